@@ -0,0 +1,194 @@
+#include "EpdFontPack.h"
+
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace EpdFontPack {
+
+namespace {
+
+constexpr uint8_t MAGIC[4] = {'E', 'F', 'P', 'K'};
+constexpr uint8_t VERSION = 1;
+constexpr size_t STYLE_COUNT = 4;
+
+// Packs hold the tables in their in-memory layout, so the layout is part of the file format
+static_assert(std::endian::native == std::endian::little, "Font packs are little-endian");
+static_assert(sizeof(EpdGlyph) == 16 && offsetof(EpdGlyph, dataOffset) == 12, "EpdGlyph layout changed");
+static_assert(sizeof(EpdUnicodeInterval) == 12, "EpdUnicodeInterval layout changed");
+static_assert(sizeof(EpdFontGroup) == 20 && offsetof(EpdFontGroup, firstGlyphIndex) == 16,
+              "EpdFontGroup layout changed");
+static_assert(sizeof(EpdKernClassEntry) == 3, "EpdKernClassEntry layout changed");
+static_assert(sizeof(EpdLigaturePair) == 8, "EpdLigaturePair layout changed");
+
+uint16_t readLe16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+
+uint32_t readLe32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Bounds- and alignment-checked view of one table. An empty table has offset 0 and becomes nullptr.
+class Image {
+ public:
+  Image(const uint8_t* data, const size_t size) : data(data), size(size) {}
+
+  template <typename T>
+  bool table(const uint32_t offset, const uint64_t count, const T*& out) const {
+    if (count == 0) {
+      out = nullptr;
+      return offset == 0;
+    }
+    if (offset < HEADER_SIZE || offset % alignof(T) != 0 || offset > size || count * sizeof(T) > size - offset) {
+      return false;
+    }
+    out = reinterpret_cast<const T*>(data + offset);
+    return true;
+  }
+
+  const uint8_t* data;
+  size_t size;
+};
+
+uint32_t alignedBitmapSize(const EpdGlyph& glyph) {
+  return glyph.width > 0 && glyph.height > 0 ? static_cast<uint32_t>((glyph.width + 3) / 4) * glyph.height : 0;
+}
+
+bool validIntervals(const EpdFontData& font, const uint32_t glyphCount) {
+  for (uint32_t i = 0; i < font.intervalCount; i++) {
+    const EpdUnicodeInterval& interval = font.intervals[i];
+    if (interval.first > interval.last || (i > 0 && interval.first <= font.intervals[i - 1].last) ||
+        static_cast<uint64_t>(interval.offset) + (interval.last - interval.first) >= glyphCount) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Every glyph's bitmap must lie inside the bitmap table, or inside its group once that is inflated
+bool validBitmaps(const EpdFontData& font, const uint32_t glyphCount, const uint32_t bitmapSize) {
+  if (font.groupCount == 0) {
+    const uint32_t bitsPerPixel = font.is2Bit ? 2 : 1;
+    for (uint32_t i = 0; i < glyphCount; i++) {
+      const EpdGlyph& glyph = font.glyph[i];
+      const uint32_t needed = (static_cast<uint32_t>(glyph.width) * glyph.height * bitsPerPixel + 7) / 8;
+      if (glyph.dataLength < needed || glyph.dataOffset > bitmapSize ||
+          glyph.dataLength > bitmapSize - glyph.dataOffset) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // FontDecompressor locates glyphs in an inflated group by summing the byte-aligned sizes of the glyphs before them
+  std::vector<uint32_t> groupBytes(font.groupCount, 0);
+  for (uint16_t g = 0; g < font.groupCount; g++) {
+    const EpdFontGroup& group = font.groups[g];
+    if (group.compressedOffset > bitmapSize || group.compressedSize > bitmapSize - group.compressedOffset ||
+        static_cast<uint64_t>(group.firstGlyphIndex) + group.glyphCount > glyphCount) {
+      return false;
+    }
+    if (!font.glyphToGroup) {
+      for (uint32_t i = group.firstGlyphIndex; i < group.firstGlyphIndex + group.glyphCount; i++) {
+        groupBytes[g] += alignedBitmapSize(font.glyph[i]);
+      }
+    }
+  }
+  if (font.glyphToGroup) {
+    for (uint32_t i = 0; i < glyphCount; i++) {
+      if (font.glyphToGroup[i] >= font.groupCount) {
+        return false;
+      }
+      groupBytes[font.glyphToGroup[i]] += alignedBitmapSize(font.glyph[i]);
+    }
+  }
+  for (uint16_t g = 0; g < font.groupCount; g++) {
+    if (groupBytes[g] > font.groups[g].uncompressedSize) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool validKernClasses(const EpdKernClassEntry* entries, const uint16_t count, const uint8_t classCount) {
+  for (uint16_t i = 0; i < count; i++) {
+    if (entries[i].classId == 0 || entries[i].classId > classCount) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool parseFace(const Image& image, const uint32_t offset, EpdFontData& font) {
+  if (offset < HEADER_SIZE || offset % 4 != 0 || offset > image.size || image.size - offset < FACE_HEADER_SIZE) {
+    return false;
+  }
+  // Metrics and counts, then the offset of each table from the start of the pack
+  const uint8_t* face = image.data + offset;
+  font = {};
+  font.advanceY = face[0];
+  font.is2Bit = face[1] != 0;
+  font.kernLeftClassCount = face[2];
+  font.kernRightClassCount = face[3];
+  font.ascender = static_cast<int16_t>(readLe16(face + 4));
+  font.descender = static_cast<int16_t>(readLe16(face + 6));
+  const uint32_t glyphCount = readLe32(face + 8);
+  font.intervalCount = readLe32(face + 12);
+  font.groupCount = readLe16(face + 16);
+  font.kernLeftEntryCount = readLe16(face + 18);
+  font.kernRightEntryCount = readLe16(face + 20);
+  font.ligaturePairCount = readLe32(face + 24);
+  const uint32_t bitmapSize = readLe32(face + 28);
+  const bool hasGlyphToGroup = readLe32(face + 48) != 0;
+  const uint32_t kernMatrixSize = font.kernLeftEntryCount > 0 ? font.kernLeftClassCount * font.kernRightClassCount : 0;
+
+  if (glyphCount == 0 || font.intervalCount == 0 || (font.kernLeftEntryCount == 0) != (font.kernRightEntryCount == 0) ||
+      !image.table(readLe32(face + 32), bitmapSize, font.bitmap) ||
+      !image.table(readLe32(face + 36), glyphCount, font.glyph) ||
+      !image.table(readLe32(face + 40), font.intervalCount, font.intervals) ||
+      !image.table(readLe32(face + 44), font.groupCount, font.groups) ||
+      !image.table(readLe32(face + 48), hasGlyphToGroup ? glyphCount : 0, font.glyphToGroup) ||
+      !image.table(readLe32(face + 52), font.kernLeftEntryCount, font.kernLeftClasses) ||
+      !image.table(readLe32(face + 56), font.kernRightEntryCount, font.kernRightClasses) ||
+      !image.table(readLe32(face + 60), kernMatrixSize, font.kernMatrix) ||
+      !image.table(readLe32(face + 64), font.ligaturePairCount, font.ligaturePairs)) {
+    return false;
+  }
+  if (font.kernLeftEntryCount > 0 && kernMatrixSize == 0) {
+    return false;
+  }
+  return validIntervals(font, glyphCount) && validBitmaps(font, glyphCount, bitmapSize) &&
+         validKernClasses(font.kernLeftClasses, font.kernLeftEntryCount, font.kernLeftClassCount) &&
+         validKernClasses(font.kernRightClasses, font.kernRightEntryCount, font.kernRightClassCount);
+}
+
+}  // namespace
+
+bool parse(const uint8_t* image, const size_t size, Family& family) {
+  // Header: magic, version, style mask, reserved u16, font ID, face offsets per style, pack size (little-endian)
+  if (!image || reinterpret_cast<uintptr_t>(image) % 4 != 0 || size < HEADER_SIZE ||
+      memcmp(image, MAGIC, sizeof(MAGIC)) != 0 || image[4] != VERSION) {
+    return false;
+  }
+  const uint8_t styleMask = image[5];
+  if ((styleMask & 1) == 0 || styleMask >= (1u << STYLE_COUNT) || readLe32(image + 28) != size) {
+    return false;
+  }
+
+  Family parsed = {};
+  parsed.fontId = static_cast<int32_t>(readLe32(image + 8));
+  parsed.styleMask = styleMask;
+  const Image view(image, size);
+  for (size_t style = 0; style < STYLE_COUNT; style++) {
+    const uint32_t faceOffset = readLe32(image + 12 + 4 * style);
+    const bool valid = parsed.hasStyle(style) ? parseFace(view, faceOffset, parsed.styles[style]) : faceOffset == 0;
+    if (!valid) {
+      return false;
+    }
+  }
+  family = parsed;
+  return true;
+}
+
+}  // namespace EpdFontPack
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "EpdFontData.h"
+
+/**
+ * Font packs: one font family (up to four styles) with the same bitmap, glyph, interval, group, kerning and ligature
+ * tables a header generated into builtinFonts holds, as a single file. Packs let reader fonts live on the SD card
+ * instead of in the firmware image. The layout is documented in docs/font-pack-format.md, and
+ * scripts/fontpack.py writes them.
+ *
+ * The tables are stored exactly as the EpdFontData structs lay them out in memory, so a parsed pack points straight
+ * into the image. On the device, FontPackStore copies the packs into a flash partition and maps them into the
+ * address space, so glyphs are read as fast as from a built-in font.
+ */
+namespace EpdFontPack {
+
+constexpr size_t HEADER_SIZE = 32;
+constexpr size_t FACE_HEADER_SIZE = 68;
+
+struct Family {
+  int fontId;             ///< Font ID the family is registered under; packs of built-in fonts reuse its ID
+  uint8_t styleMask;      ///< Bit n set when EpdFontFamily::Style n is present; REGULAR always is
+  EpdFontData styles[4];  ///< Indexed by EpdFontFamily::Style; zeroed for missing styles
+
+  bool hasStyle(const uint8_t style) const { return (styleMask & (1u << style)) != 0; }
+};
+
+// Validates a pack image and points `family` into it; the font data stays valid as long as the image does. Returns
+// false, leaving `family` untouched, for anything but a complete pack of a known version whose tables are consistent
+// enough that glyph lookups cannot read outside the image.
+bool parse(const uint8_t* image, size_t size, Family& family);
+
+}  // namespace EpdFontPack
@@ -1,10 +1,12 @@
 #include "FontDecompressor.h"
 
 #include <Arduino.h>
+#include <HeapTags.h>
 #include <Logging.h>
 #include <Utf8.h>
 
 #include <cstdlib>
+#include <cstring>
 
 FontDecompressor::~FontDecompressor() { deinit(); }
 
@@ -25,8 +27,8 @@ void FontDecompressor::clearCache() {
 
 void FontDecompressor::freePageBuffer() {
   for (uint8_t s = 0; s < pageSlotCount; s++) {
-    free(pageSlots[s].buffer);
-    free(pageSlots[s].glyphs);
+    HeapTags::release(pageSlots[s].buffer);
+    HeapTags::release(pageSlots[s].glyphs);
     pageSlots[s] = {};
   }
   pageSlotCount = 0;
@@ -315,12 +317,13 @@ int FontDecompressor::prewarmCache(const EpdFontData* fontData, const char* utf8
   stats.uniqueGroupsAccessed = groupCount;
 
   // Step 3: Allocate page buffer and lookup table for this slot
-  slot.buffer = static_cast<uint8_t*>(malloc(totalBytes));
-  slot.glyphs = static_cast<PageGlyphEntry*>(malloc(glyphCount * sizeof(PageGlyphEntry)));
+  slot.buffer = static_cast<uint8_t*>(HeapTags::alloc(HeapTags::Tag::FontDecompressor, totalBytes));
+  slot.glyphs = static_cast<PageGlyphEntry*>(
+      HeapTags::alloc(HeapTags::Tag::FontDecompressor, glyphCount * sizeof(PageGlyphEntry)));
   if (!slot.buffer || !slot.glyphs) {
     LOG_ERR("FDC", "Failed to allocate page buffer (%u bytes, %u glyphs)", totalBytes, glyphCount);
-    free(slot.buffer);
-    free(slot.glyphs);
+    HeapTags::release(slot.buffer);
+    HeapTags::release(slot.glyphs);
     slot = {};
     return glyphCount;
   }
@@ -425,7 +428,7 @@ int FontDecompressor::prewarmCache(const EpdFontData* fontData, const char* utf8
     uint16_t groupIdx = neededGroups[g];
     const EpdFontGroup& group = fontData->groups[groupIdx];
 
-    auto* tempBuf = static_cast<uint8_t*>(malloc(group.uncompressedSize));
+    auto* tempBuf = static_cast<uint8_t*>(HeapTags::alloc(HeapTags::Tag::FontDecompressor, group.uncompressedSize));
     if (!tempBuf) {
       LOG_ERR("FDC", "Failed to allocate temp buffer (%u bytes) for group %u", group.uncompressedSize, groupIdx);
       missed++;
@@ -436,7 +439,7 @@ int FontDecompressor::prewarmCache(const EpdFontData* fontData, const char* utf8
     }
 
     if (!decompressGroup(fontData, groupIdx, tempBuf, group.uncompressedSize)) {
-      free(tempBuf);
+      HeapTags::release(tempBuf);
       missed++;
       continue;
     }
@@ -453,7 +456,7 @@ int FontDecompressor::prewarmCache(const EpdFontData* fontData, const char* utf8
       writeOffset += glyph.dataLength;
     }
 
-    free(tempBuf);
+    HeapTags::release(tempBuf);
   }
 
   LOG_DBG("FDC", "Prewarm: %u glyphs in %u bytes from %u groups (%d missed)", glyphCount, writeOffset, groupCount,
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <HeapTags.h>
 #include <InflateReader.h>
 
 #include <vector>
@@ -69,11 +70,12 @@ class FontDecompressor {
   // Kept in byte-aligned format; individual glyphs are compacted on demand into hotGlyphBuf.
   const EpdFontData* hotGroupFont = nullptr;
   uint16_t hotGroupIndex = UINT16_MAX;
-  std::vector<uint8_t> hotGroup;
+  using TaggedBytes = std::vector<uint8_t, HeapTags::Allocator<uint8_t, HeapTags::Tag::FontDecompressor>>;
+  TaggedBytes hotGroup;
 
   // Scratch buffer for compacting a single glyph from the hot group.
   // Valid until the next getBitmap() call.
-  std::vector<uint8_t> hotGlyphBuf;
+  TaggedBytes hotGlyphBuf;
 
   void freePageBuffer();
   void freeHotGroup();
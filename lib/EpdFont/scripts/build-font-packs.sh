@@ -0,0 +1,20 @@
+#!/bin/bash
+# Builds a font pack of every reader font family from the generated headers. Copy the packs to /fonts/ on the SD card;
+# firmware built with OMIT_FONTS then still offers all reader fonts.
+
+set -e
+
+cd "$(dirname "$0")"
+
+OUTPUT_DIR="$(mkdir -p "${1:-../../../build/fonts}" && cd "${1:-../../../build/fonts}" && pwd)"
+FAMILIES=(
+  notoserif_12 notoserif_14 notoserif_16 notoserif_18
+  notosans_12 notosans_14 notosans_16 notosans_18
+  opendyslexic_8 opendyslexic_10 opendyslexic_12 opendyslexic_14
+)
+
+for family in ${FAMILIES[@]}; do
+  header="../builtinFonts/${family}"
+  python3 fontpack.py "${OUTPUT_DIR}/${family}.epf" "${header}_regular.h" --bold "${header}_bold.h" \
+    --italic "${header}_italic.h" --bold-italic "${header}_bolditalic.h"
+done
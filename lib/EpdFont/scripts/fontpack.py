@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""
+Builds a font pack (see docs/font-pack-format.md) from the headers fontconvert.py generated for one font family.
+
+Usage:
+    fontpack.py OUTPUT.epf REGULAR.h [--bold BOLD.h] [--italic ITALIC.h] [--bold-italic BOLDITALIC.h] [--font-id N]
+
+Without --font-id the family gets the ID build-font-ids.sh derives from the same headers, so a pack built from the
+built-in headers replaces or stands in for that built-in font.
+"""
+
+import argparse
+import hashlib
+import re
+import struct
+import sys
+
+MAGIC = b"EFPK"
+VERSION = 1
+HEADER_SIZE = 32
+FACE_HEADER_SIZE = 68
+
+GLYPH = struct.Struct("<BBHhhH2xI")
+INTERVAL = struct.Struct("<III")
+GROUP = struct.Struct("<IIIH2xI")
+KERN_CLASS = struct.Struct("<HB")
+LIGATURE = struct.Struct("<II")
+
+# Field order of the EpdFontData initializer fontconvert.py prints
+FONT_FIELDS = (
+    "bitmap", "glyph", "intervals", "intervalCount", "advanceY", "ascender", "descender", "is2Bit", "groups",
+    "groupCount", "glyphToGroup", "kernLeftClasses", "kernRightClasses", "kernMatrix", "kernLeftEntryCount",
+    "kernRightEntryCount", "kernLeftClassCount", "kernRightClassCount", "ligaturePairs", "ligaturePairCount",
+)
+
+ARRAY_RE = re.compile(r"static const (\w+) (\w+)\[\d*\] = \{(.*?)\};", re.S)
+FONT_RE = re.compile(r"static const EpdFontData (\w+) = \{(.*?)\};", re.S)
+NUMBER_RE = re.compile(r"-?0x[0-9A-Fa-f]+|-?\d+")
+
+
+def font_id(header_paths):
+    """Same hash build-font-ids.sh computes for the family's headers."""
+    total = sum(int(hashlib.sha256(open(path, "rb").read()).hexdigest(), 16) for path in header_paths)
+    return total % (2 ** 32) - (2 ** 31)
+
+
+def numbers(body, width):
+    values = [int(token, 0) for token in NUMBER_RE.findall(body)]
+    if len(values) % width:
+        raise ValueError(f"table with {len(values)} values is not made of {width}-value entries")
+    return [tuple(values[i:i + width]) for i in range(0, len(values), width)]
+
+
+def read_header(path):
+    """Returns the EpdFontData fields of a generated header, with table names replaced by their entries."""
+    text = re.sub(r"//[^\n]*", "", open(path, encoding="utf-8").read())
+    arrays = {name: (ctype, body) for ctype, name, body in ARRAY_RE.findall(text)}
+    match = FONT_RE.search(text)
+    if not match:
+        raise ValueError(f"{path}: no EpdFontData definition")
+    values = [value.strip() for value in match.group(2).split(",") if value.strip()]
+    if len(values) != len(FONT_FIELDS):
+        raise ValueError(f"{path}: expected {len(FONT_FIELDS)} EpdFontData fields, found {len(values)}")
+
+    font = {}
+    for field, value in zip(FONT_FIELDS, values):
+        if value == "nullptr":
+            font[field] = []
+        elif value in ("true", "false"):
+            font[field] = value == "true"
+        elif value in arrays:
+            ctype, body = arrays[value]
+            width = {"EpdGlyph": 7, "EpdUnicodeInterval": 3, "EpdFontGroup": 5, "EpdKernClassEntry": 2,
+                     "EpdLigaturePair": 2}.get(ctype, 1)
+            font[field] = numbers(body, width)
+        else:
+            font[field] = int(value, 0)
+    return font
+
+
+class PackWriter:
+    def __init__(self):
+        self.data = bytearray(HEADER_SIZE)
+
+    def align(self):
+        self.data += bytes(-len(self.data) % 4)
+
+    def table(self, entries, packer):
+        if not entries:
+            return 0
+        self.align()
+        offset = len(self.data)
+        for entry in entries:
+            self.data += packer(entry)
+        return offset
+
+    def face(self, font):
+        self.align()
+        offset = len(self.data)
+        self.data += bytes(FACE_HEADER_SIZE)
+        bitmap = bytes(value for (value,) in font["bitmap"])
+        offsets = [
+            self.table([bitmap] if bitmap else [], bytes),
+            self.table(font["glyph"], lambda g: GLYPH.pack(*g)),
+            self.table(font["intervals"], lambda i: INTERVAL.pack(*i)),
+            self.table(font["groups"], lambda g: GROUP.pack(*g)),
+            self.table(font["glyphToGroup"], lambda g: struct.pack("<H", *g)),
+            self.table(font["kernLeftClasses"], lambda k: KERN_CLASS.pack(*k)),
+            self.table(font["kernRightClasses"], lambda k: KERN_CLASS.pack(*k)),
+            self.table(font["kernMatrix"], lambda k: struct.pack("<b", *k)),
+            self.table(font["ligaturePairs"], lambda p: LIGATURE.pack(*p)),
+        ]
+        if len(font["intervals"]) != font["intervalCount"] or len(font["groups"]) != font["groupCount"]:
+            raise ValueError("table sizes do not match the EpdFontData counts")
+        self.data[offset:offset + FACE_HEADER_SIZE] = struct.pack(
+            "<BBBBhhIIHHHxxII9I", font["advanceY"], font["is2Bit"], font["kernLeftClassCount"],
+            font["kernRightClassCount"], font["ascender"], font["descender"], len(font["glyph"]),
+            font["intervalCount"], font["groupCount"], font["kernLeftEntryCount"], font["kernRightEntryCount"],
+            font["ligaturePairCount"], len(bitmap), *offsets)
+        return offset
+
+    def finish(self, family_id, faces):
+        style_mask = sum(1 << style for style, offset in enumerate(faces) if offset)
+        struct.pack_into("<4sBBxxi4II", self.data, 0, MAGIC, VERSION, style_mask, family_id, *faces,
+                         len(self.data))
+        return bytes(self.data)
+
+
+def build_pack(headers, family_id):
+    """headers: one generated header path (or None) per EpdFontFamily::Style; the regular style is required."""
+    writer = PackWriter()
+    faces = [writer.face(read_header(path)) if path else 0 for path in headers]
+    return writer.finish(family_id, faces)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build a font pack from fontconvert.py headers.")
+    parser.add_argument("output", help="pack file to write (.epf)")
+    parser.add_argument("regular", help="header of the regular style")
+    parser.add_argument("--bold", help="header of the bold style")
+    parser.add_argument("--italic", help="header of the italic style")
+    parser.add_argument("--bold-italic", dest="bold_italic", help="header of the bold italic style")
+    parser.add_argument("--font-id", dest="font_id", type=int,
+                        help="font ID to register the family under (default: the build-font-ids.sh hash)")
+    args = parser.parse_args()
+
+    headers = [args.regular, args.bold, args.italic, args.bold_italic]
+    family_id = args.font_id if args.font_id is not None else font_id([path for path in headers if path])
+    pack = build_pack(headers, family_id)
+    with open(args.output, "wb") as f:
+        f.write(pack)
+    print(f"{args.output}: {len(pack)} bytes, font ID {family_id}", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
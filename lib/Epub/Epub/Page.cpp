@@ -3,6 +3,11 @@
 #include <Logging.h>
 #include <Serialization.h>
 
+namespace {
+// Counts, vtable and pointer of the control block a shared_ptr made from a unique_ptr allocates
+constexpr size_t SHARED_PTR_CONTROL_BYTES = 4 * sizeof(void*);
+}  // namespace
+
 void PageLine::render(GfxRenderer& renderer, const int fontId, const int xOffset, const int yOffset) {
   block->render(renderer, fontId, xPos + xOffset, yPos + yOffset);
 }
@@ -25,6 +30,11 @@ std::unique_ptr<PageLine> PageLine::deserialize(FsFile& file) {
   return std::unique_ptr<PageLine>(new PageLine(std::move(tb), xPos, yPos));
 }
 
+size_t PageLine::heapBytes() const {
+  // The element and its block each come with a control block
+  return sizeof(PageLine) + block->heapBytes() + 2 * SHARED_PTR_CONTROL_BYTES;
+}
+
 void PageImage::render(GfxRenderer& renderer, const int fontId, const int xOffset, const int yOffset) {
   // Images don't use fontId or text rendering
   imageBlock->render(renderer, xPos + xOffset, yPos + yOffset);
@@ -48,12 +58,25 @@ std::unique_ptr<PageImage> PageImage::deserialize(FsFile& file) {
   return std::unique_ptr<PageImage>(new PageImage(std::move(ib), xPos, yPos));
 }
 
+size_t PageImage::heapBytes() const {
+  return sizeof(PageImage) + imageBlock->heapBytes() + 2 * SHARED_PTR_CONTROL_BYTES;
+}
+
 void Page::render(GfxRenderer& renderer, const int fontId, const int xOffset, const int yOffset) const {
   for (auto& element : elements) {
     element->render(renderer, fontId, xOffset, yOffset);
   }
 }
 
+size_t Page::heapBytes() const {
+  size_t bytes =
+      sizeof(Page) + elements.capacity() * sizeof(elements[0]) + footnotes.capacity() * sizeof(FootnoteEntry);
+  for (const auto& element : elements) {
+    bytes += element->heapBytes();
+  }
+  return bytes;
+}
+
 bool Page::serialize(FsFile& file) const {
   const uint16_t count = elements.size();
   serialization::writePod(file, count);
@@ -25,6 +25,8 @@ class PageElement {
   virtual void render(GfxRenderer& renderer, int fontId, int xOffset, int yOffset) = 0;
   virtual bool serialize(FsFile& file) = 0;
   virtual PageElementTag getTag() const = 0;  // Add type identification
+  // Approximate heap held by the element, including itself
+  virtual size_t heapBytes() const = 0;
 };
 
 // a line from a block element
@@ -38,6 +40,7 @@ class PageLine final : public PageElement {
   void render(GfxRenderer& renderer, int fontId, int xOffset, int yOffset) override;
   bool serialize(FsFile& file) override;
   PageElementTag getTag() const override { return TAG_PageLine; }
+  size_t heapBytes() const override;
   static std::unique_ptr<PageLine> deserialize(FsFile& file);
 };
 
@@ -51,8 +54,10 @@ class PageImage final : public PageElement {
   void render(GfxRenderer& renderer, int fontId, int xOffset, int yOffset) override;
   bool serialize(FsFile& file) override;
   PageElementTag getTag() const override { return TAG_PageImage; }
+  size_t heapBytes() const override;
   static std::unique_ptr<PageImage> deserialize(FsFile& file);
   const ImageBlock& getImageBlock() const { return *imageBlock; }
+  const std::shared_ptr<ImageBlock>& getBlock() const { return imageBlock; }
 };
 
 class Page {
@@ -76,6 +81,9 @@ class Page {
   bool serialize(FsFile& file) const;
   static std::unique_ptr<Page> deserialize(FsFile& file);
 
+  // Approximate heap held by a deserialized page, for budgeting pages kept in RAM (see PageCache)
+  size_t heapBytes() const;
+
   // Check if page contains any images (used to force full refresh)
   bool hasImages() const {
     return std::any_of(elements.begin(), elements.end(),
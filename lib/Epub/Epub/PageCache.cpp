@@ -0,0 +1,101 @@
+#include "PageCache.h"
+
+#include <utility>
+
+PageCache::Entry* PageCache::findEntry(const int spineIndex, const uint16_t pageNumber) {
+  for (auto& entry : entries) {
+    if (entry.page && entry.spineIndex == spineIndex && entry.pageNumber == pageNumber) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+void PageCache::release(Entry& entry) {
+  used -= entry.bytes;
+  entry = Entry{};
+}
+
+std::shared_ptr<const Page> PageCache::find(const int spineIndex, const uint16_t pageNumber) {
+  Entry* entry = findEntry(spineIndex, pageNumber);
+  if (!entry) {
+    stats.misses++;
+    return nullptr;
+  }
+  stats.hits++;
+  entry->lastUse = ++useClock;
+  return entry->page;
+}
+
+bool PageCache::contains(const int spineIndex, const uint16_t pageNumber) const {
+  for (const auto& entry : entries) {
+    if (entry.page && entry.spineIndex == spineIndex && entry.pageNumber == pageNumber) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void PageCache::insert(const int spineIndex, const uint16_t pageNumber, std::shared_ptr<const Page> page,
+                       const size_t bytes) {
+  if (Entry* cached = findEntry(spineIndex, pageNumber)) {
+    release(*cached);
+  }
+  if (!page || bytes > BUDGET_BYTES) return;
+
+  Entry* slot = nullptr;
+  while (true) {
+    Entry* oldest = nullptr;
+    slot = nullptr;
+    for (auto& entry : entries) {
+      if (!entry.page) {
+        slot = &entry;
+      } else if (!oldest || entry.lastUse < oldest->lastUse) {
+        oldest = &entry;
+      }
+    }
+    if (slot && used + bytes <= BUDGET_BYTES) break;
+    // The budget holds `bytes`, so some page is still cached whenever this one does not fit yet
+    release(*oldest);
+  }
+
+  slot->page = std::move(page);
+  slot->spineIndex = spineIndex;
+  slot->pageNumber = pageNumber;
+  slot->bytes = bytes;
+  slot->lastUse = ++useClock;
+  used += bytes;
+}
+
+void PageCache::recordLoad(const uint32_t us) {
+  stats.loads++;
+  stats.loadUs += us;
+}
+
+void PageCache::dropChapter(const int spineIndex) {
+  for (auto& entry : entries) {
+    if (entry.page && entry.spineIndex == spineIndex) {
+      release(entry);
+    }
+  }
+}
+
+void PageCache::clear() {
+  for (auto& entry : entries) {
+    if (entry.page) {
+      release(entry);
+    }
+  }
+}
+
+uint32_t PageCache::averageLoadUs() const {
+  return stats.loads > 0 ? static_cast<uint32_t>(stats.loadUs / stats.loads) : 0;
+}
+
+int PageCache::size() const {
+  int count = 0;
+  for (const auto& entry : entries) {
+    if (entry.page) count++;
+  }
+  return count;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+
+class Page;
+
+/**
+ * Deserialized reader pages kept in RAM, across chapters.
+ *
+ * Every page turn otherwise deserializes its page from the section file on SD. The reader keeps the pages it shows
+ * here and, once a page is on the panel, reads its neighbours ahead: the next and previous page, or at a chapter's
+ * edges the first page of the next chapter and the last page of the previous one. Paging back and forth, and across
+ * a chapter boundary in either direction, is then served without touching SD.
+ *
+ * Pages are held in a single budget of BUDGET_BYTES (as reported by their owner, see Page::heapBytes()) and at most
+ * MAX_PAGES, dropping the least recently used first. A page larger than the whole budget is not kept. The pages of a
+ * chapter are only valid for the section file they were read from: drop them whenever it is written again.
+ */
+class PageCache {
+ public:
+  // Room for the current page, both neighbours and the boundary pages of the adjacent chapters of a text-only book
+  static constexpr size_t BUDGET_BYTES = 32 * 1024;
+  static constexpr int MAX_PAGES = 5;
+
+  struct Stats {
+    uint32_t hits = 0;    // Page turns served from the cache
+    uint32_t misses = 0;  // Page turns that read their page from SD
+    uint32_t loads = 0;   // Pages read from SD, on a miss or ahead
+    uint64_t loadUs = 0;  // Time spent reading those
+  };
+
+  // The cached page, which becomes the most recently used, or null. Counts as a hit or a miss.
+  std::shared_ptr<const Page> find(int spineIndex, uint16_t pageNumber);
+  bool contains(int spineIndex, uint16_t pageNumber) const;
+  // Keep a page of `bytes`, replacing a cached copy and making room by dropping the least recently used pages
+  void insert(int spineIndex, uint16_t pageNumber, std::shared_ptr<const Page> page, size_t bytes);
+  // Account for a page read from SD in `us`
+  void recordLoad(uint32_t us);
+  void dropChapter(int spineIndex);
+  void clear();
+
+  const Stats& getStats() const { return stats; }
+  // Mean time to read a page from SD, i.e. the time a hit saves; 0 before any read
+  uint32_t averageLoadUs() const;
+  size_t usedBytes() const { return used; }
+  int size() const;
+
+ private:
+  struct Entry {
+    std::shared_ptr<const Page> page;
+    int spineIndex = 0;
+    uint16_t pageNumber = 0;
+    size_t bytes = 0;
+    uint32_t lastUse = 0;
+  };
+
+  Entry entries[MAX_PAGES];
+  size_t used = 0;
+  uint32_t useClock = 0;
+  Stats stats;
+
+  Entry* findEntry(int spineIndex, uint16_t pageNumber);
+  void release(Entry& entry);
+};
@@ -1,17 +1,24 @@
 #include "ParsedText.h"
 
 #include <GfxRenderer.h>
+#include <Logging.h>
+#include <Serialization.h>
 #include <Utf8.h>
 
 #include <algorithm>
 #include <cmath>
 #include <functional>
+#include <iterator>
 #include <limits>
 #include <vector>
 
 #include "hyphenation/Hyphenator.h"
 
 constexpr int MAX_COST = std::numeric_limits<int>::max();
+// Sanity limit for deserialization; the chapter parser hands paragraphs over in parts of about 750 words
+constexpr uint16_t MAX_SERIALIZED_WORDS = 10000;
+// Far past any real word, but keeps a corrupt length from allocating the heap away
+constexpr uint32_t MAX_SERIALIZED_WORD_BYTES = 4096;
 
 namespace {
 
@@ -89,6 +96,69 @@ void ParsedText::addWord(std::string word, const EpdFontFamily::Style fontStyle,
   wordContinues.push_back(attachToPrevious);
 }
 
+void ParsedText::takeWords(ParsedText& other) {
+  if (words.empty()) {
+    words.swap(other.words);
+    wordStyles.swap(other.wordStyles);
+    wordContinues.swap(other.wordContinues);
+    return;
+  }
+  words.insert(words.end(), std::make_move_iterator(other.words.begin()),
+               std::make_move_iterator(other.words.end()));
+  wordStyles.insert(wordStyles.end(), other.wordStyles.begin(), other.wordStyles.end());
+  wordContinues.insert(wordContinues.end(), other.wordContinues.begin(), other.wordContinues.end());
+  other.words.clear();
+  other.wordStyles.clear();
+  other.wordContinues.clear();
+}
+
+bool ParsedText::serialize(FsFile& file) const {
+  if (words.size() > MAX_SERIALIZED_WORDS) {
+    LOG_ERR("PTX", "Serialization failed: %u words", static_cast<unsigned>(words.size()));
+    return false;
+  }
+
+  serialization::writePod(file, static_cast<uint16_t>(words.size()));
+  for (const auto& w : words) serialization::writeString(file, w);
+  for (const auto s : wordStyles) serialization::writePod(file, s);
+  for (const bool c : wordContinues) serialization::writePod(file, static_cast<uint8_t>(c));
+  return true;
+}
+
+bool ParsedText::deserialize(FsFile& file) {
+  uint16_t wc = 0;
+  if (!serialization::readPodChecked(file, wc) || wc > MAX_SERIALIZED_WORDS) {
+    LOG_ERR("PTX", "Deserialization failed: bad word count %u", wc);
+    return false;
+  }
+
+  // Read into the existing storage, so a reused ParsedText keeps the capacity it has grown
+  words.resize(wc);
+  wordStyles.resize(wc);
+  wordContinues.resize(wc);
+  for (auto& w : words) {
+    if (!serialization::readStringChecked(file, w, MAX_SERIALIZED_WORD_BYTES)) {
+      LOG_ERR("PTX", "Deserialization failed: truncated or oversized word");
+      return false;
+    }
+  }
+  for (auto& s : wordStyles) {
+    if (!serialization::readPodChecked(file, s)) {
+      LOG_ERR("PTX", "Deserialization failed: truncated word styles");
+      return false;
+    }
+  }
+  for (size_t i = 0; i < wc; i++) {
+    uint8_t c = 0;
+    if (!serialization::readPodChecked(file, c)) {
+      LOG_ERR("PTX", "Deserialization failed: truncated word flags");
+      return false;
+    }
+    wordContinues[i] = c != 0;
+  }
+  return true;
+}
+
 // Consumes data to minimize memory usage
 void ParsedText::layoutAndExtractLines(const GfxRenderer& renderer, const int fontId, const uint16_t viewportWidth,
                                        const std::function<void(std::shared_ptr<TextBlock>)>& processLine,
@@ -363,8 +433,10 @@ bool ParsedText::hyphenateWordAtIndex(const size_t wordIndex, const int availabl
   const auto style = wordStyles[wordIndex];
 
   // Collect candidate breakpoints (byte offsets and hyphen requirements).
-  auto breakInfos = Hyphenator::breakOffsets(word, allowFallbackBreaks);
-  if (breakInfos.empty()) {
+  Hyphenator::BreakInfo breakInfos[Hyphenator::MAX_WORD_CODEPOINTS];
+  const size_t breakCount =
+      Hyphenator::breakOffsets(word, allowFallbackBreaks, breakInfos, Hyphenator::MAX_WORD_CODEPOINTS);
+  if (breakCount == 0) {
     return false;
   }
 
@@ -372,22 +444,24 @@ bool ParsedText::hyphenateWordAtIndex(const size_t wordIndex, const int availabl
   int chosenWidth = -1;
   bool chosenNeedsHyphen = true;
 
-  // Iterate over each legal breakpoint and retain the widest prefix that still fits.
-  for (const auto& info : breakInfos) {
-    const size_t offset = info.byteOffset;
+  // Breakpoints are in ascending order and a longer prefix is never narrower, so the widest prefix that still fits is
+  // the last one that fits: measure from the end and stop there instead of measuring every prefix.
+  for (size_t i = breakCount; i-- > 0;) {
+    const size_t offset = breakInfos[i].byteOffset;
     if (offset == 0 || offset >= word.size()) {
       continue;
     }
 
-    const bool needsHyphen = info.requiresInsertedHyphen;
+    const bool needsHyphen = breakInfos[i].requiresInsertedHyphen;
     const int prefixWidth = measureWordWidth(renderer, fontId, word.substr(0, offset), style, needsHyphen);
-    if (prefixWidth > availableWidth || prefixWidth <= chosenWidth) {
-      continue;  // Skip if too wide or not an improvement
+    if (prefixWidth > availableWidth) {
+      continue;  // Too wide, try a shorter prefix
     }
 
     chosenWidth = prefixWidth;
     chosenOffset = offset;
     chosenNeedsHyphen = needsHyphen;
+    break;
   }
 
   if (chosenWidth < 0) {
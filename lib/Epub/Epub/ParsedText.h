@@ -44,6 +44,12 @@ class ParsedText {
   BlockStyle& getBlockStyle() { return blockStyle; }
   size_t size() const { return words.size(); }
   bool isEmpty() const { return words.empty(); }
+  // Move the words of `other` to the end of this paragraph, leaving `other` empty. Into an empty paragraph this only
+  // swaps storage, so `other` keeps the capacity this one had.
+  void takeWords(ParsedText& other);
+  // The words only: whoever lays the paragraph out sets its block style
+  bool serialize(FsFile& file) const;
+  bool deserialize(FsFile& file);
   void layoutAndExtractLines(const GfxRenderer& renderer, int fontId, uint16_t viewportWidth,
                              const std::function<void(std::shared_ptr<TextBlock>)>& processLine,
                              bool includeLastLine = true);
@@ -3,11 +3,14 @@
 #include <HalStorage.h>
 #include <Logging.h>
 #include <Serialization.h>
+#include <freertos/FreeRTOS.h>
 
 #include "Epub/css/CssParser.h"
 #include "Page.h"
+#include "hyphenation/HyphenationCache.h"
 #include "hyphenation/Hyphenator.h"
 #include "parsers/ChapterHtmlSlimParser.h"
+#include "parsers/ChapterPageBuilder.h"
 
 namespace {
 constexpr uint8_t SECTION_FILE_VERSION = 21;
@@ -15,6 +18,17 @@ constexpr uint32_t HEADER_SIZE = sizeof(uint8_t) + sizeof(int) + sizeof(float) +
                                  sizeof(uint16_t) + sizeof(uint16_t) + sizeof(uint16_t) + sizeof(bool) + sizeof(bool) +
                                  sizeof(uint8_t) + sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint32_t);
 
+// Paragraphs the parser may run ahead of the layout task, which lays out pages on a second core while the chapter
+// is read and parsed. On a single core the layout task could only fill time spent waiting on reads, but SD reads
+// busy-wait on the SPI bus, so there it costs task switches and memory for nothing: lay out inline.
+constexpr uint8_t LAYOUT_PIPELINE_DEPTH = portNUM_PROCESSORS > 1 ? 4 : 0;
+
+// Item cache: version, paragraphAlignment, embeddedStyle, imageRendering, complete; then the items
+constexpr uint32_t ITEM_CACHE_HEADER_SIZE =
+    sizeof(uint8_t) + sizeof(uint8_t) + sizeof(bool) + sizeof(uint8_t) + sizeof(bool);
+// As the parser does for the HTML: laying out a smaller chapter is quick
+constexpr size_t MIN_ITEM_CACHE_SIZE_FOR_POPUP = 10 * 1024;
+
 struct PageLutEntry {
   uint32_t fileOffset;
   uint16_t paragraphIndex;
@@ -32,6 +46,12 @@ uint32_t Section::onPageComplete(std::unique_ptr<Page> page) {
     LOG_ERR("SCT", "Failed to serialize page %d", pageCount);
     return 0;
   }
+  for (const auto& element : page->elements) {
+    if (element->getTag() == TAG_PageImage) {
+      const auto& pageImage = static_cast<const PageImage&>(*element);
+      pendingImages.push_back({pageImage.getBlock(), pageImage.xPos, pageImage.yPos});
+    }
+  }
   LOG_DBG("SCT", "Page %d processed", pageCount);
 
   pageCount++;
@@ -142,12 +162,34 @@ bool Section::clearCache() const {
   return true;
 }
 
+bool Section::openItemCache(FsFile& itemCache, const uint8_t paragraphAlignment, const bool embeddedStyle,
+                            const uint8_t imageRendering) const {
+  if (!Storage.exists(itemCachePath.c_str()) || !Storage.openFileForRead("SCT", itemCachePath, itemCache)) {
+    return false;
+  }
+
+  uint8_t version, fileParagraphAlignment, fileImageRendering;
+  bool fileEmbeddedStyle, complete;
+  serialization::readPod(itemCache, version);
+  serialization::readPod(itemCache, fileParagraphAlignment);
+  serialization::readPod(itemCache, fileEmbeddedStyle);
+  serialization::readPod(itemCache, fileImageRendering);
+  serialization::readPod(itemCache, complete);
+  if (version != SECTION_FILE_VERSION || paragraphAlignment != fileParagraphAlignment ||
+      embeddedStyle != fileEmbeddedStyle || imageRendering != fileImageRendering || !complete) {
+    // Written again by the next parse
+    itemCache.close();
+    LOG_DBG("SCT", "Item cache does not match, parsing the chapter");
+    return false;
+  }
+  return true;
+}
+
 bool Section::createSectionFile(const int fontId, const float lineCompression, const bool extraParagraphSpacing,
                                 const uint8_t paragraphAlignment, const uint16_t viewportWidth,
                                 const uint16_t viewportHeight, const bool hyphenationEnabled, const bool embeddedStyle,
                                 const uint8_t imageRendering, const std::function<void()>& popupFn) {
-  const auto localPath = epub->getSpineItem(spineIndex).href;
-  const auto tmpHtmlPath = epub->getCachePath() + "/.tmp_" + std::to_string(spineIndex) + ".html";
+  pendingImages.clear();
 
   // Create cache directory if it doesn't exist
   {
@@ -155,6 +197,108 @@ bool Section::createSectionFile(const int fontId, const float lineCompression, c
     Storage.mkdir(sectionsDir.c_str());
   }
 
+  // When only layout settings changed since the chapter was parsed, lay it out again from its items
+  FsFile itemCache;
+  const bool fromItemCache = openItemCache(itemCache, paragraphAlignment, embeddedStyle, imageRendering);
+
+  if (!Storage.openFileForWrite("SCT", filePath, file)) {
+    return false;
+  }
+  writeSectionFileHeader(fontId, lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth,
+                         viewportHeight, hyphenationEnabled, embeddedStyle, imageRendering);
+  std::vector<PageLutEntry> lut = {};
+  const CompletePageFn completePageFn = [this, &lut](std::unique_ptr<Page> page, const uint16_t paragraphIndex) {
+    lut.push_back({this->onPageComplete(std::move(page)), paragraphIndex});
+  };
+  std::vector<std::pair<std::string, uint16_t>> anchors;
+
+  Hyphenator::setPreferredLanguage(epub->getLanguage());
+  bool success;
+  {
+    // Long words recur throughout a chapter; hyphenate each one once
+    HyphenationCache hyphenationCache;
+    success = fromItemCache ? layOutItems(itemCache, fontId, lineCompression, extraParagraphSpacing, viewportWidth,
+                                          viewportHeight, hyphenationEnabled, completePageFn, anchors, popupFn)
+                            : parseChapter(fontId, lineCompression, extraParagraphSpacing, paragraphAlignment,
+                                           viewportWidth, viewportHeight, hyphenationEnabled, embeddedStyle,
+                                           imageRendering, completePageFn, anchors, popupFn);
+    const auto& stats = hyphenationCache.getStats();
+    if (stats.lookups > 0) {
+      LOG_DBG("SCT", "Hyphenation cache: %u lookups, %u hits (%u%%), %u uncacheable",
+              static_cast<unsigned>(stats.lookups), static_cast<unsigned>(stats.hits),
+              static_cast<unsigned>(stats.hits * 100ULL / stats.lookups), static_cast<unsigned>(stats.uncacheable));
+    }
+  }
+
+  if (!success) {
+    // Explicitly close() file before calling Storage.remove()
+    file.close();
+    Storage.remove(filePath.c_str());
+    if (fromItemCache) {
+      LOG_ERR("SCT", "Failed to lay out pages from the item cache, parsing the chapter instead");
+      Storage.remove(itemCachePath.c_str());
+      pendingImages.clear();
+      pageCount = 0;
+      return createSectionFile(fontId, lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth,
+                               viewportHeight, hyphenationEnabled, embeddedStyle, imageRendering, popupFn);
+    }
+    LOG_ERR("SCT", "Failed to parse XML and build pages");
+    return false;
+  }
+
+  const uint32_t lutOffset = file.position();
+  bool hasFailedLutRecords = false;
+  // Write LUT
+  for (const auto& entry : lut) {
+    if (entry.fileOffset == 0) {
+      hasFailedLutRecords = true;
+      break;
+    }
+    serialization::writePod(file, entry.fileOffset);
+  }
+
+  if (hasFailedLutRecords) {
+    LOG_ERR("SCT", "Failed to write LUT due to invalid page positions");
+    // Explicitly close() file before calling Storage.remove()
+    file.close();
+    Storage.remove(filePath.c_str());
+    return false;
+  }
+
+  // Write anchor-to-page map for fragment navigation (e.g. footnote targets)
+  const uint32_t anchorMapOffset = file.position();
+  serialization::writePod(file, static_cast<uint16_t>(anchors.size()));
+  for (const auto& [anchor, page] : anchors) {
+    serialization::writeString(file, anchor);
+    serialization::writePod(file, page);
+  }
+
+  const uint32_t paragraphLutOffset = file.position();
+  serialization::writePod(file, static_cast<uint16_t>(lut.size()));
+  for (const auto& entry : lut) {
+    serialization::writePod(file, entry.paragraphIndex);
+  }
+
+  // Patch header with final pageCount, lutOffset, anchorMapOffset, and paragraphLutOffset
+  file.seek(HEADER_SIZE - sizeof(uint32_t) * 3 - sizeof(pageCount));
+  serialization::writePod(file, pageCount);
+  serialization::writePod(file, lutOffset);
+  serialization::writePod(file, anchorMapOffset);
+  serialization::writePod(file, paragraphLutOffset);
+  // Explicit close() required: member variable persists beyond function scope
+  file.close();
+  return true;
+}
+
+bool Section::parseChapter(const int fontId, const float lineCompression, const bool extraParagraphSpacing,
+                           const uint8_t paragraphAlignment, const uint16_t viewportWidth,
+                           const uint16_t viewportHeight, const bool hyphenationEnabled, const bool embeddedStyle,
+                           const uint8_t imageRendering, const CompletePageFn& completePageFn,
+                           std::vector<std::pair<std::string, uint16_t>>& anchors,
+                           const std::function<void()>& popupFn) {
+  const auto localPath = epub->getSpineItem(spineIndex).href;
+  const auto tmpHtmlPath = epub->getCachePath() + "/.tmp_" + std::to_string(spineIndex) + ".html";
+
   // Retry logic for SD card timing issues
   bool success = false;
   uint32_t fileSize = 0;
@@ -192,13 +336,6 @@ bool Section::createSectionFile(const int fontId, const float lineCompression, c
 
   LOG_DBG("SCT", "Streamed temp HTML to %s (%d bytes)", tmpHtmlPath.c_str(), fileSize);
 
-  if (!Storage.openFileForWrite("SCT", filePath, file)) {
-    return false;
-  }
-  writeSectionFileHeader(fontId, lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth,
-                         viewportHeight, hyphenationEnabled, embeddedStyle, imageRendering);
-  std::vector<PageLutEntry> lut = {};
-
   // Derive the content base directory and image cache path prefix for the parser
   size_t lastSlash = localPath.find_last_of('/');
   std::string contentBase = (lastSlash != std::string::npos) ? localPath.substr(0, lastSlash + 1) : "";
@@ -214,93 +351,147 @@ bool Section::createSectionFile(const int fontId, const float lineCompression, c
     }
   }
 
-  ChapterHtmlSlimParser visitor(
-      epub, tmpHtmlPath, renderer, fontId, lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth,
-      viewportHeight, hyphenationEnabled,
-      [this, &lut](std::unique_ptr<Page> page, const uint16_t paragraphIndex) {
-        lut.push_back({this->onPageComplete(std::move(page)), paragraphIndex});
-      },
-      embeddedStyle, contentBase, imageBasePath, imageRendering, popupFn, cssParser);
-  Hyphenator::setPreferredLanguage(epub->getLanguage());
-  success = visitor.parseAndBuildPages();
+  ChapterHtmlSlimParser visitor(epub, tmpHtmlPath, renderer, fontId, lineCompression, extraParagraphSpacing,
+                                paragraphAlignment, viewportWidth, viewportHeight, hyphenationEnabled, completePageFn,
+                                embeddedStyle, contentBase, imageBasePath, imageRendering, popupFn, cssParser);
+  visitor.setLayoutPipelineDepth(LAYOUT_PIPELINE_DEPTH);
 
+  // Record the chapter's items for laying it out again; the header is marked complete once they all are
+  if (Storage.exists(itemCachePath.c_str())) {
+    Storage.remove(itemCachePath.c_str());
+  }
+  FsFile itemCache;
+  const bool recordItems = Storage.openFileForWrite("SCT", itemCachePath, itemCache);
+  if (recordItems) {
+    serialization::writePod(itemCache, SECTION_FILE_VERSION);
+    serialization::writePod(itemCache, paragraphAlignment);
+    serialization::writePod(itemCache, embeddedStyle);
+    serialization::writePod(itemCache, imageRendering);
+    serialization::writePod(itemCache, false);
+    visitor.setItemCacheFile(&itemCache);
+  }
+
+  success = visitor.parseAndBuildPages();
   Storage.remove(tmpHtmlPath.c_str());
-  if (!success) {
-    LOG_ERR("SCT", "Failed to parse XML and build pages");
-    // Explicitly close() file before calling Storage.remove()
-    file.close();
-    Storage.remove(filePath.c_str());
-    if (cssParser) {
-      cssParser->clear();
-    }
-    return false;
+  if (cssParser) {
+    cssParser->clear();
   }
 
-  const uint32_t lutOffset = file.position();
-  bool hasFailedLutRecords = false;
-  // Write LUT
-  for (const auto& entry : lut) {
-    if (entry.fileOffset == 0) {
-      hasFailedLutRecords = true;
-      break;
+  if (recordItems) {
+    if (success && visitor.isItemCacheComplete()) {
+      itemCache.seek(ITEM_CACHE_HEADER_SIZE - sizeof(bool));
+      serialization::writePod(itemCache, true);
+      itemCache.close();
+    } else {
+      // Explicitly close() file before calling Storage.remove()
+      itemCache.close();
+      Storage.remove(itemCachePath.c_str());
     }
-    serialization::writePod(file, entry.fileOffset);
   }
 
-  if (hasFailedLutRecords) {
-    LOG_ERR("SCT", "Failed to write LUT due to invalid page positions");
-    // Explicitly close() file before calling Storage.remove()
-    file.close();
-    Storage.remove(filePath.c_str());
-    return false;
+  if (success) {
+    anchors = visitor.getAnchors();
   }
+  return success;
+}
 
-  // Write anchor-to-page map for fragment navigation (e.g. footnote targets)
-  const uint32_t anchorMapOffset = file.position();
-  const auto& anchors = visitor.getAnchors();
-  serialization::writePod(file, static_cast<uint16_t>(anchors.size()));
-  for (const auto& [anchor, page] : anchors) {
-    serialization::writeString(file, anchor);
-    serialization::writePod(file, page);
+bool Section::layOutItems(FsFile& itemCache, const int fontId, const float lineCompression,
+                          const bool extraParagraphSpacing, const uint16_t viewportWidth,
+                          const uint16_t viewportHeight, const bool hyphenationEnabled,
+                          const CompletePageFn& completePageFn,
+                          std::vector<std::pair<std::string, uint16_t>>& anchors,
+                          const std::function<void()>& popupFn) {
+  if (popupFn && itemCache.size() >= MIN_ITEM_CACHE_SIZE_FOR_POPUP) {
+    popupFn();
   }
 
-  const uint32_t paragraphLutOffset = file.position();
-  serialization::writePod(file, static_cast<uint16_t>(lut.size()));
-  for (const auto& entry : lut) {
-    serialization::writePod(file, entry.paragraphIndex);
+  const uint32_t startTime = millis();
+  ChapterPageBuilder pageBuilder(renderer, fontId, lineCompression, extraParagraphSpacing, viewportWidth,
+                                 viewportHeight, hyphenationEnabled, completePageFn);
+  // One item, reused: its storage grows to the largest paragraph part of the chapter
+  ChapterPageBuilder::Item item;
+  do {
+    // A cache marked complete still ends in an End item; running out of items first means it is damaged
+    if (itemCache.position() >= itemCache.size() || !item.deserialize(itemCache)) {
+      itemCache.close();
+      return false;
+    }
+    // Prerendering images deletes their source once decoded for the old layout
+    if (item.kind == ChapterPageBuilder::Item::Kind::Image && !Storage.exists(item.name.c_str()) &&
+        !extractImage(item.name, item.source)) {
+      itemCache.close();
+      return false;
+    }
+    pageBuilder.process(item);
+  } while (item.kind != ChapterPageBuilder::Item::Kind::End);
+  itemCache.close();
+
+  anchors = pageBuilder.getAnchors();
+  LOG_DBG("SCT", "Laid out section %d from its item cache in %lu ms", spineIndex, millis() - startTime);
+  return true;
+}
+
+bool Section::extractImage(const std::string& path, const std::string& source) const {
+  FsFile imageFile;
+  if (!Storage.openFileForWrite("SCT", path, imageFile)) {
+    return false;
   }
+  const bool success = epub->readItemContentsToStream(source, imageFile, 4096);
+  imageFile.flush();
+  // Explicitly close() file before calling Storage.remove()
+  imageFile.close();
+  if (!success) {
+    LOG_ERR("SCT", "Failed to extract image %s", source.c_str());
+    Storage.remove(path.c_str());
+  }
+  return success;
+}
 
-  // Patch header with final pageCount, lutOffset, anchorMapOffset, and paragraphLutOffset
-  file.seek(HEADER_SIZE - sizeof(uint32_t) * 3 - sizeof(pageCount));
-  serialization::writePod(file, pageCount);
-  serialization::writePod(file, lutOffset);
-  serialization::writePod(file, anchorMapOffset);
-  serialization::writePod(file, paragraphLutOffset);
-  // Explicit close() required: member variable persists beyond function scope
-  file.close();
-  if (cssParser) {
-    cssParser->clear();
+int Section::decodeImages(const int xOffset, const int yOffset) {
+  int decoded = 0;
+  const unsigned long start = millis();
+  for (const auto& image : pendingImages) {
+    const unsigned long imageStart = millis();
+    const int x = image.x + xOffset;
+    const int y = image.y + yOffset;
+    if (image.block->decodeToCache(renderer, x, y)) {
+      decoded++;
+      LOG_INF("SCT", "Decoded image %s (%dx%d) in %lums", image.block->getImagePath().c_str(),
+              image.block->getWidth(), image.block->getHeight(), millis() - imageStart);
+    } else {
+      LOG_DBG("SCT", "Left image for render-time decode: %s", image.block->getImagePath().c_str());
+    }
   }
-  return true;
+  if (!pendingImages.empty()) {
+    LOG_INF("SCT", "Decoded %d/%zu images for section %d in %lums", decoded, pendingImages.size(), spineIndex,
+            millis() - start);
+  }
+  pendingImages.clear();
+  pendingImages.shrink_to_fit();
+  return decoded;
 }
 
-std::unique_ptr<Page> Section::loadPageFromSectionFile() {
-  if (!Storage.openFileForRead("SCT", filePath, file)) {
+std::unique_ptr<Page> Section::loadPageFromSectionFile() { return loadPage(currentPage); }
+
+std::unique_ptr<Page> Section::loadPage(const uint16_t pageNumber) const {
+  if (pageNumber >= pageCount) {
+    return nullptr;
+  }
+
+  FsFile f;
+  if (!Storage.openFileForRead("SCT", filePath, f)) {
     return nullptr;
   }
 
-  file.seek(HEADER_SIZE - sizeof(uint32_t) * 3);
+  f.seek(HEADER_SIZE - sizeof(uint32_t) * 3);
   uint32_t lutOffset;
-  serialization::readPod(file, lutOffset);
-  file.seek(lutOffset + sizeof(uint32_t) * currentPage);
+  serialization::readPod(f, lutOffset);
+  f.seek(lutOffset + sizeof(uint32_t) * pageNumber);
   uint32_t pagePos;
-  serialization::readPod(file, pagePos);
-  file.seek(pagePos);
+  serialization::readPod(f, pagePos);
+  f.seek(pagePos);
 
-  auto page = Page::deserialize(file);
-  // Explicit close() required: member variable persists beyond function scope
-  file.close();
-  return page;
+  return Page::deserialize(f);
 }
 
 std::optional<uint16_t> Section::getPageForAnchor(const std::string& anchor) const {
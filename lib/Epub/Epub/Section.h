@@ -3,23 +3,48 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "Epub.h"
 
 class Page;
 class GfxRenderer;
+class ImageBlock;
 
 class Section {
   std::shared_ptr<Epub> epub;
   const int spineIndex;
   GfxRenderer& renderer;
   std::string filePath;
+  // The chapter's items as parsed (see ChapterPageBuilder), independent of font and viewport
+  std::string itemCachePath;
   FsFile file;
 
+  // Images placed by the last createSectionFile(), with their position on the page
+  struct PendingImage {
+    std::shared_ptr<ImageBlock> block;
+    int16_t x;
+    int16_t y;
+  };
+  std::vector<PendingImage> pendingImages;
+
+  using CompletePageFn = std::function<void(std::unique_ptr<Page>, uint16_t)>;
+
   void writeSectionFileHeader(int fontId, float lineCompression, bool extraParagraphSpacing, uint8_t paragraphAlignment,
                               uint16_t viewportWidth, uint16_t viewportHeight, bool hyphenationEnabled,
                               bool embeddedStyle, uint8_t imageRendering);
   uint32_t onPageComplete(std::unique_ptr<Page> page);
+  bool openItemCache(FsFile& itemCache, uint8_t paragraphAlignment, bool embeddedStyle, uint8_t imageRendering) const;
+  bool parseChapter(int fontId, float lineCompression, bool extraParagraphSpacing, uint8_t paragraphAlignment,
+                    uint16_t viewportWidth, uint16_t viewportHeight, bool hyphenationEnabled, bool embeddedStyle,
+                    uint8_t imageRendering, const CompletePageFn& completePageFn,
+                    std::vector<std::pair<std::string, uint16_t>>& anchors, const std::function<void()>& popupFn);
+  bool layOutItems(FsFile& itemCache, int fontId, float lineCompression, bool extraParagraphSpacing,
+                   uint16_t viewportWidth, uint16_t viewportHeight, bool hyphenationEnabled,
+                   const CompletePageFn& completePageFn, std::vector<std::pair<std::string, uint16_t>>& anchors,
+                   const std::function<void()>& popupFn);
+  bool extractImage(const std::string& path, const std::string& source) const;
 
  public:
   uint16_t pageCount = 0;
@@ -29,16 +54,24 @@ class Section {
       : epub(epub),
         spineIndex(spineIndex),
         renderer(renderer),
-        filePath(epub->getCachePath() + "/sections/" + std::to_string(spineIndex) + ".bin") {}
+        filePath(epub->getCachePath() + "/sections/" + std::to_string(spineIndex) + ".bin"),
+        itemCachePath(epub->getCachePath() + "/sections/" + std::to_string(spineIndex) + ".items") {}
   ~Section() = default;
   bool loadSectionFile(int fontId, float lineCompression, bool extraParagraphSpacing, uint8_t paragraphAlignment,
                        uint16_t viewportWidth, uint16_t viewportHeight, bool hyphenationEnabled, bool embeddedStyle,
                        uint8_t imageRendering);
+  // Removes the section file only: the item cache stays valid through layout setting changes
   bool clearCache() const;
+  // Parses the chapter, or lays it out from its item cache when only font, spacing or viewport settings changed
   bool createSectionFile(int fontId, float lineCompression, bool extraParagraphSpacing, uint8_t paragraphAlignment,
                          uint16_t viewportWidth, uint16_t viewportHeight, bool hyphenationEnabled, bool embeddedStyle,
                          uint8_t imageRendering, const std::function<void()>& popupFn = nullptr);
+  // Decode the images placed by the last createSectionFile() into their pixel caches, so their pages render
+  // without decoding. xOffset/yOffset are the page margins used when rendering. Returns the number decoded.
+  int decodeImages(int xOffset, int yOffset);
   std::unique_ptr<Page> loadPageFromSectionFile();
+  // Read any page of the section file, e.g. a neighbour of the current page ahead of time
+  std::unique_ptr<Page> loadPage(uint16_t pageNumber) const;
 
   // Look up the page number for an anchor id from the section cache file.
   std::optional<uint16_t> getPageForAnchor(const std::string& anchor) const;
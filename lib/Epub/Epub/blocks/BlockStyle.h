@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <vector>
 
 #include "Epub/css/CssStyle.h"
 
@@ -67,30 +68,92 @@ struct BlockStyle {
     }
     return combinedBlockStyle;
   }
+};
 
-  // Create a BlockStyle from CSS style properties, resolving CssLength values to pixels
-  // emSize is the current font line height, used for em/rem unit conversion
-  // paragraphAlignment is the user's paragraphAlignment setting preference
-  static BlockStyle fromCssStyle(const CssStyle& cssStyle, const float emSize, const CssTextAlign paragraphAlignment,
-                                 const uint16_t viewportWidth = 0) {
+/**
+ * CssBlockStyle - A BlockStyle with its lengths still in CSS units, so it can be resolved for any font and viewport
+ *
+ * Nested block elements each contribute a box of margins and padding; resolved, they add up the way
+ * BlockStyle::getCombinedBlockStyle() adds up resolved styles. Alignment and text indent come from the innermost
+ * element that defines them.
+ */
+struct CssBlockStyle {
+  struct Box {
+    CssLength marginTop;
+    CssLength marginBottom;
+    CssLength marginLeft;
+    CssLength marginRight;
+    CssLength paddingTop;
+    CssLength paddingBottom;
+    CssLength paddingLeft;
+    CssLength paddingRight;
+  };
+
+  std::vector<Box> boxes;  // Outermost first; only elements that set some margin or padding have one
+  CssTextAlign alignment = CssTextAlign::Justify;
+  bool textAlignDefined = false;
+  CssLength textIndent;
+  bool textIndentDefined = false;
+
+  // Combine with the style of a child element, as BlockStyle::getCombinedBlockStyle() does
+  void combineWith(const CssBlockStyle& child) {
+    boxes.insert(boxes.end(), child.boxes.begin(), child.boxes.end());
+    if (child.textIndentDefined) {
+      textIndent = child.textIndent;
+      textIndentDefined = true;
+    }
+    if (child.textAlignDefined) {
+      alignment = child.alignment;
+      textAlignDefined = true;
+    }
+  }
+
+  // Resolve the lengths to pixels. emSize is the current font's em size, used for em/rem units, and viewportWidth
+  // the width percentages are taken of.
+  [[nodiscard]] BlockStyle resolve(const float emSize, const uint16_t viewportWidth) const {
     BlockStyle blockStyle;
     const float vw = viewportWidth;
-    const auto maxHorizontalInsetPx = static_cast<int16_t>(emSize * MAX_HORIZONTAL_INSET_EM);
-    // Resolve all CssLength values to pixels using the current font's em size and viewport width
-    blockStyle.marginTop = cssStyle.marginTop.toPixelsInt16(emSize, vw);
-    blockStyle.marginBottom = cssStyle.marginBottom.toPixelsInt16(emSize, vw);
-    blockStyle.marginLeft = std::min(cssStyle.marginLeft.toPixelsInt16(emSize, vw), maxHorizontalInsetPx);
-    blockStyle.marginRight = std::min(cssStyle.marginRight.toPixelsInt16(emSize, vw), maxHorizontalInsetPx);
-
-    blockStyle.paddingTop = cssStyle.paddingTop.toPixelsInt16(emSize, vw);
-    blockStyle.paddingBottom = cssStyle.paddingBottom.toPixelsInt16(emSize, vw);
-    blockStyle.paddingLeft = std::min(cssStyle.paddingLeft.toPixelsInt16(emSize, vw), maxHorizontalInsetPx);
-    blockStyle.paddingRight = std::min(cssStyle.paddingRight.toPixelsInt16(emSize, vw), maxHorizontalInsetPx);
-
-    // For textIndent: if it's a percentage we can't resolve (no viewport width),
-    // leave textIndentDefined=false so the EmSpace fallback in applyParagraphIndent() is used
-    if (cssStyle.hasTextIndent() && cssStyle.textIndent.isResolvable(vw)) {
-      blockStyle.textIndent = cssStyle.textIndent.toPixelsInt16(emSize, vw);
+    const auto maxHorizontalInsetPx = static_cast<int16_t>(emSize * BlockStyle::MAX_HORIZONTAL_INSET_EM);
+    const auto add = [](int16_t& total, const int16_t pixels) { total = static_cast<int16_t>(total + pixels); };
+    const auto addHorizontal = [&](int16_t& total, const CssLength& length) {
+      add(total, std::min(length.toPixelsInt16(emSize, vw), maxHorizontalInsetPx));
+    };
+    for (const auto& box : boxes) {
+      add(blockStyle.marginTop, box.marginTop.toPixelsInt16(emSize, vw));
+      add(blockStyle.marginBottom, box.marginBottom.toPixelsInt16(emSize, vw));
+      addHorizontal(blockStyle.marginLeft, box.marginLeft);
+      addHorizontal(blockStyle.marginRight, box.marginRight);
+      add(blockStyle.paddingTop, box.paddingTop.toPixelsInt16(emSize, vw));
+      add(blockStyle.paddingBottom, box.paddingBottom.toPixelsInt16(emSize, vw));
+      addHorizontal(blockStyle.paddingLeft, box.paddingLeft);
+      addHorizontal(blockStyle.paddingRight, box.paddingRight);
+    }
+
+    // If the indent is a percentage we can't resolve (no viewport width), leave textIndentDefined=false so the
+    // EmSpace fallback in applyParagraphIndent() is used
+    if (textIndentDefined && textIndent.isResolvable(vw)) {
+      blockStyle.textIndent = textIndent.toPixelsInt16(emSize, vw);
+      blockStyle.textIndentDefined = true;
+    }
+    blockStyle.alignment = alignment;
+    blockStyle.textAlignDefined = textAlignDefined;
+    return blockStyle;
+  }
+
+  // Create a CssBlockStyle from an element's CSS style properties
+  // paragraphAlignment is the user's paragraphAlignment setting preference
+  static CssBlockStyle fromCssStyle(const CssStyle& cssStyle, const CssTextAlign paragraphAlignment) {
+    CssBlockStyle blockStyle;
+    const auto& defined = cssStyle.defined;
+    if (defined.marginTop || defined.marginBottom || defined.marginLeft || defined.marginRight ||
+        defined.paddingTop || defined.paddingBottom || defined.paddingLeft || defined.paddingRight) {
+      blockStyle.boxes.push_back({cssStyle.marginTop, cssStyle.marginBottom, cssStyle.marginLeft,
+                                  cssStyle.marginRight, cssStyle.paddingTop, cssStyle.paddingBottom,
+                                  cssStyle.paddingLeft, cssStyle.paddingRight});
+    }
+
+    if (cssStyle.hasTextIndent()) {
+      blockStyle.textIndent = cssStyle.textIndent;
       blockStyle.textIndentDefined = true;
     }
     blockStyle.textAlignDefined = cssStyle.hasTextAlign();
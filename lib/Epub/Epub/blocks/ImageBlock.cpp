@@ -1,16 +1,25 @@
 #include "ImageBlock.h"
 
 #include <GfxRenderer.h>
+#include <HeapTags.h>
 #include <Logging.h>
 #include <Serialization.h>
 
+#include <algorithm>
+#include <cstring>
+
 #include "../converters/DirectPixelWriter.h"
 #include "../converters/ImageDecoderFactory.h"
+#include "../converters/ImagePlaneCache.h"
 
-// Cache file format:
+// Cache file formats:
+// .pxc (v1, written by the decoders):
 // - uint16_t width
 // - uint16_t height
 // - uint8_t pixels[...] - 2 bits per pixel, packed (4 pixels per byte), row-major order
+// .ppc (v2, built from the v1 cache for the current orientation): see PanelImage.h
+// - uint8_t header[PanelImage::HEADER_SIZE]
+// - uint8_t planes[3][spanBytes * rows] - BW, grayscale LSB, grayscale MSB in framebuffer layout
 
 ImageBlock::ImageBlock(const std::string& imagePath, int16_t width, int16_t height)
     : imagePath(imagePath), width(width), height(height) {}
@@ -19,23 +28,25 @@ bool ImageBlock::imageExists() const { return Storage.exists(imagePath.c_str());
 
 namespace {
 
-std::string getCachePath(const std::string& imagePath) {
-  // Replace extension with .pxc (pixel cache)
+// Plane rows streamed per SD read when a v2 cache is drawn without the page plane cache
+constexpr size_t PANEL_READ_CHUNK = 2048;
+
+std::string getCachePath(const std::string& imagePath, const char* extension) {
+  // Replace extension with the cache extension
   size_t dotPos = imagePath.rfind('.');
   if (dotPos != std::string::npos) {
-    return imagePath.substr(0, dotPos) + ".pxc";
+    return imagePath.substr(0, dotPos) + extension;
   }
-  return imagePath + ".pxc";
+  return imagePath + extension;
 }
 
-bool renderFromCache(GfxRenderer& renderer, const std::string& cachePath, int x, int y, int expectedWidth,
-                     int expectedHeight) {
-  FsFile cacheFile;
+// Open a v1 cache and read its dimensions, checking them against the layout size
+bool openPixelCache(const std::string& cachePath, FsFile& cacheFile, const int expectedWidth,
+                    const int expectedHeight, uint16_t& cachedWidth, uint16_t& cachedHeight) {
   if (!Storage.openFileForRead("IMG", cachePath, cacheFile)) {
     return false;
   }
 
-  uint16_t cachedWidth, cachedHeight;
   if (cacheFile.read(&cachedWidth, 2) != 2 || cacheFile.read(&cachedHeight, 2) != 2) {
     return false;
   }
@@ -48,16 +59,28 @@ bool renderFromCache(GfxRenderer& renderer, const std::string& cachePath, int x,
             expectedHeight);
     return false;
   }
+  return true;
+}
 
-  // Use cached dimensions for rendering (they're the actual decoded size)
-  expectedWidth = cachedWidth;
-  expectedHeight = cachedHeight;
+bool computeLayout(const GfxRenderer& renderer, const int x, const int y, const int width, const int height,
+                   PanelImage::Layout& layout) {
+  return PanelImage::computeLayout(static_cast<uint8_t>(renderer.getOrientation()), renderer.getDisplayWidth(),
+                                   renderer.getDisplayHeight(), x, y, width, height, layout);
+}
+
+bool renderFromCache(GfxRenderer& renderer, const std::string& cachePath, int x, int y, int expectedWidth,
+                     int expectedHeight) {
+  FsFile cacheFile;
+  uint16_t cachedWidth, cachedHeight;
+  if (!openPixelCache(cachePath, cacheFile, expectedWidth, expectedHeight, cachedWidth, cachedHeight)) {
+    return false;
+  }
 
   LOG_DBG("IMG", "Loading from cache: %s (%dx%d)", cachePath.c_str(), cachedWidth, cachedHeight);
 
   // Read and render row by row to minimize memory usage
   const int bytesPerRow = (cachedWidth + 3) / 4;  // 2 bits per pixel, 4 pixels per byte
-  uint8_t* rowBuffer = (uint8_t*)malloc(bytesPerRow);
+  auto* rowBuffer = static_cast<uint8_t*>(HeapTags::alloc(HeapTags::Tag::ImageDecode, bytesPerRow));
   if (!rowBuffer) {
     LOG_ERR("IMG", "Failed to allocate row buffer");
     return false;
@@ -66,12 +89,18 @@ bool renderFromCache(GfxRenderer& renderer, const std::string& cachePath, int x,
   DirectPixelWriter pw;
   pw.init(renderer);
 
+  PanelImage::Layout layout;
+  const int planeSlot = computeLayout(renderer, x, y, cachedWidth, cachedHeight, layout)
+                            ? ImagePlaneCache::reserve(cachePath, layout)
+                            : -1;
+
   for (int row = 0; row < cachedHeight; row++) {
     if (cacheFile.read(rowBuffer, bytesPerRow) != bytesPerRow) {
       LOG_ERR("IMG", "Cache read error at row %d", row);
-      free(rowBuffer);
+      HeapTags::release(rowBuffer);
       return false;
     }
+    ImagePlaneCache::storeRow(planeSlot, row, rowBuffer);
 
     const int destY = y + row;
     pw.beginRow(destY);
@@ -84,11 +113,166 @@ bool renderFromCache(GfxRenderer& renderer, const std::string& cachePath, int x,
     }
   }
 
-  free(rowBuffer);
+  HeapTags::release(rowBuffer);
+  ImagePlaneCache::commit(planeSlot);
   LOG_DBG("IMG", "Cache render complete");
   return true;
 }
 
+// Convert the v1 cache into a v2 cache for the renderer's current orientation. Planes are built one at a time so
+// only a single plane has to fit in memory.
+bool buildPanelCache(const GfxRenderer& renderer, const std::string& cachePath, const std::string& panelPath, int x,
+                     int y, int expectedWidth, int expectedHeight) {
+  FsFile cacheFile;
+  uint16_t cachedWidth, cachedHeight;
+  if (!openPixelCache(cachePath, cacheFile, expectedWidth, expectedHeight, cachedWidth, cachedHeight)) {
+    return false;
+  }
+
+  PanelImage::Layout layout;
+  if (!computeLayout(renderer, x, y, cachedWidth, cachedHeight, layout)) {
+    return false;
+  }
+
+  const int bytesPerRow = (cachedWidth + 3) / 4;
+  const size_t planeSize = layout.planeSize();
+  auto* rowBuffer = static_cast<uint8_t*>(HeapTags::alloc(HeapTags::Tag::ImageDecode, bytesPerRow));
+  auto* plane = static_cast<uint8_t*>(HeapTags::alloc(HeapTags::Tag::ImageDecode, planeSize));
+  if (!rowBuffer || !plane) {
+    LOG_ERR("IMG", "Not enough memory to build panel cache (%zu bytes)", planeSize);
+    HeapTags::release(rowBuffer);
+    HeapTags::release(plane);
+    return false;
+  }
+
+  FsFile panelFile;
+  if (!Storage.openFileForWrite("IMG", panelPath, panelFile)) {
+    HeapTags::release(rowBuffer);
+    HeapTags::release(plane);
+    return false;
+  }
+
+  uint8_t header[PanelImage::HEADER_SIZE];
+  PanelImage::encodeHeader(layout, header);
+  bool ok = panelFile.write(header, sizeof(header)) == sizeof(header);
+
+  for (uint8_t mode = 0; ok && mode < PanelImage::PLANE_COUNT; mode++) {
+    uint8_t* planes[PanelImage::PLANE_COUNT] = {};
+    planes[mode] = plane;
+    memset(plane, 0, planeSize);
+
+    ok = cacheFile.seekSet(4);
+    for (int row = 0; ok && row < cachedHeight; row++) {
+      ok = cacheFile.read(rowBuffer, bytesPerRow) == bytesPerRow;
+      if (ok) PanelImage::addRow(layout, planes, row, rowBuffer);
+    }
+    ok = ok && panelFile.write(plane, planeSize) == planeSize;
+  }
+
+  panelFile.close();
+  HeapTags::release(rowBuffer);
+  HeapTags::release(plane);
+
+  if (!ok) {
+    LOG_ERR("IMG", "Failed to build panel cache: %s", panelPath.c_str());
+    Storage.remove(panelPath.c_str());
+    return false;
+  }
+  LOG_DBG("IMG", "Panel cache written: %s (%u rows x %u bytes)", panelPath.c_str(), layout.rows, layout.spanBytes);
+  return true;
+}
+
+bool renderFromPanelCache(GfxRenderer& renderer, const std::string& cachePath, const std::string& panelPath, int x,
+                          int y, int expectedWidth, int expectedHeight) {
+  if (!Storage.exists(panelPath.c_str())) {
+    return false;
+  }
+
+  FsFile panelFile;
+  if (!Storage.openFileForRead("IMG", panelPath, panelFile)) {
+    return false;
+  }
+
+  uint8_t header[PanelImage::HEADER_SIZE];
+  PanelImage::Layout layout;
+  if (panelFile.read(header, sizeof(header)) != sizeof(header) || !PanelImage::decodeHeader(header, layout)) {
+    LOG_ERR("IMG", "Invalid panel cache: %s", panelPath.c_str());
+    return false;
+  }
+
+  // Built for another orientation, panel or position: the caller rebuilds it from the v1 cache
+  if (layout.orientation != renderer.getOrientation() || layout.panelWidth != renderer.getDisplayWidth() ||
+      layout.panelHeight != renderer.getDisplayHeight() || layout.x != x || layout.y != y ||
+      abs(layout.width - expectedWidth) > 1 || abs(layout.height - expectedHeight) > 1) {
+    return false;
+  }
+
+  const size_t planeSize = layout.planeSize();
+  if (panelFile.size() != PanelImage::HEADER_SIZE + PanelImage::PLANE_COUNT * planeSize) {
+    LOG_ERR("IMG", "Truncated panel cache: %s", panelPath.c_str());
+    return false;
+  }
+
+  // Keep all planes for the remaining passes over this page when the budget allows
+  const int planeSlot = ImagePlaneCache::reserve(cachePath, layout);
+  if (planeSlot >= 0) {
+    for (uint8_t mode = 0; mode < PanelImage::PLANE_COUNT; mode++) {
+      if (panelFile.read(ImagePlaneCache::plane(planeSlot, mode), planeSize) != static_cast<int>(planeSize)) {
+        LOG_ERR("IMG", "Panel cache read error: %s", panelPath.c_str());
+        return false;
+      }
+    }
+    ImagePlaneCache::commit(planeSlot);
+    return ImagePlaneCache::blit(renderer, cachePath, x, y);
+  }
+
+  // Otherwise stream just the plane for the current mode
+  const uint8_t mode = renderer.getRenderMode();
+  if (mode >= PanelImage::PLANE_COUNT || !panelFile.seekSet(PanelImage::HEADER_SIZE + mode * planeSize)) {
+    return false;
+  }
+
+  const int rowsPerChunk = std::max<int>(1, PANEL_READ_CHUNK / layout.spanBytes);
+  auto* chunk = static_cast<uint8_t*>(
+      HeapTags::alloc(HeapTags::Tag::ImageDecode, static_cast<size_t>(rowsPerChunk) * layout.spanBytes));
+  if (!chunk) {
+    LOG_ERR("IMG", "Failed to allocate panel read buffer");
+    return false;
+  }
+
+  uint8_t* frameBuffer = renderer.getFrameBuffer();
+  const uint16_t stride = renderer.getDisplayWidthBytes();
+  for (int row = 0; row < layout.rows; row += rowsPerChunk) {
+    const int rowCount = std::min(rowsPerChunk, layout.rows - row);
+    const int bytes = rowCount * layout.spanBytes;
+    if (panelFile.read(chunk, bytes) != bytes) {
+      // Rows already drawn stay; the v1 cache redraws the whole image over them
+      LOG_ERR("IMG", "Panel cache read error at row %d", row);
+      HeapTags::release(chunk);
+      return false;
+    }
+    PanelImage::blitRows(frameBuffer, stride, layout, mode, row, rowCount, chunk);
+  }
+
+  HeapTags::release(chunk);
+  return true;
+}
+
+RenderConfig makeDecodeConfig(const int x, const int y, const int width, const int height,
+                              const std::string& cachePath) {
+  RenderConfig config;
+  config.x = x;
+  config.y = y;
+  config.maxWidth = width;
+  config.maxHeight = height;
+  config.useGrayscale = true;
+  config.useDithering = true;
+  config.performanceMode = false;
+  config.useExactDimensions = true;  // Use pre-calculated dimensions to avoid rounding mismatches
+  config.cachePath = cachePath;      // Enable caching during decode
+  return config;
+}
+
 }  // namespace
 
 void ImageBlock::render(GfxRenderer& renderer, const int x, const int y) {
@@ -104,8 +288,24 @@ void ImageBlock::render(GfxRenderer& renderer, const int x, const int y) {
     return;
   }
 
-  // Try to render from cache first
-  std::string cachePath = getCachePath(imagePath);
+  // Try to render from cache first: the page plane cache, then the panel-native v2 cache, then the v1 cache
+  std::string cachePath = getCachePath(imagePath, ".pxc");
+  if (ImagePlaneCache::blit(renderer, cachePath, x, y)) {
+    return;  // Later passes over the same page draw from the planes captured by the first one
+  }
+
+  std::string panelPath = getCachePath(imagePath, ".ppc");
+  if (renderFromPanelCache(renderer, cachePath, panelPath, x, y, width, height)) {
+    return;
+  }
+
+  // Missing or built for another layout: convert the v1 cache once, so later renders can use it
+  if (Storage.exists(cachePath.c_str()) &&
+      buildPanelCache(renderer, cachePath, panelPath, x, y, width, height) &&
+      renderFromPanelCache(renderer, cachePath, panelPath, x, y, width, height)) {
+    return;
+  }
+
   if (renderFromCache(renderer, cachePath, x, y, width, height)) {
     return;  // Successfully rendered from cache
   }
@@ -127,16 +327,12 @@ void ImageBlock::render(GfxRenderer& renderer, const int x, const int y) {
 
   LOG_DBG("IMG", "Decoding and caching: %s", imagePath.c_str());
 
-  RenderConfig config;
-  config.x = x;
-  config.y = y;
-  config.maxWidth = width;
-  config.maxHeight = height;
-  config.useGrayscale = true;
-  config.useDithering = true;
-  config.performanceMode = false;
-  config.useExactDimensions = true;  // Use pre-calculated dimensions to avoid rounding mismatches
-  config.cachePath = cachePath;      // Enable caching during decode
+  const RenderConfig config = makeDecodeConfig(x, y, width, height, cachePath);
+
+  // A panel cache left over from an earlier decode no longer matches the pixels about to be cached
+  if (Storage.exists(panelPath.c_str())) {
+    Storage.remove(panelPath.c_str());
+  }
 
   ImageToFramebufferDecoder* decoder = ImageDecoderFactory::getDecoder(imagePath);
   if (!decoder) {
@@ -155,6 +351,41 @@ void ImageBlock::render(GfxRenderer& renderer, const int x, const int y) {
   LOG_DBG("IMG", "Decode successful");
 }
 
+bool ImageBlock::decodeToCache(GfxRenderer& renderer, const int x, const int y) const {
+  if (x < 0 || y < 0 || x + width > renderer.getScreenWidth() || y + height > renderer.getScreenHeight()) {
+    return false;
+  }
+
+  ImageToFramebufferDecoder* decoder = ImageDecoderFactory::getDecoder(imagePath);
+  if (!decoder) {
+    LOG_ERR("IMG", "No decoder found for image: %s", imagePath.c_str());
+    return false;
+  }
+
+  const std::string cachePath = getCachePath(imagePath, ".pxc");
+  const std::string panelPath = getCachePath(imagePath, ".ppc");
+  // Drop caches from an earlier layout so a failed write cannot leave them in place
+  if (Storage.exists(cachePath.c_str())) {
+    Storage.remove(cachePath.c_str());
+  }
+  if (Storage.exists(panelPath.c_str())) {
+    Storage.remove(panelPath.c_str());
+  }
+
+  RenderConfig config = makeDecodeConfig(x, y, width, height, cachePath);
+  config.cacheOnly = true;
+  if (!decoder->decodeToFramebuffer(imagePath, renderer, config) || !Storage.exists(cachePath.c_str())) {
+    return false;
+  }
+
+  // Best effort: without it the panel cache is built on first render
+  buildPanelCache(renderer, cachePath, panelPath, x, y, width, height);
+
+  // The source can always be extracted from the EPUB again when the section is re-indexed
+  Storage.remove(imagePath.c_str());
+  return true;
+}
+
 bool ImageBlock::serialize(FsFile& file) {
   serialization::writeString(file, imagePath);
   serialization::writePod(file, width);
@@ -19,8 +19,13 @@ class ImageBlock final : public Block {
 
   BlockType getType() override { return IMAGE_BLOCK; }
   bool isEmpty() override { return false; }
+  // Approximate heap held by the block, including itself
+  size_t heapBytes() const { return sizeof(ImageBlock) + imagePath.capacity() + 1; }
 
   void render(GfxRenderer& renderer, const int x, const int y);
+  // Decode the source image into its pixel cache (and panel cache for the current orientation) without drawing,
+  // then delete the source. Returns false if the image is left to be decoded at render time.
+  bool decodeToCache(GfxRenderer& renderer, int x, int y) const;
   bool serialize(FsFile& file);
   static std::unique_ptr<ImageBlock> deserialize(FsFile& file);
 
@@ -41,6 +41,17 @@ void TextBlock::render(const GfxRenderer& renderer, const int fontId, const int
   }
 }
 
+size_t TextBlock::heapBytes() const {
+  // Words short enough for the string's inline buffer hold no heap of their own
+  const size_t inlineCapacity = std::string().capacity();
+  size_t bytes = sizeof(TextBlock) + words.capacity() * sizeof(std::string) + wordXpos.capacity() * sizeof(int16_t) +
+                 wordStyles.capacity() * sizeof(EpdFontFamily::Style);
+  for (const auto& w : words) {
+    if (w.capacity() > inlineCapacity) bytes += w.capacity() + 1;
+  }
+  return bytes;
+}
+
 bool TextBlock::serialize(FsFile& file) const {
   if (words.size() != wordXpos.size() || words.size() != wordStyles.size()) {
     LOG_ERR("TXB", "Serialization failed: size mismatch (words=%u, xpos=%u, styles=%u)\n", words.size(),
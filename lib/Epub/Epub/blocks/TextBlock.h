@@ -30,6 +30,8 @@ class TextBlock final : public Block {
   const std::vector<std::string>& getWords() const { return words; }
   bool isEmpty() override { return words.empty(); }
   size_t wordCount() const { return words.size(); }
+  // Approximate heap held by the block, including itself
+  size_t heapBytes() const;
   // given a renderer works out where to break the words into lines
   void render(const GfxRenderer& renderer, int fontId, int x, int y) const;
   BlockType getType() override { return TEXT_BLOCK; }
@@ -4,6 +4,16 @@
 #include <HalDisplay.h>
 #include <stdint.h>
 
+#include "PanelImage.h"
+
+static_assert(GfxRenderer::Portrait == PanelImage::PORTRAIT &&
+                  GfxRenderer::LandscapeClockwise == PanelImage::LANDSCAPE_CLOCKWISE &&
+                  GfxRenderer::PortraitInverted == PanelImage::PORTRAIT_INVERTED &&
+                  GfxRenderer::LandscapeCounterClockwise == PanelImage::LANDSCAPE_COUNTER_CLOCKWISE,
+              "PanelImage orientation codes must match GfxRenderer::Orientation");
+static_assert(GfxRenderer::BW == 0 && GfxRenderer::GRAYSCALE_LSB == 1 && GfxRenderer::GRAYSCALE_MSB == 2,
+              "PanelImage planes are indexed by render mode");
+
 // Direct framebuffer writer that eliminates per-pixel overhead from the image
 // rendering hot path.  Pre-computes orientation transform as linear coefficients
 // and caches render-mode state so the inner loop is: one multiply, one add,
@@ -32,56 +42,14 @@ struct DirectPixelWriter {
     mode = renderer.getRenderMode();
     displayWidthBytes = renderer.getDisplayWidthBytes();
 
-    const int phyW = renderer.getDisplayWidth();
-    const int phyH = renderer.getDisplayHeight();
-
-    switch (renderer.getOrientation()) {
-      case GfxRenderer::Portrait:
-        // phyX = y, phyY = (phyH-1) - x
-        phyXBase = 0;
-        phyYBase = phyH - 1;
-        phyXStepX = 0;
-        phyYStepX = -1;
-        phyXStepY = 1;
-        phyYStepY = 0;
-        break;
-      case GfxRenderer::LandscapeClockwise:
-        // phyX = (phyW-1) - x, phyY = (phyH-1) - y
-        phyXBase = phyW - 1;
-        phyYBase = phyH - 1;
-        phyXStepX = -1;
-        phyYStepX = 0;
-        phyXStepY = 0;
-        phyYStepY = -1;
-        break;
-      case GfxRenderer::PortraitInverted:
-        // phyX = (phyW-1) - y, phyY = x
-        phyXBase = phyW - 1;
-        phyYBase = 0;
-        phyXStepX = 0;
-        phyYStepX = 1;
-        phyXStepY = -1;
-        phyYStepY = 0;
-        break;
-      case GfxRenderer::LandscapeCounterClockwise:
-        // phyX = x, phyY = y
-        phyXBase = 0;
-        phyYBase = 0;
-        phyXStepX = 1;
-        phyYStepX = 0;
-        phyXStepY = 0;
-        phyYStepY = 1;
-        break;
-      default:
-        // Fallback to LandscapeCounterClockwise (identity transform)
-        phyXBase = 0;
-        phyYBase = 0;
-        phyXStepX = 1;
-        phyYStepX = 0;
-        phyXStepY = 0;
-        phyYStepY = 1;
-        break;
-    }
+    const auto t = PanelImage::Transform::forOrientation(static_cast<uint8_t>(renderer.getOrientation()),
+                                                         renderer.getDisplayWidth(), renderer.getDisplayHeight());
+    phyXBase = t.xBase;
+    phyYBase = t.yBase;
+    phyXStepX = t.xStepX;
+    phyYStepX = t.yStepX;
+    phyXStepY = t.xStepY;
+    phyYStepY = t.yStepY;
   }
 
   // Call once per row before the column loop.
@@ -95,35 +63,26 @@ struct DirectPixelWriter {
   // Must be called after beginRow() for the current row.
   // No bounds checking — caller guarantees coordinates are valid.
   inline void writePixel(int logicalX, uint8_t pixelValue) const {
-    // Determine whether to draw based on render mode
-    bool draw;
-    bool state;
-    switch (mode) {
-      case GfxRenderer::BW:
-        draw = (pixelValue < 3);
-        state = true;
-        break;
-      case GfxRenderer::GRAYSCALE_MSB:
-        draw = (pixelValue == 1 || pixelValue == 2);
-        state = false;
-        break;
-      case GfxRenderer::GRAYSCALE_LSB:
-        draw = (pixelValue == 1);
-        state = false;
-        break;
-      default:
-        return;
+    if (drawsValue(mode, pixelValue)) {
+      drawPixel(logicalX);
     }
+  }
 
-    if (!draw) return;
+  // Whether a 2-bit pixel value produces ink in the given render mode
+  static inline bool drawsValue(GfxRenderer::RenderMode renderMode, uint8_t pixelValue) {
+    return PanelImage::drawsValue(static_cast<uint8_t>(renderMode), pixelValue);
+  }
 
+  // Mark a pixel the way the current render mode draws: BW clears the bit (black),
+  // grayscale modes set it. Must be called after beginRow() for the current row.
+  inline void drawPixel(int logicalX) const {
     const int phyX = rowPhyXBase + logicalX * phyXStepX;
     const int phyY = rowPhyYBase + logicalX * phyYStepX;
 
     const uint16_t byteIndex = phyY * displayWidthBytes + (phyX >> 3);
     const uint8_t bitMask = 1 << (7 - (phyX & 7));
 
-    if (state) {
+    if (mode == GfxRenderer::BW) {
       fb[byteIndex] &= ~bitMask;  // Clear bit (draw black)
     } else {
       fb[byteIndex] |= bitMask;  // Set bit (draw white)
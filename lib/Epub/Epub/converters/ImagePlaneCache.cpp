@@ -0,0 +1,151 @@
+#include "ImagePlaneCache.h"
+
+#include <HeapTags.h>
+#include <Logging.h>
+
+#include <cstdlib>
+#include <cstring>
+
+namespace ImagePlaneCache {
+
+namespace {
+
+struct CachedImage {
+  std::string cachePath;
+  PanelImage::Layout layout{};
+  uint8_t* planes[PanelImage::PLANE_COUNT] = {};  // Indexed by render mode, layout.planeSize() bytes each
+  bool complete = false;
+
+  bool reserved() const { return planes[0] != nullptr; }
+
+  void release() {
+    for (auto*& plane : planes) {
+      HeapTags::release(plane);
+      plane = nullptr;
+    }
+  }
+};
+
+bool scopeActive = false;
+size_t usedBytes = 0;
+CachedImage images[MAX_CACHED_IMAGES];
+
+void releaseAll() {
+  for (auto& image : images) {
+    image.release();
+    image = CachedImage{};
+  }
+  usedBytes = 0;
+}
+
+CachedImage* findImage(const std::string& cachePath, const int x, const int y) {
+  for (auto& image : images) {
+    if (image.reserved() && image.layout.x == x && image.layout.y == y && image.cachePath == cachePath) {
+      return &image;
+    }
+  }
+  return nullptr;
+}
+
+CachedImage* slotImage(const int slot) {
+  if (slot < 0 || slot >= MAX_CACHED_IMAGES || !images[slot].reserved()) return nullptr;
+  return &images[slot];
+}
+
+}  // namespace
+
+PageScope::PageScope() {
+  releaseAll();
+  scopeActive = true;
+}
+
+PageScope::~PageScope() {
+  scopeActive = false;
+  releaseAll();
+}
+
+bool blit(GfxRenderer& renderer, const std::string& cachePath, const int x, const int y) {
+  if (!scopeActive) return false;
+
+  const CachedImage* image = findImage(cachePath, x, y);
+  if (!image || !image->complete) return false;
+
+  // Planes are only valid for the orientation they were built for
+  if (image->layout.orientation != renderer.getOrientation()) return false;
+
+  const uint8_t mode = renderer.getRenderMode();
+  if (mode >= PanelImage::PLANE_COUNT) return false;
+
+  PanelImage::blitRows(renderer.getFrameBuffer(), renderer.getDisplayWidthBytes(), image->layout, mode, 0,
+                       image->layout.rows, image->planes[mode]);
+  return true;
+}
+
+int reserve(const std::string& cachePath, const PanelImage::Layout& layout) {
+  if (!scopeActive) return -1;
+
+  // A previous pass that failed part-way left its planes reserved; refill them
+  if (CachedImage* image = findImage(cachePath, layout.x, layout.y)) {
+    if (!image->complete && image->layout.sameKey(layout)) {
+      for (auto* plane : image->planes) {
+        memset(plane, 0, image->layout.planeSize());
+      }
+      return static_cast<int>(image - images);
+    }
+    return -1;
+  }
+
+  const size_t bytes = PanelImage::PLANE_COUNT * layout.planeSize();
+  if (usedBytes + bytes > PLANE_BUDGET_BYTES) {
+    LOG_DBG("IMG", "Plane cache budget exceeded (%zu + %zu bytes), streaming %s", usedBytes, bytes,
+            cachePath.c_str());
+    return -1;
+  }
+
+  for (int slot = 0; slot < MAX_CACHED_IMAGES; slot++) {
+    auto& image = images[slot];
+    if (image.reserved()) continue;
+
+    for (auto*& plane : image.planes) {
+      plane = static_cast<uint8_t*>(HeapTags::allocZeroed(HeapTags::Tag::ImageDecode, 1, layout.planeSize()));
+      if (!plane) {
+        LOG_ERR("IMG", "Failed to allocate %zu bytes of image planes", bytes);
+        image.release();
+        return -1;
+      }
+    }
+    const size_t largestFree = HeapTags::largestFreeBlock();
+    if (largestFree != 0 && largestFree < HEAP_HEADROOM_BYTES) {
+      LOG_DBG("IMG", "Only %zu bytes left in one block after the planes, streaming %s", largestFree,
+              cachePath.c_str());
+      image.release();
+      return -1;
+    }
+    image.cachePath = cachePath;
+    image.layout = layout;
+    image.complete = false;
+    usedBytes += bytes;
+    return slot;
+  }
+  return -1;
+}
+
+uint8_t* plane(const int slot, const uint8_t mode) {
+  CachedImage* image = slotImage(slot);
+  return image && mode < PanelImage::PLANE_COUNT ? image->planes[mode] : nullptr;
+}
+
+void storeRow(const int slot, const int row, const uint8_t* pixelRow) {
+  CachedImage* image = slotImage(slot);
+  if (!image || row < 0 || row >= image->layout.height) return;
+
+  PanelImage::addRow(image->layout, image->planes, row, pixelRow);
+}
+
+void commit(const int slot) {
+  if (CachedImage* image = slotImage(slot)) {
+    image->complete = true;
+  }
+}
+
+}  // namespace ImagePlaneCache
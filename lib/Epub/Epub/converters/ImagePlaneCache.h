@@ -0,0 +1,56 @@
+#pragma once
+
+#include <GfxRenderer.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "PanelImage.h"
+
+/**
+ * Holds the panel-native planes (see PanelImage) of the images on the page being rendered.
+ *
+ * A reader page with images is rendered several times (font scan, BW, blanked BW, grayscale LSB and MSB). Without
+ * this cache every pass re-opens the image's pixel cache on SD. While a PageScope is alive, the first pass that
+ * reads an image keeps all three planes in RAM and later passes blit the plane for the current mode.
+ *
+ * An image takes PLANE_COUNT planes of its panel bounding box (a byte per 8 pixels each), allocated separately so no
+ * block larger than one plane is needed: a full-screen 480x800 illustration takes 3 x 48000 bytes. The images on a
+ * page share PLANE_BUDGET_BYTES, enough for that one full-screen image or several smaller ones, and an image is only
+ * kept while the largest free heap block still holds HEAP_HEADROOM_BYTES afterwards (when the firmware installed the
+ * HeapTags probe), so the rest of the render does not run out of memory. Images that do not fit are not cached and
+ * keep streaming the current mode's plane from SD on every pass.
+ */
+namespace ImagePlaneCache {
+
+constexpr size_t PLANE_BUDGET_BYTES = 160 * 1024;
+// Room for the BW buffer copy the grayscale passes store (48KB, in chunks) and the rest of the page render
+constexpr size_t HEAP_HEADROOM_BYTES = 64 * 1024;
+constexpr int MAX_CACHED_IMAGES = 4;
+
+// Enables caching for the page rendered during its lifetime and releases all planes when it ends
+class PageScope {
+ public:
+  PageScope();
+  ~PageScope();
+  PageScope(const PageScope&) = delete;
+  PageScope& operator=(const PageScope&) = delete;
+};
+
+// Draw a cached image at (x, y) in the renderer's current mode. Returns false if it is not cached.
+bool blit(GfxRenderer& renderer, const std::string& cachePath, int x, int y);
+
+// Reserve zeroed planes for an image that is about to be read from SD. Returns a slot index, or -1 when no scope is
+// active or the image does not fit the budget or the free heap.
+int reserve(const std::string& cachePath, const PanelImage::Layout& layout);
+
+// The reserved plane for a render mode, layout.planeSize() bytes, for filling straight from a v2 cache
+uint8_t* plane(int slot, uint8_t mode);
+
+// Add one 2-bit row of a v1 cache to the reserved planes
+void storeRow(int slot, int row, const uint8_t* pixelRow);
+
+// Mark a reserved image complete so blit() can serve it. Until then (e.g. after a read error) it is never served.
+void commit(int slot);
+
+}  // namespace ImagePlaneCache
@@ -0,0 +1,156 @@
+#include "PanelImage.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace PanelImage {
+
+namespace {
+constexpr uint8_t MAGIC[4] = {'P', 'X', 'P', 'L'};
+
+void putU16(uint8_t*& p, const uint16_t value) {
+  p[0] = value & 0xFF;
+  p[1] = value >> 8;
+  p += 2;
+}
+
+uint16_t getU16(const uint8_t*& p) {
+  const uint16_t value = p[0] | (p[1] << 8);
+  p += 2;
+  return value;
+}
+}  // namespace
+
+Transform Transform::forOrientation(const uint8_t orientation, const int panelWidth, const int panelHeight) {
+  switch (orientation) {
+    case PORTRAIT:
+      // phyX = y, phyY = (phyH-1) - x
+      return {0, panelHeight - 1, 0, -1, 1, 0};
+    case LANDSCAPE_CLOCKWISE:
+      // phyX = (phyW-1) - x, phyY = (phyH-1) - y
+      return {panelWidth - 1, panelHeight - 1, -1, 0, 0, -1};
+    case PORTRAIT_INVERTED:
+      // phyX = (phyW-1) - y, phyY = x
+      return {panelWidth - 1, 0, 0, 1, -1, 0};
+    case LANDSCAPE_COUNTER_CLOCKWISE:
+    default:
+      // phyX = x, phyY = y (native panel orientation)
+      return {0, 0, 1, 0, 0, 1};
+  }
+}
+
+bool computeLayout(const uint8_t orientation, const uint16_t panelWidth, const uint16_t panelHeight, const int x,
+                   const int y, const int width, const int height, Layout& out) {
+  if (width <= 0 || height <= 0) return false;
+
+  const Transform t = Transform::forOrientation(orientation, panelWidth, panelHeight);
+  // Opposite corners of the logical rectangle bound the physical one in every orientation
+  const int right = x + width - 1;
+  const int bottom = y + height - 1;
+  const int phyX0 = t.xBase + x * t.xStepX + y * t.xStepY;
+  const int phyY0 = t.yBase + x * t.yStepX + y * t.yStepY;
+  const int phyX1 = t.xBase + right * t.xStepX + bottom * t.xStepY;
+  const int phyY1 = t.yBase + right * t.yStepX + bottom * t.yStepY;
+  const int minX = std::min(phyX0, phyX1);
+  const int maxX = std::max(phyX0, phyX1);
+  const int minY = std::min(phyY0, phyY1);
+  const int maxY = std::max(phyY0, phyY1);
+  if (minX < 0 || minY < 0 || maxX >= panelWidth || maxY >= panelHeight) return false;
+
+  out.orientation = orientation;
+  out.panelWidth = panelWidth;
+  out.panelHeight = panelHeight;
+  out.x = static_cast<int16_t>(x);
+  out.y = static_cast<int16_t>(y);
+  out.width = static_cast<uint16_t>(width);
+  out.height = static_cast<uint16_t>(height);
+  out.firstByte = static_cast<uint16_t>(minX >> 3);
+  out.firstRow = static_cast<uint16_t>(minY);
+  out.spanBytes = static_cast<uint16_t>((maxX >> 3) - (minX >> 3) + 1);
+  out.rows = static_cast<uint16_t>(maxY - minY + 1);
+  out.transform = t;
+  return true;
+}
+
+void encodeHeader(const Layout& layout, uint8_t out[HEADER_SIZE]) {
+  uint8_t* p = out;
+  memcpy(p, MAGIC, sizeof(MAGIC));
+  p += sizeof(MAGIC);
+  *p++ = FORMAT_VERSION;
+  *p++ = layout.orientation;
+  putU16(p, layout.panelWidth);
+  putU16(p, layout.panelHeight);
+  putU16(p, static_cast<uint16_t>(layout.x));
+  putU16(p, static_cast<uint16_t>(layout.y));
+  putU16(p, layout.width);
+  putU16(p, layout.height);
+  putU16(p, layout.firstByte);
+  putU16(p, layout.firstRow);
+  putU16(p, layout.spanBytes);
+  putU16(p, layout.rows);
+}
+
+bool decodeHeader(const uint8_t in[HEADER_SIZE], Layout& out) {
+  const uint8_t* p = in;
+  if (memcmp(p, MAGIC, sizeof(MAGIC)) != 0) return false;
+  p += sizeof(MAGIC);
+  if (*p++ != FORMAT_VERSION) return false;
+  const uint8_t orientation = *p++;
+  const uint16_t panelWidth = getU16(p);
+  const uint16_t panelHeight = getU16(p);
+  const auto x = static_cast<int16_t>(getU16(p));
+  const auto y = static_cast<int16_t>(getU16(p));
+  const uint16_t width = getU16(p);
+  const uint16_t height = getU16(p);
+  const uint16_t firstByte = getU16(p);
+  const uint16_t firstRow = getU16(p);
+  const uint16_t spanBytes = getU16(p);
+  const uint16_t rows = getU16(p);
+
+  // The span is derived data; recompute it so a corrupt header cannot send writes outside the framebuffer
+  if (!computeLayout(orientation, panelWidth, panelHeight, x, y, width, height, out)) return false;
+  return out.firstByte == firstByte && out.firstRow == firstRow && out.spanBytes == spanBytes && out.rows == rows;
+}
+
+void addRow(const Layout& layout, uint8_t* const planes[PLANE_COUNT], const int row, const uint8_t* pixelRow) {
+  const Transform& t = layout.transform;
+  const int logicalY = layout.y + row;
+  // Position in the plane of the row's first pixel, and how it moves per logical-X step
+  int phyX = t.xBase + layout.x * t.xStepX + logicalY * t.xStepY;
+  int phyY = t.yBase + layout.x * t.yStepX + logicalY * t.yStepY - layout.firstRow;
+  const int originX = layout.firstByte * 8;
+
+  for (int col = 0; col < layout.width; col++, phyX += t.xStepX, phyY += t.yStepX) {
+    const uint8_t pixelValue = (pixelRow[col >> 2] >> (6 - (col & 3) * 2)) & 0x03;
+    const int localX = phyX - originX;
+    const size_t byteIndex = static_cast<size_t>(phyY) * layout.spanBytes + (localX >> 3);
+    const uint8_t bitMask = 0x80 >> (localX & 7);
+    for (uint8_t mode = 0; mode < PLANE_COUNT; mode++) {
+      if (planes[mode] && drawsValue(mode, pixelValue)) {
+        planes[mode][byteIndex] |= bitMask;
+      }
+    }
+  }
+}
+
+void blitRows(uint8_t* frameBuffer, const uint16_t frameBufferStride, const Layout& layout, const uint8_t mode,
+              const int firstPlaneRow, const int rowCount, const uint8_t* planeRows) {
+  const int span = layout.spanBytes;
+  uint8_t* dst = frameBuffer + static_cast<size_t>(layout.firstRow + firstPlaneRow) * frameBufferStride +
+                 layout.firstByte;
+  const uint8_t* src = planeRows;
+
+  if (mode == MODE_BW) {
+    // BW draws ink by clearing bits
+    for (int r = 0; r < rowCount; r++, dst += frameBufferStride, src += span) {
+      for (int i = 0; i < span; i++) dst[i] &= ~src[i];
+    }
+  } else {
+    // Grayscale planes mark ink by setting bits
+    for (int r = 0; r < rowCount; r++, dst += frameBufferStride, src += span) {
+      for (int i = 0; i < span; i++) dst[i] |= src[i];
+    }
+  }
+}
+
+}  // namespace PanelImage
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Panel-native image planes (the v2 pixel cache, `.ppc`).
+ *
+ * A v1 `.pxc` holds 2-bit pixels in logical orientation, so drawing it costs an orientation transform and a
+ * render-mode test per pixel. This format holds the same image already transformed into the physical framebuffer
+ * layout as three 1-bit planes (BW, grayscale LSB, grayscale MSB). Each plane covers the image's bounding rectangle
+ * on the panel, widened to whole bytes, and is bit-aligned with the framebuffer, so drawing is a byte-wise AND-NOT
+ * (BW) or OR (grayscale) of each plane row into the framebuffer row.
+ *
+ * Because the result depends on where the image lands on the panel, the file is keyed by orientation, panel size and
+ * the image's logical rectangle. Render settings that change the pixels themselves are already baked into the v1
+ * cache it is built from.
+ *
+ * Everything here is plain C++ so it can be exercised on the host; file I/O lives in ImageBlock.
+ */
+namespace PanelImage {
+
+constexpr uint8_t FORMAT_VERSION = 2;
+constexpr uint8_t PLANE_COUNT = 3;  // Indexed by render mode: 0 = BW, 1 = grayscale LSB, 2 = grayscale MSB
+constexpr uint8_t MODE_BW = 0;
+constexpr size_t HEADER_SIZE = 26;
+
+// Orientation codes, matching GfxRenderer::Orientation
+constexpr uint8_t PORTRAIT = 0;
+constexpr uint8_t LANDSCAPE_CLOCKWISE = 1;
+constexpr uint8_t PORTRAIT_INVERTED = 2;
+constexpr uint8_t LANDSCAPE_COUNTER_CLOCKWISE = 3;
+
+// Orientation collapsed into a linear transform:
+//   phyX = xBase + x * xStepX + y * xStepY
+//   phyY = yBase + x * yStepX + y * yStepY
+struct Transform {
+  int xBase, yBase;
+  int xStepX, yStepX;  // per logical-X step
+  int xStepY, yStepY;  // per logical-Y step
+
+  static Transform forOrientation(uint8_t orientation, int panelWidth, int panelHeight);
+};
+
+// Whether a 2-bit cache pixel value produces ink in the given render mode
+inline bool drawsValue(const uint8_t mode, const uint8_t pixelValue) {
+  switch (mode) {
+    case 0:  // BW
+      return pixelValue < 3;
+    case 1:  // GRAYSCALE_LSB
+      return pixelValue == 1;
+    case 2:  // GRAYSCALE_MSB
+      return pixelValue == 1 || pixelValue == 2;
+    default:
+      return false;
+  }
+}
+
+struct Layout {
+  // Cache key
+  uint8_t orientation;
+  uint16_t panelWidth;
+  uint16_t panelHeight;
+  int16_t x;  // Logical image rectangle
+  int16_t y;
+  uint16_t width;
+  uint16_t height;
+
+  // Physical span covered by each plane
+  uint16_t firstByte;  // Framebuffer byte column of the first plane byte in each row
+  uint16_t firstRow;   // Framebuffer row of the first plane row
+  uint16_t spanBytes;  // Bytes per plane row
+  uint16_t rows;       // Plane rows
+
+  Transform transform;
+
+  size_t planeSize() const { return static_cast<size_t>(spanBytes) * rows; }
+  bool sameKey(const Layout& other) const {
+    return orientation == other.orientation && panelWidth == other.panelWidth && panelHeight == other.panelHeight &&
+           x == other.x && y == other.y && width == other.width && height == other.height;
+  }
+};
+
+// Place a logical image rectangle on the panel. Returns false if it does not fit on the panel.
+bool computeLayout(uint8_t orientation, uint16_t panelWidth, uint16_t panelHeight, int x, int y, int width,
+                   int height, Layout& out);
+
+// Serialize the layout as the file header, and parse it back (recomputing the derived fields).
+// decodeHeader returns false for a foreign file, another version or inconsistent geometry.
+void encodeHeader(const Layout& layout, uint8_t out[HEADER_SIZE]);
+bool decodeHeader(const uint8_t in[HEADER_SIZE], Layout& out);
+
+// Add one 2-bit logical row of a v1 cache to the planes. Planes must start zeroed; null planes are skipped, so
+// the planes can be built together or one at a time.
+void addRow(const Layout& layout, uint8_t* const planes[PLANE_COUNT], int row, const uint8_t* pixelRow);
+
+// Draw `rowCount` plane rows starting at plane row `firstPlaneRow` into a framebuffer with the given stride
+void blitRows(uint8_t* frameBuffer, uint16_t frameBufferStride, const Layout& layout, uint8_t mode, int firstPlaneRow,
+              int rowCount, const uint8_t* planeRows);
+
+}  // namespace PanelImage
@@ -3,6 +3,7 @@
 #include <FsHelpers.h>
 #include <GfxRenderer.h>
 #include <HalStorage.h>
+#include <HeapTags.h>
 #include <Logging.h>
 #include <PNGdec.h>
 
@@ -193,6 +194,7 @@ int pngDrawCallback(PNGDRAW* pDraw) {
   int screenWidth = ctx->screenWidth;
   bool useDithering = ctx->config->useDithering;
   bool caching = ctx->caching;
+  bool drawing = !ctx->config->cacheOnly;
 
   // Pre-compute orientation and render-mode state once per row
   DirectPixelWriter pw;
@@ -220,7 +222,7 @@ int pngDrawCallback(PNGDRAW* pDraw) {
         ditheredGray = gray / 85;
         if (ditheredGray > 3) ditheredGray = 3;
       }
-      pw.writePixel(outX, ditheredGray);
+      if (drawing) pw.writePixel(outX, ditheredGray);
       if (caching) cw.writePixel(outX, ditheredGray);
     }
 
@@ -244,7 +246,7 @@ bool PngToFramebufferConverter::getDimensionsStatic(const std::string& imagePath
     return false;
   }
 
-  PNG* png = new (std::nothrow) PNG();
+  PNG* png = HeapTags::create<PNG>(HeapTags::Tag::ImageDecode);
   if (!png) {
     LOG_ERR("PNG", "Failed to allocate PNG decoder for dimensions");
     return false;
@@ -255,7 +257,7 @@ bool PngToFramebufferConverter::getDimensionsStatic(const std::string& imagePath
 
   if (rc != 0) {
     LOG_ERR("PNG", "Failed to open PNG for dimensions: %d", rc);
-    delete png;
+    HeapTags::destroy(png);
     return false;
   }
 
@@ -263,7 +265,7 @@ bool PngToFramebufferConverter::getDimensionsStatic(const std::string& imagePath
   out.height = png->getHeight();
 
   png->close();
-  delete png;
+  HeapTags::destroy(png);
   return true;
 }
 
@@ -278,7 +280,7 @@ bool PngToFramebufferConverter::decodeToFramebuffer(const std::string& imagePath
   }
 
   // Heap-allocate PNG decoder (~42 KB) - freed at end of function
-  PNG* png = new (std::nothrow) PNG();
+  PNG* png = HeapTags::create<PNG>(HeapTags::Tag::ImageDecode);
   if (!png) {
     LOG_ERR("PNG", "Failed to allocate PNG decoder");
     return false;
@@ -294,13 +296,13 @@ bool PngToFramebufferConverter::decodeToFramebuffer(const std::string& imagePath
                      pngDrawCallback);
   if (rc != PNG_SUCCESS) {
     LOG_ERR("PNG", "Failed to open PNG: %d", rc);
-    delete png;
+    HeapTags::destroy(png);
     return false;
   }
 
   if (!validateImageDimensions(png->getWidth(), png->getHeight(), "PNG")) {
     png->close();
-    delete png;
+    HeapTags::destroy(png);
     return false;
   }
 
@@ -336,7 +338,7 @@ bool PngToFramebufferConverter::decodeToFramebuffer(const std::string& imagePath
             requiredInternal, ctx.srcWidth, pixelType, PNG_MAX_BUFFERED_PIXELS);
     LOG_ERR("PNG", "Aborting decode to avoid PNGdec internal buffer overflow");
     png->close();
-    delete png;
+    HeapTags::destroy(png);
     return false;
   }
 
@@ -346,11 +348,11 @@ bool PngToFramebufferConverter::decodeToFramebuffer(const std::string& imagePath
 
   // Allocate grayscale line buffer on demand (~3.2 KB) - freed after decode
   const size_t grayBufSize = PNG_MAX_BUFFERED_PIXELS / 2;
-  ctx.grayLineBuffer = static_cast<uint8_t*>(malloc(grayBufSize));
+  ctx.grayLineBuffer = static_cast<uint8_t*>(HeapTags::alloc(HeapTags::Tag::ImageDecode, grayBufSize));
   if (!ctx.grayLineBuffer) {
     LOG_ERR("PNG", "Failed to allocate gray line buffer");
     png->close();
-    delete png;
+    HeapTags::destroy(png);
     return false;
   }
 
@@ -370,23 +372,30 @@ bool PngToFramebufferConverter::decodeToFramebuffer(const std::string& imagePath
       ctx.caching = false;
     }
   }
+  if (config.cacheOnly && !ctx.caching) {
+    // Nothing to produce; the image is decoded at render time instead
+    HeapTags::release(ctx.grayLineBuffer);
+    png->close();
+    HeapTags::destroy(png);
+    return false;
+  }
 
   unsigned long decodeStart = millis();
   rc = png->decode(&ctx, 0);
   unsigned long decodeTime = millis() - decodeStart;
 
-  free(ctx.grayLineBuffer);
+  HeapTags::release(ctx.grayLineBuffer);
   ctx.grayLineBuffer = nullptr;
 
   if (rc != PNG_SUCCESS) {
     LOG_ERR("PNG", "Decode failed: %d", rc);
     png->close();
-    delete png;
+    HeapTags::destroy(png);
     return false;
   }
 
   png->close();
-  delete png;
+  HeapTags::destroy(png);
   LOG_DBG("PNG", "PNG decoding complete - render time: %lu ms", decodeTime);
 
   // Write cache file if caching was enabled and buffer was allocated
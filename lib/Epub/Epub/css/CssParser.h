@@ -1,7 +1,9 @@
 #pragma once
 
 #include <HalStorage.h>
+#include <HeapTags.h>
 
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -104,8 +106,10 @@ class CssParser {
   bool loadFromCache();
 
  private:
-  // Storage: maps normalized selector -> style properties
-  std::unordered_map<std::string, CssStyle> rulesBySelector_;
+  // Storage: maps normalized selector -> style properties. Nodes and buckets are accounted under the CSS heap tag.
+  using RuleMap = std::unordered_map<std::string, CssStyle, std::hash<std::string>, std::equal_to<std::string>,
+                                     HeapTags::Allocator<std::pair<const std::string, CssStyle>, HeapTags::Tag::Css>>;
+  RuleMap rulesBySelector_;
 
   std::string cachePath;
 
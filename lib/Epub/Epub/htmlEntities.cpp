@@ -3,14 +3,16 @@
 
 #include "htmlEntities.h"
 
+#include <cstdint>
 #include <cstring>
+#include <type_traits>
 
 struct EntityPair {
   const char* key;
   const char* value;
 };
 
-// Sorted lexicographically by key to allow binary search.
+// Sorted lexicographically by key, which also rules out duplicate keys.
 static constexpr EntityPair ENTITY_LOOKUP[] = {
     {"&AElig;", "Æ"},    {"&Aacute;", "Á"},     {"&Acirc;", "Â"},      {"&Agrave;", "À"},   {"&Alpha;", "Α"},
     {"&Aring;", "Å"},    {"&Atilde;", "Ã"},     {"&Auml;", "Ä"},       {"&Beta;", "Β"},     {"&Ccedil;", "Ç"},
@@ -80,35 +82,145 @@ static constexpr bool isTableSorted() {
 }
 static_assert(isTableSorted(), "ENTITY_LOOKUP must be sorted lexicographically by key");
 
-// Lookup a single HTML entity and return its UTF-8 value.
-const char* lookupHtmlEntity(const char* entity, size_t len) {
-  if (entity == nullptr || len == 0) return nullptr;
+// Minimal perfect hash over the keys, built at compile time ("hash and displace"): the key's hash picks one of
+// ENTITY_BUCKET_COUNT buckets and, with that bucket's displacement, one of ENTITY_LOOKUP_COUNT slots. The
+// displacements are chosen bucket by bucket, largest first, so every key lands in a slot of its own. If a new table
+// cannot be placed, the static_assert below fires: change ENTITY_HASH_SEED.
+static constexpr size_t ENTITY_BUCKET_COUNT = 64;
+static constexpr uint32_t ENTITY_HASH_SEED = 0;
+static_assert(ENTITY_LOOKUP_COUNT <= 256, "Slots hold uint8_t table indices");
+static_assert(ENTITY_LOOKUP_COUNT * ENTITY_LOOKUP_COUNT <= 65536, "Displacements are uint16_t");
+
+// FNV-1a, then the murmur3 finaliser so that all bits depend on every byte
+static constexpr uint32_t entityHash(const char* key, const size_t len) {
+  uint32_t h = 2166136261u ^ ENTITY_HASH_SEED;
+  for (size_t i = 0; i < len; i++) {
+    h = (h ^ static_cast<uint8_t>(key[i])) * 16777619u;
+  }
+  h ^= h >> 16;
+  h *= 0x85EBCA6Bu;
+  h ^= h >> 13;
+  h *= 0xC2B2AE35u;
+  h ^= h >> 16;
+  return h;
+}
+
+static constexpr size_t entityBucket(const uint32_t hash) { return hash % ENTITY_BUCKET_COUNT; }
+
+// Displacement d moves the key's first choice of slot by d % COUNT, and by d / COUNT times a step that also comes
+// from the hash, so keys sharing a bucket spread out differently
+static constexpr size_t entitySlot(const uint32_t hash, const uint16_t displacement) {
+  constexpr size_t COUNT = ENTITY_LOOKUP_COUNT;
+  const size_t first = (hash >> 7) % COUNT;
+  const size_t step = (hash >> 19) % (COUNT - 1) + 1;
+  return (first + displacement / COUNT * step + displacement % COUNT) % COUNT;
+}
+
+static constexpr size_t constexprStrlen(const char* s) {
+  size_t len = 0;
+  while (s[len] != '\0') len++;
+  return len;
+}
+
+struct EntityHashTable {
+  bool complete = false;
+  uint16_t displacement[ENTITY_BUCKET_COUNT] = {};
+  uint8_t entry[ENTITY_LOOKUP_COUNT] = {};      // ENTITY_LOOKUP index in each slot
+  uint8_t keyLength[ENTITY_LOOKUP_COUNT] = {};  // By ENTITY_LOOKUP index
+};
+
+static constexpr EntityHashTable buildEntityHashTable() {
+  EntityHashTable table;
+  uint32_t hashes[ENTITY_LOOKUP_COUNT] = {};
+  size_t bucketSize[ENTITY_BUCKET_COUNT] = {};
+  for (size_t i = 0; i < ENTITY_LOOKUP_COUNT; i++) {
+    table.keyLength[i] = static_cast<uint8_t>(constexprStrlen(ENTITY_LOOKUP[i].key));
+    hashes[i] = entityHash(ENTITY_LOOKUP[i].key, table.keyLength[i]);
+    bucketSize[entityBucket(hashes[i])]++;
+  }
+
+  bool slotUsed[ENTITY_LOOKUP_COUNT] = {};
+  bool bucketDone[ENTITY_BUCKET_COUNT] = {};
+  for (size_t placed = 0; placed < ENTITY_BUCKET_COUNT; placed++) {
+    size_t bucket = 0;
+    for (size_t b = 0; b < ENTITY_BUCKET_COUNT; b++) {
+      if (!bucketDone[b] && (bucketDone[bucket] || bucketSize[b] > bucketSize[bucket])) bucket = b;
+    }
+    bucketDone[bucket] = true;
 
-  size_t lo = 0;
-  size_t hi = ENTITY_LOOKUP_COUNT;
-
-  while (lo < hi) {
-    const size_t mid = lo + (hi - lo) / 2;
-    const char* key = ENTITY_LOOKUP[mid].key;
-    const size_t keyLen = strlen(key);
-    const size_t cmpLen = (len < keyLen) ? len : keyLen;
-    int cmp = memcmp(entity, key, cmpLen);
-    if (cmp == 0) {
-      // safety net: if prefix equal, shorter string is considered smaller
-      if (len < keyLen)
-        cmp = -1;
-      else if (len > keyLen)
-        cmp = 1;
-      else
-        cmp = 0;
+    size_t members[ENTITY_LOOKUP_COUNT] = {};
+    size_t memberCount = 0;
+    for (size_t i = 0; i < ENTITY_LOOKUP_COUNT; i++) {
+      if (entityBucket(hashes[i]) == bucket) members[memberCount++] = i;
     }
+    if (memberCount == 0) continue;
 
-    if (cmp == 0) return ENTITY_LOOKUP[mid].value;
-    if (cmp < 0)
-      hi = mid;
-    else
-      lo = mid + 1;
+    bool found = false;
+    for (uint32_t d = 0; !found && d < ENTITY_LOOKUP_COUNT * ENTITY_LOOKUP_COUNT; d++) {
+      const auto displacement = static_cast<uint16_t>(d);
+      found = true;
+      for (size_t m = 0; found && m < memberCount; m++) {
+        const size_t slot = entitySlot(hashes[members[m]], displacement);
+        found = !slotUsed[slot];
+        for (size_t other = 0; found && other < m; other++) {
+          found = entitySlot(hashes[members[other]], displacement) != slot;
+        }
+      }
+      if (found) {
+        table.displacement[bucket] = displacement;
+        for (size_t m = 0; m < memberCount; m++) {
+          const size_t slot = entitySlot(hashes[members[m]], displacement);
+          slotUsed[slot] = true;
+          table.entry[slot] = static_cast<uint8_t>(members[m]);
+        }
+      }
+    }
+    if (!found) return table;
   }
+  table.complete = true;
+  return table;
+}
+
+static constexpr EntityHashTable ENTITY_HASH_TABLE = buildEntityHashTable();
 
-  return nullptr;
+static constexpr const EntityPair* hashLookup(const char* entity, const size_t len) {
+  const uint32_t hash = entityHash(entity, len);
+  const size_t index = ENTITY_HASH_TABLE.entry[entitySlot(hash, ENTITY_HASH_TABLE.displacement[entityBucket(hash)])];
+  if (ENTITY_HASH_TABLE.keyLength[index] != len) return nullptr;
+  if (std::is_constant_evaluated()) {
+    return constexprStrcmp(ENTITY_LOOKUP[index].key, entity) == 0 ? &ENTITY_LOOKUP[index] : nullptr;
+  }
+  return memcmp(ENTITY_LOOKUP[index].key, entity, len) == 0 ? &ENTITY_LOOKUP[index] : nullptr;
+}
+
+// Verify at compile time that every key was placed and is found again.
+static constexpr bool isHashComplete() {
+  if (!ENTITY_HASH_TABLE.complete) return false;
+  for (size_t i = 0; i < ENTITY_LOOKUP_COUNT; i++) {
+    if (hashLookup(ENTITY_LOOKUP[i].key, ENTITY_HASH_TABLE.keyLength[i]) != &ENTITY_LOOKUP[i]) return false;
+  }
+  return true;
+}
+static_assert(isHashComplete(), "ENTITY_LOOKUP does not hash perfectly, change ENTITY_HASH_SEED");
+
+// The fast path in htmlEntities.h must agree with the table.
+static constexpr bool isCommonTableConsistent() {
+  for (const CommonHtmlEntity& common : COMMON_HTML_ENTITIES) {
+    char key[HTML_ENTITY_COMMON_NAME_MAX + 3] = {'&'};
+    const size_t nameLen = common.nameLength;
+    if (nameLen > HTML_ENTITY_COMMON_NAME_MAX) return false;
+    for (size_t i = 0; i < nameLen; i++) key[i + 1] = common.name[i];
+    key[nameLen + 1] = ';';
+    const EntityPair* pair = hashLookup(key, nameLen + 2);
+    if (pair == nullptr || constexprStrcmp(pair->value, common.value) != 0) return false;
+  }
+  return true;
+}
+static_assert(isCommonTableConsistent(), "COMMON_HTML_ENTITIES must match ENTITY_LOOKUP");
+
+// Lookup a single HTML entity and return its UTF-8 value.
+const char* lookupHtmlEntity(const char* entity, size_t len) {
+  if (entity == nullptr || len == 0) return nullptr;
+  const EntityPair* pair = hashLookup(entity, len);
+  return pair != nullptr ? pair->value : nullptr;
 }
@@ -2,8 +2,52 @@
 // https://github.com/atomic14/diy-esp32-epub-reader/blob/2c2f57fdd7e2a788d14a0bcb26b9e845a47aac42/lib/Epub/RubbishHtmlParser/htmlEntities.cpp
 
 #pragma once
+#include <cstdint>
 #include <string>
 
 // Lookup a single HTML entity (including & and ;) and return its UTF-8 value
 // Returns nullptr if entity is not found
 const char* lookupHtmlEntity(const char* entity, size_t len);
+
+// Fast path for the entities nearly every book uses, tried before lookupHtmlEntity(): the name between '&' and ';'
+// is packed into an integer and compared with a dozen constants, without hashing. (&amp;, &lt;, &gt;, &quot; and
+// &apos; never get here, expat expands them itself.)
+constexpr size_t HTML_ENTITY_COMMON_NAME_MAX = 8;
+
+constexpr uint64_t packHtmlEntityName(const char* name, const size_t len) {
+  uint64_t packed = 0;
+  for (size_t i = 0; i < len; i++) {
+    packed |= static_cast<uint64_t>(static_cast<uint8_t>(name[i])) << (8 * i);
+  }
+  return packed;
+}
+
+struct CommonHtmlEntity {
+  const char* name;  // Without & and ;
+  const char* value;
+  uint8_t nameLength;
+  uint64_t packedName;
+
+  constexpr CommonHtmlEntity(const char* name, const char* value)
+      : name(name),
+        value(value),
+        nameLength(static_cast<uint8_t>(std::char_traits<char>::length(name))),
+        packedName(packHtmlEntityName(name, nameLength)) {}
+};
+
+// Most frequent first. Checked against the full table at compile time (htmlEntities.cpp)
+inline constexpr CommonHtmlEntity COMMON_HTML_ENTITIES[] = {
+    {"nbsp", "\xC2\xA0"}, {"rsquo", "\u2019"}, {"mdash", "—"},       {"ldquo", "\u201C"}, {"rdquo", "\u201D"},
+    {"lsquo", "\u2018"}, {"hellip", "…"},      {"ndash", "–"},       {"shy", "\xC2\xAD"},    {"thinsp", " "},
+    {"eacute", "é"},      {"copy", "©"},
+};
+
+// entity: as for lookupHtmlEntity(), already known to start with & and end with ;
+inline const char* lookupCommonHtmlEntity(const char* entity, const size_t len) {
+  if (len < 3 || len > HTML_ENTITY_COMMON_NAME_MAX + 2) return nullptr;
+  const uint64_t name = packHtmlEntityName(entity + 1, len - 2);
+  for (const CommonHtmlEntity& common : COMMON_HTML_ENTITIES) {
+    if (common.packedName == name && common.nameLength == len - 2) return common.value;
+  }
+  return nullptr;
+}
@@ -0,0 +1,97 @@
+#include "HyphenationCache.h"
+
+#include <HeapTags.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace {
+HyphenationCache* activeCache = nullptr;
+
+constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL;
+constexpr uint64_t FNV_PRIME = 0x100000001b3ULL;
+constexpr size_t MAX_WORD_BYTES = 255;
+}  // namespace
+
+HyphenationCache::HyphenationCache() {
+  assert(activeCache == nullptr);
+  activeCache = this;
+}
+
+HyphenationCache::~HyphenationCache() {
+  if (activeCache == this) {
+    activeCache = nullptr;
+  }
+  HeapTags::release(entries);
+}
+
+HyphenationCache* HyphenationCache::active() { return activeCache; }
+
+uint64_t HyphenationCache::keyFor(const std::string& word, const bool includeFallback, const void* language) {
+  uint64_t hash = FNV_OFFSET;
+  for (const char c : word) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * FNV_PRIME;
+  }
+  // The same word breaks differently per language and with fallback breaks
+  hash = (hash ^ static_cast<uint64_t>(reinterpret_cast<uintptr_t>(language))) * FNV_PRIME;
+  hash = (hash ^ (includeFallback ? 1 : 2)) * FNV_PRIME;
+  return hash != 0 ? hash : 1;
+}
+
+bool HyphenationCache::lookup(const uint64_t key, Hyphenator::BreakInfo* out, const size_t capacity, size_t& count) {
+  stats.lookups++;
+  if (!entries) {
+    return false;
+  }
+  Entry* set = entries + (key % SETS) * WAYS;
+  for (size_t way = 0; way < WAYS; way++) {
+    const Entry& entry = set[way];
+    if (entry.key != key) {
+      continue;
+    }
+    count = std::min<size_t>(entry.count, capacity);
+    for (size_t i = 0; i < count; i++) {
+      out[i] = {entry.offsets[i], ((entry.hyphenMask >> i) & 1) != 0};
+    }
+    if (way != 0) {
+      // Keep the most recently used entry first so the other one is evicted next
+      std::swap(set[0], set[way]);
+    }
+    stats.hits++;
+    return true;
+  }
+  return false;
+}
+
+void HyphenationCache::store(const uint64_t key, const std::string& word, const Hyphenator::BreakInfo* breaks,
+                             const size_t count) {
+  if (word.size() > MAX_WORD_BYTES || count > MAX_BREAKS) {
+    stats.uncacheable++;
+    return;
+  }
+  if (!entries) {
+    if (allocationFailed) {
+      return;
+    }
+    entries = static_cast<Entry*>(HeapTags::allocZeroed(HeapTags::Tag::Hyphenation, SETS * WAYS, sizeof(Entry)));
+    if (!entries) {
+      // Layout still works, just without memoization
+      allocationFailed = true;
+      return;
+    }
+  }
+
+  Entry* set = entries + (key % SETS) * WAYS;
+  memmove(set + 1, set, (WAYS - 1) * sizeof(Entry));
+  Entry& entry = set[0];
+  entry.key = key;
+  entry.hyphenMask = 0;
+  entry.count = static_cast<uint8_t>(count);
+  for (size_t i = 0; i < count; i++) {
+    entry.offsets[i] = static_cast<uint8_t>(breaks[i].byteOffset);
+    if (breaks[i].requiresInsertedHyphen) {
+      entry.hyphenMask |= static_cast<uint16_t>(1u << i);
+    }
+  }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Hyphenator.h"
+
+/**
+ * Memoizes Hyphenator::breakOffsets() while one section is laid out.
+ *
+ * Long words recur throughout a chapter, and in justified German or Russian text most of them reach a line end and are
+ * hyphenated again each time. Entries map a 64-bit hash of (word, fallback flag, language) to the packed break
+ * offsets, in a fixed two-way set-associative table that is allocated on the first store and never grows; a new entry
+ * evicts the older of its set. Words longer than 255 bytes or with more than MAX_BREAKS breaks are not cached.
+ *
+ * Hyphenator::breakOffsets() uses the cache that is alive, if any; only one can be alive at a time.
+ */
+class HyphenationCache {
+ public:
+  static constexpr size_t SETS = 128;
+  static constexpr size_t WAYS = 2;
+  static constexpr size_t MAX_BREAKS = 13;
+
+  struct Stats {
+    uint32_t lookups = 0;
+    uint32_t hits = 0;
+    uint32_t uncacheable = 0;  // Results too large to store
+  };
+
+  HyphenationCache();
+  ~HyphenationCache();
+  HyphenationCache(const HyphenationCache&) = delete;
+  HyphenationCache& operator=(const HyphenationCache&) = delete;
+
+  // The cache breakOffsets() goes through, or nullptr
+  static HyphenationCache* active();
+
+  static uint64_t keyFor(const std::string& word, bool includeFallback, const void* language);
+
+  // On a hit, copies up to `capacity` breaks into `out` and sets `count`
+  bool lookup(uint64_t key, Hyphenator::BreakInfo* out, size_t capacity, size_t& count);
+  void store(uint64_t key, const std::string& word, const Hyphenator::BreakInfo* breaks, size_t count);
+
+  const Stats& getStats() const { return stats; }
+
+ private:
+  struct Entry {
+    uint64_t key;                 // 0 = empty
+    uint16_t hyphenMask;          // Bit i: break i requires an inserted hyphen
+    uint8_t count;                // Breaks stored
+    uint8_t offsets[MAX_BREAKS];  // Byte offsets into the word
+  };
+  static_assert(sizeof(Entry) == 24, "Entries are packed into 24 bytes");
+
+  Entry* entries = nullptr;  // SETS * WAYS, allocated on the first store
+  bool allocationFailed = false;
+  Stats stats;
+};
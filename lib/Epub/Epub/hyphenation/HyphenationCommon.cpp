@@ -149,14 +149,10 @@ bool isExplicitHyphen(const uint32_t cp) {
 
 bool isSoftHyphen(const uint32_t cp) { return cp == 0x00AD; }
 
-void trimSurroundingPunctuationAndFootnote(std::vector<CodepointInfo>& cps) {
-  if (cps.empty()) {
-    return;
-  }
-
+size_t trimSurroundingPunctuationAndFootnote(const CodepointInfo* cps, size_t& count) {
   // Remove trailing footnote references like [12], even if punctuation trails after the closing bracket.
-  if (cps.size() >= 3) {
-    int end = static_cast<int>(cps.size()) - 1;
+  if (count >= 3) {
+    int end = static_cast<int>(count) - 1;
     while (end >= 0 && isPunctuation(cps[end].value)) {
       --end;
     }
@@ -166,23 +162,231 @@ void trimSurroundingPunctuationAndFootnote(std::vector<CodepointInfo>& cps) {
         --pos;
       }
       if (pos >= 0 && cps[pos].value == '[' && end - pos > 1) {
-        cps.erase(cps.begin() + pos, cps.end());
+        count = static_cast<size_t>(pos);
       }
     }
   }
 
-  while (!cps.empty() && isPunctuation(cps.front().value)) {
-    cps.erase(cps.begin());
+  size_t first = 0;
+  while (first < count && isPunctuation(cps[first].value)) {
+    ++first;
   }
-  while (!cps.empty() && isPunctuation(cps.back().value)) {
-    cps.pop_back();
+  while (count > first && isPunctuation(cps[count - 1].value)) {
+    --count;
   }
+  count -= first;
+  return first;
 }
 
-std::vector<CodepointInfo> collectCodepoints(const std::string& word) {
-  std::vector<CodepointInfo> cps;
-  cps.reserve(word.size());
+void trimSurroundingPunctuationAndFootnote(std::vector<CodepointInfo>& cps) {
+  size_t count = cps.size();
+  const size_t first = trimSurroundingPunctuationAndFootnote(cps.data(), count);
+  cps.resize(first + count);
+  cps.erase(cps.begin(), cps.begin() + static_cast<std::ptrdiff_t>(first));
+}
 
+namespace {
+
+// Precomposed form of `prev` followed by the combining `mark`, or 0 if there is none.
+uint32_t composeWithMark(const uint32_t prev, const uint32_t mark) {
+  uint32_t composed = 0;
+  switch (mark) {
+    case 0x0300:  // grave
+      switch (prev) {
+        case 0x0041:
+          composed = 0x00C0;
+          break;  // A -> À
+        case 0x0061:
+          composed = 0x00E0;
+          break;  // a -> à
+        case 0x0045:
+          composed = 0x00C8;
+          break;  // E -> È
+        case 0x0065:
+          composed = 0x00E8;
+          break;  // e -> è
+        case 0x0049:
+          composed = 0x00CC;
+          break;  // I -> Ì
+        case 0x0069:
+          composed = 0x00EC;
+          break;  // i -> ì
+        case 0x004F:
+          composed = 0x00D2;
+          break;  // O -> Ò
+        case 0x006F:
+          composed = 0x00F2;
+          break;  // o -> ò
+        case 0x0055:
+          composed = 0x00D9;
+          break;  // U -> Ù
+        case 0x0075:
+          composed = 0x00F9;
+          break;  // u -> ù
+        default:
+          break;
+      }
+      break;
+    case 0x0301:  // acute
+      switch (prev) {
+        case 0x0041:
+          composed = 0x00C1;
+          break;  // A -> Á
+        case 0x0061:
+          composed = 0x00E1;
+          break;  // a -> á
+        case 0x0045:
+          composed = 0x00C9;
+          break;  // E -> É
+        case 0x0065:
+          composed = 0x00E9;
+          break;  // e -> é
+        case 0x0049:
+          composed = 0x00CD;
+          break;  // I -> Í
+        case 0x0069:
+          composed = 0x00ED;
+          break;  // i -> í
+        case 0x004F:
+          composed = 0x00D3;
+          break;  // O -> Ó
+        case 0x006F:
+          composed = 0x00F3;
+          break;  // o -> ó
+        case 0x0055:
+          composed = 0x00DA;
+          break;  // U -> Ú
+        case 0x0075:
+          composed = 0x00FA;
+          break;  // u -> ú
+        case 0x0059:
+          composed = 0x00DD;
+          break;  // Y -> Ý
+        case 0x0079:
+          composed = 0x00FD;
+          break;  // y -> ý
+        default:
+          break;
+      }
+      break;
+    case 0x0302:  // circumflex
+      switch (prev) {
+        case 0x0041:
+          composed = 0x00C2;
+          break;  // A -> Â
+        case 0x0061:
+          composed = 0x00E2;
+          break;  // a -> â
+        case 0x0045:
+          composed = 0x00CA;
+          break;  // E -> Ê
+        case 0x0065:
+          composed = 0x00EA;
+          break;  // e -> ê
+        case 0x0049:
+          composed = 0x00CE;
+          break;  // I -> Î
+        case 0x0069:
+          composed = 0x00EE;
+          break;  // i -> î
+        case 0x004F:
+          composed = 0x00D4;
+          break;  // O -> Ô
+        case 0x006F:
+          composed = 0x00F4;
+          break;  // o -> ô
+        case 0x0055:
+          composed = 0x00DB;
+          break;  // U -> Û
+        case 0x0075:
+          composed = 0x00FB;
+          break;  // u -> û
+        default:
+          break;
+      }
+      break;
+    case 0x0303:  // tilde
+      switch (prev) {
+        case 0x0041:
+          composed = 0x00C3;
+          break;  // A -> Ã
+        case 0x0061:
+          composed = 0x00E3;
+          break;  // a -> ã
+        case 0x004E:
+          composed = 0x00D1;
+          break;  // N -> Ñ
+        case 0x006E:
+          composed = 0x00F1;
+          break;  // n -> ñ
+        default:
+          break;
+      }
+      break;
+    case 0x0308:  // diaeresis/umlaut
+      switch (prev) {
+        case 0x0041:
+          composed = 0x00C4;
+          break;  // A -> Ä
+        case 0x0061:
+          composed = 0x00E4;
+          break;  // a -> ä
+        case 0x0045:
+          composed = 0x00CB;
+          break;  // E -> Ë
+        case 0x0065:
+          composed = 0x00EB;
+          break;  // e -> ë
+        case 0x0049:
+          composed = 0x00CF;
+          break;  // I -> Ï
+        case 0x0069:
+          composed = 0x00EF;
+          break;  // i -> ï
+        case 0x004F:
+          composed = 0x00D6;
+          break;  // O -> Ö
+        case 0x006F:
+          composed = 0x00F6;
+          break;  // o -> ö
+        case 0x0055:
+          composed = 0x00DC;
+          break;  // U -> Ü
+        case 0x0075:
+          composed = 0x00FC;
+          break;  // u -> ü
+        case 0x0059:
+          composed = 0x0178;
+          break;  // Y -> Ÿ
+        case 0x0079:
+          composed = 0x00FF;
+          break;  // y -> ÿ
+        default:
+          break;
+      }
+      break;
+    case 0x0327:  // cedilla
+      switch (prev) {
+        case 0x0043:
+          composed = 0x00C7;
+          break;  // C -> Ç
+        case 0x0063:
+          composed = 0x00E7;
+          break;  // c -> ç
+        default:
+          break;
+      }
+      break;
+    default:
+      break;
+  }
+  return composed;
+}
+
+}  // namespace
+
+bool collectCodepoints(const std::string& word, CodepointInfo* out, const size_t capacity, size_t& count) {
+  count = 0;
   const unsigned char* base = reinterpret_cast<const unsigned char*>(word.c_str());
   const unsigned char* ptr = base;
   while (*ptr != 0) {
@@ -195,208 +399,28 @@ std::vector<CodepointInfo> collectCodepoints(const std::string& word) {
     // common Western European diacritics (acute, grave, circumflex, tilde,
     // diaeresis, cedilla) without pulling in a full Unicode normalization
     // library.
-    if (!cps.empty()) {
-      uint32_t prev = cps.back().value;
-      uint32_t composed = 0;
-      switch (cp) {
-        case 0x0300:  // grave
-          switch (prev) {
-            case 0x0041:
-              composed = 0x00C0;
-              break;  // A -> À
-            case 0x0061:
-              composed = 0x00E0;
-              break;  // a -> à
-            case 0x0045:
-              composed = 0x00C8;
-              break;  // E -> È
-            case 0x0065:
-              composed = 0x00E8;
-              break;  // e -> è
-            case 0x0049:
-              composed = 0x00CC;
-              break;  // I -> Ì
-            case 0x0069:
-              composed = 0x00EC;
-              break;  // i -> ì
-            case 0x004F:
-              composed = 0x00D2;
-              break;  // O -> Ò
-            case 0x006F:
-              composed = 0x00F2;
-              break;  // o -> ò
-            case 0x0055:
-              composed = 0x00D9;
-              break;  // U -> Ù
-            case 0x0075:
-              composed = 0x00F9;
-              break;  // u -> ù
-            default:
-              break;
-          }
-          break;
-        case 0x0301:  // acute
-          switch (prev) {
-            case 0x0041:
-              composed = 0x00C1;
-              break;  // A -> Á
-            case 0x0061:
-              composed = 0x00E1;
-              break;  // a -> á
-            case 0x0045:
-              composed = 0x00C9;
-              break;  // E -> É
-            case 0x0065:
-              composed = 0x00E9;
-              break;  // e -> é
-            case 0x0049:
-              composed = 0x00CD;
-              break;  // I -> Í
-            case 0x0069:
-              composed = 0x00ED;
-              break;  // i -> í
-            case 0x004F:
-              composed = 0x00D3;
-              break;  // O -> Ó
-            case 0x006F:
-              composed = 0x00F3;
-              break;  // o -> ó
-            case 0x0055:
-              composed = 0x00DA;
-              break;  // U -> Ú
-            case 0x0075:
-              composed = 0x00FA;
-              break;  // u -> ú
-            case 0x0059:
-              composed = 0x00DD;
-              break;  // Y -> Ý
-            case 0x0079:
-              composed = 0x00FD;
-              break;  // y -> ý
-            default:
-              break;
-          }
-          break;
-        case 0x0302:  // circumflex
-          switch (prev) {
-            case 0x0041:
-              composed = 0x00C2;
-              break;  // A -> Â
-            case 0x0061:
-              composed = 0x00E2;
-              break;  // a -> â
-            case 0x0045:
-              composed = 0x00CA;
-              break;  // E -> Ê
-            case 0x0065:
-              composed = 0x00EA;
-              break;  // e -> ê
-            case 0x0049:
-              composed = 0x00CE;
-              break;  // I -> Î
-            case 0x0069:
-              composed = 0x00EE;
-              break;  // i -> î
-            case 0x004F:
-              composed = 0x00D4;
-              break;  // O -> Ô
-            case 0x006F:
-              composed = 0x00F4;
-              break;  // o -> ô
-            case 0x0055:
-              composed = 0x00DB;
-              break;  // U -> Û
-            case 0x0075:
-              composed = 0x00FB;
-              break;  // u -> û
-            default:
-              break;
-          }
-          break;
-        case 0x0303:  // tilde
-          switch (prev) {
-            case 0x0041:
-              composed = 0x00C3;
-              break;  // A -> Ã
-            case 0x0061:
-              composed = 0x00E3;
-              break;  // a -> ã
-            case 0x004E:
-              composed = 0x00D1;
-              break;  // N -> Ñ
-            case 0x006E:
-              composed = 0x00F1;
-              break;  // n -> ñ
-            default:
-              break;
-          }
-          break;
-        case 0x0308:  // diaeresis/umlaut
-          switch (prev) {
-            case 0x0041:
-              composed = 0x00C4;
-              break;  // A -> Ä
-            case 0x0061:
-              composed = 0x00E4;
-              break;  // a -> ä
-            case 0x0045:
-              composed = 0x00CB;
-              break;  // E -> Ë
-            case 0x0065:
-              composed = 0x00EB;
-              break;  // e -> ë
-            case 0x0049:
-              composed = 0x00CF;
-              break;  // I -> Ï
-            case 0x0069:
-              composed = 0x00EF;
-              break;  // i -> ï
-            case 0x004F:
-              composed = 0x00D6;
-              break;  // O -> Ö
-            case 0x006F:
-              composed = 0x00F6;
-              break;  // o -> ö
-            case 0x0055:
-              composed = 0x00DC;
-              break;  // U -> Ü
-            case 0x0075:
-              composed = 0x00FC;
-              break;  // u -> ü
-            case 0x0059:
-              composed = 0x0178;
-              break;  // Y -> Ÿ
-            case 0x0079:
-              composed = 0x00FF;
-              break;  // y -> ÿ
-            default:
-              break;
-          }
-          break;
-        case 0x0327:  // cedilla
-          switch (prev) {
-            case 0x0043:
-              composed = 0x00C7;
-              break;  // C -> Ç
-            case 0x0063:
-              composed = 0x00E7;
-              break;  // c -> ç
-            default:
-              break;
-          }
-          break;
-        default:
-          break;
-      }
-
+    if (count > 0) {
+      const uint32_t composed = composeWithMark(out[count - 1].value, cp);
       if (composed != 0) {
-        cps.back().value = composed;
+        out[count - 1].value = composed;
         continue;  // skip pushing the combining mark itself
       }
     }
 
-    cps.push_back({cp, static_cast<size_t>(current - base)});
+    if (count == capacity) {
+      return false;
+    }
+    out[count++] = {cp, static_cast<size_t>(current - base)};
   }
 
+  return true;
+}
+
+std::vector<CodepointInfo> collectCodepoints(const std::string& word) {
+  // A word never has more codepoints than bytes
+  std::vector<CodepointInfo> cps(word.size());
+  size_t count = 0;
+  collectCodepoints(word, cps.data(), cps.size(), count);
+  cps.resize(count);
   return cps;
 }
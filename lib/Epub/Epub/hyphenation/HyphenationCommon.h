@@ -24,3 +24,8 @@ bool isExplicitHyphen(uint32_t cp);
 bool isSoftHyphen(uint32_t cp);
 void trimSurroundingPunctuationAndFootnote(std::vector<CodepointInfo>& cps);
 std::vector<CodepointInfo> collectCodepoints(const std::string& word);
+
+// Allocation-free forms of the two above. The trim narrows `count` and returns how many codepoints to skip at the
+// front; collection fails once the word exceeds `capacity` codepoints.
+size_t trimSurroundingPunctuationAndFootnote(const CodepointInfo* cps, size_t& count);
+bool collectCodepoints(const std::string& word, CodepointInfo* out, size_t capacity, size_t& count);
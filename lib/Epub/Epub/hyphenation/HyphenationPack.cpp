@@ -0,0 +1,52 @@
+#include "HyphenationPack.h"
+
+#include <cstring>
+
+namespace HyphenationPack {
+
+namespace {
+
+constexpr uint8_t MAGIC[4] = {'H', 'Y', 'P', 'K'};
+constexpr uint8_t VERSION = 1;
+constexpr size_t TABLE_SIZE = 256;
+
+uint32_t readLe32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+}  // namespace
+
+bool parse(const uint8_t* image, const size_t size, SerializedHyphenationPatterns& patterns) {
+  // Header: magic, version, dispatch table count, reserved u16, root offset, trie size (little-endian)
+  if (!image || size < HEADER_SIZE || memcmp(image, MAGIC, sizeof(MAGIC)) != 0 || image[4] != VERSION) {
+    return false;
+  }
+  const size_t tables = image[5];
+  const size_t rootOffset = readLe32(image + 8);
+  const size_t trieSize = readLe32(image + 12);
+  if (tables == 0 || rootOffset >= trieSize || trieSize > size - HEADER_SIZE) {
+    return false;
+  }
+
+  // Trie, then the dispatch slots, then the tables; anything shorter or longer is a damaged copy
+  const uint8_t* trie = image + HEADER_SIZE;
+  const uint8_t* slots = trie + trieSize;
+  if (size - HEADER_SIZE - trieSize != TABLE_SIZE * (tables + 1)) {
+    return false;
+  }
+  for (size_t i = 0; i < TABLE_SIZE; i++) {
+    if (slots[i] >= tables) {
+      return false;
+    }
+  }
+
+  patterns.rootOffset = rootOffset;
+  patterns.data = trie;
+  patterns.size = trieSize;
+  patterns.dispatch = slots + TABLE_SIZE;
+  patterns.dispatchSlots = slots;
+  return true;
+}
+
+}  // namespace HyphenationPack
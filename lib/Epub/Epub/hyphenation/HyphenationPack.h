@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "SerializedHyphenationTrie.h"
+
+/**
+ * Hyphenation pattern packs: the serialized trie and dispatch tables of a generated hyph-<tag>.trie.h header as one
+ * file, so languages other than English can live on the SD card instead of in the firmware image. The layout is
+ * documented in docs/hyphenation-trie-format.md; generate_hyphenation_trie.py --pack writes them.
+ *
+ * Packs are used in place. The device copies the pack of the book's language into a flash partition and maps it into
+ * the address space (HyphenationPackStore), so the pattern walk reads it exactly like a built-in trie.
+ */
+namespace HyphenationPack {
+
+constexpr size_t HEADER_SIZE = 16;
+
+// Validates a pack image and points `patterns` at the trie and dispatch tables inside it; they stay valid as long as
+// the image does. Returns false, leaving `patterns` untouched, for anything but a complete pack of a known version.
+bool parse(const uint8_t* image, size_t size, SerializedHyphenationPatterns& patterns);
+
+}  // namespace HyphenationPack
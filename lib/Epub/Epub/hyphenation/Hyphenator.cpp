@@ -1,9 +1,12 @@
 #include "Hyphenator.h"
 
+#include <Utf8.h>
+
 #include <algorithm>
 #include <cassert>
 #include <vector>
 
+#include "HyphenationCache.h"
 #include "HyphenationCommon.h"
 #include "LanguageHyphenator.h"
 #include "LanguageRegistry.h"
@@ -50,68 +53,80 @@ const LanguageHyphenator* hyphenatorForLanguage(const std::string& langTag) {
   return getLanguageHyphenatorForPrimaryTag(primary);
 }
 
+// Fixed-capacity destination for break points; breaks past the capacity are dropped.
+struct BreakList {
+  Hyphenator::BreakInfo* data;
+  size_t capacity;
+  size_t size = 0;
+
+  void push(const size_t byteOffset, const bool requiresInsertedHyphen) {
+    if (size < capacity) {
+      data[size++] = {byteOffset, requiresInsertedHyphen};
+    }
+  }
+};
+
 // Maps a codepoint index back to its byte offset inside the source word.
-size_t byteOffsetForIndex(const std::vector<CodepointInfo>& cps, const size_t index) {
-  return (index < cps.size()) ? cps[index].byteOffset : (cps.empty() ? 0 : cps.back().byteOffset);
+size_t byteOffsetForIndex(const CodepointInfo* cps, const size_t count, const size_t index) {
+  return (index < count) ? cps[index].byteOffset : (count == 0 ? 0 : cps[count - 1].byteOffset);
 }
 
-// Builds a vector of break information from explicit hyphen markers in the given codepoints.
+// Adds break information for explicit hyphen markers in the given codepoints.
 // Only hyphens that appear between two alphabetic characters are considered valid breaks.
 //
 // Example: "US-Satellitensystems" (cps: U, S, -, S, a, t, ...)
 //   -> finds '-' at index 2 with alphabetic neighbors 'S' and 'S'
-//   -> returns one BreakInfo at the byte offset of 'S' (the char after '-'),
+//   -> adds one BreakInfo at the byte offset of 'S' (the char after '-'),
 //      with requiresInsertedHyphen=false because '-' is already visible.
 //
 // Example: "Satel\u00ADliten" (soft-hyphen between 'l' and 'l')
-//   -> returns one BreakInfo with requiresInsertedHyphen=true (soft-hyphen
+//   -> adds one BreakInfo with requiresInsertedHyphen=true (soft-hyphen
 //      is invisible and needs a visible '-' when the break is used).
-std::vector<Hyphenator::BreakInfo> buildExplicitBreakInfos(const std::vector<CodepointInfo>& cps) {
-  std::vector<Hyphenator::BreakInfo> breaks;
-
-  for (size_t i = 1; i + 1 < cps.size(); ++i) {
+void appendExplicitBreakInfos(const CodepointInfo* cps, const size_t count, BreakList& outBreaks) {
+  for (size_t i = 1; i + 1 < count; ++i) {
     const uint32_t cp = cps[i].value;
     if (!isExplicitHyphen(cp) || !isAlphabetic(cps[i - 1].value) || !isAlphabetic(cps[i + 1].value)) {
       continue;
     }
     // Offset points to the next codepoint so rendering starts after the hyphen marker.
-    breaks.push_back({cps[i + 1].byteOffset, isSoftHyphen(cp)});
+    outBreaks.push(cps[i + 1].byteOffset, isSoftHyphen(cp));
   }
-
-  return breaks;
 }
 
 bool isSegmentSeparator(const uint32_t cp) { return isExplicitHyphen(cp) || isApostrophe(cp); }
 
-void appendSegmentPatternBreaks(const std::vector<CodepointInfo>& cps, const LanguageHyphenator& hyphenator,
-                                const bool includeFallback, std::vector<Hyphenator::BreakInfo>& outBreaks) {
+void appendSegmentPatternBreaks(const CodepointInfo* cps, const size_t count, const LanguageHyphenator& hyphenator,
+                                const bool includeFallback, BreakList& outBreaks) {
   size_t segStart = 0;
 
-  for (size_t i = 0; i <= cps.size(); ++i) {
-    const bool atEnd = i == cps.size();
+  for (size_t i = 0; i <= count; ++i) {
+    const bool atEnd = i == count;
     const bool atSeparator = !atEnd && isSegmentSeparator(cps[i].value);
     if (!atEnd && !atSeparator) {
       continue;
     }
 
     if (i > segStart) {
-      std::vector<CodepointInfo> segment(cps.begin() + segStart, cps.begin() + i);
-      auto segIndexes = hyphenator.breakIndexes(segment);
+      const CodepointInfo* segment = cps + segStart;
+      const size_t segmentSize = i - segStart;
+      size_t segIndexes[Hyphenator::MAX_WORD_CODEPOINTS];
+      const size_t indexCount =
+          hyphenator.breakIndexes(segment, segmentSize, segIndexes, Hyphenator::MAX_WORD_CODEPOINTS);
+
+      for (size_t k = 0; k < indexCount; ++k) {
+        const size_t idx = segIndexes[k];
+        assert(idx > 0 && idx < segmentSize);
+        if (idx == 0 || idx >= segmentSize) continue;
+        outBreaks.push(segment[idx].byteOffset, true);
+      }
 
-      if (includeFallback && segIndexes.empty()) {
+      if (includeFallback && indexCount == 0) {
         const size_t minPrefix = hyphenator.minPrefix();
         const size_t minSuffix = hyphenator.minSuffix();
-        for (size_t idx = minPrefix; idx + minSuffix <= segment.size(); ++idx) {
-          segIndexes.push_back(idx);
-        }
-      }
-
-      for (const size_t idx : segIndexes) {
-        assert(idx > 0 && idx < segment.size());
-        if (idx == 0 || idx >= segment.size()) continue;
-        const size_t cpIdx = segStart + idx;
-        if (cpIdx < cps.size()) {
-          outBreaks.push_back({cps[cpIdx].byteOffset, true});
+        for (size_t idx = minPrefix; idx + minSuffix <= segmentSize; ++idx) {
+          if (idx > 0 && idx < segmentSize) {
+            outBreaks.push(segment[idx].byteOffset, true);
+          }
         }
       }
     }
@@ -120,15 +135,14 @@ void appendSegmentPatternBreaks(const std::vector<CodepointInfo>& cps, const Lan
   }
 }
 
-void appendApostropheContractionBreaks(const std::vector<CodepointInfo>& cps,
-                                       std::vector<Hyphenator::BreakInfo>& outBreaks) {
+void appendApostropheContractionBreaks(const CodepointInfo* cps, const size_t count, BreakList& outBreaks) {
   constexpr size_t kMinLeftSegmentLen = 3;
   constexpr size_t kMinRightSegmentLen = 3;
   size_t segmentStart = 0;
 
-  for (size_t i = 0; i < cps.size(); ++i) {
+  for (size_t i = 0; i < count; ++i) {
     if (isSegmentSeparator(cps[i].value)) {
-      if (isApostrophe(cps[i].value) && i > 0 && i + 1 < cps.size() && isAlphabetic(cps[i - 1].value) &&
+      if (isApostrophe(cps[i].value) && i > 0 && i + 1 < count && isAlphabetic(cps[i - 1].value) &&
           isAlphabetic(cps[i + 1].value)) {
         size_t leftPrefixLen = 0;
         for (size_t j = segmentStart; j < i; ++j) {
@@ -138,7 +152,7 @@ void appendApostropheContractionBreaks(const std::vector<CodepointInfo>& cps,
         }
 
         size_t rightSuffixLen = 0;
-        for (size_t j = i + 1; j < cps.size() && !isSegmentSeparator(cps[j].value); ++j) {
+        for (size_t j = i + 1; j < count && !isSegmentSeparator(cps[j].value); ++j) {
           if (isAlphabetic(cps[j].value)) {
             ++rightSuffixLen;
           }
@@ -146,7 +160,7 @@ void appendApostropheContractionBreaks(const std::vector<CodepointInfo>& cps,
 
         // Avoid stranding short clitics like "l'"/"d'" or contraction tails like "'ve"/"'re"/"'ll".
         if (leftPrefixLen >= kMinLeftSegmentLen && rightSuffixLen >= kMinRightSegmentLen) {
-          outBreaks.push_back({cps[i + 1].byteOffset, false});
+          outBreaks.push(cps[i + 1].byteOffset, false);
         }
       }
       segmentStart = i + 1;
@@ -154,45 +168,119 @@ void appendApostropheContractionBreaks(const std::vector<CodepointInfo>& cps,
   }
 }
 
-void sortAndDedupeBreakInfos(std::vector<Hyphenator::BreakInfo>& infos) {
-  std::sort(infos.begin(), infos.end(), [](const Hyphenator::BreakInfo& a, const Hyphenator::BreakInfo& b) {
+void sortAndDedupeBreakInfos(BreakList& infos) {
+  Hyphenator::BreakInfo* begin = infos.data;
+  Hyphenator::BreakInfo* end = infos.data + infos.size;
+  std::sort(begin, end, [](const Hyphenator::BreakInfo& a, const Hyphenator::BreakInfo& b) {
     if (a.byteOffset != b.byteOffset) {
       return a.byteOffset < b.byteOffset;
     }
     return a.requiresInsertedHyphen < b.requiresInsertedHyphen;
   });
 
-  infos.erase(std::unique(infos.begin(), infos.end(),
-                          [](const Hyphenator::BreakInfo& a, const Hyphenator::BreakInfo& b) {
-                            return a.byteOffset == b.byteOffset;
-                          }),
-              infos.end());
+  end = std::unique(begin, end, [](const Hyphenator::BreakInfo& a, const Hyphenator::BreakInfo& b) {
+    return a.byteOffset == b.byteOffset;
+  });
+  infos.size = static_cast<size_t>(end - begin);
+}
+
+// Words too long to hold as codepoints are also too long for every pattern table, so they only break after explicit
+// hyphens or, with fallback, at any character boundary. Both are found by streaming the UTF-8; combining marks stay
+// with their base character.
+void appendLongWordBreaks(const std::string& word, const bool includeFallback, const LanguageHyphenator* hyphenator,
+                          BreakList& outBreaks) {
+  const auto* base = reinterpret_cast<const unsigned char*>(word.c_str());
+  const unsigned char* ptr = base;
+  uint32_t prev = 0;
+  uint32_t cp = utf8NextCodepoint(&ptr);
+  size_t characters = 0;
+  while (cp != 0) {
+    const size_t nextOffset = static_cast<size_t>(ptr - base);
+    const uint32_t next = utf8NextCodepoint(&ptr);
+    if (!utf8IsCombiningMark(cp)) {
+      ++characters;
+    }
+    if (isExplicitHyphen(cp) && isAlphabetic(prev) && isAlphabetic(next)) {
+      outBreaks.push(nextOffset, isSoftHyphen(cp));
+    }
+    prev = cp;
+    cp = next;
+  }
+  if (outBreaks.size > 0 || !includeFallback) {
+    return;
+  }
+
+  const size_t minPrefix = hyphenator ? hyphenator->minPrefix() : LiangWordConfig::kDefaultMinPrefix;
+  const size_t minSuffix = hyphenator ? hyphenator->minSuffix() : LiangWordConfig::kDefaultMinSuffix;
+  ptr = base;
+  size_t index = 0;
+  while (*ptr != 0 && outBreaks.size < outBreaks.capacity) {
+    const size_t offset = static_cast<size_t>(ptr - base);
+    if (utf8IsCombiningMark(utf8NextCodepoint(&ptr))) {
+      continue;
+    }
+    if (index >= minPrefix && index + minSuffix <= characters) {
+      outBreaks.push(offset, true);
+    }
+    ++index;
+  }
 }
 
 }  // namespace
 
 std::vector<Hyphenator::BreakInfo> Hyphenator::breakOffsets(const std::string& word, const bool includeFallback) {
-  if (word.empty()) {
-    return {};
+  BreakInfo breaks[MAX_WORD_CODEPOINTS];
+  const size_t count = breakOffsets(word, includeFallback, breaks, MAX_WORD_CODEPOINTS);
+  return std::vector<BreakInfo>(breaks, breaks + count);
+}
+
+size_t Hyphenator::breakOffsets(const std::string& word, const bool includeFallback, BreakInfo* out,
+                                const size_t capacity) {
+  if (word.empty() || capacity == 0) {
+    return 0;
   }
 
-  // Convert to codepoints and normalize word boundaries.
-  auto cps = collectCodepoints(word);
-  trimSurroundingPunctuationAndFootnote(cps);
+  HyphenationCache* cache = HyphenationCache::active();
+  if (!cache) {
+    return computeBreakOffsets(word, includeFallback, out, capacity);
+  }
+  const uint64_t key = HyphenationCache::keyFor(word, includeFallback, cachedHyphenator_);
+  size_t count = 0;
+  if (!cache->lookup(key, out, capacity, count)) {
+    count = computeBreakOffsets(word, includeFallback, out, capacity);
+    if (count < capacity) {
+      cache->store(key, word, out, count);  // Complete results only
+    }
+  }
+  return count;
+}
+
+size_t Hyphenator::computeBreakOffsets(const std::string& word, const bool includeFallback, BreakInfo* out,
+                                       const size_t capacity) {
+  BreakList breaks{out, capacity};
   const auto* hyphenator = cachedHyphenator_;
 
+  // Convert to codepoints and normalize word boundaries.
+  CodepointInfo codepoints[MAX_WORD_CODEPOINTS];
+  size_t count = 0;
+  if (!collectCodepoints(word, codepoints, MAX_WORD_CODEPOINTS, count)) {
+    appendLongWordBreaks(word, includeFallback, hyphenator, breaks);
+    return breaks.size;
+  }
+  const CodepointInfo* cps = codepoints + trimSurroundingPunctuationAndFootnote(codepoints, count);
+
   // Detect apostrophe-like separators early; used by both branches below.
   bool hasApostropheLikeSeparator = false;
-  for (const auto& cp : cps) {
-    if (isApostrophe(cp.value)) {
+  for (size_t i = 0; i < count; ++i) {
+    if (isApostrophe(cps[i].value)) {
       hasApostropheLikeSeparator = true;
       break;
     }
   }
 
   // Explicit hyphen markers (soft or hard) take precedence over language breaks.
-  auto explicitBreakInfos = buildExplicitBreakInfos(cps);
-  if (!explicitBreakInfos.empty()) {
+  appendExplicitBreakInfos(cps, count, breaks);
+  if (breaks.size > 0) {
     // When a word contains explicit hyphens we also run Liang patterns on each alphabetic
     // segment between them. Without this, "US-Satellitensystems" would only offer one split
     // point (after "US-"), making it impossible to break mid-"Satellitensystems" even when
@@ -208,16 +296,16 @@ std::vector<Hyphenator::BreakInfo> Hyphenator::breakOffsets(const std::string& w
     //                                            @16 Satellitensys|tems  (+hyphen)
     //   Result: 6 sorted break points; the line-breaker picks the widest prefix that fits.
     if (hyphenator) {
-      appendSegmentPatternBreaks(cps, *hyphenator, /*includeFallback=*/false, explicitBreakInfos);
+      appendSegmentPatternBreaks(cps, count, *hyphenator, /*includeFallback=*/false, breaks);
     }
     // Also add apostrophe contraction breaks when present (e.g. "l'état-major"
     // has both an explicit hyphen and an apostrophe that can independently break).
     if (hasApostropheLikeSeparator) {
-      appendApostropheContractionBreaks(cps, explicitBreakInfos);
+      appendApostropheContractionBreaks(cps, count, breaks);
     }
     // Merge all break points into ascending byte-offset order.
-    sortAndDedupeBreakInfos(explicitBreakInfos);
-    return explicitBreakInfos;
+    sortAndDedupeBreakInfos(breaks);
+    return breaks.size;
   }
 
   // Apostrophe-like separators split compounds into alphabetic segments; run Liang on each segment.
@@ -225,41 +313,34 @@ std::vector<Hyphenator::BreakInfo> Hyphenator::breakOffsets(const std::string& w
   // completely unsplittable due to the apostrophe punctuation. Apostrophe contraction breaks are
   // applied regardless of whether a language hyphenator is available.
   if (hasApostropheLikeSeparator) {
-    std::vector<BreakInfo> segmentedBreaks;
     if (hyphenator) {
-      appendSegmentPatternBreaks(cps, *hyphenator, includeFallback, segmentedBreaks);
+      appendSegmentPatternBreaks(cps, count, *hyphenator, includeFallback, breaks);
     }
-    appendApostropheContractionBreaks(cps, segmentedBreaks);
-    sortAndDedupeBreakInfos(segmentedBreaks);
-    return segmentedBreaks;
+    appendApostropheContractionBreaks(cps, count, breaks);
+    sortAndDedupeBreakInfos(breaks);
+    return breaks.size;
   }
 
   // Ask language hyphenator for legal break points.
-  std::vector<size_t> indexes;
+  size_t indexes[MAX_WORD_CODEPOINTS];
+  size_t indexCount = 0;
   if (hyphenator) {
-    indexes = hyphenator->breakIndexes(cps);
+    indexCount = hyphenator->breakIndexes(cps, count, indexes, MAX_WORD_CODEPOINTS);
   }
 
   // Only add fallback breaks if needed
-  if (includeFallback && indexes.empty()) {
+  if (includeFallback && indexCount == 0) {
     const size_t minPrefix = hyphenator ? hyphenator->minPrefix() : LiangWordConfig::kDefaultMinPrefix;
     const size_t minSuffix = hyphenator ? hyphenator->minSuffix() : LiangWordConfig::kDefaultMinSuffix;
-    for (size_t idx = minPrefix; idx + minSuffix <= cps.size(); ++idx) {
-      indexes.push_back(idx);
+    for (size_t idx = minPrefix; idx + minSuffix <= count && indexCount < MAX_WORD_CODEPOINTS; ++idx) {
+      indexes[indexCount++] = idx;
     }
   }
 
-  if (indexes.empty()) {
-    return {};
-  }
-
-  std::vector<Hyphenator::BreakInfo> breaks;
-  breaks.reserve(indexes.size());
-  for (const size_t idx : indexes) {
-    breaks.push_back({byteOffsetForIndex(cps, idx), true});
+  for (size_t i = 0; i < indexCount; ++i) {
+    breaks.push(byteOffsetForIndex(cps, count, indexes[i]), true);
   }
-
-  return breaks;
+  return breaks.size;
 }
 
 void Hyphenator::setPreferredLanguage(const std::string& lang) { cachedHyphenator_ = hyphenatorForLanguage(lang); }
@@ -33,11 +33,24 @@ class Hyphenator {
   //   4. Fallback every-N-chars splitting (only when includeFallback is true AND no
   //      pattern breaks were found). Used as a last resort to prevent a single oversized
   //      word from overflowing the page width.
+  //
+  // Results are memoized while a HyphenationCache is alive.
   static std::vector<BreakInfo> breakOffsets(const std::string& word, bool includeFallback);
 
+  // Words of up to this many codepoints are analyzed in full. A word has fewer breaks than codepoints, so a buffer of
+  // this many entries holds all of its breaks.
+  static constexpr size_t MAX_WORD_CODEPOINTS = 72;
+
+  // Same as above, written into `out` without touching the heap; returns the number of breaks. Only the first
+  // `capacity` breaks are kept. Words longer than MAX_WORD_CODEPOINTS are past every pattern table's limit and only
+  // break at explicit hyphens or, with includeFallback, between any two characters.
+  static size_t breakOffsets(const std::string& word, bool includeFallback, BreakInfo* out, size_t capacity);
+
   // Provide a publication-level language hint (e.g. "en", "en-US", "ru") used to select hyphenation rules.
   static void setPreferredLanguage(const std::string& lang);
 
  private:
   static const LanguageHyphenator* cachedHyphenator_;
+
+  static size_t computeBreakOffsets(const std::string& word, bool includeFallback, BreakInfo* out, size_t capacity);
 };
\ No newline at end of file
@@ -4,45 +4,92 @@
 #include <array>
 
 #include "HyphenationCommon.h"
-#include "generated/hyph-de.trie.h"
+#include "HyphenationPack.h"
 #include "generated/hyph-en.trie.h"
-#include "generated/hyph-es.trie.h"
-#include "generated/hyph-fr.trie.h"
-#include "generated/hyph-it.trie.h"
-#include "generated/hyph-ru.trie.h"
-#include "generated/hyph-uk.trie.h"
 
 namespace {
 
-// English hyphenation patterns (3/3 minimum prefix/suffix length)
+// A language whose patterns come from a pack. `patterns` points into the loaded pack image (empty while another
+// language is loaded) and `hyphenator` reads it through a reference, so it follows the pack being loaded and dropped.
+struct PackedLanguage {
+  SerializedHyphenationPatterns patterns{0, nullptr, 0};
+  LanguageHyphenator hyphenator;
+
+  PackedLanguage(bool (*isLetterFn)(uint32_t), uint32_t (*toLowerFn)(uint32_t))
+      : hyphenator(patterns, isLetterFn, toLowerFn) {}
+};
+
+HyphenationPackLoader packLoader = nullptr;
+
+// English hyphenation patterns (3/3 minimum prefix/suffix length); the only language built into the firmware
 LanguageHyphenator englishHyphenator(en_patterns, isLatinLetter, toLowerLatin, 3, 3);
-LanguageHyphenator frenchHyphenator(fr_patterns, isLatinLetter, toLowerLatin);
-LanguageHyphenator germanHyphenator(de_patterns, isLatinLetter, toLowerLatin);
-LanguageHyphenator russianHyphenator(ru_patterns, isCyrillicLetter, toLowerCyrillic);
-LanguageHyphenator spanishHyphenator(es_patterns, isLatinLetter, toLowerLatin);
-LanguageHyphenator italianHyphenator(it_patterns, isLatinLetter, toLowerLatin);
-LanguageHyphenator ukrainianHyphenator(uk_patterns, isCyrillicLetter, toLowerCyrillic);
+PackedLanguage french(isLatinLetter, toLowerLatin);
+PackedLanguage german(isLatinLetter, toLowerLatin);
+PackedLanguage russian(isCyrillicLetter, toLowerCyrillic);
+PackedLanguage spanish(isLatinLetter, toLowerLatin);
+PackedLanguage italian(isLatinLetter, toLowerLatin);
+PackedLanguage ukrainian(isCyrillicLetter, toLowerCyrillic);
+
+constexpr std::array<PackedLanguage*, 6> kPackedLanguages = {&french,  &german,  &russian,
+                                                             &spanish, &italian, &ukrainian};
+PackedLanguage* loadedLanguage = nullptr;
 
 using EntryArray = std::array<LanguageEntry, 7>;
 
 const EntryArray& entries() {
   static const EntryArray kEntries = {{{"english", "en", &englishHyphenator},
-                                       {"french", "fr", &frenchHyphenator},
-                                       {"german", "de", &germanHyphenator},
-                                       {"russian", "ru", &russianHyphenator},
-                                       {"spanish", "es", &spanishHyphenator},
-                                       {"italian", "it", &italianHyphenator},
-                                       {"ukrainian", "uk", &ukrainianHyphenator}}};
+                                       {"french", "fr", &french.hyphenator},
+                                       {"german", "de", &german.hyphenator},
+                                       {"russian", "ru", &russian.hyphenator},
+                                       {"spanish", "es", &spanish.hyphenator},
+                                       {"italian", "it", &italian.hyphenator},
+                                       {"ukrainian", "uk", &ukrainian.hyphenator}}};
   return kEntries;
 }
 
+void dropLoadedPack() {
+  if (loadedLanguage) {
+    loadedLanguage->patterns = SerializedHyphenationPatterns{0, nullptr, 0};
+    loadedLanguage = nullptr;
+  }
+}
+
+// Only one pack is loaded at a time: a book hyphenates in one language, and the loader reuses its storage.
+bool loadPack(PackedLanguage& language, const char* primaryTag) {
+  if (loadedLanguage == &language) {
+    return true;
+  }
+  // The loader invalidates the previous image
+  dropLoadedPack();
+  size_t size = 0;
+  const uint8_t* image = packLoader ? packLoader(primaryTag, size) : nullptr;
+  if (!image || !HyphenationPack::parse(image, size, language.patterns)) {
+    return false;
+  }
+  loadedLanguage = &language;
+  return true;
+}
+
 }  // namespace
 
+void setHyphenationPackLoader(const HyphenationPackLoader loader) {
+  dropLoadedPack();
+  packLoader = loader;
+}
+
 const LanguageHyphenator* getLanguageHyphenatorForPrimaryTag(const std::string& primaryTag) {
   const auto& allEntries = entries();
   const auto it = std::find_if(allEntries.begin(), allEntries.end(),
                                [&primaryTag](const LanguageEntry& entry) { return primaryTag == entry.primaryTag; });
-  return (it != allEntries.end()) ? it->hyphenator : nullptr;
+  if (it == allEntries.end()) {
+    return nullptr;
+  }
+  for (PackedLanguage* language : kPackedLanguages) {
+    if (&language->hyphenator == it->hyphenator) {
+      return loadPack(*language, it->primaryTag) ? it->hyphenator : nullptr;
+    }
+  }
+  return it->hyphenator;
 }
 
 LanguageEntryView getLanguageEntries() {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 
 #include "LanguageHyphenator.h"
@@ -19,7 +20,17 @@ struct LanguageEntryView {
   const LanguageEntry* end() const { return data + size; }
 };
 
-// Returns the Liang-backed hyphenator for a given primary language tag (e.g., "en", "fr").
+// Returns the pattern pack image (see HyphenationPack.h) for a primary language tag and sets `size`, or returns nullptr
+// when there is none. The image must stay valid until the loader is called again.
+using HyphenationPackLoader = const uint8_t* (*)(const char* primaryTag, size_t& size);
+
+// English patterns are built in; every other language comes from a pattern pack loaded through this hook (copied from
+// the SD card and memory-mapped on the device). Without a loader only English hyphenates.
+void setHyphenationPackLoader(HyphenationPackLoader loader);
+
+// Returns the Liang-backed hyphenator for a given primary language tag (e.g., "en", "fr"), or nullptr if the language
+// is unknown or its pack cannot be loaded. Loading a language's pack drops the previously loaded one, which leaves that
+// language's hyphenator without patterns (no breaks) until it is requested here again.
 const LanguageHyphenator* getLanguageHyphenatorForPrimaryTag(const std::string& primaryTag);
 
 // Exposes the list of supported languages primarily for tooling/tests.
@@ -24,8 +24,9 @@
  *       nodes, and an optional pointer into a shared "levels" list. We parse
  *       that layout lazily via decodeState/transition, keeping everything in
  *       flash memory; no heap allocations besides the stack-local AutomatonState
- *       structs. getAutomaton caches parseAutomaton results per blob pointer so
- *       multiple words hitting the same language only pay the cost once.
+ *       structs. The first two steps of every walk (root, then one of its
+ *       children) index the dense dispatch tables the generator emits next to
+ *       the blob instead of scanning the node's transition list.
  *
  * 3.  Pattern application
  *     - We walk the augmented bytes left-to-right. For each starting byte we
@@ -40,9 +41,9 @@
  * 4.  Output filtering
  *     - collectBreakIndexes converts odd-valued score entries back to codepoint
  *       break positions while enforcing `minPrefix`/`minSuffix` constraints from
- *       LiangWordConfig. The caller (language-specific hyphenators) can then
- *       translate these indexes into renderer glyph offsets, page layout data,
- *       etc.
+ *       LiangWordConfig, writing them into the caller's buffer. The caller
+ *       (language-specific hyphenators) can then translate these indexes into
+ *       renderer glyph offsets, page layout data, etc.
  *
  * Keeping the entire algorithm small and deterministic is critical on the
  * ESP32-C3: we avoid recursion, dynamic allocations per node, or copying the
@@ -63,7 +64,9 @@
  * 2 UTF-8 bytes per German letter + 2 sentinel dots = 128 bytes. MAX_WORD_BYTES=160
  * and MAX_WORD_CHARS=70 give comfortable headroom. Words exceeding these limits
  * are silently skipped (no hyphenation), which is acceptable for correctness.
- * The struct lives on the render-task stack (8 KB) so no permanent DRAM is wasted.
+ * The struct lives on the render-task stack (8 KB) so no permanent DRAM is wasted;
+ * its offset tables use 8-bit entries (both limits are below 256) to keep that
+ * footprint small, since the callers above it hold fixed buffers of their own.
  */
 
 namespace {
@@ -75,11 +78,12 @@ using EmbeddedAutomaton = SerializedHyphenationPatterns;
 // exceed these limits are skipped rather than heap-allocated.
 static constexpr size_t MAX_WORD_BYTES = 160;  // max UTF-8 bytes in augmented word
 static constexpr size_t MAX_WORD_CHARS = 70;   // max codepoints + 2 sentinel dots
+static_assert(MAX_WORD_BYTES <= 256 && MAX_WORD_CHARS <= 128, "AugmentedWord offsets are 8-bit");
 
 struct AugmentedWord {
   uint8_t bytes[MAX_WORD_BYTES];
-  size_t charByteOffsets[MAX_WORD_CHARS];
-  int32_t byteToCharIndex[MAX_WORD_BYTES];
+  uint8_t charByteOffsets[MAX_WORD_CHARS];
+  int8_t byteToCharIndex[MAX_WORD_BYTES];
   size_t byteLen = 0;
   size_t charCount_ = 0;
 
@@ -126,11 +130,12 @@ size_t encodeUtf8(uint32_t cp, AugmentedWord& word) {
 
 // Build the dotted, lowercase UTF-8 representation plus lookup tables into `word`.
 // Returns false if the word should be skipped (empty, non-letter, or too long).
-bool buildAugmentedWord(AugmentedWord& word, const std::vector<CodepointInfo>& cps, const LiangWordConfig& config) {
+bool buildAugmentedWord(AugmentedWord& word, const CodepointInfo* cps, const size_t count,
+                        const LiangWordConfig& config) {
   word.byteLen = 0;
   word.charCount_ = 0;
 
-  if (cps.empty()) {
+  if (count == 0) {
     return false;
   }
 
@@ -138,7 +143,8 @@ bool buildAugmentedWord(AugmentedWord& word, const std::vector<CodepointInfo>& c
   word.charByteOffsets[word.charCount_++] = 0;
   word.bytes[word.byteLen++] = '.';
 
-  for (const auto& info : cps) {
+  for (size_t i = 0; i < count; ++i) {
+    const CodepointInfo& info = cps[i];
     if (!config.isLetter(info.value)) {
       word.byteLen = 0;
       word.charCount_ = 0;
@@ -150,7 +156,7 @@ bool buildAugmentedWord(AugmentedWord& word, const std::vector<CodepointInfo>& c
       word.charCount_ = 0;
       return false;  // word too long
     }
-    word.charByteOffsets[word.charCount_++] = word.byteLen;
+    word.charByteOffsets[word.charCount_++] = static_cast<uint8_t>(word.byteLen);
     if (encodeUtf8(config.toLower(info.value), word) == 0) {
       word.byteLen = 0;
       word.charCount_ = 0;
@@ -164,7 +170,7 @@ bool buildAugmentedWord(AugmentedWord& word, const std::vector<CodepointInfo>& c
     word.charCount_ = 0;
     return false;
   }
-  word.charByteOffsets[word.charCount_++] = word.byteLen;
+  word.charByteOffsets[word.charCount_++] = static_cast<uint8_t>(word.byteLen);
   word.bytes[word.byteLen++] = '.';
 
   // Build byte→char reverse index: -1 for mid-codepoint bytes, char index for start bytes.
@@ -174,7 +180,7 @@ bool buildAugmentedWord(AugmentedWord& word, const std::vector<CodepointInfo>& c
   for (size_t i = 0; i < word.charCount_; ++i) {
     const size_t offset = word.charByteOffsets[i];
     if (offset < word.byteLen) {
-      word.byteToCharIndex[offset] = static_cast<int32_t>(i);
+      word.byteToCharIndex[offset] = static_cast<int8_t>(i);
     }
   }
 
@@ -283,6 +289,23 @@ int32_t decodeDelta(const uint8_t* buf, uint8_t stride) {
   return unsignedVal - (1 << 23);
 }
 
+// Decode the child behind transition `idx` of `state`.
+bool childAt(const EmbeddedAutomaton& automaton, const AutomatonState& state, const size_t idx, AutomatonState& out) {
+  if (idx >= state.childCount) {
+    return false;
+  }
+  const uint8_t* deltaPtr = state.targets + idx * state.stride;
+  const int32_t delta = decodeDelta(deltaPtr, state.stride);
+  // Deltas are relative to the current node's address, allowing us to keep all
+  // targets within 24 bits while still referencing further nodes in the blob.
+  const int64_t nextAddr = static_cast<int64_t>(state.addr) + delta;
+  if (nextAddr < 0 || static_cast<size_t>(nextAddr) >= automaton.size) {
+    return false;
+  }
+  out = decodeState(automaton, static_cast<size_t>(nextAddr));
+  return out.valid();
+}
+
 // Follow a single byte transition from `state`, decoding the child node on success.
 bool transition(const EmbeddedAutomaton& automaton, const AutomatonState& state, uint8_t letter, AutomatonState& out) {
   if (!state.valid()) {
@@ -292,32 +315,27 @@ bool transition(const EmbeddedAutomaton& automaton, const AutomatonState& state,
   // Children remain sorted by letter in the serialized blob, but the lists are
   // short enough that a linear scan keeps code size down compared to binary search.
   for (size_t idx = 0; idx < state.childCount; ++idx) {
-    if (state.transitions[idx] != letter) {
-      continue;
-    }
-    const uint8_t* deltaPtr = state.targets + idx * state.stride;
-    const int32_t delta = decodeDelta(deltaPtr, state.stride);
-    // Deltas are relative to the current node's address, allowing us to keep all
-    // targets within 24 bits while still referencing further nodes in the blob.
-    const int64_t nextAddr = static_cast<int64_t>(state.addr) + delta;
-    if (nextAddr < 0 || static_cast<size_t>(nextAddr) >= automaton.size) {
-      return false;
+    if (state.transitions[idx] == letter) {
+      return childAt(automaton, state, idx, out);
     }
-    out = decodeState(automaton, static_cast<size_t>(nextAddr));
-    return out.valid();
   }
   return false;
 }
 
+// Follow a transition through a dense dispatch table (256 child indexes, 0xFF = none).
+bool dispatchTransition(const EmbeddedAutomaton& automaton, const AutomatonState& state, const uint8_t* table,
+                        const uint8_t letter, AutomatonState& out) {
+  const uint8_t idx = table[letter];
+  return idx != 0xFF && childAt(automaton, state, idx, out);
+}
+
 // Converts odd score positions back into codepoint indexes, honoring min prefix/suffix constraints.
 // Each break corresponds to scores[breakIndex + 1] because of the leading '.' sentinel.
-// Convert odd score entries into hyphen positions while honoring prefix/suffix limits.
-std::vector<size_t> collectBreakIndexes(const std::vector<CodepointInfo>& cps, const uint8_t* scores,
-                                        const size_t scoresSize, const size_t minPrefix, const size_t minSuffix) {
-  std::vector<size_t> indexes;
-  const size_t cpCount = cps.size();
+size_t collectBreakIndexes(const size_t cpCount, const uint8_t* scores, const size_t scoresSize,
+                           const size_t minPrefix, const size_t minSuffix, size_t* out, const size_t capacity) {
+  size_t written = 0;
   if (cpCount < 2) {
-    return indexes;
+    return written;
   }
 
   for (size_t breakIndex = 1; breakIndex < cpCount; ++breakIndex) {
@@ -337,29 +355,32 @@ std::vector<size_t> collectBreakIndexes(const std::vector<CodepointInfo>& cps, c
     if ((scores[scoreIdx] & 1u) == 0) {
       continue;
     }
-    indexes.push_back(breakIndex);
+    if (written == capacity) {
+      break;
+    }
+    out[written++] = breakIndex;
   }
 
-  return indexes;
+  return written;
 }
 
 }  // namespace
 
 // Entry point that runs the full Liang pipeline for a single word.
-std::vector<size_t> liangBreakIndexes(const std::vector<CodepointInfo>& cps,
-                                      const SerializedHyphenationPatterns& patterns, const LiangWordConfig& config) {
+size_t liangBreakIndexes(const CodepointInfo* cps, const size_t count, const SerializedHyphenationPatterns& patterns,
+                         const LiangWordConfig& config, size_t* out, const size_t capacity) {
   // AugmentedWord uses fixed-size C arrays (no heap allocation) to avoid
   // fragmenting the heap across hundreds of words during page layout.
   AugmentedWord augmented;
-  if (!buildAugmentedWord(augmented, cps, config)) {
-    return {};
+  if (!buildAugmentedWord(augmented, cps, count, config)) {
+    return 0;
   }
 
   const EmbeddedAutomaton& automaton = patterns;
 
   const AutomatonState root = decodeState(automaton, automaton.rootOffset);
   if (!root.valid()) {
-    return {};
+    return 0;
   }
 
   // Liang scores: one entry per augmented char (leading/trailing dots included).
@@ -373,12 +394,21 @@ std::vector<size_t> liangBreakIndexes(const std::vector<CodepointInfo>& cps,
   for (size_t charStart = 0; charStart < augmented.charCount_; ++charStart) {
     const size_t byteStart = augmented.charByteOffsets[charStart];
     AutomatonState state = root;
+    // Dense table for the node reached after the first byte, if the generator emitted one
+    const uint8_t* nextTable = automaton.dispatch;
 
     for (size_t cursor = byteStart; cursor < augmented.byteLen; ++cursor) {
+      const uint8_t letter = augmented.bytes[cursor];
       AutomatonState next;
-      if (!transition(automaton, state, augmented.bytes[cursor], next)) {
+      const bool matched = nextTable ? dispatchTransition(automaton, state, nextTable, letter, next)
+                                     : transition(automaton, state, letter, next);
+      if (!matched) {
         break;  // No more matches for this prefix.
       }
+      nextTable = nullptr;
+      if (cursor == byteStart && automaton.dispatchSlots && automaton.dispatchSlots[letter] != 0) {
+        nextTable = automaton.dispatch + automaton.dispatchSlots[letter] * 256u;
+      }
       state = next;
 
       if (state.levels && state.levelsLen > 0) {
@@ -413,5 +443,12 @@ std::vector<size_t> liangBreakIndexes(const std::vector<CodepointInfo>& cps,
     }
   }
 
-  return collectBreakIndexes(cps, scores, augmented.charCount_, config.minPrefix, config.minSuffix);
+  return collectBreakIndexes(count, scores, augmented.charCount_, config.minPrefix, config.minSuffix, out, capacity);
+}
+
+std::vector<size_t> liangBreakIndexes(const std::vector<CodepointInfo>& cps,
+                                      const SerializedHyphenationPatterns& patterns, const LiangWordConfig& config) {
+  size_t indexes[MAX_WORD_CHARS];
+  const size_t count = liangBreakIndexes(cps.data(), cps.size(), patterns, config, indexes, MAX_WORD_CHARS);
+  return std::vector<size_t>(indexes, indexes + count);
 }
@@ -33,6 +33,12 @@ struct LiangWordConfig {
       : isLetter(letterFn), toLower(lowerFn), minPrefix(prefix), minSuffix(suffix) {}
 };
 
-// Shared Liang pattern evaluator used by every language-specific hyphenator.
+// Shared Liang pattern evaluator used by every language-specific hyphenator.  Writes the codepoint indexes at which
+// `cps` may break into `out`, in ascending order, and returns how many were written (at most `capacity`).  Works
+// entirely on the stack; words too long for its fixed buffers have no breaks.
+size_t liangBreakIndexes(const CodepointInfo* cps, size_t count, const SerializedHyphenationPatterns& patterns,
+                         const LiangWordConfig& config, size_t* out, size_t capacity);
+
+// Same as above, collected into a vector.
 std::vector<size_t> liangBreakIndexes(const std::vector<CodepointInfo>& cps,
                                       const SerializedHyphenationPatterns& patterns, const LiangWordConfig& config);
@@ -8,4 +8,9 @@ struct SerializedHyphenationPatterns {
   size_t rootOffset;
   const std::uint8_t* data;
   size_t size;
+  // Dense first-step transitions precomputed by generate_hyphenation_trie.py (null = scan every node). Table 0 maps a
+  // byte to the root's child index; dispatchSlots[b], when non-zero, names the table for the root's child on byte b.
+  // Tables are 256 bytes each and 0xFF marks a missing child.
+  const std::uint8_t* dispatch = nullptr;
+  const std::uint8_t* dispatchSlots = nullptr;
 };
@@ -1,5 +1,6 @@
 #include "ChapterHtmlSlimParser.h"
 
+#include <Arduino.h>
 #include <FsHelpers.h>
 #include <GfxRenderer.h>
 #include <HalStorage.h>
@@ -21,6 +22,11 @@ constexpr int NUM_HEADER_TAGS = sizeof(HEADER_TAGS) / sizeof(HEADER_TAGS[0]);
 constexpr size_t MIN_SIZE_FOR_POPUP = 10 * 1024;  // 10KB
 constexpr size_t PARSE_BUFFER_SIZE = 1024;
 
+// The layout task holds up to the pipeline depth of paragraphs more than laying out inline does, plus its stack
+constexpr size_t MIN_FREE_HEAP_FOR_LAYOUT_TASK = 96 * 1024;
+// Same as the task that builds sections: line breaking, hyphenation and page serialization all run on it
+constexpr uint32_t LAYOUT_TASK_STACK_SIZE = 8192;
+
 const char* BLOCK_TAGS[] = {"p", "li", "div", "br", "blockquote"};
 constexpr int NUM_BLOCK_TAGS = sizeof(BLOCK_TAGS) / sizeof(BLOCK_TAGS[0]);
 
@@ -99,8 +105,8 @@ void ChapterHtmlSlimParser::updateEffectiveInlineStyle() {
   }
 }
 
-// flush the contents of partWordBuffer to currentTextBlock
-void ChapterHtmlSlimParser::flushPartWordBuffer() {
+// add a word (or a piece of a long one) from the tokenizer to currentTextBlock
+void ChapterHtmlSlimParser::addWord(const char* word, const size_t length) {
   // Determine font style from depth-based tracking and CSS effective style
   const bool isBold = boldUntilDepth < depth || effectiveBold;
   const bool isItalic = italicUntilDepth < depth || effectiveItalic;
@@ -118,40 +124,137 @@ void ChapterHtmlSlimParser::flushPartWordBuffer() {
     fontStyle = static_cast<EpdFontFamily::Style>(fontStyle | EpdFontFamily::UNDERLINE);
   }
 
-  // flush the buffer
-  partWordBuffer[partWordBufferIndex] = '\0';
-  currentTextBlock->addWord(partWordBuffer, fontStyle, false, nextWordContinues);
-  partWordBufferIndex = 0;
+  currentTextBlock->addWord(std::string(word, length), fontStyle, false, nextWordContinues);
   nextWordContinues = false;
 }
 
+// Whitespace is a real word boundary — reset continuation state
+void ChapterHtmlSlimParser::wordBreak() { nextWordContinues = false; }
+
+// Both no-break spaces are rendered as a visible space but must never allow a line break around them.
+// The space becomes its own word token and the surrounding words are linked with continuation flags
+// so the layout engine treats them as an indivisible group.
+//
+// Example: "200&#xA0;Quadratkilometer" or "200&#x202F;Quadratkilometer"
+//   Input bytes:  "200\xC2\xA0Quadratkilometer"  (or 0xE2 0x80 0xAF for U+202F)
+//   Tokens produced:
+//     [0] "200"               continues=false
+//     [1] " "                 continues=true   (attaches to "200", no gap)
+//     [2] "Quadratkilometer"  continues=true   (attaches to " ", no gap)
+//
+//   The continuation flags prevent the line-breaker from inserting a line break
+//   between "200" and "Quadratkilometer". However, "Quadratkilometer" is now a
+//   standalone word for hyphenation purposes, so Liang patterns can produce
+//   "200 Quadrat-" / "kilometer" instead of the unusable "200" / "Quadratkilometer".
+void ChapterHtmlSlimParser::noBreakSpace() {
+  nextWordContinues = true;  // Attach space to previous word (no break).
+  addWord(" ", 1);
+  nextWordContinues = true;  // Next real word attaches to this space (no break).
+}
+
 // start a new text block if needed
-void ChapterHtmlSlimParser::startNewTextBlock(const BlockStyle& blockStyle) {
+void ChapterHtmlSlimParser::startNewTextBlock(const CssBlockStyle& blockStyle) {
   nextWordContinues = false;  // New block = new paragraph, no continuation
   if (currentTextBlock) {
     // already have a text block running and it is empty - just reuse it
-    if (currentTextBlock->isEmpty()) {
+    if (!paragraphHasWords()) {
       // Merge with existing block style to accumulate CSS styling from parent block elements.
       // This handles cases like <div style="margin-bottom:2em"><h1>text</h1></div> where the
       // div's margin should be preserved, even though it has no direct text content.
-      currentTextBlock->setBlockStyle(currentTextBlock->getBlockStyle().getCombinedBlockStyle(blockStyle));
-
-      if (!pendingAnchorId.empty()) {
-        anchorData.push_back({std::move(pendingAnchorId), static_cast<uint16_t>(completedPageCount)});
-        pendingAnchorId.clear();
-      }
+      currentBlockStyle.combineWith(blockStyle);
+      emitPendingAnchor();
       return;
     }
 
-    makePages();
+    emitParagraph(true);
   }
   // Record deferred anchor after previous block is flushed
-  if (!pendingAnchorId.empty()) {
-    anchorData.push_back({std::move(pendingAnchorId), static_cast<uint16_t>(completedPageCount)});
-    pendingAnchorId.clear();
+  emitPendingAnchor();
+  currentBlockStyle = blockStyle;
+  if (!currentTextBlock) {
+    // Reused from then on: emitParagraph() leaves it empty, with the storage of an earlier paragraph
+    currentTextBlock.reset(new ParsedText(extraParagraphSpacing, hyphenationEnabled));
+  }
+}
+
+ChapterPageBuilder::Item* ChapterHtmlSlimParser::acquireLayoutItem() {
+  return layoutTask ? layoutRing->acquire() : &inlineLayoutItem;
+}
+
+void ChapterHtmlSlimParser::submitLayoutItem(const ChapterPageBuilder::Item& item) {
+  if (itemCacheFile) {
+    if (!item.serialize(*itemCacheFile)) {
+      // Stop writing; isItemCacheComplete() tells the caller to drop the file
+      itemCacheFile = nullptr;
+    }
+  }
+  if (layoutTask) {
+    layoutRing->publish();
+  } else {
+    pageBuilder.process(inlineLayoutItem);
+  }
+}
+
+// Hand the words collected so far, and the footnote links among them, to the layout stage
+void ChapterHtmlSlimParser::emitParagraph(const bool endsParagraph) {
+  ChapterPageBuilder::Item* item = acquireLayoutItem();
+  if (!item) {
+    return;
+  }
+  const int words = static_cast<int>(currentTextBlock->size());
+  item->kind = ChapterPageBuilder::Item::Kind::Paragraph;
+  item->paragraphIndex = xpathParagraphIndex;
+  item->style = currentBlockStyle;
+  item->text.takeWords(*currentTextBlock);
+  item->endsParagraph = endsParagraph;
+  item->footnotes.swap(pendingFootnotes);
+  submitLayoutItem(*item);
+  wordsShippedInBlock = endsParagraph ? 0 : wordsShippedInBlock + words;
+}
+
+// Record the deferred anchor at the position the layout stage has reached
+void ChapterHtmlSlimParser::emitPendingAnchor() {
+  if (pendingAnchorId.empty()) {
+    return;
+  }
+  ChapterPageBuilder::Item* item = acquireLayoutItem();
+  if (item) {
+    item->kind = ChapterPageBuilder::Item::Kind::Anchor;
+    item->paragraphIndex = xpathParagraphIndex;
+    item->name = std::move(pendingAnchorId);
+    submitLayoutItem(*item);
   }
-  currentTextBlock.reset(new ParsedText(extraParagraphSpacing, hyphenationEnabled, blockStyle));
-  wordsExtractedInBlock = 0;
+  pendingAnchorId.clear();
+}
+
+// The layout stage sizes the image for the viewport, from its own size and the size its CSS asks for
+void ChapterHtmlSlimParser::emitImage(const std::string& path, const std::string& source,
+                                      const ImageDimensions& dims, const CssStyle& imgStyle) {
+  ChapterPageBuilder::Item* item = acquireLayoutItem();
+  if (!item) {
+    return;
+  }
+  item->kind = ChapterPageBuilder::Item::Kind::Image;
+  item->paragraphIndex = xpathParagraphIndex;
+  item->name = path;
+  item->source = source;
+  item->imageWidth = dims.width;
+  item->imageHeight = dims.height;
+  item->hasCssWidth = imgStyle.hasImageWidth();
+  item->hasCssHeight = imgStyle.hasImageHeight();
+  item->cssWidth = imgStyle.imageWidth;
+  item->cssHeight = imgStyle.imageHeight;
+  submitLayoutItem(*item);
+}
+
+void ChapterHtmlSlimParser::emitEnd() {
+  ChapterPageBuilder::Item* item = acquireLayoutItem();
+  if (!item) {
+    return;
+  }
+  item->kind = ChapterPageBuilder::Item::Kind::End;
+  item->paragraphIndex = xpathParagraphIndex;
+  submitLayoutItem(*item);
 }
 
 void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char* name, const XML_Char** atts) {
@@ -183,7 +286,7 @@ void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char*
     }
   }
 
-  auto centeredBlockStyle = BlockStyle();
+  auto centeredBlockStyle = CssBlockStyle();
   centeredBlockStyle.textAlignDefined = true;
   centeredBlockStyle.alignment = CssTextAlign::Center;
 
@@ -213,8 +316,8 @@ void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char*
       return;
     }
 
-    if (self->partWordBufferIndex > 0) {
-      self->flushPartWordBuffer();
+    if (self->wordTokenizer.hasPendingWord()) {
+      self->wordTokenizer.flush();
     }
     self->tableDepth += 1;
     self->tableRowIndex = 0;
@@ -231,12 +334,12 @@ void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char*
   }
 
   if (self->tableDepth == 1 && (strcmp(name, "td") == 0 || strcmp(name, "th") == 0)) {
-    if (self->partWordBufferIndex > 0) {
-      self->flushPartWordBuffer();
+    if (self->wordTokenizer.hasPendingWord()) {
+      self->wordTokenizer.flush();
     }
     self->tableColIndex += 1;
 
-    auto tableCellBlockStyle = BlockStyle();
+    auto tableCellBlockStyle = CssBlockStyle();
     tableCellBlockStyle.textAlignDefined = true;
     const auto align = (self->paragraphAlignment == static_cast<uint8_t>(CssTextAlign::None))
                            ? CssTextAlign::Justify
@@ -257,8 +360,8 @@ void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char*
     self->inlineStyleStack.push_back(headerStyle);
     self->updateEffectiveInlineStyle();
     self->characterData(userData, headerText.c_str(), static_cast<int>(headerText.length()));
-    if (self->partWordBufferIndex > 0) {
-      self->flushPartWordBuffer();
+    if (self->wordTokenizer.hasPendingWord()) {
+      self->wordTokenizer.flush();
     }
     self->nextWordContinues = false;
     self->inlineStyleStack.pop_back();
@@ -333,136 +436,22 @@ void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char*
               if (decoder && decoder->getDimensions(cachedImagePath, dims)) {
                 LOG_DBG("EHP", "Image dimensions: %dx%d", dims.width, dims.height);
 
-                int displayWidth = 0;
-                int displayHeight = 0;
-                const float emSize = static_cast<float>(self->renderer.getFontAscenderSize(self->fontId));
                 CssStyle imgStyle = self->cssParser ? self->cssParser->resolveStyle("img", classAttr) : CssStyle{};
                 // Merge inline style (e.g. style="height: 2em") so it overrides stylesheet rules
                 if (!styleAttr.empty()) {
                   imgStyle.applyOver(CssParser::parseInlineStyle(styleAttr));
                 }
-                const bool hasCssHeight = imgStyle.hasImageHeight();
-                const bool hasCssWidth = imgStyle.hasImageWidth();
-
-                if (hasCssHeight && hasCssWidth && dims.width > 0 && dims.height > 0) {
-                  // Both CSS height and width set: resolve both, then clamp to viewport preserving requested ratio
-                  displayHeight = static_cast<int>(
-                      imgStyle.imageHeight.toPixels(emSize, static_cast<float>(self->viewportHeight)) + 0.5f);
-                  displayWidth = static_cast<int>(
-                      imgStyle.imageWidth.toPixels(emSize, static_cast<float>(self->viewportWidth)) + 0.5f);
-                  if (displayHeight < 1) displayHeight = 1;
-                  if (displayWidth < 1) displayWidth = 1;
-                  if (displayWidth > self->viewportWidth || displayHeight > self->viewportHeight) {
-                    float scaleX = (displayWidth > self->viewportWidth)
-                                       ? static_cast<float>(self->viewportWidth) / displayWidth
-                                       : 1.0f;
-                    float scaleY = (displayHeight > self->viewportHeight)
-                                       ? static_cast<float>(self->viewportHeight) / displayHeight
-                                       : 1.0f;
-                    float scale = (scaleX < scaleY) ? scaleX : scaleY;
-                    displayWidth = static_cast<int>(displayWidth * scale + 0.5f);
-                    displayHeight = static_cast<int>(displayHeight * scale + 0.5f);
-                    if (displayWidth < 1) displayWidth = 1;
-                    if (displayHeight < 1) displayHeight = 1;
-                  }
-                  LOG_DBG("EHP", "Display size from CSS height+width: %dx%d", displayWidth, displayHeight);
-                } else if (hasCssHeight && !hasCssWidth && dims.width > 0 && dims.height > 0) {
-                  // Use CSS height (resolve % against viewport height) and derive width from aspect ratio
-                  displayHeight = static_cast<int>(
-                      imgStyle.imageHeight.toPixels(emSize, static_cast<float>(self->viewportHeight)) + 0.5f);
-                  if (displayHeight < 1) displayHeight = 1;
-                  displayWidth =
-                      static_cast<int>(displayHeight * (static_cast<float>(dims.width) / dims.height) + 0.5f);
-                  if (displayHeight > self->viewportHeight) {
-                    displayHeight = self->viewportHeight;
-                    // Rescale width to preserve aspect ratio when height is clamped
-                    displayWidth =
-                        static_cast<int>(displayHeight * (static_cast<float>(dims.width) / dims.height) + 0.5f);
-                    if (displayWidth < 1) displayWidth = 1;
-                  }
-                  if (displayWidth > self->viewportWidth) {
-                    displayWidth = self->viewportWidth;
-                    // Rescale height to preserve aspect ratio when width is clamped
-                    displayHeight =
-                        static_cast<int>(displayWidth * (static_cast<float>(dims.height) / dims.width) + 0.5f);
-                    if (displayHeight < 1) displayHeight = 1;
-                  }
-                  if (displayWidth < 1) displayWidth = 1;
-                  LOG_DBG("EHP", "Display size from CSS height: %dx%d", displayWidth, displayHeight);
-                } else if (hasCssWidth && !hasCssHeight && dims.width > 0 && dims.height > 0) {
-                  // Use CSS width (resolve % against viewport width) and derive height from aspect ratio
-                  displayWidth = static_cast<int>(
-                      imgStyle.imageWidth.toPixels(emSize, static_cast<float>(self->viewportWidth)) + 0.5f);
-                  if (displayWidth > self->viewportWidth) displayWidth = self->viewportWidth;
-                  if (displayWidth < 1) displayWidth = 1;
-                  displayHeight =
-                      static_cast<int>(displayWidth * (static_cast<float>(dims.height) / dims.width) + 0.5f);
-                  if (displayHeight > self->viewportHeight) {
-                    displayHeight = self->viewportHeight;
-                    // Rescale width to preserve aspect ratio when height is clamped
-                    displayWidth =
-                        static_cast<int>(displayHeight * (static_cast<float>(dims.width) / dims.height) + 0.5f);
-                    if (displayWidth < 1) displayWidth = 1;
-                  }
-                  if (displayHeight < 1) displayHeight = 1;
-                  LOG_DBG("EHP", "Display size from CSS width: %dx%d", displayWidth, displayHeight);
-                } else {
-                  // Scale to fit viewport while maintaining aspect ratio
-                  int maxWidth = self->viewportWidth;
-                  int maxHeight = self->viewportHeight;
-                  float scaleX = (dims.width > maxWidth) ? (float)maxWidth / dims.width : 1.0f;
-                  float scaleY = (dims.height > maxHeight) ? (float)maxHeight / dims.height : 1.0f;
-                  float scale = (scaleX < scaleY) ? scaleX : scaleY;
-                  if (scale > 1.0f) scale = 1.0f;
-
-                  displayWidth = (int)(dims.width * scale);
-                  displayHeight = (int)(dims.height * scale);
-                  LOG_DBG("EHP", "Display size: %dx%d (scale %.2f)", displayWidth, displayHeight, scale);
-                }
 
                 // Flush any pending text block so it appears before the image
-                if (self->partWordBufferIndex > 0) {
-                  self->flushPartWordBuffer();
+                if (self->wordTokenizer.hasPendingWord()) {
+                  self->wordTokenizer.flush();
                 }
-                if (self->currentTextBlock && !self->currentTextBlock->isEmpty()) {
-                  const BlockStyle parentBlockStyle = self->currentTextBlock->getBlockStyle();
+                if (self->currentTextBlock && self->paragraphHasWords()) {
+                  const CssBlockStyle parentBlockStyle = self->currentBlockStyle;
                   self->startNewTextBlock(parentBlockStyle);
                 }
 
-                // Create page for image - only break if image won't fit remaining space
-                if (self->currentPage && !self->currentPage->elements.empty() &&
-                    (self->currentPageNextY + displayHeight > self->viewportHeight)) {
-                  self->completePageFn(std::move(self->currentPage), self->xpathParagraphIndex);
-                  self->completedPageCount++;
-                  self->currentPage.reset(new Page());
-                  if (!self->currentPage) {
-                    LOG_ERR("EHP", "Failed to create new page");
-                    return;
-                  }
-                  self->currentPageNextY = 0;
-                } else if (!self->currentPage) {
-                  self->currentPage.reset(new Page());
-                  if (!self->currentPage) {
-                    LOG_ERR("EHP", "Failed to create initial page");
-                    return;
-                  }
-                  self->currentPageNextY = 0;
-                }
-
-                // Create ImageBlock and add to page
-                auto imageBlock = std::make_shared<ImageBlock>(cachedImagePath, displayWidth, displayHeight);
-                if (!imageBlock) {
-                  LOG_ERR("EHP", "Failed to create ImageBlock");
-                  return;
-                }
-                int xPos = (self->viewportWidth - displayWidth) / 2;
-                auto pageImage = std::make_shared<PageImage>(imageBlock, xPos, self->currentPageNextY);
-                if (!pageImage) {
-                  LOG_ERR("EHP", "Failed to create PageImage");
-                  return;
-                }
-                self->currentPage->elements.push_back(pageImage);
-                self->currentPageNextY += displayHeight;
+                self->emitImage(cachedImagePath, resolvedPath, dims, imgStyle);
 
                 self->depth += 1;
                 return;
@@ -533,8 +522,8 @@ void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char*
 
     if (isInternalLink) {
       // Flush buffer before style change
-      if (self->partWordBufferIndex > 0) {
-        self->flushPartWordBuffer();
+      if (self->wordTokenizer.hasPendingWord()) {
+        self->wordTokenizer.flush();
         self->nextWordContinues = true;
       }
       self->insideFootnoteLink = true;
@@ -559,13 +548,12 @@ void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char*
     }
   }
 
-  const float emSize = static_cast<float>(self->renderer.getFontAscenderSize(self->fontId));
-  const auto userAlignmentBlockStyle = BlockStyle::fromCssStyle(
-      cssStyle, emSize, static_cast<CssTextAlign>(self->paragraphAlignment), self->viewportWidth);
+  const auto userAlignmentBlockStyle =
+      CssBlockStyle::fromCssStyle(cssStyle, static_cast<CssTextAlign>(self->paragraphAlignment));
 
   if (matches(name, HEADER_TAGS, NUM_HEADER_TAGS)) {
     self->currentCssStyle = cssStyle;
-    auto headerBlockStyle = BlockStyle::fromCssStyle(cssStyle, emSize, CssTextAlign::Center, self->viewportWidth);
+    auto headerBlockStyle = CssBlockStyle::fromCssStyle(cssStyle, CssTextAlign::Center);
     headerBlockStyle.textAlignDefined = true;
     if (self->embeddedStyle && cssStyle.hasTextAlign()) {
       headerBlockStyle.alignment = cssStyle.textAlign;
@@ -575,11 +563,12 @@ void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char*
     self->updateEffectiveInlineStyle();
   } else if (matches(name, BLOCK_TAGS, NUM_BLOCK_TAGS)) {
     if (strcmp(name, "br") == 0) {
-      if (self->partWordBufferIndex > 0) {
+      if (self->wordTokenizer.hasPendingWord()) {
         // flush word preceding <br/> to currentTextBlock before calling startNewTextBlock
-        self->flushPartWordBuffer();
+        self->wordTokenizer.flush();
       }
-      self->startNewTextBlock(self->currentTextBlock->getBlockStyle());
+      const CssBlockStyle blockStyle = self->currentBlockStyle;
+      self->startNewTextBlock(blockStyle);
     } else {
       self->currentCssStyle = cssStyle;
       self->startNewTextBlock(userAlignmentBlockStyle);
@@ -591,8 +580,8 @@ void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char*
     }
   } else if (matches(name, UNDERLINE_TAGS, NUM_UNDERLINE_TAGS)) {
     // Flush buffer before style change so preceding text gets current style
-    if (self->partWordBufferIndex > 0) {
-      self->flushPartWordBuffer();
+    if (self->wordTokenizer.hasPendingWord()) {
+      self->wordTokenizer.flush();
       self->nextWordContinues = true;
     }
     self->underlineUntilDepth = std::min(self->underlineUntilDepth, self->depth);
@@ -613,8 +602,8 @@ void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char*
     self->updateEffectiveInlineStyle();
   } else if (matches(name, BOLD_TAGS, NUM_BOLD_TAGS)) {
     // Flush buffer before style change so preceding text gets current style
-    if (self->partWordBufferIndex > 0) {
-      self->flushPartWordBuffer();
+    if (self->wordTokenizer.hasPendingWord()) {
+      self->wordTokenizer.flush();
       self->nextWordContinues = true;
     }
     self->boldUntilDepth = std::min(self->boldUntilDepth, self->depth);
@@ -635,8 +624,8 @@ void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char*
     self->updateEffectiveInlineStyle();
   } else if (matches(name, ITALIC_TAGS, NUM_ITALIC_TAGS)) {
     // Flush buffer before style change so preceding text gets current style
-    if (self->partWordBufferIndex > 0) {
-      self->flushPartWordBuffer();
+    if (self->wordTokenizer.hasPendingWord()) {
+      self->wordTokenizer.flush();
       self->nextWordContinues = true;
     }
     self->italicUntilDepth = std::min(self->italicUntilDepth, self->depth);
@@ -659,8 +648,8 @@ void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char*
     // Handle span and other inline elements for CSS styling
     if (cssStyle.hasFontWeight() || cssStyle.hasFontStyle() || cssStyle.hasTextDecoration()) {
       // Flush buffer before style change so preceding text gets current style
-      if (self->partWordBufferIndex > 0) {
-        self->flushPartWordBuffer();
+      if (self->wordTokenizer.hasPendingWord()) {
+        self->wordTokenizer.flush();
         self->nextWordContinues = true;
       }
       StyleStackEntry entry;
@@ -727,135 +716,27 @@ void XMLCALL ChapterHtmlSlimParser::characterData(void* userData, const XML_Char
     self->currentFootnote.number[self->currentFootnoteLinkTextLen] = '\0';
   }
 
-  for (int i = 0; i < len; i++) {
-    if (isWhitespace(s[i])) {
-      // Currently looking at whitespace, if there's anything in the partWordBuffer, flush it
-      if (self->partWordBufferIndex > 0) {
-        self->flushPartWordBuffer();
-      }
-      // Whitespace is a real word boundary — reset continuation state
-      self->nextWordContinues = false;
-      // Skip the whitespace char
-      continue;
-    }
-
-    // Detect U+00A0 (non-breaking space, UTF-8: 0xC2 0xA0) or
-    //        U+202F (narrow no-break space, UTF-8: 0xE2 0x80 0xAF).
-    //
-    // Both are rendered as a visible space but must never allow a line break around them.
-    // We split the no-break space into its own word token and link the surrounding words
-    // with continuation flags so the layout engine treats them as an indivisible group.
-    //
-    // Example: "200&#xA0;Quadratkilometer" or "200&#x202F;Quadratkilometer"
-    //   Input bytes:  "200\xC2\xA0Quadratkilometer"  (or 0xE2 0x80 0xAF for U+202F)
-    //   Tokens produced:
-    //     [0] "200"               continues=false
-    //     [1] " "                 continues=true   (attaches to "200", no gap)
-    //     [2] "Quadratkilometer"  continues=true   (attaches to " ", no gap)
-    //
-    //   The continuation flags prevent the line-breaker from inserting a line break
-    //   between "200" and "Quadratkilometer". However, "Quadratkilometer" is now a
-    //   standalone word for hyphenation purposes, so Liang patterns can produce
-    //   "200 Quadrat-" / "kilometer" instead of the unusable "200" / "Quadratkilometer".
-    if (static_cast<uint8_t>(s[i]) == 0xC2 && i + 1 < len && static_cast<uint8_t>(s[i + 1]) == 0xA0) {
-      if (self->partWordBufferIndex > 0) {
-        self->flushPartWordBuffer();
-      }
-
-      self->partWordBuffer[0] = ' ';
-      self->partWordBuffer[1] = '\0';
-      self->partWordBufferIndex = 1;
-      self->nextWordContinues = true;  // Attach space to previous word (no break).
-      self->flushPartWordBuffer();
-
-      self->nextWordContinues = true;  // Next real word attaches to this space (no break).
-
-      i++;  // Skip the second byte (0xA0)
-      continue;
-    }
-
-    // U+202F (narrow no-break space) — identical logic to U+00A0 above.
-    if (static_cast<uint8_t>(s[i]) == 0xE2 && i + 2 < len && static_cast<uint8_t>(s[i + 1]) == 0x80 &&
-        static_cast<uint8_t>(s[i + 2]) == 0xAF) {
-      if (self->partWordBufferIndex > 0) {
-        self->flushPartWordBuffer();
-      }
-
-      self->partWordBuffer[0] = ' ';
-      self->partWordBuffer[1] = '\0';
-      self->partWordBufferIndex = 1;
-      self->nextWordContinues = true;
-      self->flushPartWordBuffer();
-
-      self->nextWordContinues = true;
-
-      i += 2;  // Skip the remaining two bytes (0x80 0xAF)
-      continue;
-    }
-
-    // Skip Zero Width No-Break Space / BOM (U+FEFF) = 0xEF 0xBB 0xBF
-    const XML_Char FEFF_BYTE_1 = static_cast<XML_Char>(0xEF);
-    const XML_Char FEFF_BYTE_2 = static_cast<XML_Char>(0xBB);
-    const XML_Char FEFF_BYTE_3 = static_cast<XML_Char>(0xBF);
-
-    if (s[i] == FEFF_BYTE_1) {
-      // Check if the next two bytes complete the 3-byte sequence
-      if ((i + 2 < len) && (s[i + 1] == FEFF_BYTE_2) && (s[i + 2] == FEFF_BYTE_3)) {
-        // Sequence 0xEF 0xBB 0xBF found!
-        i += 2;    // Skip the next two bytes
-        continue;  // Move to the next iteration
-      }
-    }
-
-    // If we're about to run out of space, then cut the word off and start a new one.
-    // For CJK text (no spaces), this is the primary word-breaking mechanism.
-    // We must avoid splitting multi-byte UTF-8 sequences across word boundaries,
-    // otherwise the trailing bytes become orphaned continuation bytes that the
-    // decoder can't interpret.
-    if (self->partWordBufferIndex >= MAX_WORD_SIZE) {
-      int safeLen = utf8SafeTruncateBuffer(self->partWordBuffer, self->partWordBufferIndex);
-
-      if (safeLen < self->partWordBufferIndex && safeLen > 0) {
-        // Incomplete UTF-8 sequence at the end — save it before flushing
-        int overflow = self->partWordBufferIndex - safeLen;
-        char saved[4];
-        for (int j = 0; j < overflow; j++) {
-          saved[j] = self->partWordBuffer[safeLen + j];
-        }
-        self->partWordBufferIndex = safeLen;
-        self->flushPartWordBuffer();
-        for (int j = 0; j < overflow; j++) {
-          self->partWordBuffer[j] = saved[j];
-        }
-        self->partWordBufferIndex = overflow;
-      } else {
-        self->flushPartWordBuffer();
-      }
-    }
+  // Words are split off at whitespace, and U+00A0 (non-breaking space) and U+202F (narrow no-break space) become
+  // words of their own, linked to their neighbours with continuation flags (see noBreakSpace())
+  self->wordTokenizer.feed(s, static_cast<size_t>(len));
 
-    self->partWordBuffer[self->partWordBufferIndex++] = s[i];
-  }
-
-  // If we have > 750 words buffered up, perform the layout and consume out all but the last line
-  // There should be enough here to build out 1-2 full pages and doing this will free up a lot of
-  // memory.
+  // If we have > 750 words buffered up, hand them to the layout stage, which lays out all but the last line.
+  // Doing this will free up a lot of memory.
   // Spotted when reading Intermezzo, there are some really long text blocks in there.
   if (self->currentTextBlock->size() > 750) {
     LOG_DBG("EHP", "Text block too long, splitting into multiple pages");
-    const int horizontalInset = self->currentTextBlock->getBlockStyle().totalHorizontalInset();
-    const uint16_t effectiveWidth = (horizontalInset < self->viewportWidth)
-                                        ? static_cast<uint16_t>(self->viewportWidth - horizontalInset)
-                                        : self->viewportWidth;
-    self->currentTextBlock->layoutAndExtractLines(
-        self->renderer, self->fontId, effectiveWidth,
-        [self](const std::shared_ptr<TextBlock>& textBlock) { self->addLineToPage(textBlock); }, false);
+    self->emitParagraph(false);
   }
 }
 
 void XMLCALL ChapterHtmlSlimParser::defaultHandlerExpand(void* userData, const XML_Char* s, const int len) {
   // Check if this looks like an entity reference (&...;)
   if (len >= 3 && s[0] == '&' && s[len - 1] == ';') {
-    const char* utf8Value = lookupHtmlEntity(s, static_cast<size_t>(len));
+    // The handful of entities most books use before the full table
+    const char* utf8Value = lookupCommonHtmlEntity(s, static_cast<size_t>(len));
+    if (utf8Value == nullptr) {
+      utf8Value = lookupHtmlEntity(s, static_cast<size_t>(len));
+    }
     if (utf8Value != nullptr) {
       // Known entity: expand to its UTF-8 value
       characterData(userData, utf8Value, strlen(utf8Value));
@@ -872,7 +753,7 @@ void XMLCALL ChapterHtmlSlimParser::endElement(void* userData, const XML_Char* n
   auto* self = static_cast<ChapterHtmlSlimParser*>(userData);
 
   // Check if any style state will change after we decrement depth
-  // If so, we MUST flush the partWordBuffer with the CURRENT style first
+  // If so, we MUST flush the pending word with the CURRENT style first
   // Note: depth hasn't been decremented yet, so we check against (depth - 1)
   const bool willPopStyleStack =
       !self->inlineStyleStack.empty() && self->inlineStyleStack.back().depth == self->depth - 1;
@@ -886,14 +767,14 @@ void XMLCALL ChapterHtmlSlimParser::endElement(void* userData, const XML_Char* n
 
   if (self->tableDepth > 1 && strcmp(name, "table") == 0) {
     // get rid of all text inside the nested table
-    self->partWordBufferIndex = 0;
+    self->wordTokenizer.discard();
     self->tableDepth -= 1;
     LOG_DBG("EHP", "nested table detected, get rid of its content");
     return;
   }
 
   // Flush buffer with current style BEFORE any style changes
-  if (self->partWordBufferIndex > 0) {
+  if (self->wordTokenizer.hasPendingWord()) {
     // Flush if style will change OR if we're closing a block/structural element
     const bool isInlineTag =
         !headerOrBlockTag && !tableStructuralTag && !matches(name, IMAGE_TAGS, NUM_IMAGE_TAGS) && self->depth != 1;
@@ -903,7 +784,7 @@ void XMLCALL ChapterHtmlSlimParser::endElement(void* userData, const XML_Char* n
                              matches(name, IMAGE_TAGS, NUM_IMAGE_TAGS) || self->depth == 1;
 
     if (shouldFlush) {
-      self->flushPartWordBuffer();
+      self->wordTokenizer.flush();
       // If closing an inline element, the next word fragment continues the same visual word
       if (isInlineTag) {
         self->nextWordContinues = true;
@@ -922,7 +803,7 @@ void XMLCALL ChapterHtmlSlimParser::endElement(void* userData, const XML_Char* n
       strncpy(entry.href, self->currentFootnote.href, sizeof(entry.href) - 1);
       entry.href[sizeof(entry.href) - 1] = '\0';
       int wordIndex =
-          self->wordsExtractedInBlock + (self->currentTextBlock ? static_cast<int>(self->currentTextBlock->size()) : 0);
+          self->wordsShippedInBlock + (self->currentTextBlock ? static_cast<int>(self->currentTextBlock->size()) : 0);
       self->pendingFootnotes.push_back({wordIndex, entry});
     }
     self->insideFootnoteLink = false;
@@ -980,19 +861,18 @@ void XMLCALL ChapterHtmlSlimParser::endElement(void* userData, const XML_Char* n
     // Center) followed by an image-only <p> causes Center to persist through the chain
     // of empty block reuse into subsequent text paragraphs.
     // Margins/padding are preserved so parent element spacing still accumulates correctly.
-    if (self->currentTextBlock && self->currentTextBlock->isEmpty()) {
-      auto style = self->currentTextBlock->getBlockStyle();
+    if (self->currentTextBlock && !self->paragraphHasWords()) {
+      auto& style = self->currentBlockStyle;
       style.textAlignDefined = false;
       style.alignment = (self->paragraphAlignment == static_cast<uint8_t>(CssTextAlign::None))
                             ? CssTextAlign::Justify
                             : static_cast<CssTextAlign>(self->paragraphAlignment);
-      self->currentTextBlock->setBlockStyle(style);
     }
   }
 }
 
 bool ChapterHtmlSlimParser::parseAndBuildPages() {
-  auto paragraphAlignmentBlockStyle = BlockStyle();
+  auto paragraphAlignmentBlockStyle = CssBlockStyle();
   paragraphAlignmentBlockStyle.textAlignDefined = true;
   // Resolve None sentinel to Justify for initial block (no CSS context yet)
   const auto align = (this->paragraphAlignment == static_cast<uint8_t>(CssTextAlign::None))
@@ -1001,7 +881,7 @@ bool ChapterHtmlSlimParser::parseAndBuildPages() {
   paragraphAlignmentBlockStyle.alignment = align;
   startNewTextBlock(paragraphAlignmentBlockStyle);
 
-  XML_Parser parser = XML_ParserCreate(nullptr);
+  XML_Parser parser = createXmlParser();
   int done;
 
   if (!parser) {
@@ -1030,10 +910,12 @@ bool ChapterHtmlSlimParser::parseAndBuildPages() {
 
   // Compute the time taken to parse and build pages
   const uint32_t chapterStartTime = millis();
+  const bool pipelined = startLayoutTask();
   do {
     void* const buf = XML_GetBuffer(parser, PARSE_BUFFER_SIZE);
     if (!buf) {
       LOG_ERR("EHP", "Couldn't allocate memory for buffer");
+      stopLayoutTask(true);
       destroyXmlParser(parser);
       file.close();
       return false;
@@ -1043,6 +925,7 @@ bool ChapterHtmlSlimParser::parseAndBuildPages() {
 
     if (len == 0 && file.available() > 0) {
       LOG_ERR("EHP", "File read error");
+      stopLayoutTask(true);
       destroyXmlParser(parser);
       file.close();
       return false;
@@ -1053,113 +936,91 @@ bool ChapterHtmlSlimParser::parseAndBuildPages() {
     if (XML_ParseBuffer(parser, static_cast<int>(len), done) == XML_STATUS_ERROR) {
       LOG_ERR("EHP", "Parse error at line %lu:\n%s", XML_GetCurrentLineNumber(parser),
               XML_ErrorString(XML_GetErrorCode(parser)));
+      stopLayoutTask(true);
       destroyXmlParser(parser);
       file.close();
       return false;
     }
   } while (!done);
-  LOG_DBG("EHP", "Time to parse and build pages: %lu ms", millis() - chapterStartTime);
 
   destroyXmlParser(parser);
   file.close();
 
   // Process last page if there is still text
   if (currentTextBlock) {
-    makePages();
-    if (!pendingAnchorId.empty()) {
-      anchorData.push_back({std::move(pendingAnchorId), static_cast<uint16_t>(completedPageCount)});
-      pendingAnchorId.clear();
-    }
-    completePageFn(std::move(currentPage), xpathParagraphIndex);
-    completedPageCount++;
-    currentPage.reset();
+    emitParagraph(true);
+    emitPendingAnchor();
+    emitEnd();
     currentTextBlock.reset();
   }
+  stopLayoutTask(false);
+  LOG_DBG("EHP", "Time to parse and build pages: %lu ms%s", millis() - chapterStartTime,
+          pipelined ? " (layout on its own task)" : "");
 
   return true;
 }
 
-void ChapterHtmlSlimParser::addLineToPage(std::shared_ptr<TextBlock> line) {
-  const int lineHeight = renderer.getLineHeight(fontId) * lineCompression;
-
-  if (!currentPage) {
-    currentPage.reset(new Page());
-    currentPageNextY = 0;
-  }
-
-  if (currentPageNextY + lineHeight > viewportHeight) {
-    completePageFn(std::move(currentPage), xpathParagraphIndex);
-    completedPageCount++;
-    currentPage.reset(new Page());
-    currentPageNextY = 0;
+bool ChapterHtmlSlimParser::startLayoutTask() {
+  if (layoutPipelineDepth == 0) {
+    return false;
   }
-
-  // Track cumulative words to assign footnotes to the page containing their anchor
-  wordsExtractedInBlock += line->wordCount();
-  auto footnoteIt = pendingFootnotes.begin();
-  while (footnoteIt != pendingFootnotes.end() && footnoteIt->first <= wordsExtractedInBlock) {
-    currentPage->addFootnote(footnoteIt->second.number, footnoteIt->second.href);
-    ++footnoteIt;
+  if (ESP.getFreeHeap() < MIN_FREE_HEAP_FOR_LAYOUT_TASK) {
+    LOG_DBG("EHP", "Low heap (%u bytes), laying out pages inline", ESP.getFreeHeap());
+    return false;
   }
-  pendingFootnotes.erase(pendingFootnotes.begin(), footnoteIt);
-
-  // Apply horizontal left inset (margin + padding) as x position offset
-  const int16_t xOffset = line->getBlockStyle().leftInset();
-  currentPage->elements.push_back(std::make_shared<PageLine>(line, xOffset, currentPageNextY));
-  currentPageNextY += lineHeight;
-}
 
-void ChapterHtmlSlimParser::makePages() {
-  if (!currentTextBlock) {
-    LOG_ERR("EHP", "!! No text block to make pages for !!");
-    return;
+  layoutRing.reset(new (std::nothrow) ParagraphRing<ChapterPageBuilder::Item>(layoutPipelineDepth));
+  layoutTaskStopped = xSemaphoreCreateBinary();
+  if (!layoutRing || !layoutRing->allocate() || !layoutTaskStopped) {
+    LOG_ERR("EHP", "Failed to allocate the layout pipeline, laying out pages inline");
+    stopLayoutTask(true);
+    return false;
   }
 
-  if (!currentPage) {
-    currentPage.reset(new Page());
-    currentPageNextY = 0;
+  // Same priority as the parser, so each runs while the other waits on the SD card or the ring
+  xTaskCreate(&layoutTaskTrampoline, "EpubLayout",
+              LAYOUT_TASK_STACK_SIZE,      // Stack size
+              this,                        // Parameters
+              uxTaskPriorityGet(nullptr),  // Priority
+              &layoutTask                  // Task handle
+  );
+  if (!layoutTask) {
+    LOG_ERR("EHP", "Failed to create layout task, laying out pages inline");
+    stopLayoutTask(true);
+    return false;
   }
+  return true;
+}
 
-  const int lineHeight = renderer.getLineHeight(fontId) * lineCompression;
-
-  // Apply top spacing before the paragraph (stored in pixels)
-  const BlockStyle& blockStyle = currentTextBlock->getBlockStyle();
-  if (blockStyle.marginTop > 0) {
-    currentPageNextY += blockStyle.marginTop;
+// Wait for the layout task to finish the items already queued (or drop them when discarding), then free the ring
+void ChapterHtmlSlimParser::stopLayoutTask(const bool discard) {
+  if (layoutTask) {
+    if (discard) {
+      layoutRing->abort();
+    } else {
+      layoutRing->close();
+    }
+    xSemaphoreTake(layoutTaskStopped, portMAX_DELAY);
+    layoutTask = nullptr;
   }
-  if (blockStyle.paddingTop > 0) {
-    currentPageNextY += blockStyle.paddingTop;
+  if (layoutTaskStopped) {
+    vSemaphoreDelete(layoutTaskStopped);
+    layoutTaskStopped = nullptr;
   }
+  layoutRing.reset();
+}
 
-  // Calculate effective width accounting for horizontal margins/padding
-  const int horizontalInset = blockStyle.totalHorizontalInset();
-  const uint16_t effectiveWidth =
-      (horizontalInset < viewportWidth) ? static_cast<uint16_t>(viewportWidth - horizontalInset) : viewportWidth;
-
-  currentTextBlock->layoutAndExtractLines(
-      renderer, fontId, effectiveWidth,
-      [this](const std::shared_ptr<TextBlock>& textBlock) { addLineToPage(textBlock); });
-
-  // Fallback: transfer any remaining pending footnotes to current page.
-  // Normally addLineToPage handles this via word-index tracking, but this catches
-  // edge cases where a footnote's word index equals the exact block size.
-  if (!pendingFootnotes.empty() && currentPage) {
-    for (const auto& [idx, fn] : pendingFootnotes) {
-      currentPage->addFootnote(fn.number, fn.href);
-    }
-    pendingFootnotes.clear();
-  }
+void ChapterHtmlSlimParser::layoutTaskTrampoline(void* param) {
+  auto* self = static_cast<ChapterHtmlSlimParser*>(param);
+  self->layoutTaskLoop();
+}
 
-  // Apply bottom spacing after the paragraph (stored in pixels)
-  if (blockStyle.marginBottom > 0) {
-    currentPageNextY += blockStyle.marginBottom;
-  }
-  if (blockStyle.paddingBottom > 0) {
-    currentPageNextY += blockStyle.paddingBottom;
+void ChapterHtmlSlimParser::layoutTaskLoop() {
+  while (ChapterPageBuilder::Item* item = layoutRing->next()) {
+    pageBuilder.process(*item);
+    layoutRing->release();
   }
 
-  // Extra paragraph spacing if enabled (default behavior)
-  if (extraParagraphSpacing) {
-    currentPageNextY += lineHeight / 2;
-  }
+  xSemaphoreGive(layoutTaskStopped);
+  vTaskDelete(nullptr);
 }
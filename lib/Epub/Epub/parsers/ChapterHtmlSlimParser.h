@@ -1,6 +1,9 @@
 #pragma once
 
 #include <expat.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 
 #include <climits>
 #include <functional>
@@ -10,42 +13,37 @@
 
 #include "../FootnoteEntry.h"
 #include "../ParsedText.h"
+#include "../blocks/BlockStyle.h"
 #include "../blocks/ImageBlock.h"
 #include "../blocks/TextBlock.h"
+#include "../converters/ImageToFramebufferDecoder.h"
 #include "../css/CssParser.h"
 #include "../css/CssStyle.h"
+#include "ChapterPageBuilder.h"
+#include "ParagraphRing.h"
+#include "TextRunTokenizer.h"
 
 class Page;
 class GfxRenderer;
 class Epub;
 
-#define MAX_WORD_SIZE 200
-
-class ChapterHtmlSlimParser {
+class ChapterHtmlSlimParser final : TextRunTokenizer::Sink {
   std::shared_ptr<Epub> epub;
   const std::string& filepath;
-  GfxRenderer& renderer;
-  std::function<void(std::unique_ptr<Page>, uint16_t)> completePageFn;
   std::function<void()> popupFn;  // Popup callback
   int depth = 0;
   int skipUntilDepth = INT_MAX;
   int boldUntilDepth = INT_MAX;
   int italicUntilDepth = INT_MAX;
   int underlineUntilDepth = INT_MAX;
-  // buffer for building up words from characters, will auto break if longer than this
-  // leave one char at end for null pointer
-  char partWordBuffer[MAX_WORD_SIZE + 1] = {};
-  int partWordBufferIndex = 0;
+  // splits character data into words; holds a word that continues into the next callback
+  TextRunTokenizer wordTokenizer{*this};
   bool nextWordContinues = false;  // true when next flushed word attaches to previous (inline element boundary)
   std::unique_ptr<ParsedText> currentTextBlock = nullptr;
-  std::unique_ptr<Page> currentPage = nullptr;
-  int16_t currentPageNextY = 0;
-  int fontId;
-  float lineCompression;
+  CssBlockStyle currentBlockStyle;  // Of currentTextBlock
+  int wordsShippedInBlock = 0;  // Words of the current paragraph already handed to the layout stage
   bool extraParagraphSpacing;
   uint8_t paragraphAlignment;
-  uint16_t viewportWidth;
-  uint16_t viewportHeight;
   bool hyphenationEnabled;
   const CssParser* cssParser;
   bool embeddedStyle;
@@ -70,9 +68,6 @@ class ChapterHtmlSlimParser {
   int tableRowIndex = 0;
   int tableColIndex = 0;
 
-  // Anchor-to-page mapping: tracks which page each HTML id attribute lands on
-  int completedPageCount = 0;
-  std::vector<std::pair<std::string, uint16_t>> anchorData;
   std::string pendingAnchorId;  // deferred until after previous text block is flushed
   uint16_t xpathParagraphIndex = 0;
 
@@ -81,13 +76,35 @@ class ChapterHtmlSlimParser {
   int footnoteLinkDepth = -1;
   FootnoteEntry currentFootnote = {};
   int currentFootnoteLinkTextLen = 0;
-  std::vector<std::pair<int, FootnoteEntry>> pendingFootnotes;  // <wordIndex, entry>
-  int wordsExtractedInBlock = 0;
+  std::vector<std::pair<int, FootnoteEntry>> pendingFootnotes;  // <wordIndex, entry>, of the current paragraph
+
+  // Layout stage: runs on its own task, behind a ring of `layoutPipelineDepth` items, or inline when that is 0
+  ChapterPageBuilder pageBuilder;
+  uint8_t layoutPipelineDepth = 0;
+  ChapterPageBuilder::Item inlineLayoutItem;
+  std::unique_ptr<ParagraphRing<ChapterPageBuilder::Item>> layoutRing;
+  TaskHandle_t layoutTask = nullptr;
+  SemaphoreHandle_t layoutTaskStopped = nullptr;
+  FsFile* itemCacheFile = nullptr;
 
   void updateEffectiveInlineStyle();
-  void startNewTextBlock(const BlockStyle& blockStyle);
-  void flushPartWordBuffer();
-  void makePages();
+  bool paragraphHasWords() const { return wordsShippedInBlock > 0 || !currentTextBlock->isEmpty(); }
+  void startNewTextBlock(const CssBlockStyle& blockStyle);
+  ChapterPageBuilder::Item* acquireLayoutItem();
+  void submitLayoutItem(const ChapterPageBuilder::Item& item);
+  void emitParagraph(bool endsParagraph);
+  void emitPendingAnchor();
+  void emitImage(const std::string& path, const std::string& source, const ImageDimensions& dims,
+                 const CssStyle& imgStyle);
+  void emitEnd();
+  bool startLayoutTask();
+  void stopLayoutTask(bool discard);
+  static void layoutTaskTrampoline(void* param);
+  void layoutTaskLoop();
+  // TextRunTokenizer::Sink
+  void addWord(const char* word, size_t length) override;
+  void wordBreak() override;
+  void noBreakSpace() override;
   // XML callbacks
   static void XMLCALL startElement(void* userData, const XML_Char* name, const XML_Char** atts);
   static void XMLCALL characterData(void* userData, const XML_Char* s, int len);
@@ -106,24 +123,26 @@ class ChapterHtmlSlimParser {
 
       : epub(epub),
         filepath(filepath),
-        renderer(renderer),
-        fontId(fontId),
-        lineCompression(lineCompression),
         extraParagraphSpacing(extraParagraphSpacing),
         paragraphAlignment(paragraphAlignment),
-        viewportWidth(viewportWidth),
-        viewportHeight(viewportHeight),
         hyphenationEnabled(hyphenationEnabled),
-        completePageFn(completePageFn),
         popupFn(popupFn),
         cssParser(cssParser),
         embeddedStyle(embeddedStyle),
         imageRendering(imageRendering),
         contentBase(contentBase),
-        imageBasePath(imageBasePath) {}
+        imageBasePath(imageBasePath),
+        pageBuilder(renderer, fontId, lineCompression, extraParagraphSpacing, viewportWidth, viewportHeight,
+                    hyphenationEnabled, completePageFn) {}
 
   ~ChapterHtmlSlimParser() = default;
+  // Lay out pages on a separate task, up to `depth` paragraphs behind the parser (0, the default: inline). Pages
+  // and anchors come out the same either way; completePageFn is then called on the layout task.
+  void setLayoutPipelineDepth(const uint8_t depth) { layoutPipelineDepth = depth; }
+  // Also write every item handed to the layout stage to `file` (see ChapterPageBuilder::Item::serialize()), for the
+  // chapter to be laid out again without parsing it. Stops at the first item that can't be written.
+  void setItemCacheFile(FsFile* file) { itemCacheFile = file; }
+  bool isItemCacheComplete() const { return itemCacheFile != nullptr; }
   bool parseAndBuildPages();
-  void addLineToPage(std::shared_ptr<TextBlock> line);
-  const std::vector<std::pair<std::string, uint16_t>>& getAnchors() const { return anchorData; }
+  const std::vector<std::pair<std::string, uint16_t>>& getAnchors() const { return pageBuilder.getAnchors(); }
 };
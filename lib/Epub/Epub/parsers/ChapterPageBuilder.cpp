@@ -0,0 +1,370 @@
+#include "ChapterPageBuilder.h"
+
+#include <GfxRenderer.h>
+#include <Logging.h>
+#include <Serialization.h>
+
+#include <cstring>
+
+#include "../Page.h"
+#include "../converters/ImageToFramebufferDecoder.h"
+
+void ChapterPageBuilder::process(Item& item) {
+  paragraphIndex = item.paragraphIndex;
+
+  switch (item.kind) {
+    case Item::Kind::Paragraph:
+      addParagraph(item);
+      break;
+    case Item::Kind::Image:
+      addImage(item);
+      break;
+    case Item::Kind::Anchor:
+      anchorData.push_back({std::move(item.name), static_cast<uint16_t>(completedPageCount)});
+      break;
+    case Item::Kind::End:
+      completePageFn(std::move(currentPage), paragraphIndex);
+      completedPageCount++;
+      currentPage.reset();
+      break;
+  }
+}
+
+void ChapterPageBuilder::addParagraph(Item& item) {
+  if (!paragraphOpen) {
+    paragraph.setBlockStyle(item.style.resolve(emSize(), viewportWidth));
+    wordsExtractedInBlock = 0;
+    paragraphOpen = true;
+  }
+  paragraph.takeWords(item.text);
+  pendingFootnotes.insert(pendingFootnotes.end(), item.footnotes.begin(), item.footnotes.end());
+  item.footnotes.clear();
+
+  if (item.endsParagraph) {
+    makePages();
+    paragraphOpen = false;
+    return;
+  }
+
+  // Lay out all but the last line, which the words of the next part may still go on, to free up the memory the words
+  // take. There should be enough here to build out 1-2 full pages.
+  paragraph.layoutAndExtractLines(
+      renderer, fontId, effectiveWidth(paragraph.getBlockStyle()),
+      [this](const std::shared_ptr<TextBlock>& textBlock) { addLineToPage(textBlock); }, false);
+}
+
+void ChapterPageBuilder::addImage(const Item& item) {
+  int displayWidth = 0;
+  int displayHeight = 0;
+  imageDisplaySize(item, displayWidth, displayHeight);
+
+  // Create page for image - only break if image won't fit remaining space
+  if (currentPage && !currentPage->elements.empty() && (currentPageNextY + displayHeight > viewportHeight)) {
+    completePage();
+  } else if (!currentPage) {
+    currentPage.reset(new Page());
+    currentPageNextY = 0;
+  }
+
+  auto imageBlock = std::make_shared<ImageBlock>(item.name, displayWidth, displayHeight);
+  const int16_t xPos = (viewportWidth - displayWidth) / 2;
+  currentPage->elements.push_back(std::make_shared<PageImage>(imageBlock, xPos, currentPageNextY));
+  currentPageNextY += displayHeight;
+}
+
+void ChapterPageBuilder::imageDisplaySize(const Item& item, int& displayWidth, int& displayHeight) const {
+  const ImageDimensions dims = {item.imageWidth, item.imageHeight};
+  const float emSize = this->emSize();
+
+  if (item.hasCssHeight && item.hasCssWidth && dims.width > 0 && dims.height > 0) {
+    // Both CSS height and width set: resolve both, then clamp to viewport preserving requested ratio
+    displayHeight = static_cast<int>(item.cssHeight.toPixels(emSize, static_cast<float>(viewportHeight)) + 0.5f);
+    displayWidth = static_cast<int>(item.cssWidth.toPixels(emSize, static_cast<float>(viewportWidth)) + 0.5f);
+    if (displayHeight < 1) displayHeight = 1;
+    if (displayWidth < 1) displayWidth = 1;
+    if (displayWidth > viewportWidth || displayHeight > viewportHeight) {
+      float scaleX = (displayWidth > viewportWidth) ? static_cast<float>(viewportWidth) / displayWidth : 1.0f;
+      float scaleY = (displayHeight > viewportHeight) ? static_cast<float>(viewportHeight) / displayHeight : 1.0f;
+      float scale = (scaleX < scaleY) ? scaleX : scaleY;
+      displayWidth = static_cast<int>(displayWidth * scale + 0.5f);
+      displayHeight = static_cast<int>(displayHeight * scale + 0.5f);
+      if (displayWidth < 1) displayWidth = 1;
+      if (displayHeight < 1) displayHeight = 1;
+    }
+    LOG_DBG("EHP", "Display size from CSS height+width: %dx%d", displayWidth, displayHeight);
+  } else if (item.hasCssHeight && !item.hasCssWidth && dims.width > 0 && dims.height > 0) {
+    // Use CSS height (resolve % against viewport height) and derive width from aspect ratio
+    displayHeight = static_cast<int>(item.cssHeight.toPixels(emSize, static_cast<float>(viewportHeight)) + 0.5f);
+    if (displayHeight < 1) displayHeight = 1;
+    displayWidth = static_cast<int>(displayHeight * (static_cast<float>(dims.width) / dims.height) + 0.5f);
+    if (displayHeight > viewportHeight) {
+      displayHeight = viewportHeight;
+      // Rescale width to preserve aspect ratio when height is clamped
+      displayWidth = static_cast<int>(displayHeight * (static_cast<float>(dims.width) / dims.height) + 0.5f);
+      if (displayWidth < 1) displayWidth = 1;
+    }
+    if (displayWidth > viewportWidth) {
+      displayWidth = viewportWidth;
+      // Rescale height to preserve aspect ratio when width is clamped
+      displayHeight = static_cast<int>(displayWidth * (static_cast<float>(dims.height) / dims.width) + 0.5f);
+      if (displayHeight < 1) displayHeight = 1;
+    }
+    if (displayWidth < 1) displayWidth = 1;
+    LOG_DBG("EHP", "Display size from CSS height: %dx%d", displayWidth, displayHeight);
+  } else if (item.hasCssWidth && !item.hasCssHeight && dims.width > 0 && dims.height > 0) {
+    // Use CSS width (resolve % against viewport width) and derive height from aspect ratio
+    displayWidth = static_cast<int>(item.cssWidth.toPixels(emSize, static_cast<float>(viewportWidth)) + 0.5f);
+    if (displayWidth > viewportWidth) displayWidth = viewportWidth;
+    if (displayWidth < 1) displayWidth = 1;
+    displayHeight = static_cast<int>(displayWidth * (static_cast<float>(dims.height) / dims.width) + 0.5f);
+    if (displayHeight > viewportHeight) {
+      displayHeight = viewportHeight;
+      // Rescale width to preserve aspect ratio when height is clamped
+      displayWidth = static_cast<int>(displayHeight * (static_cast<float>(dims.width) / dims.height) + 0.5f);
+      if (displayWidth < 1) displayWidth = 1;
+    }
+    if (displayHeight < 1) displayHeight = 1;
+    LOG_DBG("EHP", "Display size from CSS width: %dx%d", displayWidth, displayHeight);
+  } else {
+    // Scale to fit viewport while maintaining aspect ratio
+    int maxWidth = viewportWidth;
+    int maxHeight = viewportHeight;
+    float scaleX = (dims.width > maxWidth) ? (float)maxWidth / dims.width : 1.0f;
+    float scaleY = (dims.height > maxHeight) ? (float)maxHeight / dims.height : 1.0f;
+    float scale = (scaleX < scaleY) ? scaleX : scaleY;
+    if (scale > 1.0f) scale = 1.0f;
+
+    displayWidth = (int)(dims.width * scale);
+    displayHeight = (int)(dims.height * scale);
+    LOG_DBG("EHP", "Display size: %dx%d (scale %.2f)", displayWidth, displayHeight, scale);
+  }
+}
+
+void ChapterPageBuilder::makePages() {
+  if (!currentPage) {
+    currentPage.reset(new Page());
+    currentPageNextY = 0;
+  }
+
+  // Apply top spacing before the paragraph (stored in pixels)
+  const BlockStyle& blockStyle = paragraph.getBlockStyle();
+  if (blockStyle.marginTop > 0) {
+    currentPageNextY += blockStyle.marginTop;
+  }
+  if (blockStyle.paddingTop > 0) {
+    currentPageNextY += blockStyle.paddingTop;
+  }
+
+  paragraph.layoutAndExtractLines(renderer, fontId, effectiveWidth(blockStyle),
+                                  [this](const std::shared_ptr<TextBlock>& textBlock) { addLineToPage(textBlock); });
+
+  // Fallback: transfer any remaining pending footnotes to current page.
+  // Normally addLineToPage handles this via word-index tracking, but this catches
+  // edge cases where a footnote's word index equals the exact block size.
+  if (!pendingFootnotes.empty() && currentPage) {
+    for (const auto& [idx, fn] : pendingFootnotes) {
+      currentPage->addFootnote(fn.number, fn.href);
+    }
+    pendingFootnotes.clear();
+  }
+
+  // Apply bottom spacing after the paragraph (stored in pixels)
+  if (blockStyle.marginBottom > 0) {
+    currentPageNextY += blockStyle.marginBottom;
+  }
+  if (blockStyle.paddingBottom > 0) {
+    currentPageNextY += blockStyle.paddingBottom;
+  }
+
+  // Extra paragraph spacing if enabled (default behavior)
+  if (extraParagraphSpacing) {
+    currentPageNextY += lineHeight() / 2;
+  }
+}
+
+void ChapterPageBuilder::addLineToPage(const std::shared_ptr<TextBlock>& line) {
+  const int height = lineHeight();
+
+  if (!currentPage) {
+    currentPage.reset(new Page());
+    currentPageNextY = 0;
+  }
+
+  if (currentPageNextY + height > viewportHeight) {
+    completePage();
+  }
+
+  // Track cumulative words to assign footnotes to the page containing their anchor
+  wordsExtractedInBlock += line->wordCount();
+  auto footnoteIt = pendingFootnotes.begin();
+  while (footnoteIt != pendingFootnotes.end() && footnoteIt->first <= wordsExtractedInBlock) {
+    currentPage->addFootnote(footnoteIt->second.number, footnoteIt->second.href);
+    ++footnoteIt;
+  }
+  pendingFootnotes.erase(pendingFootnotes.begin(), footnoteIt);
+
+  // Apply horizontal left inset (margin + padding) as x position offset
+  const int16_t xOffset = line->getBlockStyle().leftInset();
+  currentPage->elements.push_back(std::make_shared<PageLine>(line, xOffset, currentPageNextY));
+  currentPageNextY += height;
+}
+
+void ChapterPageBuilder::completePage() {
+  completePageFn(std::move(currentPage), paragraphIndex);
+  completedPageCount++;
+  currentPage.reset(new Page());
+  currentPageNextY = 0;
+}
+
+// Width available to the lines of a block, accounting for horizontal margins/padding
+uint16_t ChapterPageBuilder::effectiveWidth(const BlockStyle& blockStyle) const {
+  const int horizontalInset = blockStyle.totalHorizontalInset();
+  return (horizontalInset < viewportWidth) ? static_cast<uint16_t>(viewportWidth - horizontalInset) : viewportWidth;
+}
+
+int ChapterPageBuilder::lineHeight() const { return renderer.getLineHeight(fontId) * lineCompression; }
+
+// The em size CSS lengths resolve against
+float ChapterPageBuilder::emSize() const { return static_cast<float>(renderer.getFontAscenderSize(fontId)); }
+
+namespace {
+// Sanity limits for reading items back: an item cache may be cut short or corrupt
+constexpr uint32_t MAX_PATH_BYTES = 1024;
+constexpr uint16_t MAX_FOOTNOTES_PER_ITEM = 1024;
+
+void writeLength(FsFile& file, const CssLength& length) {
+  serialization::writePod(file, length.value);
+  serialization::writePod(file, length.unit);
+}
+
+bool readLength(FsFile& file, CssLength& length) {
+  return serialization::readPodChecked(file, length.value) && serialization::readPodChecked(file, length.unit) &&
+         length.unit <= CssUnit::Percent;
+}
+
+bool readAlignment(FsFile& file, CssTextAlign& alignment) {
+  return serialization::readPodChecked(file, alignment) && alignment <= CssTextAlign::None;
+}
+
+bool readFootnoteField(FsFile& file, std::string& value, char* field, const size_t fieldSize) {
+  if (!serialization::readStringChecked(file, value, fieldSize - 1)) {
+    return false;
+  }
+  strncpy(field, value.c_str(), fieldSize - 1);
+  field[fieldSize - 1] = '\0';
+  return true;
+}
+}  // namespace
+
+bool ChapterPageBuilder::Item::serialize(FsFile& file) const {
+  serialization::writePod(file, kind);
+  serialization::writePod(file, paragraphIndex);
+
+  switch (kind) {
+    case Kind::Paragraph:
+      serialization::writePod(file, endsParagraph);
+      serialization::writePod(file, static_cast<uint8_t>(style.boxes.size()));
+      for (const auto& box : style.boxes) {
+        writeLength(file, box.marginTop);
+        writeLength(file, box.marginBottom);
+        writeLength(file, box.marginLeft);
+        writeLength(file, box.marginRight);
+        writeLength(file, box.paddingTop);
+        writeLength(file, box.paddingBottom);
+        writeLength(file, box.paddingLeft);
+        writeLength(file, box.paddingRight);
+      }
+      serialization::writePod(file, style.alignment);
+      serialization::writePod(file, style.textAlignDefined);
+      writeLength(file, style.textIndent);
+      serialization::writePod(file, style.textIndentDefined);
+      serialization::writePod(file, static_cast<uint16_t>(footnotes.size()));
+      for (const auto& [wordIndex, footnote] : footnotes) {
+        serialization::writePod(file, wordIndex);
+        serialization::writeString(file, footnote.number);
+        serialization::writeString(file, footnote.href);
+      }
+      return text.serialize(file);
+    case Kind::Image:
+      serialization::writeString(file, name);
+      serialization::writeString(file, source);
+      serialization::writePod(file, imageWidth);
+      serialization::writePod(file, imageHeight);
+      serialization::writePod(file, hasCssWidth);
+      serialization::writePod(file, hasCssHeight);
+      writeLength(file, cssWidth);
+      writeLength(file, cssHeight);
+      return true;
+    case Kind::Anchor:
+      serialization::writeString(file, name);
+      return true;
+    case Kind::End:
+      return true;
+  }
+  return false;
+}
+
+bool ChapterPageBuilder::Item::deserialize(FsFile& file) {
+  if (!serialization::readPodChecked(file, kind) || !serialization::readPodChecked(file, paragraphIndex)) {
+    LOG_ERR("CPB", "Deserialization failed: truncated item");
+    return false;
+  }
+
+  switch (kind) {
+    case Kind::Paragraph: {
+      uint8_t boxCount = 0;
+      if (!serialization::readPodChecked(file, endsParagraph) || !serialization::readPodChecked(file, boxCount)) {
+        break;
+      }
+      style.boxes.resize(boxCount);
+      for (auto& box : style.boxes) {
+        if (!readLength(file, box.marginTop) || !readLength(file, box.marginBottom) ||
+            !readLength(file, box.marginLeft) || !readLength(file, box.marginRight) ||
+            !readLength(file, box.paddingTop) || !readLength(file, box.paddingBottom) ||
+            !readLength(file, box.paddingLeft) || !readLength(file, box.paddingRight)) {
+          LOG_ERR("CPB", "Deserialization failed: bad block style");
+          return false;
+        }
+      }
+      uint16_t footnoteCount = 0;
+      if (!readAlignment(file, style.alignment) || !serialization::readPodChecked(file, style.textAlignDefined) ||
+          !readLength(file, style.textIndent) || !serialization::readPodChecked(file, style.textIndentDefined) ||
+          !serialization::readPodChecked(file, footnoteCount) || footnoteCount > MAX_FOOTNOTES_PER_ITEM) {
+        LOG_ERR("CPB", "Deserialization failed: bad paragraph header");
+        return false;
+      }
+      footnotes.resize(footnoteCount);
+      std::string value;
+      for (auto& [wordIndex, footnote] : footnotes) {
+        if (!serialization::readPodChecked(file, wordIndex) ||
+            !readFootnoteField(file, value, footnote.number, sizeof(footnote.number)) ||
+            !readFootnoteField(file, value, footnote.href, sizeof(footnote.href))) {
+          LOG_ERR("CPB", "Deserialization failed: bad footnote");
+          return false;
+        }
+      }
+      return text.deserialize(file);
+    }
+    case Kind::Image:
+      if (serialization::readStringChecked(file, name, MAX_PATH_BYTES) &&
+          serialization::readStringChecked(file, source, MAX_PATH_BYTES) &&
+          serialization::readPodChecked(file, imageWidth) && serialization::readPodChecked(file, imageHeight) &&
+          serialization::readPodChecked(file, hasCssWidth) && serialization::readPodChecked(file, hasCssHeight) &&
+          readLength(file, cssWidth) && readLength(file, cssHeight)) {
+        return true;
+      }
+      break;
+    case Kind::Anchor:
+      if (serialization::readStringChecked(file, name, MAX_PATH_BYTES)) {
+        return true;
+      }
+      break;
+    case Kind::End:
+      return true;
+    default:
+      LOG_ERR("CPB", "Deserialization failed: unknown item kind %u", static_cast<unsigned>(kind));
+      return false;
+  }
+  LOG_ERR("CPB", "Deserialization failed: truncated or corrupt item");
+  return false;
+}
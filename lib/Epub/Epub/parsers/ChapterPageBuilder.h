@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../FootnoteEntry.h"
+#include "../ParsedText.h"
+#include "../blocks/BlockStyle.h"
+#include "../blocks/TextBlock.h"
+
+class GfxRenderer;
+class Page;
+
+/**
+ * The layout stage of ChapterHtmlSlimParser: breaks the paragraphs the parser collects into lines and stacks them,
+ * and the chapter's images, into Pages.
+ *
+ * The parser describes the chapter as a stream of Items, in document order. Every item is stamped with the paragraph
+ * index the parser had reached when it emitted it, which is what a page completed while processing the item is
+ * tagged with. The builder keeps no reference to an item, so the parser can refill it as soon as process() returns;
+ * that is what lets the two run on different tasks with a ParagraphRing of items in between.
+ *
+ * Items hold nothing that depends on the font or the viewport: lengths stay in CSS units and images at their own
+ * size until the builder resolves them. Section keeps the stream of a chapter in a file, and lays the chapter out
+ * again from it when only those settings change.
+ */
+class ChapterPageBuilder {
+ public:
+  using CompletePageFn = std::function<void(std::unique_ptr<Page>, uint16_t)>;
+
+  struct Item {
+    enum class Kind : uint8_t {
+      // Words of a paragraph. A paragraph too long to hold at once comes in parts, all but the last one with
+      // `endsParagraph` false.
+      Paragraph,
+      // An image on its own, centered
+      Image,
+      // An element id that starts at the next line or image
+      Anchor,
+      // Complete the last page
+      End
+    };
+
+    Kind kind = Kind::Paragraph;
+    uint16_t paragraphIndex = 0;
+    // Paragraph: the words, which the builder takes out, and the block style
+    ParsedText text{false};
+    CssBlockStyle style;
+    bool endsParagraph = true;
+    // Paragraph: footnote links, by the number of words of the paragraph up to the link (counting earlier parts)
+    std::vector<std::pair<int, FootnoteEntry>> footnotes;
+    // Image: the cached image file; Anchor: the id
+    std::string name;
+    // Image: the path of the image in the EPUB, to extract it again if the cached file is gone
+    std::string source;
+    // Image: the size of the image file, and the width and height its CSS asks for, if any
+    int16_t imageWidth = 0;
+    int16_t imageHeight = 0;
+    bool hasCssWidth = false;
+    bool hasCssHeight = false;
+    CssLength cssWidth;
+    CssLength cssHeight;
+
+    bool serialize(FsFile& file) const;
+    // Read into this item, reusing its storage
+    bool deserialize(FsFile& file);
+  };
+
+  ChapterPageBuilder(const GfxRenderer& renderer, int fontId, float lineCompression, bool extraParagraphSpacing,
+                     uint16_t viewportWidth, uint16_t viewportHeight, bool hyphenationEnabled,
+                     CompletePageFn completePageFn)
+      : renderer(renderer),
+        fontId(fontId),
+        lineCompression(lineCompression),
+        extraParagraphSpacing(extraParagraphSpacing),
+        viewportWidth(viewportWidth),
+        viewportHeight(viewportHeight),
+        completePageFn(std::move(completePageFn)),
+        paragraph(extraParagraphSpacing, hyphenationEnabled) {}
+
+  void process(Item& item);
+
+  const std::vector<std::pair<std::string, uint16_t>>& getAnchors() const { return anchorData; }
+
+ private:
+  const GfxRenderer& renderer;
+  int fontId;
+  float lineCompression;
+  bool extraParagraphSpacing;
+  uint16_t viewportWidth;
+  uint16_t viewportHeight;
+  CompletePageFn completePageFn;
+
+  // The paragraph being laid out; holds the last line of a part until the next part arrives
+  ParsedText paragraph;
+  bool paragraphOpen = false;
+  int wordsExtractedInBlock = 0;
+  std::vector<std::pair<int, FootnoteEntry>> pendingFootnotes;  // <wordIndex, entry>
+
+  std::unique_ptr<Page> currentPage;
+  int16_t currentPageNextY = 0;
+  uint16_t paragraphIndex = 0;  // Of the item being processed
+
+  // Anchor-to-page mapping: tracks which page each HTML id attribute lands on
+  int completedPageCount = 0;
+  std::vector<std::pair<std::string, uint16_t>> anchorData;
+
+  void addParagraph(Item& item);
+  void addImage(const Item& item);
+  void imageDisplaySize(const Item& item, int& displayWidth, int& displayHeight) const;
+  void makePages();
+  void addLineToPage(const std::shared_ptr<TextBlock>& line);
+  void completePage();
+  uint16_t effectiveWidth(const BlockStyle& blockStyle) const;
+  int lineHeight() const;
+  float emSize() const;
+};
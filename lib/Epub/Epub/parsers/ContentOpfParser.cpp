@@ -14,7 +14,7 @@ constexpr char itemCacheFile[] = "/.items.bin";
 }  // namespace
 
 bool ContentOpfParser::setup() {
-  parser = XML_ParserCreate(nullptr);
+  parser = createXmlParser();
   if (!parser) {
     LOG_DBG("COF", "Couldn't allocate memory for parser");
     return false;
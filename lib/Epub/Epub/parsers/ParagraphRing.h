@@ -0,0 +1,104 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+
+/**
+ * Bounded queue between one producer and one consumer running on different tasks, over a fixed set of slots that
+ * are constructed once and then handed back and forth (so whatever storage a slot has grown is reused by the items
+ * that pass through it later).
+ *
+ * The producer fills the slot acquire() gives it and publish()es it; the consumer gets slots in the same order from
+ * next() and release()s each one when done with it. acquire() blocks while every slot is in flight and next() while
+ * none is published, which keeps the faster side from running ahead by more than the ring's capacity.
+ *
+ * close() lets the consumer drain what was published and then makes next() return nullptr; abort() makes both sides
+ * return nullptr right away.
+ */
+template <typename Slot>
+class ParagraphRing {
+ public:
+  explicit ParagraphRing(const size_t capacity) : capacity(capacity) {}
+
+  ParagraphRing(const ParagraphRing&) = delete;
+  ParagraphRing& operator=(const ParagraphRing&) = delete;
+
+  // Construct the slots. Returns false if out of memory.
+  bool allocate() {
+    slots.reset(new (std::nothrow) Slot[capacity]);
+    return slots != nullptr;
+  }
+
+  size_t getCapacity() const { return capacity; }
+
+  // Producer: the next slot to fill, or nullptr after abort()
+  Slot* acquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+    slotFreed.wait(lock, [this] { return aborted || published - released < capacity; });
+    return aborted ? nullptr : &slots[published % capacity];
+  }
+
+  // Producer: hand the slot from acquire() to the consumer
+  void publish() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      published++;
+    }
+    slotPublished.notify_one();
+  }
+
+  // Producer: no more slots will be published
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      closed = true;
+    }
+    slotPublished.notify_one();
+  }
+
+  // Consumer: the next published slot, or nullptr once the ring is closed and drained (or aborted)
+  Slot* next() {
+    std::unique_lock<std::mutex> lock(mutex);
+    slotPublished.wait(lock, [this] { return aborted || closed || taken < published; });
+    if (aborted || taken == published) {
+      return nullptr;
+    }
+    return &slots[taken++ % capacity];
+  }
+
+  // Consumer: done with the slot from next(), the producer may refill it
+  void release() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      released++;
+    }
+    slotFreed.notify_one();
+  }
+
+  // Either side: stop the other one
+  void abort() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      aborted = true;
+    }
+    slotFreed.notify_all();
+    slotPublished.notify_all();
+  }
+
+ private:
+  const size_t capacity;
+  std::unique_ptr<Slot[]> slots;
+
+  std::mutex mutex;
+  std::condition_variable slotFreed;
+  std::condition_variable slotPublished;
+  // Running counts; slot i % capacity is free while published - released < capacity
+  size_t published = 0;
+  size_t taken = 0;
+  size_t released = 0;
+  bool closed = false;
+  bool aborted = false;
+};
@@ -0,0 +1,137 @@
+#include "TextRunTokenizer.h"
+
+#include <Utf8.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+using Word = uintptr_t;
+
+constexpr Word ONES = ~Word{0} / 0xFF;  // 0x01 in every byte
+constexpr Word HIGHS = ONES * 0x80;
+
+static_assert(std::endian::native == std::endian::little, "The first flagged byte is found from the low end");
+
+// 0x80 in the bytes of v below n (n <= 0x80). A byte can only be flagged wrongly above one that really is below n,
+// so the lowest flag is always right.
+constexpr Word bytesBelow(const Word v, const uint8_t n) { return (v - ONES * n) & ~v & HIGHS; }
+constexpr Word bytesEqual(const Word v, const uint8_t b) { return bytesBelow(v ^ (ONES * b), 1); }
+
+bool isWhitespace(const uint8_t c) { return c == ' ' || c == '\r' || c == '\n' || c == '\t'; }
+
+// Bytes that may end a run: whitespace and other control characters, and the lead bytes of U+00A0, U+202F and U+FEFF
+constexpr auto MAY_END_RUN = [] {
+  std::array<bool, 256> table{};
+  for (int c = 0; c <= ' '; c++) table[c] = true;
+  table[0xC2] = table[0xE2] = table[0xEF] = true;
+  return table;
+}();
+
+const char* findRunEnd(const char* p, const char* const end) {
+  while (static_cast<size_t>(end - p) >= sizeof(Word)) {
+    Word v;
+    memcpy(&v, p, sizeof(v));
+    const Word hits = bytesBelow(v, ' ' + 1) | bytesEqual(v, 0xC2) | bytesEqual(v, 0xE2) | bytesEqual(v, 0xEF);
+    if (hits != 0) {
+      return p + std::countr_zero(hits) / 8;
+    }
+    p += sizeof(Word);
+  }
+  while (p < end && !MAY_END_RUN[static_cast<uint8_t>(*p)]) {
+    p++;
+  }
+  return p;
+}
+
+// Length of the piece to cut from the front of a word longer than MAX_WORD_SIZE: the longest that does not end in
+// the middle of a UTF-8 character
+size_t cutLength(const char* word) {
+  const int safe = utf8SafeTruncateBuffer(word, TextRunTokenizer::MAX_WORD_SIZE);
+  return safe > 0 ? static_cast<size_t>(safe) : TextRunTokenizer::MAX_WORD_SIZE;
+}
+
+}  // namespace
+
+void TextRunTokenizer::feed(const char* text, const size_t length) {
+  const char* const end = text + length;
+  const char* run = text;
+  const char* p = text;
+  while ((p = findRunEnd(p, end)) != end) {
+    const auto c = static_cast<uint8_t>(p[0]);
+    const size_t left = end - p;
+    if (isWhitespace(c)) {
+      endWord(run, p - run);
+      // One break for the whole stretch of whitespace
+      do {
+        p++;
+      } while (p != end && isWhitespace(static_cast<uint8_t>(*p)));
+      sink.wordBreak();
+      run = p;
+    } else if ((c == 0xC2 && left >= 2 && static_cast<uint8_t>(p[1]) == 0xA0) ||
+               (c == 0xE2 && left >= 3 && static_cast<uint8_t>(p[1]) == 0x80 && static_cast<uint8_t>(p[2]) == 0xAF)) {
+      endWord(run, p - run);
+      sink.noBreakSpace();
+      p += c == 0xC2 ? 2 : 3;
+      run = p;
+    } else if (c == 0xEF && left >= 3 && static_cast<uint8_t>(p[1]) == 0xBB && static_cast<uint8_t>(p[2]) == 0xBF) {
+      // The word goes on after the dropped U+FEFF
+      append(run, p - run);
+      p += 3;
+      run = p;
+    } else {
+      // Any other character starting with one of these bytes, or a control character, is part of the word
+      p++;
+    }
+  }
+  append(run, end - run);
+}
+
+void TextRunTokenizer::flush() {
+  if (pendingLength > 0) {
+    sink.addWord(pending, pendingLength);
+    pendingLength = 0;
+  }
+}
+
+void TextRunTokenizer::append(const char* run, size_t length) {
+  while (length > 0) {
+    if (pendingLength == MAX_WORD_SIZE) {
+      cutPending();
+    }
+    const size_t take = std::min(length, MAX_WORD_SIZE - pendingLength);
+    memcpy(pending + pendingLength, run, take);
+    pendingLength += take;
+    run += take;
+    length -= take;
+  }
+}
+
+void TextRunTokenizer::endWord(const char* run, size_t length) {
+  if (pendingLength > 0) {
+    append(run, length);
+    flush();
+    return;
+  }
+  // The whole word is in the caller's buffer: no copy
+  while (length > MAX_WORD_SIZE) {
+    const size_t cut = cutLength(run);
+    sink.addWord(run, cut);
+    run += cut;
+    length -= cut;
+  }
+  if (length > 0) {
+    sink.addWord(run, length);
+  }
+}
+
+void TextRunTokenizer::cutPending() {
+  const size_t cut = cutLength(pending);
+  sink.addWord(pending, cut);
+  pendingLength -= cut;
+  memmove(pending, pending + cut, pendingLength);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Splits the character data expat reports for a chapter into words.
+ *
+ * Words end at ASCII whitespace and at no-break spaces (U+00A0, U+202F), which are reported separately so the
+ * caller can glue the words around them together; zero width no-break spaces (U+FEFF) are dropped. Words longer than
+ * MAX_WORD_SIZE bytes are cut, at a UTF-8 character boundary where possible (this is how CJK text, which has no
+ * spaces, is broken into words).
+ *
+ * Instead of looking at every byte, feed() scans a machine word at a time for the bytes that can end a word (control
+ * characters and spaces, and the lead bytes 0xC2, 0xE2 and 0xEF) and hands every run in between to the sink as it
+ * lies in the caller's buffer. Only a word that continues past the end of a callback (expat splits text at its buffer
+ * boundaries and at entities) is copied, into a small carry buffer, until the rest of it arrives.
+ */
+class TextRunTokenizer {
+ public:
+  class Sink {
+   public:
+    virtual ~Sink() = default;
+    // A word, or a piece of one cut at MAX_WORD_SIZE. Not NUL-terminated; only valid during the call
+    virtual void addWord(const char* word, size_t length) = 0;
+    // Whitespace between words (once for consecutive whitespace characters)
+    virtual void wordBreak() = 0;
+    // U+00A0 or U+202F between words
+    virtual void noBreakSpace() = 0;
+  };
+
+  static constexpr size_t MAX_WORD_SIZE = 200;
+
+  explicit TextRunTokenizer(Sink& sink) : sink(sink) {}
+
+  void feed(const char* text, size_t length);
+  // Hand the word in progress to the sink, if any (at the end of a text run, e.g. before an element changes style)
+  void flush();
+  // Drop the word in progress
+  void discard() { pendingLength = 0; }
+  bool hasPendingWord() const { return pendingLength > 0; }
+
+ private:
+  Sink& sink;
+  char pending[MAX_WORD_SIZE];
+  size_t pendingLength = 0;
+
+  void append(const char* run, size_t length);
+  void endWord(const char* run, size_t length);
+  void cutPending();
+};
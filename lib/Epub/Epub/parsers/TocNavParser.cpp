@@ -7,7 +7,7 @@
 #include "../BookMetadataCache.h"
 
 bool TocNavParser::setup() {
-  parser = XML_ParserCreate(nullptr);
+  parser = createXmlParser();
   if (!parser) {
     LOG_DBG("NAV", "Couldn't allocate memory for parser");
     return false;
@@ -0,0 +1,139 @@
+#include "DirectoryListing.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace {
+// Marker emitted in place of a digit run. Names never produce this byte otherwise (tolower only maps A-Z), and
+// comparing it against any non-digit gives the same result as comparing any digit would.
+constexpr uint8_t DIGIT_RUN_MARKER = '0';
+constexpr size_t KEY_PREFIX_BYTES = sizeof(uint64_t);
+
+uint64_t loadKeyPrefix(const uint8_t* key, const size_t length) {
+  uint64_t prefix = 0;
+  for (size_t i = 0; i < KEY_PREFIX_BYTES; i++) {
+    prefix = (prefix << 8) | (i < length ? key[i] : 0);
+  }
+  return prefix;
+}
+}  // namespace
+
+void DirectoryListing::reserve(const size_t entryCount, const size_t nameBytes) {
+  entries.reserve(entryCount);
+  names.reserve(nameBytes);
+}
+
+void DirectoryListing::clear() {
+  entries.clear();
+  names.clear();
+  directoryDate = 0;
+  directoryTime = 0;
+  hasMetadata = false;
+}
+
+bool DirectoryListing::add(const char* name, const size_t nameLength, const bool isDirectory, const uint32_t size,
+                           const uint16_t modifyDate, const uint16_t modifyTime) {
+  if (nameLength == 0 || nameLength > UINT16_MAX) {
+    return false;
+  }
+
+  Entry e{};
+  e.nameOffset = static_cast<uint32_t>(names.size());
+  e.size = size;
+  e.modifyDate = modifyDate;
+  e.modifyTime = modifyTime;
+  e.nameLength = static_cast<uint16_t>(nameLength);
+  e.flags = isDirectory ? FLAG_DIRECTORY : 0;
+
+  names.insert(names.end(), name, name + nameLength);
+  names.push_back('\0');
+  entries.push_back(e);
+  return true;
+}
+
+void DirectoryListing::appendSortKey(const char* name, const size_t nameLength, const bool isDirectory,
+                                     std::vector<uint8_t>& out) {
+  // Directories first
+  out.push_back(isDirectory ? 0 : 1);
+
+  size_t i = 0;
+  while (i < nameLength) {
+    const auto c = static_cast<unsigned char>(name[i]);
+    if (!isdigit(c)) {
+      // Regular case-insensitive character
+      out.push_back(static_cast<uint8_t>(tolower(c)));
+      i++;
+      continue;
+    }
+
+    // Digit run: skip leading zeros, then compare by significant length before comparing digits
+    while (i < nameLength && name[i] == '0') i++;
+    size_t digitsEnd = i;
+    while (digitsEnd < nameLength && isdigit(static_cast<unsigned char>(name[digitsEnd]))) digitsEnd++;
+    const size_t digitCount = std::min<size_t>(digitsEnd - i, UINT8_MAX);
+
+    out.push_back(DIGIT_RUN_MARKER);
+    out.push_back(static_cast<uint8_t>(digitCount));
+    out.insert(out.end(), name + i, name + i + digitCount);
+    i = digitsEnd;
+  }
+}
+
+void DirectoryListing::sort() {
+  const size_t count = entries.size();
+  if (count > 1) {
+    // Build every sort key once, plus an 8-byte big-endian prefix so most comparisons are a single integer compare
+    std::vector<uint8_t> keys;
+    keys.reserve(names.size() + count * 2);
+    std::vector<uint32_t> keyOffsets;
+    keyOffsets.reserve(count + 1);
+    std::vector<uint64_t> prefixes;
+    prefixes.reserve(count);
+
+    for (const Entry& e : entries) {
+      keyOffsets.push_back(static_cast<uint32_t>(keys.size()));
+      appendSortKey(names.data() + e.nameOffset, e.nameLength, e.flags & FLAG_DIRECTORY, keys);
+      prefixes.push_back(loadKeyPrefix(keys.data() + keyOffsets.back(), keys.size() - keyOffsets.back()));
+    }
+    keyOffsets.push_back(static_cast<uint32_t>(keys.size()));
+
+    std::vector<uint32_t> order(count);
+    for (size_t i = 0; i < count; i++) {
+      order[i] = static_cast<uint32_t>(i);
+    }
+
+    std::sort(order.begin(), order.end(), [&](const uint32_t a, const uint32_t b) {
+      if (prefixes[a] != prefixes[b]) {
+        return prefixes[a] < prefixes[b];
+      }
+      const size_t lenA = keyOffsets[a + 1] - keyOffsets[a];
+      const size_t lenB = keyOffsets[b + 1] - keyOffsets[b];
+      const int cmp = memcmp(keys.data() + keyOffsets[a], keys.data() + keyOffsets[b], std::min(lenA, lenB));
+      if (cmp != 0) {
+        return cmp < 0;
+      }
+      // One key is a prefix of the other
+      return lenA < lenB;
+    });
+
+    std::vector<Entry> sorted;
+    sorted.reserve(count);
+    for (const uint32_t index : order) {
+      sorted.push_back(entries[index]);
+    }
+    entries.swap(sorted);
+  }
+
+  entries.shrink_to_fit();
+  names.shrink_to_fit();
+}
+
+size_t DirectoryListing::find(const std::string_view entryName, const bool directory) const {
+  for (size_t i = 0; i < entries.size(); i++) {
+    if (isDirectory(i) == directory && name(i) == entryName) {
+      return i;
+    }
+  }
+  return npos;
+}
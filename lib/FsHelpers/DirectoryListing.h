@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Sorted listing of a single directory.
+ *
+ * All entry names live in one contiguous, null-terminated arena and each entry is a fixed 16 byte record, so a folder
+ * with thousands of files costs two allocations instead of one std::string per entry. Sorting precomputes a natural
+ * sort key once per entry (directories first, case-insensitive, digit runs compared by value) and orders entries by
+ * comparing keys bytewise. Callers only build display strings for the rows they actually draw.
+ *
+ * The listing itself has no storage dependency; see DirectoryListingCache for scanning and caching.
+ */
+class DirectoryListing {
+ public:
+  struct Entry {
+    uint32_t nameOffset;
+    uint32_t size;
+    uint16_t modifyDate;  // FAT date, 0 if unknown
+    uint16_t modifyTime;  // FAT time, 0 if unknown
+    uint16_t nameLength;
+    uint8_t flags;
+    uint8_t reserved;
+  };
+  static_assert(sizeof(Entry) == 16, "DirectoryListing::Entry should stay compact");
+
+  static constexpr uint8_t FLAG_DIRECTORY = 0x01;
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  explicit DirectoryListing(std::string path = {}) : path(std::move(path)) {}
+
+  void reserve(size_t entryCount, size_t nameBytes);
+  void clear();
+  // Append an entry (unsorted). Names longer than 65535 bytes are rejected.
+  bool add(const char* name, size_t nameLength, bool isDirectory, uint32_t size = 0, uint16_t modifyDate = 0,
+           uint16_t modifyTime = 0);
+  // Sort entries in natural order with directories first, then release any spare capacity
+  void sort();
+
+  const std::string& getPath() const { return path; }
+  size_t size() const { return entries.size(); }
+  bool empty() const { return entries.empty(); }
+  const Entry& entry(const size_t index) const { return entries[index]; }
+  std::string_view name(const size_t index) const {
+    return {names.data() + entries[index].nameOffset, entries[index].nameLength};
+  }
+  // Null-terminated name, valid until the listing is modified
+  const char* nameCStr(const size_t index) const { return names.data() + entries[index].nameOffset; }
+  bool isDirectory(const size_t index) const { return entries[index].flags & FLAG_DIRECTORY; }
+  uint32_t fileSize(const size_t index) const { return entries[index].size; }
+
+  // Index of the entry with the given name and type, or npos
+  size_t find(std::string_view entryName, bool directory) const;
+
+  // Approximate heap footprint, used for cache budgeting
+  size_t memoryUsage() const { return entries.capacity() * sizeof(Entry) + names.capacity(); }
+
+  // Timestamp of the directory itself when it was scanned, used to validate cached listings
+  uint16_t directoryDate = 0;
+  uint16_t directoryTime = 0;
+  // Whether sizes and timestamps were recorded when scanning
+  bool hasMetadata = false;
+
+  // Natural sort key: 0/1 directory flag, lowercased bytes, and digit runs encoded as '0', run length, significant
+  // digits. Comparing two keys with memcmp (shorter key first on a tie) yields the file browser order.
+  static void appendSortKey(const char* name, size_t nameLength, bool isDirectory, std::vector<uint8_t>& out);
+
+ private:
+  std::string path;
+  std::vector<Entry> entries;
+  std::vector<char> names;
+};
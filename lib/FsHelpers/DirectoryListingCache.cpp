@@ -0,0 +1,231 @@
+#include "DirectoryListingCache.h"
+
+#include <HalStorage.h>
+#include <Logging.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace DirectoryListingCache {
+
+namespace {
+struct CachedListing {
+  std::unique_ptr<DirectoryListing> listing;
+  EntryFilter filter;
+};
+
+// Most recently parked listing last
+std::vector<CachedListing> cache;
+
+std::string normaliseDirPath(std::string path) {
+  if (path.empty()) {
+    return "/";
+  }
+  while (path.size() > 1 && path.back() == '/') {
+    path.pop_back();
+  }
+  return path;
+}
+
+// Open `dirPath` and read its timestamp. The root directory has none, so it relies on explicit invalidation.
+bool openDirectory(const std::string& dirPath, FsFile& dir, uint16_t* dirDate, uint16_t* dirTime) {
+  dir = Storage.open(dirPath.c_str());
+  if (!dir || !dir.isDirectory()) {
+    return false;
+  }
+  if (!dir.getModifyDateTime(dirDate, dirTime)) {
+    *dirDate = 0;
+    *dirTime = 0;
+  }
+  return true;
+}
+
+// Remove and return the parked listing for `dirPath` if it is usable for this request, dropping stale copies
+std::unique_ptr<DirectoryListing> takeCached(const std::string& dirPath, const EntryFilter filter,
+                                             const bool withMetadata, const uint16_t dirDate, const uint16_t dirTime) {
+  const auto cached = std::find_if(cache.begin(), cache.end(), [&](const CachedListing& c) {
+    return c.filter == filter && (c.listing->hasMetadata || !withMetadata) && c.listing->getPath() == dirPath;
+  });
+  if (cached == cache.end()) {
+    return nullptr;
+  }
+  auto listing = std::move(cached->listing);
+  cache.erase(cached);
+  if (listing->directoryDate != dirDate || listing->directoryTime != dirTime) {
+    return nullptr;
+  }
+  return listing;
+}
+
+// Call onEntry(name, nameLength, isDirectory, size, date, time) for each entry passing `filter` until it returns false
+template <typename OnEntry>
+void scanDirectory(FsFile& dir, const EntryFilter filter, const bool withMetadata, OnEntry&& onEntry) {
+  dir.rewindDirectory();
+  char name[500];
+  for (auto file = dir.openNextFile(); file; file = dir.openNextFile()) {
+    file.getName(name, sizeof(name));
+    const bool isDirectory = file.isDirectory();
+    if (filter && !filter(name, isDirectory)) {
+      continue;
+    }
+
+    uint32_t size = 0;
+    uint16_t date = 0;
+    uint16_t time = 0;
+    if (withMetadata) {
+      size = isDirectory ? 0 : static_cast<uint32_t>(file.fileSize());
+      file.getModifyDateTime(&date, &time);
+    }
+    if (!onEntry(name, strlen(name), isDirectory, size, date, time)) {
+      break;
+    }
+  }
+}
+
+void removeExact(const std::string& dirPath) {
+  cache.erase(std::remove_if(cache.begin(), cache.end(),
+                             [&](const CachedListing& c) { return c.listing->getPath() == dirPath; }),
+              cache.end());
+}
+
+void evictToBudget() {
+  size_t total = 0;
+  for (const auto& cached : cache) {
+    total += cached.listing->memoryUsage();
+  }
+  // Evict least recently parked first
+  while (!cache.empty() && (total > CACHE_BUDGET_BYTES || cache.size() > MAX_CACHED_LISTINGS)) {
+    total -= cache.front().listing->memoryUsage();
+    LOG_DBG("DLC", "Evicting cached listing: %s", cache.front().listing->getPath().c_str());
+    cache.erase(cache.begin());
+  }
+}
+}  // namespace
+
+std::unique_ptr<DirectoryListing> load(const std::string& path, const EntryFilter filter, const bool withMetadata) {
+  const std::string dirPath = normaliseDirPath(path);
+
+  FsFile dir;
+  uint16_t dirDate = 0;
+  uint16_t dirTime = 0;
+  if (!openDirectory(dirPath, dir, &dirDate, &dirTime)) {
+    return nullptr;
+  }
+
+  if (auto cached = takeCached(dirPath, filter, withMetadata, dirDate, dirTime)) {
+    LOG_DBG("DLC", "Using cached listing: %s (%zu entries)", dirPath.c_str(), cached->size());
+    return cached;
+  }
+
+  const unsigned long start = millis();
+  auto listing = std::make_unique<DirectoryListing>(dirPath);
+  listing->reserve(64, 2048);
+  listing->directoryDate = dirDate;
+  listing->directoryTime = dirTime;
+  listing->hasMetadata = withMetadata;
+
+  scanDirectory(dir, filter, withMetadata,
+                [&](const char* name, const size_t nameLength, const bool isDirectory, const uint32_t size,
+                    const uint16_t date, const uint16_t time) {
+                  listing->add(name, nameLength, isDirectory, size, date, time);
+                  return true;
+                });
+  dir.close();
+
+  listing->sort();
+  LOG_DBG("DLC", "Scanned %s: %zu entries, %zu bytes in %lu ms", dirPath.c_str(), listing->size(),
+          listing->memoryUsage(), millis() - start);
+  return listing;
+}
+
+bool forEach(const std::string& path, const EntryFilter filter, const EntryVisitor visitor, void* context) {
+  const std::string dirPath = normaliseDirPath(path);
+
+  FsFile dir;
+  uint16_t dirDate = 0;
+  uint16_t dirTime = 0;
+  if (!openDirectory(dirPath, dir, &dirDate, &dirTime)) {
+    return false;
+  }
+
+  if (auto cached = takeCached(dirPath, filter, true, dirDate, dirTime)) {
+    dir.close();
+    for (size_t i = 0; i < cached->size(); i++) {
+      const auto& e = cached->entry(i);
+      if (!visitor(context, cached->nameCStr(i), e.nameLength, cached->isDirectory(i), e.size, e.modifyDate,
+                   e.modifyTime)) {
+        break;
+      }
+    }
+    park(std::move(cached), filter);
+    return true;
+  }
+
+  // Stream entries to the visitor while building a listing to park, unless it outgrows the cache budget
+  auto listing = std::make_unique<DirectoryListing>(dirPath);
+  listing->reserve(64, 2048);
+  listing->directoryDate = dirDate;
+  listing->directoryTime = dirTime;
+  listing->hasMetadata = true;
+
+  bool complete = true;
+  scanDirectory(dir, filter, true,
+                [&](const char* name, const size_t nameLength, const bool isDirectory, const uint32_t size,
+                    const uint16_t date, const uint16_t time) {
+                  if (listing) {
+                    listing->add(name, nameLength, isDirectory, size, date, time);
+                    if (listing->memoryUsage() > CACHE_BUDGET_BYTES) {
+                      listing.reset();
+                    }
+                  }
+                  complete = visitor(context, name, nameLength, isDirectory, size, date, time);
+                  return complete;
+                });
+  dir.close();
+
+  if (listing && complete) {
+    listing->sort();
+    park(std::move(listing), filter);
+  }
+  return true;
+}
+
+void park(std::unique_ptr<DirectoryListing> listing, const EntryFilter filter) {
+  if (!listing) {
+    return;
+  }
+  if (listing->memoryUsage() > CACHE_BUDGET_BYTES) {
+    return;
+  }
+
+  // Replace any older copy of the same directory
+  removeExact(listing->getPath());
+  cache.push_back({std::move(listing), filter});
+  evictToBudget();
+}
+
+void invalidate(const std::string& dirPath) {
+  const std::string normalised = normaliseDirPath(dirPath);
+  // Subdirectories go too, since moving or deleting a directory changes their contents as well
+  const std::string prefix = normalised == "/" ? normalised : normalised + "/";
+  cache.erase(std::remove_if(cache.begin(), cache.end(),
+                             [&](const CachedListing& c) {
+                               const std::string& cachedPath = c.listing->getPath();
+                               return cachedPath == normalised || cachedPath.compare(0, prefix.size(), prefix) == 0;
+                             }),
+              cache.end());
+}
+
+void invalidateParentOf(const std::string& path) {
+  const std::string normalised = normaliseDirPath(path);
+  const auto lastSlash = normalised.find_last_of('/');
+  if (lastSlash == std::string::npos || lastSlash == 0) {
+    removeExact("/");
+  } else {
+    removeExact(normalised.substr(0, lastSlash));
+  }
+}
+
+void clear() { cache.clear(); }
+
+}  // namespace DirectoryListingCache
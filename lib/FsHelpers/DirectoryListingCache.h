@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "DirectoryListing.h"
+
+/**
+ * Scans directories into sorted DirectoryListings and keeps recently left listings in RAM.
+ *
+ * Listings are owned by the caller while in use: load() either hands back a parked listing or scans the directory,
+ * and park() returns it to the cache when the caller moves elsewhere (e.g. the file browser entering a subfolder).
+ * A parked listing is reused only if the directory timestamp still matches; because FAT does not reliably update
+ * directory timestamps (and the root has none), every write path in the firmware must also call invalidate().
+ *
+ * The cache is RAM-only and bounded by CACHE_BUDGET_BYTES, so it never goes stale across reboots.
+ */
+namespace DirectoryListingCache {
+
+// Decides whether a directory entry is listed. Receives the entry name and whether it is a directory.
+using EntryFilter = bool (*)(const char* name, bool isDirectory);
+// Receives one entry with its metadata. Returns false to stop iterating.
+using EntryVisitor = bool (*)(void* context, const char* name, size_t nameLength, bool isDirectory, uint32_t size,
+                              uint16_t modifyDate, uint16_t modifyTime);
+
+constexpr size_t CACHE_BUDGET_BYTES = 96 * 1024;
+constexpr size_t MAX_CACHED_LISTINGS = 4;
+
+// Return the sorted listing for `path`, from cache when still valid. Returns nullptr if path is not a directory.
+// `withMetadata` also records file sizes and timestamps (needed by WebDAV, not by the file browser).
+std::unique_ptr<DirectoryListing> load(const std::string& path, EntryFilter filter, bool withMetadata = false);
+
+// Visit every entry of `path` with metadata, in no particular order, without holding the whole listing in memory.
+// Served from a parked listing when still valid; otherwise the directory is streamed and, if it fits the cache
+// budget, parked for the next call. Returns false if path is not a directory.
+bool forEach(const std::string& path, EntryFilter filter, EntryVisitor visitor, void* context);
+
+// Hand a listing back to the cache for reuse by a later load() with the same filter
+void park(std::unique_ptr<DirectoryListing> listing, EntryFilter filter);
+
+// Drop the cached listings of `dirPath` and everything below it
+void invalidate(const std::string& dirPath);
+
+// Drop the cached listing of the directory containing `path` (not its subdirectories)
+void invalidateParentOf(const std::string& path);
+
+// Release all cached listings
+void clear();
+
+}  // namespace DirectoryListingCache
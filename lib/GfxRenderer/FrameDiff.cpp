@@ -0,0 +1,146 @@
+#include "FrameDiff.h"
+
+#include <cstring>
+
+namespace FrameDiff {
+
+namespace {
+
+inline uint32_t loadWord(const uint8_t* p) {
+  uint32_t word;
+  memcpy(&word, p, sizeof(word));
+  return word;
+}
+
+// Index of the first byte that differs in [0, stride), or -1
+int firstDifferentByte(const uint8_t* a, const uint8_t* b, const int stride) {
+  int i = 0;
+  for (; i + 4 <= stride; i += 4) {
+    if (loadWord(a + i) != loadWord(b + i)) break;
+  }
+  for (; i < stride; i++) {
+    if (a[i] != b[i]) return i;
+  }
+  return -1;
+}
+
+// Index of the last byte that differs in [from, stride); the caller knows there is one
+int lastDifferentByte(const uint8_t* a, const uint8_t* b, const int from, const int stride) {
+  int i = stride;
+  for (; i - 4 >= from; i -= 4) {
+    if (loadWord(a + i - 4) != loadWord(b + i - 4)) break;
+  }
+  for (i--; i > from; i--) {
+    if (a[i] != b[i]) return i;
+  }
+  return from;
+}
+
+// Bits are MSB first: bit 7 of a byte is its leftmost pixel
+inline int leftmostBit(const uint8_t mask) {
+  int bit = 0;
+  while (!(mask & (0x80 >> bit))) bit++;
+  return bit;
+}
+
+inline int rightmostBit(const uint8_t mask) {
+  int bit = 7;
+  while (!(mask & (0x80 >> bit))) bit--;
+  return bit;
+}
+
+}  // namespace
+
+Rect diff(const uint8_t* previous, const uint8_t* current, const uint16_t stride, const uint16_t rows) {
+  Rect result;
+  for (int y = 0; y < rows; y++) {
+    const uint8_t* a = previous + static_cast<size_t>(y) * stride;
+    const uint8_t* b = current + static_cast<size_t>(y) * stride;
+
+    const int first = firstDifferentByte(a, b, stride);
+    if (first < 0) continue;
+    const int last = lastDifferentByte(a, b, first, stride);
+
+    result.include(first * 8 + leftmostBit(a[first] ^ b[first]), y);
+    result.include(last * 8 + rightmostBit(a[last] ^ b[last]), y);
+  }
+  return result;
+}
+
+void FrameSignatures::init(uint32_t* storage, const uint16_t frameStride, const uint16_t rows) {
+  stride = frameStride;
+  rowCount = rows;
+  valid = false;
+  const bool tracked = (frameStride + 3) / 4 <= MAX_WORD_COLUMNS;
+  rowSignatures = tracked ? storage : nullptr;
+  columnSignatures = tracked ? storage + rows : nullptr;
+}
+
+bool FrameSignatures::update(const uint8_t* frame, const Rect& drawn, Rect* changed) {
+  if (valid && drawn.empty()) return false;
+  if (!rowSignatures) {
+    *changed = Rect::full(stride * 8, rowCount);
+    return true;
+  }
+
+  // FNV-1a over 32-bit words, chained along each row and down each word column. Column hashes span every row, so
+  // the whole frame is read, but that is one pass over the framebuffer and far cheaper than a panel refresh.
+  constexpr uint32_t FNV_OFFSET = 2166136261u;
+  constexpr uint32_t FNV_PRIME = 16777619u;
+  const int fullWords = stride / 4;
+  const int columns = (stride + 3) / 4;
+
+  uint32_t columnHash[MAX_WORD_COLUMNS];
+  for (int c = 0; c < columns; c++) columnHash[c] = FNV_OFFSET;
+
+  Rect result;
+  for (int y = 0; y < rowCount; y++) {
+    const uint8_t* row = frame + static_cast<size_t>(y) * stride;
+    uint32_t rowHash = FNV_OFFSET;
+    for (int c = 0; c < fullWords; c++) {
+      const uint32_t word = loadWord(row + c * 4);
+      rowHash = (rowHash ^ word) * FNV_PRIME;
+      columnHash[c] = (columnHash[c] ^ word) * FNV_PRIME;
+    }
+    if (fullWords < columns) {
+      // X3 stride (99 bytes) leaves a partial last word
+      uint32_t word = 0;
+      memcpy(&word, row + fullWords * 4, stride - fullWords * 4);
+      rowHash = (rowHash ^ word) * FNV_PRIME;
+      columnHash[fullWords] = (columnHash[fullWords] ^ word) * FNV_PRIME;
+    }
+    if (!valid || rowHash != rowSignatures[y]) {
+      rowSignatures[y] = rowHash;
+      result.include(0, y);
+    }
+  }
+
+  if (result.empty() && valid) {
+    // Rows unchanged means the frame is unchanged; column hashes are identical too
+    return false;
+  }
+
+  int firstColumn = -1;
+  int lastColumn = -1;
+  for (int c = 0; c < columns; c++) {
+    if (!valid || columnHash[c] != columnSignatures[c]) {
+      columnSignatures[c] = columnHash[c];
+      if (firstColumn < 0) firstColumn = c;
+      lastColumn = c;
+    }
+  }
+  valid = true;
+
+  if (firstColumn < 0) {
+    // A row changed but no column did: only possible through a hash collision, so fall back to full rows
+    firstColumn = 0;
+    lastColumn = columns - 1;
+  }
+  const int width = stride * 8;
+  result.x0 = static_cast<int16_t>(firstColumn * 32);
+  result.x1 = static_cast<int16_t>(lastColumn * 32 + 31 < width ? lastColumn * 32 + 31 : width - 1);
+  *changed = result;
+  return true;
+}
+
+}  // namespace FrameDiff
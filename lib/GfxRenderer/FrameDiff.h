@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Dirty-region bookkeeping for the 1-bit panel framebuffer.
+ *
+ * All coordinates are physical panel pixels (native 800x480 layout, MSB-first bits, rows of `stride` bytes), so they
+ * can be handed straight to a windowed display update regardless of the logical orientation used while drawing.
+ *
+ * Two sources of dirty information are provided:
+ * - Rect is grown by the drawing primitives as they touch pixels. It is conservative: it may cover pixels that were
+ *   redrawn with the same value, but never misses a write.
+ * - diff() / FrameSignatures compare frames in 32-bit words to find what really changed. diff() needs the previous
+ *   frame; FrameSignatures only keep hashes (about 2KB) so they can run on device without a 48KB shadow copy.
+ */
+namespace FrameDiff {
+
+struct Rect {
+  // Inclusive bounds; an empty rect has x0 > x1
+  int16_t x0 = INT16_MAX;
+  int16_t y0 = INT16_MAX;
+  int16_t x1 = INT16_MIN;
+  int16_t y1 = INT16_MIN;
+
+  bool empty() const { return x0 > x1 || y0 > y1; }
+  int width() const { return empty() ? 0 : x1 - x0 + 1; }
+  int height() const { return empty() ? 0 : y1 - y0 + 1; }
+  void clear() { *this = Rect{}; }
+
+  // Hot path: called for every pixel drawn through GfxRenderer::drawPixel()
+  inline void include(const int x, const int y) {
+    if (x < x0) x0 = static_cast<int16_t>(x);
+    if (x > x1) x1 = static_cast<int16_t>(x);
+    if (y < y0) y0 = static_cast<int16_t>(y);
+    if (y > y1) y1 = static_cast<int16_t>(y);
+  }
+
+  void include(const Rect& other) {
+    if (other.empty()) return;
+    include(other.x0, other.y0);
+    include(other.x1, other.y1);
+  }
+
+  bool contains(const Rect& other) const {
+    return other.empty() || (!empty() && other.x0 >= x0 && other.x1 <= x1 && other.y0 >= y0 && other.y1 <= y1);
+  }
+
+  static Rect full(const int width, const int height) {
+    Rect r;
+    r.x0 = 0;
+    r.y0 = 0;
+    r.x1 = static_cast<int16_t>(width - 1);
+    r.y1 = static_cast<int16_t>(height - 1);
+    return r;
+  }
+};
+
+// Exact bounding box of the pixels that differ between two frames of `rows` rows of `stride` bytes. Compares 32-bit
+// words where possible and only narrows to bits at the edges. Returns an empty rect for identical frames.
+Rect diff(const uint8_t* previous, const uint8_t* current, uint16_t stride, uint16_t rows);
+
+/**
+ * Signatures of the frame last sent to the panel: one 32-bit hash per physical row and one per 32-bit word column.
+ * update() rehashes the new frame and reports the rows and word columns whose contents changed, so a redraw that
+ * produced identical pixels (or changed only part of the screen) is detected without keeping the previous frame.
+ * The result is exact to the row and to 32 pixels horizontally, barring hash collisions.
+ *
+ * Storage is caller-owned (storageSize() entries), so the tracker itself never allocates.
+ */
+class FrameSignatures {
+ public:
+  // Word columns tracked per frame: enough for panels up to 1024 pixels wide
+  static constexpr int MAX_WORD_COLUMNS = 32;
+
+  static constexpr size_t storageSize(const uint16_t stride, const uint16_t rows) { return rows + (stride + 3) / 4; }
+
+  // Panels wider than MAX_WORD_COLUMNS words are not tracked; update() then always reports the whole frame
+  void init(uint32_t* storage, uint16_t stride, uint16_t rows);
+
+  // Forget the panel contents, e.g. after a grayscale update wrote other data to the controller
+  void invalidate() { valid = false; }
+  bool isValid() const { return valid; }
+
+  // Rehash `frame`, of which only `drawn` can have changed since the last update, and store the changed region in
+  // `changed` (32-pixel aligned). Returns false if nothing changed. While invalid, the whole frame counts as changed.
+  bool update(const uint8_t* frame, const Rect& drawn, Rect* changed);
+
+ private:
+  uint32_t* rowSignatures = nullptr;
+  uint32_t* columnSignatures = nullptr;
+  uint16_t stride = 0;
+  uint16_t rowCount = 0;
+  bool valid = false;
+};
+
+}  // namespace FrameDiff
@@ -2,7 +2,9 @@
 
 #include <FontDecompressor.h>
 #include <HalGPIO.h>
+#include <HeapTags.h>
 #include <Logging.h>
+#include <Trace.h>
 #include <Utf8.h>
 
 #include "FontCacheManager.h"
@@ -34,42 +36,24 @@ void GfxRenderer::begin() {
   panelWidthBytes = display.getDisplayWidthBytes();
   frameBufferSize = display.getBufferSize();
   bwBufferChunks.assign((frameBufferSize + BW_BUFFER_CHUNK_SIZE - 1) / BW_BUFFER_CHUNK_SIZE, nullptr);
+  displayedFrameSignatures.assign(FrameDiff::FrameSignatures::storageSize(panelWidthBytes, panelHeight), 0);
+  displayedFrame.init(displayedFrameSignatures.data(), panelWidthBytes, panelHeight);
+  markAllDirty();
 }
 
 void GfxRenderer::insertFont(const int fontId, EpdFontFamily font) { fontMap.insert({fontId, font}); }
 
+static_assert(static_cast<int>(GfxRenderer::Portrait) == SpanFill::Portrait &&
+                  static_cast<int>(GfxRenderer::LandscapeClockwise) == SpanFill::LandscapeClockwise &&
+                  static_cast<int>(GfxRenderer::PortraitInverted) == SpanFill::PortraitInverted &&
+                  static_cast<int>(GfxRenderer::LandscapeCounterClockwise) == SpanFill::LandscapeCounterClockwise,
+              "SpanFill::Orientation must match GfxRenderer::Orientation");
+
 // Translate logical (x,y) coordinates to physical panel coordinates based on current orientation
 // This should always be inlined for better performance
 static inline void rotateCoordinates(const GfxRenderer::Orientation orientation, const int x, const int y, int* phyX,
                                      int* phyY, const uint16_t panelWidth, const uint16_t panelHeight) {
-  switch (orientation) {
-    case GfxRenderer::Portrait: {
-      // Logical portrait (480x800) → panel (800x480)
-      // Rotation: 90 degrees clockwise
-      *phyX = y;
-      *phyY = panelHeight - 1 - x;
-      break;
-    }
-    case GfxRenderer::LandscapeClockwise: {
-      // Logical landscape (800x480) rotated 180 degrees (swap top/bottom and left/right)
-      *phyX = panelWidth - 1 - x;
-      *phyY = panelHeight - 1 - y;
-      break;
-    }
-    case GfxRenderer::PortraitInverted: {
-      // Logical portrait (480x800) → panel (800x480)
-      // Rotation: 90 degrees counter-clockwise
-      *phyX = panelWidth - 1 - y;
-      *phyY = x;
-      break;
-    }
-    case GfxRenderer::LandscapeCounterClockwise: {
-      // Logical landscape (800x480) aligned with panel orientation
-      *phyX = x;
-      *phyY = y;
-      break;
-    }
-  }
+  SpanFill::toPhysical(static_cast<SpanFill::Orientation>(orientation), x, y, phyX, phyY, panelWidth, panelHeight);
 }
 
 enum class TextRotation { None, Rotated90CW };
@@ -186,6 +170,7 @@ void GfxRenderer::drawPixel(const int x, const int y, const bool state) const {
   // Calculate byte position and bit position
   const uint32_t byteIndex = static_cast<uint32_t>(phyY) * panelWidthBytes + (phyX / 8);
   const uint8_t bitPosition = 7 - (phyX % 8);  // MSB first
+  dirtyRegion.include(phyX, phyY);
 
   if (state) {
     frameBuffer[byteIndex] &= ~(1 << bitPosition);  // Clear bit
@@ -275,20 +260,17 @@ void GfxRenderer::drawText(const int fontId, const int x, const int y, const cha
 
 void GfxRenderer::drawLine(int x1, int y1, int x2, int y2, const bool state) const {
   if (fontCacheManager_ && fontCacheManager_->isScanning()) return;
+  const auto fill = state ? SpanFill::Fill::Black : SpanFill::Fill::White;
   if (x1 == x2) {
     if (y2 < y1) {
       std::swap(y1, y2);
     }
-    for (int y = y1; y <= y2; y++) {
-      drawPixel(x1, y, state);
-    }
+    fillSpan(x1, y1, 1, y2 - y1 + 1, fill);
   } else if (y1 == y2) {
     if (x2 < x1) {
       std::swap(x1, x2);
     }
-    for (int x = x1; x <= x2; x++) {
-      drawPixel(x, y1, state);
-    }
+    fillSpan(x1, y1, x2 - x1 + 1, 1, fill);
   } else {
     // Bresenham's line algorithm — integer arithmetic only
     int dx = x2 - x1;
@@ -440,9 +422,22 @@ void GfxRenderer::drawRoundedRect(const int x, const int y, const int width, con
 }
 
 void GfxRenderer::fillRect(const int x, const int y, const int width, const int height, const bool state) const {
-  for (int fillY = y; fillY < y + height; fillY++) {
-    drawLine(x, fillY, x + width - 1, fillY, state);
+  if (fontCacheManager_ && fontCacheManager_->isScanning()) return;
+  fillSpan(x, y, width, height, state ? SpanFill::Fill::Black : SpanFill::Fill::White);
+}
+
+void GfxRenderer::fillSpan(const int x, const int y, const int width, const int height,
+                           const SpanFill::Fill fill) const {
+  if (width <= 0 || height <= 0) {
+    return;
+  }
+  const SpanFill::Surface surface{frameBuffer, panelWidth, panelHeight, panelWidthBytes};
+  const FrameDiff::Rect written =
+      SpanFill::fillRect(surface, static_cast<SpanFill::Orientation>(orientation), x, y, width, height, fill);
+  if (written.width() * written.height() != width * height) {
+    LOG_ERR("GFX", "!! Fill (%d, %d) %dx%d partly outside range", x, y, width, height);
   }
+  dirtyRegion.include(written);
 }
 
 // NOTE: Those are in critical path, and need to be templated to avoid runtime checks for every pixel.
@@ -479,17 +474,9 @@ void GfxRenderer::fillRectDither(const int x, const int y, const int width, cons
   } else if (color == Color::White) {
     fillRect(x, y, width, height, false);
   } else if (color == Color::LightGray) {
-    for (int fillY = y; fillY < y + height; fillY++) {
-      for (int fillX = x; fillX < x + width; fillX++) {
-        drawPixelDither<Color::LightGray>(fillX, fillY);
-      }
-    }
+    fillSpan(x, y, width, height, SpanFill::Fill::LightGray);
   } else if (color == Color::DarkGray) {
-    for (int fillY = y; fillY < y + height; fillY++) {
-      for (int fillX = x; fillX < x + width; fillX++) {
-        drawPixelDither<Color::DarkGray>(fillX, fillY);
-      }
-    }
+    fillSpan(x, y, width, height, SpanFill::Fill::DarkGray);
   }
 }
 
@@ -661,10 +648,12 @@ void GfxRenderer::drawImage(const uint8_t bitmap[], const int x, const int y, co
   }
   // TODO: Rotate bits
   display.drawImage(bitmap, rotatedX, rotatedY, width, height);
+  markAllDirty();
 }
 
 void GfxRenderer::drawIcon(const uint8_t bitmap[], const int x, const int y, const int width, const int height) const {
   display.drawImageTransparent(bitmap, y, getScreenWidth() - width - x, height, width);
+  markAllDirty();
 }
 
 void GfxRenderer::drawBitmap(const Bitmap& bitmap, const int x, const int y, const int maxWidth, const int maxHeight,
@@ -708,13 +697,13 @@ void GfxRenderer::drawBitmap(const Bitmap& bitmap, const int x, const int y, con
   // Calculate output row size (2 bits per pixel, packed into bytes)
   // IMPORTANT: Use int, not uint8_t, to avoid overflow for images > 1020 pixels wide
   const int outputRowSize = (bitmap.getWidth() + 3) / 4;
-  auto* outputRow = static_cast<uint8_t*>(malloc(outputRowSize));
-  auto* rowBytes = static_cast<uint8_t*>(malloc(bitmap.getRowBytes()));
+  auto* outputRow = static_cast<uint8_t*>(HeapTags::alloc(HeapTags::Tag::ImageDecode, outputRowSize));
+  auto* rowBytes = static_cast<uint8_t*>(HeapTags::alloc(HeapTags::Tag::ImageDecode, bitmap.getRowBytes()));
 
   if (!outputRow || !rowBytes) {
     LOG_ERR("GFX", "!! Failed to allocate BMP row buffers");
-    free(outputRow);
-    free(rowBytes);
+    HeapTags::release(outputRow);
+    HeapTags::release(rowBytes);
     return;
   }
 
@@ -732,8 +721,8 @@ void GfxRenderer::drawBitmap(const Bitmap& bitmap, const int x, const int y, con
 
     if (bitmap.readNextRow(outputRow, rowBytes) != BmpReaderError::Ok) {
       LOG_ERR("GFX", "Failed to read row %d from bitmap", bmpY);
-      free(outputRow);
-      free(rowBytes);
+      HeapTags::release(outputRow);
+      HeapTags::release(rowBytes);
       return;
     }
 
@@ -771,8 +760,8 @@ void GfxRenderer::drawBitmap(const Bitmap& bitmap, const int x, const int y, con
     }
   }
 
-  free(outputRow);
-  free(rowBytes);
+  HeapTags::release(outputRow);
+  HeapTags::release(rowBytes);
 }
 
 void GfxRenderer::drawBitmap1Bit(const Bitmap& bitmap, const int x, const int y, const int maxWidth,
@@ -790,13 +779,13 @@ void GfxRenderer::drawBitmap1Bit(const Bitmap& bitmap, const int x, const int y,
 
   // For 1-bit BMP, output is still 2-bit packed (for consistency with readNextRow)
   const int outputRowSize = (bitmap.getWidth() + 3) / 4;
-  auto* outputRow = static_cast<uint8_t*>(malloc(outputRowSize));
-  auto* rowBytes = static_cast<uint8_t*>(malloc(bitmap.getRowBytes()));
+  auto* outputRow = static_cast<uint8_t*>(HeapTags::alloc(HeapTags::Tag::ImageDecode, outputRowSize));
+  auto* rowBytes = static_cast<uint8_t*>(HeapTags::alloc(HeapTags::Tag::ImageDecode, bitmap.getRowBytes()));
 
   if (!outputRow || !rowBytes) {
     LOG_ERR("GFX", "!! Failed to allocate 1-bit BMP row buffers");
-    free(outputRow);
-    free(rowBytes);
+    HeapTags::release(outputRow);
+    HeapTags::release(rowBytes);
     return;
   }
 
@@ -804,8 +793,8 @@ void GfxRenderer::drawBitmap1Bit(const Bitmap& bitmap, const int x, const int y,
     // Read rows sequentially using readNextRow
     if (bitmap.readNextRow(outputRow, rowBytes) != BmpReaderError::Ok) {
       LOG_ERR("GFX", "Failed to read row %d from 1-bit bitmap", bmpY);
-      free(outputRow);
-      free(rowBytes);
+      HeapTags::release(outputRow);
+      HeapTags::release(rowBytes);
       return;
     }
 
@@ -840,8 +829,8 @@ void GfxRenderer::drawBitmap1Bit(const Bitmap& bitmap, const int x, const int y,
     }
   }
 
-  free(outputRow);
-  free(rowBytes);
+  HeapTags::release(outputRow);
+  HeapTags::release(rowBytes);
 }
 
 void GfxRenderer::fillPolygon(const int* xPoints, const int* yPoints, int numPoints, bool state) const {
@@ -903,8 +892,8 @@ void GfxRenderer::fillPolygon(const int* xPoints, const int* yPoints, int numPoi
       if (endX >= getScreenWidth()) endX = getScreenWidth() - 1;
 
       // Draw horizontal line
-      for (int x = startX; x <= endX; x++) {
-        drawPixel(x, scanY, state);
+      if (startX <= endX) {
+        fillSpan(startX, scanY, endX - startX + 1, 1, state ? SpanFill::Fill::Black : SpanFill::Fill::White);
       }
     }
   }
@@ -918,17 +907,39 @@ static unsigned long start_ms = 0;
 void GfxRenderer::clearScreen(const uint8_t color) const {
   start_ms = millis();
   display.clearScreen(color);
+  markAllDirty();
 }
 
 void GfxRenderer::invertScreen() const {
   for (uint32_t i = 0; i < frameBufferSize; i++) {
     frameBuffer[i] = ~frameBuffer[i];
   }
+  markAllDirty();
 }
 
 void GfxRenderer::displayBuffer(const HalDisplay::RefreshMode refreshMode) const {
   auto elapsed = millis() - start_ms;
   LOG_DBG("GFX", "Time = %lu ms from clearScreen to displayBuffer", elapsed);
+
+  // Full and half refreshes are requested to clean up ghosting, so only a fast refresh may be skipped or windowed
+  const bool fast = refreshMode == HalDisplay::FAST_REFRESH;
+  const bool panelKnown = displayedFrame.isValid();
+  FrameDiff::Rect changed;
+  const bool frameChanged = displayedFrame.update(frameBuffer, dirtyRegion, &changed);
+  dirtyRegion.clear();
+
+  if (fast && panelKnown) {
+    if (!frameChanged) {
+      LOG_DBG("GFX", "Frame unchanged, skipping display update");
+      return;
+    }
+    if (display.supportsWindowedUpdate() && (changed.width() < panelWidth || changed.height() < panelHeight)) {
+      LOG_DBG("GFX", "Windowed update %dx%d at (%d, %d)", changed.width(), changed.height(), changed.x0, changed.y0);
+      display.displayWindow(changed.x0, changed.y0, changed.width(), changed.height(), fadingFix);
+      return;
+    }
+  }
+  Trace::Span span(Trace::Stage::DisplayRefresh, refreshMode);
   display.displayBuffer(refreshMode, fadingFix);
 }
 
@@ -1196,23 +1207,38 @@ void GfxRenderer::drawTextRotated90CW(const int fontId, const int x, const int y
   }
 }
 
-uint8_t* GfxRenderer::getFrameBuffer() const { return frameBuffer; }
+uint8_t* GfxRenderer::getFrameBuffer() const {
+  // Callers may write anything anywhere
+  markAllDirty();
+  return frameBuffer;
+}
 
 size_t GfxRenderer::getBufferSize() const { return frameBufferSize; }
 
 // unused
 // void GfxRenderer::grayscaleRevert() const { display.grayscaleRevert(); }
 
-void GfxRenderer::copyGrayscaleLsbBuffers() const { display.copyGrayscaleLsbBuffers(frameBuffer); }
+// Grayscale updates load other data into the controller, so the BW frame it shows is no longer known
+void GfxRenderer::copyGrayscaleLsbBuffers() const {
+  displayedFrame.invalidate();
+  display.copyGrayscaleLsbBuffers(frameBuffer);
+}
 
-void GfxRenderer::copyGrayscaleMsbBuffers() const { display.copyGrayscaleMsbBuffers(frameBuffer); }
+void GfxRenderer::copyGrayscaleMsbBuffers() const {
+  displayedFrame.invalidate();
+  display.copyGrayscaleMsbBuffers(frameBuffer);
+}
 
-void GfxRenderer::displayGrayBuffer() const { display.displayGrayBuffer(fadingFix); }
+void GfxRenderer::displayGrayBuffer() const {
+  Trace::Span span(Trace::Stage::GrayscaleRefresh);
+  displayedFrame.invalidate();
+  display.displayGrayBuffer(fadingFix);
+}
 
 void GfxRenderer::freeBwBufferChunks() {
   for (auto& bwBufferChunk : bwBufferChunks) {
     if (bwBufferChunk) {
-      free(bwBufferChunk);
+      HeapTags::release(bwBufferChunk);
       bwBufferChunk = nullptr;
     }
   }
@@ -1230,13 +1256,13 @@ bool GfxRenderer::storeBwBuffer() {
     // Check if any chunks are already allocated
     if (bwBufferChunks[i]) {
       LOG_ERR("GFX", "!! BW buffer chunk %zu already stored - this is likely a bug, freeing chunk", i);
-      free(bwBufferChunks[i]);
+      HeapTags::release(bwBufferChunks[i]);
       bwBufferChunks[i] = nullptr;
     }
 
     const size_t offset = i * BW_BUFFER_CHUNK_SIZE;
     const size_t chunkSize = std::min(BW_BUFFER_CHUNK_SIZE, static_cast<size_t>(frameBufferSize - offset));
-    bwBufferChunks[i] = static_cast<uint8_t*>(malloc(chunkSize));
+    bwBufferChunks[i] = static_cast<uint8_t*>(HeapTags::alloc(HeapTags::Tag::BwBuffer, chunkSize));
 
     if (!bwBufferChunks[i]) {
       LOG_ERR("GFX", "!! Failed to allocate BW buffer chunk %zu (%zu bytes)", i, chunkSize);
@@ -1277,7 +1303,9 @@ void GfxRenderer::restoreBwBuffer() {
     const size_t chunkSize = std::min(BW_BUFFER_CHUNK_SIZE, static_cast<size_t>(frameBufferSize - offset));
     memcpy(frameBuffer + offset, bwBufferChunks[i], chunkSize);
   }
+  markAllDirty();
 
+  displayedFrame.invalidate();
   display.cleanupGrayscaleBuffers(frameBuffer);
 
   freeBwBufferChunks();
@@ -1290,6 +1318,7 @@ void GfxRenderer::restoreBwBuffer() {
  */
 void GfxRenderer::cleanupGrayscaleWithFrameBuffer() const {
   if (frameBuffer) {
+    displayedFrame.invalidate();
     display.cleanupGrayscaleBuffers(frameBuffer);
   }
 }
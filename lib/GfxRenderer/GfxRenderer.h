@@ -11,6 +11,8 @@ class FontCacheManager;
 #include <vector>
 
 #include "Bitmap.h"
+#include "FrameDiff.h"
+#include "SpanFill.h"
 
 // Color representation: uint8_t mapped to 4x4 Bayer matrix dithering levels
 // 0 = transparent, 1-16 = gray levels (white to black)
@@ -41,6 +43,10 @@ class GfxRenderer {
   uint16_t panelWidthBytes = HalDisplay::DISPLAY_WIDTH_BYTES;
   uint32_t frameBufferSize = HalDisplay::BUFFER_SIZE;
   std::vector<uint8_t*> bwBufferChunks;
+  // Physical region written since the last displayBuffer(), and per-row signatures of the frame the panel shows
+  mutable FrameDiff::Rect dirtyRegion;
+  mutable FrameDiff::FrameSignatures displayedFrame;
+  std::vector<uint32_t> displayedFrameSignatures;
   std::map<int, EpdFontFamily> fontMap;
 
   // Mutable because drawText() is const but needs to delegate scan-mode
@@ -55,6 +61,9 @@ class GfxRenderer {
   void drawPixelDither(int x, int y) const;
   template <Color color>
   void fillArc(int maxRadius, int cx, int cy, int xDir, int yDir) const;
+  void markAllDirty() const { dirtyRegion = FrameDiff::Rect::full(panelWidth, panelHeight); }
+  // Fill a logical rectangle through SpanFill, clipped to the panel
+  void fillSpan(int x, int y, int width, int height, SpanFill::Fill fill) const;
 
  public:
   explicit GfxRenderer(HalDisplay& halDisplay)
@@ -84,8 +93,9 @@ class GfxRenderer {
   int getScreenWidth() const;
   int getScreenHeight() const;
   void displayBuffer(HalDisplay::RefreshMode refreshMode = HalDisplay::FAST_REFRESH) const;
-  // EXPERIMENTAL: Windowed update - display only a rectangular region
-  // void displayWindow(int x, int y, int width, int height) const;
+  // Physical panel region drawn since the last displayBuffer(). Conservative: it may include pixels redrawn with
+  // their previous value. getFrameBuffer() hands out raw write access and so marks the whole frame dirty.
+  const FrameDiff::Rect& getDirtyRegion() const { return dirtyRegion; }
   void invertScreen() const;
   void clearScreen(uint8_t color = 0xFF) const;
   void getOrientedViewableTRBL(int* outTop, int* outRight, int* outBottom, int* outLeft) const;
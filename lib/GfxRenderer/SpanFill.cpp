@@ -0,0 +1,80 @@
+#include "SpanFill.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+namespace SpanFill {
+
+namespace {
+
+// Framebuffer byte for a physical row of `fill` starting at (phyX, phyY). Pixels at even and odd physical x are the
+// MSB-first bit masks 0xAA and 0x55; since the patterns repeat every 2 pixels, one byte covers the whole row.
+uint8_t rowValue(const Surface& surface, const Orientation orientation, const Fill fill, const int phyX,
+                 const int phyY) {
+  if (fill == Fill::Black) return 0x00;
+  if (fill == Fill::White) return 0xFF;
+
+  // phyX + 1 may be past the panel edge; the patterns only depend on parity, which the mapping still gets right
+  bool black[2];
+  for (int i = 0; i < 2; i++) {
+    int x = 0, y = 0;
+    toLogical(orientation, phyX + i, phyY, &x, &y, surface.width, surface.height);
+    black[(phyX + i) & 1] = isBlack(fill, x, y);
+  }
+  return static_cast<uint8_t>((black[0] ? 0 : 0xAA) | (black[1] ? 0 : 0x55));
+}
+
+}  // namespace
+
+void fillRow(uint8_t* row, const int x0, const int x1, const uint8_t value) {
+  const int firstByte = x0 >> 3;
+  const int lastByte = x1 >> 3;
+  const auto leftMask = static_cast<uint8_t>(0xFF >> (x0 & 7));
+  const auto rightMask = static_cast<uint8_t>(0xFF << (7 - (x1 & 7)));
+
+  if (firstByte == lastByte) {
+    const uint8_t mask = leftMask & rightMask;
+    row[firstByte] = static_cast<uint8_t>((row[firstByte] & ~mask) | (value & mask));
+    return;
+  }
+  row[firstByte] = static_cast<uint8_t>((row[firstByte] & ~leftMask) | (value & leftMask));
+  if (lastByte - firstByte > 1) {
+    memset(row + firstByte + 1, value, lastByte - firstByte - 1);
+  }
+  row[lastByte] = static_cast<uint8_t>((row[lastByte] & ~rightMask) | (value & rightMask));
+}
+
+FrameDiff::Rect fillRect(const Surface& surface, const Orientation orientation, const int x, const int y,
+                         const int width, const int height, const Fill fill) {
+  FrameDiff::Rect written;
+  if (width <= 0 || height <= 0) {
+    return written;
+  }
+
+  // Opposite corners give the physical rectangle in every orientation
+  int ax = 0, ay = 0, bx = 0, by = 0;
+  toPhysical(orientation, x, y, &ax, &ay, surface.width, surface.height);
+  toPhysical(orientation, x + width - 1, y + height - 1, &bx, &by, surface.width, surface.height);
+  const int x0 = std::max(std::min(ax, bx), 0);
+  const int x1 = std::min(std::max(ax, bx), surface.width - 1);
+  const int y0 = std::max(std::min(ay, by), 0);
+  const int y1 = std::min(std::max(ay, by), surface.height - 1);
+  if (x0 > x1 || y0 > y1) {
+    return written;
+  }
+
+  // Rows alternate between two values at most
+  const uint8_t values[2] = {rowValue(surface, orientation, fill, x0, y0),
+                             rowValue(surface, orientation, fill, x0, y0 + 1)};
+  uint8_t* row = surface.buffer + static_cast<size_t>(y0) * surface.stride;
+  for (int phyY = y0; phyY <= y1; phyY++, row += surface.stride) {
+    fillRow(row, x0, x1, values[(phyY - y0) & 1]);
+  }
+
+  written.include(x0, y0);
+  written.include(x1, y1);
+  return written;
+}
+
+}  // namespace SpanFill
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "FrameDiff.h"
+
+/**
+ * Rectangle fills on the 1-bit panel framebuffer (native 800x480 layout, MSB-first bits, 0 = black).
+ *
+ * A logical rectangle is transformed to physical coordinates once, clipped to the panel, and then written a row at a
+ * time: whole bytes with memset, partial bytes at the edges with a mask. Every orientation maps a logical rectangle
+ * to a physical one, so portrait fills are as cheap as landscape ones.
+ *
+ * The gray fills are the 2x2 dither patterns of GfxRenderer::drawPixelDither, anchored to logical coordinates so they
+ * line up with pixels drawn one at a time. Their period is 2 on both axes, so each physical row is a single repeated
+ * byte.
+ */
+namespace SpanFill {
+
+// Same values and order as GfxRenderer::Orientation
+enum Orientation : uint8_t { Portrait, LandscapeClockwise, PortraitInverted, LandscapeCounterClockwise };
+
+enum class Fill : uint8_t { Black, White, LightGray, DarkGray };
+
+struct Surface {
+  uint8_t* buffer;
+  uint16_t width;   // Physical pixels
+  uint16_t height;  // Physical rows
+  uint16_t stride;  // Bytes per row
+};
+
+// Translate logical (x,y) coordinates to physical panel coordinates
+inline void toPhysical(const Orientation orientation, const int x, const int y, int* phyX, int* phyY,
+                       const uint16_t panelWidth, const uint16_t panelHeight) {
+  switch (orientation) {
+    case Portrait:
+      // Logical portrait (480x800) → panel (800x480), rotated 90 degrees clockwise
+      *phyX = y;
+      *phyY = panelHeight - 1 - x;
+      break;
+    case LandscapeClockwise:
+      // Logical landscape (800x480) rotated 180 degrees
+      *phyX = panelWidth - 1 - x;
+      *phyY = panelHeight - 1 - y;
+      break;
+    case PortraitInverted:
+      // Logical portrait (480x800) → panel (800x480), rotated 90 degrees counter-clockwise
+      *phyX = panelWidth - 1 - y;
+      *phyY = x;
+      break;
+    case LandscapeCounterClockwise:
+      // Native panel orientation
+      *phyX = x;
+      *phyY = y;
+      break;
+  }
+}
+
+// Inverse of toPhysical()
+inline void toLogical(const Orientation orientation, const int phyX, const int phyY, int* x, int* y,
+                      const uint16_t panelWidth, const uint16_t panelHeight) {
+  switch (orientation) {
+    case Portrait:
+      *x = panelHeight - 1 - phyY;
+      *y = phyX;
+      break;
+    case LandscapeClockwise:
+      *x = panelWidth - 1 - phyX;
+      *y = panelHeight - 1 - phyY;
+      break;
+    case PortraitInverted:
+      *x = phyY;
+      *y = panelWidth - 1 - phyX;
+      break;
+    case LandscapeCounterClockwise:
+      *x = phyX;
+      *y = phyY;
+      break;
+  }
+}
+
+// Whether `fill` paints logical pixel (x, y) black; the patterns of GfxRenderer::drawPixelDither
+inline bool isBlack(const Fill fill, const int x, const int y) {
+  switch (fill) {
+    case Fill::Black:
+      return true;
+    case Fill::White:
+      return false;
+    case Fill::LightGray:
+      return x % 2 == 0 && y % 2 == 0;
+    case Fill::DarkGray:
+      return (x + y) % 2 == 0;
+  }
+  return false;
+}
+
+// Fill the logical rectangle, clipped to the panel. Returns the physical rectangle written (empty if none), for the
+// caller's dirty region.
+FrameDiff::Rect fillRect(const Surface& surface, Orientation orientation, int x, int y, int width, int height,
+                         Fill fill);
+
+// Write `value` to physical pixels x0..x1 (inclusive, within the row) of one row
+void fillRow(uint8_t* row, int x0, int x1, uint8_t value);
+
+}  // namespace SpanFill
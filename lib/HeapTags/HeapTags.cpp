@@ -0,0 +1,181 @@
+#include "HeapTags.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+namespace HeapTags {
+
+namespace {
+
+// Block header, sized to keep the caller's pointer as aligned as malloc's
+struct Header {
+  uint32_t bytes;  // Including the header
+  uint8_t tag;
+};
+constexpr size_t HEADER_SIZE = alignof(std::max_align_t) > sizeof(Header) ? alignof(std::max_align_t) : 8;
+static_assert(HEADER_SIZE >= sizeof(Header), "Header must fit in its slot");
+
+struct Counters {
+  std::atomic<size_t> current{0};
+  std::atomic<size_t> peak{0};
+  std::atomic<size_t> largestFreeAtPeak{0};
+  std::atomic<size_t> scopePeak{0};
+  std::atomic<uint32_t> allocations{0};
+  std::atomic<uint32_t> failures{0};
+  std::atomic<size_t> lastFailedBytes{0};
+};
+
+Counters counters[TAG_COUNT];
+std::atomic<size_t (*)()> largestFreeBlockProbe{nullptr};
+
+constexpr const char* TAG_NAMES[] = {"inflate",     "font_decompressor", "css",
+                                     "bw_buffer",   "expat",             "image_decode",
+                                     "hyphenation", "hyphenation_pack",  "font_pack"};
+static_assert(sizeof(TAG_NAMES) / sizeof(TAG_NAMES[0]) == TAG_COUNT, "Every heap tag needs a name");
+
+// Raise `value` to at least `candidate`; returns true if it was raised
+bool raise(std::atomic<size_t>& value, const size_t candidate) {
+  size_t seen = value.load(std::memory_order_relaxed);
+  while (candidate > seen) {
+    if (value.compare_exchange_weak(seen, candidate, std::memory_order_relaxed)) return true;
+  }
+  return false;
+}
+
+void onAllocated(const Tag tag, const size_t bytes) {
+  Counters& c = counters[static_cast<size_t>(tag)];
+  c.allocations.fetch_add(1, std::memory_order_relaxed);
+  const size_t now = c.current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  raise(c.scopePeak, now);
+  if (raise(c.peak, now)) {
+    if (const auto probe = largestFreeBlockProbe.load(std::memory_order_relaxed)) {
+      c.largestFreeAtPeak.store(probe(), std::memory_order_relaxed);
+    }
+  }
+}
+
+void onFailed(const Tag tag, const size_t bytes) {
+  Counters& c = counters[static_cast<size_t>(tag)];
+  c.failures.fetch_add(1, std::memory_order_relaxed);
+  c.lastFailedBytes.store(bytes, std::memory_order_relaxed);
+}
+
+void* finishBlock(void* raw, const Tag tag, const size_t total) {
+  Header header{static_cast<uint32_t>(total), static_cast<uint8_t>(tag)};
+  memcpy(raw, &header, sizeof(header));
+  onAllocated(tag, total);
+  return static_cast<uint8_t*>(raw) + HEADER_SIZE;
+}
+
+Header headerOf(void* ptr) {
+  Header header;
+  memcpy(&header, static_cast<uint8_t*>(ptr) - HEADER_SIZE, sizeof(header));
+  return header;
+}
+
+}  // namespace
+
+void* alloc(const Tag tag, const size_t bytes) {
+  const size_t total = bytes + HEADER_SIZE;
+  void* raw = total > UINT32_MAX ? nullptr : malloc(total);
+  if (!raw) {
+    onFailed(tag, bytes);
+    return nullptr;
+  }
+  return finishBlock(raw, tag, total);
+}
+
+void* allocZeroed(const Tag tag, const size_t count, const size_t size) {
+  if (size != 0 && count > (SIZE_MAX - HEADER_SIZE) / size) {
+    onFailed(tag, SIZE_MAX);
+    return nullptr;
+  }
+  void* p = alloc(tag, count * size);
+  if (p) memset(p, 0, count * size);
+  return p;
+}
+
+void* reallocate(const Tag tag, void* ptr, const size_t bytes) {
+  if (!ptr) return alloc(tag, bytes);
+  if (bytes == 0) {
+    release(ptr);
+    return nullptr;
+  }
+
+  const Header old = headerOf(ptr);
+  const size_t total = bytes + HEADER_SIZE;
+  void* raw = total > UINT32_MAX ? nullptr : realloc(static_cast<uint8_t*>(ptr) - HEADER_SIZE, total);
+  if (!raw) {
+    // The old block is untouched and still accounted
+    onFailed(static_cast<Tag>(old.tag), bytes);
+    return nullptr;
+  }
+  counters[old.tag].current.fetch_sub(old.bytes, std::memory_order_relaxed);
+  return finishBlock(raw, static_cast<Tag>(old.tag), total);
+}
+
+void release(void* ptr) {
+  if (!ptr) return;
+  const Header header = headerOf(ptr);
+  if (header.tag < TAG_COUNT) {
+    counters[header.tag].current.fetch_sub(header.bytes, std::memory_order_relaxed);
+  }
+  free(static_cast<uint8_t*>(ptr) - HEADER_SIZE);
+}
+
+Usage usage(const Tag tag) {
+  const Counters& c = counters[static_cast<size_t>(tag)];
+  Usage u;
+  u.currentBytes = c.current.load(std::memory_order_relaxed);
+  u.peakBytes = c.peak.load(std::memory_order_relaxed);
+  u.largestFreeAtPeak = c.largestFreeAtPeak.load(std::memory_order_relaxed);
+  u.scopePeakBytes = c.scopePeak.load(std::memory_order_relaxed);
+  u.allocations = c.allocations.load(std::memory_order_relaxed);
+  u.failures = c.failures.load(std::memory_order_relaxed);
+  u.lastFailedBytes = c.lastFailedBytes.load(std::memory_order_relaxed);
+  return u;
+}
+
+const char* tagName(const Tag tag) {
+  const auto index = static_cast<size_t>(tag);
+  return index < TAG_COUNT ? TAG_NAMES[index] : "unknown";
+}
+
+void setLargestFreeBlockProbe(size_t (*probe)()) { largestFreeBlockProbe.store(probe); }
+
+size_t largestFreeBlock() {
+  const auto probe = largestFreeBlockProbe.load(std::memory_order_relaxed);
+  return probe ? probe() : 0;
+}
+
+void beginScope() {
+  for (auto& c : counters) {
+    c.scopePeak.store(c.current.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  }
+}
+
+void reset() {
+  for (auto& c : counters) {
+    c.current.store(0);
+    c.peak.store(0);
+    c.largestFreeAtPeak.store(0);
+    c.scopePeak.store(0);
+    c.allocations.store(0);
+    c.failures.store(0);
+    c.lastFailedBytes.store(0);
+  }
+}
+
+size_t formatUsage(const Tag tag, char* buffer, const size_t size) {
+  const Usage u = usage(tag);
+  const int len = snprintf(buffer, size,
+                           "%s: current=%zu peak=%zu scope_peak=%zu largest_free_at_peak=%zu allocs=%lu failures=%lu",
+                           tagName(tag), u.currentBytes, u.peakBytes, u.scopePeakBytes, u.largestFreeAtPeak,
+                           static_cast<unsigned long>(u.allocations), static_cast<unsigned long>(u.failures));
+  if (len < 0) return 0;
+  return static_cast<size_t>(len) < size ? static_cast<size_t>(len) : size - 1;
+}
+
+}  // namespace HeapTags
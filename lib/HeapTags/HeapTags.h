@@ -0,0 +1,129 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cstdlib>
+#include <new>
+
+/**
+ * Per-subsystem heap accounting.
+ *
+ * The large, long-lived or bursty allocations of a few subsystems go through alloc()/release() with a tag, so when a
+ * big allocation fails we can tell who owns the heap. For every tag we keep the bytes currently held, the peak since
+ * boot, the largest free heap block seen when that peak was reached, and a peak since the last beginScope() (reset
+ * whenever an activity is entered).
+ *
+ * Each block carries a small header holding its size and tag, so release() needs neither. Standard containers can be
+ * accounted with HeapTags::Allocator.
+ *
+ * The module is std-only; the firmware installs a largest-free-block probe at boot, host builds run without one.
+ */
+namespace HeapTags {
+
+enum class Tag : uint8_t {
+  Inflate,           // InflateReader streaming ring buffer
+  FontDecompressor,  // Page glyph slots, prewarm temp buffers and the hot group
+  Css,               // Parsed CSS rule map
+  BwBuffer,          // GfxRenderer BW buffer chunks stored across grayscale passes
+  Expat,             // XML parser state
+  ImageDecode,       // JPEG/PNG decoder buffers, pixel cache and image planes
+  Hyphenation,       // Hyphenation result cache of the section being built
+  HyphenationPack,   // Sector buffer while a hyphenation pattern pack is copied into flash
+  FontPack,          // Sector buffer while font packs are copied into flash
+  Count
+};
+
+constexpr size_t TAG_COUNT = static_cast<size_t>(Tag::Count);
+
+struct Usage {
+  size_t currentBytes = 0;
+  size_t peakBytes = 0;           // Since boot (or reset())
+  size_t largestFreeAtPeak = 0;   // Largest free heap block when peakBytes was reached; 0 without a probe
+  size_t scopePeakBytes = 0;      // Since the last beginScope()
+  uint32_t allocations = 0;
+  uint32_t failures = 0;
+  size_t lastFailedBytes = 0;
+};
+
+// malloc/calloc/realloc/free equivalents. Blocks must be released with release(), never free().
+void* alloc(Tag tag, size_t bytes);
+void* allocZeroed(Tag tag, size_t count, size_t size);
+void* reallocate(Tag tag, void* ptr, size_t bytes);
+void release(void* ptr);
+
+Usage usage(Tag tag);
+const char* tagName(Tag tag);
+
+// Called whenever a tag reaches a new peak, to record how fragmented the heap was at that moment
+void setLargestFreeBlockProbe(size_t (*probe)());
+
+// Largest free heap block right now, or 0 without a probe
+size_t largestFreeBlock();
+
+// Start a new high-water scope: every tag's scope peak drops to its current usage
+void beginScope();
+
+// Clear all counters (host benchmarks)
+void reset();
+
+// Buffer size that fits any line produced by formatUsage()
+constexpr size_t MAX_LINE = 160;
+
+// Format a tag's usage as one line without a trailing newline. Returns the line length.
+size_t formatUsage(Tag tag, char* buffer, size_t size);
+
+// `new (std::nothrow) T()` / `delete` equivalents for single tagged objects such as image decoders
+template <typename T>
+T* create(const Tag tag) {
+  void* p = alloc(tag, sizeof(T));
+  return p ? new (p) T() : nullptr;
+}
+
+template <typename T>
+void destroy(T* object) {
+  if (!object) return;
+  object->~T();
+  release(object);
+}
+
+// Standard allocator that accounts a container's storage under a tag
+template <typename T, Tag tag>
+struct Allocator {
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = Allocator<U, tag>;
+  };
+
+  Allocator() = default;
+  template <typename U>
+  Allocator(const Allocator<U, tag>&) {}
+
+  T* allocate(const size_t n) {
+    void* p = alloc(tag, n * sizeof(T));
+    if (!p) {
+      // Same outcome as std::allocator running out of memory
+#if __cpp_exceptions
+      throw std::bad_alloc();
+#else
+      std::abort();
+#endif
+    }
+    return static_cast<T*>(p);
+  }
+
+  void deallocate(T* p, size_t) { release(p); }
+
+  template <typename U>
+  bool operator==(const Allocator<U, tag>&) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const Allocator<U, tag>&) const {
+    return false;
+  }
+};
+
+}  // namespace HeapTags
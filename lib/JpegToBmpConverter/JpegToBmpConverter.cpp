@@ -169,6 +169,8 @@ constexpr size_t MIN_FREE_HEAP = JPEG_DECODER_SIZE + 32 * 1024;
 // Safe in single-threaded embedded context; never accessed concurrently.
 static FsFile* s_jpegFile = nullptr;
 
+bool (*abortCheck)() = nullptr;
+
 void* bmpJpegOpen(const char* /*filename*/, int32_t* size) {
   if (!s_jpegFile || !*s_jpegFile) return nullptr;
   s_jpegFile->seek(0);
@@ -330,6 +332,12 @@ int bmpDrawCallback(JPEGDRAW* pDraw) {
   // Wait for the last MCU column before processing any rows
   if (blockX + validW < ctx->srcWidth) return 1;
 
+  if (abortCheck && abortCheck()) {
+    LOG_DBG("JPG", "Conversion aborted at source row %d", blockY);
+    ctx->error = true;
+    return 0;
+  }
+
   // Process each complete source row in this MCU row
   const int endRow = blockY + blockH;
 
@@ -537,6 +545,8 @@ bool JpegToBmpConverter::jpegFileToBmpStreamInternal(FsFile& jpegFile, Print& bm
   return true;
 }
 
+void JpegToBmpConverter::setAbortCheck(bool (*check)()) { abortCheck = check; }
+
 // Core function: Convert JPEG file to 2-bit BMP (uses default target size)
 bool JpegToBmpConverter::jpegFileToBmpStream(FsFile& jpegFile, Print& bmpOut, bool crop) {
   // Use runtime display dimensions (swapped for portrait cover sizing)
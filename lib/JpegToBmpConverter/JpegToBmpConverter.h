@@ -15,4 +15,7 @@ class JpegToBmpConverter {
   static bool jpegFileToBmpStreamWithSize(FsFile& jpegFile, Print& bmpOut, int targetMaxWidth, int targetMaxHeight);
   // Convert to 1-bit BMP (black and white only, no grays) for fast home screen rendering
   static bool jpegFileTo1BitBmpStreamWithSize(FsFile& jpegFile, Print& bmpOut, int targetMaxWidth, int targetMaxHeight);
+  // Polled once per MCU row; a conversion it answers true for stops and fails, so a background task can give up
+  // mid-decode. The check decides which task it applies to. Pass nullptr to remove it.
+  static void setAbortCheck(bool (*check)());
 };
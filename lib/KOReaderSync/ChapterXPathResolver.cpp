@@ -79,7 +79,7 @@ size_t countUtf8Codepoints(const XML_Char* data, const int len) {
 class ParagraphTextCounter final : public Print {
  public:
   ParagraphTextCounter() {
-    parser = XML_ParserCreate(nullptr);
+    parser = createXmlParser();
     if (!parser) {
       LOG_ERR("KOX", "Failed to create XML parser");
       return;
@@ -200,7 +200,7 @@ class ParagraphTextCounter final : public Print {
 class XPathParagraphResolver final : public Print {
  public:
   explicit XPathParagraphResolver(const int targetParagraph) : targetParagraph(targetParagraph) {
-    parser = XML_ParserCreate(nullptr);
+    parser = createXmlParser();
     if (!parser) {
       LOG_ERR("KOX", "Failed to create XML parser");
       return;
@@ -328,7 +328,7 @@ class XPathParagraphResolver final : public Print {
 class XPathProgressResolver final : public Print {
  public:
   explicit XPathProgressResolver(const size_t targetVisibleChar) : targetVisibleChar(targetVisibleChar) {
-    parser = XML_ParserCreate(nullptr);
+    parser = createXmlParser();
     if (!parser) {
       LOG_ERR("KOX", "Failed to create XML parser");
       return;
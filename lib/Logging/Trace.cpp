@@ -0,0 +1,68 @@
+#include "Trace.h"
+
+#include <Arduino.h>
+
+#include <cstdio>
+
+namespace Trace {
+
+namespace {
+
+Event events[CAPACITY];
+size_t head = 0;   // Next slot to write
+size_t count = 0;  // Valid events, up to CAPACITY
+portMUX_TYPE traceMux = portMUX_INITIALIZER_UNLOCKED;
+
+constexpr const char* STAGE_NAMES[] = {
+    "input",            "activity_loop",     "render_task", "section_load", "page_load",
+    "page_cache_hit",   "page_read_ahead",   "prewarm",     "bw_render",    "display_refresh",
+    "grayscale_render", "grayscale_refresh",
+};
+static_assert(sizeof(STAGE_NAMES) / sizeof(STAGE_NAMES[0]) == static_cast<size_t>(Stage::Count),
+              "Every trace stage needs a name");
+
+}  // namespace
+
+void record(const Stage stage, const Kind kind, const uint16_t arg) { recordAt(micros(), stage, kind, arg); }
+
+void recordAt(const uint32_t timeUs, const Stage stage, const Kind kind, const uint16_t arg) {
+  taskENTER_CRITICAL(&traceMux);
+  events[head] = {timeUs, static_cast<uint8_t>(stage), kind, arg};
+  head = (head + 1) % CAPACITY;
+  if (count < CAPACITY) count++;
+  taskEXIT_CRITICAL(&traceMux);
+}
+
+const char* stageName(const Stage stage) {
+  const auto index = static_cast<size_t>(stage);
+  return index < static_cast<size_t>(Stage::Count) ? STAGE_NAMES[index] : "unknown";
+}
+
+size_t snapshot(Event* out, const size_t maxEvents) {
+  taskENTER_CRITICAL(&traceMux);
+  const size_t copied = count < maxEvents ? count : maxEvents;
+  // Oldest of the events being copied
+  size_t index = (head + CAPACITY - copied) % CAPACITY;
+  for (size_t i = 0; i < copied; i++) {
+    out[i] = events[index];
+    index = (index + 1) % CAPACITY;
+  }
+  taskEXIT_CRITICAL(&traceMux);
+  return copied;
+}
+
+size_t formatEvent(const Event& event, char* buffer, const size_t size) {
+  const int len = snprintf(buffer, size, "%lu %c %s %u\n", static_cast<unsigned long>(event.timeUs),
+                           static_cast<char>(event.kind), stageName(static_cast<Stage>(event.stage)), event.arg);
+  if (len < 0) return 0;
+  return static_cast<size_t>(len) < size ? static_cast<size_t>(len) : size - 1;
+}
+
+void clear() {
+  taskENTER_CRITICAL(&traceMux);
+  head = 0;
+  count = 0;
+  taskEXIT_CRITICAL(&traceMux);
+}
+
+}  // namespace Trace
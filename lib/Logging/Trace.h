@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+Always-on latency trace for the page-turn path.
+
+Events go into a fixed ring of CAPACITY entries in DRAM (8 bytes each) with microsecond timestamps, independent of
+LOG_LEVEL, so release builds can be profiled too. Spans are recorded as a BEGIN/END pair, and one-off events such as
+an input edge as INSTANT. Recording is a few dozen cycles under a spinlock and never allocates.
+
+The ring is dumped over serial with `CMD:TRACE` and over HTTP from /api/trace, one event per line:
+    <time_us> <B|E|I> <stage> <arg>
+scripts/trace_summary.py turns such a dump into per-stage p50/p95 latencies.
+*/
+namespace Trace {
+
+enum class Stage : uint8_t {
+  Input,             // Button edge, at its interrupt time if it had one (instant; arg 1 = press, 0 = release)
+  ActivityLoop,      // Activity loop iteration that handled an input edge
+  RenderTask,        // Render task woken up and rendering the current activity
+  SectionLoad,       // Section cache opened or built (arg = spine index)
+  PageLoad,          // Page deserialized from the section cache (arg = page number)
+  PageCacheHit,      // Page served from the page cache instead (instant; arg = page number)
+  PageReadAhead,     // Neighbouring page deserialized into the page cache after a render (arg = page number)
+  Prewarm,           // Font scan pass and glyph prewarm
+  BwRender,          // BW render of the page and status bar
+  DisplayRefresh,    // BW panel update (arg = HalDisplay::RefreshMode)
+  GrayscaleRender,   // One grayscale render pass (arg = GfxRenderer::RenderMode)
+  GrayscaleRefresh,  // Grayscale panel update
+  Count
+};
+
+enum Kind : uint8_t { BEGIN = 'B', END = 'E', INSTANT = 'I' };
+
+struct Event {
+  uint32_t timeUs;  // micros(), wraps after ~71 minutes
+  uint8_t stage;
+  uint8_t kind;
+  uint16_t arg;
+};
+
+constexpr size_t CAPACITY = 256;
+// Longest line produced by formatEvent(), including the newline and terminator
+constexpr size_t MAX_LINE = 48;
+
+void record(Stage stage, Kind kind, uint16_t arg = 0);
+
+// Record an event that happened at `timeUs` (a micros() value), e.g. an interrupt noted earlier. Events stay in the
+// order they were recorded, so the dump can be slightly out of time order around such an event.
+void recordAt(uint32_t timeUs, Stage stage, Kind kind, uint16_t arg = 0);
+
+inline void instant(const Stage stage, const uint16_t arg = 0) { record(stage, INSTANT, arg); }
+
+// Records a BEGIN event now and the matching END event when it goes out of scope
+class Span {
+ public:
+  explicit Span(const Stage stage, const uint16_t arg = 0) : stage(stage) { record(stage, BEGIN, arg); }
+  ~Span() { record(stage, END); }
+  Span(const Span&) = delete;
+  Span& operator=(const Span&) = delete;
+
+ private:
+  Stage stage;
+};
+
+const char* stageName(Stage stage);
+
+// Copy up to `maxEvents` of the most recent events into `out`, oldest first. Returns the number copied.
+size_t snapshot(Event* out, size_t maxEvents);
+
+// Format one event as a dump line (see above). Returns the line length.
+size_t formatEvent(const Event& event, char* buffer, size_t size);
+
+void clear();
+
+}  // namespace Trace
@@ -6,7 +6,7 @@
 #include <cstring>
 
 OpdsParser::OpdsParser() {
-  parser = XML_ParserCreate(nullptr);
+  parser = createXmlParser();
   if (!parser) {
     errorOccured = true;
     LOG_DBG("OPDS", "Couldn't allocate memory for parser");
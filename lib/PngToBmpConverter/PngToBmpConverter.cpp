@@ -171,6 +171,8 @@ void writeBmpHeader2bit(Print& bmpOut, const int width, const int height) {
     bmpOut.write(i);
   }
 }
+
+bool (*abortCheck)() = nullptr;
 }  // namespace
 
 // Context for streaming PNG decompression
@@ -666,6 +668,12 @@ bool PngToBmpConverter::pngFileToBmpStreamInternal(FsFile& pngFile, Print& bmpOu
 
   // Process each scanline
   for (uint32_t y = 0; y < height; y++) {
+    if (abortCheck && abortCheck()) {
+      LOG_DBG("PNG", "Conversion aborted at scanline %u", y);
+      success = false;
+      break;
+    }
+
     // Decode one scanline
     if (!decodeScanline(ctx)) {
       LOG_ERR("PNG", "Failed to decode scanline %u", y);
@@ -820,6 +828,8 @@ bool PngToBmpConverter::pngFileToBmpStreamInternal(FsFile& pngFile, Print& bmpOu
   return success;
 }
 
+void PngToBmpConverter::setAbortCheck(bool (*check)()) { abortCheck = check; }
+
 bool PngToBmpConverter::pngFileToBmpStream(FsFile& pngFile, Print& bmpOut, bool crop) {
   // Use runtime display dimensions (swapped for portrait cover sizing)
   const int targetWidth = display.getDisplayHeight();
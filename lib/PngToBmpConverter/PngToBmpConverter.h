@@ -12,4 +12,7 @@ class PngToBmpConverter {
   static bool pngFileToBmpStream(FsFile& pngFile, Print& bmpOut, bool crop = true);
   static bool pngFileToBmpStreamWithSize(FsFile& pngFile, Print& bmpOut, int targetMaxWidth, int targetMaxHeight);
   static bool pngFileTo1BitBmpStreamWithSize(FsFile& pngFile, Print& bmpOut, int targetMaxWidth, int targetMaxHeight);
+  // Polled once per scanline; a conversion it answers true for stops and fails, so a background task can give up
+  // mid-decode. The check decides which task it applies to. Pass nullptr to remove it.
+  static void setAbortCheck(bool (*check)());
 };
@@ -37,16 +37,32 @@ static void writeString(FsFile& file, const std::string& s) {
 }
 
 static void readString(std::istream& is, std::string& s) {
-  uint32_t len;
+  uint32_t len = 0;
   readPod(is, len);
   s.resize(len);
   is.read(&s[0], len);
 }
 
 static void readString(FsFile& file, std::string& s) {
-  uint32_t len;
+  uint32_t len = 0;
   readPod(file, len);
   s.resize(len);
   file.read(&s[0], len);
 }
+
+// Variants for files that may be cut short or corrupt: they fail on a short read, and on a string over `maxLength`
+// before allocating it
+template <typename T>
+static bool readPodChecked(FsFile& file, T& value) {
+  return file.read(reinterpret_cast<uint8_t*>(&value), sizeof(T)) == static_cast<int>(sizeof(T));
+}
+
+static bool readStringChecked(FsFile& file, std::string& s, const uint32_t maxLength) {
+  uint32_t len = 0;
+  if (!readPodChecked(file, len) || len > maxLength) {
+    return false;
+  }
+  s.resize(len);
+  return len == 0 || file.read(reinterpret_cast<uint8_t*>(&s[0]), len) == static_cast<int>(len);
+}
 }  // namespace serialization
@@ -0,0 +1,548 @@
+#include "TxtBlockParser.h"
+
+#include <algorithm>
+
+namespace {
+constexpr uint8_t BOM[3] = {0xEF, 0xBB, 0xBF};
+constexpr size_t MAX_LIST_LEVEL = 8;
+constexpr char BULLET[] = "\xe2\x80\xa2";
+
+bool isSpace(const char c) { return c == ' ' || c == '\t'; }
+
+// Non-ASCII bytes count as word characters, so intraword underscores in any script stay literal
+bool isWordChar(const char c) {
+  const auto u = static_cast<unsigned char>(c);
+  return u >= 0x80 || (u >= '0' && u <= '9') || (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z');
+}
+
+bool isAsciiPunct(const char c) {
+  return (c >= '!' && c <= '/') || (c >= ':' && c <= '@') || (c >= '[' && c <= '`') || (c >= '{' && c <= '~');
+}
+
+bool startsFence(const char* text, const size_t length, const char fence) {
+  return length >= 3 && text[0] == fence && text[1] == fence && text[2] == fence;
+}
+
+// Three or more of the same '-', '*' or '_', optionally separated by spaces, and nothing else
+bool isThematicBreak(const char* text, const size_t length) {
+  if (length == 0 || (text[0] != '-' && text[0] != '*' && text[0] != '_')) {
+    return false;
+  }
+  size_t markers = 0;
+  for (size_t i = 0; i < length; i++) {
+    if (text[i] == text[0]) {
+      markers++;
+    } else if (!isSpace(text[i])) {
+      return false;
+    }
+  }
+  return markers >= 3;
+}
+}  // namespace
+
+TxtBlockParser::TxtBlockParser(const Format format, Sink& sink, const uint32_t startOffset, const uint8_t state)
+    : format(format),
+      sink(sink),
+      offset(startOffset),
+      state(state),
+      bomMatched(startOffset == 0 ? 0 : sizeof(BOM)),
+      lineStart(startOffset),
+      lineState(state),
+      lineMode(format == Format::Plain ? LineMode::Words : LineMode::Buffer) {
+  if (format == Format::Markdown) {
+    lineBuffer.reserve(MAX_LINE_PREFIX);
+  } else {
+    openBlock(BlockKind::Paragraph, 0);
+  }
+}
+
+void TxtBlockParser::feed(const uint8_t* data, const size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    const uint8_t c = data[i];
+    if (bomMatched < sizeof(BOM)) {
+      if (c == BOM[bomMatched]) {
+        bomMatched++;
+        offset++;
+        continue;
+      }
+      // Not a byte order mark after all: the bytes held back are text
+      const uint8_t held = bomMatched;
+      bomMatched = sizeof(BOM);
+      for (uint8_t j = 0; j < held; j++) {
+        byte(BOM[j]);
+      }
+    }
+    byte(c);
+    offset++;
+  }
+}
+
+void TxtBlockParser::finish() {
+  if (bomMatched < sizeof(BOM)) {
+    const uint8_t held = bomMatched;
+    bomMatched = sizeof(BOM);
+    for (uint8_t j = 0; j < held; j++) {
+      byte(BOM[j]);
+    }
+  }
+  endLine();
+  closeBlock();
+}
+
+void TxtBlockParser::byte(const uint8_t c) {
+  if (c == '\r' || c == '\0') {
+    // Never drawn
+    return;
+  }
+  if (c == '\n') {
+    endLine();
+    return;
+  }
+
+  const char ch = static_cast<char>(c);
+  switch (lineMode) {
+    case LineMode::Buffer:
+      lineBuffer.push_back(ch);
+      if (lineBuffer.size() >= MAX_LINE_PREFIX) {
+        classifyLine(false);
+      }
+      break;
+    case LineMode::Inline:
+      inlineChar(ch);
+      break;
+    case LineMode::Words:
+      wordChar(ch);
+      break;
+    case LineMode::Skip:
+      break;
+  }
+}
+
+void TxtBlockParser::endLine() {
+  if (format == Format::Plain) {
+    flushWord();
+    closeBlock();
+  } else {
+    if (lineMode == LineMode::Buffer) {
+      classifyLine(true);
+    }
+    if (lineMode == LineMode::Inline) {
+      // A line break inside a paragraph is a space
+      endInline();
+      if (blockOpen && block.kind == BlockKind::Heading) {
+        closeBlock();
+      }
+    } else if (lineMode == LineMode::Words) {
+      flushWord();
+      closeBlock();
+    }
+  }
+
+  lineStart = offset + 1;
+  lineState = state;
+  lineBuffer.clear();
+  afterSpace = true;
+  prevAlnum = false;
+  wordContinues = false;
+  if (format == Format::Plain) {
+    lineMode = LineMode::Words;
+    openBlock(BlockKind::Paragraph, 0);
+  } else {
+    lineMode = LineMode::Buffer;
+  }
+}
+
+void TxtBlockParser::classifyLine(const bool complete) {
+  const char* line = lineBuffer.data();
+  const size_t lineLength = lineBuffer.size();
+  size_t indent = 0;
+  size_t spaces = 0;
+  while (indent < lineLength && isSpace(line[indent])) {
+    spaces += line[indent] == '\t' ? 4 : 1;
+    indent++;
+  }
+  const char* rest = line + indent;
+  size_t restLength = lineLength - indent;
+
+  if (state & STATE_FENCE) {
+    const char fence = (state & STATE_TILDE_FENCE) ? '~' : '`';
+    closeBlock();
+    if (spaces < 4 && startsFence(rest, restLength, fence)) {
+      state = 0;
+      lineMode = LineMode::Skip;
+      return;
+    }
+    // Code keeps its markup; the indentation becomes a margin
+    openBlock(BlockKind::Code, static_cast<uint8_t>(std::min<size_t>(spaces, UINT8_MAX)));
+    lineMode = LineMode::Words;
+    for (size_t i = 0; i < restLength; i++) {
+      wordChar(rest[i]);
+    }
+    return;
+  }
+
+  if (restLength == 0) {
+    closeBlock();
+    previousLineBlank = true;
+    lineMode = LineMode::Skip;
+    return;
+  }
+  const bool wasBlank = previousLineBlank;
+  previousLineBlank = false;
+  lineMode = LineMode::Inline;
+
+  if (spaces < 4 && (startsFence(rest, restLength, '`') || startsFence(rest, restLength, '~'))) {
+    // The info string after the fence is not shown
+    closeBlock();
+    state = STATE_FENCE | (rest[0] == '~' ? STATE_TILDE_FENCE : 0);
+    lineMode = LineMode::Skip;
+    return;
+  }
+
+  if (spaces < 4 && isThematicBreak(rest, restLength)) {
+    closeBlock();
+    openBlock(BlockKind::Rule, 0);
+    for (int i = 0; i < 3; i++) {
+      emitWord("*", EpdFontFamily::REGULAR, false);
+    }
+    closeBlock();
+    lineMode = LineMode::Skip;
+    return;
+  }
+
+  if (rest[0] == '#') {
+    size_t level = 0;
+    while (level < restLength && rest[level] == '#') {
+      level++;
+    }
+    if (level <= 6 && (level == restLength || isSpace(rest[level]))) {
+      closeBlock();
+      openBlock(BlockKind::Heading, static_cast<uint8_t>(level));
+      const char* text = rest + level;
+      size_t textLength = restLength - level;
+      if (complete) {
+        // Drop an optional closing sequence: "## Title ##"
+        while (textLength > 0 && isSpace(text[textLength - 1])) textLength--;
+        size_t closing = textLength;
+        while (closing > 0 && text[closing - 1] == '#') closing--;
+        if (closing == 0 || isSpace(text[closing - 1])) textLength = closing;
+      }
+      inlineText(text, textLength);
+      return;
+    }
+  }
+
+  if (rest[0] == '>') {
+    uint8_t depth = 0;
+    size_t i = 0;
+    while (i < restLength && rest[i] == '>') {
+      depth++;
+      i++;
+      while (i < restLength && isSpace(rest[i])) i++;
+    }
+    if (i == restLength) {
+      // An empty quote line separates paragraphs within the quote
+      closeBlock();
+      previousLineBlank = true;
+      return;
+    }
+    if (blockOpen && block.kind == BlockKind::Quote && block.level == depth && !wasBlank) {
+      endInline();
+    } else {
+      closeBlock();
+      openBlock(BlockKind::Quote, depth);
+    }
+    inlineText(rest + i, restLength - i);
+    return;
+  }
+
+  const auto level = static_cast<uint8_t>(std::min(spaces / 2, MAX_LIST_LEVEL));
+  if ((rest[0] == '-' || rest[0] == '*' || rest[0] == '+') && (restLength == 1 || isSpace(rest[1]))) {
+    closeBlock();
+    openBlock(BlockKind::ListItem, level);
+    emitWord(BULLET, EpdFontFamily::REGULAR, false);
+    const size_t start = std::min<size_t>(2, restLength);
+    inlineText(rest + start, restLength - start);
+    return;
+  }
+
+  size_t digits = 0;
+  while (digits < restLength && digits < 9 && rest[digits] >= '0' && rest[digits] <= '9') {
+    digits++;
+  }
+  if (digits > 0 && digits < restLength && (rest[digits] == '.' || rest[digits] == ')') &&
+      (digits + 1 == restLength || isSpace(rest[digits + 1]))) {
+    closeBlock();
+    openBlock(BlockKind::ListItem, level);
+    emitWord(std::string(rest, digits + 1), EpdFontFamily::REGULAR, false);
+    const size_t start = std::min(digits + 2, restLength);
+    inlineText(rest + start, restLength - start);
+    return;
+  }
+
+  const bool continues = blockOpen && !wasBlank &&
+                         (block.kind == BlockKind::Paragraph || block.kind == BlockKind::ListItem ||
+                          block.kind == BlockKind::Quote);
+  if (continues) {
+    endInline();
+  } else {
+    closeBlock();
+    openBlock(BlockKind::Paragraph, 0);
+  }
+  inlineText(rest, restLength);
+}
+
+void TxtBlockParser::openBlock(const BlockKind kind, const uint8_t level) {
+  block.kind = kind;
+  block.level = level;
+  block.state = lineState;
+  block.offset = lineStart;
+  blockOpen = true;
+  blockStarted = false;
+}
+
+void TxtBlockParser::closeBlock() {
+  if (!blockOpen) {
+    return;
+  }
+  endInline();
+  if (linkOpen) {
+    resolveLinkAsText();
+  }
+  if (blockStarted) {
+    sink.endBlock();
+  }
+  blockOpen = false;
+  blockStarted = false;
+  bold = false;
+  italic = false;
+  codeSpan = false;
+}
+
+void TxtBlockParser::inlineText(const char* text, const size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    inlineChar(text[i]);
+  }
+}
+
+void TxtBlockParser::inlineChar(const char c) {
+  if (linkTargetDepth > 0) {
+    if (c == '(') {
+      linkTargetDepth++;
+    } else if (c == ')' && --linkTargetDepth == 0) {
+      // Punctuation right after the link belongs to its last word
+      wordContinues = true;
+    }
+    return;
+  }
+
+  if (linkClosePending) {
+    linkClosePending = false;
+    if (c == '(') {
+      // [text](target): the text stays, the target is skipped
+      flushWord();
+      linkOpen = false;
+      for (auto& held : heldWords) {
+        emitWord(std::move(held.text), held.style, held.attachToPrevious);
+      }
+      heldWords.clear();
+      linkTargetDepth = 1;
+      return;
+    }
+    wordChar(']');
+    resolveLinkAsText();
+  }
+
+  if (delimiterCount > 0) {
+    if (c == delimiter && delimiterCount < UINT8_MAX) {
+      delimiterCount++;
+      return;
+    }
+    resolveDelimiter(c);
+  }
+
+  if (escape) {
+    escape = false;
+    if (isAsciiPunct(c)) {
+      wordChar(c);
+      return;
+    }
+    wordChar('\\');
+  }
+
+  if (codeSpan) {
+    if (c == '`') {
+      codeSpan = false;
+    } else {
+      wordChar(c);
+    }
+    return;
+  }
+
+  switch (c) {
+    case '\\':
+      escape = true;
+      return;
+    case '`':
+      codeSpan = true;
+      return;
+    case '*':
+    case '_':
+      delimiter = c;
+      delimiterCount = 1;
+      delimiterAfterSpace = afterSpace;
+      delimiterAfterAlnum = prevAlnum;
+      return;
+    case '[':
+      if (!linkOpen && (word.empty() || word == "!")) {
+        linkIsImage = !word.empty();
+        word.clear();
+        linkOpen = true;
+        heldWords.clear();
+        return;
+      }
+      break;
+    case ']':
+      if (linkOpen) {
+        linkClosePending = true;
+        return;
+      }
+      break;
+    default:
+      break;
+  }
+  wordChar(c);
+}
+
+void TxtBlockParser::endInline() {
+  if (escape) {
+    escape = false;
+    wordChar('\\');
+  }
+  if (delimiterCount > 0) {
+    resolveDelimiter(' ');
+  }
+  if (linkClosePending) {
+    linkClosePending = false;
+    wordChar(']');
+    resolveLinkAsText();
+  }
+  linkTargetDepth = 0;
+  flushWord();
+  wordContinues = false;
+  afterSpace = true;
+  prevAlnum = false;
+}
+
+void TxtBlockParser::wordChar(const char c) {
+  if (isSpace(c)) {
+    flushWord();
+    wordContinues = false;
+    afterSpace = true;
+    prevAlnum = false;
+    return;
+  }
+  // Split overlong words between UTF-8 sequences, never inside one (a sequence is at most 4 bytes)
+  if (word.size() + 4 > MAX_WORD_SIZE && (static_cast<unsigned char>(c) & 0xC0) != 0x80) {
+    flushWord();
+    wordContinues = true;
+  }
+  word.push_back(c);
+  afterSpace = false;
+  prevAlnum = isWordChar(c);
+}
+
+void TxtBlockParser::resolveDelimiter(const char next) {
+  const char run = delimiter;
+  const uint8_t count = delimiterCount;
+  delimiterCount = 0;
+
+  // Simplified flanking rules: a run opens before a non-space and closes after one; '_' never acts inside a word
+  const bool canOpen = !isSpace(next) && !(run == '_' && delimiterAfterAlnum);
+  const bool canClose = !delimiterAfterSpace && !(run == '_' && isWordChar(next));
+  const auto toggle = [canOpen, canClose](bool& flag) {
+    if (flag ? canClose : canOpen) {
+      flag = !flag;
+      return true;
+    }
+    return false;
+  };
+
+  bool newBold = bold;
+  bool newItalic = italic;
+  bool applied = false;
+  if (count == 1) {
+    applied = toggle(newItalic);
+  } else if (count == 2) {
+    applied = toggle(newBold);
+  } else if (count == 3) {
+    applied = toggle(newBold) && toggle(newItalic);
+  }
+
+  if (!applied) {
+    for (uint8_t i = 0; i < count; i++) {
+      wordChar(run);
+    }
+    return;
+  }
+  if (!word.empty()) {
+    // The style changes inside a word: the rest attaches to what came before
+    flushWord();
+    wordContinues = true;
+  }
+  bold = newBold;
+  italic = newItalic;
+}
+
+void TxtBlockParser::resolveLinkAsText() {
+  linkOpen = false;
+  emitWord(linkIsImage ? "![" : "[", currentStyle(), false);
+  if (heldWords.empty()) {
+    wordContinues = true;
+  }
+  bool first = true;
+  for (auto& held : heldWords) {
+    emitWord(std::move(held.text), held.style, first || held.attachToPrevious);
+    first = false;
+  }
+  heldWords.clear();
+}
+
+void TxtBlockParser::flushWord() {
+  if (word.empty()) {
+    return;
+  }
+  emitWord(std::move(word), currentStyle(), wordContinues);
+  word.clear();
+  wordContinues = false;
+}
+
+void TxtBlockParser::emitWord(std::string text, const EpdFontFamily::Style style, const bool attachToPrevious) {
+  if (linkOpen) {
+    heldWords.push_back({std::move(text), style, attachToPrevious});
+    if (heldWords.size() >= MAX_HELD_WORDS) {
+      // Too long to be link text
+      resolveLinkAsText();
+    }
+    return;
+  }
+  if (!blockOpen) {
+    openBlock(BlockKind::Paragraph, 0);
+  }
+  if (!blockStarted) {
+    blockStarted = true;
+    sink.beginBlock(block);
+  }
+  sink.addWord(std::move(text), style, attachToPrevious);
+}
+
+EpdFontFamily::Style TxtBlockParser::currentStyle() const {
+  auto style = EpdFontFamily::REGULAR;
+  if (bold) {
+    style = static_cast<EpdFontFamily::Style>(style | EpdFontFamily::BOLD);
+  }
+  if (italic) {
+    style = static_cast<EpdFontFamily::Style>(style | EpdFontFamily::ITALIC);
+  }
+  return style;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <EpdFontFamily.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Front end that turns plain text or Markdown into the blocks and styled words the EPUB layout engine consumes.
+ *
+ * Plain text: every non-empty line is a paragraph, split into words at spaces and tabs.
+ *
+ * Markdown: blank-line separated paragraphs (consecutive lines are joined), ATX headings, bullet and numbered list
+ * items, block quotes, fenced code (one block per line) and thematic breaks. Inline, `*`/`_` emphasis and strong
+ * emphasis become italic/bold words, code spans lose their backticks, and links and images keep their text and drop
+ * their target.
+ *
+ * Bytes are fed in file order, in chunks of any size. Every block starts at the beginning of a source line, and the
+ * block's offset and parser state are enough to start a new parser there and get the same blocks again.
+ */
+class TxtBlockParser {
+ public:
+  enum class Format : uint8_t { Plain, Markdown };
+  enum class BlockKind : uint8_t { Paragraph, Heading, ListItem, Quote, Code, Rule };
+
+  struct Block {
+    BlockKind kind = BlockKind::Paragraph;
+    uint8_t level = 0;    // Heading level (1-6), list nesting, quote depth, or leading spaces of a code line
+    uint8_t state = 0;    // Parser state at `offset`
+    uint32_t offset = 0;  // Start of the source line the block begins on
+  };
+
+  class Sink {
+   public:
+    virtual ~Sink() = default;
+    virtual void beginBlock(const Block& block) = 0;
+    // attachToPrevious: no space between this word and the previous one (a style change inside a word)
+    virtual void addWord(std::string word, EpdFontFamily::Style style, bool attachToPrevious) = 0;
+    virtual void endBlock() = 0;
+  };
+
+  // Longer words are split, as in ChapterHtmlSlimParser
+  static constexpr size_t MAX_WORD_SIZE = 200;
+  // Markdown lines are classified from at most this many bytes; the rest of a longer line is streamed
+  static constexpr size_t MAX_LINE_PREFIX = 512;
+
+  // startOffset and state: where to resume, taken from a Block reported by an earlier parser
+  TxtBlockParser(Format format, Sink& sink, uint32_t startOffset = 0, uint8_t state = 0);
+
+  void feed(const uint8_t* data, size_t length);
+  // End the last block at end of input
+  void finish();
+
+  // Offset of the next byte expected by feed()
+  uint32_t getOffset() const { return offset; }
+
+ private:
+  static constexpr uint8_t STATE_FENCE = 1 << 0;        // Inside fenced code
+  static constexpr uint8_t STATE_TILDE_FENCE = 1 << 1;  // ... opened with ~~~ rather than ```
+  static constexpr size_t MAX_HELD_WORDS = 32;          // Link text held until its closing bracket is resolved
+
+  // How the rest of the current line is consumed
+  enum class LineMode : uint8_t { Buffer, Inline, Words, Skip };
+
+  struct HeldWord {
+    std::string text;
+    EpdFontFamily::Style style;
+    bool attachToPrevious;
+  };
+
+  Format format;
+  Sink& sink;
+  uint32_t offset;
+  uint8_t state;
+  uint8_t bomMatched;  // Bytes of a leading UTF-8 byte order mark seen so far; 3 once past it
+
+  // Current line
+  uint32_t lineStart;
+  uint8_t lineState;  // state at lineStart
+  LineMode lineMode;
+  std::string lineBuffer;
+  bool previousLineBlank = true;
+
+  // Current block; it is reported to the sink with its first word
+  Block block;
+  bool blockOpen = false;
+  bool blockStarted = false;
+
+  // Word being assembled
+  std::string word;
+  bool wordContinues = false;
+
+  // Inline Markdown state
+  bool bold = false;
+  bool italic = false;
+  bool codeSpan = false;
+  bool escape = false;
+  bool afterSpace = true;  // Previous character was whitespace or the line start
+  char delimiter = 0;      // Pending run of '*' or '_'
+  uint8_t delimiterCount = 0;
+  bool delimiterAfterSpace = false;
+  bool delimiterAfterAlnum = false;
+  bool prevAlnum = false;
+  bool linkOpen = false;
+  bool linkIsImage = false;
+  bool linkClosePending = false;  // Seen "]", waiting for "("
+  int linkTargetDepth = 0;        // > 0 while skipping "(target)"
+  std::vector<HeldWord> heldWords;
+
+  void byte(uint8_t c);
+  void endLine();
+  void classifyLine(bool complete);
+  void openBlock(BlockKind kind, uint8_t level);
+  void closeBlock();
+  void inlineText(const char* text, size_t length);
+  void inlineChar(char c);
+  void endInline();
+  void wordChar(char c);
+  void resolveDelimiter(char next);
+  void resolveLinkAsText();
+  void flushWord();
+  void emitWord(std::string text, EpdFontFamily::Style style, bool attachToPrevious);
+  EpdFontFamily::Style currentStyle() const;
+};
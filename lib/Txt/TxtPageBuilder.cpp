@@ -0,0 +1,162 @@
+#include "TxtPageBuilder.h"
+
+#include <Epub/Page.h>
+#include <GfxRenderer.h>
+
+#include <algorithm>
+
+namespace {
+// Long blocks are laid out in chunks to bound memory, as in ChapterHtmlSlimParser
+constexpr size_t MAX_BLOCK_WORDS = 750;
+}  // namespace
+
+using BlockKind = TxtBlockParser::BlockKind;
+
+int TxtPageBuilder::lineHeight() const { return renderer.getLineHeight(fontId) * lineCompression; }
+
+void TxtPageBuilder::resume(const uint32_t lineSkip) {
+  resuming = true;
+  skipLines = lineSkip;
+}
+
+BlockStyle TxtPageBuilder::blockStyleFor(const TxtBlockParser::Block& block) const {
+  const auto em = static_cast<int16_t>(renderer.getFontAscenderSize(fontId));
+  const auto maxInset = static_cast<int16_t>(em * BlockStyle::MAX_HORIZONTAL_INSET_EM);
+  BlockStyle style;
+  style.textAlignDefined = true;
+  style.alignment = paragraphAlignment == static_cast<uint8_t>(CssTextAlign::None)
+                        ? CssTextAlign::Justify
+                        : static_cast<CssTextAlign>(paragraphAlignment);
+
+  switch (block.kind) {
+    case BlockKind::Paragraph:
+      break;
+    case BlockKind::Heading:
+      style.alignment = CssTextAlign::Left;
+      style.textIndentDefined = true;
+      style.marginTop = static_cast<int16_t>(block.level <= 2 ? lineHeight() : lineHeight() / 2);
+      break;
+    case BlockKind::ListItem:
+      // Hanging indent: the marker sits in the margin of the wrapped lines
+      style.textIndentDefined = true;
+      style.marginLeft = static_cast<int16_t>(std::min<int>(em * (block.level + 1), maxInset) + em);
+      style.textIndent = static_cast<int16_t>(-em);
+      break;
+    case BlockKind::Quote:
+      style.marginLeft = static_cast<int16_t>(std::min<int>(em * block.level, maxInset));
+      style.marginRight = em;
+      break;
+    case BlockKind::Code:
+      style.alignment = CssTextAlign::Left;
+      style.textIndentDefined = true;
+      style.marginLeft =
+          static_cast<int16_t>(std::min<int>(em + block.level * renderer.getSpaceWidth(fontId), maxInset));
+      break;
+    case BlockKind::Rule:
+      style.alignment = CssTextAlign::Center;
+      style.textIndentDefined = true;
+      break;
+  }
+  return style;
+}
+
+void TxtPageBuilder::beginBlock(const TxtBlockParser::Block& block) {
+  this->block = block;
+  blockLines = 0;
+  blockTopApplied = false;
+  // Code is never hyphenated
+  currentTextBlock.reset(new ParsedText(extraParagraphSpacing, hyphenationEnabled && block.kind != BlockKind::Code,
+                                        blockStyleFor(block)));
+}
+
+void TxtPageBuilder::addWord(std::string word, EpdFontFamily::Style style, const bool attachToPrevious) {
+  if (!currentTextBlock) {
+    return;
+  }
+  if (block.kind == BlockKind::Heading) {
+    style = static_cast<EpdFontFamily::Style>(style | EpdFontFamily::BOLD);
+  }
+  currentTextBlock->addWord(std::move(word), style, false, attachToPrevious);
+  if (currentTextBlock->size() > MAX_BLOCK_WORDS) {
+    // Lay out all but the last line now to free the words
+    layoutBlock(false);
+  }
+}
+
+void TxtPageBuilder::endBlock() {
+  if (!currentTextBlock) {
+    return;
+  }
+  layoutBlock(true);
+
+  if (currentPage) {
+    const BlockStyle& style = currentTextBlock->getBlockStyle();
+    currentPageNextY += style.marginBottom + style.paddingBottom;
+    // Code lines stay together like the lines of one paragraph
+    if (extraParagraphSpacing && block.kind != BlockKind::Code) {
+      currentPageNextY += lineHeight() / 2;
+    }
+  }
+  currentTextBlock.reset();
+  resuming = false;
+}
+
+void TxtPageBuilder::finish() {
+  if (currentTextBlock) {
+    endBlock();
+  }
+  if (currentPage) {
+    completePageFn(std::move(currentPage), currentPageStart);
+    currentPage.reset();
+  }
+}
+
+void TxtPageBuilder::layoutBlock(const bool includeLastLine) {
+  const BlockStyle& style = currentTextBlock->getBlockStyle();
+  if (!blockTopApplied) {
+    blockTopApplied = true;
+    // A resumed page starts with its first line at the top, as every page after the first does
+    if (!resuming) {
+      if (!currentPage) {
+        startPage(blockLines);
+      }
+      currentPageNextY += style.marginTop + style.paddingTop;
+    }
+  }
+
+  const int horizontalInset = style.totalHorizontalInset();
+  const uint16_t effectiveWidth =
+      (horizontalInset < viewportWidth) ? static_cast<uint16_t>(viewportWidth - horizontalInset) : viewportWidth;
+  currentTextBlock->layoutAndExtractLines(
+      renderer, fontId, effectiveWidth,
+      [this](const std::shared_ptr<TextBlock>& line) { addLineToPage(line); }, includeLastLine);
+}
+
+void TxtPageBuilder::addLineToPage(const std::shared_ptr<TextBlock>& line) {
+  const uint32_t lineIndex = blockLines++;
+  if (skipLines > 0) {
+    // Already on the page before the one being resumed
+    skipLines--;
+    return;
+  }
+
+  const int height = lineHeight();
+  if (!currentPage) {
+    startPage(lineIndex);
+  } else if (currentPageNextY + height > viewportHeight) {
+    completePageFn(std::move(currentPage), currentPageStart);
+    startPage(lineIndex);
+  }
+
+  const int16_t xOffset = line->getBlockStyle().leftInset();
+  currentPage->elements.push_back(std::make_shared<PageLine>(line, xOffset, currentPageNextY));
+  currentPageNextY += height;
+}
+
+void TxtPageBuilder::startPage(const uint32_t lineIndex) {
+  currentPage.reset(new Page());
+  currentPageNextY = 0;
+  currentPageStart.blockOffset = block.offset;
+  currentPageStart.lineSkip = lineIndex;
+  currentPageStart.state = block.state;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <Epub/ParsedText.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "TxtBlockParser.h"
+
+class GfxRenderer;
+class Page;
+
+/**
+ * Lays out the blocks of a TxtBlockParser with ParsedText and cuts them into Pages, the way ChapterHtmlSlimParser
+ * does for an EPUB chapter.
+ *
+ * Every completed page comes with where it starts: the block its first line belongs to and how many lines of that
+ * block went to earlier pages. A parser and builder started there (see resume()) produce the same pages again, so a
+ * build can be stopped after any page and continued later.
+ */
+class TxtPageBuilder final : public TxtBlockParser::Sink {
+ public:
+  struct PageStart {
+    uint32_t blockOffset = 0;  // TxtBlockParser::Block::offset
+    uint32_t lineSkip = 0;     // Lines of the block laid out on earlier pages
+    uint8_t state = 0;         // TxtBlockParser::Block::state
+  };
+  using CompletePageFn = std::function<void(std::unique_ptr<Page>, const PageStart&)>;
+
+  TxtPageBuilder(GfxRenderer& renderer, int fontId, float lineCompression, bool extraParagraphSpacing,
+                 uint8_t paragraphAlignment, uint16_t viewportWidth, uint16_t viewportHeight, bool hyphenationEnabled,
+                 CompletePageFn completePageFn)
+      : renderer(renderer),
+        fontId(fontId),
+        lineCompression(lineCompression),
+        extraParagraphSpacing(extraParagraphSpacing),
+        paragraphAlignment(paragraphAlignment),
+        viewportWidth(viewportWidth),
+        viewportHeight(viewportHeight),
+        hyphenationEnabled(hyphenationEnabled),
+        completePageFn(std::move(completePageFn)) {}
+
+  // Continue at a page that is not the first one: its first block is laid out from the top of the page, dropping the
+  // `lineSkip` lines that ended up on the page before
+  void resume(uint32_t lineSkip);
+
+  void beginBlock(const TxtBlockParser::Block& block) override;
+  void addWord(std::string word, EpdFontFamily::Style style, bool attachToPrevious) override;
+  void endBlock() override;
+
+  // Complete the last page
+  void finish();
+
+ private:
+  GfxRenderer& renderer;
+  int fontId;
+  float lineCompression;
+  bool extraParagraphSpacing;
+  uint8_t paragraphAlignment;
+  uint16_t viewportWidth;
+  uint16_t viewportHeight;
+  bool hyphenationEnabled;
+  CompletePageFn completePageFn;
+
+  std::unique_ptr<ParsedText> currentTextBlock;
+  TxtBlockParser::Block block;
+  uint32_t blockLines = 0;  // Lines of the current block laid out so far
+  bool blockTopApplied = false;
+
+  std::unique_ptr<Page> currentPage;
+  PageStart currentPageStart;
+  int16_t currentPageNextY = 0;
+
+  bool resuming = false;  // The first block after resume() starts at the top of a page
+  uint32_t skipLines = 0;
+
+  BlockStyle blockStyleFor(const TxtBlockParser::Block& block) const;
+  void layoutBlock(bool includeLastLine);
+  void addLineToPage(const std::shared_ptr<TextBlock>& line);
+  void startPage(uint32_t lineIndex);
+  int lineHeight() const;
+};
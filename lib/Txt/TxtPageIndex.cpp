@@ -0,0 +1,218 @@
+#include "TxtPageIndex.h"
+
+#include <Logging.h>
+#include <Serialization.h>
+
+#include <algorithm>
+
+namespace {
+constexpr uint32_t INDEX_MAGIC = 0x54585449;  // "TXTI"
+constexpr uint8_t INDEX_VERSION = 5;          // Increment when the format or the layout rules change
+
+// Header: magic, version, layout (fileSize, fontId, lineCompression, extraParagraphSpacing, paragraphAlignment,
+// viewportWidth, viewportHeight, hyphenationEnabled, markdown), complete flag, page count
+constexpr size_t LAYOUT_SIZE = sizeof(uint32_t) + sizeof(int32_t) + sizeof(float) + 2 * sizeof(uint8_t) +
+                               2 * sizeof(uint16_t) + 2 * sizeof(uint8_t);
+constexpr size_t COMPLETE_POS = sizeof(uint32_t) + sizeof(uint8_t) + LAYOUT_SIZE;
+constexpr size_t COUNT_POS = COMPLETE_POS + sizeof(uint8_t);
+constexpr size_t HEADER_SIZE = COUNT_POS + sizeof(uint32_t);
+}  // namespace
+
+bool TxtPageIndex::open(const std::string& path, const Layout& layout) {
+  close();
+  file = Storage.open(path.c_str(), O_RDWR | O_CREAT);
+  if (!file) {
+    LOG_ERR("TXI", "Failed to open page index %s", path.c_str());
+    return false;
+  }
+
+  if (readHeader(layout)) {
+    reset = false;
+    LOG_DBG("TXI", "Resuming page index: %lu pages%s", static_cast<unsigned long>(pageCount),
+            complete ? " (complete)" : "");
+    return true;
+  }
+
+  reset = true;
+  complete = false;
+  pageCount = 0;
+  if (!writeHeader(layout)) {
+    LOG_ERR("TXI", "Failed to write page index header");
+    close();
+    return false;
+  }
+  return true;
+}
+
+void TxtPageIndex::close() {
+  if (file) {
+    file.close();
+  }
+  complete = false;
+  pageCount = 0;
+  windowCount = 0;
+}
+
+bool TxtPageIndex::readHeader(const Layout& layout) {
+  const size_t size = file.size();
+  if (size < HEADER_SIZE || !file.seek(0)) {
+    return false;
+  }
+
+  uint32_t magic;
+  uint8_t version;
+  Layout stored;
+  uint8_t storedComplete;
+  uint32_t storedCount;
+  serialization::readPod(file, magic);
+  serialization::readPod(file, version);
+  serialization::readPod(file, stored.fileSize);
+  serialization::readPod(file, stored.fontId);
+  serialization::readPod(file, stored.lineCompression);
+  serialization::readPod(file, stored.extraParagraphSpacing);
+  serialization::readPod(file, stored.paragraphAlignment);
+  serialization::readPod(file, stored.viewportWidth);
+  serialization::readPod(file, stored.viewportHeight);
+  serialization::readPod(file, stored.hyphenationEnabled);
+  serialization::readPod(file, stored.markdown);
+  serialization::readPod(file, storedComplete);
+  serialization::readPod(file, storedCount);
+
+  if (magic != INDEX_MAGIC || version != INDEX_VERSION) {
+    LOG_DBG("TXI", "Page index format changed, rebuilding");
+    return false;
+  }
+  if (stored != layout) {
+    LOG_DBG("TXI", "Page index layout changed, rebuilding");
+    return false;
+  }
+
+  // Entries past the committed count may be left over from an interrupted append; they are overwritten later
+  const uint32_t available = (size - HEADER_SIZE) / sizeof(Entry);
+  pageCount = std::min(storedCount, available);
+  complete = storedComplete != 0 && pageCount == storedCount;
+  windowCount = 0;
+  return true;
+}
+
+bool TxtPageIndex::writeHeader(const Layout& layout) {
+  if (!file.seek(0)) {
+    return false;
+  }
+  serialization::writePod(file, INDEX_MAGIC);
+  serialization::writePod(file, INDEX_VERSION);
+  serialization::writePod(file, layout.fileSize);
+  serialization::writePod(file, layout.fontId);
+  serialization::writePod(file, layout.lineCompression);
+  serialization::writePod(file, layout.extraParagraphSpacing);
+  serialization::writePod(file, layout.paragraphAlignment);
+  serialization::writePod(file, layout.viewportWidth);
+  serialization::writePod(file, layout.viewportHeight);
+  serialization::writePod(file, layout.hyphenationEnabled);
+  serialization::writePod(file, layout.markdown);
+  windowCount = 0;
+  return commit();
+}
+
+bool TxtPageIndex::commit() {
+  if (!file.seek(COMPLETE_POS)) {
+    return false;
+  }
+  serialization::writePod(file, static_cast<uint8_t>(complete ? 1 : 0));
+  serialization::writePod(file, pageCount);
+  file.flush();
+  return true;
+}
+
+bool TxtPageIndex::getEntry(const uint32_t page, Entry& entry) {
+  if (page >= pageCount) {
+    return false;
+  }
+  if (page >= windowFirst && page < windowFirst + windowCount) {
+    entry = window[page - windowFirst];
+    return true;
+  }
+
+  // Load a window with the requested page a quarter of the way in, so turning back a few pages stays in RAM too
+  windowFirst = page > WINDOW_PAGES / 4 ? page - WINDOW_PAGES / 4 : 0;
+  const uint32_t count = std::min<uint32_t>(WINDOW_PAGES, pageCount - windowFirst);
+  windowCount = 0;
+  if (!file.seek(HEADER_SIZE + windowFirst * sizeof(Entry))) {
+    return false;
+  }
+  const size_t bytes = count * sizeof(Entry);
+  if (file.read(window, bytes) != static_cast<int>(bytes)) {
+    LOG_ERR("TXI", "Failed to read page entries at %lu", static_cast<unsigned long>(windowFirst));
+    return false;
+  }
+  windowCount = count;
+  entry = window[page - windowFirst];
+  return true;
+}
+
+uint32_t TxtPageIndex::findPage(const uint32_t offset) {
+  // Last page whose block starts at or before the offset...
+  uint32_t low = 0;
+  uint32_t high = pageCount;
+  Entry entry;
+  while (high - low > 1) {
+    const uint32_t mid = low + (high - low) / 2;
+    if (!getEntry(mid, entry)) {
+      return low;
+    }
+    if (entry.blockOffset <= offset) {
+      low = mid;
+    } else {
+      high = mid;
+    }
+  }
+  if (!getEntry(low, entry)) {
+    return low;
+  }
+
+  // ... then back to the first page of that block, so the text at the offset is on screen
+  const uint32_t blockOffset = entry.blockOffset;
+  high = low;
+  low = 0;
+  while (low < high) {
+    const uint32_t mid = low + (high - low) / 2;
+    if (!getEntry(mid, entry)) {
+      return high;
+    }
+    if (entry.blockOffset < blockOffset) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+bool TxtPageIndex::append(const Entry* entries, const size_t count, const bool markComplete) {
+  if (!file) {
+    return false;
+  }
+  if (count > 0) {
+    if (!file.seek(HEADER_SIZE + pageCount * sizeof(Entry))) {
+      return false;
+    }
+    const size_t bytes = count * sizeof(Entry);
+    if (file.write(entries, bytes) != bytes) {
+      LOG_ERR("TXI", "Failed to append %zu page entries", count);
+      return false;
+    }
+  }
+  pageCount += count;
+  complete = markComplete;
+  return commit();
+}
+
+bool TxtPageIndex::truncate(const uint32_t count) {
+  if (!file) {
+    return false;
+  }
+  pageCount = std::min(pageCount, count);
+  complete = false;
+  windowCount = 0;
+  return commit();
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <HalStorage.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Page index of a TXT or Markdown file, kept on the SD card next to the serialized pages.
+ *
+ * index.bin starts with a fixed header (the layout parameters the pages were built for, whether the index is
+ * complete, and how many pages it holds) followed by one Entry per page: where the page is stored in pages.bin and
+ * where it starts in the text. The reader appends pages as it builds them in the background and rewrites the header
+ * count after every batch, so a build interrupted by sleep or by leaving the book resumes from its last page instead
+ * of starting over.
+ *
+ * Only a small window of entries around the last lookup is held in RAM.
+ */
+class TxtPageIndex {
+ public:
+  // Everything the pages depend on (the same parameters as an EPUB section); an index built for another layout is
+  // discarded
+  struct Layout {
+    uint32_t fileSize = 0;
+    int32_t fontId = 0;
+    float lineCompression = 0;
+    uint8_t extraParagraphSpacing = 0;
+    uint8_t paragraphAlignment = 0;
+    uint16_t viewportWidth = 0;
+    uint16_t viewportHeight = 0;
+    uint8_t hyphenationEnabled = 0;
+    uint8_t markdown = 0;
+
+    bool operator==(const Layout& other) const {
+      return fileSize == other.fileSize && fontId == other.fontId && lineCompression == other.lineCompression &&
+             extraParagraphSpacing == other.extraParagraphSpacing &&
+             paragraphAlignment == other.paragraphAlignment && viewportWidth == other.viewportWidth &&
+             viewportHeight == other.viewportHeight && hyphenationEnabled == other.hyphenationEnabled &&
+             markdown == other.markdown;
+    }
+    bool operator!=(const Layout& other) const { return !(*this == other); }
+  };
+
+  struct Entry {
+    uint32_t pagePos = 0;      // Offset of the serialized Page in pages.bin
+    uint32_t blockOffset = 0;  // TxtPageBuilder::PageStart
+    uint32_t lineSkip = 0;
+    uint8_t state = 0;
+    uint8_t reserved[3] = {};
+  };
+  static_assert(sizeof(Entry) == 16, "Entry is stored as is");
+
+  static constexpr uint16_t WINDOW_PAGES = 64;
+
+  // Open the index at `path`, starting a new one if it is missing or was built for a different layout.
+  // Returns false if the file cannot be created.
+  bool open(const std::string& path, const Layout& layout);
+  void close();
+
+  // True if open() discarded an index built for another layout (or found none)
+  bool wasReset() const { return reset; }
+  bool isComplete() const { return complete; }
+  uint32_t getPageCount() const { return pageCount; }
+
+  // Entry of an indexed page (page < getPageCount())
+  bool getEntry(uint32_t page, Entry& entry);
+  // First page of the last block starting at or before text offset `offset`
+  uint32_t findPage(uint32_t offset);
+
+  // Add pages after the last one and commit the new count (and completion) to the header
+  bool append(const Entry* entries, size_t count, bool markComplete);
+  // Forget the pages from `count` on, to build them again
+  bool truncate(uint32_t count);
+
+ private:
+  FsFile file;
+  bool reset = false;
+  bool complete = false;
+  uint32_t pageCount = 0;
+
+  Entry window[WINDOW_PAGES] = {};
+  uint32_t windowFirst = 0;
+  uint16_t windowCount = 0;
+
+  bool readHeader(const Layout& layout);
+  bool writeHeader(const Layout& layout);
+  bool commit();
+};
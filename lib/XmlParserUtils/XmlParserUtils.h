@@ -1,7 +1,18 @@
 #pragma once
 
+#include <HeapTags.h>
 #include <expat.h>
 
+// Create an expat parser whose allocations are accounted under the expat heap tag.
+inline XML_Parser createXmlParser() {
+  static const XML_Memory_Handling_Suite memorySuite = {
+      [](const size_t size) { return HeapTags::alloc(HeapTags::Tag::Expat, size); },
+      [](void* ptr, const size_t size) { return HeapTags::reallocate(HeapTags::Tag::Expat, ptr, size); },
+      [](void* ptr) { HeapTags::release(ptr); },
+  };
+  return XML_ParserCreate_MM(nullptr, &memorySuite, nullptr);
+}
+
 // Safely tear down an expat parser: stop processing, clear callbacks, free, and null the pointer.
 inline void destroyXmlParser(XML_Parser& parser) {
   if (!parser) return;
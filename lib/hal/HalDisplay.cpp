@@ -66,6 +66,12 @@ void HalDisplay::refreshDisplay(HalDisplay::RefreshMode mode, bool turnOffScreen
   einkDisplay.refreshDisplay(convertRefreshMode(mode), turnOffScreen);
 }
 
+bool HalDisplay::supportsWindowedUpdate() const { return false; }
+
+void HalDisplay::displayWindow(uint16_t /*x*/, uint16_t /*y*/, uint16_t /*w*/, uint16_t /*h*/, bool turnOffScreen) {
+  einkDisplay.displayBuffer(EInkDisplay::FAST_REFRESH, turnOffScreen);
+}
+
 void HalDisplay::deepSleep() { einkDisplay.deepSleep(); }
 
 uint8_t* HalDisplay::getFrameBuffer() const { return einkDisplay.getFrameBuffer(); }
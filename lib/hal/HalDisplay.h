@@ -36,6 +36,11 @@ class HalDisplay {
   void displayBuffer(RefreshMode mode = RefreshMode::FAST_REFRESH, bool turnOffScreen = false);
   void refreshDisplay(RefreshMode mode = RefreshMode::FAST_REFRESH, bool turnOffScreen = false);
 
+  // Fast update of a physical panel region (x and width in whole bytes). The EInkDisplay driver has no windowed
+  // update yet, so supportsWindowedUpdate() is false and displayWindow() falls back to a full fast refresh.
+  bool supportsWindowedUpdate() const;
+  void displayWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h, bool turnOffScreen = false);
+
   // Power management
   void deepSleep();
 
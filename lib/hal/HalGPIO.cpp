@@ -203,10 +203,50 @@ void HalGPIO::begin() {
 }
 
 void HalGPIO::update() {
+  // Taken before sampling so an interrupt arriving during update() is kept for the next edge
+  const uint32_t edgeUs = pendingEdgeUs;
+  pendingEdgeUs = 0;
   inputMgr.update();
   const bool connected = isUsbConnected();
   usbStateChanged = (connected != lastUsbConnected);
   lastUsbConnected = connected;
+  if (inputMgr.wasAnyPressed() || inputMgr.wasAnyReleased()) {
+    lastEdgeUs = edgeUs != 0 ? edgeUs : micros();
+  }
+}
+
+void IRAM_ATTR HalGPIO::onButtonEdge(void* arg) {
+  auto* self = static_cast<HalGPIO*>(arg);
+  // Keep the first edge until update() consumes it; contact bounce follows within a few ms
+  if (self->pendingEdgeUs == 0) {
+    self->pendingEdgeUs = micros() | 1;
+  }
+  if (self->inputWakeup) {
+    BaseType_t higherPriorityWoken = pdFALSE;
+    xSemaphoreGiveFromISR(self->inputWakeup, &higherPriorityWoken);
+    if (higherPriorityWoken) {
+      portYIELD_FROM_ISR();
+    }
+  }
+}
+
+void HalGPIO::enableInputWakeups() {
+  if (!inputWakeup) {
+    inputWakeup = xSemaphoreCreateBinary();
+  }
+  attachInterruptArg(InputManager::POWER_BUTTON_PIN, onButtonEdge, this, CHANGE);
+}
+
+void HalGPIO::disableInputWakeups() {
+  detachInterrupt(InputManager::POWER_BUTTON_PIN);
+}
+
+bool HalGPIO::waitForInput(const uint32_t timeoutMs) {
+  if (!inputWakeup) {
+    delay(timeoutMs);
+    return false;
+  }
+  return xSemaphoreTake(inputWakeup, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
 }
 
 bool HalGPIO::wasUsbStateChanged() const { return usbStateChanged; }
@@ -221,9 +261,19 @@ bool HalGPIO::wasReleased(uint8_t buttonIndex) const { return inputMgr.wasReleas
 
 bool HalGPIO::wasAnyReleased() const { return inputMgr.wasAnyReleased(); }
 
+bool HalGPIO::isAnyPressed() const {
+  for (uint8_t i = BTN_BACK; i <= BTN_POWER; i++) {
+    if (inputMgr.isPressed(i)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 unsigned long HalGPIO::getHeldTime() const { return inputMgr.getHeldTime(); }
 
 void HalGPIO::startDeepSleep() {
+  disableInputWakeups();
   // Ensure that the power button has been released to avoid immediately turning back on if you're holding it
   while (inputMgr.isPressed(BTN_POWER)) {
     delay(50);
@@ -2,6 +2,8 @@
 
 #include <Arduino.h>
 #include <InputManager.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 // Display SPI pins (custom pins for XteinkX4, not hardware SPI defaults)
 #define EPD_SCLK 8   // SPI Clock
@@ -46,6 +48,14 @@ class HalGPIO {
   bool lastUsbConnected = false;
   bool usbStateChanged = false;
 
+  // Given by the button edge interrupt, see enableInputWakeups(). A semaphore rather than a task notification: the
+  // waiting task's notification value already carries the render handshakes of ActivityManager.
+  SemaphoreHandle_t inputWakeup = nullptr;
+  volatile uint32_t pendingEdgeUs = 0;
+  uint32_t lastEdgeUs = 0;
+
+  static void IRAM_ATTR onButtonEdge(void* arg);
+
  public:
   enum class DeviceType : uint8_t { X4, X3 };
 
@@ -69,8 +79,22 @@ class HalGPIO {
   bool wasAnyPressed() const;
   bool wasReleased(uint8_t buttonIndex) const;
   bool wasAnyReleased() const;
+  bool isAnyPressed() const;
   unsigned long getHeldTime() const;
 
+  // Wake waitForInput() from an edge interrupt whenever the power button changes, so a task can block there instead
+  // of polling. The other buttons are sampled through the ADC by update() and cannot raise an interrupt.
+  void enableInputWakeups();
+  void disableInputWakeups();
+
+  // Block the calling task until a button interrupt arrives or `timeoutMs` passes. Returns true when woken by an
+  // interrupt.
+  bool waitForInput(uint32_t timeoutMs);
+
+  // micros() of the interrupt behind the input edge reported by the last update(), or of the update() itself when the
+  // edge was only seen by sampling
+  uint32_t getEdgeTimeUs() const { return lastEdgeUs; }
+
   // Setup wake up GPIO and enter deep sleep
   void startDeepSleep();
 
@@ -87,6 +87,8 @@ class HalFile : public Print {
   size_t write(uint8_t b) override;
   bool rename(const char* newPath);
   bool isDirectory() const;
+  // FAT modify timestamp of this file or directory. Returns false for the root directory, which has no entry.
+  bool getModifyDateTime(uint16_t* pdate, uint16_t* ptime);
   void rewindDirectory();
   bool close();
   HalFile openNextFile();
@@ -208,6 +208,15 @@ void HalTiltSensor::update(const uint8_t mode, const uint8_t orientation, const
   }
 }
 
+uint32_t HalTiltSensor::msUntilNextPoll(const uint8_t mode, const bool inReader) const {
+  if (!_available || !_isAwake || (mode == CrossPointTiltPageTurn::TILT_OFF) || !inReader) {
+    // A pending wake() or deepSleep() is retried by the next update(), which the idle timeout guarantees
+    return UINT32_MAX;
+  }
+  const unsigned long elapsed = millis() - _lastPollMs;
+  return elapsed >= POLL_INTERVAL_MS ? 0 : static_cast<uint32_t>(POLL_INTERVAL_MS - elapsed);
+}
+
 bool HalTiltSensor::wasTiltedForward() {
   const bool val = _tiltForwardEvent;
   _tiltForwardEvent = false;
@@ -83,6 +83,10 @@ class HalTiltSensor {
   // Poll the accelerometer and update tilt gesture state.
   void update(const uint8_t mode, const uint8_t orientation, const bool inReader);
 
+  // Milliseconds until update() next needs to run to keep the 20 Hz gesture sampling, or UINT32_MAX when it has
+  // nothing to poll. Gestures are detected from polled gyro rates, so the main loop sleeps until this deadline.
+  uint32_t msUntilNextPoll(const uint8_t mode, const bool inReader) const;
+
   // Returns true once per tilt-forward gesture (next page direction).
   // Consumed on read — subsequent calls return false until next gesture.
   bool wasTiltedForward();
@@ -11,6 +11,7 @@ Features:
 - Interactive memory usage graphing with matplotlib
 - Command input interface for sending commands to the ESP32 device
 - Screenshot capture and processing (1-bit black/white format)
+- Page-turn trace capture (CMD:TRACE) to trace.txt
 - Graceful shutdown handling with Ctrl-C signal processing
 - Configurable filtering and suppression of log messages
 - Thread-safe operation with coordinated shutdown events
@@ -222,6 +223,7 @@ def serial_worker(ser, kwargs: dict[str, str]) -> None:
     expecting_screenshot = False
     screenshot_size = 0
     screenshot_data = b""
+    trace_lines: list[str] | None = None
 
     try:
         while not shutdown_event.is_set():
@@ -264,6 +266,21 @@ def serial_worker(ser, kwargs: dict[str, str]) -> None:
                         continue
                     elif clean_line == "SCREENSHOT_END":
                         continue  # ignore
+                    elif clean_line.startswith("TRACE_START:"):
+                        trace_lines = []
+                        continue
+                    elif clean_line == "TRACE_END" and trace_lines is not None:
+                        with open("trace.txt", "w", encoding="utf-8") as f:
+                            f.write("\n".join(trace_lines) + "\n")
+                        print(
+                            f"{Fore.GREEN}Trace ({len(trace_lines)} events) saved to trace.txt, "
+                            f"summarize with scripts/trace_summary.py trace.txt{Style.RESET_ALL}"
+                        )
+                        trace_lines = None
+                        continue
+                    elif trace_lines is not None:
+                        trace_lines.append(clean_line)
+                        continue
 
                     # Add PC timestamp
                     pc_time = datetime.now().strftime("%H:%M:%S")
@@ -1,10 +1,25 @@
 #!/usr/bin/env python3
-"""Embed hypher-generated `.bin` tries into constexpr headers."""
+"""Embed hypher-generated `.bin` tries into constexpr headers and/or SD card pattern packs."""
 
 from __future__ import annotations
 
 import argparse
 import pathlib
+import re
+import struct
+
+# Dense dispatch: the root plus every first-level node with at least this many children gets a 256-entry table of
+# child indexes, so the first two steps of each pattern walk skip the linear transition scan. Smaller nodes are cheap
+# to scan and not worth 256 bytes of flash.
+DISPATCH_MIN_CHILDREN = 12
+DISPATCH_NONE = 0xFF
+
+# Pattern pack layout, read by HyphenationPack.cpp: magic, version, dispatch table count, reserved u16, root offset and
+# trie size (little-endian), then the trie, the dispatch slots and the dispatch tables.
+PACK_MAGIC = b'HYPK'
+PACK_VERSION = 1
+# HyphenationPack copies nodes into buffers of this size
+PACK_MAX_NODE_SIZE = 256
 
 
 def _format_bytes(blob: bytes, per_line: int = 16) -> str:
@@ -18,6 +33,84 @@ def _format_bytes(blob: bytes, per_line: int = 16) -> str:
     return '\n'.join(lines)
 
 
+def _node_children(nodes: bytes, addr: int) -> list[tuple[int, int]]:
+    # Decode a node the way LiangHyphenation.cpp does: returns (byte, child address) pairs in serialized order.
+    header = nodes[addr]
+    pos = addr + 1
+    stride = (header >> 5) & 0x03 or 1
+    count = header & 0x1F
+    if count == 31:
+        count = nodes[pos]
+        pos += 1
+    if header & 0x80:
+        pos += 2
+    letters = nodes[pos : pos + count]
+    pos += count
+    children = []
+    for i, letter in enumerate(letters):
+        raw = nodes[pos + i * stride : pos + (i + 1) * stride]
+        if stride == 3:
+            delta = int.from_bytes(raw, 'big') - (1 << 23)
+        else:
+            delta = int.from_bytes(raw, 'big', signed=True)
+        children.append((letter, addr + delta))
+    return children
+
+
+def _node_size(nodes: bytes, addr: int) -> int:
+    header = nodes[addr]
+    stride = (header >> 5) & 0x03 or 1
+    count = header & 0x1F
+    size = 1
+    if count == 31:
+        count = nodes[addr + 1]
+        size += 1
+    if header & 0x80:
+        size += 2
+    return size + count * (1 + stride)
+
+
+def _max_node_size(nodes: bytes, root: int) -> int:
+    # Every node is reachable from the root
+    largest = 0
+    seen = set()
+    pending = [root]
+    while pending:
+        addr = pending.pop()
+        if addr in seen:
+            continue
+        seen.add(addr)
+        largest = max(largest, _node_size(nodes, addr))
+        pending.extend(child for _, child in _node_children(nodes, addr))
+    return largest
+
+
+def _dense_table(children: list[tuple[int, int]]) -> bytes:
+    if len(children) >= DISPATCH_NONE:
+        raise ValueError(f"Node has {len(children)} children; dispatch indexes are 8-bit")
+    table = bytearray([DISPATCH_NONE] * 256)
+    for index, (letter, _) in enumerate(children):
+        table[letter] = index
+    return bytes(table)
+
+
+def build_dispatch(nodes: bytes, root: int) -> tuple[bytes, bytes]:
+    # Table 0 maps a byte to the root's child index; slots[b] names the table for the root's child on byte b (0 = none,
+    # scan that node instead).
+    root_children = _node_children(nodes, root)
+    tables = [_dense_table(root_children)]
+    slots = bytearray(256)
+    for letter, child in root_children:
+        grandchildren = _node_children(nodes, child)
+        if len(grandchildren) < DISPATCH_MIN_CHILDREN:
+            continue
+        if len(tables) > 0xFF:
+            break
+        slots[letter] = len(tables)
+        tables.append(_dense_table(grandchildren))
+    return b''.join(tables), bytes(slots)
+
+
 def _symbol_from_output(path: pathlib.Path) -> str:
     # Derive a stable C identifier from the destination header name (e.g., hyph-en.trie.h -> en).
     name = path.name
@@ -31,28 +124,46 @@ def _symbol_from_output(path: pathlib.Path) -> str:
     return name
 
 
-def write_header(path: pathlib.Path, blob: bytes, symbol: str) -> None:
-    # Emit a constexpr header containing the raw bytes plus a SerializedHyphenationPatterns descriptor.
+def split_blob(blob: bytes) -> tuple[bytes, int]:
     # The binary format has:
     #   - 4 bytes: big-endian root address
     #   - levels tape: from byte 4 to root_addr
     #   - nodes data: from root_addr onwards
-    
+    # Returns the data after the root address and the root offset within it.
     if len(blob) < 4:
         raise ValueError(f"Blob too small: {len(blob)} bytes")
-    
+
     # Parse root address (big-endian uint32)
     root_addr = (blob[0] << 24) | (blob[1] << 16) | (blob[2] << 8) | blob[3]
-    
+
     if root_addr > len(blob):
         raise ValueError(f"Root address {root_addr} exceeds blob size {len(blob)}")
-    
+
     # Remove the 4-byte root address and adjust the offset
-    bytes_literal = _format_bytes(blob[4:])
-    root_addr_new = root_addr - 4
+    return blob[4:], root_addr - 4
+
+
+def read_header_blob(path: pathlib.Path) -> bytes:
+    # Recover the hypher blob from a header this script generated, so packs can be built without the original .bin.
+    text = path.read_text()
+    data = re.search(r'_trie_data\[\] = \{(.*?)\};', text, re.S)
+    root = re.search(r'_patterns = \{\s*(0x[0-9A-Fa-f]+)u,', text)
+    if not data or not root:
+        raise ValueError(f"{path} is not a generated trie header")
+    nodes = bytes(int(value, 16) for value in re.findall(r'0x([0-9A-Fa-f]{2})', data.group(1)))
+    return (int(root.group(1), 16) + 4).to_bytes(4, 'big') + nodes
+
+
+def write_header(path: pathlib.Path, blob: bytes, symbol: str) -> None:
+    # Emit a constexpr header containing the raw bytes plus a SerializedHyphenationPatterns descriptor.
+    nodes, root_addr_new = split_blob(blob)
+    bytes_literal = _format_bytes(nodes)
+    dispatch, slots = build_dispatch(nodes, root_addr_new)
 
     path.parent.mkdir(parents=True, exist_ok=True)
     data_symbol = f"{symbol}_trie_data"
+    dispatch_symbol = f"{symbol}_trie_dispatch"
+    slots_symbol = f"{symbol}_trie_dispatch_slots"
     patterns_symbol = f"{symbol}_patterns"
 
     content = f"""#pragma once
@@ -67,34 +178,66 @@ alignas(4) constexpr uint8_t {data_symbol}[] = {{
 {bytes_literal}
 }};
 
+// Dense first-step transitions: {len(dispatch) // 256} tables of 256 child indexes (0xFF = no child).
+constexpr uint8_t {dispatch_symbol}[] = {{
+{_format_bytes(dispatch)}
+}};
+
+constexpr uint8_t {slots_symbol}[] = {{
+{_format_bytes(slots)}
+}};
+
 constexpr SerializedHyphenationPatterns {patterns_symbol} = {{
     {f"0x{root_addr_new:02X}"}u,
     {data_symbol},
     sizeof({data_symbol}),
+    {dispatch_symbol},
+    {slots_symbol},
 }};
 """
     path.write_text(content)
 
 
+def write_pack(path: pathlib.Path, blob: bytes) -> None:
+    # Emit a pattern pack holding the same trie and dispatch tables as the header, for HyphenationPack to read.
+    nodes, root = split_blob(blob)
+    largest = _max_node_size(nodes, root)
+    if largest > PACK_MAX_NODE_SIZE:
+        raise ValueError(f"Largest node is {largest} bytes; packs allow {PACK_MAX_NODE_SIZE}")
+    dispatch, slots = build_dispatch(nodes, root)
+    header = PACK_MAGIC + struct.pack('<BBHII', PACK_VERSION, len(dispatch) // 256, 0, root, len(nodes))
+    path.parent.mkdir(parents=True, exist_ok=True)
+    path.write_bytes(header + nodes + slots + dispatch)
+
+
 def main() -> None:
     parser = argparse.ArgumentParser()
     parser.add_argument('--input', dest='inputs', action='append', required=True,
-                        help='Path to a hypher-generated .bin trie')
-    parser.add_argument('--output', dest='outputs', action='append', required=True,
+                        help='Path to a hypher-generated .bin trie, or to a header generated from one')
+    parser.add_argument('--output', dest='outputs', action='append', default=[],
                         help='Destination header path (hyph-*.trie.h)')
+    parser.add_argument('--pack', dest='packs', action='append', default=[],
+                        help='Destination pattern pack path (hyph-*.pack)')
     args = parser.parse_args()
 
-    if len(args.inputs) != len(args.outputs):
-        raise SystemExit('input/output counts must match')
+    if not args.outputs and not args.packs:
+        raise SystemExit('at least one --output or --pack is required')
+    for targets in (args.outputs, args.packs):
+        if targets and len(targets) != len(args.inputs):
+            raise SystemExit('input/output counts must match')
 
-    for src, dst in zip(args.inputs, args.outputs):
-        # Process each input/output pair independently so mixed-language refreshes work in one invocation.
+    for index, src in enumerate(args.inputs):
+        # Process each input independently so mixed-language refreshes work in one invocation.
         src_path = pathlib.Path(src)
-        blob = src_path.read_bytes()
-        out_path = pathlib.Path(dst)
-        symbol = _symbol_from_output(out_path)
-        write_header(out_path, blob, symbol)
-        print(f'wrote {dst} ({len(blob)} bytes payload)')
+        blob = read_header_blob(src_path) if src_path.name.endswith('.h') else src_path.read_bytes()
+        if args.outputs:
+            out_path = pathlib.Path(args.outputs[index])
+            write_header(out_path, blob, _symbol_from_output(out_path))
+            print(f'wrote {out_path} ({len(blob)} bytes payload)')
+        if args.packs:
+            pack_path = pathlib.Path(args.packs[index])
+            write_pack(pack_path, blob)
+            print(f'wrote {pack_path} ({pack_path.stat().st_size} bytes)')
 
 
 if __name__ == '__main__':
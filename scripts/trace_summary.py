@@ -0,0 +1,228 @@
+#!/usr/bin/env python3
+"""
+Summarize a page-turn latency trace dumped by the firmware.
+
+The trace ring (lib/Logging/Trace.h) is dumped either over serial with `CMD:TRACE` (debugging_monitor.py saves it
+to trace.txt) or over HTTP from /api/trace. Each event is one line:
+
+    <time_us> <B|E|I> <stage> <arg>
+
+Other lines (log output, TRACE_START/TRACE_END markers) are ignored, so a raw serial capture works too.
+
+Spans are nested by time into a flame-style tree, and each node gets count, p50, p95 and max duration. End-to-end
+latency is measured from every input edge to the start of the render it triggers (how long input waits before any
+work on the new page begins) and to the end of the first panel refresh that follows it. Page turns served from the
+page cache (page_cache_hit instants) are counted against those that read their page (page_load spans), and every hit
+is credited with the median page_load time it saved.
+
+Usage:
+    python trace_summary.py trace.txt
+    python trace_summary.py --url http://crosspoint.local/api/trace
+    python trace_summary.py trace.txt --folded > trace.folded   # input for flamegraph.pl
+"""
+
+from __future__ import annotations
+
+import argparse
+import math
+import re
+import sys
+import urllib.request
+from dataclasses import dataclass, field
+
+EVENT_RE = re.compile(r"^(\d+) ([BEI]) ([a-z_]+) (\d+)$")
+WRAP = 1 << 32
+
+
+@dataclass
+class Event:
+    time_us: int
+    kind: str
+    stage: str
+    arg: int
+
+
+@dataclass
+class Span:
+    stage: str
+    start: int
+    end: int
+    arg: int
+    path: str = ""
+    children_us: int = 0
+
+    @property
+    def duration(self) -> int:
+        return self.end - self.start
+
+
+@dataclass
+class Node:
+    durations: list[int] = field(default_factory=list)
+    self_us: int = 0
+
+
+def parse_events(lines: list[str]) -> list[Event]:
+    events: list[Event] = []
+    offset = 0
+    previous = None
+    for line in lines:
+        match = EVENT_RE.match(line.strip())
+        if not match:
+            continue
+        raw = int(match.group(1))
+        # Timestamps are micros() and wrap every ~71 minutes; events are in recording order
+        if previous is not None and raw + offset < previous - WRAP // 2:
+            offset += WRAP
+        time_us = raw + offset
+        previous = time_us
+        events.append(Event(time_us, match.group(2), match.group(3), int(match.group(4))))
+    return events
+
+
+def build_spans(events: list[Event]) -> list[Span]:
+    open_spans: dict[str, list[Event]] = {}
+    spans: list[Span] = []
+    for event in events:
+        if event.kind == "B":
+            open_spans.setdefault(event.stage, []).append(event)
+        elif event.kind == "E":
+            stack = open_spans.get(event.stage)
+            # An END without its BEGIN was cut off by the ring wrapping
+            if stack:
+                begin = stack.pop()
+                spans.append(Span(event.stage, begin.time_us, event.time_us, begin.arg))
+    spans.sort(key=lambda s: (s.start, -s.end))
+
+    # Innermost enclosing span is the parent; spans from other tasks that overlap without nesting become roots
+    stack: list[Span] = []
+    for span in spans:
+        while stack and not (span.start >= stack[-1].start and span.end <= stack[-1].end):
+            stack.pop()
+        if stack:
+            span.path = f"{stack[-1].path};{span.stage}"
+            stack[-1].children_us += span.duration
+        else:
+            span.path = span.stage
+        stack.append(span)
+    return spans
+
+
+def percentile(values: list[int], pct: float) -> int:
+    # Nearest-rank percentile
+    ordered = sorted(values)
+    rank = max(0, min(len(ordered) - 1, math.ceil(pct / 100 * len(ordered)) - 1))
+    return ordered[rank]
+
+
+def end_to_end(events: list[Event], spans: list[Span], stage: str, to_start: bool = False) -> list[int]:
+    """Latency from each input edge to the end (or start) of the first `stage` span that starts after it."""
+    inputs = [e.time_us for e in events if e.kind == "I" and e.stage == "input"]
+    ends = sorted((s.start, s.end) for s in spans if s.stage == stage)
+    latencies = []
+    for i, t in enumerate(inputs):
+        next_input = inputs[i + 1] if i + 1 < len(inputs) else None
+        for start, end in ends:
+            if start < t:
+                continue
+            if next_input is not None and start >= next_input:
+                break
+            latencies.append((start if to_start else end) - t)
+            break
+    return latencies
+
+
+def ms(us: int) -> str:
+    return f"{us / 1000:9.2f}"
+
+
+def print_summary(events: list[Event], spans: list[Span]) -> None:
+    nodes: dict[str, Node] = {}
+    first_start: dict[str, int] = {}
+    for span in spans:
+        first_start.setdefault(span.path, span.start)
+        node = nodes.setdefault(span.path, Node())
+        node.durations.append(span.duration)
+        node.self_us += max(0, span.duration - span.children_us)
+
+    print(f"{len(events)} events, {len(spans)} spans\n")
+    print(f"{'stage':<44} {'count':>6} {'p50 ms':>9} {'p95 ms':>9} {'max ms':>9} {'self %':>7}")
+    # Children follow their parent, in the order the stages first ran (i.e. pipeline order)
+    def tree_order(path: str) -> list[int]:
+        parts = path.split(";")
+        return [first_start[";".join(parts[: i + 1])] for i in range(len(parts))]
+
+    for path in sorted(nodes, key=tree_order):
+        node = nodes[path]
+        depth = path.count(";")
+        name = "  " * depth + path.rsplit(";", 1)[-1]
+        total = sum(node.durations)
+        self_pct = 100 * node.self_us / total if total else 0
+        print(
+            f"{name:<44} {len(node.durations):>6} {ms(percentile(node.durations, 50))} "
+            f"{ms(percentile(node.durations, 95))} {ms(max(node.durations))} {self_pct:6.1f}%"
+        )
+
+    print()
+    for label, stage, to_start in (
+        ("input -> render_task start", "render_task", True),
+        ("input -> display_refresh done", "display_refresh", False),
+        ("input -> grayscale_refresh done", "grayscale_refresh", False),
+    ):
+        latencies = end_to_end(events, spans, stage, to_start)
+        if latencies:
+            print(
+                f"{label:<44} {len(latencies):>6} {ms(percentile(latencies, 50))} "
+                f"{ms(percentile(latencies, 95))} {ms(max(latencies))}"
+            )
+
+    hits = sum(1 for e in events if e.kind == "I" and e.stage == "page_cache_hit")
+    loads = [s.duration for s in spans if s.stage == "page_load"]
+    if hits:
+        turns = hits + len(loads)
+        saved_us = hits * percentile(loads, 50) if loads else 0
+        print(
+            f"\npage cache: {hits}/{turns} page turns hit ({100 * hits / turns:.1f}%), "
+            f"~{saved_us / turns / 1000:.2f} ms saved per turn"
+        )
+
+
+def print_folded(spans: list[Span]) -> None:
+    self_time: dict[str, int] = {}
+    for span in spans:
+        self_time[span.path] = self_time.get(span.path, 0) + max(0, span.duration - span.children_us)
+    for path in sorted(self_time):
+        print(f"{path} {self_time[path]}")
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Summarize a CrossPoint page-turn trace dump")
+    parser.add_argument("dump", nargs="?", help="Trace dump file (default: stdin)")
+    parser.add_argument("--url", help="Fetch the dump from a device, e.g. http://crosspoint.local/api/trace")
+    parser.add_argument("--folded", action="store_true", help="Print folded stacks (self time in us) for flamegraph.pl")
+    args = parser.parse_args()
+
+    if args.url:
+        with urllib.request.urlopen(args.url, timeout=10) as response:
+            lines = response.read().decode("utf-8", errors="replace").splitlines()
+    elif args.dump and args.dump != "-":
+        with open(args.dump, encoding="utf-8", errors="replace") as f:
+            lines = f.read().splitlines()
+    else:
+        lines = sys.stdin.read().splitlines()
+
+    events = parse_events(lines)
+    if not events:
+        print("No trace events found", file=sys.stderr)
+        return 1
+
+    spans = build_spans(events)
+    if args.folded:
+        print_folded(spans)
+    else:
+        print_summary(events, spans)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
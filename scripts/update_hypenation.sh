@@ -13,7 +13,8 @@ process() {
 
   python scripts/generate_hyphenation_trie.py \
     --input "build/$lang.bin" \
-    --output "lib/Epub/Epub/hyphenation/generated/hyph-${lang}.trie.h"
+    --output "lib/Epub/Epub/hyphenation/generated/hyph-${lang}.trie.h" \
+    --pack "build/hyphenation/hyph-${lang}.pack"
 }
 
 process en
@@ -23,3 +24,6 @@ process es
 process ru
 process it
 process uk
+
+# English is built into the firmware; copy the other packs to /hyphenation/ on the SD card
+rm "build/hyphenation/hyph-en.pack"
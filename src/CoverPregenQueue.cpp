@@ -0,0 +1,280 @@
+#include "CoverPregenQueue.h"
+
+#include <Epub.h>
+#include <FsHelpers.h>
+#include <HalPowerManager.h>
+#include <HalStorage.h>
+#include <JpegToBmpConverter.h>
+#include <Logging.h>
+#include <PngToBmpConverter.h>
+#include <Serialization.h>
+#include <Txt.h>
+#include <Xtc.h>
+
+#include <algorithm>
+
+#include "CrossPointSettings.h"
+#include "components/UITheme.h"
+
+namespace {
+constexpr uint8_t COVER_QUEUE_FILE_VERSION = 1;
+constexpr char COVER_QUEUE_FILE[] = "/.crosspoint/cover_queue.bin";
+constexpr size_t MAX_PENDING_BOOKS = 32;
+// Epub metadata and the JPEG/PNG decoders run on the generator task
+constexpr uint32_t GENERATOR_STACK_SIZE = 8192;
+
+// Variants the active theme and sleep screen settings will ask for
+struct CoverTargets {
+  int thumbHeight;
+  bool wantsSleepCover;
+  bool cropped;
+};
+
+CoverTargets currentTargets() {
+  return {UITheme::getInstance().getMetrics().homeCoverHeight,
+          SETTINGS.sleepScreen == CrossPointSettings::SLEEP_SCREEN_MODE::COVER ||
+              SETTINGS.sleepScreen == CrossPointSettings::SLEEP_SCREEN_MODE::COVER_CUSTOM,
+          SETTINGS.sleepScreenCoverMode == CrossPointSettings::SLEEP_SCREEN_COVER_MODE::CROP};
+}
+
+// Cache paths are derived from the file path, so missing variants can be found without loading the book
+struct MissingVariants {
+  bool thumb = false;
+  bool cover = false;
+  bool any() const { return thumb || cover; }
+};
+
+MissingVariants findMissingVariants(const std::string& path, const CoverTargets& targets) {
+  MissingVariants missing;
+  if (FsHelpers::hasEpubExtension(path)) {
+    const Epub epub(path, "/.crosspoint");
+    missing.thumb = !Storage.exists(epub.getThumbBmpPath(targets.thumbHeight).c_str());
+    missing.cover = targets.wantsSleepCover && !Storage.exists(epub.getCoverBmpPath(targets.cropped).c_str());
+  } else if (FsHelpers::hasXtcExtension(path)) {
+    const Xtc xtc(path, "/.crosspoint");
+    missing.thumb = !Storage.exists(xtc.getThumbBmpPath(targets.thumbHeight).c_str());
+    missing.cover = targets.wantsSleepCover && !Storage.exists(xtc.getCoverBmpPath().c_str());
+  } else if (FsHelpers::hasTxtExtension(path)) {
+    // TXT files only have a sleep screen cover (from an image in the same folder)
+    const Txt txt(path, "/.crosspoint");
+    missing.cover = targets.wantsSleepCover && !Storage.exists(txt.getCoverBmpPath().c_str());
+  }
+  return missing;
+}
+}  // namespace
+
+CoverPregenQueue CoverPregenQueue::instance;
+
+void CoverPregenQueue::ensureLoaded() {
+  if (!loaded) {
+    loadFromFile();
+    loaded = true;
+  }
+}
+
+void CoverPregenQueue::enqueue(const std::string& path) {
+  if (!FsHelpers::hasEpubExtension(path) && !FsHelpers::hasXtcExtension(path) && !FsHelpers::hasTxtExtension(path)) {
+    return;
+  }
+
+  ensureLoaded();
+  if (std::find(pendingBooks.begin(), pendingBooks.end(), path) != pendingBooks.end()) {
+    return;
+  }
+  if (!findMissingVariants(path, currentTargets()).any()) {
+    return;
+  }
+  if (pendingBooks.size() >= MAX_PENDING_BOOKS) {
+    LOG_DBG("CPQ", "Queue full, dropping oldest entry: %s", pendingBooks.front().c_str());
+    pendingBooks.erase(pendingBooks.begin());
+  }
+
+  pendingBooks.push_back(path);
+  LOG_DBG("CPQ", "Queued cover generation: %s", path.c_str());
+  saveToFile();
+}
+
+bool CoverPregenQueue::hasPending() {
+  ensureLoaded();
+  return !pendingBooks.empty();
+}
+
+CoverPregenQueue::StepResult CoverPregenQueue::generateNextVariant(const std::string& path) const {
+  const CoverTargets targets = currentTargets();
+  const MissingVariants missing = findMissingVariants(path, targets);
+  if (!missing.any()) {
+    return StepResult::Complete;
+  }
+
+  bool success = false;
+  if (FsHelpers::hasEpubExtension(path)) {
+    Epub epub(path, "/.crosspoint");
+    // Skip loading css since we only need metadata here
+    if (epub.load(true, true)) {
+      success = missing.thumb ? epub.generateThumbBmp(targets.thumbHeight) : epub.generateCoverBmp(targets.cropped);
+    }
+  } else if (FsHelpers::hasXtcExtension(path)) {
+    Xtc xtc(path, "/.crosspoint");
+    if (xtc.load()) {
+      success = missing.thumb ? xtc.generateThumbBmp(targets.thumbHeight) : xtc.generateCoverBmp();
+    }
+  } else if (FsHelpers::hasTxtExtension(path)) {
+    Txt txt(path, "/.crosspoint");
+    success = txt.load() && txt.generateCoverBmp();
+  }
+  return success ? StepResult::Generated : StepResult::Failed;
+}
+
+bool CoverPregenQueue::processNext() {
+  ensureLoaded();
+
+  while (!pendingBooks.empty()) {
+    const std::string& path = pendingBooks.front();
+    if (Storage.exists(path.c_str())) {
+      const unsigned long start = millis();
+      const StepResult result = generateNextVariant(path);
+      if (result == StepResult::Generated) {
+        LOG_DBG("CPQ", "Generated cover variant for %s in %lu ms", path.c_str(), millis() - start);
+        return true;
+      }
+      if (result == StepResult::Failed && generatorCancelled) {
+        // Aborted mid-conversion; the partial BMP is gone, so the book is simply tried again next time
+        return false;
+      }
+      if (result == StepResult::Failed) {
+        LOG_DBG("CPQ", "Cover generation failed, dropping: %s", path.c_str());
+      }
+    }
+
+    // Book is complete, failed or no longer exists
+    pendingBooks.erase(pendingBooks.begin());
+    saveToFile();
+  }
+
+  return false;
+}
+
+void CoverPregenQueue::startGenerator() {
+  reapGenerator();
+  if (generatorTask) {
+    return;
+  }
+  if (!generatorStopped) {
+    generatorStopped = xSemaphoreCreateBinary();
+    if (!generatorStopped) {
+      LOG_ERR("CPQ", "Failed to create generator semaphore");
+      return;
+    }
+  }
+
+  generatorCancelled = false;
+  generatorDone = false;
+  // Idle priority: the loop and render tasks preempt the generator whenever they are ready to run
+  xTaskCreate(&generatorTrampoline, "CoverPregen",
+              GENERATOR_STACK_SIZE,  // Stack size
+              this,                  // Parameters
+              tskIDLE_PRIORITY,      // Priority
+              &generatorTask         // Task handle
+  );
+  if (!generatorTask) {
+    LOG_ERR("CPQ", "Failed to create generator task");
+  }
+}
+
+void CoverPregenQueue::stopGenerator() {
+  if (!generatorTask) {
+    return;
+  }
+  cancelGenerator();
+  xSemaphoreTake(generatorStopped, portMAX_DELAY);
+  generatorTask = nullptr;
+}
+
+// Forget a generator that ended on its own
+void CoverPregenQueue::reapGenerator() {
+  if (generatorTask && generatorDone) {
+    xSemaphoreTake(generatorStopped, portMAX_DELAY);
+    generatorTask = nullptr;
+  }
+}
+
+void CoverPregenQueue::generatorTrampoline(void* param) {
+  auto* self = static_cast<CoverPregenQueue*>(param);
+  self->generatorLoop();
+}
+
+// Stops the converters mid-image once the generator is cancelled, and only on the generator task
+bool CoverPregenQueue::generatorAborted() {
+  return instance.generatorCancelled && xTaskGetCurrentTaskHandle() == instance.generatorTask;
+}
+
+void CoverPregenQueue::generatorLoop() {
+  JpegToBmpConverter::setAbortCheck(&generatorAborted);
+  PngToBmpConverter::setAbortCheck(&generatorAborted);
+  {
+    HalPowerManager::Lock powerLock;  // Decode at full CPU frequency
+    while (!generatorCancelled && processNext()) {
+    }
+  }
+  JpegToBmpConverter::setAbortCheck(nullptr);
+  PngToBmpConverter::setAbortCheck(nullptr);
+
+  generatorDone = true;
+  xSemaphoreGive(generatorStopped);
+  vTaskDelete(nullptr);
+}
+
+bool CoverPregenQueue::saveToFile() const {
+  if (pendingBooks.empty()) {
+    if (Storage.exists(COVER_QUEUE_FILE)) {
+      Storage.remove(COVER_QUEUE_FILE);
+    }
+    return true;
+  }
+
+  Storage.mkdir("/.crosspoint");
+  FsFile outputFile;
+  if (!Storage.openFileForWrite("CPQ", COVER_QUEUE_FILE, outputFile)) {
+    return false;
+  }
+
+  serialization::writePod(outputFile, COVER_QUEUE_FILE_VERSION);
+  serialization::writePod(outputFile, static_cast<uint8_t>(pendingBooks.size()));
+  for (const auto& path : pendingBooks) {
+    serialization::writeString(outputFile, path);
+  }
+  return true;
+}
+
+bool CoverPregenQueue::loadFromFile() {
+  pendingBooks.clear();
+
+  if (!Storage.exists(COVER_QUEUE_FILE)) {
+    return false;
+  }
+
+  FsFile inputFile;
+  if (!Storage.openFileForRead("CPQ", COVER_QUEUE_FILE, inputFile)) {
+    return false;
+  }
+
+  uint8_t version;
+  serialization::readPod(inputFile, version);
+  if (version != COVER_QUEUE_FILE_VERSION) {
+    LOG_ERR("CPQ", "Deserialization failed: Unknown version %u", version);
+    return false;
+  }
+
+  uint8_t count = 0;
+  serialization::readPod(inputFile, count);
+  count = std::min(count, static_cast<uint8_t>(MAX_PENDING_BOOKS));
+  pendingBooks.reserve(count);
+  for (uint8_t i = 0; i < count; i++) {
+    std::string path;
+    serialization::readString(inputFile, path);
+    pendingBooks.push_back(std::move(path));
+  }
+
+  LOG_DBG("CPQ", "Loaded %u pending cover jobs", count);
+  return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * Low-priority queue of books whose cover and thumbnail BMPs should be generated ahead of first display.
+ *
+ * Books are enqueued after an upload completes and whenever the home screen lists recent books. The queue is drained
+ * while the device idles on the home screen, by a generator task at idle priority: a JPEG/PNG decode takes seconds,
+ * and the loop and render tasks preempt the generator as soon as they have work, so input is handled mid-decode.
+ * Input cancels the generator: a JPEG/PNG conversion in progress stops at its next row and removes its partial BMP,
+ * and the book stays queued, so leaving the home screen does not wait for a decode to finish. The pending list is
+ * persisted to the SD card, and already generated variants are skipped, so progress survives deep sleep.
+ *
+ * While the generator runs, it alone uses the queue: only start it, and touch the queue again, once it has ended.
+ */
+class CoverPregenQueue {
+  // Static instance
+  static CoverPregenQueue instance;
+
+  std::vector<std::string> pendingBooks;
+  bool loaded = false;
+
+  TaskHandle_t generatorTask = nullptr;
+  SemaphoreHandle_t generatorStopped = nullptr;
+  volatile bool generatorCancelled = false;
+  volatile bool generatorDone = false;
+
+  enum class StepResult { Generated, Complete, Failed };
+  StepResult generateNextVariant(const std::string& path) const;
+  void ensureLoaded();
+  void reapGenerator();
+  static bool generatorAborted();
+  static void generatorTrampoline(void* param);
+  void generatorLoop();
+
+ public:
+  ~CoverPregenQueue() = default;
+
+  // Get singleton instance
+  static CoverPregenQueue& getInstance() { return instance; }
+
+  // Add a book to the back of the queue (no-op for unsupported formats or books already queued)
+  void enqueue(const std::string& path);
+
+  bool hasPending();
+
+  // Generate at most one missing cover variant for the book at the head of the queue.
+  // Returns true if a variant was generated and more work may remain.
+  bool processNext();
+
+  // Start draining the queue on the generator task; no-op while it runs
+  void startGenerator();
+  // Let the generator stop the conversion in progress and end; returns at once
+  void cancelGenerator() { generatorCancelled = true; }
+  // Cancel the generator and wait until it has ended, before leaving the screen that started it. A conversion stops at
+  // its next image row; only a book's metadata load or cover extraction in progress is waited for.
+  void stopGenerator();
+  bool isGeneratorRunning() const { return generatorTask != nullptr && !generatorDone; }
+
+  bool saveToFile() const;
+
+  bool loadFromFile();
+};
+
+// Helper macro to access the cover pre-generation queue
+#define COVER_PREGEN CoverPregenQueue::getInstance()
@@ -9,6 +9,7 @@
 #include <string>
 
 #include "fontIds.h"
+#include "util/FontPackStore.h"
 
 // Initialize the static instance
 CrossPointSettings CrossPointSettings::instance;
@@ -58,6 +59,27 @@ void applyLegacyFrontButtonLayout(CrossPointSettings& settings) {
   }
 }
 
+struct ReaderFont {
+  const char* packName;  // Font pack file name without .epf, as build-font-packs.sh writes it
+  int fontId;            // Built-in font
+};
+
+// Indexed by FONT_FAMILY, then FONT_SIZE
+constexpr ReaderFont READER_FONTS[CrossPointSettings::FONT_FAMILY_COUNT][CrossPointSettings::FONT_SIZE_COUNT] = {
+    {{"notoserif_12", NOTOSERIF_12_FONT_ID},
+     {"notoserif_14", NOTOSERIF_14_FONT_ID},
+     {"notoserif_16", NOTOSERIF_16_FONT_ID},
+     {"notoserif_18", NOTOSERIF_18_FONT_ID}},
+    {{"notosans_12", NOTOSANS_12_FONT_ID},
+     {"notosans_14", NOTOSANS_14_FONT_ID},
+     {"notosans_16", NOTOSANS_16_FONT_ID},
+     {"notosans_18", NOTOSANS_18_FONT_ID}},
+    {{"opendyslexic_8", OPENDYSLEXIC_8_FONT_ID},
+     {"opendyslexic_10", OPENDYSLEXIC_10_FONT_ID},
+     {"opendyslexic_12", OPENDYSLEXIC_12_FONT_ID},
+     {"opendyslexic_14", OPENDYSLEXIC_14_FONT_ID}},
+};
+
 }  // namespace
 
 void CrossPointSettings::validateFrontButtonMapping(CrossPointSettings& settings) {
@@ -292,43 +314,19 @@ int CrossPointSettings::getRefreshFrequency() const {
 }
 
 int CrossPointSettings::getReaderFontId() const {
-  switch (fontFamily) {
-    case NOTOSERIF:
-    default:
-      switch (fontSize) {
-        case SMALL:
-          return NOTOSERIF_12_FONT_ID;
-        case MEDIUM:
-        default:
-          return NOTOSERIF_14_FONT_ID;
-        case LARGE:
-          return NOTOSERIF_16_FONT_ID;
-        case EXTRA_LARGE:
-          return NOTOSERIF_18_FONT_ID;
-      }
-    case NOTOSANS:
-      switch (fontSize) {
-        case SMALL:
-          return NOTOSANS_12_FONT_ID;
-        case MEDIUM:
-        default:
-          return NOTOSANS_14_FONT_ID;
-        case LARGE:
-          return NOTOSANS_16_FONT_ID;
-        case EXTRA_LARGE:
-          return NOTOSANS_18_FONT_ID;
-      }
-    case OPENDYSLEXIC:
-      switch (fontSize) {
-        case SMALL:
-          return OPENDYSLEXIC_8_FONT_ID;
-        case MEDIUM:
-        default:
-          return OPENDYSLEXIC_10_FONT_ID;
-        case LARGE:
-          return OPENDYSLEXIC_12_FONT_ID;
-        case EXTRA_LARGE:
-          return OPENDYSLEXIC_14_FONT_ID;
-      }
+  const uint8_t family = fontFamily < FONT_FAMILY_COUNT ? fontFamily : NOTOSERIF;
+  const uint8_t size = fontSize < FONT_SIZE_COUNT ? fontSize : MEDIUM;
+  const ReaderFont& font = READER_FONTS[family][size];
+
+  // A font pack named after the font is used in its place, under the pack's own font ID
+  int packFontId;
+  if (FontPackStore::findFont(font.packName, packFontId)) {
+    return packFontId;
   }
+#ifdef OMIT_FONTS
+  // Only the default reader font is built in
+  return NOTOSERIF_14_FONT_ID;
+#else
+  return font.fontId;
+#endif
 }
@@ -1,6 +1,8 @@
 #include "ActivityManager.h"
 
 #include <HalPowerManager.h>
+#include <HeapTags.h>
+#include <Trace.h>
 
 #include "OpdsServerStore.h"
 #include "boot_sleep/BootActivity.h"
@@ -34,6 +36,7 @@ void ActivityManager::renderTaskTrampoline(void* param) {
 void ActivityManager::renderTaskLoop() {
   while (true) {
     ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    Trace::Span span(Trace::Stage::RenderTask);
     // Acquire the lock before reading currentActivity to avoid a TOCTOU race
     // where the main task deletes the activity between the null-check and render().
     RenderLock lock;
@@ -127,6 +130,7 @@ void ActivityManager::loop() {
       currentActivity = std::move(pendingActivity);
 
       lock.unlock();  // onEnter may acquire its own lock
+      HeapTags::beginScope();
       currentActivity->onEnter();
 
       // onEnter may request another pending action, we will handle it in the next loop iteration
@@ -148,8 +152,22 @@ void ActivityManager::exitActivity(const RenderLock& lock) {
   // Note: lock must be held by the caller
   if (currentActivity) {
     currentActivity->onExit();
+    logHeapHighWater(*currentActivity);
     currentActivity.reset();
   }
+  // An activity resumed from the stack is measured from here
+  HeapTags::beginScope();
+}
+
+void ActivityManager::logHeapHighWater(const Activity& activity) {
+  for (size_t i = 0; i < HeapTags::TAG_COUNT; i++) {
+    const auto tag = static_cast<HeapTags::Tag>(i);
+    const HeapTags::Usage usage = HeapTags::usage(tag);
+    if (usage.scopePeakBytes == 0) continue;
+    LOG_INF("HEAP", "%s high-water %s: %zu bytes (boot peak %zu, largest free block at peak %zu)",
+            activity.name.c_str(), HeapTags::tagName(tag), usage.scopePeakBytes, usage.peakBytes,
+            usage.largestFreeAtPeak);
+  }
 }
 
 void ActivityManager::replaceActivity(std::unique_ptr<Activity>&& newActivity) {
@@ -162,6 +180,7 @@ void ActivityManager::replaceActivity(std::unique_ptr<Activity>&& newActivity) {
   } else {
     // No current activity, safe to launch immediately
     currentActivity = std::move(newActivity);
+    HeapTags::beginScope();
     currentActivity->onEnter();
   }
 }
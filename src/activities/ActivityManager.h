@@ -39,6 +39,8 @@ class ActivityManager {
   std::unique_ptr<Activity> currentActivity;
 
   void exitActivity(const RenderLock& lock);
+  // Per-tag heap high-water of the activity being exited, since it became current
+  static void logHeapHighWater(const Activity& activity);
 
   // Pending activity to be launched on next loop iteration
   std::unique_ptr<Activity> pendingActivity;
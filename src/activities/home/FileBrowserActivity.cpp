@@ -1,12 +1,13 @@
 #include "FileBrowserActivity.h"
 
+#include <DirectoryListingCache.h>
 #include <Epub.h>
 #include <FsHelpers.h>
 #include <GfxRenderer.h>
 #include <HalStorage.h>
 #include <I18n.h>
 
-#include <algorithm>
+#include <cstring>
 
 #include "../util/ConfirmationActivity.h"
 #include "CrossPointSettings.h"
@@ -16,89 +17,28 @@
 
 namespace {
 constexpr unsigned long GO_HOME_MS = 1000;
-}  // namespace
-
-void sortFileList(std::vector<std::string>& strs) {
-  std::sort(begin(strs), end(strs), [](const std::string& str1, const std::string& str2) {
-    // Directories first
-    bool isDir1 = str1.back() == '/';
-    bool isDir2 = str2.back() == '/';
-    if (isDir1 != isDir2) return isDir1;
-
-    // Start naive natural sort
-    const char* s1 = str1.c_str();
-    const char* s2 = str2.c_str();
-
-    // Iterate while both strings have characters
-    while (*s1 && *s2) {
-      // Check if both are at the start of a number
-      if (isdigit(*s1) && isdigit(*s2)) {
-        // Skip leading zeros and track them
-        const char* start1 = s1;
-        const char* start2 = s2;
-        while (*s1 == '0') s1++;
-        while (*s2 == '0') s2++;
-
-        // Count digits to compare lengths first
-        int len1 = 0, len2 = 0;
-        while (isdigit(s1[len1])) len1++;
-        while (isdigit(s2[len2])) len2++;
-
-        // Different length so return smaller integer value
-        if (len1 != len2) return len1 < len2;
-
-        // Same length so compare digit by digit
-        for (int i = 0; i < len1; i++) {
-          if (s1[i] != s2[i]) return s1[i] < s2[i];
-        }
 
-        // Numbers equal so advance pointers
-        s1 += len1;
-        s2 += len2;
-      } else {
-        // Regular case-insensitive character comparison
-        char c1 = tolower(*s1);
-        char c2 = tolower(*s2);
-        if (c1 != c2) return c1 < c2;
-        s1++;
-        s2++;
-      }
-    }
-
-    // One string is prefix of other
-    return *s1 == '\0' && *s2 != '\0';
-  });
+bool isBrowsableEntry(const char* name, const bool isDirectory) {
+  if ((!SETTINGS.showHiddenFiles && name[0] == '.') || strcmp(name, "System Volume Information") == 0) {
+    return false;
+  }
+  if (isDirectory) {
+    return true;
+  }
+  const std::string_view filename{name};
+  return FsHelpers::hasEpubExtension(filename) || FsHelpers::hasXtcExtension(filename) ||
+         FsHelpers::hasTxtExtension(filename) || FsHelpers::hasMarkdownExtension(filename) ||
+         FsHelpers::hasBmpExtension(filename);
 }
+}  // namespace
 
 void FileBrowserActivity::loadFiles() {
-  files.clear();
-
-  auto root = Storage.open(basepath.c_str());
-  if (!root || !root.isDirectory()) {
-    return;
-  }
-
-  root.rewindDirectory();
-
-  char name[500];
-  for (auto file = root.openNextFile(); file; file = root.openNextFile()) {
-    file.getName(name, sizeof(name));
-    if ((!SETTINGS.showHiddenFiles && name[0] == '.') || strcmp(name, "System Volume Information") == 0) {
-      continue;
-    }
-
-    if (file.isDirectory()) {
-      files.emplace_back(std::string(name) + "/");
-    } else {
-      std::string_view filename{name};
-      if (FsHelpers::hasEpubExtension(filename) || FsHelpers::hasXtcExtension(filename) ||
-          FsHelpers::hasTxtExtension(filename) || FsHelpers::hasMarkdownExtension(filename) ||
-          FsHelpers::hasBmpExtension(filename)) {
-        files.emplace_back(filename);
-      }
-    }
+  // Keep the listing we are leaving around so navigating back to it does not rescan the directory
+  DirectoryListingCache::park(std::move(listing), &isBrowsableEntry);
+  listing = DirectoryListingCache::load(basepath, &isBrowsableEntry);
+  if (!listing) {
+    listing = std::make_unique<DirectoryListing>(basepath);
   }
-  sortFileList(files);
 }
 
 void FileBrowserActivity::onEnter() {
@@ -119,7 +59,7 @@ void FileBrowserActivity::onEnter() {
 
     const auto pos = oldPath.find_last_of('/');
     const std::string fileName = oldPath.substr(pos + 1);
-    selectorIndex = findEntry(fileName);
+    selectorIndex = findEntry(fileName, false);
   } else {
     loadFiles();
   }
@@ -129,7 +69,9 @@ void FileBrowserActivity::onEnter() {
 
 void FileBrowserActivity::onExit() {
   Activity::onExit();
-  files.clear();
+  listing.reset();
+  // Cached listings are only useful while browsing, release them before opening a book
+  DirectoryListingCache::clear();
 }
 
 void FileBrowserActivity::clearFileMetadata(const std::string& fullPath) {
@@ -162,10 +104,10 @@ void FileBrowserActivity::loop() {
   const int pageItems = UITheme::getNumberOfItemsPerPage(renderer, true, false, true, false, pathReserved);
 
   if (mappedInput.wasReleased(MappedInputManager::Button::Confirm)) {
-    if (files.empty()) return;
+    if (listing->empty()) return;
 
-    const std::string& entry = files[selectorIndex];
-    bool isDirectory = (entry.back() == '/');
+    const std::string entry = listing->nameCStr(selectorIndex);
+    const bool isDirectory = listing->isDirectory(selectorIndex);
 
     if (mappedInput.getHeldTime() >= GO_HOME_MS && !isDirectory) {
       // --- LONG PRESS ACTION: DELETE FILE ---
@@ -179,12 +121,15 @@ void FileBrowserActivity::loop() {
           clearFileMetadata(fullPath);
           if (Storage.remove(fullPath.c_str())) {
             LOG_DBG("FileBrowser", "Deleted successfully");
+            // Drop the stale listing rather than parking it
+            listing.reset();
+            DirectoryListingCache::invalidate(basepath);
             loadFiles();
-            if (files.empty()) {
+            if (listing->empty()) {
               selectorIndex = 0;
-            } else if (selectorIndex >= files.size()) {
+            } else if (selectorIndex >= listing->size()) {
               // Move selection to the new "last" item
-              selectorIndex = files.size() - 1;
+              selectorIndex = listing->size() - 1;
             }
 
             requestUpdate(true);
@@ -205,7 +150,7 @@ void FileBrowserActivity::loop() {
       if (basepath.back() != '/') basepath += "/";
 
       if (isDirectory) {
-        basepath += entry.substr(0, entry.length() - 1);
+        basepath += entry;
         loadFiles();
         selectorIndex = 0;
         requestUpdate();
@@ -227,8 +172,8 @@ void FileBrowserActivity::loop() {
         loadFiles();
 
         const auto pos = oldPath.find_last_of('/');
-        const std::string dirName = oldPath.substr(pos + 1) + "/";
-        selectorIndex = findEntry(dirName);
+        const std::string dirName = oldPath.substr(pos + 1);
+        selectorIndex = findEntry(dirName, true);
 
         requestUpdate();
       } else {
@@ -237,7 +182,7 @@ void FileBrowserActivity::loop() {
     }
   }
 
-  int listSize = static_cast<int>(files.size());
+  int listSize = static_cast<int>(listing->size());
   buttonNavigator.onNextRelease([this, listSize] {
     selectorIndex = ButtonNavigator::nextIndex(static_cast<int>(selectorIndex), listSize);
     requestUpdate();
@@ -259,24 +204,23 @@ void FileBrowserActivity::loop() {
   });
 }
 
-std::string getFileName(std::string filename) {
-  if (filename.back() == '/') {
-    filename.pop_back();
+std::string getFileName(const std::string_view filename, const bool isDirectory) {
+  if (isDirectory) {
     if (!UITheme::getInstance().getTheme().showsFileIcons()) {
-      return "[" + filename + "]";
+      return "[" + std::string(filename) + "]";
     }
-    return filename;
+    return std::string(filename);
   }
   const auto pos = filename.rfind('.');
-  return filename.substr(0, pos);
+  return std::string(filename.substr(0, pos));
 }
 
-std::string getFileExtension(std::string filename) {
-  if (filename.back() == '/') {
+std::string getFileExtension(const std::string_view filename, const bool isDirectory) {
+  if (isDirectory) {
     return "";
   }
   const auto pos = filename.rfind('.');
-  return filename.substr(pos);
+  return std::string(filename.substr(pos));
 }
 
 void FileBrowserActivity::render(RenderLock&&) {
@@ -294,14 +238,17 @@ void FileBrowserActivity::render(RenderLock&&) {
   const int contentTop = metrics.topPadding + metrics.headerHeight + metrics.verticalSpacing;
   const int contentHeight =
       pageHeight - contentTop - metrics.buttonHintsHeight - metrics.verticalSpacing - pathReserved;
-  if (files.empty()) {
+  if (listing->empty()) {
     renderer.drawText(UI_10_FONT_ID, metrics.contentSidePadding, contentTop + 20, tr(STR_NO_FILES_FOUND));
   } else {
+    // Display strings are only built for the rows drawList actually renders
     GUI.drawList(
-        renderer, Rect{0, contentTop, pageWidth, contentHeight}, files.size(), selectorIndex,
-        [this](int index) { return getFileName(files[index]); }, nullptr,
-        [this](int index) { return UITheme::getFileIcon(files[index]); },
-        [this](int index) { return getFileExtension(files[index]); }, false);
+        renderer, Rect{0, contentTop, pageWidth, contentHeight}, listing->size(), selectorIndex,
+        [this](int index) { return getFileName(listing->name(index), listing->isDirectory(index)); }, nullptr,
+        [this](int index) {
+          return listing->isDirectory(index) ? Folder : UITheme::getFileIcon(listing->nameCStr(index));
+        },
+        [this](int index) { return getFileExtension(listing->name(index), listing->isDirectory(index)); }, false);
   }
 
   // Full path display
@@ -333,15 +280,14 @@ void FileBrowserActivity::render(RenderLock&&) {
 
   // Help text
   const auto labels =
-      mappedInput.mapLabels(basepath == "/" ? tr(STR_HOME) : tr(STR_BACK), files.empty() ? "" : tr(STR_OPEN),
-                            files.empty() ? "" : tr(STR_DIR_UP), files.empty() ? "" : tr(STR_DIR_DOWN));
+      mappedInput.mapLabels(basepath == "/" ? tr(STR_HOME) : tr(STR_BACK), listing->empty() ? "" : tr(STR_OPEN),
+                            listing->empty() ? "" : tr(STR_DIR_UP), listing->empty() ? "" : tr(STR_DIR_DOWN));
   GUI.drawButtonHints(renderer, labels.btn1, labels.btn2, labels.btn3, labels.btn4);
 
   renderer.displayBuffer();
 }
 
-size_t FileBrowserActivity::findEntry(const std::string& name) const {
-  for (size_t i = 0; i < files.size(); i++)
-    if (files[i] == name) return i;
-  return 0;
+size_t FileBrowserActivity::findEntry(const std::string& name, const bool isDirectory) const {
+  const size_t index = listing->find(name, isDirectory);
+  return index == DirectoryListing::npos ? 0 : index;
 }
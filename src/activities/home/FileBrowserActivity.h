@@ -1,8 +1,10 @@
 #pragma once
 
+#include <DirectoryListing.h>
+
 #include <functional>
+#include <memory>
 #include <string>
-#include <vector>
 
 #include "../Activity.h"
 #include "RecentBooksStore.h"
@@ -21,11 +23,11 @@ class FileBrowserActivity final : public Activity {
 
   // Files state
   std::string basepath = "/";
-  std::vector<std::string> files;
+  std::unique_ptr<DirectoryListing> listing = std::make_unique<DirectoryListing>();
 
   // Data loading
   void loadFiles();
-  size_t findEntry(const std::string& name) const;
+  size_t findEntry(const std::string& name, bool isDirectory) const;
 
  public:
   explicit FileBrowserActivity(GfxRenderer& renderer, MappedInputManager& mappedInput, std::string initialPath = "/")
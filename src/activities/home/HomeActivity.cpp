@@ -12,6 +12,7 @@
 #include <cstring>
 #include <vector>
 
+#include "CoverPregenQueue.h"
 #include "CrossPointSettings.h"
 #include "CrossPointState.h"
 #include "MappedInputManager.h"
@@ -20,6 +21,11 @@
 #include "components/UITheme.h"
 #include "fontIds.h"
 
+namespace {
+// How long the home screen must be left untouched before covers are pre-generated in the background
+constexpr unsigned long COVER_PREGEN_IDLE_MS = 2000;
+}  // namespace
+
 int HomeActivity::getMenuItemCount() const {
   int count = 4;  // File Browser, Recents, File transfer, Settings
   if (!recentBooks.empty()) {
@@ -118,6 +124,12 @@ void HomeActivity::onEnter() {
   const auto& metrics = UITheme::getInstance().getMetrics();
   loadRecentBooks(metrics.homeRecentBooksCount);
 
+  // Covers for recent books beyond the visible ones (and sleep screen covers) are generated while idle
+  for (const RecentBook& book : recentBooks) {
+    COVER_PREGEN.enqueue(book.path);
+  }
+  lastInputTime = millis();
+
   // Trigger first update
   requestUpdate();
 }
@@ -125,6 +137,9 @@ void HomeActivity::onEnter() {
 void HomeActivity::onExit() {
   Activity::onExit();
 
+  // The next screen gets the heap and the SD card to itself; a decode in progress is finished first
+  COVER_PREGEN.stopGenerator();
+
   // Free the stored cover buffer if any
   freeCoverBuffer();
 }
@@ -208,6 +223,19 @@ void HomeActivity::loop() {
       onSettingsOpen();
     }
   }
+
+  if (mappedInput.wasAnyPressed() || mappedInput.wasAnyReleased()) {
+    lastInputTime = millis();
+    COVER_PREGEN.cancelGenerator();
+    return;
+  }
+
+  // Pre-generate covers in the background while idle; input preempts the generator and cancels it.
+  // Don't start while the render task holds the lock (first render, recent covers being loaded).
+  if (recentsLoaded && millis() - lastInputTime >= COVER_PREGEN_IDLE_MS && !RenderLock::peek() &&
+      !COVER_PREGEN.isGeneratorRunning() && COVER_PREGEN.hasPending()) {
+    COVER_PREGEN.startGenerator();
+  }
 }
 
 void HomeActivity::render(RenderLock&&) {
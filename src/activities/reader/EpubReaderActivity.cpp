@@ -2,12 +2,14 @@
 
 #include <Epub/Page.h>
 #include <Epub/blocks/TextBlock.h>
+#include <Epub/converters/ImagePlaneCache.h>
 #include <FontCacheManager.h>
 #include <FsHelpers.h>
 #include <GfxRenderer.h>
 #include <HalStorage.h>
 #include <I18n.h>
 #include <Logging.h>
+#include <Trace.h>
 #include <esp_system.h>
 
 #include <limits>
@@ -33,6 +35,32 @@ constexpr unsigned long skipChapterMs = 700;
 // pages per minute, first item is 1 to prevent division by zero if accessed
 const std::vector<int> PAGE_TURN_LABELS = {1, 1, 3, 6, 12};
 
+// Read a page of `from` into the page cache, timing it as a page load for the hit statistics
+std::shared_ptr<const Page> loadPageIntoCache(PageCache& pageCache, const Section& from, const int spineIndex,
+                                              const uint16_t pageNumber, const Trace::Stage stage) {
+  const uint32_t start = micros();
+  Trace::record(stage, Trace::BEGIN, pageNumber);
+  std::shared_ptr<const Page> page = from.loadPage(pageNumber);
+  Trace::record(stage, Trace::END);
+  if (!page) {
+    return nullptr;
+  }
+  pageCache.recordLoad(micros() - start);
+  pageCache.insert(spineIndex, pageNumber, page, page->heapBytes());
+  return page;
+}
+
+void logPageCacheStats(const PageCache& pageCache) {
+  const auto& stats = pageCache.getStats();
+  const uint32_t turns = stats.hits + stats.misses;
+  // Every hit saves the mean time a page takes to read
+  const uint64_t savedUs = static_cast<uint64_t>(stats.hits) * pageCache.averageLoadUs();
+  LOG_DBG("ERS", "Page cache: %lu/%lu turns hit, ~%lums saved per turn, %d pages in %u bytes",
+          static_cast<unsigned long>(stats.hits), static_cast<unsigned long>(turns),
+          static_cast<unsigned long>(turns > 0 ? savedUs / turns / 1000 : 0), pageCache.size(),
+          static_cast<unsigned>(pageCache.usedBytes()));
+}
+
 int clampPercent(int percent) {
   if (percent < 0) {
     return 0;
@@ -106,6 +134,11 @@ void EpubReaderActivity::onExit() {
 
   APP_STATE.readerActivityLoadCount = 0;
   APP_STATE.saveToFile();
+  const auto& cacheStats = pageCache.getStats();
+  LOG_INF("ERS", "Page cache: %lu of %lu turns hit, %lu pages read, ~%luus per read",
+          static_cast<unsigned long>(cacheStats.hits), static_cast<unsigned long>(cacheStats.hits + cacheStats.misses),
+          static_cast<unsigned long>(cacheStats.loads), static_cast<unsigned long>(pageCache.averageLoadUs()));
+  pageCache.clear();
   section.reset();
   epub.reset();
 }
@@ -564,6 +597,7 @@ void EpubReaderActivity::render(RenderLock&& lock) {
   const uint16_t viewportHeight = renderer.getScreenHeight() - orientedMarginTop - orientedMarginBottom;
 
   if (!section) {
+    Trace::Span sectionSpan(Trace::Stage::SectionLoad, currentSpineIndex);
     const auto filepath = epub->getSpineItem(currentSpineIndex).href;
     LOG_DBG("ERS", "Loading file: %s, index: %d", filepath.c_str(), currentSpineIndex);
     section = std::unique_ptr<Section>(new Section(epub, currentSpineIndex, renderer));
@@ -575,6 +609,9 @@ void EpubReaderActivity::render(RenderLock&& lock) {
       LOG_DBG("ERS", "Cache not found, building...");
 
       const auto popupFn = [this]() { GUI.drawPopup(renderer, tr(STR_INDEXING)); };
+      // Settings changed or the chapter is new: cached pages may be stale, and the build wants the heap
+      pageCache.clear();
+      previousChapterSpineIndex = -1;
 
       if (!section->createSectionFile(SETTINGS.getReaderFontId(), SETTINGS.getReaderLineCompression(),
                                       SETTINGS.extraParagraphSpacing, SETTINGS.paragraphAlignment, viewportWidth,
@@ -584,6 +621,9 @@ void EpubReaderActivity::render(RenderLock&& lock) {
         section.reset();
         return;
       }
+      if (SETTINGS.imagePrerender) {
+        section->decodeImages(orientedMarginLeft, orientedMarginTop);
+      }
     } else {
       LOG_DBG("ERS", "Cache found, skipping build...");
     }
@@ -658,26 +698,34 @@ void EpubReaderActivity::render(RenderLock&& lock) {
   }
 
   {
-    auto p = section->loadPageFromSectionFile();
+    auto p = pageCache.find(currentSpineIndex, section->currentPage);
+    if (p) {
+      Trace::instant(Trace::Stage::PageCacheHit, section->currentPage);
+    } else {
+      p = loadPageIntoCache(pageCache, *section, currentSpineIndex, section->currentPage, Trace::Stage::PageLoad);
+    }
     if (!p) {
       LOG_ERR("ERS", "Failed to load page from SD - clearing section cache");
       section->clearCache();
+      pageCache.dropChapter(currentSpineIndex);
       section.reset();
       requestUpdate();  // Try again after clearing cache
                         // TODO: prevent infinite loop if the page keeps failing to load for some reason
       automaticPageTurnActive = false;
       return;
     }
+    logPageCacheStats(pageCache);
 
-    // Collect footnotes from the loaded page
-    currentPageFootnotes = std::move(p->footnotes);
+    // Collect footnotes from the loaded page; it stays in the page cache
+    currentPageFootnotes = p->footnotes;
 
     const auto start = millis();
-    renderContents(std::move(p), orientedMarginTop, orientedMarginRight, orientedMarginBottom, orientedMarginLeft);
+    renderContents(*p, orientedMarginTop, orientedMarginRight, orientedMarginBottom, orientedMarginLeft);
     LOG_DBG("ERS", "Rendered page in %dms", millis() - start);
   }
-  silentIndexNextChapterIfNeeded(viewportWidth, viewportHeight);
+  silentIndexNextChapterIfNeeded(viewportWidth, viewportHeight, orientedMarginLeft, orientedMarginTop);
   saveProgress(currentSpineIndex, section->currentPage, section->pageCount);
+  readAheadNeighbours(viewportWidth, viewportHeight);
 
   if (pendingScreenshot) {
     pendingScreenshot = false;
@@ -685,7 +733,8 @@ void EpubReaderActivity::render(RenderLock&& lock) {
   }
 }
 
-void EpubReaderActivity::silentIndexNextChapterIfNeeded(const uint16_t viewportWidth, const uint16_t viewportHeight) {
+void EpubReaderActivity::silentIndexNextChapterIfNeeded(const uint16_t viewportWidth, const uint16_t viewportHeight,
+                                                        const int orientedMarginLeft, const int orientedMarginTop) {
   if (!epub || !section || section->pageCount < 2) {
     return;
   }
@@ -709,11 +758,76 @@ void EpubReaderActivity::silentIndexNextChapterIfNeeded(const uint16_t viewportW
   }
 
   LOG_DBG("ERS", "Silently indexing next chapter: %d", nextSpineIndex);
+  // The build wants the heap more than the cached pages, which read-ahead refills after this
+  pageCache.clear();
   if (!nextSection.createSectionFile(SETTINGS.getReaderFontId(), SETTINGS.getReaderLineCompression(),
                                      SETTINGS.extraParagraphSpacing, SETTINGS.paragraphAlignment, viewportWidth,
                                      viewportHeight, SETTINGS.hyphenationEnabled, SETTINGS.embeddedStyle,
                                      SETTINGS.imageRendering)) {
     LOG_ERR("ERS", "Failed silent indexing for chapter: %d", nextSpineIndex);
+    return;
+  }
+  if (SETTINGS.imagePrerender) {
+    nextSection.decodeImages(orientedMarginLeft, orientedMarginTop);
+  }
+}
+
+void EpubReaderActivity::readAheadNeighbours(const uint16_t viewportWidth, const uint16_t viewportHeight) {
+  if (!section || section->pageCount == 0) {
+    return;
+  }
+
+  // The page a forward turn lands on first: it is the usual next turn
+  const int page = section->currentPage;
+  if (page + 1 < section->pageCount) {
+    if (!pageCache.contains(currentSpineIndex, page + 1)) {
+      loadPageIntoCache(pageCache, *section, currentSpineIndex, page + 1, Trace::Stage::PageReadAhead);
+    }
+  } else {
+    readAheadChapterBoundary(currentSpineIndex + 1, false, viewportWidth, viewportHeight);
+  }
+
+  if (page > 0) {
+    if (!pageCache.contains(currentSpineIndex, page - 1)) {
+      loadPageIntoCache(pageCache, *section, currentSpineIndex, page - 1, Trace::Stage::PageReadAhead);
+    }
+  } else {
+    readAheadChapterBoundary(currentSpineIndex - 1, true, viewportWidth, viewportHeight);
+  }
+}
+
+void EpubReaderActivity::readAheadChapterBoundary(const int spineIndex, const bool lastPage,
+                                                  const uint16_t viewportWidth, const uint16_t viewportHeight) {
+  if (spineIndex < 0 || spineIndex >= epub->getSpineItemsCount()) {
+    return;
+  }
+
+  // Already cached: skip opening the section file on SD
+  if (!lastPage && pageCache.contains(spineIndex, 0)) {
+    return;
+  }
+  if (lastPage && spineIndex == previousChapterSpineIndex &&
+      pageCache.contains(spineIndex, previousChapterPageCount - 1)) {
+    return;
+  }
+
+  // Only a chapter already laid out for the current settings; building one is left to the turn that enters it
+  Section adjacent(epub, spineIndex, renderer);
+  if (!adjacent.loadSectionFile(SETTINGS.getReaderFontId(), SETTINGS.getReaderLineCompression(),
+                                SETTINGS.extraParagraphSpacing, SETTINGS.paragraphAlignment, viewportWidth,
+                                viewportHeight, SETTINGS.hyphenationEnabled, SETTINGS.embeddedStyle,
+                                SETTINGS.imageRendering) ||
+      adjacent.pageCount == 0) {
+    return;
+  }
+
+  if (lastPage) {
+    previousChapterSpineIndex = spineIndex;
+    previousChapterPageCount = adjacent.pageCount;
+  }
+  const uint16_t page = lastPage ? adjacent.pageCount - 1 : 0;
+  if (!pageCache.contains(spineIndex, page)) {
+    loadPageIntoCache(pageCache, adjacent, spineIndex, page, Trace::Stage::PageReadAhead);
   }
 }
 
@@ -733,18 +847,22 @@ void EpubReaderActivity::saveProgress(int spineIndex, int currentPage, int pageC
     LOG_ERR("ERS", "Could not save progress!");
   }
 }
-void EpubReaderActivity::renderContents(std::unique_ptr<Page> page, const int orientedMarginTop,
-                                        const int orientedMarginRight, const int orientedMarginBottom,
-                                        const int orientedMarginLeft) {
+void EpubReaderActivity::renderContents(const Page& page, const int orientedMarginTop, const int orientedMarginRight,
+                                        const int orientedMarginBottom, const int orientedMarginLeft) {
   const auto t0 = millis();
   auto* fcm = renderer.getFontCacheManager();
   fcm->resetStats();
 
+  // Images are read from SD on the first pass only; the remaining passes blit their cached planes
+  ImagePlaneCache::PageScope imagePlanes;
+
   // Font prewarm: scan pass accumulates text, then prewarm, then real render
   const uint32_t heapBefore = esp_get_free_heap_size();
+  Trace::record(Trace::Stage::Prewarm, Trace::BEGIN);
   auto scope = fcm->createPrewarmScope();
-  page->render(renderer, SETTINGS.getReaderFontId(), orientedMarginLeft, orientedMarginTop);  // scan pass
+  page.render(renderer, SETTINGS.getReaderFontId(), orientedMarginLeft, orientedMarginTop);  // scan pass
   scope.endScanAndPrewarm();
+  Trace::record(Trace::Stage::Prewarm, Trace::END);
   const uint32_t heapAfter = esp_get_free_heap_size();
   fcm->logStats("prewarm");
   const auto tPrewarm = millis();
@@ -753,10 +871,12 @@ void EpubReaderActivity::renderContents(std::unique_ptr<Page> page, const int or
           (int32_t)heapAfter - (int32_t)heapBefore);
 
   // Force special handling for pages with images when anti-aliasing is on
-  bool imagePageWithAA = page->hasImages() && SETTINGS.textAntiAliasing;
+  bool imagePageWithAA = page.hasImages() && SETTINGS.textAntiAliasing;
 
-  page->render(renderer, SETTINGS.getReaderFontId(), orientedMarginLeft, orientedMarginTop);
+  Trace::record(Trace::Stage::BwRender, Trace::BEGIN);
+  page.render(renderer, SETTINGS.getReaderFontId(), orientedMarginLeft, orientedMarginTop);
   renderStatusBar();
+  Trace::record(Trace::Stage::BwRender, Trace::END);
   fcm->logStats("bw_render");
   const auto tBwRender = millis();
 
@@ -767,13 +887,13 @@ void EpubReaderActivity::renderContents(std::unique_ptr<Page> page, const int or
     // Step 1: Display page with image area blanked (text appears, image area white)
     // Step 2: Re-render with images and display again (images appear clean)
     int16_t imgX, imgY, imgW, imgH;
-    if (page->getImageBoundingBox(imgX, imgY, imgW, imgH)) {
+    if (page.getImageBoundingBox(imgX, imgY, imgW, imgH)) {
       renderer.fillRect(imgX + orientedMarginLeft, imgY + orientedMarginTop, imgW, imgH, false);
       renderer.displayBuffer(HalDisplay::FAST_REFRESH);
 
       // Re-render page content to restore images into the blanked area
       // Status bar is not re-rendered here to avoid reading stale dynamic values (e.g. battery %)
-      page->render(renderer, SETTINGS.getReaderFontId(), orientedMarginLeft, orientedMarginTop);
+      page.render(renderer, SETTINGS.getReaderFontId(), orientedMarginLeft, orientedMarginTop);
       renderer.displayBuffer(HalDisplay::FAST_REFRESH);
     } else {
       renderer.displayBuffer(HalDisplay::HALF_REFRESH);
@@ -793,15 +913,19 @@ void EpubReaderActivity::renderContents(std::unique_ptr<Page> page, const int or
   if (SETTINGS.textAntiAliasing) {
     renderer.clearScreen(0x00);
     renderer.setRenderMode(GfxRenderer::GRAYSCALE_LSB);
-    page->render(renderer, SETTINGS.getReaderFontId(), orientedMarginLeft, orientedMarginTop);
+    Trace::record(Trace::Stage::GrayscaleRender, Trace::BEGIN, GfxRenderer::GRAYSCALE_LSB);
+    page.render(renderer, SETTINGS.getReaderFontId(), orientedMarginLeft, orientedMarginTop);
     renderer.copyGrayscaleLsbBuffers();
+    Trace::record(Trace::Stage::GrayscaleRender, Trace::END);
     const auto tGrayLsb = millis();
 
     // Render and copy to MSB buffer
     renderer.clearScreen(0x00);
     renderer.setRenderMode(GfxRenderer::GRAYSCALE_MSB);
-    page->render(renderer, SETTINGS.getReaderFontId(), orientedMarginLeft, orientedMarginTop);
+    Trace::record(Trace::Stage::GrayscaleRender, Trace::BEGIN, GfxRenderer::GRAYSCALE_MSB);
+    page.render(renderer, SETTINGS.getReaderFontId(), orientedMarginLeft, orientedMarginTop);
     renderer.copyGrayscaleMsbBuffers();
+    Trace::record(Trace::Stage::GrayscaleRender, Trace::END);
     const auto tGrayMsb = millis();
 
     // display grayscale part
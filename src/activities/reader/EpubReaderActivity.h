@@ -1,6 +1,7 @@
 #pragma once
 #include <Epub.h>
 #include <Epub/FootnoteEntry.h>
+#include <Epub/PageCache.h>
 #include <Epub/Section.h>
 
 #include <optional>
@@ -11,6 +12,12 @@
 class EpubReaderActivity final : public Activity {
   std::shared_ptr<Epub> epub;
   std::unique_ptr<Section> section = nullptr;
+  // Pages shown and read ahead, so turning back and forth (also across chapters) skips the section file
+  PageCache pageCache;
+  // Page count of the chapter before the current one, once read-ahead has opened it, so later renders of the first
+  // page can find its last page in the cache without opening the section file again
+  int previousChapterSpineIndex = -1;
+  uint16_t previousChapterPageCount = 0;
   int currentSpineIndex = 0;
   int nextPageNumber = 0;
   std::optional<uint16_t> pendingPageJump;
@@ -41,10 +48,14 @@ class EpubReaderActivity final : public Activity {
   SavedPosition savedPositions[MAX_FOOTNOTE_DEPTH] = {};
   int footnoteDepth = 0;
 
-  void renderContents(std::unique_ptr<Page> page, int orientedMarginTop, int orientedMarginRight,
-                      int orientedMarginBottom, int orientedMarginLeft);
+  void renderContents(const Page& page, int orientedMarginTop, int orientedMarginRight, int orientedMarginBottom,
+                      int orientedMarginLeft);
   void renderStatusBar() const;
-  void silentIndexNextChapterIfNeeded(uint16_t viewportWidth, uint16_t viewportHeight);
+  void silentIndexNextChapterIfNeeded(uint16_t viewportWidth, uint16_t viewportHeight, int orientedMarginLeft,
+                                      int orientedMarginTop);
+  // Read the pages a turn from the current one can land on into the page cache
+  void readAheadNeighbours(uint16_t viewportWidth, uint16_t viewportHeight);
+  void readAheadChapterBoundary(int spineIndex, bool lastPage, uint16_t viewportWidth, uint16_t viewportHeight);
   void saveProgress(int spineIndex, int currentPage, int pageCount);
   // Jump to a percentage of the book (0-100), mapping it to spine and page.
   void jumpToPercent(int percent);
@@ -1,11 +1,15 @@
 #include "TxtReaderActivity.h"
 
+#include <Epub/Page.h>
+#include <Epub/hyphenation/Hyphenator.h>
 #include <FontCacheManager.h>
+#include <FsHelpers.h>
 #include <GfxRenderer.h>
+#include <HalPowerManager.h>
 #include <HalStorage.h>
 #include <I18n.h>
-#include <Serialization.h>
-#include <Utf8.h>
+
+#include <new>
 
 #include "CrossPointSettings.h"
 #include "CrossPointState.h"
@@ -16,10 +20,8 @@
 #include "fontIds.h"
 
 namespace {
-constexpr size_t CHUNK_SIZE = 8 * 1024;  // 8KB chunk for reading
-// Cache file magic and version
-constexpr uint32_t CACHE_MAGIC = 0x54585449;  // "TXTI"
-constexpr uint8_t CACHE_VERSION = 2;          // Increment when cache format changes
+constexpr size_t CHUNK_SIZE = 4 * 1024;         // 4KB chunk for reading
+constexpr size_t INDEX_SLICE_BYTES = 4 * 1024;  // Text laid out per idle loop iteration
 }  // namespace
 
 void TxtReaderActivity::onEnter() {
@@ -50,8 +52,12 @@ void TxtReaderActivity::onExit() {
   // Reset orientation back to portrait for the rest of the UI
   renderer.setOrientation(GfxRenderer::Orientation::Portrait);
 
-  pageOffsets.clear();
-  currentPageLines.clear();
+  // Every slice is already committed, so the build resumes from here next time
+  stopIndexer();
+  pageIndex.close();
+  if (pagesFile) {
+    pagesFile.close();
+  }
   APP_STATE.readerActivityLoadCount = 0;
   APP_STATE.saveToFile();
   txt.reset();
@@ -73,6 +79,12 @@ void TxtReaderActivity::loop() {
 
   auto [prevTriggered, nextTriggered, fromTilt] = ReaderUtils::detectPageTurn(mappedInput);
   if (!prevTriggered && !nextTriggered) {
+    // Extend the page cache while idle; skip while the render task holds the lock so page turns go first
+    if (parser && !RenderLock::peek()) {
+      RenderLock lock(*this);
+      HalPowerManager::Lock powerLock;
+      indexSlice();
+    }
     return;
   }
 
@@ -80,7 +92,7 @@ void TxtReaderActivity::loop() {
     currentPage--;
     requestUpdate();
   } else if (nextTriggered) {
-    if (currentPage < totalPages - 1) {
+    if (hasNextPage) {
       currentPage++;
       requestUpdate();
     } else {
@@ -94,206 +106,226 @@ void TxtReaderActivity::initializeReader() {
     return;
   }
 
-  // Store current settings for cache validation
   cachedFontId = SETTINGS.getReaderFontId();
-  cachedScreenMargin = SETTINGS.screenMargin;
-  cachedParagraphAlignment = SETTINGS.paragraphAlignment;
+  markdown = FsHelpers::hasMarkdownExtension(txt->getPath());
 
   // Calculate viewport dimensions
   renderer.getOrientedViewableTRBL(&cachedOrientedMarginTop, &cachedOrientedMarginRight, &cachedOrientedMarginBottom,
                                    &cachedOrientedMarginLeft);
-  cachedOrientedMarginTop += cachedScreenMargin;
-  cachedOrientedMarginLeft += cachedScreenMargin;
-  cachedOrientedMarginRight += cachedScreenMargin;
+  cachedOrientedMarginTop += SETTINGS.screenMargin;
+  cachedOrientedMarginLeft += SETTINGS.screenMargin;
+  cachedOrientedMarginRight += SETTINGS.screenMargin;
   cachedOrientedMarginBottom +=
-      std::max(cachedScreenMargin, static_cast<uint8_t>(UITheme::getInstance().getStatusBarHeight()));
+      std::max(SETTINGS.screenMargin, static_cast<uint8_t>(UITheme::getInstance().getStatusBarHeight()));
 
   viewportWidth = renderer.getScreenWidth() - cachedOrientedMarginLeft - cachedOrientedMarginRight;
-  const int viewportHeight = renderer.getScreenHeight() - cachedOrientedMarginTop - cachedOrientedMarginBottom;
-  const int lineHeight = renderer.getLineHeight(cachedFontId);
-
-  linesPerPage = viewportHeight / lineHeight;
-  if (linesPerPage < 1) linesPerPage = 1;
-
-  LOG_DBG("TRS", "Viewport: %dx%d, lines per page: %d", viewportWidth, viewportHeight, linesPerPage);
-
-  // Try to load cached page index first
-  if (!loadPageIndexCache()) {
-    // Cache not found, build page index
-    buildPageIndex();
-    // Save to cache for next time
-    savePageIndexCache();
+  viewportHeight = renderer.getScreenHeight() - cachedOrientedMarginTop - cachedOrientedMarginBottom;
+  LOG_DBG("TRS", "Viewport: %ux%u%s", viewportWidth, viewportHeight, markdown ? ", Markdown" : "");
+
+  // Keyed on the same parameters as an EPUB section, so changing any of them rebuilds the pages
+  TxtPageIndex::Layout layout;
+  layout.fileSize = txt->getFileSize();
+  layout.fontId = cachedFontId;
+  layout.lineCompression = SETTINGS.getReaderLineCompression();
+  layout.extraParagraphSpacing = SETTINGS.extraParagraphSpacing;
+  layout.paragraphAlignment = SETTINGS.paragraphAlignment;
+  layout.viewportWidth = viewportWidth;
+  layout.viewportHeight = viewportHeight;
+  layout.hyphenationEnabled = SETTINGS.hyphenationEnabled;
+  layout.markdown = markdown;
+  pageIndex.open(txt->getCachePath() + "/index.bin", layout);
+  pagesFile = Storage.open((txt->getCachePath() + "/pages.bin").c_str(), O_RDWR | O_CREAT);
+  if (!pagesFile) {
+    LOG_ERR("TRS", "Failed to open page cache");
+  }
+
+  uint32_t savedOffset = 0;
+  const bool hasSavedOffset = loadProgress(savedOffset);
+  startIndexer();
+
+  if (hasSavedOffset && pageIndex.wasReset() && savedOffset > 0) {
+    // The pages moved (font, margins, ...): build up to the saved position and open the page that now holds it
+    indexUntil([this, savedOffset]() {
+      TxtPageIndex::Entry last;
+      const uint32_t count = pageIndex.getPageCount();
+      return pageIndex.isComplete() ||
+             (count > 0 && pageIndex.getEntry(count - 1, last) && last.blockOffset > savedOffset);
+    });
+    currentPage = static_cast<int>(pageIndex.findPage(savedOffset));
   }
 
-  // Load saved progress
-  loadProgress();
-
   initialized = true;
 }
 
-void TxtReaderActivity::buildPageIndex() {
-  pageOffsets.clear();
-  pageOffsets.push_back(0);  // First page starts at offset 0
-
-  size_t offset = 0;
-  const size_t fileSize = txt->getFileSize();
-
-  LOG_DBG("TRS", "Building page index for %zu bytes...", fileSize);
-
-  GUI.drawPopup(renderer, tr(STR_INDEXING));
-
-  while (offset < fileSize) {
-    std::vector<std::string> tempLines;
-    size_t nextOffset = offset;
-
-    if (!loadPageAtOffset(offset, tempLines, nextOffset)) {
-      break;
-    }
-
-    if (nextOffset <= offset) {
-      // No progress made, avoid infinite loop
-      break;
-    }
+bool TxtReaderActivity::startIndexer() {
+  if (pageIndex.isComplete() || !pagesFile) {
+    return pageIndex.isComplete();
+  }
 
-    offset = nextOffset;
-    if (offset < fileSize) {
-      pageOffsets.push_back(offset);
-    }
+  // A page is rebuilt from where it starts, so continue by building the last stored page again. The first page is
+  // laid out below the top margin of its first block, so a build with one page starts over.
+  uint32_t storedPages = pageIndex.getPageCount();
+  TxtPageIndex::Entry resume;
+  if (storedPages < 2 || !pageIndex.getEntry(storedPages - 1, resume) || resume.pagePos > pagesFile.size()) {
+    storedPages = 0;
+    resume = TxtPageIndex::Entry();
+  }
+  if (!pageIndex.truncate(storedPages > 0 ? storedPages - 1 : 0)) {
+    LOG_ERR("TRS", "Failed to reset page index");
+    return false;
+  }
 
-    // Yield to other tasks periodically
-    if (pageOffsets.size() % 20 == 0) {
-      vTaskDelay(1);
-    }
+  if (!Storage.openFileForRead("TRS", txt->getPath(), indexSource) || !indexSource.seek(resume.blockOffset)) {
+    LOG_ERR("TRS", "Failed to open %s for indexing", txt->getPath().c_str());
+    return false;
+  }
+  indexBuffer.reset(new (std::nothrow) uint8_t[CHUNK_SIZE]);
+  if (!indexBuffer) {
+    LOG_ERR("TRS", "Failed to allocate %zu bytes", CHUNK_SIZE);
+    indexSource.close();
+    return false;
   }
 
-  totalPages = pageOffsets.size();
-  LOG_DBG("TRS", "Built page index: %d pages", totalPages);
+  // Plain text has no language tag to pick hyphenation patterns by; the layout must not depend on the last book
+  Hyphenator::setPreferredLanguage("");
+  builder = std::make_unique<TxtPageBuilder>(
+      renderer, cachedFontId, SETTINGS.getReaderLineCompression(), SETTINGS.extraParagraphSpacing,
+      SETTINGS.paragraphAlignment, viewportWidth, viewportHeight, SETTINGS.hyphenationEnabled,
+      [this](std::unique_ptr<Page> page, const TxtPageBuilder::PageStart& start) {
+        onPageBuilt(std::move(page), start);
+      });
+  if (storedPages > 0) {
+    builder->resume(resume.lineSkip);
+  }
+  parser = std::make_unique<TxtBlockParser>(
+      markdown ? TxtBlockParser::Format::Markdown : TxtBlockParser::Format::Plain, *builder, resume.blockOffset,
+      resume.state);
+  pagesEnd = resume.pagePos;
+  indexedBytes = resume.blockOffset;
+  buildFailed = false;
+  LOG_DBG("TRS", "Building pages from offset %lu (%lu pages stored)", static_cast<unsigned long>(resume.blockOffset),
+          static_cast<unsigned long>(pageIndex.getPageCount()));
+  return true;
 }
 
-bool TxtReaderActivity::loadPageAtOffset(size_t offset, std::vector<std::string>& outLines, size_t& nextOffset) {
-  outLines.clear();
-  const size_t fileSize = txt->getFileSize();
+void TxtReaderActivity::onPageBuilt(std::unique_ptr<Page> page, const TxtPageBuilder::PageStart& start) {
+  if (buildFailed) {
+    return;
+  }
+  if (!pagesFile.seek(pagesEnd) || !page->serialize(pagesFile)) {
+    LOG_ERR("TRS", "Failed to store page %lu",
+            static_cast<unsigned long>(pageIndex.getPageCount() + pendingEntries.size()));
+    buildFailed = true;
+    return;
+  }
+  TxtPageIndex::Entry entry;
+  entry.pagePos = pagesEnd;
+  entry.blockOffset = start.blockOffset;
+  entry.lineSkip = start.lineSkip;
+  entry.state = start.state;
+  pendingEntries.push_back(entry);
+  pagesEnd = pagesFile.position();
+}
 
-  if (offset >= fileSize) {
+bool TxtReaderActivity::indexSlice() {
+  if (!parser) {
     return false;
   }
 
-  // Read a chunk from file
-  size_t chunkSize = std::min(CHUNK_SIZE, fileSize - offset);
-  auto* buffer = static_cast<uint8_t*>(malloc(chunkSize + 1));
-  if (!buffer) {
-    LOG_ERR("TRS", "Failed to allocate %zu bytes", chunkSize);
+  const size_t fileSize = txt->getFileSize();
+  size_t sliceBytes = 0;
+  while (indexedBytes < fileSize && sliceBytes < INDEX_SLICE_BYTES) {
+    const int bytesRead = indexSource.read(indexBuffer.get(), std::min(CHUNK_SIZE, fileSize - indexedBytes));
+    if (bytesRead <= 0) {
+      LOG_ERR("TRS", "Read failed at offset %zu, indexing stopped", indexedBytes);
+      stopIndexer();
+      return false;
+    }
+    parser->feed(indexBuffer.get(), bytesRead);
+    indexedBytes += bytesRead;
+    sliceBytes += bytesRead;
+  }
+  const bool done = indexedBytes >= fileSize;
+  if (done) {
+    parser->finish();
+    builder->finish();
+  }
+  if (buildFailed) {
+    stopIndexer();
     return false;
   }
 
-  if (!txt->readContent(buffer, offset, chunkSize)) {
-    free(buffer);
+  // Pages first, so every committed entry points at a complete page
+  pagesFile.flush();
+  if (!pageIndex.append(pendingEntries.data(), pendingEntries.size(), done)) {
+    LOG_ERR("TRS", "Failed to store page index, indexing stopped");
+    stopIndexer();
     return false;
   }
-  buffer[chunkSize] = '\0';
-
-  // Parse lines from buffer
-  size_t pos = 0;
+  pendingEntries.clear();
 
-  while (pos < chunkSize && static_cast<int>(outLines.size()) < linesPerPage) {
-    // Find end of line
-    size_t lineEnd = pos;
-    while (lineEnd < chunkSize && buffer[lineEnd] != '\n') {
-      lineEnd++;
-    }
-
-    // Check if we have a complete line
-    bool lineComplete = (lineEnd < chunkSize) || (offset + lineEnd >= fileSize);
-
-    if (!lineComplete && static_cast<int>(outLines.size()) > 0) {
-      // Incomplete line and we already have some lines, stop here
-      break;
-    }
+  if (done) {
+    LOG_DBG("TRS", "Pages complete: %lu", static_cast<unsigned long>(pageIndex.getPageCount()));
+    stopIndexer();
+  }
+  return true;
+}
 
-    // Calculate the actual length of line content in the buffer (excluding newline)
-    size_t lineContentLen = lineEnd - pos;
-
-    // Check for carriage return
-    bool hasCR = (lineContentLen > 0 && buffer[pos + lineContentLen - 1] == '\r');
-    size_t displayLen = hasCR ? lineContentLen - 1 : lineContentLen;
-
-    // Extract line content for display (without CR/LF)
-    std::string line(reinterpret_cast<char*>(buffer + pos), displayLen);
-
-    // Track position within this source line (in bytes from pos)
-    size_t lineBytePos = 0;
-
-    // Word wrap if needed
-    while (!line.empty() && static_cast<int>(outLines.size()) < linesPerPage) {
-      int lineWidth = renderer.getTextWidth(cachedFontId, line.c_str());
-
-      if (lineWidth <= viewportWidth) {
-        outLines.push_back(line);
-        lineBytePos = displayLen;  // Consumed entire display content
-        line.clear();
-        break;
-      }
-
-      // Find break point
-      size_t breakPos = line.length();
-      while (breakPos > 0 && renderer.getTextWidth(cachedFontId, line.substr(0, breakPos).c_str()) > viewportWidth) {
-        // Try to break at space
-        size_t spacePos = line.rfind(' ', breakPos - 1);
-        if (spacePos != std::string::npos && spacePos > 0) {
-          breakPos = spacePos;
-        } else {
-          // Break at character boundary for UTF-8
-          breakPos--;
-          // Make sure we don't break in the middle of a UTF-8 sequence
-          while (breakPos > 0 && (line[breakPos] & 0xC0) == 0x80) {
-            breakPos--;
-          }
-        }
-      }
-
-      if (breakPos == 0) {
-        breakPos = 1;
-      }
-
-      outLines.push_back(line.substr(0, breakPos));
-
-      // Skip space at break point
-      size_t skipChars = breakPos;
-      if (breakPos < line.length() && line[breakPos] == ' ') {
-        skipChars++;
-      }
-      lineBytePos += skipChars;
-      line = line.substr(skipChars);
+bool TxtReaderActivity::indexUntil(const std::function<bool()>& reached) {
+  int slices = 0;
+  while (parser && !reached()) {
+    // Only worth a popup when it takes more than a moment
+    if (++slices == 2) {
+      GUI.drawPopup(renderer, tr(STR_INDEXING));
     }
-
-    // Determine how much of the source buffer we consumed
-    if (line.empty()) {
-      // Fully consumed this source line, move past the newline
-      pos = lineEnd + 1;
-    } else {
-      // Partially consumed - page is full mid-line
-      // Move pos to where we stopped in the line (NOT past the line)
-      pos = pos + lineBytePos;
+    if (!indexSlice()) {
       break;
     }
+    vTaskDelay(1);
   }
+  return reached();
+}
 
-  // Ensure we make progress even if calculations go wrong
-  if (pos == 0 && !outLines.empty()) {
-    // Fallback: at minimum, consume something to avoid infinite loop
-    pos = 1;
+void TxtReaderActivity::stopIndexer() {
+  // The parser refers to the builder
+  parser.reset();
+  builder.reset();
+  indexBuffer.reset();
+  if (indexSource) {
+    indexSource.close();
   }
+  pendingEntries.clear();
+  pendingEntries.shrink_to_fit();
+}
 
-  nextOffset = offset + pos;
-
-  // Make sure we don't go past the file
-  if (nextOffset > fileSize) {
-    nextOffset = fileSize;
+std::unique_ptr<Page> TxtReaderActivity::loadPage(const int page) {
+  if (page < 0) {
+    return nullptr;
   }
 
-  free(buffer);
+  // Usually already built: the build runs well ahead of reading
+  const auto target = static_cast<uint32_t>(page);
+  indexUntil([this, target]() { return pageIndex.getPageCount() > target; });
+  TxtPageIndex::Entry entry;
+  if (!pageIndex.getEntry(target, entry) || !pagesFile.seek(entry.pagePos)) {
+    return nullptr;
+  }
+  auto loaded = Page::deserialize(pagesFile);
+  if (loaded) {
+    currentOffset = entry.blockOffset;
+  }
+  return loaded;
+}
 
-  return !outLines.empty();
+int TxtReaderActivity::estimatedPageCount() const {
+  const int stored = static_cast<int>(pageIndex.getPageCount());
+  const int known = std::max(stored, currentPage + (hasNextPage ? 2 : 1));
+  if (pageIndex.isComplete() || indexedBytes == 0 || stored == 0) {
+    return known;
+  }
+  // Assume the rest of the file lays out like the part built so far
+  const auto estimate = static_cast<int>(static_cast<uint64_t>(stored) * txt->getFileSize() / indexedBytes);
+  return std::max(estimate, known);
 }
 
 void TxtReaderActivity::render(RenderLock&&) {
@@ -306,89 +338,59 @@ void TxtReaderActivity::render(RenderLock&&) {
     initializeReader();
   }
 
-  if (pageOffsets.empty()) {
+  if (currentPage < 0) currentPage = 0;
+
+  auto page = loadPage(currentPage);
+  if (!page && pageIndex.getPageCount() > 0) {
+    // The book ends before the requested page
+    currentPage = static_cast<int>(pageIndex.getPageCount()) - 1;
+    page = loadPage(currentPage);
+  }
+  if (!page) {
+    hasNextPage = false;
     renderer.clearScreen();
     renderer.drawCenteredText(UI_12_FONT_ID, 300, tr(STR_EMPTY_FILE), true, EpdFontFamily::BOLD);
     renderer.displayBuffer();
     return;
   }
-
-  // Bounds check
-  if (currentPage < 0) currentPage = 0;
-  if (currentPage >= totalPages) currentPage = totalPages - 1;
-
-  // Load current page content
-  size_t offset = pageOffsets[currentPage];
-  size_t nextOffset;
-  currentPageLines.clear();
-  loadPageAtOffset(offset, currentPageLines, nextOffset);
+  hasNextPage = currentPage + 1 < static_cast<int>(pageIndex.getPageCount()) || parser != nullptr;
 
   renderer.clearScreen();
-  renderPage();
+  renderPage(*page);
 
   // Save progress
   saveProgress();
 }
 
-void TxtReaderActivity::renderPage() {
-  const int lineHeight = renderer.getLineHeight(cachedFontId);
-  const int contentWidth = viewportWidth;
-
-  // Render text lines with alignment
-  auto renderLines = [&]() {
-    int y = cachedOrientedMarginTop;
-    for (const auto& line : currentPageLines) {
-      if (!line.empty()) {
-        int x = cachedOrientedMarginLeft;
-
-        // Apply text alignment
-        switch (cachedParagraphAlignment) {
-          case CrossPointSettings::LEFT_ALIGN:
-          default:
-            // x already set to left margin
-            break;
-          case CrossPointSettings::CENTER_ALIGN: {
-            int textWidth = renderer.getTextWidth(cachedFontId, line.c_str());
-            x = cachedOrientedMarginLeft + (contentWidth - textWidth) / 2;
-            break;
-          }
-          case CrossPointSettings::RIGHT_ALIGN: {
-            int textWidth = renderer.getTextWidth(cachedFontId, line.c_str());
-            x = cachedOrientedMarginLeft + contentWidth - textWidth;
-            break;
-          }
-          case CrossPointSettings::JUSTIFIED:
-            // For plain text, justified is treated as left-aligned
-            // (true justification would require word spacing adjustments)
-            break;
-        }
-
-        renderer.drawText(cachedFontId, x, y, line.c_str());
-      }
-      y += lineHeight;
-    }
-  };
-
+void TxtReaderActivity::renderPage(const Page& page) {
   // Font prewarm: scan pass accumulates text, then prewarm, then real render
   auto* fcm = renderer.getFontCacheManager();
   auto scope = fcm->createPrewarmScope();
-  renderLines();  // scan pass — text accumulated, no drawing
+  page.render(renderer, cachedFontId, cachedOrientedMarginLeft, cachedOrientedMarginTop);  // scan pass
   scope.endScanAndPrewarm();
 
   // BW rendering
-  renderLines();
+  page.render(renderer, cachedFontId, cachedOrientedMarginLeft, cachedOrientedMarginTop);
   renderStatusBar();
 
   ReaderUtils::displayWithRefreshCycle(renderer, pagesUntilFullRefresh);
 
   if (SETTINGS.textAntiAliasing) {
-    ReaderUtils::renderAntiAliased(renderer, [&renderLines]() { renderLines(); });
+    ReaderUtils::renderAntiAliased(renderer, [this, &page]() {
+      page.render(renderer, cachedFontId, cachedOrientedMarginLeft, cachedOrientedMarginTop);
+    });
   }
   // scope destructor clears font cache via FontCacheManager
 }
-
 void TxtReaderActivity::renderStatusBar() const {
-  const float progress = totalPages > 0 ? (currentPage + 1) * 100.0f / totalPages : 0;
+  const int totalPages = estimatedPageCount();
+  float progress = 0;
+  if (pageIndex.isComplete()) {
+    progress = (currentPage + 1) * 100.0f / totalPages;
+  } else if (txt->getFileSize() > 0) {
+    // Page numbers past the built part are estimates; the byte position is exact
+    progress = currentOffset * 100.0f / txt->getFileSize();
+  }
   std::string title;
   if (SETTINGS.statusBarTitle != CrossPointSettings::STATUS_BAR_TITLE::HIDE_TITLE) {
     title = txt->getTitle();
@@ -399,150 +401,35 @@ void TxtReaderActivity::renderStatusBar() const {
 void TxtReaderActivity::saveProgress() const {
   FsFile f;
   if (Storage.openFileForWrite("TRS", txt->getCachePath() + "/progress.bin", f)) {
-    uint8_t data[4];
+    // Page number, then the offset of the block the page starts in so the position survives a layout change
+    uint8_t data[8];
     data[0] = currentPage & 0xFF;
     data[1] = (currentPage >> 8) & 0xFF;
     data[2] = 0;
     data[3] = 0;
-    f.write(data, 4);
-  }
-}
-
-void TxtReaderActivity::loadProgress() {
-  FsFile f;
-  if (Storage.openFileForRead("TRS", txt->getCachePath() + "/progress.bin", f)) {
-    uint8_t data[4];
-    if (f.read(data, 4) == 4) {
-      currentPage = data[0] + (data[1] << 8);
-      if (currentPage >= totalPages) {
-        currentPage = totalPages - 1;
-      }
-      if (currentPage < 0) {
-        currentPage = 0;
-      }
-      LOG_DBG("TRS", "Loaded progress: page %d/%d", currentPage, totalPages);
+    for (int i = 0; i < 4; i++) {
+      data[4 + i] = (currentOffset >> (8 * i)) & 0xFF;
     }
+    f.write(data, 8);
   }
 }
 
-bool TxtReaderActivity::loadPageIndexCache() {
-  // Cache file format (using serialization module):
-  // - uint32_t: magic "TXTI"
-  // - uint8_t: cache version
-  // - uint32_t: file size (to validate cache)
-  // - int32_t: viewport width
-  // - int32_t: lines per page
-  // - int32_t: font ID (to invalidate cache on font change)
-  // - int32_t: screen margin (to invalidate cache on margin change)
-  // - uint8_t: paragraph alignment (to invalidate cache on alignment change)
-  // - uint32_t: total pages count
-  // - N * uint32_t: page offsets
-
-  std::string cachePath = txt->getCachePath() + "/index.bin";
+bool TxtReaderActivity::loadProgress(uint32_t& savedOffset) {
   FsFile f;
-  if (!Storage.openFileForRead("TRS", cachePath, f)) {
-    LOG_DBG("TRS", "No page index cache found");
-    return false;
-  }
-
-  // Read and validate header using serialization module
-  uint32_t magic;
-  serialization::readPod(f, magic);
-  if (magic != CACHE_MAGIC) {
-    LOG_DBG("TRS", "Cache magic mismatch, rebuilding");
-    return false;
-  }
-
-  uint8_t version;
-  serialization::readPod(f, version);
-  if (version != CACHE_VERSION) {
-    LOG_DBG("TRS", "Cache version mismatch (%d != %d), rebuilding", version, CACHE_VERSION);
-    return false;
-  }
-
-  uint32_t fileSize;
-  serialization::readPod(f, fileSize);
-  if (fileSize != txt->getFileSize()) {
-    LOG_DBG("TRS", "Cache file size mismatch, rebuilding");
+  if (!Storage.openFileForRead("TRS", txt->getCachePath() + "/progress.bin", f)) {
     return false;
   }
-
-  int32_t cachedWidth;
-  serialization::readPod(f, cachedWidth);
-  if (cachedWidth != viewportWidth) {
-    LOG_DBG("TRS", "Cache viewport width mismatch, rebuilding");
+  uint8_t data[8];
+  const int bytesRead = f.read(data, 8);
+  if (bytesRead < 4) {
     return false;
   }
-
-  int32_t cachedLines;
-  serialization::readPod(f, cachedLines);
-  if (cachedLines != linesPerPage) {
-    LOG_DBG("TRS", "Cache lines per page mismatch, rebuilding");
+  currentPage = data[0] + (data[1] << 8);
+  LOG_DBG("TRS", "Loaded progress: page %d", currentPage + 1);
+  if (bytesRead < 8) {
+    // Written before offsets were saved
     return false;
   }
-
-  int32_t fontId;
-  serialization::readPod(f, fontId);
-  if (fontId != cachedFontId) {
-    LOG_DBG("TRS", "Cache font ID mismatch (%d != %d), rebuilding", fontId, cachedFontId);
-    return false;
-  }
-
-  int32_t margin;
-  serialization::readPod(f, margin);
-  if (margin != cachedScreenMargin) {
-    LOG_DBG("TRS", "Cache screen margin mismatch, rebuilding");
-    return false;
-  }
-
-  uint8_t alignment;
-  serialization::readPod(f, alignment);
-  if (alignment != cachedParagraphAlignment) {
-    LOG_DBG("TRS", "Cache paragraph alignment mismatch, rebuilding");
-    return false;
-  }
-
-  uint32_t numPages;
-  serialization::readPod(f, numPages);
-
-  // Read page offsets
-  pageOffsets.clear();
-  pageOffsets.reserve(numPages);
-
-  for (uint32_t i = 0; i < numPages; i++) {
-    uint32_t offset;
-    serialization::readPod(f, offset);
-    pageOffsets.push_back(offset);
-  }
-
-  totalPages = pageOffsets.size();
-  LOG_DBG("TRS", "Loaded page index cache: %d pages", totalPages);
+  savedOffset = data[4] | (data[5] << 8) | (data[6] << 16) | (static_cast<uint32_t>(data[7]) << 24);
   return true;
 }
-
-void TxtReaderActivity::savePageIndexCache() const {
-  std::string cachePath = txt->getCachePath() + "/index.bin";
-  FsFile f;
-  if (!Storage.openFileForWrite("TRS", cachePath, f)) {
-    LOG_ERR("TRS", "Failed to save page index cache");
-    return;
-  }
-
-  // Write header using serialization module
-  serialization::writePod(f, CACHE_MAGIC);
-  serialization::writePod(f, CACHE_VERSION);
-  serialization::writePod(f, static_cast<uint32_t>(txt->getFileSize()));
-  serialization::writePod(f, static_cast<int32_t>(viewportWidth));
-  serialization::writePod(f, static_cast<int32_t>(linesPerPage));
-  serialization::writePod(f, static_cast<int32_t>(cachedFontId));
-  serialization::writePod(f, static_cast<int32_t>(cachedScreenMargin));
-  serialization::writePod(f, cachedParagraphAlignment);
-  serialization::writePod(f, static_cast<uint32_t>(pageOffsets.size()));
-
-  // Write page offsets
-  for (size_t offset : pageOffsets) {
-    serialization::writePod(f, static_cast<uint32_t>(offset));
-  }
-
-  LOG_DBG("TRS", "Saved page index cache: %d pages", totalPages);
-}
@@ -1,45 +1,65 @@
 #pragma once
 
 #include <Txt.h>
+#include <TxtBlockParser.h>
+#include <TxtPageBuilder.h>
+#include <TxtPageIndex.h>
 
+#include <functional>
 #include <vector>
 
-#include "CrossPointSettings.h"
 #include "activities/Activity.h"
 
+class Page;
+
 class TxtReaderActivity final : public Activity {
   std::unique_ptr<Txt> txt;
+  bool markdown = false;
 
   int currentPage = 0;
-  int totalPages = 1;
   int pagesUntilFullRefresh = 0;
+  uint32_t currentOffset = 0;  // Text offset of the block the current page starts in
+  bool hasNextPage = false;
+
+  // Pages are laid out once and stored in pages.bin, indexed by index.bin; the build is extended a slice at a time
+  // while the reader is idle
+  TxtPageIndex pageIndex;
+  FsFile pagesFile;
+  uint32_t pagesEnd = 0;  // Where the next built page is written
+  std::unique_ptr<TxtPageBuilder> builder;
+  std::unique_ptr<TxtBlockParser> parser;
+  FsFile indexSource;
+  std::unique_ptr<uint8_t[]> indexBuffer;
+  std::vector<TxtPageIndex::Entry> pendingEntries;  // Pages built by the current slice
+  size_t indexedBytes = 0;                          // How far the build has read
+  bool buildFailed = false;
 
-  // Streaming text reader - stores file offsets for each page
-  std::vector<size_t> pageOffsets;  // File offset for start of each page
-  std::vector<std::string> currentPageLines;
-  int linesPerPage = 0;
-  int viewportWidth = 0;
   bool initialized = false;
 
-  // Cached settings for cache validation (different fonts/margins require re-indexing)
+  // Layout the pages are built for
   int cachedFontId = 0;
-  uint8_t cachedScreenMargin = 0;
-  uint8_t cachedParagraphAlignment = CrossPointSettings::LEFT_ALIGN;
   int cachedOrientedMarginTop = 0;
   int cachedOrientedMarginRight = 0;
   int cachedOrientedMarginBottom = 0;
   int cachedOrientedMarginLeft = 0;
+  uint16_t viewportWidth = 0;
+  uint16_t viewportHeight = 0;
 
-  void renderPage();
+  void renderPage(const Page& page);
   void renderStatusBar() const;
 
   void initializeReader();
-  bool loadPageAtOffset(size_t offset, std::vector<std::string>& outLines, size_t& nextOffset);
-  void buildPageIndex();
-  bool loadPageIndexCache();
-  void savePageIndexCache() const;
+  std::unique_ptr<Page> loadPage(int page);
+  int estimatedPageCount() const;
+
+  bool startIndexer();
+  void onPageBuilt(std::unique_ptr<Page> page, const TxtPageBuilder::PageStart& start);
+  bool indexSlice();
+  bool indexUntil(const std::function<bool()>& reached);
+  void stopIndexer();
+
   void saveProgress() const;
-  void loadProgress();
+  bool loadProgress(uint32_t& savedOffset);
 
  public:
   explicit TxtReaderActivity(GfxRenderer& renderer, MappedInputManager& mappedInput, std::unique_ptr<Txt> txt)
@@ -48,5 +68,6 @@ class TxtReaderActivity final : public Activity {
   void onExit() override;
   void loop() override;
   void render(RenderLock&&) override;
+  bool skipLoopDelay() override { return parser != nullptr; }
   bool isReaderActivity() const override { return true; }
 };
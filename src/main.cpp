@@ -1,5 +1,6 @@
 #include <Arduino.h>
 #include <Epub.h>
+#include <Epub/hyphenation/LanguageRegistry.h>
 #include <FontCacheManager.h>
 #include <FontDecompressor.h>
 #include <GfxRenderer.h>
@@ -9,12 +10,17 @@
 #include <HalStorage.h>
 #include <HalSystem.h>
 #include <HalTiltSensor.h>
+#include <HeapTags.h>
 #include <I18n.h>
 #include <Logging.h>
 #include <SPI.h>
+#include <Trace.h>
 #include <builtinFonts/all.h>
 
+#include <algorithm>
 #include <cstring>
+#include <optional>
+#include <vector>
 
 #include "CrossPointSettings.h"
 #include "CrossPointState.h"
@@ -27,6 +33,8 @@
 #include "components/UITheme.h"
 #include "fontIds.h"
 #include "util/ButtonNavigator.h"
+#include "util/FontPackStore.h"
+#include "util/HyphenationPackStore.h"
 #include "util/ScreenshotUtil.h"
 
 MappedInputManager mappedInputManager(gpio);
@@ -124,6 +132,11 @@ EpdFont ui12RegularFont(&ubuntu_12_regular);
 EpdFont ui12BoldFont(&ubuntu_12_bold);
 EpdFontFamily ui12FontFamily(&ui12RegularFont, &ui12BoldFont);
 
+// How long the main loop may sleep between input samples. Buttons are sampled often while one is held or the user was
+// recently active, so held times and repeats stay accurate; the power button also wakes the loop by interrupt.
+constexpr uint32_t ACTIVE_INPUT_SAMPLE_MS = 10;
+constexpr uint32_t IDLE_INPUT_SAMPLE_MS = 50;
+
 // measurement of power button press duration calibration value
 unsigned long t1 = 0;
 unsigned long t2 = 0;
@@ -206,6 +219,8 @@ void setupDisplayAndFonts() {
   }
   fontCacheManager.setFontDecompressor(&fontDecompressor);
   renderer.setFontCacheManager(&fontCacheManager);
+  // Font packs on the SD card come first, so they take precedence over built-in fonts with the same ID
+  FontPackStore::registerFonts(renderer);
   renderer.insertFont(NOTOSERIF_14_FONT_ID, notoserif14FontFamily);
 #ifndef OMIT_FONTS
   renderer.insertFont(NOTOSERIF_12_FONT_ID, notoserif12FontFamily);
@@ -231,9 +246,11 @@ void setup() {
   t1 = millis();
 
   HalSystem::begin();
+  HeapTags::setLargestFreeBlockProbe([]() -> size_t { return ESP.getMaxAllocHeap(); });
   gpio.begin();
   powerManager.begin();
   halTiltSensor.begin();
+  gpio.enableInputWakeups();
 
 #ifdef ENABLE_SERIAL_LOG
   if (gpio.isUsbConnected()) {
@@ -258,6 +275,9 @@ void setup() {
 
   HalSystem::checkPanic();
 
+  // Hyphenation patterns other than English are loaded from the card on demand
+  setHyphenationPackLoader(HyphenationPackStore::load);
+
   SETTINGS.loadFromFile();
   I18N.loadSettings();
   KOREADER_STORE.loadFromFile();
@@ -344,6 +364,26 @@ void loop() {
         uint8_t* buf = display.getFrameBuffer();
         logSerial.write(buf, bufferSize);
         logSerial.printf("SCREENSHOT_END\n");
+      } else if (cmd == "TRACE") {
+        std::vector<Trace::Event> events(Trace::CAPACITY);
+        const size_t count = Trace::snapshot(events.data(), events.size());
+        logSerial.printf("TRACE_START:%u\n", static_cast<unsigned>(count));
+        char line[Trace::MAX_LINE];
+        for (size_t i = 0; i < count; i++) {
+          logSerial.write(reinterpret_cast<const uint8_t*>(line), Trace::formatEvent(events[i], line, sizeof(line)));
+        }
+        logSerial.printf("TRACE_END\n");
+      } else if (cmd == "HEAP") {
+        logSerial.printf("HEAP_START:%u\n", static_cast<unsigned>(HeapTags::TAG_COUNT));
+        logSerial.printf("free=%lu min_free=%lu largest_free=%lu\n", static_cast<unsigned long>(ESP.getFreeHeap()),
+                         static_cast<unsigned long>(ESP.getMinFreeHeap()),
+                         static_cast<unsigned long>(ESP.getMaxAllocHeap()));
+        char line[HeapTags::MAX_LINE];
+        for (size_t i = 0; i < HeapTags::TAG_COUNT; i++) {
+          HeapTags::formatUsage(static_cast<HeapTags::Tag>(i), line, sizeof(line));
+          logSerial.printf("%s\n", line);
+        }
+        logSerial.printf("HEAP_END\n");
       }
     }
   }
@@ -402,8 +442,19 @@ void loop() {
     activityManager.requestUpdate();
   }
 
+  // Only loop iterations that handle an input edge are traced, so idle polling does not flush the trace ring
+  const bool inputEdge = gpio.wasAnyPressed() || gpio.wasAnyReleased();
+  if (inputEdge) {
+    // Stamped with the interrupt time when there was one, so the trace includes the time the loop was asleep
+    Trace::recordAt(gpio.getEdgeTimeUs(), Trace::Stage::Input, Trace::INSTANT, gpio.wasAnyPressed() ? 1 : 0);
+  }
+
   const unsigned long activityStartTime = millis();
-  activityManager.loop();
+  {
+    std::optional<Trace::Span> span;
+    if (inputEdge) span.emplace(Trace::Stage::ActivityLoop);
+    activityManager.loop();
+  }
   const unsigned long activityDuration = millis() - activityStartTime;
 
   const unsigned long loopDuration = millis() - loopStartTime;
@@ -414,20 +465,21 @@ void loop() {
     }
   }
 
-  // Add delay at the end of the loop to prevent tight spinning
+  // Sleep until the next input sample is due instead of spinning
   // When an activity requests skip loop delay (e.g., webserver running), use yield() for faster response
-  // Otherwise, use longer delay to save power
+  // Otherwise, block until the power button interrupt fires or the buttons or tilt sensor need sampling again
   if (activityManager.skipLoopDelay()) {
     powerManager.setPowerSaving(false);  // Make sure we're at full performance when skipLoopDelay is requested
     yield();                             // Give FreeRTOS a chance to run tasks, but return immediately
   } else {
-    if (millis() - lastActivityTime >= HalPowerManager::IDLE_POWER_SAVING_MS) {
-      // If we've been inactive for a while, increase the delay to save power
+    uint32_t timeoutMs = ACTIVE_INPUT_SAMPLE_MS;
+    if (!gpio.isAnyPressed() && millis() - lastActivityTime >= HalPowerManager::IDLE_POWER_SAVING_MS) {
+      // If we've been inactive for a while, sample less often to save power
       powerManager.setPowerSaving(true);  // Lower CPU frequency after extended inactivity
-      delay(50);
-    } else {
-      // Short delay to prevent tight loop while still being responsive
-      delay(10);
+      timeoutMs = IDLE_INPUT_SAMPLE_MS;
     }
+    timeoutMs =
+        std::min(timeoutMs, halTiltSensor.msUntilNextPoll(SETTINGS.tiltPageTurn, activityManager.isReaderActivity()));
+    gpio.waitForInput(timeoutMs);
   }
 }
@@ -1,16 +1,21 @@
 #include "CrossPointWebServer.h"
 
 #include <ArduinoJson.h>
+#include <DirectoryListingCache.h>
 #include <Epub.h>
 #include <FsHelpers.h>
 #include <HalStorage.h>
+#include <HeapTags.h>
 #include <Logging.h>
+#include <Trace.h>
 #include <WiFi.h>
 #include <esp_task_wdt.h>
 
 #include <algorithm>
 
+#include "CoverPregenQueue.h"
 #include "CrossPointSettings.h"
+#include "FileDownload.h"
 #include "OpdsServerStore.h"
 #include "SettingsList.h"
 #include "WebDAVHandler.h"
@@ -32,6 +37,7 @@ CrossPointWebServer* wsInstance = nullptr;
 
 // WebSocket upload state
 FsFile wsUploadFile;
+UploadWriter wsUploadWriter;
 String wsUploadFileName;
 String wsUploadPath;
 size_t wsUploadSize = 0;
@@ -138,6 +144,7 @@ void CrossPointWebServer::begin() {
   server->on("/js/jszip.min.js", HTTP_GET, [this] { handleJszip(); });
 
   server->on("/api/status", HTTP_GET, [this] { handleStatus(); });
+  server->on("/api/trace", HTTP_GET, [this] { handleTrace(); });
   server->on("/api/files", HTTP_GET, [this] { handleFileListData(); });
   server->on("/download", HTTP_GET, [this] { handleDownload(); });
 
@@ -169,9 +176,10 @@ void CrossPointWebServer::begin() {
   server->onNotFound([this] { handleNotFound(); });
   LOG_DBG("WEB", "[MEM] Free heap after route setup: %d bytes", ESP.getFreeHeap());
 
-  // Collect WebDAV headers and register handler
-  const char* davHeaders[] = {"Depth", "Destination", "Overwrite", "If", "Lock-Token", "Timeout"};
-  server->collectHeaders(davHeaders, 6);
+  // Collect WebDAV and range/conditional download headers and register handler
+  const char* collectedHeaders[] = {"Depth",         "Destination",       "Overwrite", "If", "Lock-Token", "Timeout",
+                                    "Range",         "If-None-Match",     "If-Range",  "If-Modified-Since"};
+  server->collectHeaders(collectedHeaders, sizeof(collectedHeaders) / sizeof(collectedHeaders[0]));
   server->addHandler(new WebDAVHandler());  // Note: WebDAVHandler will be deleted by WebServer when server is stopped
   LOG_DBG("WEB", "WebDAV handler initialized");
 
@@ -199,6 +207,7 @@ void CrossPointWebServer::begin() {
 }
 
 void CrossPointWebServer::abortWsUpload(const char* tag) {
+  wsUploadWriter.abort();
   // Explicit close() required: file-scope global persists beyond function scope
   wsUploadFile.close();
   String filePath = wsUploadPath;
@@ -225,6 +234,9 @@ void CrossPointWebServer::stop() {
 
   LOG_DBG("WEB", "[MEM] Free heap before stop: %d bytes", ESP.getFreeHeap());
 
+  // Listings parked by WebDAV are only kept up to date while the server runs
+  DirectoryListingCache::clear();
+
   // Close any in-progress WebSocket upload and remove partial file
   if (wsUploadInProgress && wsUploadFile) {
     abortWsUpload("WEB");
@@ -321,6 +333,8 @@ CrossPointWebServer::WsUploadStatus CrossPointWebServer::getWsUploadStatus() con
   status.lastCompleteName = wsLastCompleteName.c_str();
   status.lastCompleteSize = wsLastCompleteSize;
   status.lastCompleteAt = wsLastCompleteAt;
+  status.throughputMBps =
+      wsUploadInProgress ? wsUploadWriter.getThroughputMBps() : UploadWriter::getLastThroughputMBps();
   return status;
 }
 
@@ -356,13 +370,68 @@ void CrossPointWebServer::handleStatus() const {
   doc["mode"] = apMode ? "AP" : "STA";
   doc["rssi"] = apMode ? 0 : WiFi.RSSI();
   doc["freeHeap"] = ESP.getFreeHeap();
+  doc["largestFreeBlock"] = ESP.getMaxAllocHeap();
   doc["uptime"] = millis() / 1000;
 
+  // Per-subsystem heap accounting (see HeapTags.h)
+  JsonArray heap = doc["heap"].to<JsonArray>();
+  for (size_t i = 0; i < HeapTags::TAG_COUNT; i++) {
+    const auto tag = static_cast<HeapTags::Tag>(i);
+    const HeapTags::Usage usage = HeapTags::usage(tag);
+    JsonObject entry = heap.add<JsonObject>();
+    entry["tag"] = HeapTags::tagName(tag);
+    entry["current"] = usage.currentBytes;
+    entry["peak"] = usage.peakBytes;
+    entry["scopePeak"] = usage.scopePeakBytes;
+    entry["largestFreeAtPeak"] = usage.largestFreeAtPeak;
+    entry["failures"] = usage.failures;
+  }
+
+  // Sustained upload rate, live while an upload is running, otherwise from the last completed upload
+  JsonObject uploadStatus = doc["upload"].to<JsonObject>();
+  if (wsUploadInProgress) {
+    uploadStatus["inProgress"] = true;
+    uploadStatus["name"] = wsUploadFileName;
+    uploadStatus["received"] = wsUploadReceived;
+    uploadStatus["total"] = wsUploadSize;
+    uploadStatus["mbps"] = wsUploadWriter.getThroughputMBps();
+  } else if (upload.writer.isActive()) {
+    uploadStatus["inProgress"] = true;
+    uploadStatus["name"] = upload.fileName;
+    uploadStatus["received"] = upload.writer.getBytesReceived();
+    uploadStatus["mbps"] = upload.writer.getThroughputMBps();
+  } else {
+    uploadStatus["inProgress"] = false;
+    uploadStatus["mbps"] = UploadWriter::getLastThroughputMBps();
+  }
+
   String json;
   serializeJson(doc, json);
   server->send(200, "application/json", json);
 }
 
+void CrossPointWebServer::handleTrace() const {
+  std::vector<Trace::Event> events(Trace::CAPACITY);
+  const size_t count = Trace::snapshot(events.data(), events.size());
+
+  server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server->send(200, "text/plain", "");
+  // Batch lines so each chunk is a few hundred bytes rather than one per event
+  constexpr size_t LINES_PER_CHUNK = 16;
+  char chunk[LINES_PER_CHUNK * Trace::MAX_LINE];
+  size_t used = 0;
+  for (size_t i = 0; i < count; i++) {
+    used += Trace::formatEvent(events[i], chunk + used, sizeof(chunk) - used);
+    if (sizeof(chunk) - used < Trace::MAX_LINE || i + 1 == count) {
+      server->sendContent(chunk, used);
+      used = 0;
+    }
+  }
+  // End of streamed response, empty chunk to signal client
+  server->sendContent("");
+  LOG_DBG("WEB", "Served %zu trace events", count);
+}
+
 void CrossPointWebServer::scanFiles(const char* path, const std::function<void(FileInfo)>& callback) const {
   FsFile root = Storage.open(path);
   if (!root) {
@@ -531,57 +600,13 @@ void CrossPointWebServer::handleDownload() const {
     filename = nameBuf;
   }
 
-  server->setContentLength(file.size());
   server->sendHeader("Content-Disposition", "attachment; filename=\"" + filename + "\"");
-  server->send(200, contentType.c_str(), "");
-
-  NetworkClient client = server->client();
-  const size_t chunkSize = 4096;
-  uint8_t buffer[chunkSize];
-
-  bool downloadOk = true;
-  while (downloadOk && file.available()) {
-    int result = file.read(buffer, chunkSize);
-    if (result <= 0) break;
-    size_t bytesRead = static_cast<size_t>(result);
-    size_t totalWritten = 0;
-    while (totalWritten < bytesRead) {
-      esp_task_wdt_reset();
-      size_t wrote = client.write(buffer + totalWritten, bytesRead - totalWritten);
-      if (wrote == 0) {
-        downloadOk = false;
-        break;
-      }
-      totalWritten += wrote;
-    }
-  }
-  client.clear();
+  sendFileResponse(*server, file, contentType.c_str());
   file.close();
 }
 
 // Diagnostic counters for upload performance analysis
 static unsigned long uploadStartTime = 0;
-static unsigned long totalWriteTime = 0;
-static size_t writeCount = 0;
-
-static bool flushUploadBuffer(CrossPointWebServer::UploadState& state) {
-  if (state.bufferPos > 0 && state.file) {
-    esp_task_wdt_reset();  // Reset watchdog before potentially slow SD write
-    const unsigned long writeStart = millis();
-    const size_t written = state.file.write(state.buffer.data(), state.bufferPos);
-    totalWriteTime += millis() - writeStart;
-    writeCount++;
-    esp_task_wdt_reset();  // Reset watchdog after SD write
-
-    if (written != state.bufferPos) {
-      LOG_DBG("WEB", "[UPLOAD] Buffer flush failed: expected %d, wrote %d", state.bufferPos, written);
-      state.bufferPos = 0;
-      return false;
-    }
-    state.bufferPos = 0;
-  }
-  return true;
-}
 
 void CrossPointWebServer::handleUpload(UploadState& state) const {
   static size_t lastLoggedSize = 0;
@@ -607,9 +632,6 @@ void CrossPointWebServer::handleUpload(UploadState& state) const {
     state.error = "";
     uploadStartTime = millis();
     lastLoggedSize = 0;
-    state.bufferPos = 0;
-    totalWriteTime = 0;
-    writeCount = 0;
 
     // Get upload path from query parameter (defaults to root if not specified)
     // Note: We use query parameter instead of form data because multipart form
@@ -651,33 +673,23 @@ void CrossPointWebServer::handleUpload(UploadState& state) const {
       LOG_DBG("WEB", "[UPLOAD] FAILED to create file: %s", filePath.c_str());
       return;
     }
+    if (!state.writer.begin(state.file)) {
+      state.error = "Not enough memory for upload buffers";
+      state.file.close();
+      Storage.remove(filePath.c_str());
+      return;
+    }
     esp_task_wdt_reset();
 
     LOG_DBG("WEB", "[UPLOAD] File created successfully: %s", filePath.c_str());
   } else if (upload.status == UPLOAD_FILE_WRITE) {
     if (state.file && state.error.isEmpty()) {
-      // Buffer incoming data and flush when buffer is full
-      // This reduces SD card write operations and improves throughput
-      const uint8_t* data = upload.buf;
-      size_t remaining = upload.currentSize;
-
-      while (remaining > 0) {
-        const size_t space = UploadState::UPLOAD_BUFFER_SIZE - state.bufferPos;
-        const size_t toCopy = (remaining < space) ? remaining : space;
-
-        memcpy(state.buffer.data() + state.bufferPos, data, toCopy);
-        state.bufferPos += toCopy;
-        data += toCopy;
-        remaining -= toCopy;
-
-        // Flush buffer when full
-        if (state.bufferPos >= UploadState::UPLOAD_BUFFER_SIZE) {
-          if (!flushUploadBuffer(state)) {
-            state.error = "Failed to write to SD card - disk may be full";
-            state.file.close();
-            return;
-          }
-        }
+      // Hand data to the writer task; this blocks (backpressure) while both buffers are being written
+      if (!state.writer.write(upload.buf, upload.currentSize)) {
+        state.error = "Failed to write to SD card - disk may be full";
+        state.writer.abort();
+        state.file.close();
+        return;
       }
 
       state.size += upload.currentSize;
@@ -686,15 +698,14 @@ void CrossPointWebServer::handleUpload(UploadState& state) const {
       if (state.size - lastLoggedSize >= 102400) {
         const unsigned long elapsed = millis() - uploadStartTime;
         const float kbps = (elapsed > 0) ? (state.size / 1024.0) / (elapsed / 1000.0) : 0;
-        LOG_DBG("WEB", "[UPLOAD] %d bytes (%.1f KB), %.1f KB/s, %d writes", state.size, state.size / 1024.0, kbps,
-                writeCount);
+        LOG_DBG("WEB", "[UPLOAD] %d bytes (%.1f KB), %.1f KB/s", state.size, state.size / 1024.0, kbps);
         lastLoggedSize = state.size;
       }
     }
   } else if (upload.status == UPLOAD_FILE_END) {
     if (state.file) {
-      // Flush any remaining buffered data
-      if (!flushUploadBuffer(state)) {
+      // Write out any remaining buffered data
+      if (!state.writer.finish()) {
         state.error = "Failed to write final data to SD card";
       }
       state.file.close();
@@ -703,21 +714,20 @@ void CrossPointWebServer::handleUpload(UploadState& state) const {
         state.success = true;
         const unsigned long elapsed = millis() - uploadStartTime;
         const float avgKbps = (elapsed > 0) ? (state.size / 1024.0) / (elapsed / 1000.0) : 0;
-        const float writePercent = (elapsed > 0) ? (totalWriteTime * 100.0 / elapsed) : 0;
         LOG_DBG("WEB", "[UPLOAD] Complete: %s (%d bytes in %lu ms, avg %.1f KB/s)", state.fileName.c_str(), state.size,
                 elapsed, avgKbps);
-        LOG_DBG("WEB", "[UPLOAD] Diagnostics: %d writes, total write time: %lu ms (%.1f%%)", writeCount, totalWriteTime,
-                writePercent);
 
         // Clear epub cache to prevent stale metadata issues when overwriting files
         String filePath = state.path;
         if (!filePath.endsWith("/")) filePath += "/";
         filePath += state.fileName;
         clearEpubCacheIfNeeded(filePath);
+        COVER_PREGEN.enqueue(filePath.c_str());
+        DirectoryListingCache::invalidateParentOf(filePath.c_str());
       }
     }
   } else if (upload.status == UPLOAD_FILE_ABORTED) {
-    state.bufferPos = 0;  // Discard buffered data
+    state.writer.abort();  // Discard buffered data
     if (state.file) {
       state.file.close();
       // Try to delete the incomplete file
@@ -783,6 +793,7 @@ void CrossPointWebServer::handleCreateFolder() const {
   // Create the folder
   if (Storage.mkdir(folderPath.c_str())) {
     LOG_DBG("WEB", "Folder created successfully: %s", folderPath.c_str());
+    DirectoryListingCache::invalidateParentOf(folderPath.c_str());
     server->send(200, "text/plain", "Folder created: " + folderName);
   } else {
     LOG_DBG("WEB", "Failed to create folder: %s", folderPath.c_str());
@@ -865,6 +876,7 @@ void CrossPointWebServer::handleRename() const {
 
   if (success) {
     LOG_DBG("WEB", "Renamed file: %s -> %s", itemPath.c_str(), newPath.c_str());
+    DirectoryListingCache::invalidateParentOf(itemPath.c_str());
     server->send(200, "text/plain", "Renamed successfully");
   } else {
     LOG_ERR("WEB", "Failed to rename file: %s -> %s", itemPath.c_str(), newPath.c_str());
@@ -958,6 +970,8 @@ void CrossPointWebServer::handleMove() const {
 
   if (success) {
     LOG_DBG("WEB", "Moved file: %s -> %s", itemPath.c_str(), newPath.c_str());
+    DirectoryListingCache::invalidateParentOf(itemPath.c_str());
+    DirectoryListingCache::invalidateParentOf(newPath.c_str());
     server->send(200, "text/plain", "Moved successfully");
   } else {
     LOG_ERR("WEB", "Failed to move file: %s -> %s", itemPath.c_str(), newPath.c_str());
@@ -1078,6 +1092,8 @@ void CrossPointWebServer::handleDelete() const {
       failedItems += itemPath + " (deletion failed); ";
       allSuccess = false;
     }
+    DirectoryListingCache::invalidate(itemPath.c_str());
+    DirectoryListingCache::invalidateParentOf(itemPath.c_str());
   }
 
   if (allSuccess) {
@@ -1472,11 +1488,19 @@ void CrossPointWebServer::onWebSocketEvent(uint8_t num, WStype_t type, uint8_t*
             wsLastCompleteAt = millis();
             LOG_DBG("WS", "Zero-byte upload complete: %s", filePath.c_str());
             clearEpubCacheIfNeeded(filePath);
+            DirectoryListingCache::invalidateParentOf(filePath.c_str());
             wsServer->sendTXT(num, "DONE");
             wsLastProgressSent = 0;
             break;
           }
 
+          if (!wsUploadWriter.begin(wsUploadFile)) {
+            wsUploadFile.close();
+            Storage.remove(filePath.c_str());
+            wsServer->sendTXT(num, "ERROR:Not enough memory");
+            return;
+          }
+
           wsUploadClientNum = num;
           wsUploadInProgress = true;
           wsServer->sendTXT(num, "READY");
@@ -1493,7 +1517,7 @@ void CrossPointWebServer::onWebSocketEvent(uint8_t num, WStype_t type, uint8_t*
         return;
       }
 
-      // Write binary data directly to file
+      // Hand the frame to the writer task; this blocks (backpressure) while both buffers are being written
       size_t remaining = wsUploadSize - wsUploadReceived;
       if (length > remaining) {
         abortWsUpload("WS");
@@ -1501,16 +1525,14 @@ void CrossPointWebServer::onWebSocketEvent(uint8_t num, WStype_t type, uint8_t*
         return;
       }
       esp_task_wdt_reset();
-      size_t written = wsUploadFile.write(payload, length);
-      esp_task_wdt_reset();
-
-      if (written != length) {
+      if (!wsUploadWriter.write(payload, length)) {
         abortWsUpload("WS");
         wsServer->sendTXT(num, "ERROR:Write failed - disk full?");
         return;
       }
+      esp_task_wdt_reset();
 
-      wsUploadReceived += written;
+      wsUploadReceived += length;
 
       // Send progress update (every 64KB or at end)
       if (wsUploadReceived - wsLastProgressSent >= 65536 || wsUploadReceived >= wsUploadSize) {
@@ -1521,6 +1543,11 @@ void CrossPointWebServer::onWebSocketEvent(uint8_t num, WStype_t type, uint8_t*
 
       // Check if upload complete
       if (wsUploadReceived >= wsUploadSize) {
+        if (!wsUploadWriter.finish()) {
+          abortWsUpload("WS");
+          wsServer->sendTXT(num, "ERROR:Write failed - disk full?");
+          return;
+        }
         // Explicit close() required: file-scope global persists beyond function scope
         wsUploadFile.close();
         wsUploadInProgress = false;
@@ -1531,16 +1558,16 @@ void CrossPointWebServer::onWebSocketEvent(uint8_t num, WStype_t type, uint8_t*
         wsLastCompleteAt = millis();
 
         unsigned long elapsed = millis() - wsUploadStartTime;
-        float kbps = (elapsed > 0) ? (wsUploadSize / 1024.0) / (elapsed / 1000.0) : 0;
-
-        LOG_DBG("WS", "Upload complete: %s (%d bytes in %lu ms, %.1f KB/s)", wsUploadFileName.c_str(), wsUploadSize,
-                elapsed, kbps);
+        LOG_DBG("WS", "Upload complete: %s (%d bytes in %lu ms, %.2f MB/s)", wsUploadFileName.c_str(), wsUploadSize,
+                elapsed, UploadWriter::getLastThroughputMBps());
 
         // Clear epub cache to prevent stale metadata issues when overwriting files
         String filePath = wsUploadPath;
         if (!filePath.endsWith("/")) filePath += "/";
         filePath += wsUploadFileName;
         clearEpubCacheIfNeeded(filePath);
+        COVER_PREGEN.enqueue(filePath.c_str());
+        DirectoryListingCache::invalidateParentOf(filePath.c_str());
 
         wsServer->sendTXT(num, "DONE");
         wsLastProgressSent = 0;
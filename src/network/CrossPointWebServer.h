@@ -9,6 +9,8 @@
 #include <string>
 #include <vector>
 
+#include "UploadWriter.h"
+
 // Structure to hold file information
 struct FileInfo {
   String name;
@@ -27,6 +29,7 @@ class CrossPointWebServer {
     std::string lastCompleteName;
     size_t lastCompleteSize = 0;
     unsigned long lastCompleteAt = 0;
+    float throughputMBps = 0;  // Current upload rate, or the last completed upload's rate when idle
   };
 
   // Used by POST upload handler
@@ -38,14 +41,8 @@ class CrossPointWebServer {
     bool success = false;
     String error = "";
 
-    // Upload write buffer - batches small writes into larger SD card operations
-    // 4KB is a good balance: large enough to reduce syscall overhead, small enough
-    // to keep individual write times short and avoid watchdog issues
-    static constexpr size_t UPLOAD_BUFFER_SIZE = 4096;  // 4KB buffer
-    std::vector<uint8_t> buffer;
-    size_t bufferPos = 0;
-
-    UploadState() { buffer.resize(UPLOAD_BUFFER_SIZE); }
+    // Batches incoming data into sector-aligned buffers written to the SD card by a separate task
+    UploadWriter writer;
   } upload;
 
   CrossPointWebServer();
@@ -93,6 +90,7 @@ class CrossPointWebServer {
   void handleJszip() const;
   void handleNotFound() const;
   void handleStatus() const;
+  void handleTrace() const;
   void handleFileList() const;
   void handleFileListData() const;
   void handleDownload() const;
@@ -0,0 +1,55 @@
+#include "FileDownload.h"
+
+#include <Logging.h>
+#include <esp_task_wdt.h>
+#include <sdkconfig.h>
+
+#include "HttpConditional.h"
+
+namespace {
+// Reading one send window per chunk keeps the socket busy without holding more data than lwIP can queue
+#ifdef CONFIG_LWIP_TCP_SND_BUF_DEFAULT
+constexpr size_t TCP_SEND_WINDOW = CONFIG_LWIP_TCP_SND_BUF_DEFAULT;
+#else
+constexpr size_t TCP_SEND_WINDOW = 5744;
+#endif
+
+struct ServerRequest {
+  WebServer& server;
+  String header(const char* name) const { return server.header(name); }
+};
+
+struct ServerResponse {
+  WebServer& server;
+  NetworkClient client;
+
+  void sendHeader(const char* name, const char* value) { server.sendHeader(name, value); }
+  void send(const int status, const char* contentType, const size_t contentLength) {
+    server.setContentLength(contentLength);
+    server.send(status, contentType, "");
+    client = server.client();
+  }
+  size_t write(const uint8_t* data, const size_t length) {
+    esp_task_wdt_reset();
+    return client.write(data, length);
+  }
+  size_t sendWindow() const { return TCP_SEND_WINDOW; }
+};
+}  // namespace
+
+bool sendFileResponse(WebServer& server, FsFile& file, const char* contentType, const bool sendBody) {
+  HttpConditional::FileInfo info{static_cast<uint32_t>(file.size()), 0, 0};
+  if (!file.getModifyDateTime(&info.fatDate, &info.fatTime)) {
+    info.fatDate = 0;
+    info.fatTime = 0;
+  }
+
+  ServerRequest request{server};
+  ServerResponse response{server, {}};
+  const bool ok = HttpConditional::serveFile(request, response, file, info, contentType, sendBody);
+  if (!ok) {
+    LOG_DBG("WEB", "File response interrupted");
+  }
+  response.client.clear();
+  return ok;
+}
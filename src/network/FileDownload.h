@@ -0,0 +1,10 @@
+#pragma once
+
+#include <HalStorage.h>
+#include <WebServer.h>
+
+// Stream an open file to the current request of `server`, honouring Range, If-None-Match, If-Modified-Since and
+// If-Range (see HttpConditional). With sendBody false only the headers are sent, for HEAD requests.
+// Extra response headers (e.g. Content-Disposition) must be added with server.sendHeader() before calling.
+// The caller keeps ownership of `file`. The server must collect the Range and If-* request headers.
+bool sendFileResponse(WebServer& server, FsFile& file, const char* contentType, bool sendBody = true);
@@ -0,0 +1,228 @@
+#include "HttpConditional.h"
+
+#include <strings.h>
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace HttpConditional {
+
+namespace {
+constexpr const char* DAY_NAMES[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+constexpr const char* MONTH_NAMES[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                       "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+bool isEmpty(const char* value) { return value == nullptr || value[0] == '\0'; }
+
+const char* skipSpaces(const char* p) {
+  while (*p == ' ' || *p == '\t') p++;
+  return p;
+}
+
+// Sakamoto's algorithm, 0 = Sunday
+int dayOfWeek(int year, const int month, const int day) {
+  static constexpr int offsets[] = {0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4};
+  if (month < 3) year--;
+  return (year + year / 4 - year / 100 + year / 400 + offsets[month - 1] + day) % 7;
+}
+
+uint64_t dateKey(const int year, const int month, const int day, const int hour, const int minute, const int second) {
+  return ((((static_cast<uint64_t>(year) * 16 + month) * 32 + day) * 32 + hour) * 64 + minute) * 64 + second;
+}
+
+uint64_t fatDateKey(const uint16_t fatDate, const uint16_t fatTime) {
+  return dateKey(1980 + (fatDate >> 9), (fatDate >> 5) & 0x0F, fatDate & 0x1F, fatTime >> 11, (fatTime >> 5) & 0x3F,
+                 (fatTime & 0x1F) * 2);
+}
+
+// Compare one entity tag from a header list against ours. Weak comparison ignores a W/ prefix on either side.
+bool tagMatches(const char* tag, const size_t tagLength, const char* etag, const bool weakComparison) {
+  if (tagLength >= 2 && tag[0] == 'W' && tag[1] == '/') {
+    if (!weakComparison) return false;
+    tag += 2;
+    return tagMatches(tag, tagLength - 2, etag, weakComparison);
+  }
+  return tagLength == strlen(etag) && strncmp(tag, etag, tagLength) == 0;
+}
+
+// If-None-Match: "*" or a comma separated list of entity tags
+bool noneMatchHits(const char* header, const char* etag) {
+  const char* p = skipSpaces(header);
+  if (*p == '*') return true;
+
+  while (*p) {
+    p = skipSpaces(p);
+    const char* start = p;
+    while (*p && *p != ',') p++;
+    const char* end = p;
+    while (end > start && (end[-1] == ' ' || end[-1] == '\t')) end--;
+    if (end > start && tagMatches(start, end - start, etag, true)) {
+      return true;
+    }
+    if (*p == ',') p++;
+  }
+  return false;
+}
+
+bool parseNumber(const char*& p, uint64_t* out) {
+  if (!isdigit(static_cast<unsigned char>(*p))) return false;
+  char* end = nullptr;
+  *out = strtoull(p, &end, 10);
+  p = end;
+  return true;
+}
+
+enum class RangeResult { None, Satisfiable, Unsatisfiable };
+
+// Parse a single "bytes=" range. Malformed or multi-range headers yield None so the full file is sent.
+RangeResult parseRange(const char* header, const uint32_t size, uint32_t* outOffset, uint32_t* outLength) {
+  const char* p = skipSpaces(header);
+  if (strncasecmp(p, "bytes", 5) != 0) return RangeResult::None;
+  p = skipSpaces(p + 5);
+  if (*p != '=') return RangeResult::None;
+  p = skipSpaces(p + 1);
+  if (strchr(p, ',') != nullptr) return RangeResult::None;
+
+  uint64_t first = 0;
+  uint64_t last = 0;
+  bool hasFirst = false;
+  bool hasLast = false;
+  if (*p != '-') {
+    if (!parseNumber(p, &first)) return RangeResult::None;
+    hasFirst = true;
+  }
+  if (*p != '-') return RangeResult::None;
+  p++;
+  if (*p != '\0' && *p != ' ' && *p != '\t') {
+    if (!parseNumber(p, &last)) return RangeResult::None;
+    hasLast = true;
+  }
+  if (*skipSpaces(p) != '\0') return RangeResult::None;
+
+  if (!hasFirst) {
+    // Suffix range: the last N bytes
+    if (!hasLast) return RangeResult::None;
+    if (last == 0 || size == 0) return RangeResult::Unsatisfiable;
+    const uint32_t length = last < size ? static_cast<uint32_t>(last) : size;
+    *outOffset = size - length;
+    *outLength = length;
+    return RangeResult::Satisfiable;
+  }
+
+  if (hasLast && last < first) return RangeResult::None;
+  if (first >= size) return RangeResult::Unsatisfiable;
+  if (!hasLast || last >= size) last = size - 1;
+  *outOffset = static_cast<uint32_t>(first);
+  *outLength = static_cast<uint32_t>(last - first + 1);
+  return RangeResult::Satisfiable;
+}
+
+// If-Range holds either an entity tag (strong comparison) or a date that must match exactly
+bool ifRangeMatches(const char* header, const ResponsePlan& p) {
+  const char* value = skipSpaces(header);
+  size_t length = strlen(value);
+  while (length > 0 && (value[length - 1] == ' ' || value[length - 1] == '\t')) length--;
+  if (value[0] == '"' || value[0] == 'W') {
+    return tagMatches(value, length, p.etag, false);
+  }
+  return p.lastModified[0] != '\0' && length == strlen(p.lastModified) && strncmp(value, p.lastModified, length) == 0;
+}
+}  // namespace
+
+void formatEtag(const FileInfo& file, char* out, const size_t outSize) {
+  snprintf(out, outSize, "\"%lx-%04x%04x\"", static_cast<unsigned long>(file.size), file.fatDate, file.fatTime);
+}
+
+bool formatHttpDate(const uint16_t fatDate, const uint16_t fatTime, char* out, const size_t outSize) {
+  const int month = (fatDate >> 5) & 0x0F;
+  const int day = fatDate & 0x1F;
+  if (fatDate == 0 || month < 1 || month > 12 || day < 1) {
+    if (outSize > 0) out[0] = '\0';
+    return false;
+  }
+  const int year = 1980 + (fatDate >> 9);
+  snprintf(out, outSize, "%s, %02d %s %04d %02d:%02d:%02d GMT", DAY_NAMES[dayOfWeek(year, month, day)], day,
+           MONTH_NAMES[month - 1], year, fatTime >> 11, (fatTime >> 5) & 0x3F, (fatTime & 0x1F) * 2);
+  return true;
+}
+
+bool parseHttpDate(const char* value, uint64_t* outKey) {
+  if (isEmpty(value)) return false;
+
+  char monthName[4] = {};
+  int day = 0, year = 0, hour = 0, minute = 0, second = 0;
+  if (sscanf(value, "%*3s, %d %3s %d %d:%d:%d", &day, monthName, &year, &hour, &minute, &second) != 6) {
+    return false;
+  }
+  for (int month = 1; month <= 12; month++) {
+    if (strcmp(monthName, MONTH_NAMES[month - 1]) == 0) {
+      *outKey = dateKey(year, month, day, hour, minute, second);
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t chunkSizeForWindow(const size_t sendWindow) {
+  size_t chunk = sendWindow & ~static_cast<size_t>(511);
+  if (chunk < MIN_CHUNK_SIZE) chunk = MIN_CHUNK_SIZE;
+  if (chunk > MAX_CHUNK_SIZE) chunk = MAX_CHUNK_SIZE;
+  return chunk;
+}
+
+ResponsePlan plan(const RequestHeaders& request, const FileInfo& file) {
+  ResponsePlan p{};
+  p.status = 200;
+  p.offset = 0;
+  p.length = file.size;
+  formatEtag(file, p.etag, sizeof(p.etag));
+  formatHttpDate(file.fatDate, file.fatTime, p.lastModified, sizeof(p.lastModified));
+
+  // If-None-Match takes precedence; If-Modified-Since is only evaluated without it
+  if (!isEmpty(request.ifNoneMatch)) {
+    if (noneMatchHits(request.ifNoneMatch, p.etag)) {
+      p.status = 304;
+      p.length = 0;
+      return p;
+    }
+  } else if (!isEmpty(request.ifModifiedSince) && p.lastModified[0] != '\0') {
+    uint64_t since = 0;
+    if (parseHttpDate(request.ifModifiedSince, &since) && fatDateKey(file.fatDate, file.fatTime) <= since) {
+      p.status = 304;
+      p.length = 0;
+      return p;
+    }
+  }
+
+  if (isEmpty(request.range)) {
+    return p;
+  }
+  // A stale If-Range means the client's partial copy is outdated: send the whole file
+  if (!isEmpty(request.ifRange) && !ifRangeMatches(request.ifRange, p)) {
+    return p;
+  }
+
+  uint32_t offset = 0;
+  uint32_t length = 0;
+  switch (parseRange(request.range, file.size, &offset, &length)) {
+    case RangeResult::None:
+      break;
+    case RangeResult::Satisfiable:
+      p.status = 206;
+      p.offset = offset;
+      p.length = length;
+      snprintf(p.contentRange, sizeof(p.contentRange), "bytes %lu-%lu/%lu", static_cast<unsigned long>(offset),
+               static_cast<unsigned long>(offset + length - 1), static_cast<unsigned long>(file.size));
+      break;
+    case RangeResult::Unsatisfiable:
+      p.status = 416;
+      p.length = 0;
+      snprintf(p.contentRange, sizeof(p.contentRange), "bytes */%lu", static_cast<unsigned long>(file.size));
+      break;
+  }
+  return p;
+}
+
+}  // namespace HttpConditional
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+/**
+ * Byte ranges and conditional GET for file downloads (RFC 9110).
+ *
+ * Validators are derived from the file's size and FAT modify timestamp: the ETag is "<size>-<date><time>" in hex and
+ * Last-Modified is the FAT timestamp formatted as an HTTP date. FAT timestamps carry no time zone, so Last-Modified is
+ * only meaningful for comparing against values this device produced earlier, which is exactly what sync clients send
+ * back in If-Modified-Since.
+ *
+ * Only a single range is supported. Multi-range requests are answered with the full file (200), which RFC 9110
+ * permits. Everything here is free of Arduino dependencies so the logic can be exercised on the host.
+ */
+namespace HttpConditional {
+
+struct FileInfo {
+  uint32_t size;
+  uint16_t fatDate;  // 0 if unknown (e.g. the root directory)
+  uint16_t fatTime;
+};
+
+// Raw request header values, empty string or nullptr when absent
+struct RequestHeaders {
+  const char* range;
+  const char* ifNoneMatch;
+  const char* ifModifiedSince;
+  const char* ifRange;
+};
+
+struct ResponsePlan {
+  int status;       // 200, 206, 304 or 416
+  uint32_t offset;  // First byte to send
+  uint32_t length;  // Number of bytes to send
+  char etag[24];
+  char lastModified[32];  // Empty if the file has no timestamp
+  char contentRange[48];  // Empty unless status is 206 or 416
+};
+
+// Smallest and largest chunk read from the card per socket write
+constexpr size_t MIN_CHUNK_SIZE = 2048;
+constexpr size_t MAX_CHUNK_SIZE = 16 * 1024;
+
+ResponsePlan plan(const RequestHeaders& request, const FileInfo& file);
+
+// Chunk size matching the socket send window, in whole 512 byte sectors
+size_t chunkSizeForWindow(size_t sendWindow);
+
+void formatEtag(const FileInfo& file, char* out, size_t outSize);
+// RFC 1123 date ("Sun, 06 Nov 1994 08:49:37 GMT"). Returns false if the FAT date is unset.
+bool formatHttpDate(uint16_t fatDate, uint16_t fatTime, char* out, size_t outSize);
+// Parse an RFC 1123 date into a value that orders like the date. Returns false if malformed.
+bool parseHttpDate(const char* value, uint64_t* outKey);
+
+/**
+ * Answer a GET (or HEAD when sendBody is false) for an open file.
+ *
+ * Request must provide header(name) returning something with c_str(). Response must provide
+ * sendHeader(name, value), send(status, contentType, contentLength), write(data, length) returning bytes written
+ * (0 on failure) and sendWindow(). File must provide seek(offset) and read(buffer, length).
+ * Returns false if the body could not be sent in full.
+ */
+template <typename Request, typename Response, typename File>
+bool serveFile(Request& request, Response& response, File& file, const FileInfo& info, const char* contentType,
+               const bool sendBody = true) {
+  const auto range = request.header("Range");
+  const auto ifNoneMatch = request.header("If-None-Match");
+  const auto ifModifiedSince = request.header("If-Modified-Since");
+  const auto ifRange = request.header("If-Range");
+  const ResponsePlan p = plan({range.c_str(), ifNoneMatch.c_str(), ifModifiedSince.c_str(), ifRange.c_str()}, info);
+
+  response.sendHeader("Accept-Ranges", "bytes");
+  response.sendHeader("ETag", p.etag);
+  if (p.lastModified[0] != '\0') {
+    response.sendHeader("Last-Modified", p.lastModified);
+  }
+  if (p.contentRange[0] != '\0') {
+    response.sendHeader("Content-Range", p.contentRange);
+  }
+
+  if (p.status == 304 || p.status == 416) {
+    response.send(p.status, contentType, 0);
+    return true;
+  }
+
+  response.send(p.status, contentType, p.length);
+  if (!sendBody || p.length == 0) {
+    return true;
+  }
+
+  const size_t chunkSize = chunkSizeForWindow(response.sendWindow());
+  std::unique_ptr<uint8_t[]> buffer(new (std::nothrow) uint8_t[chunkSize]);
+  if (!buffer || !file.seek(p.offset)) {
+    return false;
+  }
+
+  uint32_t remaining = p.length;
+  while (remaining > 0) {
+    const size_t toRead = remaining < chunkSize ? remaining : chunkSize;
+    const int result = file.read(buffer.get(), toRead);
+    if (result <= 0) {
+      return false;
+    }
+    const size_t bytesRead = static_cast<size_t>(result);
+    size_t totalWritten = 0;
+    while (totalWritten < bytesRead) {
+      const size_t wrote = response.write(buffer.get() + totalWritten, bytesRead - totalWritten);
+      if (wrote == 0) {
+        return false;
+      }
+      totalWritten += wrote;
+    }
+    remaining -= bytesRead;
+  }
+  return true;
+}
+
+}  // namespace HttpConditional
@@ -0,0 +1,150 @@
+#include "PropfindWriter.h"
+
+#include <FsHelpers.h>
+#include <strings.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "HttpConditional.h"
+
+namespace {
+// Used when an entry has no FAT timestamp (e.g. the root directory)
+constexpr char FALLBACK_DATE[] = "Thu, 01 Jan 2024 00:00:00 GMT";
+
+struct MimeMapping {
+  const char* extension;
+  const char* mimeType;
+};
+
+// Types the device handles itself are matched by FsHelpers' predicates; these are only served to WebDAV clients
+constexpr MimeMapping OTHER_MIME_TYPES[] = {
+    {".pdf", "application/pdf"}, {".html", "text/html"},            {".htm", "text/html"},
+    {".css", "text/css"},        {".js", "application/javascript"}, {".json", "application/json"},
+    {".xml", "application/xml"}, {".svg", "image/svg+xml"},         {".zip", "application/zip"},
+    {".gz", "application/gzip"},
+};
+
+// Characters that must be percent-encoded in an href: reserved URL delimiters, XML markup and non-ASCII bytes
+bool needsEncoding(const unsigned char c) {
+  return c <= 0x20 || c >= 0x7F || c == '%' || c == '#' || c == '?' || c == '&' || c == '<' || c == '>' ||
+         c == '"' || c == '\'';
+}
+}  // namespace
+
+PropfindDepth parsePropfindDepth(const char* header) {
+  if (header == nullptr || header[0] == '\0') return PropfindDepth::One;
+  if (strcmp(header, "0") == 0) return PropfindDepth::Zero;
+  if (strcmp(header, "1") == 0) return PropfindDepth::One;
+  if (strcasecmp(header, "infinity") == 0) return PropfindDepth::Infinity;
+  return PropfindDepth::Invalid;
+}
+
+const char* webDavMimeType(const std::string_view fileName) {
+  if (FsHelpers::hasEpubExtension(fileName)) return "application/epub+zip";
+  if (FsHelpers::hasTxtExtension(fileName)) return "text/plain";
+  if (FsHelpers::hasMarkdownExtension(fileName)) return "text/markdown";
+  if (FsHelpers::hasJpgExtension(fileName)) return "image/jpeg";
+  if (FsHelpers::hasPngExtension(fileName)) return "image/png";
+  if (FsHelpers::hasGifExtension(fileName)) return "image/gif";
+  if (FsHelpers::hasBmpExtension(fileName)) return "image/bmp";
+  for (const auto& mapping : OTHER_MIME_TYPES) {
+    if (FsHelpers::checkFileExtension(fileName, mapping.extension)) {
+      return mapping.mimeType;
+    }
+  }
+  return "application/octet-stream";
+}
+
+void PropfindWriter::begin() {
+  append(
+      "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+      "<D:multistatus xmlns:D=\"DAV:\">\n");
+}
+
+void PropfindWriter::entry(const std::string_view collectionPath, const std::string_view name, const bool isDirectory,
+                           const uint32_t size, const uint16_t fatDate, const uint16_t fatTime) {
+  if (failed) return;
+
+  append("<D:response><D:href>");
+  appendEncodedPath(collectionPath);
+  bool endsWithSlash = !collectionPath.empty() && collectionPath.back() == '/';
+  if (!name.empty()) {
+    if (!endsWithSlash) appendChar('/');
+    appendEncodedPath(name);
+    endsWithSlash = false;
+  }
+  // Directory hrefs end with /
+  if (isDirectory && !endsWithSlash) appendChar('/');
+  append("</D:href><D:propstat><D:prop>");
+
+  if (isDirectory) {
+    append("<D:resourcetype><D:collection/></D:resourcetype>");
+  } else {
+    append("<D:resourcetype/><D:getcontentlength>");
+    appendNumber(size);
+    append("</D:getcontentlength><D:getcontenttype>");
+    append(webDavMimeType(name.empty() ? collectionPath : name));
+    append("</D:getcontenttype>");
+  }
+
+  char date[32];
+  append("<D:getlastmodified>");
+  append(HttpConditional::formatHttpDate(fatDate, fatTime, date, sizeof(date)) ? date : FALLBACK_DATE);
+  append("</D:getlastmodified></D:prop><D:status>HTTP/1.1 200 OK</D:status></D:propstat></D:response>\n");
+}
+
+bool PropfindWriter::end() {
+  append("</D:multistatus>\n");
+  flush();
+  return !failed;
+}
+
+void PropfindWriter::flush() {
+  if (used > 0 && !failed) {
+    failed = !sink(context, buffer, used);
+    totalBytes += used;
+  }
+  used = 0;
+}
+
+void PropfindWriter::append(std::string_view text) {
+  while (!text.empty()) {
+    if (used == BUFFER_SIZE) flush();
+    const size_t toCopy = std::min(text.size(), BUFFER_SIZE - used);
+    memcpy(buffer + used, text.data(), toCopy);
+    used += toCopy;
+    text.remove_prefix(toCopy);
+  }
+}
+
+void PropfindWriter::appendChar(const char c) {
+  if (used == BUFFER_SIZE) flush();
+  buffer[used++] = c;
+}
+
+void PropfindWriter::appendEncodedPath(const std::string_view path) {
+  static constexpr char HEX[] = "0123456789ABCDEF";
+  for (const char c : path) {
+    const auto byte = static_cast<unsigned char>(c);
+    if (needsEncoding(byte)) {
+      appendChar('%');
+      appendChar(HEX[byte >> 4]);
+      appendChar(HEX[byte & 0x0F]);
+    } else {
+      appendChar(c);
+    }
+  }
+}
+
+void PropfindWriter::appendNumber(uint32_t value) {
+  char digits[10];
+  size_t count = 0;
+  do {
+    digits[count++] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value > 0);
+  while (count > 0) {
+    appendChar(digits[--count]);
+  }
+}
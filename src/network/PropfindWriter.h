@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+enum class PropfindDepth { Zero, One, Infinity, Invalid };
+
+// Parse a WebDAV Depth header. A missing header is treated as 1 rather than infinity (RFC 4918 default) because
+// several clients omit it for simple folder listings and we never serve infinite depth.
+PropfindDepth parsePropfindDepth(const char* header);
+
+// MIME type reported for a file name, by extension
+const char* webDavMimeType(std::string_view fileName);
+
+/**
+ * Streams a PROPFIND multistatus body through a fixed-size buffer.
+ *
+ * Each entry is formatted straight into the buffer (URL encoding, size and date included) and the buffer is handed to
+ * the sink whenever it fills, so memory use is independent of the number of entries and no per-entry strings are
+ * allocated. Once the sink reports failure (e.g. the client disconnected) further output is dropped.
+ */
+class PropfindWriter {
+ public:
+  // Receives each filled buffer. Returns false to abort the response.
+  using Sink = bool (*)(void* context, const char* data, size_t length);
+
+  static constexpr size_t BUFFER_SIZE = 1536;
+
+  PropfindWriter(Sink sink, void* context) : sink(sink), context(context) {}
+
+  void begin();
+  // Add one <D:response>. `collectionPath` is the directory containing the entry; with an empty `name` the entry
+  // describes `collectionPath` itself. fatDate 0 means no timestamp is known.
+  void entry(std::string_view collectionPath, std::string_view name, bool isDirectory, uint32_t size,
+             uint16_t fatDate, uint16_t fatTime);
+  // Close the multistatus element and flush. Returns false if the sink failed at any point.
+  bool end();
+
+  bool ok() const { return !failed; }
+  size_t bytesWritten() const { return totalBytes; }
+
+ private:
+  Sink sink;
+  void* context;
+  char buffer[BUFFER_SIZE];
+  size_t used = 0;
+  size_t totalBytes = 0;
+  bool failed = false;
+
+  void flush();
+  void append(std::string_view text);
+  void appendChar(char c);
+  void appendEncodedPath(std::string_view path);
+  void appendNumber(uint32_t value);
+};
@@ -0,0 +1,217 @@
+#include "UploadWriter.h"
+
+#include <Logging.h>
+#include <esp_task_wdt.h>
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace {
+// Poll interval while waiting on the writer task, short enough to keep feeding the watchdog
+constexpr TickType_t WAIT_SLICE = pdMS_TO_TICKS(100);
+// Give up if the card has not accepted a buffer for this long
+constexpr unsigned long STALL_TIMEOUT_MS = 15000;
+}  // namespace
+
+float UploadWriter::lastThroughputMBps = 0;
+
+UploadWriter::~UploadWriter() {
+  if (task) {
+    abort();
+  } else {
+    release();
+  }
+}
+
+bool UploadWriter::begin(FsFile& targetFile) {
+  if (task) {
+    abort();
+  }
+
+  storage.reset(new (std::nothrow) uint8_t[BUFFER_COUNT * BUFFER_SIZE]);
+  filledQueue = xQueueCreate(BUFFER_COUNT + 1, sizeof(uint8_t));
+  freeQueue = xQueueCreate(BUFFER_COUNT, sizeof(uint8_t));
+  stoppedSemaphore = xSemaphoreCreateBinary();
+  if (!storage || !filledQueue || !freeQueue || !stoppedSemaphore) {
+    LOG_ERR("UPW", "Failed to allocate %zu byte upload buffers", BUFFER_COUNT * BUFFER_SIZE);
+    release();
+    return false;
+  }
+
+  for (uint8_t i = 0; i < BUFFER_COUNT; i++) {
+    xQueueSend(freeQueue, &i, 0);
+  }
+
+  file = &targetFile;
+  current = STOP_TOKEN;
+  currentPos = 0;
+  bytesReceived = 0;
+  failed = false;
+  discard = false;
+  totalWriteTime = 0;
+  writeCount = 0;
+  startTime = millis();
+  elapsedAtFinish = 0;
+
+  xTaskCreate(&taskTrampoline, "UploadWriter",
+              4096,  // Stack size
+              this,  // Parameters
+              1,     // Priority
+              &task  // Task handle
+  );
+  if (!task) {
+    LOG_ERR("UPW", "Failed to create writer task");
+    release();
+    return false;
+  }
+  return true;
+}
+
+bool UploadWriter::write(const uint8_t* data, size_t length) {
+  if (!task || failed) {
+    return false;
+  }
+
+  bytesReceived += length;
+  while (length > 0) {
+    if (current == STOP_TOKEN && !acquireBuffer()) {
+      return false;
+    }
+
+    const size_t toCopy = std::min(length, BUFFER_SIZE - currentPos);
+    memcpy(buffer(current) + currentPos, data, toCopy);
+    currentPos += toCopy;
+    data += toCopy;
+    length -= toCopy;
+
+    if (currentPos == BUFFER_SIZE && !submitCurrent()) {
+      return false;
+    }
+  }
+  return !failed;
+}
+
+bool UploadWriter::finish() {
+  if (!task) {
+    return !failed;
+  }
+
+  if (currentPos > 0) {
+    submitCurrent();
+  }
+  stopTask();
+  elapsedAtFinish = millis() - startTime;
+
+  if (!failed) {
+    lastThroughputMBps = getThroughputMBps();
+    LOG_DBG("UPW", "Wrote %zu bytes in %lu ms (%.2f MB/s), %zu SD writes took %lu ms", bytesReceived, elapsedAtFinish,
+            lastThroughputMBps, writeCount, totalWriteTime);
+  }
+
+  release();
+  return !failed;
+}
+
+void UploadWriter::abort() {
+  if (task) {
+    discard = true;
+    stopTask();
+    elapsedAtFinish = millis() - startTime;
+  }
+  release();
+}
+
+float UploadWriter::getThroughputMBps() const {
+  const unsigned long elapsed = task ? millis() - startTime : elapsedAtFinish;
+  if (elapsed == 0) {
+    return 0;
+  }
+  return (bytesReceived / (1024.0f * 1024.0f)) / (elapsed / 1000.0f);
+}
+
+bool UploadWriter::submitCurrent() {
+  lengths[current] = currentPos;
+  // filledQueue has room for every buffer plus the stop token, so this never blocks
+  xQueueSend(filledQueue, &current, portMAX_DELAY);
+  current = STOP_TOKEN;
+  currentPos = 0;
+  return !failed;
+}
+
+bool UploadWriter::acquireBuffer() {
+  const unsigned long waitStart = millis();
+  while (xQueueReceive(freeQueue, &current, WAIT_SLICE) != pdTRUE) {
+    // Both buffers are still being written: stall the caller so the sender backs off
+    esp_task_wdt_reset();
+    if (failed) {
+      return false;
+    }
+    if (millis() - waitStart > STALL_TIMEOUT_MS) {
+      LOG_ERR("UPW", "SD card stalled for %lu ms, aborting upload", millis() - waitStart);
+      failed = true;
+      current = STOP_TOKEN;
+      return false;
+    }
+  }
+  currentPos = 0;
+  return !failed;
+}
+
+void UploadWriter::stopTask() {
+  uint8_t token = STOP_TOKEN;
+  xQueueSend(filledQueue, &token, portMAX_DELAY);
+  while (xSemaphoreTake(stoppedSemaphore, WAIT_SLICE) != pdTRUE) {
+    esp_task_wdt_reset();
+  }
+  task = nullptr;
+}
+
+void UploadWriter::release() {
+  if (filledQueue) {
+    vQueueDelete(filledQueue);
+    filledQueue = nullptr;
+  }
+  if (freeQueue) {
+    vQueueDelete(freeQueue);
+    freeQueue = nullptr;
+  }
+  if (stoppedSemaphore) {
+    vSemaphoreDelete(stoppedSemaphore);
+    stoppedSemaphore = nullptr;
+  }
+  storage.reset();
+  file = nullptr;
+  current = STOP_TOKEN;
+  currentPos = 0;
+}
+
+void UploadWriter::taskTrampoline(void* param) {
+  auto* self = static_cast<UploadWriter*>(param);
+  self->taskLoop();
+}
+
+void UploadWriter::taskLoop() {
+  while (true) {
+    uint8_t index = STOP_TOKEN;
+    xQueueReceive(filledQueue, &index, portMAX_DELAY);
+    if (index == STOP_TOKEN) {
+      break;
+    }
+
+    if (!discard && !failed) {
+      const unsigned long writeStart = millis();
+      const size_t written = file->write(buffer(index), lengths[index]);
+      totalWriteTime = totalWriteTime + (millis() - writeStart);
+      writeCount = writeCount + 1;
+      if (written != lengths[index]) {
+        LOG_ERR("UPW", "SD write failed: expected %zu, wrote %zu", lengths[index], written);
+        failed = true;
+      }
+    }
+    xQueueSend(freeQueue, &index, 0);
+  }
+
+  xSemaphoreGive(stoppedSemaphore);
+  vTaskDelete(nullptr);
+}
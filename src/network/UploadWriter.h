@@ -0,0 +1,84 @@
+#pragma once
+
+#include <HalStorage.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Double-buffered SD writer for network uploads.
+ *
+ * The network side copies incoming data into one buffer while a separate task writes the previously filled buffer to
+ * the card, so the socket keeps draining while the card erases/programs. Buffers are a multiple of the 512 byte
+ * sector size and the file is written from offset 0, so every full buffer lands on sector boundaries and SdFat can
+ * write it straight to the card without going through its single-sector cache.
+ *
+ * When both buffers are in flight write() blocks until the writer task returns one. While blocked the caller stops
+ * reading from its socket, which closes the TCP window and throttles the sender (backpressure).
+ *
+ * Usage: begin(file) -> write()... -> finish() (or abort()). The caller still owns and closes the file.
+ */
+class UploadWriter {
+ public:
+  static constexpr size_t BUFFER_COUNT = 2;
+  static constexpr size_t BUFFER_SIZE = 16 * 1024;
+  static_assert(BUFFER_SIZE % 512 == 0, "Upload buffers must be whole SD sectors");
+
+  UploadWriter() = default;
+  ~UploadWriter();
+  UploadWriter(const UploadWriter&) = delete;
+  UploadWriter& operator=(const UploadWriter&) = delete;
+
+  // Allocate buffers and start the writer task. Returns false if out of memory.
+  bool begin(FsFile& file);
+  // Queue data for writing. Returns false once any SD write has failed.
+  bool write(const uint8_t* data, size_t length);
+  // Write out any buffered data and stop the writer task. Returns true if every write succeeded.
+  bool finish();
+  // Drop buffered data and stop the writer task
+  void abort();
+
+  bool isActive() const { return task != nullptr; }
+  bool hasFailed() const { return failed; }
+  size_t getBytesReceived() const { return bytesReceived; }
+  // Sustained end-to-end rate since begin(), in MB/s
+  float getThroughputMBps() const;
+  // Rate of the most recently finished upload from any writer, in MB/s (0 if none yet)
+  static float getLastThroughputMBps() { return lastThroughputMBps; }
+
+ private:
+  static constexpr uint8_t STOP_TOKEN = 0xFF;
+
+  FsFile* file = nullptr;
+  std::unique_ptr<uint8_t[]> storage;
+  size_t lengths[BUFFER_COUNT] = {};
+  QueueHandle_t filledQueue = nullptr;
+  QueueHandle_t freeQueue = nullptr;
+  SemaphoreHandle_t stoppedSemaphore = nullptr;
+  TaskHandle_t task = nullptr;
+
+  uint8_t current = STOP_TOKEN;
+  size_t currentPos = 0;
+  size_t bytesReceived = 0;
+  unsigned long startTime = 0;
+  unsigned long elapsedAtFinish = 0;
+  volatile bool failed = false;
+  volatile bool discard = false;
+  volatile unsigned long totalWriteTime = 0;
+  volatile size_t writeCount = 0;
+
+  static float lastThroughputMBps;
+
+  uint8_t* buffer(uint8_t index) const { return storage.get() + index * BUFFER_SIZE; }
+  bool submitCurrent();
+  bool acquireBuffer();
+  void stopTask();
+  void release();
+
+  static void taskTrampoline(void* param);
+  void taskLoop();
+};
@@ -1,19 +1,51 @@
 #include "WebDAVHandler.h"
 
+#include <DirectoryListingCache.h>
 #include <Epub.h>
 #include <FsHelpers.h>
 #include <HalStorage.h>
 #include <Logging.h>
 #include <esp_task_wdt.h>
 
+#include "CoverPregenQueue.h"
+#include "FileDownload.h"
+#include "PropfindWriter.h"
+
 namespace {
 const char* HIDDEN_ITEMS[] = {"System Volume Information", "XTCache"};
 constexpr size_t HIDDEN_ITEMS_COUNT = sizeof(HIDDEN_ITEMS) / sizeof(HIDDEN_ITEMS[0]);
 
-// RFC 1123 date format helper: "Sun, 06 Nov 1994 08:49:37 GMT"
-// ESP32 doesn't have real-time clock set by default, so we use a fixed epoch date
-// as a fallback. The date is not critical for WebDAV Class 1 operations.
-const char* FIXED_DATE = "Thu, 01 Jan 2024 00:00:00 GMT";
+bool isVisibleEntry(const char* name, bool isDirectory) {
+  (void)isDirectory;
+  if (name[0] == '.') return false;
+  for (size_t i = 0; i < HIDDEN_ITEMS_COUNT; i++) {
+    if (strcmp(name, HIDDEN_ITEMS[i]) == 0) return false;
+  }
+  return true;
+}
+
+bool sendPropfindChunk(void* context, const char* data, size_t length) {
+  auto* server = static_cast<WebServer*>(context);
+  server->sendContent(data, length);
+  return server->client().connected();
+}
+
+struct PropfindListing {
+  PropfindWriter& writer;
+  const char* collectionPath;
+  size_t count;
+};
+
+bool visitPropfindEntry(void* context, const char* name, size_t nameLength, bool isDirectory, uint32_t size,
+                        uint16_t modifyDate, uint16_t modifyTime) {
+  auto* listing = static_cast<PropfindListing*>(context);
+  listing->writer.entry(listing->collectionPath, {name, nameLength}, isDirectory, size, modifyDate, modifyTime);
+  if (++listing->count % 32 == 0) {
+    yield();
+    esp_task_wdt_reset();
+  }
+  return listing->writer.ok();
+}
 }  // namespace
 
 // ── RequestHandler interface ─────────────────────────────────────────────────
@@ -80,18 +112,25 @@ void WebDAVHandler::raw(WebServer& server, const String& uri, HTTPRaw& raw) {
     String tempPath = _putPath + ".davtmp";
     Storage.remove(tempPath.c_str());
     _putOk = Storage.openFileForWrite("DAV", tempPath, _putFile);
+    if (_putOk && !_putWriter.begin(_putFile)) {
+      _putFile.close();
+      Storage.remove(tempPath.c_str());
+      _putOk = false;
+    }
     LOG_DBG("DAV", "PUT START: %s", _putPath.c_str());
 
   } else if (raw.status == RAW_WRITE) {
     if (_putFile && _putOk) {
       esp_task_wdt_reset();
-      size_t written = _putFile.write(raw.buf, raw.currentSize);
-      if (written != raw.currentSize) {
+      // Blocks (backpressure) while both writer buffers are being written to the card
+      if (!_putWriter.write(raw.buf, raw.currentSize)) {
+        _putWriter.abort();
         _putOk = false;
       }
     }
 
   } else if (raw.status == RAW_END) {
+    if (!_putWriter.finish()) _putOk = false;
     if (_putFile) _putFile.close();
     if (_putOk) {
       String tempPath = _putPath + ".davtmp";
@@ -108,6 +147,7 @@ void WebDAVHandler::raw(WebServer& server, const String& uri, HTTPRaw& raw) {
     LOG_DBG("DAV", "PUT END: %u bytes, ok=%d", raw.totalSize, _putOk);
 
   } else if (raw.status == RAW_ABORTED) {
+    _putWriter.abort();
     if (_putFile) _putFile.close();
     String tempPath = _putPath + ".davtmp";
     Storage.remove(tempPath.c_str());
@@ -117,6 +157,19 @@ void WebDAVHandler::raw(WebServer& server, const String& uri, HTTPRaw& raw) {
 
 bool WebDAVHandler::handle(WebServer& server, HTTPMethod method, const String& uri) {
   (void)uri;
+  switch (method) {
+    case HTTP_PUT:
+    case HTTP_DELETE:
+    case HTTP_MKCOL:
+    case HTTP_MOVE:
+    case HTTP_COPY:
+      // FAT does not reliably update directory timestamps, so drop cached PROPFIND listings explicitly
+      invalidateListings(server);
+      break;
+    default:
+      break;
+  }
+
   switch (method) {
     case HTTP_OPTIONS:
       handleOptions(server);
@@ -156,6 +209,19 @@ bool WebDAVHandler::handle(WebServer& server, HTTPMethod method, const String& u
   }
 }
 
+void WebDAVHandler::invalidateListings(WebServer& s) const {
+  const String path = getRequestPath(s);
+  DirectoryListingCache::invalidate(path.c_str());
+  DirectoryListingCache::invalidateParentOf(path.c_str());
+  if (s.hasHeader("Destination")) {
+    const String destination = getDestinationPath(s);
+    if (!destination.isEmpty()) {
+      DirectoryListingCache::invalidate(destination.c_str());
+      DirectoryListingCache::invalidateParentOf(destination.c_str());
+    }
+  }
+}
+
 // ── OPTIONS ──────────────────────────────────────────────────────────────────
 
 void WebDAVHandler::handleOptions(WebServer& s) {
@@ -172,9 +238,21 @@ void WebDAVHandler::handleOptions(WebServer& s) {
 
 void WebDAVHandler::handlePropfind(WebServer& s) {
   String path = getRequestPath(s);
-  int depth = getDepth(s);
+  const PropfindDepth depth = parsePropfindDepth(s.header("Depth").c_str());
 
-  LOG_DBG("DAV", "PROPFIND %s depth=%d", path.c_str(), depth);
+  LOG_DBG("DAV", "PROPFIND %s depth=%s", path.c_str(), s.header("Depth").c_str());
+
+  if (depth == PropfindDepth::Invalid) {
+    s.send(400, "text/plain", "Invalid Depth header");
+    return;
+  }
+  if (depth == PropfindDepth::Infinity) {
+    // RFC 4918 9.1: servers may refuse infinite depth
+    s.send(403, "application/xml; charset=\"utf-8\"",
+           "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+           "<D:error xmlns:D=\"DAV:\"><D:propfind-finite-depth/></D:error>\n");
+    return;
+  }
 
   // Check if path exists
   if (!Storage.exists(path.c_str()) && path != "/") {
@@ -182,119 +260,44 @@ void WebDAVHandler::handlePropfind(WebServer& s) {
     return;
   }
 
+  bool isDir = true;
+  uint32_t size = 0;
+  uint16_t modifyDate = 0;
+  uint16_t modifyTime = 0;
   FsFile root = Storage.open(path.c_str());
-  if (!root) {
-    if (path == "/") {
-      // Root should always work — send minimal response
-      s.setContentLength(CONTENT_LENGTH_UNKNOWN);
-      s.send(207, "application/xml; charset=\"utf-8\"", "");
-      s.sendContent(
-          "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
-          "<D:multistatus xmlns:D=\"DAV:\">\n");
-      sendPropEntry(s, "/", true, 0, FIXED_DATE);
-      s.sendContent("</D:multistatus>\n");
-      s.sendContent("");
-      return;
+  if (root) {
+    isDir = root.isDirectory();
+    size = isDir ? 0 : static_cast<uint32_t>(root.size());
+    if (!root.getModifyDateTime(&modifyDate, &modifyTime)) {
+      modifyDate = 0;
+      modifyTime = 0;
     }
+    root.close();
+  } else if (path != "/") {
     s.send(500, "text/plain", "Failed to open");
     return;
   }
-
-  bool isDir = root.isDirectory();
+  // Root should always work, even if it cannot be opened
 
   s.setContentLength(CONTENT_LENGTH_UNKNOWN);
   s.send(207, "application/xml; charset=\"utf-8\"", "");
-  s.sendContent(
-      "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
-      "<D:multistatus xmlns:D=\"DAV:\">\n");
 
+  PropfindWriter writer(&sendPropfindChunk, &s);
+  writer.begin();
   // Entry for the resource itself
-  if (isDir) {
-    sendPropEntry(s, path, true, 0, FIXED_DATE);
-  } else {
-    sendPropEntry(s, path, false, root.size(), FIXED_DATE);
-    root.close();
-    s.sendContent("</D:multistatus>\n");
-    s.sendContent("");
-    return;
-  }
-
-  // If depth > 0 and it's a directory, list children
-  if (depth > 0) {
-    FsFile file = root.openNextFile();
-    char name[500];
-    while (file) {
-      file.getName(name, sizeof(name));
-      String fileName(name);
-
-      // Skip hidden/protected items
-      bool shouldHide = fileName.startsWith(".");
-      if (!shouldHide) {
-        for (size_t i = 0; i < HIDDEN_ITEMS_COUNT; i++) {
-          if (fileName.equals(HIDDEN_ITEMS[i])) {
-            shouldHide = true;
-            break;
-          }
-        }
-      }
-
-      if (!shouldHide) {
-        String childPath = path;
-        if (!childPath.endsWith("/")) childPath += "/";
-        childPath += fileName;
+  writer.entry(path.c_str(), {}, isDir, size, modifyDate, modifyTime);
 
-        if (file.isDirectory()) {
-          sendPropEntry(s, childPath, true, 0, FIXED_DATE);
-        } else {
-          sendPropEntry(s, childPath, false, file.size(), FIXED_DATE);
-        }
-      }
-
-      file.close();
-      yield();
-      esp_task_wdt_reset();
-      file = root.openNextFile();
-    }
+  // Depth 1 on a collection: immediate children only, streamed from the directory listing metadata
+  if (isDir && depth == PropfindDepth::One) {
+    PropfindListing listing{writer, path.c_str(), 0};
+    DirectoryListingCache::forEach(path.c_str(), &isVisibleEntry, &visitPropfindEntry, &listing);
+    LOG_DBG("DAV", "PROPFIND listed %zu entries", listing.count);
   }
 
-  root.close();
-  s.sendContent("</D:multistatus>\n");
+  writer.end();
   s.sendContent("");
 }
 
-void WebDAVHandler::sendPropEntry(WebServer& s, const String& path, bool isDir, size_t size,
-                                  const String& lastModified) const {
-  String href;
-  urlEncodePath(path, href);
-  // Ensure directory hrefs end with /
-  if (isDir && !href.endsWith("/")) href += "/";
-
-  String xml = "<D:response><D:href>";
-  xml += href;
-  xml += "</D:href><D:propstat><D:prop>";
-
-  if (isDir) {
-    xml += "<D:resourcetype><D:collection/></D:resourcetype>";
-  } else {
-    xml += "<D:resourcetype/>";
-    xml += "<D:getcontentlength>";
-    xml += String(size);
-    xml += "</D:getcontentlength>";
-    String mime = getMimeType(path);
-    xml += "<D:getcontenttype>";
-    xml += mime;
-    xml += "</D:getcontenttype>";
-  }
-
-  xml += "<D:getlastmodified>";
-  xml += lastModified;
-  xml += "</D:getlastmodified>";
-
-  xml += "</D:prop><D:status>HTTP/1.1 200 OK</D:status></D:propstat></D:response>\n";
-
-  s.sendContent(xml);
-}
-
 // ── GET ──────────────────────────────────────────────────────────────────────
 
 void WebDAVHandler::handleGet(WebServer& s) {
@@ -324,11 +327,7 @@ void WebDAVHandler::handleGet(WebServer& s) {
   }
 
   String contentType = getMimeType(path);
-  s.setContentLength(file.size());
-  s.send(200, contentType.c_str(), "");
-
-  NetworkClient client = s.client();
-  client.write(file);
+  sendFileResponse(s, file, contentType.c_str());
   file.close();
 }
 
@@ -361,8 +360,7 @@ void WebDAVHandler::handleHead(WebServer& s) {
   }
 
   String contentType = getMimeType(path);
-  s.setContentLength(file.size());
-  s.send(200, contentType.c_str(), "");
+  sendFileResponse(s, file, contentType.c_str(), false);
   file.close();
 }
 
@@ -386,6 +384,7 @@ void WebDAVHandler::handlePut(WebServer& s) {
   }
 
   clearEpubCacheIfNeeded(path);
+  COVER_PREGEN.enqueue(path.c_str());
   s.send(_putExisted ? 204 : 201);
   LOG_DBG("DAV", "PUT complete: %s", path.c_str());
 }
@@ -731,33 +730,6 @@ String WebDAVHandler::getDestinationPath(WebServer& s) const {
   return result;
 }
 
-void WebDAVHandler::urlEncodePath(const String& path, String& out) const {
-  out = "";
-  for (unsigned int i = 0; i < path.length(); i++) {
-    char c = path.charAt(i);
-    if (c == '/') {
-      out += '/';
-    } else if (c == ' ') {
-      out += "%20";
-    } else if (c == '%') {
-      out += "%25";
-    } else if (c == '#') {
-      out += "%23";
-    } else if (c == '?') {
-      out += "%3F";
-    } else if (c == '&') {
-      out += "%26";
-    } else if ((uint8_t)c > 127) {
-      // Encode non-ASCII bytes
-      char hex[4];
-      snprintf(hex, sizeof(hex), "%%%02X", (uint8_t)c);
-      out += hex;
-    } else {
-      out += c;
-    }
-  }
-}
-
 bool WebDAVHandler::isProtectedPath(const String& path) const {
   // Check every segment of the path, not just the last one.
   // This prevents access to e.g. /.hidden/somefile or /System Volume Information/foo
@@ -784,14 +756,6 @@ bool WebDAVHandler::isProtectedPath(const String& path) const {
   return false;
 }
 
-int WebDAVHandler::getDepth(WebServer& s) const {
-  String depth = s.header("Depth");
-  if (depth == "0") return 0;
-  if (depth == "1") return 1;
-  // "infinity" or missing → treat as 1 (Class 1 servers don't need to support infinity)
-  return 1;
-}
-
 bool WebDAVHandler::getOverwrite(WebServer& s) const {
   String ow = s.header("Overwrite");
   if (ow == "F" || ow == "f") return false;
@@ -806,19 +770,5 @@ void WebDAVHandler::clearEpubCacheIfNeeded(const String& path) const {
 }
 
 String WebDAVHandler::getMimeType(const String& path) const {
-  if (FsHelpers::hasEpubExtension(path)) return "application/epub+zip";
-  if (FsHelpers::checkFileExtension(path, ".pdf")) return "application/pdf";
-  if (FsHelpers::hasTxtExtension(path)) return "text/plain";
-  if (FsHelpers::checkFileExtension(path, ".html") || FsHelpers::checkFileExtension(path, ".htm")) return "text/html";
-  if (FsHelpers::checkFileExtension(path, ".css")) return "text/css";
-  if (FsHelpers::checkFileExtension(path, ".js")) return "application/javascript";
-  if (FsHelpers::checkFileExtension(path, ".json")) return "application/json";
-  if (FsHelpers::checkFileExtension(path, ".xml")) return "application/xml";
-  if (FsHelpers::hasJpgExtension(path)) return "image/jpeg";
-  if (FsHelpers::hasPngExtension(path)) return "image/png";
-  if (FsHelpers::hasGifExtension(path)) return "image/gif";
-  if (FsHelpers::checkFileExtension(path, ".svg")) return "image/svg+xml";
-  if (FsHelpers::checkFileExtension(path, ".zip")) return "application/zip";
-  if (FsHelpers::checkFileExtension(path, ".gz")) return "application/gzip";
-  return "application/octet-stream";
+  return webDavMimeType(std::string_view{path.c_str(), path.length()});
 }
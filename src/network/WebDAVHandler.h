@@ -3,6 +3,8 @@
 #include <HalStorage.h>
 #include <WebServer.h>
 
+#include "UploadWriter.h"
+
 class WebDAVHandler : public RequestHandler {
  public:
   // RequestHandler interface
@@ -14,6 +16,7 @@ class WebDAVHandler : public RequestHandler {
  private:
   // PUT streaming state (raw() is called in chunks)
   FsFile _putFile;
+  UploadWriter _putWriter;
   String _putPath;
   bool _putOk = false;
   bool _putExisted = false;
@@ -34,11 +37,9 @@ class WebDAVHandler : public RequestHandler {
   // Utilities
   String getRequestPath(WebServer& s) const;
   String getDestinationPath(WebServer& s) const;
-  void urlEncodePath(const String& path, String& out) const;
   bool isProtectedPath(const String& path) const;
-  int getDepth(WebServer& s) const;
   bool getOverwrite(WebServer& s) const;
   void clearEpubCacheIfNeeded(const String& path) const;
-  void sendPropEntry(WebServer& s, const String& href, bool isDir, size_t size, const String& lastModified) const;
+  void invalidateListings(WebServer& s) const;
   String getMimeType(const String& path) const;
 };
@@ -0,0 +1,213 @@
+#include "FontPackStore.h"
+
+#include <Arduino.h>
+#include <EpdFontFamily.h>
+#include <EpdFontPack.h>
+#include <FsHelpers.h>
+#include <GfxRenderer.h>
+#include <HalStorage.h>
+#include <HeapTags.h>
+#include <Logging.h>
+#include <strings.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "PackPartition.h"
+
+namespace {
+
+constexpr char FONT_DIR[] = "/fonts";
+constexpr uint8_t DIRECTORY_MAGIC[4] = {'E', 'F', 'P', 'S'};
+constexpr size_t MAX_PACKS = 16;
+constexpr size_t NAME_LENGTH = 32;
+constexpr size_t COPY_CHUNK = 4096;  // One flash sector
+
+struct DirectoryEntry {
+  char name[NAME_LENGTH];
+  uint32_t offset;  // From the start of the partition, sector aligned
+  uint32_t size;
+  uint16_t modifyDate;
+  uint16_t modifyTime;
+};
+
+// Lists the packs stored behind it in the partition's first sector. Written last, so an interrupted copy is never
+// mapped; zero-initialised, so two directories of the same packs compare equal byte for byte.
+struct Directory {
+  uint8_t magic[4];
+  uint32_t count;
+  DirectoryEntry entries[MAX_PACKS];
+
+  size_t usedSize() const { return count > 0 ? entries[count - 1].offset + entries[count - 1].size : 0; }
+};
+static_assert(sizeof(Directory) <= COPY_CHUNK, "The directory must fit its sector");
+
+// A registered family: EpdFontFamily and EpdFont only point at their data, so it all stays in one place
+struct PackFamily {
+  PackFamily(const char* fileName, const EpdFontPack::Family& parsed)
+      : pack(parsed),
+        fonts{EpdFont(&pack.styles[EpdFontFamily::REGULAR]), EpdFont(&pack.styles[EpdFontFamily::BOLD]),
+              EpdFont(&pack.styles[EpdFontFamily::ITALIC]), EpdFont(&pack.styles[EpdFontFamily::BOLD_ITALIC])} {
+    strncpy(name, fileName, sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+  }
+
+  const EpdFont* font(const EpdFontFamily::Style style) const { return pack.hasStyle(style) ? &fonts[style] : nullptr; }
+  EpdFontFamily family() const {
+    return EpdFontFamily(font(EpdFontFamily::REGULAR), font(EpdFontFamily::BOLD), font(EpdFontFamily::ITALIC),
+                         font(EpdFontFamily::BOLD_ITALIC));
+  }
+
+  // The file name without .epf is what the font settings look the pack up by
+  bool named(const char* stem) const {
+    const size_t length = strlen(stem);
+    return strncasecmp(name, stem, length) == 0 && strcasecmp(name + length, ".epf") == 0;
+  }
+
+  char name[NAME_LENGTH];
+  EpdFontPack::Family pack;
+  EpdFont fonts[4];
+};
+
+std::vector<std::unique_ptr<PackFamily>> families;
+
+size_t alignToSector(const size_t value, const size_t sector) { return (value + sector - 1) / sector * sector; }
+
+// Directory of the packs on the card, sorted by name and laid out one after another behind the directory sector
+bool scanCard(const esp_partition_t* partition, Directory& directory) {
+  auto dir = Storage.open(FONT_DIR);
+  if (!dir || !dir.isDirectory()) {
+    return false;
+  }
+
+  char name[64];
+  for (auto file = dir.openNextFile(); file && directory.count < MAX_PACKS; file = dir.openNextFile()) {
+    file.getName(name, sizeof(name));
+    if (file.isDirectory() || name[0] == '.' || !FsHelpers::checkFileExtension(std::string_view{name}, ".epf")) {
+      continue;
+    }
+    if (strlen(name) >= NAME_LENGTH) {
+      LOG_ERR("FPK", "Skipping %s: font pack names are limited to %u characters", name,
+              static_cast<unsigned>(NAME_LENGTH - 1));
+      continue;
+    }
+    DirectoryEntry& entry = directory.entries[directory.count++];
+    strncpy(entry.name, name, sizeof(entry.name));
+    entry.size = file.fileSize();
+    file.getModifyDateTime(&entry.modifyDate, &entry.modifyTime);
+  }
+  std::sort(directory.entries, directory.entries + directory.count,
+            [](const DirectoryEntry& a, const DirectoryEntry& b) { return strcmp(a.name, b.name) < 0; });
+
+  const size_t regionSize = PackPartition::fontRegionSize(partition);
+  size_t offset = partition->erase_size;
+  for (uint32_t i = 0; i < directory.count; i++) {
+    DirectoryEntry& entry = directory.entries[i];
+    if (offset + entry.size > regionSize) {
+      LOG_ERR("FPK", "Font packs from %s on do not fit the %u byte font region", entry.name,
+              static_cast<unsigned>(regionSize));
+      memset(&entry, 0, sizeof(DirectoryEntry) * (directory.count - i));
+      directory.count = i;
+      break;
+    }
+    entry.offset = offset;
+    offset = alignToSector(offset + entry.size, partition->erase_size);
+  }
+  if (directory.count > 0) {
+    memcpy(directory.magic, DIRECTORY_MAGIC, sizeof(DIRECTORY_MAGIC));
+  }
+  return directory.count > 0;
+}
+
+bool copyToPartition(const esp_partition_t* partition, const Directory& directory) {
+  const size_t eraseSize = alignToSector(directory.usedSize(), partition->erase_size);
+  if (esp_partition_erase_range(partition, 0, eraseSize) != ESP_OK) {
+    LOG_ERR("FPK", "Could not erase %u bytes of the font region", static_cast<unsigned>(eraseSize));
+    return false;
+  }
+
+  auto* buffer = static_cast<uint8_t*>(HeapTags::alloc(HeapTags::Tag::FontPack, COPY_CHUNK));
+  if (!buffer) {
+    LOG_ERR("FPK", "No memory to copy font packs");
+    return false;
+  }
+  bool ok = true;
+  char path[NAME_LENGTH + sizeof(FONT_DIR) + 1];
+  for (uint32_t i = 0; ok && i < directory.count; i++) {
+    const DirectoryEntry& entry = directory.entries[i];
+    snprintf(path, sizeof(path), "%s/%s", FONT_DIR, entry.name);
+    HalFile file;
+    ok = Storage.openFileForRead("FPK", path, file);
+    for (size_t offset = 0; ok && offset < entry.size; offset += COPY_CHUNK) {
+      const size_t chunk = std::min(COPY_CHUNK, entry.size - offset);
+      ok = file.read(buffer, chunk) == static_cast<int>(chunk) &&
+           esp_partition_write(partition, entry.offset + offset, buffer, chunk) == ESP_OK;
+    }
+  }
+  HeapTags::release(buffer);
+
+  if (!ok || esp_partition_write(partition, 0, &directory, sizeof(directory)) != ESP_OK) {
+    LOG_ERR("FPK", "Copying font packs to flash failed");
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+void FontPackStore::registerFonts(GfxRenderer& renderer) {
+  const esp_partition_t* partition = PackPartition::get();
+  if (!partition || PackPartition::fontRegionSize(partition) <= partition->erase_size) {
+    LOG_ERR("FPK", "No data partition for font packs");
+    return;
+  }
+
+  Directory wanted = {};
+  if (!scanCard(partition, wanted)) {
+    LOG_DBG("FPK", "No font packs in %s", FONT_DIR);
+    return;
+  }
+
+  Directory stored;
+  if (esp_partition_read(partition, 0, &stored, sizeof(stored)) != ESP_OK ||
+      memcmp(&stored, &wanted, sizeof(wanted)) != 0) {
+    const unsigned long start = millis();
+    if (!copyToPartition(partition, wanted)) {
+      return;
+    }
+    LOG_INF("FPK", "Copied %u font packs to flash in %lu ms", static_cast<unsigned>(wanted.count), millis() - start);
+  }
+
+  // The fonts are used until the device sleeps, so the mapping is never released
+  const void* region = nullptr;
+  esp_partition_mmap_handle_t mapping;
+  if (esp_partition_mmap(partition, 0, wanted.usedSize(), ESP_PARTITION_MMAP_DATA, &region, &mapping) != ESP_OK) {
+    LOG_ERR("FPK", "Could not map the font region");
+    return;
+  }
+
+  for (uint32_t i = 0; i < wanted.count; i++) {
+    const DirectoryEntry& entry = wanted.entries[i];
+    EpdFontPack::Family parsed;
+    if (!EpdFontPack::parse(static_cast<const uint8_t*>(region) + entry.offset, entry.size, parsed)) {
+      LOG_ERR("FPK", "%s is not a valid font pack", entry.name);
+      continue;
+    }
+    families.push_back(std::make_unique<PackFamily>(entry.name, parsed));
+    renderer.insertFont(parsed.fontId, families.back()->family());
+    LOG_DBG("FPK", "Registered font pack %s as font %d", entry.name, parsed.fontId);
+  }
+}
+
+bool FontPackStore::findFont(const char* name, int& fontId) {
+  for (const auto& family : families) {
+    if (family->named(name)) {
+      fontId = family->pack.fontId;
+      return true;
+    }
+  }
+  return false;
+}
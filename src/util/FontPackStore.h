@@ -0,0 +1,25 @@
+#pragma once
+
+class GfxRenderer;
+
+/**
+ * Registers the font packs on the SD card (/fonts/<name>.epf, see EpdFontPack.h) as reader fonts.
+ *
+ * At boot the packs are copied into the font region of the pack partition (see PackPartition.h) and the region is
+ * mapped into the address space, so glyph tables and bitmaps are read in place, as fast as from a built-in font. The
+ * copy only happens when the set of packs changed (names, sizes or modification times); otherwise the packs are just
+ * mapped again. A pack built from the built-in headers carries that font's ID, so it replaces the built-in font or
+ * stands in for one left out of the firmware with OMIT_FONTS.
+ *
+ * The font family and size settings pick a pack by file name: a pack named after a reader font (notosans_16.epf, as
+ * build-font-packs.sh names them) is read in its place, under the ID the pack carries. A pack of any other font can
+ * be named that way too; its own ID keeps the cached layouts of the two fonts apart.
+ */
+class FontPackStore {
+ public:
+  // Call before the built-in fonts are inserted, so a pack takes precedence over the built-in font with its ID.
+  static void registerFonts(GfxRenderer& renderer);
+
+  // Font ID of the registered pack /fonts/<name>.epf (compared case-insensitively); false when there is none.
+  static bool findFont(const char* name, int& fontId);
+};
@@ -0,0 +1,153 @@
+#include "HyphenationPackStore.h"
+
+#include <Arduino.h>
+#include <HalStorage.h>
+#include <HeapTags.h>
+#include <Logging.h>
+#include <esp_partition.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "PackPartition.h"
+
+namespace {
+
+constexpr char PACK_DIR[] = "/hyphenation";
+constexpr uint8_t STORE_MAGIC[4] = {'H', 'Y', 'P', 'S'};
+constexpr size_t COPY_CHUNK = 4096;  // One flash sector
+
+// Describes the pack stored behind it in the partition. Written last, so an interrupted copy is never mapped.
+struct StoreHeader {
+  uint8_t magic[4];
+  char tag[4];
+  uint32_t packSize;
+  uint16_t modifyDate;
+  uint16_t modifyTime;
+};
+static_assert(sizeof(StoreHeader) == 16, "The pack image must stay 4-byte aligned");
+
+esp_partition_mmap_handle_t mapping;
+bool mapped = false;
+
+void unmap() {
+  if (mapped) {
+    esp_partition_munmap(mapping);
+    mapped = false;
+  }
+}
+
+// Every pack starts on an erase sector, so storing one erases only the sectors it takes
+size_t slotSize(const size_t packSize, const size_t sectorSize) {
+  return (sizeof(StoreHeader) + packSize + sectorSize - 1) / sectorSize * sectorSize;
+}
+
+// Walk the packs stored one after another from the start of the region. Returns true with the offset of the pack
+// `wanted` describes, or false with the offset right after the last stored pack.
+bool findStored(const esp_partition_t* partition, const size_t region, const StoreHeader& wanted, size_t& offset) {
+  offset = 0;
+  while (offset + sizeof(StoreHeader) <= PackPartition::HYPHENATION_REGION_SIZE) {
+    StoreHeader stored;
+    if (esp_partition_read(partition, region + offset, &stored, sizeof(stored)) != ESP_OK ||
+        memcmp(stored.magic, STORE_MAGIC, sizeof(STORE_MAGIC)) != 0 || stored.packSize == 0 ||
+        offset + sizeof(StoreHeader) + stored.packSize > PackPartition::HYPHENATION_REGION_SIZE) {
+      return false;
+    }
+    if (memcmp(&stored, &wanted, sizeof(wanted)) == 0) {
+      return true;
+    }
+    offset += slotSize(stored.packSize, partition->erase_size);
+  }
+  return false;
+}
+
+bool copyToPartition(const esp_partition_t* partition, const size_t region, const size_t offset, HalFile& file,
+                     const StoreHeader& header) {
+  // Erase one sector more, if the region has it, so a walk over the stored packs stops behind this one
+  const size_t slot = region + offset;
+  const size_t eraseSize = std::min(slotSize(header.packSize, partition->erase_size) + partition->erase_size,
+                                    PackPartition::HYPHENATION_REGION_SIZE - offset);
+  if (esp_partition_erase_range(partition, slot, eraseSize) != ESP_OK) {
+    LOG_ERR("HYP", "Could not erase %u bytes of the pattern partition", static_cast<unsigned>(eraseSize));
+    return false;
+  }
+
+  auto* buffer = static_cast<uint8_t*>(HeapTags::alloc(HeapTags::Tag::HyphenationPack, COPY_CHUNK));
+  if (!buffer) {
+    LOG_ERR("HYP", "No memory to copy hyphenation patterns");
+    return false;
+  }
+  bool ok = file.seekSet(0);
+  for (size_t copied = 0; ok && copied < header.packSize; copied += COPY_CHUNK) {
+    const size_t chunk = std::min(COPY_CHUNK, header.packSize - copied);
+    ok = file.read(buffer, chunk) == static_cast<int>(chunk) &&
+         esp_partition_write(partition, slot + sizeof(StoreHeader) + copied, buffer, chunk) == ESP_OK;
+  }
+  HeapTags::release(buffer);
+
+  if (!ok || esp_partition_write(partition, slot, &header, sizeof(header)) != ESP_OK) {
+    LOG_ERR("HYP", "Copying hyphenation patterns to flash failed");
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+const uint8_t* HyphenationPackStore::load(const char* primaryTag, size_t& size) {
+  unmap();
+
+  const esp_partition_t* partition = PackPartition::get();
+  if (!partition || partition->size < PackPartition::HYPHENATION_REGION_SIZE) {
+    LOG_ERR("HYP", "No data partition for hyphenation patterns");
+    return nullptr;
+  }
+
+  char path[40];
+  snprintf(path, sizeof(path), "%s/hyph-%s.pack", PACK_DIR, primaryTag);
+  if (!Storage.exists(path)) {
+    LOG_INF("HYP", "No hyphenation patterns for '%s' (%s missing)", primaryTag, path);
+    return nullptr;
+  }
+  HalFile file;
+  if (!Storage.openFileForRead("HYP", path, file)) {
+    return nullptr;
+  }
+
+  StoreHeader wanted = {};
+  memcpy(wanted.magic, STORE_MAGIC, sizeof(STORE_MAGIC));
+  strncpy(wanted.tag, primaryTag, sizeof(wanted.tag));
+  wanted.packSize = file.fileSize();
+  file.getModifyDateTime(&wanted.modifyDate, &wanted.modifyTime);
+  if (wanted.packSize == 0 || sizeof(StoreHeader) + wanted.packSize > PackPartition::HYPHENATION_REGION_SIZE) {
+    LOG_ERR("HYP", "%s does not fit the %u byte pattern region", path,
+            static_cast<unsigned>(PackPartition::HYPHENATION_REGION_SIZE));
+    return nullptr;
+  }
+
+  const size_t region = PackPartition::fontRegionSize(partition);
+  size_t offset = 0;
+  if (!findStored(partition, region, wanted, offset)) {
+    // Behind the packs already stored, or from the start again once the region is full
+    if (offset + slotSize(wanted.packSize, partition->erase_size) > PackPartition::HYPHENATION_REGION_SIZE) {
+      offset = 0;
+    }
+    const unsigned long start = millis();
+    if (!copyToPartition(partition, region, offset, file, wanted)) {
+      return nullptr;
+    }
+    LOG_INF("HYP", "Copied %s to flash in %lu ms", path, millis() - start);
+  }
+  file.close();
+
+  const void* image = nullptr;
+  if (esp_partition_mmap(partition, region + offset, sizeof(StoreHeader) + wanted.packSize, ESP_PARTITION_MMAP_DATA,
+                         &image, &mapping) != ESP_OK) {
+    LOG_ERR("HYP", "Could not map the pattern partition");
+    return nullptr;
+  }
+  mapped = true;
+  size = wanted.packSize;
+  return static_cast<const uint8_t*>(image) + sizeof(StoreHeader);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Keeps the hyphenation pattern pack of the language being read memory-mapped from flash.
+ *
+ * Packs live on the SD card as /hyphenation/hyph-<tag>.pack. The first time a language is needed, its pack is copied
+ * into the hyphenation region of the pack partition (see PackPartition.h) and mapped into the address space, so
+ * patterns are read as fast as the built-in English trie. Copied packs stay in the region one after another, so
+ * switching between languages already stored (same size and modification time) only maps them again; only when a new
+ * pack no longer fits behind them is the region reused from the start. The German pack alone takes most of it, while
+ * several of the smaller ones fit side by side.
+ */
+class HyphenationPackStore {
+ public:
+  // HyphenationPackLoader for LanguageRegistry. Unmaps the previously loaded pack.
+  static const uint8_t* load(const char* primaryTag, size_t& size);
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <esp_partition.h>
+
+#include <cstddef>
+
+/**
+ * The data partition the firmware does not otherwise use ("spiffs" in partitions.csv) holds packs copied from the SD
+ * card so they can be memory-mapped: font packs (FontPackStore) from the start, the hyphenation packs of recently read
+ * languages (HyphenationPackStore) in a fixed region at the end.
+ */
+namespace PackPartition {
+
+constexpr size_t HYPHENATION_REGION_SIZE = 256 * 1024;
+
+inline const esp_partition_t* get() {
+  static const esp_partition_t* partition =
+      esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, nullptr);
+  return partition;
+}
+
+// Font packs use everything in front of the hyphenation region
+inline size_t fontRegionSize(const esp_partition_t* partition) {
+  return partition->size > HYPHENATION_REGION_SIZE ? partition->size - HYPHENATION_REGION_SIZE : 0;
+}
+
+}  // namespace PackPartition
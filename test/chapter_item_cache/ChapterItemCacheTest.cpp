@@ -0,0 +1,440 @@
+#include <GfxRenderer.h>
+#include <Serialization.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "lib/Epub/Epub/Page.h"
+#include "lib/Epub/Epub/parsers/ChapterPageBuilder.h"
+
+// ImageBlock.cpp decodes and draws images; pages only need to hold and serialize them here
+ImageBlock::ImageBlock(const std::string& imagePath, int16_t width, int16_t height)
+    : imagePath(imagePath), width(width), height(height) {}
+void ImageBlock::render(GfxRenderer&, const int, const int) {}
+bool ImageBlock::serialize(FsFile& file) {
+  serialization::writeString(file, imagePath);
+  serialization::writePod(file, width);
+  serialization::writePod(file, height);
+  return true;
+}
+std::unique_ptr<ImageBlock> ImageBlock::deserialize(FsFile&) { return nullptr; }
+
+static int testsPassed = 0;
+static int testsFailed = 0;
+
+#define ASSERT_EQ(a, b)                                                         \
+  do {                                                                          \
+    if ((a) != (b)) {                                                           \
+      fprintf(stderr, "  FAIL: %s:%d: %s != %s\n", __FILE__, __LINE__, #a, #b); \
+      testsFailed++;                                                            \
+      return;                                                                   \
+    }                                                                           \
+  } while (0)
+
+#define ASSERT_TRUE(cond)                                                \
+  do {                                                                   \
+    if (!(cond)) {                                                       \
+      fprintf(stderr, "  FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testsFailed++;                                                     \
+      return;                                                            \
+    }                                                                    \
+  } while (0)
+
+#define PASS() testsPassed++
+
+using Item = ChapterPageBuilder::Item;
+
+namespace {
+// Layout settings: font id (the em size of the stub renderer), line compression, extra paragraph spacing, viewport
+struct Settings {
+  int fontId;
+  float lineCompression;
+  bool extraParagraphSpacing;
+  uint16_t viewportWidth;
+  uint16_t viewportHeight;
+  bool hyphenationEnabled;
+};
+
+constexpr Settings RECORDED{18, 1.0f, true, 464, 760, true};
+constexpr Settings LARGER_FONT{24, 0.95f, false, 464, 760, true};
+
+// The in-memory FsFile appends on write and reads from the start, so a copy reads back what was written
+std::string contents(FsFile file) {
+  std::string data(static_cast<size_t>(file.available()), '\0');
+  file.read(data.data(), data.size());
+  return data;
+}
+
+std::string serialized(const Item& item) {
+  FsFile file;
+  item.serialize(file);
+  return contents(file);
+}
+
+FootnoteEntry footnote(const char* number, const char* href) {
+  FootnoteEntry entry;
+  strncpy(entry.number, number, sizeof(entry.number) - 1);
+  strncpy(entry.href, href, sizeof(entry.href) - 1);
+  return entry;
+}
+
+// ============================================================================
+// A sample chapter, streamed the way ChapterHtmlSlimParser streams one: a single item refilled for every paragraph
+// part, anchor and image, paragraphs over 750 words handed over in parts, and an End item last
+// ============================================================================
+
+// Soft hyphens mark the breaks of the one word that has them
+const char* const VOCABULARY[] = {
+    "the",   "quick", "brown",   "fox",     "jumps",         "over",        "lazy",
+    "dog",   "and",   "then",    "rests",   "beneath",       "ancient",     "oak",
+    "trees", "while", "café",    "naïve",   "extraordinary", "hyphen-ated", "un\xC2\xAD" "break\xC2\xAD" "able",
+    "on",    "paper", "reading", "a",       "of",            "to",          "characteristically",
+    "in",    "it",    "is",      "was",     "she",           "he",          "they",
+};
+constexpr size_t VOCABULARY_SIZE = sizeof(VOCABULARY) / sizeof(VOCABULARY[0]);
+constexpr int PARAGRAPH_COUNT = 60;
+constexpr size_t MAX_WORDS_PER_PART = 750;
+
+CssBlockStyle paragraphStyle(const int paragraph) {
+  CssBlockStyle style;
+  if (paragraph % 4 == 1) {
+    style.boxes.push_back({CssLength(1.0f, CssUnit::Em), CssLength(0.5f, CssUnit::Em),
+                           CssLength(5.0f, CssUnit::Percent), CssLength(), CssLength(4.0f), CssLength(),
+                           CssLength(0.5f, CssUnit::Rem), CssLength()});
+  }
+  if (paragraph % 6 == 5) {
+    style.boxes.push_back({CssLength(), CssLength(12.0f, CssUnit::Points), CssLength(2.0f, CssUnit::Em), CssLength(),
+                           CssLength(), CssLength(), CssLength(), CssLength(8.0f)});
+  }
+  style.alignment = static_cast<CssTextAlign>(paragraph % 4);
+  style.textAlignDefined = paragraph % 2 == 0;
+  if (paragraph % 3 != 0) {
+    style.textIndent = CssLength(1.5f, CssUnit::Em);
+    style.textIndentDefined = true;
+  }
+  return style;
+}
+
+void streamSampleChapter(const std::function<void(Item&)>& submit) {
+  std::mt19937 random(49);
+  Item item;
+  ParsedText block(false);
+  uint16_t paragraphIndex = 0;
+
+  for (int paragraph = 0; paragraph < PARAGRAPH_COUNT; paragraph++) {
+    paragraphIndex++;
+    if (paragraph % 5 == 0) {
+      item.kind = Item::Kind::Anchor;
+      item.paragraphIndex = paragraphIndex;
+      item.name = "section-" + std::to_string(paragraph);
+      submit(item);
+    }
+
+    if (paragraph % 12 == 7) {
+      item.kind = Item::Kind::Image;
+      item.paragraphIndex = paragraphIndex;
+      item.name = "/.crosspoint/epub_1/img_" + std::to_string(paragraph) + ".bmp";
+      item.source = "OEBPS/images/figure" + std::to_string(paragraph) + ".png";
+      item.imageWidth = static_cast<int16_t>(200 + paragraph * 13);
+      item.imageHeight = static_cast<int16_t>(150 + paragraph * 17);
+      item.hasCssWidth = paragraph % 3 == 1;
+      item.hasCssHeight = paragraph % 2 == 1;
+      item.cssWidth = CssLength(80.0f, CssUnit::Percent);
+      item.cssHeight = CssLength(12.0f, CssUnit::Em);
+      submit(item);
+      continue;
+    }
+
+    // Mostly short paragraphs, a few long enough to come in parts
+    const size_t wordCount = paragraph % 17 == 3 ? 1900 : 8 + random() % 140;
+    const CssBlockStyle style = paragraphStyle(paragraph);
+    std::vector<std::pair<int, FootnoteEntry>> footnotes;
+    for (size_t word = 0; word < wordCount; word++) {
+      const auto fontStyle = static_cast<EpdFontFamily::Style>(random() % 8 == 0 ? random() % 5 : 0);
+      block.addWord(VOCABULARY[random() % VOCABULARY_SIZE], fontStyle, random() % 29 == 0, random() % 23 == 0);
+      if (random() % 97 == 0) {
+        const std::string number = std::to_string(footnotes.size() + 1);
+        const std::string href = "notes.xhtml#n" + number;
+        footnotes.emplace_back(static_cast<int>(word + 1), footnote(number.c_str(), href.c_str()));
+      }
+
+      const bool last = word + 1 == wordCount;
+      if (last || block.size() > MAX_WORDS_PER_PART) {
+        item.kind = Item::Kind::Paragraph;
+        item.paragraphIndex = paragraphIndex;
+        item.style = style;
+        item.text.takeWords(block);
+        item.endsParagraph = last;
+        item.footnotes.swap(footnotes);
+        footnotes.clear();
+        submit(item);
+      }
+    }
+  }
+
+  item.kind = Item::Kind::End;
+  item.paragraphIndex = paragraphIndex;
+  submit(item);
+}
+
+// ============================================================================
+// Laying out: pages as Section stores them, and the anchors
+// ============================================================================
+
+struct Layout {
+  std::vector<std::string> pages;  // Serialized page followed by the paragraph index it is tagged with
+  std::vector<std::pair<std::string, uint16_t>> anchors;
+};
+
+ChapterPageBuilder makeBuilder(const GfxRenderer& renderer, const Settings& settings, Layout& layout) {
+  return ChapterPageBuilder(renderer, settings.fontId, settings.lineCompression, settings.extraParagraphSpacing,
+                            settings.viewportWidth, settings.viewportHeight, settings.hyphenationEnabled,
+                            [&layout](std::unique_ptr<Page> page, const uint16_t paragraphIndex) {
+                              FsFile file;
+                              if (page) page->serialize(file);
+                              serialization::writePod(file, paragraphIndex);
+                              layout.pages.push_back(contents(file));
+                            });
+}
+
+// The parser's stream goes straight into the builder, recorded to `itemCache` first if given, as parseChapter does
+Layout layOutLive(const Settings& settings, FsFile* itemCache) {
+  const GfxRenderer renderer;
+  Layout layout;
+  ChapterPageBuilder builder = makeBuilder(renderer, settings, layout);
+  streamSampleChapter([&](Item& item) {
+    if (itemCache) item.serialize(*itemCache);
+    builder.process(item);
+  });
+  layout.anchors = builder.getAnchors();
+  return layout;
+}
+
+// Replay a recorded stream the way Section::layOutItems does; false if it ends before its End item or is corrupt
+bool layOutRecorded(FsFile itemCache, const Settings& settings, Layout& layout) {
+  const GfxRenderer renderer;
+  ChapterPageBuilder builder = makeBuilder(renderer, settings, layout);
+  Item item;
+  do {
+    if (itemCache.available() <= 0 || !item.deserialize(itemCache)) {
+      return false;
+    }
+    builder.process(item);
+  } while (item.kind != Item::Kind::End);
+  layout.anchors = builder.getAnchors();
+  return true;
+}
+}  // namespace
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+// A paragraph part comes back with its words, block style and footnotes, and serializes to the same bytes again
+void testParagraphRoundTrip() {
+  printf("testParagraphRoundTrip...\n");
+  Item item;
+  item.kind = Item::Kind::Paragraph;
+  item.paragraphIndex = 412;
+  item.endsParagraph = false;
+  item.style = paragraphStyle(5);
+  item.style.alignment = CssTextAlign::Center;
+  item.text.addWord("Call", EpdFontFamily::BOLD);
+  item.text.addWord("me", EpdFontFamily::ITALIC, true);
+  item.text.addWord("Ish\xC2\xAD"
+                    "mael",
+                    EpdFontFamily::REGULAR);
+  item.text.addWord(".", EpdFontFamily::REGULAR, false, true);
+  item.footnotes.emplace_back(2, footnote("1", "notes.xhtml#n1"));
+  item.footnotes.emplace_back(4, footnote("[12]", "notes.xhtml#note-twelve"));
+  const std::string bytes = serialized(item);
+
+  // Into an item that still holds an image, as the reused item on replay does
+  Item read;
+  read.kind = Item::Kind::Image;
+  read.name = "/img.bmp";
+  FsFile file(bytes);
+  ASSERT_TRUE(read.deserialize(file));
+  ASSERT_EQ(file.available(), 0);
+  ASSERT_TRUE(read.kind == Item::Kind::Paragraph);
+  ASSERT_EQ(read.paragraphIndex, 412);
+  ASSERT_TRUE(!read.endsParagraph);
+  ASSERT_EQ(read.text.size(), 4u);
+  ASSERT_EQ(read.style.boxes.size(), 2u);
+  ASSERT_TRUE(read.style.boxes[0].marginLeft.unit == CssUnit::Percent);
+  ASSERT_TRUE(read.style.alignment == CssTextAlign::Center);
+  ASSERT_TRUE(read.style.textIndentDefined);
+  ASSERT_EQ(read.footnotes.size(), 2u);
+  ASSERT_EQ(read.footnotes[1].first, 4);
+  ASSERT_EQ(std::string(read.footnotes[1].second.number), "[12]");
+  ASSERT_EQ(std::string(read.footnotes[1].second.href), "notes.xhtml#note-twelve");
+  ASSERT_EQ(serialized(read), bytes);
+  PASS();
+}
+
+// An image keeps its cached path, source and both CSS sizes
+void testImageRoundTrip() {
+  printf("testImageRoundTrip...\n");
+  Item item;
+  item.kind = Item::Kind::Image;
+  item.paragraphIndex = 9;
+  item.name = "/.crosspoint/epub_1/img_9.bmp";
+  item.source = "OEBPS/images/cover.jpg";
+  item.imageWidth = 1072;
+  item.imageHeight = 1448;
+  item.hasCssWidth = true;
+  item.hasCssHeight = false;
+  item.cssWidth = CssLength(75.0f, CssUnit::Percent);
+  item.cssHeight = CssLength(3.0f, CssUnit::Em);
+  const std::string bytes = serialized(item);
+
+  Item read;
+  FsFile file(bytes);
+  ASSERT_TRUE(read.deserialize(file));
+  ASSERT_EQ(file.available(), 0);
+  ASSERT_TRUE(read.kind == Item::Kind::Image);
+  ASSERT_EQ(read.paragraphIndex, 9);
+  ASSERT_EQ(read.name, item.name);
+  ASSERT_EQ(read.source, item.source);
+  ASSERT_EQ(read.imageWidth, 1072);
+  ASSERT_EQ(read.imageHeight, 1448);
+  ASSERT_TRUE(read.hasCssWidth && !read.hasCssHeight);
+  ASSERT_EQ(read.cssWidth.value, 75.0f);
+  ASSERT_TRUE(read.cssWidth.unit == CssUnit::Percent);
+  ASSERT_TRUE(read.cssHeight.unit == CssUnit::Em);
+  ASSERT_EQ(serialized(read), bytes);
+  PASS();
+}
+
+// Anchors keep their id; End, which completes the last page, only its paragraph index
+void testAnchorAndEndRoundTrip() {
+  printf("testAnchorAndEndRoundTrip...\n");
+  Item anchor;
+  anchor.kind = Item::Kind::Anchor;
+  anchor.paragraphIndex = 77;
+  anchor.name = "chapter-3-section-2";
+  Item end;
+  end.kind = Item::Kind::End;
+  end.paragraphIndex = 78;
+
+  FsFile file(serialized(anchor) + serialized(end));
+  Item read;
+  ASSERT_TRUE(read.deserialize(file));
+  ASSERT_TRUE(read.kind == Item::Kind::Anchor);
+  ASSERT_EQ(read.paragraphIndex, 77);
+  ASSERT_EQ(read.name, "chapter-3-section-2");
+  ASSERT_TRUE(read.deserialize(file));
+  ASSERT_TRUE(read.kind == Item::Kind::End);
+  ASSERT_EQ(read.paragraphIndex, 78);
+  ASSERT_EQ(file.available(), 0);
+  PASS();
+}
+
+// Laying the chapter out from its recorded items gives the pages and anchors of laying it out from the stream
+void testReplayMatchesLiveLayout() {
+  printf("testReplayMatchesLiveLayout...\n");
+  FsFile itemCache;
+  const Layout live = layOutLive(RECORDED, &itemCache);
+  ASSERT_TRUE(live.pages.size() > 20);
+  ASSERT_EQ(live.anchors.size(), static_cast<size_t>(PARAGRAPH_COUNT / 5));
+
+  Layout replayed;
+  ASSERT_TRUE(layOutRecorded(itemCache, RECORDED, replayed));
+  ASSERT_EQ(replayed.pages.size(), live.pages.size());
+  for (size_t page = 0; page < live.pages.size(); page++) {
+    ASSERT_EQ(replayed.pages[page], live.pages[page]);
+  }
+  ASSERT_TRUE(replayed.anchors == live.anchors);
+  PASS();
+}
+
+// Items hold nothing that depends on the font or viewport: replayed with other settings, they lay out as the stream
+// does with those settings
+void testReplayWithOtherSettings() {
+  printf("testReplayWithOtherSettings...\n");
+  FsFile itemCache;
+  layOutLive(RECORDED, &itemCache);
+  const Layout live = layOutLive(LARGER_FONT, nullptr);
+
+  Layout replayed;
+  ASSERT_TRUE(layOutRecorded(itemCache, LARGER_FONT, replayed));
+  ASSERT_EQ(replayed.pages.size(), live.pages.size());
+  for (size_t page = 0; page < live.pages.size(); page++) {
+    ASSERT_EQ(replayed.pages[page], live.pages[page]);
+  }
+  ASSERT_TRUE(replayed.anchors == live.anchors);
+  PASS();
+}
+
+// A recording cut short anywhere, inside an item or between two, never replays to its End item
+void testTruncatedCacheIsRejected() {
+  printf("testTruncatedCacheIsRejected...\n");
+  FsFile itemCache;
+  layOutLive(RECORDED, &itemCache);
+  const std::string bytes = contents(itemCache);
+
+  // Every cut through the first items, then a spread over the rest
+  std::vector<size_t> cuts;
+  for (size_t cut = 0; cut < std::min<size_t>(bytes.size(), 4096); cut++) cuts.push_back(cut);
+  for (size_t cut = 4096; cut < bytes.size(); cut += 997) cuts.push_back(cut);
+  cuts.push_back(bytes.size() - 1);
+
+  for (const size_t cut : cuts) {
+    Layout layout;
+    if (layOutRecorded(FsFile(bytes.substr(0, cut)), RECORDED, layout)) {
+      fprintf(stderr, "  cut at %zu of %zu bytes replayed\n", cut, bytes.size());
+      ASSERT_TRUE(false);
+    }
+  }
+  PASS();
+}
+
+// Corrupt lengths and enum values fail the item instead of allocating or laying out garbage
+void testCorruptItemIsRejected() {
+  printf("testCorruptItemIsRejected...\n");
+  Item anchor;
+  anchor.kind = Item::Kind::Anchor;
+  anchor.name = "id";
+  std::string bytes = serialized(anchor);
+
+  Item read;
+  std::string badKind = bytes;
+  badKind[0] = static_cast<char>(0x7f);
+  FsFile badKindFile(badKind);
+  ASSERT_TRUE(!read.deserialize(badKindFile));
+
+  // The anchor id length follows kind and paragraph index
+  std::string hugeName = bytes;
+  const uint32_t hugeLength = 0x7fffffff;
+  memcpy(hugeName.data() + sizeof(Item::Kind) + sizeof(uint16_t), &hugeLength, sizeof(hugeLength));
+  FsFile hugeNameFile(hugeName);
+  ASSERT_TRUE(!read.deserialize(hugeNameFile));
+
+  Item image;
+  image.kind = Item::Kind::Image;
+  image.hasCssWidth = true;
+  image.cssWidth = CssLength(50.0f, CssUnit::Percent);
+  bytes = serialized(image);
+  // The unit of the CSS height is the last byte
+  bytes.back() = static_cast<char>(0x20);
+  FsFile badUnitFile(bytes);
+  ASSERT_TRUE(!read.deserialize(badUnitFile));
+  PASS();
+}
+
+int main() {
+  testParagraphRoundTrip();
+  testImageRoundTrip();
+  testAnchorAndEndRoundTrip();
+  testReplayMatchesLiveLayout();
+  testReplayWithOtherSettings();
+  testTruncatedCacheIsRejected();
+  testCorruptItemIsRejected();
+
+  printf("\n=== Results: %d passed, %d failed ===\n", testsPassed, testsFailed);
+  return testsFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+// Host stand-in for GfxRenderer: text is measured with a fixed glyph width table, scaled by the font id, and drawing
+// does nothing. Layout only needs the measurements to be deterministic.
+
+#include <EpdFontFamily.h>
+#include <Utf8.h>
+
+#include <cstdint>
+
+class GfxRenderer {
+ public:
+  // Font ids are the em size in pixels
+  int getTextAdvanceX(const int fontId, const char* text, const EpdFontFamily::Style style) const {
+    int width = 0;
+    const auto* ptr = reinterpret_cast<const unsigned char*>(text);
+    while (const uint32_t cp = utf8NextCodepoint(&ptr)) {
+      width += glyphAdvance(fontId, cp, style);
+    }
+    return width;
+  }
+  int getTextWidth(const int fontId, const char* text,
+                   const EpdFontFamily::Style style = EpdFontFamily::REGULAR) const {
+    return getTextAdvanceX(fontId, text, style);
+  }
+  int getSpaceWidth(const int fontId, const EpdFontFamily::Style style = EpdFontFamily::REGULAR) const {
+    return glyphAdvance(fontId, ' ', style);
+  }
+  int getSpaceAdvance(const int fontId, const uint32_t leftCp, const uint32_t rightCp,
+                      const EpdFontFamily::Style style) const {
+    return getSpaceWidth(fontId, style) + getKerning(fontId, leftCp, rightCp, style);
+  }
+  int getKerning(int, const uint32_t leftCp, const uint32_t rightCp, EpdFontFamily::Style) const {
+    return ((leftCp ^ rightCp) % 5 == 0) ? -1 : 0;
+  }
+  int getFontAscenderSize(const int fontId) const { return fontId; }
+  int getLineHeight(const int fontId) const { return fontId * 4 / 3; }
+
+  void drawText(int, int, int, const char*, bool = true, EpdFontFamily::Style = EpdFontFamily::REGULAR) const {}
+  void drawLine(int, int, int, int, bool = true) const {}
+
+ private:
+  static int glyphAdvance(const int fontId, const uint32_t cp, const EpdFontFamily::Style style) {
+    const int bold = (style & EpdFontFamily::BOLD) != 0 ? 1 : 0;
+    return fontId / 2 + static_cast<int>(cp * 2654435761u >> 29) * fontId / 16 + bold;
+  }
+};
@@ -0,0 +1,221 @@
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "lib/Epub/Epub/blocks/BlockStyle.h"
+
+static int testsPassed = 0;
+static int testsFailed = 0;
+
+#define ASSERT_EQ(a, b)                                                                          \
+  do {                                                                                           \
+    if ((a) != (b)) {                                                                            \
+      fprintf(stderr, "  FAIL: %s:%d: %s != %s\n", __FILE__, __LINE__, #a, #b);                  \
+      testsFailed++;                                                                             \
+      return;                                                                                    \
+    }                                                                                            \
+  } while (0)
+
+#define ASSERT_TRUE(cond)                                                \
+  do {                                                                   \
+    if (!(cond)) {                                                       \
+      fprintf(stderr, "  FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testsFailed++;                                                     \
+      return;                                                            \
+    }                                                                    \
+  } while (0)
+
+#define PASS() testsPassed++
+
+// ============================================================================
+// Reference: the parser resolved every element's style as it went, before styles were kept in CSS units
+// ============================================================================
+
+BlockStyle referenceFromCssStyle(const CssStyle& cssStyle, const float emSize, const CssTextAlign paragraphAlignment,
+                                 const uint16_t viewportWidth) {
+  BlockStyle blockStyle;
+  const float vw = viewportWidth;
+  const auto maxHorizontalInsetPx = static_cast<int16_t>(emSize * BlockStyle::MAX_HORIZONTAL_INSET_EM);
+  blockStyle.marginTop = cssStyle.marginTop.toPixelsInt16(emSize, vw);
+  blockStyle.marginBottom = cssStyle.marginBottom.toPixelsInt16(emSize, vw);
+  blockStyle.marginLeft = std::min(cssStyle.marginLeft.toPixelsInt16(emSize, vw), maxHorizontalInsetPx);
+  blockStyle.marginRight = std::min(cssStyle.marginRight.toPixelsInt16(emSize, vw), maxHorizontalInsetPx);
+  blockStyle.paddingTop = cssStyle.paddingTop.toPixelsInt16(emSize, vw);
+  blockStyle.paddingBottom = cssStyle.paddingBottom.toPixelsInt16(emSize, vw);
+  blockStyle.paddingLeft = std::min(cssStyle.paddingLeft.toPixelsInt16(emSize, vw), maxHorizontalInsetPx);
+  blockStyle.paddingRight = std::min(cssStyle.paddingRight.toPixelsInt16(emSize, vw), maxHorizontalInsetPx);
+  if (cssStyle.hasTextIndent() && cssStyle.textIndent.isResolvable(vw)) {
+    blockStyle.textIndent = cssStyle.textIndent.toPixelsInt16(emSize, vw);
+    blockStyle.textIndentDefined = true;
+  }
+  blockStyle.textAlignDefined = cssStyle.hasTextAlign();
+  if (paragraphAlignment == CssTextAlign::None) {
+    blockStyle.alignment = blockStyle.textAlignDefined ? cssStyle.textAlign : CssTextAlign::Justify;
+  } else {
+    blockStyle.alignment = paragraphAlignment;
+  }
+  return blockStyle;
+}
+
+bool sameStyle(const BlockStyle& a, const BlockStyle& b) {
+  return a.alignment == b.alignment && a.textAlignDefined == b.textAlignDefined && a.marginTop == b.marginTop &&
+         a.marginBottom == b.marginBottom && a.marginLeft == b.marginLeft && a.marginRight == b.marginRight &&
+         a.paddingTop == b.paddingTop && a.paddingBottom == b.paddingBottom && a.paddingLeft == b.paddingLeft &&
+         a.paddingRight == b.paddingRight && a.textIndent == b.textIndent &&
+         a.textIndentDefined == b.textIndentDefined;
+}
+
+CssLength randomLength(std::mt19937& rng) {
+  static constexpr CssUnit UNITS[] = {CssUnit::Pixels, CssUnit::Em, CssUnit::Rem, CssUnit::Points, CssUnit::Percent};
+  std::uniform_real_distribution<float> value(-1.0f, 6.0f);
+  const CssUnit unit = UNITS[rng() % 5];
+  return {unit == CssUnit::Pixels || unit == CssUnit::Points ? value(rng) * 8.0f : value(rng), unit};
+}
+
+CssStyle randomStyle(std::mt19937& rng) {
+  CssStyle style;
+  auto maybe = [&rng](CssLength& length) {
+    if (rng() % 3 == 0) {
+      length = randomLength(rng);
+      return 1;
+    }
+    return 0;
+  };
+  style.defined.marginTop = maybe(style.marginTop);
+  style.defined.marginBottom = maybe(style.marginBottom);
+  style.defined.marginLeft = maybe(style.marginLeft);
+  style.defined.marginRight = maybe(style.marginRight);
+  style.defined.paddingTop = maybe(style.paddingTop);
+  style.defined.paddingBottom = maybe(style.paddingBottom);
+  style.defined.paddingLeft = maybe(style.paddingLeft);
+  style.defined.paddingRight = maybe(style.paddingRight);
+  style.defined.textIndent = maybe(style.textIndent);
+  if (rng() % 3 == 0) {
+    style.textAlign = static_cast<CssTextAlign>(rng() % 4);
+    style.defined.textAlign = 1;
+  }
+  return style;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+// Nested elements, as the parser combines them into an empty paragraph, resolve to the same pixels as when each
+// element was resolved on its own and the results added up
+void testNestedStylesMatchReference() {
+  printf("testNestedStylesMatchReference...\n");
+  std::mt19937 rng(1234);
+  static constexpr float EM_SIZES[] = {11.0f, 14.0f, 19.0f, 26.0f};
+  static constexpr uint16_t VIEWPORT_WIDTHS[] = {400, 464, 752};
+  static constexpr CssTextAlign ALIGNMENTS[] = {CssTextAlign::None, CssTextAlign::Justify, CssTextAlign::Left};
+
+  for (int round = 0; round < 2000; round++) {
+    const CssTextAlign paragraphAlignment = ALIGNMENTS[rng() % 3];
+    std::vector<CssStyle> elements(1 + rng() % 4);
+    for (auto& element : elements) {
+      element = randomStyle(rng);
+    }
+
+    CssBlockStyle deferred = CssBlockStyle::fromCssStyle(elements[0], paragraphAlignment);
+    for (size_t i = 1; i < elements.size(); i++) {
+      deferred.combineWith(CssBlockStyle::fromCssStyle(elements[i], paragraphAlignment));
+    }
+
+    for (const float emSize : EM_SIZES) {
+      for (const uint16_t viewportWidth : VIEWPORT_WIDTHS) {
+        BlockStyle reference = referenceFromCssStyle(elements[0], emSize, paragraphAlignment, viewportWidth);
+        for (size_t i = 1; i < elements.size(); i++) {
+          reference = reference.getCombinedBlockStyle(
+              referenceFromCssStyle(elements[i], emSize, paragraphAlignment, viewportWidth));
+        }
+        ASSERT_TRUE(sameStyle(deferred.resolve(emSize, viewportWidth), reference));
+      }
+    }
+  }
+  PASS();
+}
+
+// Elements without margins or padding add no box
+void testBoxesOnlyForInsets() {
+  printf("testBoxesOnlyForInsets...\n");
+  CssStyle aligned;
+  aligned.textAlign = CssTextAlign::Center;
+  aligned.defined.textAlign = 1;
+  aligned.textIndent = CssLength(1.5f, CssUnit::Em);
+  aligned.defined.textIndent = 1;
+  const CssBlockStyle style = CssBlockStyle::fromCssStyle(aligned, CssTextAlign::None);
+  ASSERT_TRUE(style.boxes.empty());
+  ASSERT_EQ(style.alignment, CssTextAlign::Center);
+
+  CssStyle spaced;
+  spaced.marginBottom = CssLength(2.0f, CssUnit::Em);
+  spaced.defined.marginBottom = 1;
+  ASSERT_EQ(CssBlockStyle::fromCssStyle(spaced, CssTextAlign::None).boxes.size(), 1u);
+  PASS();
+}
+
+// The same style resolves again for another font and viewport, the horizontal cap following the em size
+void testResolvesPerLayout() {
+  printf("testResolvesPerLayout...\n");
+  CssStyle element;
+  element.marginTop = CssLength(1.0f, CssUnit::Em);
+  element.defined.marginTop = 1;
+  element.marginLeft = CssLength(10.0f, CssUnit::Percent);
+  element.defined.marginLeft = 1;
+  element.paddingLeft = CssLength(5.0f, CssUnit::Em);
+  element.defined.paddingLeft = 1;
+  const CssBlockStyle style = CssBlockStyle::fromCssStyle(element, CssTextAlign::Justify);
+
+  const BlockStyle small = style.resolve(12.0f, 400);
+  ASSERT_EQ(small.marginTop, 12);
+  ASSERT_EQ(small.marginLeft, 24);   // 40px, capped at 2em
+  ASSERT_EQ(small.paddingLeft, 24);  // 60px, capped at 2em
+
+  const BlockStyle large = style.resolve(30.0f, 400);
+  ASSERT_EQ(large.marginTop, 30);
+  ASSERT_EQ(large.marginLeft, 40);
+  ASSERT_EQ(large.paddingLeft, 60);
+  PASS();
+}
+
+// A child's indent and alignment replace the parent's; a child that sets neither keeps them
+void testInnermostIndentAndAlignment() {
+  printf("testInnermostIndentAndAlignment...\n");
+  CssStyle parent;
+  parent.textIndent = CssLength(2.0f, CssUnit::Em);
+  parent.defined.textIndent = 1;
+  parent.textAlign = CssTextAlign::Right;
+  parent.defined.textAlign = 1;
+  CssStyle child;
+  child.marginTop = CssLength(4.0f);
+  child.defined.marginTop = 1;
+
+  CssBlockStyle style = CssBlockStyle::fromCssStyle(parent, CssTextAlign::None);
+  style.combineWith(CssBlockStyle::fromCssStyle(child, CssTextAlign::None));
+  BlockStyle resolved = style.resolve(10.0f, 480);
+  ASSERT_EQ(resolved.textIndent, 20);
+  ASSERT_EQ(resolved.alignment, CssTextAlign::Right);
+
+  child.textIndent = CssLength(0.0f);
+  child.defined.textIndent = 1;
+  child.textAlign = CssTextAlign::Center;
+  child.defined.textAlign = 1;
+  style.combineWith(CssBlockStyle::fromCssStyle(child, CssTextAlign::None));
+  resolved = style.resolve(10.0f, 480);
+  ASSERT_EQ(resolved.textIndent, 0);
+  ASSERT_EQ(resolved.alignment, CssTextAlign::Center);
+  ASSERT_EQ(resolved.marginTop, 8);
+  PASS();
+}
+
+int main() {
+  testNestedStylesMatchReference();
+  testBoxesOnlyForInsets();
+  testResolvesPerLayout();
+  testInnermostIndentAndAlignment();
+
+  printf("\n=== Results: %d passed, %d failed ===\n", testsPassed, testsFailed);
+  return testsFailed > 0 ? 1 : 0;
+}
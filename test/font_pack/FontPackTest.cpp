@@ -0,0 +1,248 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "lib/EpdFont/EpdFont.h"
+#include "lib/EpdFont/EpdFontPack.h"
+#include "lib/EpdFont/builtinFonts/all.h"
+#include "src/fontIds.h"
+
+static int testsPassed = 0;
+static int testsFailed = 0;
+
+#define ASSERT_EQ(a, b)                                                         \
+  do {                                                                          \
+    if ((a) != (b)) {                                                           \
+      fprintf(stderr, "  FAIL: %s:%d: %s != %s\n", __FILE__, __LINE__, #a, #b); \
+      testsFailed++;                                                            \
+      return;                                                                   \
+    }                                                                           \
+  } while (0)
+
+#define ASSERT_TRUE(cond)                                                \
+  do {                                                                   \
+    if (!(cond)) {                                                       \
+      fprintf(stderr, "  FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testsFailed++;                                                     \
+      return;                                                            \
+    }                                                                    \
+  } while (0)
+
+#define PASS() testsPassed++
+
+struct BuiltInFamily {
+  const char* name;
+  int fontId;
+  const EpdFontData* styles[4];  // Indexed by EpdFontFamily::Style
+  std::vector<uint8_t> pack;
+};
+
+#define FAMILY(name, id) \
+  {#name, id, {&name##_regular, &name##_bold, &name##_italic, &name##_bolditalic}, {}}
+
+static std::vector<BuiltInFamily> families = {
+    FAMILY(notoserif_12, NOTOSERIF_12_FONT_ID),       FAMILY(notoserif_14, NOTOSERIF_14_FONT_ID),
+    FAMILY(notoserif_16, NOTOSERIF_16_FONT_ID),       FAMILY(notoserif_18, NOTOSERIF_18_FONT_ID),
+    FAMILY(notosans_12, NOTOSANS_12_FONT_ID),         FAMILY(notosans_14, NOTOSANS_14_FONT_ID),
+    FAMILY(notosans_16, NOTOSANS_16_FONT_ID),         FAMILY(notosans_18, NOTOSANS_18_FONT_ID),
+    FAMILY(opendyslexic_8, OPENDYSLEXIC_8_FONT_ID),   FAMILY(opendyslexic_10, OPENDYSLEXIC_10_FONT_ID),
+    FAMILY(opendyslexic_12, OPENDYSLEXIC_12_FONT_ID), FAMILY(opendyslexic_14, OPENDYSLEXIC_14_FONT_ID),
+};
+
+// Directory run_font_pack_test.sh builds the packs into (build-font-packs.sh), passed in FONT_PACK_DIR
+static bool loadPacks() {
+  const char* dir = getenv("FONT_PACK_DIR");
+  for (BuiltInFamily& family : families) {
+    const std::string path = std::string(dir ? dir : "build/fonts") + "/" + family.name + ".epf";
+    std::ifstream file(path, std::ios::binary);
+    family.pack.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (family.pack.empty()) {
+      fprintf(stderr, "Missing font pack %s\n", path.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+static uint32_t glyphCount(const EpdFontData& font) {
+  const EpdUnicodeInterval& last = font.intervals[font.intervalCount - 1];
+  return last.offset + (last.last - last.first) + 1;
+}
+
+template <typename T>
+static bool sameTable(const T* a, const T* b, const size_t count) {
+  return (a == nullptr) == (b == nullptr) && (count == 0 || memcmp(a, b, count * sizeof(T)) == 0);
+}
+
+static bool sameFont(const EpdFontData& builtIn, const EpdFontData& packed) {
+  if (builtIn.intervalCount != packed.intervalCount || builtIn.advanceY != packed.advanceY ||
+      builtIn.ascender != packed.ascender || builtIn.descender != packed.descender ||
+      builtIn.is2Bit != packed.is2Bit || builtIn.groupCount != packed.groupCount ||
+      builtIn.kernLeftEntryCount != packed.kernLeftEntryCount ||
+      builtIn.kernRightEntryCount != packed.kernRightEntryCount ||
+      builtIn.kernLeftClassCount != packed.kernLeftClassCount ||
+      builtIn.kernRightClassCount != packed.kernRightClassCount ||
+      builtIn.ligaturePairCount != packed.ligaturePairCount || packed.glyphToGroup != nullptr) {
+    return false;
+  }
+  const uint32_t glyphs = glyphCount(builtIn);
+  if (!sameTable(builtIn.intervals, packed.intervals, builtIn.intervalCount) ||
+      !sameTable(builtIn.glyph, packed.glyph, glyphs) ||
+      !sameTable(builtIn.groups, packed.groups, builtIn.groupCount) ||
+      !sameTable(builtIn.kernLeftClasses, packed.kernLeftClasses, builtIn.kernLeftEntryCount) ||
+      !sameTable(builtIn.kernRightClasses, packed.kernRightClasses, builtIn.kernRightEntryCount) ||
+      !sameTable(builtIn.ligaturePairs, packed.ligaturePairs, builtIn.ligaturePairCount) ||
+      !sameTable(builtIn.kernMatrix, packed.kernMatrix, builtIn.kernLeftClassCount * builtIn.kernRightClassCount)) {
+    return false;
+  }
+  // Compressed fonts: every group's DEFLATE stream; the reader fonts are all compressed
+  for (uint16_t g = 0; g < builtIn.groupCount; g++) {
+    const EpdFontGroup& group = builtIn.groups[g];
+    if (memcmp(builtIn.bitmap + group.compressedOffset, packed.bitmap + group.compressedOffset,
+               group.compressedSize) != 0) {
+      return false;
+    }
+  }
+  return builtIn.groupCount > 0;
+}
+
+// --- Tests ---
+
+void testPacksMatchBuiltInFonts() {
+  printf("testPacksMatchBuiltInFonts...\n");
+  for (const BuiltInFamily& family : families) {
+    EpdFontPack::Family parsed;
+    ASSERT_TRUE(EpdFontPack::parse(family.pack.data(), family.pack.size(), parsed));
+    ASSERT_EQ(parsed.fontId, family.fontId);
+    ASSERT_EQ(parsed.styleMask, 0xF);
+    for (uint8_t style = 0; style < 4; style++) {
+      if (!sameFont(*family.styles[style], parsed.styles[style])) {
+        fprintf(stderr, "  %s style %u differs from the built-in font\n", family.name, style);
+        ASSERT_TRUE(false);
+      }
+    }
+  }
+  PASS();
+}
+
+void testTablesPointIntoThePack() {
+  printf("testTablesPointIntoThePack...\n");
+  const BuiltInFamily& family = families.front();
+  EpdFontPack::Family parsed;
+  ASSERT_TRUE(EpdFontPack::parse(family.pack.data(), family.pack.size(), parsed));
+  const auto inPack = [&](const void* p) {
+    const auto* bytes = static_cast<const uint8_t*>(p);
+    return bytes >= family.pack.data() && bytes < family.pack.data() + family.pack.size();
+  };
+  for (const EpdFontData& font : parsed.styles) {
+    ASSERT_TRUE(inPack(font.bitmap) && inPack(font.glyph) && inPack(font.intervals) && inPack(font.groups));
+    ASSERT_TRUE(inPack(font.kernLeftClasses) && inPack(font.kernMatrix) && inPack(font.ligaturePairs));
+  }
+  PASS();
+}
+
+void testLookupsMatchBuiltInFonts() {
+  printf("testLookupsMatchBuiltInFonts...\n");
+  for (const BuiltInFamily& family : families) {
+    EpdFontPack::Family parsed;
+    ASSERT_TRUE(EpdFontPack::parse(family.pack.data(), family.pack.size(), parsed));
+    const EpdFont builtIn(family.styles[0]);
+    const EpdFont packed(&parsed.styles[0]);
+    for (uint32_t cp = 0; cp < 0x3000; cp++) {
+      const EpdGlyph* a = builtIn.getGlyph(cp);
+      const EpdGlyph* b = packed.getGlyph(cp);
+      ASSERT_EQ(a == nullptr, b == nullptr);
+      ASSERT_TRUE(!a || memcmp(a, b, sizeof(EpdGlyph)) == 0);
+    }
+    for (uint32_t left = 0x20; left < 0x180; left++) {
+      for (uint32_t right = 0x20; right < 0x180; right++) {
+        ASSERT_EQ(builtIn.getKerning(left, right), packed.getKerning(left, right));
+        ASSERT_EQ(builtIn.getLigature(left, right), packed.getLigature(left, right));
+      }
+    }
+  }
+  PASS();
+}
+
+void testRejectsDamagedPacks() {
+  printf("testRejectsDamagedPacks...\n");
+  const std::vector<uint8_t>& good = families.front().pack;
+  EpdFontPack::Family parsed;
+  parsed.fontId = 42;
+
+  const auto rejects = [&](std::vector<uint8_t> image, const size_t size) {
+    return !EpdFontPack::parse(image.data(), size, parsed) && parsed.fontId == 42;
+  };
+  const auto patched = [&](const size_t offset, const uint32_t value) {
+    std::vector<uint8_t> image = good;
+    memcpy(image.data() + offset, &value, sizeof(value));
+    return image;
+  };
+  uint32_t regularFace;
+  memcpy(&regularFace, good.data() + 12, sizeof(regularFace));
+
+  ASSERT_TRUE(!EpdFontPack::parse(nullptr, good.size(), parsed));
+  ASSERT_TRUE(rejects(good, good.size() - 1));                                  // Truncated copy
+  ASSERT_TRUE(rejects(patched(0, 0x4546504B), good.size()));                    // Magic reversed
+  ASSERT_TRUE(rejects(patched(4, 0x0F02), good.size()));                        // Unknown version
+  ASSERT_TRUE(rejects(patched(4, 0x0E01), good.size()));                        // No regular style
+  ASSERT_TRUE(rejects(patched(regularFace + 8, 3), good.size()));               // Intervals point past the glyphs
+  ASSERT_TRUE(rejects(patched(regularFace + 8, 0x40000000), good.size()));      // Glyph table past the end
+  ASSERT_TRUE(rejects(patched(regularFace + 36, regularFace + 2), good.size()));  // Misaligned glyph table
+  ASSERT_TRUE(rejects(patched(regularFace + 28, 16), good.size()));             // Groups outside the bitmap
+  ASSERT_TRUE(rejects(patched(regularFace, 0x41020122), good.size()));          // Kern class IDs over the count
+
+  // Tables are used in place, so the image itself must keep them aligned
+  std::vector<uint8_t> shifted(good.size() + 1);
+  memcpy(shifted.data() + 1, good.data(), good.size());
+  ASSERT_TRUE(!EpdFontPack::parse(shifted.data() + 1, good.size(), parsed));
+  PASS();
+}
+
+// Packs go through the same EpdFont code on the same table layout, so lookups cost the same as for built-in fonts
+void benchmarkGlyphLookups() {
+  printf("benchmarkGlyphLookups...\n");
+  const BuiltInFamily& family = families.front();
+  EpdFontPack::Family parsed;
+  ASSERT_TRUE(EpdFontPack::parse(family.pack.data(), family.pack.size(), parsed));
+
+  const auto run = [](const EpdFont& font) {
+    uint64_t checksum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < 200; round++) {
+      for (uint32_t cp = 0x20; cp < 0x500; cp++) {
+        const EpdGlyph* glyph = font.getGlyph(cp);
+        checksum += glyph ? glyph->advanceX + font.getKerning(cp, 'a') : 0;
+      }
+    }
+    const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+    return std::make_pair(elapsed.count() / (200.0 * (0x500 - 0x20)), checksum);
+  };
+  const auto [builtInNs, builtInSum] = run(EpdFont(family.styles[0]));
+  const auto [packedNs, packedSum] = run(EpdFont(&parsed.styles[0]));
+  printf("  glyph + kern lookup: built-in %.1f ns, pack %.1f ns\n", builtInNs, packedNs);
+  ASSERT_EQ(builtInSum, packedSum);
+  PASS();
+}
+
+int main() {
+  printf("=== Font Pack Tests ===\n\n");
+  if (!loadPacks()) {
+    return 1;
+  }
+
+  testPacksMatchBuiltInFonts();
+  testTablesPointIntoThePack();
+  testLookupsMatchBuiltInFonts();
+  testRejectsDamagedPacks();
+  benchmarkGlyphLookups();
+
+  printf("\n=== Results: %d passed, %d failed ===\n", testsPassed, testsFailed);
+  return testsFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,228 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "lib/GfxRenderer/FrameDiff.h"
+
+static int testsPassed = 0;
+static int testsFailed = 0;
+
+#define ASSERT_EQ(a, b)                                                         \
+  do {                                                                          \
+    if ((a) != (b)) {                                                           \
+      fprintf(stderr, "  FAIL: %s:%d: %s != %s\n", __FILE__, __LINE__, #a, #b); \
+      testsFailed++;                                                            \
+      return;                                                                   \
+    }                                                                           \
+  } while (0)
+
+#define ASSERT_TRUE(cond)                                                \
+  do {                                                                   \
+    if (!(cond)) {                                                       \
+      fprintf(stderr, "  FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testsFailed++;                                                     \
+      return;                                                            \
+    }                                                                    \
+  } while (0)
+
+#define PASS() testsPassed++
+
+// X4 panel geometry (HalDisplay::DISPLAY_WIDTH x DISPLAY_HEIGHT, native landscape); the X3 stride is 99 bytes
+constexpr int PANEL_WIDTH = 800;
+constexpr int PANEL_HEIGHT = 480;
+
+using FrameDiff::Rect;
+
+// ============================================================================
+// Host framebuffer with the GfxRenderer drawing rules (Portrait orientation)
+// ============================================================================
+
+struct Frame {
+  int stride;
+  std::vector<uint8_t> pixels;
+  Rect dirty;
+
+  explicit Frame(const int strideBytes) : stride(strideBytes), pixels(strideBytes * PANEL_HEIGHT, 0xFF) {}
+
+  // Same physical mapping and bit rules as GfxRenderer::drawPixel in Portrait
+  void drawPixel(const int x, const int y, const bool black) {
+    const int phyX = y;
+    const int phyY = PANEL_HEIGHT - 1 - x;
+    dirty.include(phyX, phyY);
+    uint8_t& byte = pixels[phyY * stride + phyX / 8];
+    const uint8_t mask = 1 << (7 - phyX % 8);
+    byte = black ? (byte & ~mask) : (byte | mask);
+  }
+
+  void fillRect(const int x, const int y, const int w, const int h, const bool black) {
+    for (int yy = y; yy < y + h; yy++) {
+      for (int xx = x; xx < x + w; xx++) drawPixel(xx, yy, black);
+    }
+  }
+
+  void clear() {
+    memset(pixels.data(), 0xFF, pixels.size());
+    dirty = Rect::full(stride * 8 < PANEL_WIDTH ? stride * 8 : PANEL_WIDTH, PANEL_HEIGHT);
+  }
+
+  bool pixel(const int phyX, const int phyY) const { return (pixels[phyY * stride + phyX / 8] >> (7 - phyX % 8)) & 1; }
+};
+
+// Bit-by-bit reference for FrameDiff::diff
+Rect bruteForceDiff(const Frame& a, const Frame& b) {
+  Rect r;
+  for (int y = 0; y < PANEL_HEIGHT; y++) {
+    for (int x = 0; x < a.stride * 8; x++) {
+      if (a.pixel(x, y) != b.pixel(x, y)) r.include(x, y);
+    }
+  }
+  return r;
+}
+
+bool sameRect(const Rect& a, const Rect& b) {
+  if (a.empty() || b.empty()) return a.empty() == b.empty();
+  return a.x0 == b.x0 && a.y0 == b.y0 && a.x1 == b.x1 && a.y1 == b.y1;
+}
+
+// A menu of eight rows with one highlighted (inverted) row, redrawn from scratch like the UI activities do
+void drawMenu(Frame& frame, const int selected) {
+  frame.clear();
+  frame.fillRect(0, 0, 480, 40, true);  // Header bar
+  for (int i = 0; i < 8; i++) {
+    const int top = 60 + i * 60;
+    if (i == selected) frame.fillRect(10, top, 460, 50, true);
+    frame.fillRect(20, top + 20, 200 + i * 10, 10, i != selected);  // Item label
+  }
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void testIdenticalFramesAreClean() {
+  printf("testIdenticalFramesAreClean...\n");
+  for (const int stride : {100, 99}) {
+    Frame a(stride);
+    Frame b(stride);
+    drawMenu(a, 3);
+    drawMenu(b, 3);
+    ASSERT_TRUE(FrameDiff::diff(a.pixels.data(), b.pixels.data(), stride, PANEL_HEIGHT).empty());
+  }
+  PASS();
+}
+
+void testDiffMatchesBruteForce() {
+  printf("testDiffMatchesBruteForce...\n");
+  std::mt19937 rng(1234);
+  for (const int stride : {100, 99}) {
+    const int width = stride * 8;
+    for (int round = 0; round < 200; round++) {
+      Frame before(stride);
+      for (auto& byte : before.pixels) byte = static_cast<uint8_t>(rng());
+      Frame after = before;
+
+      // A few single bits, including the frame edges and word boundaries
+      const int flips = 1 + static_cast<int>(rng() % 4);
+      for (int i = 0; i < flips; i++) {
+        int phyX = static_cast<int>(rng() % width);
+        int phyY = static_cast<int>(rng() % PANEL_HEIGHT);
+        if (round % 7 == 0) phyX = (round & 1) ? 0 : width - 1;
+        if (round % 11 == 0) phyY = (round & 1) ? 0 : PANEL_HEIGHT - 1;
+        after.pixels[phyY * stride + phyX / 8] ^= 1 << (7 - phyX % 8);
+      }
+
+      const Rect expected = bruteForceDiff(before, after);
+      const Rect actual = FrameDiff::diff(before.pixels.data(), after.pixels.data(), stride, PANEL_HEIGHT);
+      if (!sameRect(expected, actual)) {
+        fprintf(stderr, "  stride %d round %d: expected (%d,%d)-(%d,%d), got (%d,%d)-(%d,%d)\n", stride, round,
+                expected.x0, expected.y0, expected.x1, expected.y1, actual.x0, actual.y0, actual.x1, actual.y1);
+      }
+      ASSERT_TRUE(sameRect(expected, actual));
+    }
+  }
+  PASS();
+}
+
+void testTrackedRegionCoversDiff() {
+  printf("testTrackedRegionCoversDiff...\n");
+  std::mt19937 rng(99);
+  for (int round = 0; round < 100; round++) {
+    Frame frame(100);
+    drawMenu(frame, 2);
+    const Frame before = frame;
+    frame.dirty.clear();
+
+    // Random primitives, some of which redraw pixels with their existing value
+    for (int i = 0; i < 3; i++) {
+      const int x = static_cast<int>(rng() % 470);
+      const int y = static_cast<int>(rng() % 790);
+      frame.fillRect(x, y, 1 + static_cast<int>(rng() % (480 - x)), 1 + static_cast<int>(rng() % 10),
+                     (rng() & 1) != 0);
+    }
+
+    const Rect changed = FrameDiff::diff(before.pixels.data(), frame.pixels.data(), 100, PANEL_HEIGHT);
+    ASSERT_TRUE(frame.dirty.contains(changed));
+  }
+  PASS();
+}
+
+void testSignaturesFindChangedRegion() {
+  printf("testSignaturesFindChangedRegion...\n");
+  for (const int stride : {100, 99}) {
+    std::vector<uint32_t> storage(FrameDiff::FrameSignatures::storageSize(stride, PANEL_HEIGHT));
+    FrameDiff::FrameSignatures signatures;
+    signatures.init(storage.data(), stride, PANEL_HEIGHT);
+
+    Frame frame(stride);
+    drawMenu(frame, 2);
+    Rect changed;
+
+    // Nothing is known about the panel yet: the whole frame counts as changed
+    ASSERT_TRUE(signatures.update(frame.pixels.data(), frame.dirty, &changed));
+    ASSERT_TRUE(sameRect(changed, Rect::full(stride * 8, PANEL_HEIGHT)));
+
+    // Nothing drawn, nothing to do
+    frame.dirty.clear();
+    ASSERT_TRUE(!signatures.update(frame.pixels.data(), frame.dirty, &changed));
+
+    // A full redraw that produced the same pixels is recognised as unchanged
+    const Frame shown = frame;
+    drawMenu(frame, 2);
+    ASSERT_TRUE(!signatures.update(frame.pixels.data(), frame.dirty, &changed));
+
+    // Moving the cursor: the reported region covers the exact diff, rounded out to 32-pixel words
+    drawMenu(frame, 5);
+    const Rect exact = FrameDiff::diff(shown.pixels.data(), frame.pixels.data(), stride, PANEL_HEIGHT);
+    ASSERT_TRUE(signatures.update(frame.pixels.data(), frame.dirty, &changed));
+    ASSERT_TRUE(changed.contains(exact));
+    ASSERT_EQ(changed.y0, exact.y0);
+    ASSERT_EQ(changed.y1, exact.y1);
+    ASSERT_EQ(changed.x0, exact.x0 & ~31);
+    ASSERT_TRUE(changed.x1 - exact.x1 < 32);
+    if (stride == 100) {
+      printf("  cursor move: drawn %dx%d, signatures %dx%d, exact %dx%d\n", frame.dirty.width(), frame.dirty.height(),
+             changed.width(), changed.height(), exact.width(), exact.height());
+    }
+
+    // After a grayscale update the panel contents are unknown again
+    signatures.invalidate();
+    frame.dirty.clear();
+    ASSERT_TRUE(signatures.update(frame.pixels.data(), frame.dirty, &changed));
+    ASSERT_TRUE(sameRect(changed, Rect::full(stride * 8, PANEL_HEIGHT)));
+  }
+  PASS();
+}
+
+int main() {
+  printf("=== Frame Diff Tests ===\n\n");
+
+  testIdenticalFramesAreClean();
+  testDiffMatchesBruteForce();
+  testTrackedRegionCoversDiff();
+  testSignaturesFindChangedRegion();
+
+  printf("\n=== Results: %d passed, %d failed ===\n", testsPassed, testsFailed);
+  return testsFailed > 0 ? 1 : 0;
+}
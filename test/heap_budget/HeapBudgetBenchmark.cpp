@@ -0,0 +1,252 @@
+#include <HeapTags.h>
+#include <XmlParserUtils.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "lib/EpdFont/FontDecompressor.h"
+#include "lib/EpdFont/builtinFonts/notosans_14_regular.h"
+#include "lib/EpdFont/builtinFonts/notoserif_14_bold.h"
+#include "lib/EpdFont/builtinFonts/notoserif_14_bolditalic.h"
+#include "lib/EpdFont/builtinFonts/notoserif_14_italic.h"
+#include "lib/EpdFont/builtinFonts/notoserif_14_regular.h"
+#include "lib/Epub/Epub/css/CssParser.h"
+
+static int testsPassed = 0;
+static int testsFailed = 0;
+
+#define ASSERT_EQ(a, b)                                                         \
+  do {                                                                          \
+    if ((a) != (b)) {                                                           \
+      fprintf(stderr, "  FAIL: %s:%d: %s != %s\n", __FILE__, __LINE__, #a, #b); \
+      testsFailed++;                                                            \
+      return;                                                                   \
+    }                                                                           \
+  } while (0)
+
+#define ASSERT_TRUE(cond)                                                \
+  do {                                                                   \
+    if (!(cond)) {                                                       \
+      fprintf(stderr, "  FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testsFailed++;                                                     \
+      return;                                                            \
+    }                                                                    \
+  } while (0)
+
+#define PASS() testsPassed++
+
+// ============================================================================
+// Host rendering workload
+//
+// One book page the way the reader produces it: the chapter's stylesheet is parsed, the chapter XHTML goes through
+// expat, the page's glyphs are prewarmed for all four styles, and UI glyphs are drawn from a font that was not
+// prewarmed (hot-group path). A streaming inflate stands in for reading the chapter out of the EPUB zip.
+// ============================================================================
+
+static const char* const PAGE_TEXT =
+    "It was the best of times, it was the worst of times, it was the age of wisdom, it was the age of foolishness, "
+    "it was the epoch of belief, it was the epoch of incredulity, it was the season of Light, it was the season of "
+    "Darkness, it was the spring of hope, it was the winter of despair. \"Quoth the Raven: Nevermore!\" 1234567890 "
+    "— naïve café résumé, Straße, Øresund; (parentheses) [brackets] {braces} and question marks?";
+
+static std::string buildStylesheet() {
+  std::string css = "body { margin: 0; text-align: justify }\np { text-indent: 1.5em; margin: 0 }\n";
+  for (int i = 0; i < 400; i++) {
+    css += ".c" + std::to_string(i) + " { font-weight: " + (i % 2 ? "bold" : "normal") +
+           "; text-align: " + (i % 3 ? "left" : "center") + "; margin-left: " + std::to_string(i % 7) + "em }\n";
+  }
+  return css;
+}
+
+static std::string buildChapter() {
+  std::string xhtml =
+      "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<html xmlns=\"http://www.w3.org/1999/xhtml\"><head>"
+      "<title>Chapter</title></head><body><h1 class=\"c1\">Chapter One</h1>\n";
+  for (int i = 0; i < 300; i++) {
+    xhtml += "<p class=\"c" + std::to_string(i % 400) + "\">" + PAGE_TEXT + " <em>emphasis</em> <b>strong</b></p>\n";
+  }
+  xhtml += "</body></html>\n";
+  return xhtml;
+}
+
+struct ChapterCounts {
+  int elements = 0;
+  size_t textBytes = 0;
+};
+
+static void testParseStylesheet() {
+  printf("testParseStylesheet...\n");
+  FsFile source(buildStylesheet());
+  CssParser parser("/tmp");
+  ASSERT_TRUE(parser.loadFromStream(source));
+  ASSERT_EQ(parser.resolveStyle("p", "c1").textAlign, CssTextAlign::Left);
+  ASSERT_TRUE(HeapTags::usage(HeapTags::Tag::Css).currentBytes > 0);
+  PASS();
+}
+
+static void testParseChapter() {
+  printf("testParseChapter...\n");
+  const std::string xhtml = buildChapter();
+  ChapterCounts counts;
+
+  XML_Parser parser = createXmlParser();
+  ASSERT_TRUE(parser != nullptr);
+  XML_SetUserData(parser, &counts);
+  XML_SetElementHandler(
+      parser, [](void* data, const XML_Char*, const XML_Char**) { static_cast<ChapterCounts*>(data)->elements++; },
+      nullptr);
+  XML_SetCharacterDataHandler(parser, [](void* data, const XML_Char*, const int len) {
+    static_cast<ChapterCounts*>(data)->textBytes += len;
+  });
+
+  // Fed in 1KB chunks like ChapterHtmlSlimParser reads the chapter from the zip
+  constexpr size_t CHUNK = 1024;
+  bool ok = true;
+  for (size_t offset = 0; ok && offset < xhtml.size(); offset += CHUNK) {
+    const size_t len = std::min(CHUNK, xhtml.size() - offset);
+    const bool last = offset + len >= xhtml.size();
+    ok = XML_Parse(parser, xhtml.data() + offset, static_cast<int>(len), last) == XML_STATUS_OK;
+  }
+  const size_t expatPeak = HeapTags::usage(HeapTags::Tag::Expat).currentBytes;
+  destroyXmlParser(parser);
+
+  ASSERT_TRUE(ok);
+  ASSERT_EQ(counts.elements, 5 + 300 * 3);
+  ASSERT_TRUE(expatPeak > 0);
+  ASSERT_EQ(HeapTags::usage(HeapTags::Tag::Expat).currentBytes, static_cast<size_t>(0));
+  PASS();
+}
+
+static void testStreamingInflate() {
+  printf("testStreamingInflate...\n");
+  // Every compressed group of the regular font, streamed through the ring buffer in small reads
+  const EpdFontData& font = notoserif_14_regular;
+  uint8_t out[512];
+  for (uint16_t g = 0; g < font.groupCount; g++) {
+    const EpdFontGroup& group = font.groups[g];
+    InflateReader reader;
+    ASSERT_TRUE(reader.init(true));
+    reader.setSource(&font.bitmap[group.compressedOffset], group.compressedSize);
+
+    size_t total = 0;
+    InflateStatus status = InflateStatus::Ok;
+    while (status == InflateStatus::Ok) {
+      size_t produced = 0;
+      status = reader.readAtMost(out, sizeof(out), &produced);
+      total += produced;
+    }
+    ASSERT_TRUE(status == InflateStatus::Done);
+    ASSERT_EQ(total, static_cast<size_t>(group.uncompressedSize));
+  }
+  ASSERT_EQ(HeapTags::usage(HeapTags::Tag::Inflate).currentBytes, static_cast<size_t>(0));
+  PASS();
+}
+
+static void testRenderPageGlyphs() {
+  printf("testRenderPageGlyphs...\n");
+  FontDecompressor decompressor;
+  ASSERT_TRUE(decompressor.init());
+
+  const EpdFontData* styles[] = {&notoserif_14_regular, &notoserif_14_bold, &notoserif_14_italic,
+                                 &notoserif_14_bolditalic};
+  for (const EpdFontData* style : styles) {
+    ASSERT_EQ(decompressor.prewarmCache(style, PAGE_TEXT), 0);
+  }
+
+  // Status bar and UI text come from a font that was not prewarmed
+  const EpdFontData& ui = notosans_14_regular;
+  for (uint32_t i = 0; i < 200; i++) {
+    const EpdGlyph& glyph = ui.glyph[i];
+    if (glyph.dataLength == 0) continue;
+    ASSERT_TRUE(decompressor.getBitmap(&ui, &glyph, i) != nullptr);
+  }
+
+  decompressor.deinit();
+  ASSERT_EQ(HeapTags::usage(HeapTags::Tag::FontDecompressor).currentBytes, static_cast<size_t>(0));
+  PASS();
+}
+
+// ============================================================================
+// Budgets
+// ============================================================================
+
+static bool loadBudgets(const char* path, size_t budgets[HeapTags::TAG_COUNT], bool present[HeapTags::TAG_COUNT]) {
+  std::ifstream file(path);
+  if (!file) {
+    fprintf(stderr, "  cannot open budgets file %s\n", path);
+    return false;
+  }
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#') continue;
+    std::istringstream fields(line);
+    std::string name;
+    size_t bytes = 0;
+    if (!(fields >> name >> bytes)) {
+      fprintf(stderr, "  malformed budget line: %s\n", line.c_str());
+      return false;
+    }
+    bool known = false;
+    for (size_t i = 0; i < HeapTags::TAG_COUNT; i++) {
+      if (name == HeapTags::tagName(static_cast<HeapTags::Tag>(i))) {
+        budgets[i] = bytes;
+        present[i] = true;
+        known = true;
+      }
+    }
+    if (!known) {
+      fprintf(stderr, "  unknown heap tag in budgets: %s\n", name.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+static void checkBudgets(const char* path) {
+  printf("checkBudgets (%s)...\n", path);
+  size_t budgets[HeapTags::TAG_COUNT] = {};
+  bool present[HeapTags::TAG_COUNT] = {};
+  ASSERT_TRUE(loadBudgets(path, budgets, present));
+
+  bool withinBudget = true;
+  printf("  %-18s %10s %10s %8s\n", "tag", "peak", "budget", "allocs");
+  for (size_t i = 0; i < HeapTags::TAG_COUNT; i++) {
+    const auto tag = static_cast<HeapTags::Tag>(i);
+    const HeapTags::Usage usage = HeapTags::usage(tag);
+    if (!present[i]) {
+      fprintf(stderr, "  no budget for heap tag %s\n", HeapTags::tagName(tag));
+      withinBudget = false;
+      continue;
+    }
+    const bool over = usage.peakBytes > budgets[i];
+    printf("  %-18s %10zu %10zu %8lu%s\n", HeapTags::tagName(tag), usage.peakBytes, budgets[i],
+           static_cast<unsigned long>(usage.allocations), over ? "  OVER BUDGET" : "");
+    if (over) withinBudget = false;
+  }
+  ASSERT_TRUE(withinBudget);
+  PASS();
+}
+
+int main(const int argc, char** argv) {
+  printf("=== Heap Budget Benchmark ===\n\n");
+
+  HeapTags::reset();
+  const auto start = std::chrono::steady_clock::now();
+  testParseStylesheet();
+  testParseChapter();
+  testStreamingInflate();
+  testRenderPageGlyphs();
+  const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  printf("  workload: %.2f ms on this host\n\n", ms);
+
+  checkBudgets(argc > 1 ? argv[1] : "test/heap_budget/budgets.txt");
+
+  printf("\n=== Results: %d passed, %d failed ===\n", testsPassed, testsFailed);
+  return testsFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+// Host stand-in for the few Arduino APIs used by the libraries the heap budget benchmark links
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+
+inline unsigned long micros() {
+  return static_cast<unsigned long>(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+inline unsigned long millis() { return micros() / 1000; }
+
+struct EspClass {
+  // Plenty, so heap guards never skip work on the host
+  uint32_t getFreeHeap() const { return 256 * 1024; }
+};
+
+inline EspClass ESP;
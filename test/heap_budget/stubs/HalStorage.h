@@ -0,0 +1,47 @@
+#pragma once
+
+// Host stand-in for HalStorage: an in-memory FsFile and a Storage with no files
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cstring>
+#include <string>
+
+class FsFile {
+ public:
+  FsFile() = default;
+  explicit FsFile(std::string data) : data(std::move(data)) {}
+
+  explicit operator bool() const { return true; }
+
+  int available() const { return static_cast<int>(data.size() - position); }
+
+  int read(void* buffer, const size_t size) {
+    const size_t n = size < data.size() - position ? size : data.size() - position;
+    memcpy(buffer, data.data() + position, n);
+    position += n;
+    return static_cast<int>(n);
+  }
+
+  size_t write(const void* buffer, const size_t size) {
+    data.append(static_cast<const char*>(buffer), size);
+    return size;
+  }
+  size_t write(const uint8_t value) { return write(&value, sizeof(value)); }
+
+  void close() {}
+
+ private:
+  std::string data;
+  size_t position = 0;
+};
+
+struct HalStorage {
+  bool exists(const char*) const { return false; }
+  bool remove(const char*) const { return false; }
+  bool openFileForRead(const char*, const std::string&, FsFile&) const { return false; }
+  bool openFileForWrite(const char*, const std::string&, FsFile&) const { return false; }
+};
+
+inline HalStorage Storage;
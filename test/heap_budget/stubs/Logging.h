@@ -0,0 +1,9 @@
+#pragma once
+
+// Host stand-in for lib/Logging: messages are formatted nowhere, but arguments still count as used
+
+inline void logPrintf(const char*, const char*, const char*, ...) {}
+
+#define LOG_DBG(origin, format, ...) logPrintf("DBG", origin, format "\n", ##__VA_ARGS__)
+#define LOG_ERR(origin, format, ...) logPrintf("ERR", origin, format "\n", ##__VA_ARGS__)
+#define LOG_INF(origin, format, ...) logPrintf("INF", origin, format "\n", ##__VA_ARGS__)
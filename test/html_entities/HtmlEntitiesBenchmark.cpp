@@ -0,0 +1,185 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// Included rather than linked, for ENTITY_LOOKUP
+#include "lib/Epub/Epub/htmlEntities.cpp"
+
+static int testsPassed = 0;
+static int testsFailed = 0;
+
+#define ASSERT_EQ(a, b)                                                         \
+  do {                                                                          \
+    if ((a) != (b)) {                                                           \
+      fprintf(stderr, "  FAIL: %s:%d: %s != %s\n", __FILE__, __LINE__, #a, #b); \
+      testsFailed++;                                                            \
+      return;                                                                   \
+    }                                                                           \
+  } while (0)
+
+#define ASSERT_TRUE(cond)                                                \
+  do {                                                                   \
+    if (!(cond)) {                                                       \
+      fprintf(stderr, "  FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testsFailed++;                                                     \
+      return;                                                            \
+    }                                                                    \
+  } while (0)
+
+#define PASS() testsPassed++
+
+// The binary search lookupHtmlEntity used before the perfect hash, as the reference
+static const char* binarySearchLookup(const char* entity, const size_t len) {
+  if (entity == nullptr || len == 0) return nullptr;
+  size_t lo = 0;
+  size_t hi = ENTITY_LOOKUP_COUNT;
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    const char* key = ENTITY_LOOKUP[mid].key;
+    const size_t keyLen = strlen(key);
+    int cmp = memcmp(entity, key, len < keyLen ? len : keyLen);
+    if (cmp == 0) cmp = len < keyLen ? -1 : (len > keyLen ? 1 : 0);
+    if (cmp == 0) return ENTITY_LOOKUP[mid].value;
+    if (cmp < 0) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return nullptr;
+}
+
+// What ChapterHtmlSlimParser::defaultHandlerExpand does
+static const char* handlerLookup(const char* entity, const size_t len) {
+  const char* value = lookupCommonHtmlEntity(entity, len);
+  return value != nullptr ? value : lookupHtmlEntity(entity, len);
+}
+
+static std::vector<std::string> unknownEntities() {
+  std::vector<std::string> unknown = {"&;", "&x;", "&nbs;", "&nbspp;", "&NBSP;", "&mdash", "mdash;", "&zzzz;",
+                                      "&amp", "&hellipsis;", "&#8217;", "&#x2019;", "&eacute ;", "&thinspace;"};
+  // Every key with one letter changed
+  for (size_t i = 0; i < ENTITY_LOOKUP_COUNT; i++) {
+    std::string key = ENTITY_LOOKUP[i].key;
+    key[1] = key[1] == 'q' ? 'Q' : 'q';
+    if (binarySearchLookup(key.data(), key.size()) == nullptr) unknown.push_back(key);
+  }
+  return unknown;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+static void testEveryKey() {
+  printf("testEveryKey (%zu entities)...\n", ENTITY_LOOKUP_COUNT);
+  for (size_t i = 0; i < ENTITY_LOOKUP_COUNT; i++) {
+    const char* key = ENTITY_LOOKUP[i].key;
+    ASSERT_TRUE(lookupHtmlEntity(key, strlen(key)) == ENTITY_LOOKUP[i].value);
+    ASSERT_TRUE(handlerLookup(key, strlen(key)) != nullptr);
+    ASSERT_TRUE(strcmp(handlerLookup(key, strlen(key)), ENTITY_LOOKUP[i].value) == 0);
+  }
+  PASS();
+}
+
+static void testUnknown() {
+  printf("testUnknown...\n");
+  for (const std::string& entity : unknownEntities()) {
+    ASSERT_TRUE(lookupHtmlEntity(entity.data(), entity.size()) == nullptr);
+  }
+  ASSERT_TRUE(lookupHtmlEntity(nullptr, 0) == nullptr);
+  ASSERT_TRUE(lookupHtmlEntity("&nbsp;", 0) == nullptr);
+  // A prefix of a key is not the key
+  ASSERT_TRUE(lookupHtmlEntity("&nbsp;", 5) == nullptr);
+  ASSERT_TRUE(lookupCommonHtmlEntity("&nbsp;x", 7) == nullptr);
+  PASS();
+}
+
+static void testCommonFastPath() {
+  printf("testCommonFastPath...\n");
+  for (const CommonHtmlEntity& common : COMMON_HTML_ENTITIES) {
+    const std::string entity = std::string("&") + common.name + ";";
+    ASSERT_TRUE(lookupCommonHtmlEntity(entity.data(), entity.size()) == common.value);
+    ASSERT_TRUE(strcmp(binarySearchLookup(entity.data(), entity.size()), common.value) == 0);
+  }
+  ASSERT_TRUE(lookupCommonHtmlEntity("&euro;", 6) == nullptr);
+  ASSERT_TRUE(lookupCommonHtmlEntity("&nbspnbsp;", 10) == nullptr);
+  PASS();
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+
+// An entity-heavy book: mostly the common entities (the first ones far more often than the others), some of the
+// rest, a few the table does not know
+static std::vector<std::string> workload() {
+  std::mt19937 random(47);
+  std::vector<std::string> unknown = unknownEntities();
+  std::vector<std::string> entities;
+  for (int i = 0; i < 20000; i++) {
+    const unsigned roll = random() % 100;
+    if (roll < 85) {
+      const unsigned pick = random() % 100;
+      const size_t index = pick < 45   ? 0
+                           : pick < 75 ? 1
+                           : pick < 85 ? 2
+                                       : random() % std::size(COMMON_HTML_ENTITIES);
+      const auto& common = COMMON_HTML_ENTITIES[index];
+      entities.push_back(std::string("&") + common.name + ";");
+    } else if (roll < 97) {
+      entities.emplace_back(ENTITY_LOOKUP[random() % ENTITY_LOOKUP_COUNT].key);
+    } else {
+      entities.push_back(unknown[random() % unknown.size()]);
+    }
+  }
+  return entities;
+}
+
+template <typename Lookup>
+static double timeLookups(const std::vector<std::string>& entities, const int rounds, Lookup lookup, size_t& found) {
+  const auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    for (const std::string& entity : entities) {
+      found += lookup(entity.data(), entity.size()) != nullptr ? 1 : 0;
+    }
+  }
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+         (static_cast<double>(entities.size()) * rounds);
+}
+
+static void benchmark() {
+  printf("benchmark...\n");
+  const std::vector<std::string> entities = workload();
+  constexpr int ROUNDS = 200;
+  size_t foundSearch = 0;
+  size_t foundHash = 0;
+  size_t foundHandler = 0;
+  timeLookups(entities, 5, binarySearchLookup, foundSearch);
+  const double search = timeLookups(entities, ROUNDS, binarySearchLookup, foundSearch);
+  const double hash = timeLookups(entities, ROUNDS, lookupHtmlEntity, foundHash);
+  const double handler = timeLookups(entities, ROUNDS, handlerLookup, foundHandler);
+  ASSERT_EQ(foundSearch / (ROUNDS + 5), foundHash / ROUNDS);
+  ASSERT_EQ(foundHash, foundHandler);
+
+  printf("  %zu lookups, %zu of them found\n", entities.size(), foundHash / ROUNDS);
+  printf("  binary search             %6.2f ns per lookup\n", search);
+  printf("  perfect hash              %6.2f ns per lookup  (%.2fx)\n", hash, search / hash);
+  printf("  common entities, then hash %5.2f ns per lookup  (%.2fx)\n", handler, search / handler);
+  PASS();
+}
+
+int main() {
+  printf("=== HTML Entities Benchmark ===\n\n");
+
+  testEveryKey();
+  testUnknown();
+  testCommonFastPath();
+  benchmark();
+
+  printf("\n=== Results: %d passed, %d failed ===\n", testsPassed, testsFailed);
+  return testsFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,362 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "src/network/HttpConditional.h"
+
+static int testsPassed = 0;
+static int testsFailed = 0;
+
+#define ASSERT_EQ(a, b)                                                                          \
+  do {                                                                                           \
+    if ((a) != (b)) {                                                                            \
+      fprintf(stderr, "  FAIL: %s:%d: %s != %s\n", __FILE__, __LINE__, #a, #b);                  \
+      testsFailed++;                                                                             \
+      return;                                                                                    \
+    }                                                                                            \
+  } while (0)
+
+#define ASSERT_TRUE(cond)                                                \
+  do {                                                                   \
+    if (!(cond)) {                                                       \
+      fprintf(stderr, "  FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testsFailed++;                                                     \
+      return;                                                            \
+    }                                                                    \
+  } while (0)
+
+#define PASS() testsPassed++
+
+// ============================================================================
+// Stand-ins for WebServer request/response and FsFile
+// ============================================================================
+
+struct FakeRequest {
+  std::map<std::string, std::string> headers;
+  std::string header(const char* name) const {
+    const auto it = headers.find(name);
+    return it == headers.end() ? std::string() : it->second;
+  }
+};
+
+struct FakeResponse {
+  std::map<std::string, std::string> headers;
+  int status = 0;
+  size_t contentLength = 0;
+  std::string body;
+  size_t window = 5744;
+  size_t maxWritePerCall = SIZE_MAX;  // Simulate short socket writes
+  size_t failAfterBytes = SIZE_MAX;   // Simulate the client going away
+
+  void sendHeader(const char* name, const char* value) { headers[name] = value; }
+  void send(const int code, const char*, const size_t length) {
+    status = code;
+    contentLength = length;
+  }
+  size_t write(const uint8_t* data, size_t length) {
+    if (body.size() >= failAfterBytes) return 0;
+    if (length > maxWritePerCall) length = maxWritePerCall;
+    body.append(reinterpret_cast<const char*>(data), length);
+    return length;
+  }
+  size_t sendWindow() const { return window; }
+  std::string header(const char* name) const {
+    const auto it = headers.find(name);
+    return it == headers.end() ? std::string() : it->second;
+  }
+};
+
+struct FakeFile {
+  std::string data;
+  size_t pos = 0;
+  std::vector<size_t> readSizes;
+
+  bool seek(const size_t offset) {
+    if (offset > data.size()) return false;
+    pos = offset;
+    return true;
+  }
+  int read(void* buffer, const size_t length) {
+    readSizes.push_back(length);
+    const size_t n = std::min(length, data.size() - pos);
+    memcpy(buffer, data.data() + pos, n);
+    pos += n;
+    return static_cast<int>(n);
+  }
+};
+
+// 2024-03-15 14:30:20
+constexpr uint16_t FAT_DATE = ((2024 - 1980) << 9) | (3 << 5) | 15;
+constexpr uint16_t FAT_TIME = (14 << 11) | (30 << 5) | (20 / 2);
+constexpr const char* LAST_MODIFIED = "Fri, 15 Mar 2024 14:30:20 GMT";
+
+static FakeFile makeFile(const size_t size) {
+  FakeFile file;
+  file.data.reserve(size);
+  for (size_t i = 0; i < size; i++) {
+    file.data.push_back(static_cast<char>('a' + i % 26));
+  }
+  return file;
+}
+
+static HttpConditional::FileInfo infoFor(const FakeFile& file) {
+  return {static_cast<uint32_t>(file.data.size()), FAT_DATE, FAT_TIME};
+}
+
+// Serve `file` for a request with the given headers
+static FakeResponse serve(FakeFile& file, std::map<std::string, std::string> requestHeaders, bool sendBody = true) {
+  FakeRequest request{std::move(requestHeaders)};
+  FakeResponse response;
+  HttpConditional::serveFile(request, response, file, infoFor(file), "application/octet-stream", sendBody);
+  return response;
+}
+
+static std::string etagFor(const FakeFile& file) {
+  char etag[24];
+  HttpConditional::formatEtag(infoFor(file), etag, sizeof(etag));
+  return etag;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void testFullResponse() {
+  printf("testFullResponse...\n");
+  FakeFile file = makeFile(10000);
+  const FakeResponse r = serve(file, {});
+  ASSERT_EQ(r.status, 200);
+  ASSERT_EQ(r.contentLength, 10000u);
+  ASSERT_TRUE(r.body == file.data);
+  ASSERT_TRUE(r.header("Accept-Ranges") == "bytes");
+  ASSERT_TRUE(r.header("ETag") == etagFor(file));
+  ASSERT_TRUE(r.header("Last-Modified") == LAST_MODIFIED);
+  ASSERT_TRUE(r.header("Content-Range").empty());
+  PASS();
+}
+
+void testHttpDate() {
+  printf("testHttpDate...\n");
+  char buf[32];
+  ASSERT_TRUE(HttpConditional::formatHttpDate(FAT_DATE, FAT_TIME, buf, sizeof(buf)));
+  ASSERT_TRUE(strcmp(buf, LAST_MODIFIED) == 0);
+  // 2024-01-01 was a Monday
+  ASSERT_TRUE(HttpConditional::formatHttpDate(((2024 - 1980) << 9) | (1 << 5) | 1, 0, buf, sizeof(buf)));
+  ASSERT_TRUE(strcmp(buf, "Mon, 01 Jan 2024 00:00:00 GMT") == 0);
+  ASSERT_TRUE(!HttpConditional::formatHttpDate(0, 0, buf, sizeof(buf)));
+
+  uint64_t a = 0, b = 0;
+  ASSERT_TRUE(HttpConditional::parseHttpDate("Fri, 15 Mar 2024 14:30:20 GMT", &a));
+  ASSERT_TRUE(HttpConditional::parseHttpDate("Fri, 15 Mar 2024 14:30:21 GMT", &b));
+  ASSERT_TRUE(a < b);
+  ASSERT_TRUE(!HttpConditional::parseHttpDate("yesterday", &a));
+  PASS();
+}
+
+void testClosedRange() {
+  printf("testClosedRange...\n");
+  FakeFile file = makeFile(10000);
+  const FakeResponse r = serve(file, {{"Range", "bytes=100-199"}});
+  ASSERT_EQ(r.status, 206);
+  ASSERT_EQ(r.contentLength, 100u);
+  ASSERT_TRUE(r.body == file.data.substr(100, 100));
+  ASSERT_TRUE(r.header("Content-Range") == "bytes 100-199/10000");
+  PASS();
+}
+
+void testOpenAndSuffixRanges() {
+  printf("testOpenAndSuffixRanges...\n");
+  FakeFile file = makeFile(10000);
+
+  FakeResponse r = serve(file, {{"Range", "bytes=9000-"}});
+  ASSERT_EQ(r.status, 206);
+  ASSERT_TRUE(r.body == file.data.substr(9000));
+  ASSERT_TRUE(r.header("Content-Range") == "bytes 9000-9999/10000");
+
+  r = serve(file, {{"Range", "bytes=-500"}});
+  ASSERT_EQ(r.status, 206);
+  ASSERT_TRUE(r.body == file.data.substr(9500));
+  ASSERT_TRUE(r.header("Content-Range") == "bytes 9500-9999/10000");
+
+  // Suffix longer than the file selects the whole file
+  r = serve(file, {{"Range", "bytes=-20000"}});
+  ASSERT_EQ(r.status, 206);
+  ASSERT_TRUE(r.body == file.data);
+
+  // End past the file is clamped
+  r = serve(file, {{"Range", "bytes=9990-20000"}});
+  ASSERT_EQ(r.status, 206);
+  ASSERT_TRUE(r.header("Content-Range") == "bytes 9990-9999/10000");
+  PASS();
+}
+
+void testUnsatisfiableAndIgnoredRanges() {
+  printf("testUnsatisfiableAndIgnoredRanges...\n");
+  FakeFile file = makeFile(10000);
+
+  FakeResponse r = serve(file, {{"Range", "bytes=10000-"}});
+  ASSERT_EQ(r.status, 416);
+  ASSERT_TRUE(r.body.empty());
+  ASSERT_TRUE(r.header("Content-Range") == "bytes */10000");
+
+  r = serve(file, {{"Range", "bytes=-0"}});
+  ASSERT_EQ(r.status, 416);
+
+  // Multiple ranges, malformed ranges and other units fall back to the full file
+  for (const char* range : {"bytes=0-1,5-6", "bytes=abc", "bytes=50-10", "items=0-5", "bytes=5"}) {
+    r = serve(file, {{"Range", range}});
+    ASSERT_EQ(r.status, 200);
+    ASSERT_TRUE(r.body == file.data);
+  }
+  PASS();
+}
+
+void testIfNoneMatch() {
+  printf("testIfNoneMatch...\n");
+  FakeFile file = makeFile(4000);
+  const std::string etag = etagFor(file);
+
+  FakeResponse r = serve(file, {{"If-None-Match", etag}});
+  ASSERT_EQ(r.status, 304);
+  ASSERT_TRUE(r.body.empty());
+  ASSERT_TRUE(r.header("ETag") == etag);
+
+  r = serve(file, {{"If-None-Match", "\"other\", W/" + etag}});
+  ASSERT_EQ(r.status, 304);
+
+  r = serve(file, {{"If-None-Match", "*"}});
+  ASSERT_EQ(r.status, 304);
+
+  r = serve(file, {{"If-None-Match", "\"other\""}});
+  ASSERT_EQ(r.status, 200);
+  ASSERT_TRUE(r.body == file.data);
+
+  // A changed file (different size) no longer matches
+  FakeFile changed = makeFile(4001);
+  r = serve(changed, {{"If-None-Match", etag}});
+  ASSERT_EQ(r.status, 200);
+  PASS();
+}
+
+void testIfModifiedSince() {
+  printf("testIfModifiedSince...\n");
+  FakeFile file = makeFile(4000);
+
+  FakeResponse r = serve(file, {{"If-Modified-Since", LAST_MODIFIED}});
+  ASSERT_EQ(r.status, 304);
+
+  r = serve(file, {{"If-Modified-Since", "Sat, 16 Mar 2024 00:00:00 GMT"}});
+  ASSERT_EQ(r.status, 304);
+
+  r = serve(file, {{"If-Modified-Since", "Fri, 15 Mar 2024 14:30:18 GMT"}});
+  ASSERT_EQ(r.status, 200);
+
+  // If-None-Match takes precedence over If-Modified-Since
+  r = serve(file, {{"If-None-Match", "\"other\""}, {"If-Modified-Since", LAST_MODIFIED}});
+  ASSERT_EQ(r.status, 200);
+
+  // Without a timestamp If-Modified-Since is ignored and no Last-Modified is sent
+  FakeRequest request{{{"If-Modified-Since", LAST_MODIFIED}}};
+  FakeResponse response;
+  HttpConditional::serveFile(request, response, file, {4000, 0, 0}, "text/plain");
+  ASSERT_EQ(response.status, 200);
+  ASSERT_TRUE(response.header("Last-Modified").empty());
+  PASS();
+}
+
+void testIfRange() {
+  printf("testIfRange...\n");
+  FakeFile file = makeFile(10000);
+  const std::string etag = etagFor(file);
+
+  FakeResponse r = serve(file, {{"Range", "bytes=5000-"}, {"If-Range", etag}});
+  ASSERT_EQ(r.status, 206);
+  ASSERT_EQ(r.body.size(), 5000u);
+
+  r = serve(file, {{"Range", "bytes=5000-"}, {"If-Range", LAST_MODIFIED}});
+  ASSERT_EQ(r.status, 206);
+
+  // Stale validator: resend everything
+  r = serve(file, {{"Range", "bytes=5000-"}, {"If-Range", "\"stale\""}});
+  ASSERT_EQ(r.status, 200);
+  ASSERT_TRUE(r.body == file.data);
+
+  // Weak tags never satisfy If-Range
+  r = serve(file, {{"Range", "bytes=5000-"}, {"If-Range", "W/" + etag}});
+  ASSERT_EQ(r.status, 200);
+  PASS();
+}
+
+void testHeadRequest() {
+  printf("testHeadRequest...\n");
+  FakeFile file = makeFile(10000);
+  FakeResponse r = serve(file, {}, false);
+  ASSERT_EQ(r.status, 200);
+  ASSERT_EQ(r.contentLength, 10000u);
+  ASSERT_TRUE(r.body.empty());
+  ASSERT_TRUE(file.readSizes.empty());
+
+  r = serve(file, {{"Range", "bytes=0-9"}}, false);
+  ASSERT_EQ(r.status, 206);
+  ASSERT_EQ(r.contentLength, 10u);
+  ASSERT_TRUE(r.body.empty());
+  PASS();
+}
+
+void testChunkSizing() {
+  printf("testChunkSizing...\n");
+  ASSERT_EQ(HttpConditional::chunkSizeForWindow(5744), 5632u);
+  ASSERT_EQ(HttpConditional::chunkSizeForWindow(100), HttpConditional::MIN_CHUNK_SIZE);
+  ASSERT_EQ(HttpConditional::chunkSizeForWindow(1 << 20), HttpConditional::MAX_CHUNK_SIZE);
+
+  // Reads follow the send window rather than a fixed 4KB
+  FakeFile file = makeFile(20000);
+  FakeRequest request;
+  FakeResponse response;
+  response.window = 8192;
+  HttpConditional::serveFile(request, response, file, infoFor(file), "text/plain");
+  ASSERT_TRUE(response.body == file.data);
+  ASSERT_EQ(file.readSizes.size(), 3u);
+  ASSERT_EQ(file.readSizes[0], 8192u);
+  ASSERT_EQ(file.readSizes[2], 20000u - 2 * 8192u);
+  PASS();
+}
+
+void testShortWritesAndDisconnect() {
+  printf("testShortWritesAndDisconnect...\n");
+  FakeFile file = makeFile(10000);
+  FakeRequest request;
+  FakeResponse response;
+  response.maxWritePerCall = 700;
+  ASSERT_TRUE(HttpConditional::serveFile(request, response, file, infoFor(file), "text/plain"));
+  ASSERT_TRUE(response.body == file.data);
+
+  FakeResponse dropped;
+  dropped.failAfterBytes = 3000;
+  ASSERT_TRUE(!HttpConditional::serveFile(request, dropped, file, infoFor(file), "text/plain"));
+  ASSERT_TRUE(dropped.body.size() < file.data.size());
+  PASS();
+}
+
+int main() {
+  printf("=== HTTP Conditional/Range Tests ===\n\n");
+
+  testFullResponse();
+  testHttpDate();
+  testClosedRange();
+  testOpenAndSuffixRanges();
+  testUnsatisfiableAndIgnoredRanges();
+  testIfNoneMatch();
+  testIfModifiedSince();
+  testIfRange();
+  testHeadRequest();
+  testChunkSizing();
+  testShortWritesAndDisconnect();
+
+  printf("\n=== Results: %d passed, %d failed ===\n", testsPassed, testsFailed);
+  return testsFailed > 0 ? 1 : 0;
+}
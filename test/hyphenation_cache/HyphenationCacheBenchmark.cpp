@@ -0,0 +1,329 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "lib/Epub/Epub/hyphenation/HyphenationCache.h"
+#include "lib/Epub/Epub/hyphenation/Hyphenator.h"
+#include "lib/Epub/Epub/hyphenation/LanguageRegistry.h"
+#include "test/hyphenation_pack/TestPackLoader.h"
+
+static int testsPassed = 0;
+static int testsFailed = 0;
+
+#define ASSERT_EQ(a, b)                                                         \
+  do {                                                                          \
+    if ((a) != (b)) {                                                           \
+      fprintf(stderr, "  FAIL: %s:%d: %s != %s\n", __FILE__, __LINE__, #a, #b); \
+      testsFailed++;                                                            \
+      return;                                                                   \
+    }                                                                           \
+  } while (0)
+
+#define ASSERT_TRUE(cond)                                                \
+  do {                                                                   \
+    if (!(cond)) {                                                       \
+      fprintf(stderr, "  FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testsFailed++;                                                     \
+      return;                                                            \
+    }                                                                    \
+  } while (0)
+
+#define PASS() testsPassed++
+
+using BreakInfo = Hyphenator::BreakInfo;
+
+static bool sameBreaks(const BreakInfo* a, const size_t count, const std::vector<BreakInfo>& b) {
+  if (count != b.size()) return false;
+  for (size_t i = 0; i < count; i++) {
+    if (a[i].byteOffset != b[i].byteOffset || a[i].requiresInsertedHyphen != b[i].requiresInsertedHyphen) return false;
+  }
+  return true;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void testLookupAndStore() {
+  printf("testLookupAndStore...\n");
+  HyphenationCache cache;
+  ASSERT_TRUE(HyphenationCache::active() == &cache);
+
+  const std::vector<BreakInfo> breaks = {{2, true}, {5, false}, {9, true}};
+  const uint64_t key = HyphenationCache::keyFor("Donaudampfschiff", false, nullptr);
+  BreakInfo out[Hyphenator::MAX_WORD_CODEPOINTS];
+  size_t count = 0;
+  ASSERT_TRUE(!cache.lookup(key, out, Hyphenator::MAX_WORD_CODEPOINTS, count));
+  cache.store(key, "Donaudampfschiff", breaks.data(), breaks.size());
+  ASSERT_TRUE(cache.lookup(key, out, Hyphenator::MAX_WORD_CODEPOINTS, count));
+  ASSERT_TRUE(sameBreaks(out, count, breaks));
+
+  // An empty result is a result too
+  const uint64_t shortKey = HyphenationCache::keyFor("ja", false, nullptr);
+  cache.store(shortKey, "ja", nullptr, 0);
+  ASSERT_TRUE(cache.lookup(shortKey, out, Hyphenator::MAX_WORD_CODEPOINTS, count));
+  ASSERT_EQ(count, 0u);
+
+  ASSERT_EQ(cache.getStats().lookups, 3u);
+  ASSERT_EQ(cache.getStats().hits, 2u);
+  PASS();
+}
+
+void testKeysSeparateFallbackAndLanguage() {
+  printf("testKeysSeparateFallbackAndLanguage...\n");
+  static const int languageA = 0;
+  static const int languageB = 0;
+  const uint64_t base = HyphenationCache::keyFor("Wort", false, &languageA);
+  ASSERT_TRUE(base != 0);
+  ASSERT_TRUE(base != HyphenationCache::keyFor("Wort", true, &languageA));
+  ASSERT_TRUE(base != HyphenationCache::keyFor("Wort", false, &languageB));
+  ASSERT_TRUE(base != HyphenationCache::keyFor("Worte", false, &languageA));
+  ASSERT_EQ(base, HyphenationCache::keyFor("Wort", false, &languageA));
+  PASS();
+}
+
+void testUncacheable() {
+  printf("testUncacheable...\n");
+  HyphenationCache cache;
+  std::vector<BreakInfo> many;
+  for (size_t i = 1; i <= HyphenationCache::MAX_BREAKS + 1; i++) many.push_back({i * 2, true});
+  const std::string longWord(40, 'a');
+  const uint64_t key = HyphenationCache::keyFor(longWord, false, nullptr);
+  cache.store(key, longWord, many.data(), many.size());
+  BreakInfo out[Hyphenator::MAX_WORD_CODEPOINTS];
+  size_t count = 0;
+  ASSERT_TRUE(!cache.lookup(key, out, Hyphenator::MAX_WORD_CODEPOINTS, count));
+
+  const std::string hugeWord(300, 'a');
+  const uint64_t hugeKey = HyphenationCache::keyFor(hugeWord, false, nullptr);
+  const BreakInfo hugeBreak = {200, true};
+  cache.store(hugeKey, hugeWord, &hugeBreak, 1);
+  ASSERT_TRUE(!cache.lookup(hugeKey, out, Hyphenator::MAX_WORD_CODEPOINTS, count));
+  ASSERT_EQ(cache.getStats().uncacheable, 2u);
+
+  many.pop_back();
+  cache.store(key, longWord, many.data(), many.size());
+  ASSERT_TRUE(cache.lookup(key, out, Hyphenator::MAX_WORD_CODEPOINTS, count));
+  ASSERT_TRUE(sameBreaks(out, count, many));
+
+  // A smaller buffer gets the first breaks
+  ASSERT_TRUE(cache.lookup(key, out, 2, count));
+  ASSERT_EQ(count, 2u);
+  ASSERT_EQ(out[1].byteOffset, many[1].byteOffset);
+  PASS();
+}
+
+void testEvictsLeastRecentlyUsed() {
+  printf("testEvictsLeastRecentlyUsed...\n");
+  HyphenationCache cache;
+  // Three keys in the same set of a two-way table
+  const uint64_t a = 5;
+  const uint64_t b = a + HyphenationCache::SETS;
+  const uint64_t c = b + HyphenationCache::SETS;
+  const BreakInfo breaks[] = {{1, true}, {2, true}, {3, true}};
+  BreakInfo out[Hyphenator::MAX_WORD_CODEPOINTS];
+  size_t count = 0;
+
+  cache.store(a, "a", &breaks[0], 1);
+  cache.store(b, "b", &breaks[1], 1);
+  ASSERT_TRUE(cache.lookup(a, out, Hyphenator::MAX_WORD_CODEPOINTS, count));  // a is now the most recently used
+  cache.store(c, "c", &breaks[2], 1);                                // evicts b
+  ASSERT_TRUE(cache.lookup(a, out, Hyphenator::MAX_WORD_CODEPOINTS, count));
+  ASSERT_EQ(out[0].byteOffset, 1u);
+  ASSERT_TRUE(cache.lookup(c, out, Hyphenator::MAX_WORD_CODEPOINTS, count));
+  ASSERT_EQ(out[0].byteOffset, 3u);
+  ASSERT_TRUE(!cache.lookup(b, out, Hyphenator::MAX_WORD_CODEPOINTS, count));
+  PASS();
+}
+
+void testOnlyOneActive() {
+  printf("testOnlyOneActive...\n");
+  ASSERT_TRUE(HyphenationCache::active() == nullptr);
+  {
+    HyphenationCache cache;
+    ASSERT_TRUE(HyphenationCache::active() == &cache);
+  }
+  ASSERT_TRUE(HyphenationCache::active() == nullptr);
+  PASS();
+}
+
+// ============================================================================
+// Benchmark: greedy line filling as in ParsedText, on the German evaluation corpus
+// ============================================================================
+
+constexpr int LINE_WIDTH = 34;  // In characters: a portrait page at a medium font size
+
+static int measure(const std::string& text, const bool withHyphen, int& measurements) {
+  measurements++;
+  int width = 0;
+  for (const char c : text) {
+    width += (static_cast<uint8_t>(c) & 0xC0) != 0x80;
+  }
+  return width + (withHyphen ? 1 : 0);
+}
+
+struct LayoutResult {
+  uint64_t checksum = 1469598103934665603ULL;
+  int lines = 0;
+  int hyphenations = 0;
+  int measurements = 0;
+  double ms = 0;
+};
+
+// Before: measure every break and keep the widest prefix that fits
+static int widestPrefixForward(const std::string& word, const std::vector<BreakInfo>& breaks, const int available,
+                               bool& needsHyphen, int& measurements) {
+  int chosenWidth = -1;
+  size_t chosenOffset = 0;
+  for (const auto& info : breaks) {
+    if (info.byteOffset == 0 || info.byteOffset >= word.size()) continue;
+    const int width = measure(word.substr(0, info.byteOffset), info.requiresInsertedHyphen, measurements);
+    if (width > available || width <= chosenWidth) continue;
+    chosenWidth = width;
+    chosenOffset = info.byteOffset;
+    needsHyphen = info.requiresInsertedHyphen;
+  }
+  return chosenWidth < 0 ? -1 : static_cast<int>(chosenOffset);
+}
+
+// After: the last break that fits is the widest
+static int widestPrefixReverse(const std::string& word, const std::vector<BreakInfo>& breaks, const int available,
+                               bool& needsHyphen, int& measurements) {
+  for (auto it = breaks.rbegin(); it != breaks.rend(); ++it) {
+    if (it->byteOffset == 0 || it->byteOffset >= word.size()) continue;
+    if (measure(word.substr(0, it->byteOffset), it->requiresInsertedHyphen, measurements) > available) continue;
+    needsHyphen = it->requiresInsertedHyphen;
+    return static_cast<int>(it->byteOffset);
+  }
+  return -1;
+}
+
+static LayoutResult layOut(const std::vector<std::string>& words, const bool reverseScan) {
+  LayoutResult result;
+  const auto mix = [&result](const uint64_t value) { result.checksum = (result.checksum ^ value) * 1099511628211ULL; };
+  const auto start = std::chrono::steady_clock::now();
+
+  int lineWidth = 0;
+  for (const std::string& original : words) {
+    std::string word = original;
+    while (true) {
+      const int gap = lineWidth > 0 ? 1 : 0;
+      const int width = measure(word, false, result.measurements);
+      if (lineWidth + gap + width <= LINE_WIDTH) {
+        lineWidth += gap + width;
+        break;
+      }
+      const int available = LINE_WIDTH - lineWidth - gap;
+      const auto breaks = Hyphenator::breakOffsets(word, false);
+      bool needsHyphen = false;
+      const int offset = reverseScan ? widestPrefixReverse(word, breaks, available, needsHyphen, result.measurements)
+                                     : widestPrefixForward(word, breaks, available, needsHyphen, result.measurements);
+      if (offset > 0) {
+        mix(static_cast<uint64_t>(offset) * 2 + needsHyphen);
+        result.hyphenations++;
+        word = word.substr(offset);
+      } else if (lineWidth == 0) {
+        break;  // Overlong word on its own line
+      }
+      mix(static_cast<uint64_t>(result.lines));
+      result.lines++;
+      lineWidth = 0;
+    }
+  }
+  result.lines++;
+  result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return result;
+}
+
+static std::vector<std::string> loadWordStream(const std::string& path) {
+  std::vector<std::string> words;
+  std::ifstream file(path);
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#') continue;
+    std::istringstream fields(line);
+    std::string word, hyphenated, frequency;
+    if (!std::getline(fields, word, '|') || !std::getline(fields, hyphenated, '|') ||
+        !std::getline(fields, frequency)) {
+      continue;
+    }
+    const int count = std::max(1, std::atoi(frequency.c_str()));
+    for (int i = 0; i < count; i++) words.push_back(word);
+  }
+  std::mt19937 rng(42);
+  std::shuffle(words.begin(), words.end(), rng);
+  return words;
+}
+
+void benchmarkSectionLayout(const std::string& corpusPath) {
+  printf("benchmarkSectionLayout...\n");
+  const auto words = loadWordStream(corpusPath);
+  ASSERT_TRUE(!words.empty());
+  Hyphenator::setPreferredLanguage("de");
+
+  // Sections of about 5000 words, each with its own cache as in Section::createSectionFile
+  constexpr size_t SECTION_WORDS = 5000;
+  const auto forEachSection = [&words](auto&& fn) {
+    for (size_t begin = 0; begin < words.size(); begin += SECTION_WORDS) {
+      const auto end = words.begin() + static_cast<std::ptrdiff_t>(std::min(words.size(), begin + SECTION_WORDS));
+      fn(std::vector<std::string>(words.begin() + static_cast<std::ptrdiff_t>(begin), end));
+    }
+  };
+
+  LayoutResult before, cacheOnly, after;
+  HyphenationCache::Stats stats;
+  forEachSection([&](const std::vector<std::string>& section) {
+    const auto add = [](LayoutResult& total, const LayoutResult& part) {
+      total.checksum = (total.checksum ^ part.checksum) * 1099511628211ULL;
+      total.lines += part.lines;
+      total.hyphenations += part.hyphenations;
+      total.measurements += part.measurements;
+      total.ms += part.ms;
+    };
+    add(before, layOut(section, false));
+    {
+      HyphenationCache cache;
+      add(cacheOnly, layOut(section, false));
+    }
+    HyphenationCache cache;
+    add(after, layOut(section, true));
+    stats.lookups += cache.getStats().lookups;
+    stats.hits += cache.getStats().hits;
+    stats.uncacheable += cache.getStats().uncacheable;
+  });
+
+  ASSERT_EQ(cacheOnly.checksum, before.checksum);
+  ASSERT_EQ(after.checksum, before.checksum);
+  ASSERT_EQ(after.lines, before.lines);
+
+  printf("  %zu words, %d lines, %d hyphenated line ends\n", words.size(), before.lines, before.hyphenations);
+  printf("  no cache, forward scan   %8.2f ms  %7d measurements\n", before.ms, before.measurements);
+  printf("  cache, forward scan      %8.2f ms  (%.1fx)\n", cacheOnly.ms,
+         cacheOnly.ms > 0 ? before.ms / cacheOnly.ms : 0.0);
+  printf("  cache, reverse scan      %8.2f ms  %7d measurements  (%.1fx)\n", after.ms, after.measurements,
+         after.ms > 0 ? before.ms / after.ms : 0.0);
+  printf("  cache: %u lookups, %u hits (%u%%), %u uncacheable\n", stats.lookups, stats.hits,
+         stats.lookups ? stats.hits * 100 / stats.lookups : 0, stats.uncacheable);
+  PASS();
+}
+
+int main(int argc, char* argv[]) {
+  printf("=== Hyphenation Cache Tests ===\n\n");
+  setHyphenationPackLoader(loadTestHyphenationPack);
+
+  testLookupAndStore();
+  testKeysSeparateFallbackAndLanguage();
+  testUncacheable();
+  testEvictsLeastRecentlyUsed();
+  testOnlyOneActive();
+  benchmarkSectionLayout(argc > 1 ? argv[1] : "test/hyphenation_eval/resources/german_hyphenation_tests.txt");
+
+  printf("\n=== Results: %d passed, %d failed ===\n", testsPassed, testsFailed);
+  return testsFailed > 0 ? 1 : 0;
+}
@@ -13,6 +13,7 @@
 #include "lib/Epub/Epub/hyphenation/HyphenationCommon.h"
 #include "lib/Epub/Epub/hyphenation/LanguageHyphenator.h"
 #include "lib/Epub/Epub/hyphenation/LanguageRegistry.h"
+#include "test/hyphenation_pack/TestPackLoader.h"
 
 struct TestCase {
   std::string word;
@@ -305,6 +306,7 @@ void printResults(const std::string& language, const std::vector<TestCase>& test
 int main(int argc, char* argv[]) {
   const bool summaryMode = argc <= 1;
   const std::string languageSelection = summaryMode ? "all" : argv[1];
+  setHyphenationPackLoader(loadTestHyphenationPack);
 
   std::vector<LanguageConfig> languages = resolveLanguages(languageSelection);
   if (languages.empty()) {
@@ -0,0 +1,294 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "lib/Epub/Epub/hyphenation/HyphenationCommon.h"
+#include "lib/Epub/Epub/hyphenation/HyphenationPack.h"
+#include "lib/Epub/Epub/hyphenation/LanguageHyphenator.h"
+#include "lib/Epub/Epub/hyphenation/LanguageRegistry.h"
+#include "lib/Epub/Epub/hyphenation/generated/hyph-de.trie.h"
+#include "lib/Epub/Epub/hyphenation/generated/hyph-en.trie.h"
+#include "lib/Epub/Epub/hyphenation/generated/hyph-es.trie.h"
+#include "lib/Epub/Epub/hyphenation/generated/hyph-fr.trie.h"
+#include "lib/Epub/Epub/hyphenation/generated/hyph-it.trie.h"
+#include "lib/Epub/Epub/hyphenation/generated/hyph-ru.trie.h"
+#include "lib/Epub/Epub/hyphenation/generated/hyph-uk.trie.h"
+#include "test/hyphenation_pack/TestPackLoader.h"
+
+static int testsPassed = 0;
+static int testsFailed = 0;
+
+#define ASSERT_EQ(a, b)                                                         \
+  do {                                                                          \
+    if ((a) != (b)) {                                                           \
+      fprintf(stderr, "  FAIL: %s:%d: %s != %s\n", __FILE__, __LINE__, #a, #b); \
+      testsFailed++;                                                            \
+      return;                                                                   \
+    }                                                                           \
+  } while (0)
+
+#define ASSERT_TRUE(cond)                                                \
+  do {                                                                   \
+    if (!(cond)) {                                                       \
+      fprintf(stderr, "  FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testsFailed++;                                                     \
+      return;                                                            \
+    }                                                                    \
+  } while (0)
+
+#define PASS() testsPassed++
+
+struct Language {
+  const char* name;
+  const char* tag;
+  const char* file;  // Ukrainian has no corpus of its own; the Russian words exercise the same Cyrillic walk
+  const SerializedHyphenationPatterns& builtIn;
+  bool (*isLetter)(uint32_t);
+  uint32_t (*toLower)(uint32_t);
+  size_t minPrefix;
+  std::vector<std::vector<CodepointInfo>> words;
+};
+
+static std::vector<Language> languages = {
+    {"english", "en", "english_hyphenation_tests.txt", en_patterns, isLatinLetter, toLowerLatin, 3, {}},
+    {"french", "fr", "french_hyphenation_tests.txt", fr_patterns, isLatinLetter, toLowerLatin, 2, {}},
+    {"german", "de", "german_hyphenation_tests.txt", de_patterns, isLatinLetter, toLowerLatin, 2, {}},
+    {"russian", "ru", "russian_hyphenation_tests.txt", ru_patterns, isCyrillicLetter, toLowerCyrillic, 2, {}},
+    {"spanish", "es", "spanish_hyphenation_tests.txt", es_patterns, isLatinLetter, toLowerLatin, 2, {}},
+    {"italian", "it", "italian_hyphenation_tests.txt", it_patterns, isLatinLetter, toLowerLatin, 2, {}},
+    {"ukrainian", "uk", "russian_hyphenation_tests.txt", uk_patterns, isCyrillicLetter, toLowerCyrillic, 2, {}},
+};
+
+// The HyphenationEvaluationTest corpus, `word|hyphenated|frequency` lines, as trimmed codepoints
+static bool loadWords(const std::string& resourceDir) {
+  for (Language& lang : languages) {
+    std::ifstream file(resourceDir + "/" + lang.file);
+    std::string line;
+    while (std::getline(file, line)) {
+      if (line.empty() || line[0] == '#') continue;
+      const size_t bar = line.find('|');
+      if (bar == std::string::npos || bar == 0) continue;
+      lang.words.push_back(collectCodepoints(line.substr(0, bar)));
+      trimSurroundingPunctuationAndFootnote(lang.words.back());
+    }
+    if (lang.words.empty()) {
+      fprintf(stderr, "No words in %s/%s\n", resourceDir.c_str(), lang.file);
+      return false;
+    }
+  }
+  return true;
+}
+
+static std::vector<uint8_t> packFor(const Language& lang) {
+  return readPackFile(hyphenationPackDir() + "/hyph-" + lang.tag + ".pack");
+}
+
+static int loaderCalls = 0;
+
+static const uint8_t* countingLoader(const char* primaryTag, size_t& size) {
+  loaderCalls++;
+  return loadTestHyphenationPack(primaryTag, size);
+}
+
+static const uint8_t* missingLoader(const char*, size_t&) { return nullptr; }
+
+static double elapsedMs(const std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void testPackMatchesBuiltIn() {
+  printf("testPackMatchesBuiltIn...\n");
+  constexpr size_t CAPACITY = 72;
+  size_t expected[CAPACITY];
+  size_t actual[CAPACITY];
+  for (const Language& lang : languages) {
+    const std::vector<uint8_t> image = packFor(lang);
+    SerializedHyphenationPatterns packed{0, nullptr, 0};
+    ASSERT_TRUE(HyphenationPack::parse(image.data(), image.size(), packed));
+    ASSERT_EQ(packed.size, lang.builtIn.size);
+    ASSERT_EQ(packed.rootOffset, lang.builtIn.rootOffset);
+
+    const LanguageHyphenator builtIn(lang.builtIn, lang.isLetter, lang.toLower, lang.minPrefix, lang.minPrefix);
+    const LanguageHyphenator fromPack(packed, lang.isLetter, lang.toLower, lang.minPrefix, lang.minPrefix);
+    size_t breaks = 0;
+    for (const auto& cps : lang.words) {
+      const size_t count = builtIn.breakIndexes(cps.data(), cps.size(), expected, CAPACITY);
+      if (fromPack.breakIndexes(cps.data(), cps.size(), actual, CAPACITY) != count ||
+          !std::equal(expected, expected + count, actual)) {
+        fprintf(stderr, "  %s: a word of %zu codepoints differs\n", lang.name, cps.size());
+        testsFailed++;
+        return;
+      }
+      breaks += count;
+    }
+    printf("  %-9s %5zu words, %6zu breaks identical (%zu byte pack)\n", lang.name, lang.words.size(), breaks,
+           image.size());
+  }
+  PASS();
+}
+
+void testRegistryMatchesBuiltIn() {
+  printf("testRegistryMatchesBuiltIn...\n");
+  setHyphenationPackLoader(loadTestHyphenationPack);
+  for (const Language& lang : languages) {
+    const LanguageHyphenator* registered = getLanguageHyphenatorForPrimaryTag(lang.tag);
+    ASSERT_TRUE(registered != nullptr);
+    const LanguageHyphenator builtIn(lang.builtIn, lang.isLetter, lang.toLower, registered->minPrefix(),
+                                     registered->minSuffix());
+    for (const auto& cps : lang.words) {
+      if (registered->breakIndexes(cps) != builtIn.breakIndexes(cps)) {
+        fprintf(stderr, "  %s: registry differs from the built-in patterns\n", lang.name);
+        testsFailed++;
+        return;
+      }
+    }
+  }
+  PASS();
+}
+
+void testLoadsOnDemand() {
+  printf("testLoadsOnDemand...\n");
+  setHyphenationPackLoader(countingLoader);
+  loaderCalls = 0;
+  const auto word = collectCodepoints("Silbentrennung");
+
+  // English is built in
+  ASSERT_TRUE(getLanguageHyphenatorForPrimaryTag("en") != nullptr);
+  ASSERT_EQ(loaderCalls, 0);
+
+  // Loaded once, then reused
+  const LanguageHyphenator* german = getLanguageHyphenatorForPrimaryTag("de");
+  ASSERT_TRUE(german != nullptr);
+  ASSERT_TRUE(getLanguageHyphenatorForPrimaryTag("de") == german);
+  ASSERT_EQ(loaderCalls, 1);
+  const auto breaks = german->breakIndexes(word);
+  ASSERT_TRUE(!breaks.empty());
+
+  // Another language replaces it; German has no patterns until it is requested again
+  ASSERT_TRUE(getLanguageHyphenatorForPrimaryTag("fr") != nullptr);
+  ASSERT_EQ(loaderCalls, 2);
+  ASSERT_TRUE(german->breakIndexes(word).empty());
+  ASSERT_TRUE(getLanguageHyphenatorForPrimaryTag("de") == german);
+  ASSERT_EQ(loaderCalls, 3);
+  ASSERT_TRUE(german->breakIndexes(word) == breaks);
+
+  // Unknown languages never reach the loader
+  ASSERT_TRUE(getLanguageHyphenatorForPrimaryTag("xx") == nullptr);
+  ASSERT_EQ(loaderCalls, 3);
+  PASS();
+}
+
+void testMissingPack() {
+  printf("testMissingPack...\n");
+  setHyphenationPackLoader(missingLoader);
+  ASSERT_TRUE(getLanguageHyphenatorForPrimaryTag("de") == nullptr);
+  ASSERT_TRUE(getLanguageHyphenatorForPrimaryTag("en") != nullptr);
+  setHyphenationPackLoader(nullptr);
+  ASSERT_TRUE(getLanguageHyphenatorForPrimaryTag("fr") == nullptr);
+  PASS();
+}
+
+void testRejectsDamagedPacks() {
+  printf("testRejectsDamagedPacks...\n");
+  const std::vector<uint8_t> good = packFor(languages[1]);
+  SerializedHyphenationPatterns patterns{0, nullptr, 0};
+  ASSERT_TRUE(HyphenationPack::parse(good.data(), good.size(), patterns));
+
+  const auto rejects = [](std::vector<uint8_t> image) {
+    SerializedHyphenationPatterns untouched{0, nullptr, 0};
+    return !HyphenationPack::parse(image.data(), image.size(), untouched) && untouched.data == nullptr;
+  };
+  std::vector<uint8_t> image = good;
+  image[0] = 'X';
+  ASSERT_TRUE(rejects(image));  // Magic
+
+  image = good;
+  image[4] = 2;
+  ASSERT_TRUE(rejects(image));  // Version
+
+  ASSERT_TRUE(rejects(std::vector<uint8_t>(good.begin(), good.end() - 1)));  // Truncated copy
+  ASSERT_TRUE(rejects(std::vector<uint8_t>(good.begin(), good.begin() + HyphenationPack::HEADER_SIZE)));
+  ASSERT_TRUE(rejects(std::vector<uint8_t>(good.begin(), good.begin() + 3)));
+
+  image = good;
+  image.push_back(0);
+  ASSERT_TRUE(rejects(image));  // Trailing bytes
+
+  image = good;
+  image[HyphenationPack::HEADER_SIZE + patterns.size] = good[5];
+  ASSERT_TRUE(rejects(image));  // Dispatch slot past the last table
+
+  image = good;
+  image[8] = image[12];
+  image[9] = image[13];
+  image[10] = image[14];
+  image[11] = image[15];
+  ASSERT_TRUE(rejects(image));  // Root outside the trie
+
+  ASSERT_TRUE(!HyphenationPack::parse(nullptr, 0, patterns));
+  PASS();
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+
+void benchmarkPackVsBuiltIn() {
+  printf("benchmarkPackVsBuiltIn...\n");
+  constexpr int ROUNDS = 5;
+  constexpr size_t CAPACITY = 72;
+  size_t indexes[CAPACITY];
+  size_t checksum = 0;
+  size_t packBytes = 0;
+  printf("  %-9s %13s %13s\n", "", "built-in", "pack");
+  for (const Language& lang : languages) {
+    const std::vector<uint8_t> image = packFor(lang);
+    SerializedHyphenationPatterns packed{0, nullptr, 0};
+    ASSERT_TRUE(HyphenationPack::parse(image.data(), image.size(), packed));
+    if (lang.builtIn.data != en_patterns.data) packBytes += image.size();
+
+    const LanguageHyphenator builtIn(lang.builtIn, lang.isLetter, lang.toLower, lang.minPrefix, lang.minPrefix);
+    const LanguageHyphenator fromPack(packed, lang.isLetter, lang.toLower, lang.minPrefix, lang.minPrefix);
+    double ms[2] = {};
+    for (int variant = 0; variant < 2; variant++) {
+      const LanguageHyphenator& hyphenator = variant == 0 ? builtIn : fromPack;
+      const auto start = std::chrono::steady_clock::now();
+      for (int r = 0; r < ROUNDS; r++) {
+        for (const auto& cps : lang.words) {
+          checksum += hyphenator.breakIndexes(cps.data(), cps.size(), indexes, CAPACITY);
+        }
+      }
+      ms[variant] = elapsedMs(start);
+    }
+    const double count = static_cast<double>(lang.words.size()) * ROUNDS;
+    const auto perSecond = [count](const double elapsed) { return elapsed > 0 ? count * 1000.0 / elapsed : 0.0; };
+    printf("  %-9s %11.0f/s %11.0f/s\n", lang.name, perSecond(ms[0]), perSecond(ms[1]));
+  }
+  printf("  %zu bytes of patterns moved from the firmware image to packs, checksum %zu\n", packBytes, checksum);
+  PASS();
+}
+
+int main(int argc, char* argv[]) {
+  printf("=== Hyphenation Pack Tests ===\n\n");
+  if (!loadWords(argc > 1 ? argv[1] : "test/hyphenation_eval/resources")) {
+    return 1;
+  }
+
+  testPackMatchesBuiltIn();
+  testRegistryMatchesBuiltIn();
+  testLoadsOnDemand();
+  testMissingPack();
+  testRejectsDamagedPacks();
+  benchmarkPackVsBuiltIn();
+
+  printf("\n=== Results: %d passed, %d failed ===\n", testsPassed, testsFailed);
+  return testsFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Directory the run_*.sh scripts build packs into (build_packs.sh), passed in HYPHENATION_PACK_DIR
+inline std::string hyphenationPackDir() {
+  const char* dir = getenv("HYPHENATION_PACK_DIR");
+  return dir ? dir : "build/hyphenation_packs";
+}
+
+inline std::vector<uint8_t> readPackFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Host stand-in for HyphenationPackStore::load(): the pack is read into memory rather than mapped from flash, and like
+// the device's mapping it is replaced by the next call.
+inline const uint8_t* loadTestHyphenationPack(const char* primaryTag, size_t& size) {
+  static std::vector<uint8_t> image;
+  image = readPackFile(hyphenationPackDir() + "/hyph-" + primaryTag + ".pack");
+  size = image.size();
+  return image.empty() ? nullptr : image.data();
+}
@@ -0,0 +1,14 @@
+#!/usr/bin/env bash
+# Builds hyph-<tag>.pack for every language from the generated headers (English is built in, its pack is for tests).
+# Usage: build_packs.sh <output dir>
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/../.." && pwd)"
+PACK_DIR="$1"
+
+ARGS=()
+for lang in de en es fr it ru uk; do
+  ARGS+=(--input "$ROOT_DIR/lib/Epub/Epub/hyphenation/generated/hyph-${lang}.trie.h")
+  ARGS+=(--pack "$PACK_DIR/hyph-${lang}.pack")
+done
+python3 "$ROOT_DIR/scripts/generate_hyphenation_trie.py" "${ARGS[@]}" >/dev/null
@@ -0,0 +1,292 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "lib/Epub/Epub/hyphenation/HyphenationCommon.h"
+#include "lib/Epub/Epub/hyphenation/Hyphenator.h"
+#include "lib/Epub/Epub/hyphenation/LanguageHyphenator.h"
+#include "lib/Epub/Epub/hyphenation/LanguageRegistry.h"
+#include "lib/Epub/Epub/hyphenation/generated/hyph-de.trie.h"
+#include "lib/Epub/Epub/hyphenation/generated/hyph-en.trie.h"
+#include "lib/Epub/Epub/hyphenation/generated/hyph-es.trie.h"
+#include "lib/Epub/Epub/hyphenation/generated/hyph-fr.trie.h"
+#include "lib/Epub/Epub/hyphenation/generated/hyph-it.trie.h"
+#include "lib/Epub/Epub/hyphenation/generated/hyph-ru.trie.h"
+#include "test/hyphenation_pack/TestPackLoader.h"
+
+static int testsPassed = 0;
+static int testsFailed = 0;
+
+#define ASSERT_EQ(a, b)                                                         \
+  do {                                                                          \
+    if ((a) != (b)) {                                                           \
+      fprintf(stderr, "  FAIL: %s:%d: %s != %s\n", __FILE__, __LINE__, #a, #b); \
+      testsFailed++;                                                            \
+      return;                                                                   \
+    }                                                                           \
+  } while (0)
+
+#define ASSERT_TRUE(cond)                                                \
+  do {                                                                   \
+    if (!(cond)) {                                                       \
+      fprintf(stderr, "  FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testsFailed++;                                                     \
+      return;                                                            \
+    }                                                                    \
+  } while (0)
+
+#define PASS() testsPassed++
+
+// Counts heap allocations, to check the span API makes none
+static size_t allocations = 0;
+
+void* operator new(const size_t size) {
+  allocations++;
+  if (void* p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+using BreakInfo = Hyphenator::BreakInfo;
+
+struct Language {
+  const char* name;
+  const char* tag;
+  const char* file;
+  const SerializedHyphenationPatterns& patterns;
+  bool (*isLetter)(uint32_t);
+  uint32_t (*toLower)(uint32_t);
+  size_t minPrefix;
+  std::vector<std::string> words;
+};
+
+static std::vector<Language> languages = {
+    {"english", "en", "english_hyphenation_tests.txt", en_patterns, isLatinLetter, toLowerLatin, 3, {}},
+    {"french", "fr", "french_hyphenation_tests.txt", fr_patterns, isLatinLetter, toLowerLatin, 2, {}},
+    {"german", "de", "german_hyphenation_tests.txt", de_patterns, isLatinLetter, toLowerLatin, 2, {}},
+    {"russian", "ru", "russian_hyphenation_tests.txt", ru_patterns, isCyrillicLetter, toLowerCyrillic, 2, {}},
+    {"spanish", "es", "spanish_hyphenation_tests.txt", es_patterns, isLatinLetter, toLowerLatin, 2, {}},
+    {"italian", "it", "italian_hyphenation_tests.txt", it_patterns, isLatinLetter, toLowerLatin, 2, {}},
+};
+
+// The same corpus the HyphenationEvaluationTest scores: `word|hyphenated|frequency` lines
+static bool loadWords(const std::string& resourceDir) {
+  for (Language& lang : languages) {
+    std::ifstream file(resourceDir + "/" + lang.file);
+    std::string line;
+    while (std::getline(file, line)) {
+      if (line.empty() || line[0] == '#') continue;
+      const size_t bar = line.find('|');
+      if (bar != std::string::npos && bar > 0) lang.words.push_back(line.substr(0, bar));
+    }
+    if (lang.words.empty()) {
+      fprintf(stderr, "No words in %s/%s\n", resourceDir.c_str(), lang.file);
+      return false;
+    }
+  }
+  return true;
+}
+
+static SerializedHyphenationPatterns withoutDispatch(const SerializedHyphenationPatterns& patterns) {
+  SerializedHyphenationPatterns copy = patterns;
+  copy.dispatch = nullptr;
+  copy.dispatchSlots = nullptr;
+  return copy;
+}
+
+static bool sameBreaks(const std::vector<BreakInfo>& a, const BreakInfo* b, const size_t count) {
+  if (a.size() != count) return false;
+  for (size_t i = 0; i < count; i++) {
+    if (a[i].byteOffset != b[i].byteOffset || a[i].requiresInsertedHyphen != b[i].requiresInsertedHyphen) return false;
+  }
+  return true;
+}
+
+static double elapsedMs(const std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void testDispatchMatchesScan() {
+  printf("testDispatchMatchesScan...\n");
+  size_t words = 0;
+  for (const Language& lang : languages) {
+    ASSERT_TRUE(lang.patterns.dispatch != nullptr);
+    const SerializedHyphenationPatterns scanPatterns = withoutDispatch(lang.patterns);
+    const LanguageHyphenator dispatch(lang.patterns, lang.isLetter, lang.toLower, lang.minPrefix, lang.minPrefix);
+    const LanguageHyphenator scan(scanPatterns, lang.isLetter, lang.toLower, lang.minPrefix, lang.minPrefix);
+    for (const std::string& word : lang.words) {
+      auto cps = collectCodepoints(word);
+      trimSurroundingPunctuationAndFootnote(cps);
+      if (dispatch.breakIndexes(cps) != scan.breakIndexes(cps)) {
+        fprintf(stderr, "  %s: '%s' differs\n", lang.name, word.c_str());
+        testsFailed++;
+        return;
+      }
+      words++;
+    }
+  }
+  printf("  %zu words identical with and without dispatch tables\n", words);
+  PASS();
+}
+
+void testSpanMatchesVector() {
+  printf("testSpanMatchesVector...\n");
+  BreakInfo breaks[Hyphenator::MAX_WORD_CODEPOINTS];
+  for (const Language& lang : languages) {
+    Hyphenator::setPreferredLanguage(lang.tag);
+    for (const std::string& word : lang.words) {
+      for (const bool fallback : {false, true}) {
+        const size_t count = Hyphenator::breakOffsets(word, fallback, breaks, Hyphenator::MAX_WORD_CODEPOINTS);
+        if (!sameBreaks(Hyphenator::breakOffsets(word, fallback), breaks, count)) {
+          fprintf(stderr, "  %s: '%s' differs\n", lang.name, word.c_str());
+          testsFailed++;
+          return;
+        }
+      }
+    }
+  }
+  PASS();
+}
+
+void testSpanApiDoesNotAllocate() {
+  printf("testSpanApiDoesNotAllocate...\n");
+  BreakInfo breaks[Hyphenator::MAX_WORD_CODEPOINTS];
+  size_t total = 0;
+  for (const Language& lang : languages) {
+    Hyphenator::setPreferredLanguage(lang.tag);
+    const size_t before = allocations;
+    for (const std::string& word : lang.words) {
+      total += Hyphenator::breakOffsets(word, true, breaks, Hyphenator::MAX_WORD_CODEPOINTS);
+    }
+    ASSERT_EQ(allocations, before);
+  }
+  ASSERT_TRUE(total > 0);
+  PASS();
+}
+
+void testSmallBufferKeepsFirstBreaks() {
+  printf("testSmallBufferKeepsFirstBreaks...\n");
+  Hyphenator::setPreferredLanguage("de");
+  const std::string word = "Donaudampfschifffahrtsgesellschaft";
+  const auto all = Hyphenator::breakOffsets(word, false);
+  ASSERT_TRUE(all.size() > 3);
+  BreakInfo breaks[3];
+  ASSERT_EQ(Hyphenator::breakOffsets(word, false, breaks, 3), 3u);
+  ASSERT_EQ(breaks[2].byteOffset, all[2].byteOffset);
+  ASSERT_EQ(Hyphenator::breakOffsets(word, false, breaks, 0), 0u);
+  PASS();
+}
+
+void testLongWords() {
+  printf("testLongWords...\n");
+  Hyphenator::setPreferredLanguage("en");
+  BreakInfo breaks[Hyphenator::MAX_WORD_CODEPOINTS];
+
+  // Longer than MAX_WORD_CODEPOINTS: explicit hyphens still break
+  std::string chain;
+  for (int i = 0; i < 12; i++) chain += i ? "-example" : "example";
+  ASSERT_TRUE(chain.size() > Hyphenator::MAX_WORD_CODEPOINTS);
+  size_t count = Hyphenator::breakOffsets(chain, true, breaks, Hyphenator::MAX_WORD_CODEPOINTS);
+  ASSERT_EQ(count, 11u);
+  ASSERT_EQ(breaks[0].byteOffset, 8u);
+  ASSERT_TRUE(!breaks[0].requiresInsertedHyphen);
+
+  // Without hyphens only fallback breaks, from minPrefix on, as many as fit
+  const std::string url(200, 'x');
+  ASSERT_EQ(Hyphenator::breakOffsets(url, false, breaks, Hyphenator::MAX_WORD_CODEPOINTS), 0u);
+  count = Hyphenator::breakOffsets(url, true, breaks, Hyphenator::MAX_WORD_CODEPOINTS);
+  ASSERT_EQ(count, Hyphenator::MAX_WORD_CODEPOINTS);
+  ASSERT_EQ(breaks[0].byteOffset, 3u);
+  ASSERT_TRUE(breaks[0].requiresInsertedHyphen);
+  PASS();
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+
+void benchmarkWordsPerSecond() {
+  printf("benchmarkWordsPerSecond...\n");
+  constexpr int ROUNDS = 5;
+  size_t checksum = 0;
+  printf("  %-8s %7s  %13s %13s  %13s %13s  %s\n", "", "words", "liang scan", "liang table", "vector API", "span API",
+         "allocs/word");
+
+  for (const Language& lang : languages) {
+    const SerializedHyphenationPatterns scanPatterns = withoutDispatch(lang.patterns);
+    const LanguageHyphenator dispatch(lang.patterns, lang.isLetter, lang.toLower, lang.minPrefix, lang.minPrefix);
+    const LanguageHyphenator scan(scanPatterns, lang.isLetter, lang.toLower, lang.minPrefix, lang.minPrefix);
+    std::vector<std::vector<CodepointInfo>> words;
+    for (const std::string& word : lang.words) {
+      words.push_back(collectCodepoints(word));
+      trimSurroundingPunctuationAndFootnote(words.back());
+    }
+    const double count = static_cast<double>(words.size()) * ROUNDS;
+    constexpr size_t CAPACITY = Hyphenator::MAX_WORD_CODEPOINTS;
+    size_t indexes[CAPACITY];
+
+    // Pattern walk alone, on codepoints collected up front
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++) {
+      for (const auto& cps : words) checksum += scan.breakIndexes(cps.data(), cps.size(), indexes, CAPACITY);
+    }
+    const double scanMs = elapsedMs(start);
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++) {
+      for (const auto& cps : words) checksum += dispatch.breakIndexes(cps.data(), cps.size(), indexes, CAPACITY);
+    }
+    const double tableMs = elapsedMs(start);
+
+    // Whole Hyphenator::breakOffsets(), as ParsedText calls it
+    Hyphenator::setPreferredLanguage(lang.tag);
+    const size_t allocationsBefore = allocations;
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++) {
+      for (const std::string& word : lang.words) checksum += Hyphenator::breakOffsets(word, false).size();
+    }
+    const double vectorMs = elapsedMs(start);
+    const double vectorAllocs = static_cast<double>(allocations - allocationsBefore) / count;
+    BreakInfo breaks[Hyphenator::MAX_WORD_CODEPOINTS];
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++) {
+      for (const std::string& word : lang.words) {
+        checksum += Hyphenator::breakOffsets(word, false, breaks, Hyphenator::MAX_WORD_CODEPOINTS);
+      }
+    }
+    const double spanMs = elapsedMs(start);
+
+    const auto perSecond = [count](const double ms) { return ms > 0 ? count * 1000.0 / ms : 0.0; };
+    printf("  %-8s %7zu  %11.0f/s %11.0f/s  %11.0f/s %11.0f/s  %.2f -> 0\n", lang.name, lang.words.size(),
+           perSecond(scanMs), perSecond(tableMs), perSecond(vectorMs), perSecond(spanMs), vectorAllocs);
+  }
+  printf("  checksum %zu\n", checksum);
+  PASS();
+}
+
+int main(int argc, char* argv[]) {
+  printf("=== Hyphenation Throughput Tests ===\n\n");
+  setHyphenationPackLoader(loadTestHyphenationPack);
+  if (!loadWords(argc > 1 ? argv[1] : "test/hyphenation_eval/resources")) {
+    return 1;
+  }
+
+  testDispatchMatchesScan();
+  testSpanMatchesVector();
+  testSpanApiDoesNotAllocate();
+  testSmallBufferKeepsFirstBreaks();
+  testLongWords();
+  benchmarkWordsPerSecond();
+
+  printf("\n=== Results: %d passed, %d failed ===\n", testsPassed, testsFailed);
+  return testsFailed > 0 ? 1 : 0;
+}
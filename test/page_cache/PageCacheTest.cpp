@@ -0,0 +1,163 @@
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+
+#include "lib/Epub/Epub/PageCache.h"
+
+// PageCache only holds pages; a stand-in tells them apart without pulling in the renderer
+class Page {
+ public:
+  explicit Page(const int id) : id(id) {}
+  int id;
+};
+
+static int testsPassed = 0;
+static int testsFailed = 0;
+
+#define ASSERT_EQ(a, b)                                                                          \
+  do {                                                                                           \
+    if ((a) != (b)) {                                                                            \
+      fprintf(stderr, "  FAIL: %s:%d: %s != %s\n", __FILE__, __LINE__, #a, #b);                  \
+      testsFailed++;                                                                             \
+      return;                                                                                    \
+    }                                                                                            \
+  } while (0)
+
+#define ASSERT_TRUE(cond)                                                \
+  do {                                                                   \
+    if (!(cond)) {                                                       \
+      fprintf(stderr, "  FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testsFailed++;                                                     \
+      return;                                                            \
+    }                                                                    \
+  } while (0)
+
+#define PASS() testsPassed++
+
+namespace {
+constexpr size_t PAGE_BYTES = PageCache::BUDGET_BYTES / 8;
+
+void insertPage(PageCache& cache, const int spineIndex, const uint16_t pageNumber, const size_t bytes = PAGE_BYTES) {
+  cache.insert(spineIndex, pageNumber, std::make_shared<const Page>(spineIndex * 1000 + pageNumber), bytes);
+}
+}  // namespace
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+// Pages come back as inserted, from any chapter; turns count as hits or misses
+void testFindAcrossChapters() {
+  printf("testFindAcrossChapters...\n");
+  PageCache cache;
+  insertPage(cache, 3, 0);
+  insertPage(cache, 2, 41);
+
+  const auto boundary = cache.find(2, 41);
+  ASSERT_TRUE(boundary != nullptr);
+  ASSERT_EQ(boundary->id, 2041);
+  ASSERT_EQ(cache.find(3, 0)->id, 3000);
+  ASSERT_TRUE(cache.find(3, 1) == nullptr);
+  ASSERT_TRUE(cache.contains(2, 41));
+  ASSERT_TRUE(!cache.contains(2, 40));
+
+  ASSERT_EQ(cache.getStats().hits, 2u);
+  ASSERT_EQ(cache.getStats().misses, 1u);
+  PASS();
+}
+
+// With every slot taken, the page used longest ago makes room
+void testEvictsLeastRecentlyUsed() {
+  printf("testEvictsLeastRecentlyUsed...\n");
+  PageCache cache;
+  for (int page = 0; page < PageCache::MAX_PAGES; page++) {
+    insertPage(cache, 0, page);
+  }
+  cache.find(0, 0);  // Page 1 is now the oldest
+  insertPage(cache, 0, 10);
+
+  ASSERT_EQ(cache.size(), PageCache::MAX_PAGES);
+  ASSERT_TRUE(cache.contains(0, 0));
+  ASSERT_TRUE(!cache.contains(0, 1));
+  ASSERT_TRUE(cache.contains(0, 10));
+  ASSERT_EQ(cache.usedBytes(), PageCache::MAX_PAGES * PAGE_BYTES);
+  PASS();
+}
+
+// Large pages drop as many old pages as the budget needs; a page over the whole budget is not kept
+void testByteBudget() {
+  printf("testByteBudget...\n");
+  PageCache cache;
+  insertPage(cache, 0, 0);
+  insertPage(cache, 0, 1);
+  insertPage(cache, 0, 2, PageCache::BUDGET_BYTES - PAGE_BYTES);
+
+  ASSERT_TRUE(!cache.contains(0, 0));
+  ASSERT_TRUE(cache.contains(0, 1));
+  ASSERT_TRUE(cache.contains(0, 2));
+  ASSERT_EQ(cache.usedBytes(), PageCache::BUDGET_BYTES);
+
+  insertPage(cache, 0, 3, PageCache::BUDGET_BYTES + 1);
+  ASSERT_TRUE(!cache.contains(0, 3));
+  ASSERT_EQ(cache.size(), 2);
+  PASS();
+}
+
+// Inserting a page again replaces it; dropping a chapter leaves the others
+void testReplaceAndDropChapter() {
+  printf("testReplaceAndDropChapter...\n");
+  PageCache cache;
+  insertPage(cache, 4, 7);
+  cache.insert(4, 7, std::make_shared<const Page>(-1), PAGE_BYTES * 2);
+  ASSERT_EQ(cache.size(), 1);
+  ASSERT_EQ(cache.usedBytes(), PAGE_BYTES * 2);
+  ASSERT_EQ(cache.find(4, 7)->id, -1);
+
+  insertPage(cache, 5, 0);
+  insertPage(cache, 4, 8);
+  cache.dropChapter(4);
+  ASSERT_EQ(cache.size(), 1);
+  ASSERT_TRUE(cache.contains(5, 0));
+  ASSERT_EQ(cache.usedBytes(), PAGE_BYTES);
+
+  cache.clear();
+  ASSERT_EQ(cache.size(), 0);
+  ASSERT_EQ(cache.usedBytes(), 0u);
+  PASS();
+}
+
+// A page the reader still shows outlives its eviction
+void testEvictedPageStaysAlive() {
+  printf("testEvictedPageStaysAlive...\n");
+  PageCache cache;
+  insertPage(cache, 0, 0);
+  const auto shown = cache.find(0, 0);
+  cache.dropChapter(0);
+  ASSERT_EQ(shown->id, 0);
+  ASSERT_EQ(shown.use_count(), 1);
+  PASS();
+}
+
+// The time a hit saves is the mean time of the reads
+void testAverageLoadTime() {
+  printf("testAverageLoadTime...\n");
+  PageCache cache;
+  ASSERT_EQ(cache.averageLoadUs(), 0u);
+  cache.recordLoad(30000);
+  cache.recordLoad(10000);
+  ASSERT_EQ(cache.averageLoadUs(), 20000u);
+  ASSERT_EQ(cache.getStats().loads, 2u);
+  PASS();
+}
+
+int main() {
+  testFindAcrossChapters();
+  testEvictsLeastRecentlyUsed();
+  testByteBudget();
+  testReplaceAndDropChapter();
+  testEvictedPageStaysAlive();
+  testAverageLoadTime();
+
+  printf("\n=== Results: %d passed, %d failed ===\n", testsPassed, testsFailed);
+  return testsFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "lib/Epub/Epub/converters/ImagePlaneCache.h"
+#include "lib/Epub/Epub/converters/PanelImage.h"
+#include "lib/HeapTags/HeapTags.h"
+
+static int testsPassed = 0;
+static int testsFailed = 0;
+
+#define ASSERT_EQ(a, b)                                                         \
+  do {                                                                          \
+    if ((a) != (b)) {                                                           \
+      fprintf(stderr, "  FAIL: %s:%d: %s != %s\n", __FILE__, __LINE__, #a, #b); \
+      testsFailed++;                                                            \
+      return;                                                                   \
+    }                                                                           \
+  } while (0)
+
+#define ASSERT_TRUE(cond)                                                \
+  do {                                                                   \
+    if (!(cond)) {                                                       \
+      fprintf(stderr, "  FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testsFailed++;                                                     \
+      return;                                                            \
+    }                                                                    \
+  } while (0)
+
+#define PASS() testsPassed++
+
+// X4 panel geometry (HalDisplay::DISPLAY_WIDTH x DISPLAY_HEIGHT, native landscape)
+constexpr int PANEL_WIDTH = 800;
+constexpr int PANEL_HEIGHT = 480;
+constexpr int STRIDE = PANEL_WIDTH / 8;
+constexpr size_t FRAME_SIZE = STRIDE * PANEL_HEIGHT;
+
+// ============================================================================
+// v1 cache in memory and the v1 render loop
+//
+// renderV1 mirrors ImageBlock's renderFromCache: per pixel, DirectPixelWriter::writePixel's mode test and
+// orientation transform.
+// ============================================================================
+
+struct PixelCacheV1 {
+  int width;
+  int height;
+  int bytesPerRow;
+  std::vector<uint8_t> pixels;
+
+  PixelCacheV1(const int w, const int h) : width(w), height(h), bytesPerRow((w + 3) / 4), pixels(bytesPerRow * h) {}
+
+  void set(const int x, const int y, const uint8_t value) {
+    uint8_t& byte = pixels[y * bytesPerRow + x / 4];
+    const int shift = 6 - (x % 4) * 2;
+    byte = (byte & ~(0x03 << shift)) | (value << shift);
+  }
+  const uint8_t* row(const int y) const { return pixels.data() + y * bytesPerRow; }
+};
+
+// A dithered illustration: gradient with a white frame and some solid shapes
+PixelCacheV1 makeIllustration(const int w, const int h) {
+  PixelCacheV1 cache(w, h);
+  uint32_t seed = 12345;
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      seed = seed * 1103515245 + 12345;
+      uint8_t value;
+      if (x < 12 || y < 12 || x >= w - 12 || y >= h - 12) {
+        value = 3;  // white margin
+      } else if ((x - w / 2) * (x - w / 2) + (y - h / 3) * (y - h / 3) < (w / 5) * (w / 5)) {
+        value = 0;  // black disc
+      } else {
+        const int level = (x + y) * 4 / (w + h);
+        value = static_cast<uint8_t>(std::min(3, level + static_cast<int>((seed >> 16) & 1)));
+      }
+      cache.set(x, y, value);
+    }
+  }
+  return cache;
+}
+
+void renderV1(uint8_t* fb, const PixelCacheV1& cache, const uint8_t orientation, const uint8_t mode, const int x,
+              const int y) {
+  const auto t = PanelImage::Transform::forOrientation(orientation, PANEL_WIDTH, PANEL_HEIGHT);
+  std::vector<uint8_t> rowBuffer(cache.bytesPerRow);
+  for (int row = 0; row < cache.height; row++) {
+    memcpy(rowBuffer.data(), cache.row(row), cache.bytesPerRow);  // stands in for the SD read
+    const int logicalY = y + row;
+    const int rowPhyXBase = t.xBase + logicalY * t.xStepY;
+    const int rowPhyYBase = t.yBase + logicalY * t.yStepY;
+    for (int col = 0; col < cache.width; col++) {
+      const uint8_t pixelValue = (rowBuffer[col >> 2] >> (6 - (col & 3) * 2)) & 0x03;
+      if (!PanelImage::drawsValue(mode, pixelValue)) continue;
+      const int phyX = rowPhyXBase + (x + col) * t.xStepX;
+      const int phyY = rowPhyYBase + (x + col) * t.yStepX;
+      const uint8_t bitMask = 1 << (7 - (phyX & 7));
+      if (mode == PanelImage::MODE_BW) {
+        fb[phyY * STRIDE + (phyX >> 3)] &= ~bitMask;
+      } else {
+        fb[phyY * STRIDE + (phyX >> 3)] |= bitMask;
+      }
+    }
+  }
+}
+
+// ============================================================================
+// v2 cache in memory, built the way ImageBlock's buildPanelCache does (one plane at a time)
+// ============================================================================
+
+struct PanelCacheV2 {
+  std::vector<uint8_t> file;
+
+  const uint8_t* plane(const PanelImage::Layout& layout, const uint8_t mode) const {
+    return file.data() + PanelImage::HEADER_SIZE + mode * layout.planeSize();
+  }
+};
+
+bool buildV2(const PixelCacheV1& cache, const uint8_t orientation, const int x, const int y, PanelCacheV2& out,
+             PanelImage::Layout& layout) {
+  if (!PanelImage::computeLayout(orientation, PANEL_WIDTH, PANEL_HEIGHT, x, y, cache.width, cache.height, layout)) {
+    return false;
+  }
+  out.file.assign(PanelImage::HEADER_SIZE, 0);
+  PanelImage::encodeHeader(layout, out.file.data());
+
+  std::vector<uint8_t> plane(layout.planeSize());
+  for (uint8_t mode = 0; mode < PanelImage::PLANE_COUNT; mode++) {
+    uint8_t* planes[PanelImage::PLANE_COUNT] = {};
+    planes[mode] = plane.data();
+    std::fill(plane.begin(), plane.end(), 0);
+    for (int row = 0; row < cache.height; row++) {
+      PanelImage::addRow(layout, planes, row, cache.row(row));
+    }
+    out.file.insert(out.file.end(), plane.begin(), plane.end());
+  }
+  return true;
+}
+
+void renderV2(uint8_t* fb, const PanelCacheV2& cache, const PanelImage::Layout& layout, const uint8_t mode) {
+  PanelImage::blitRows(fb, STRIDE, layout, mode, 0, layout.rows, cache.plane(layout, mode));
+}
+
+// Framebuffer with text-like content around the image so edge bytes shared with the image are checked too
+std::vector<uint8_t> makeBackground(const uint8_t mode) {
+  std::vector<uint8_t> fb(FRAME_SIZE);
+  for (size_t i = 0; i < FRAME_SIZE; i++) {
+    const uint8_t pattern = static_cast<uint8_t>((i * 37) ^ (i >> 5));
+    fb[i] = mode == PanelImage::MODE_BW ? static_cast<uint8_t>(0xFF ^ (pattern & 0x11)) : (pattern & 0x22);
+  }
+  return fb;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void testIdenticalOutputAllOrientations() {
+  printf("testIdenticalOutputAllOrientations...\n");
+  struct Placement {
+    int x, y, w, h;
+  };
+  for (uint8_t orientation = 0; orientation < 4; orientation++) {
+    const bool portrait = orientation == PanelImage::PORTRAIT || orientation == PanelImage::PORTRAIT_INVERTED;
+    const int screenW = portrait ? PANEL_HEIGHT : PANEL_WIDTH;
+    const int screenH = portrait ? PANEL_WIDTH : PANEL_HEIGHT;
+    // Odd offsets and sizes so spans start and end mid-byte
+    const Placement placements[] = {{0, 0, screenW, screenH}, {13, 27, 101, 67}, {screenW - 45, screenH - 30, 45, 30}};
+    for (const auto& p : placements) {
+      const PixelCacheV1 image = makeIllustration(p.w, p.h);
+      PanelCacheV2 v2;
+      PanelImage::Layout layout;
+      ASSERT_TRUE(buildV2(image, orientation, p.x, p.y, v2, layout));
+      for (uint8_t mode = 0; mode < PanelImage::PLANE_COUNT; mode++) {
+        auto expected = makeBackground(mode);
+        auto actual = expected;
+        renderV1(expected.data(), image, orientation, mode, p.x, p.y);
+        renderV2(actual.data(), v2, layout, mode);
+        if (expected != actual) {
+          fprintf(stderr, "  orientation %u, mode %u, image %dx%d at %d,%d differs\n", orientation, mode, p.w, p.h,
+                  p.x, p.y);
+        }
+        ASSERT_TRUE(expected == actual);
+      }
+    }
+  }
+  PASS();
+}
+
+void testHeaderRoundTrip() {
+  printf("testHeaderRoundTrip...\n");
+  PanelImage::Layout layout;
+  ASSERT_TRUE(PanelImage::computeLayout(PanelImage::PORTRAIT, PANEL_WIDTH, PANEL_HEIGHT, 40, 120, 400, 300, layout));
+  // Portrait: logical rows become physical columns
+  ASSERT_EQ(layout.rows, 400);
+  ASSERT_EQ(layout.firstRow, PANEL_HEIGHT - 440);
+  ASSERT_EQ(layout.firstByte, 120 / 8);
+  ASSERT_EQ(layout.spanBytes, (120 + 299) / 8 - 120 / 8 + 1);
+
+  uint8_t header[PanelImage::HEADER_SIZE];
+  PanelImage::encodeHeader(layout, header);
+  PanelImage::Layout decoded;
+  ASSERT_TRUE(PanelImage::decodeHeader(header, decoded));
+  ASSERT_TRUE(decoded.sameKey(layout));
+  ASSERT_EQ(decoded.planeSize(), layout.planeSize());
+
+  // Another version, or a span that disagrees with the geometry, is rejected
+  uint8_t corrupt[PanelImage::HEADER_SIZE];
+  memcpy(corrupt, header, sizeof(header));
+  corrupt[4] = 1;
+  ASSERT_TRUE(!PanelImage::decodeHeader(corrupt, decoded));
+  memcpy(corrupt, header, sizeof(header));
+  corrupt[PanelImage::HEADER_SIZE - 2] ^= 0x10;
+  ASSERT_TRUE(!PanelImage::decodeHeader(corrupt, decoded));
+
+  // Images that leave the panel have no layout
+  ASSERT_TRUE(!PanelImage::computeLayout(PanelImage::PORTRAIT, PANEL_WIDTH, PANEL_HEIGHT, 400, 0, 100, 10, layout));
+  PASS();
+}
+
+// Fill a reserved slot from a v2 cache the way ImageBlock's renderFromPanelCache does
+bool fillPlanes(const int slot, const PanelCacheV2& cache, const PanelImage::Layout& layout) {
+  for (uint8_t mode = 0; mode < PanelImage::PLANE_COUNT; mode++) {
+    uint8_t* plane = ImagePlaneCache::plane(slot, mode);
+    if (!plane) return false;
+    std::memcpy(plane, cache.plane(layout, mode), layout.planeSize());
+  }
+  ImagePlaneCache::commit(slot);
+  return true;
+}
+
+size_t freeHeapBlock = 0;
+
+// A full-screen illustration stays in RAM for every pass over its page, drawn as the v2 cache draws it
+void testFullPageImageServedFromPlaneCache() {
+  printf("testFullPageImageServedFromPlaneCache...\n");
+  const PixelCacheV1 image = makeIllustration(480, 800);
+  PanelCacheV2 v2;
+  PanelImage::Layout layout;
+  ASSERT_TRUE(buildV2(image, PanelImage::PORTRAIT, 0, 0, v2, layout));
+  ASSERT_EQ(PanelImage::PLANE_COUNT * layout.planeSize(), 144000u);
+
+  freeHeapBlock = 200 * 1024;
+  HeapTags::setLargestFreeBlockProbe([] { return freeHeapBlock; });
+  const std::string cachePath = "/.crosspoint/epub_1/img_0.pxc";
+  GfxRenderer renderer;
+  {
+    ImagePlaneCache::PageScope scope;
+    ASSERT_TRUE(!ImagePlaneCache::blit(renderer, cachePath, 0, 0));
+    const int slot = ImagePlaneCache::reserve(cachePath, layout);
+    ASSERT_TRUE(slot >= 0);
+    ASSERT_TRUE(fillPlanes(slot, v2, layout));
+
+    for (uint8_t mode = 0; mode < PanelImage::PLANE_COUNT; mode++) {
+      auto expected = makeBackground(mode);
+      auto actual = expected;
+      renderV2(expected.data(), v2, layout, mode);
+      renderer.renderMode = static_cast<GfxRenderer::RenderMode>(mode);
+      renderer.frameBuffer = actual.data();
+      renderer.displayWidthBytes = STRIDE;
+      ASSERT_TRUE(ImagePlaneCache::blit(renderer, cachePath, 0, 0));
+      ASSERT_TRUE(expected == actual);
+    }
+    ASSERT_TRUE(HeapTags::usage(HeapTags::Tag::ImageDecode).currentBytes >= 144000u);
+
+    // A second full-screen image is over the page's budget
+    ASSERT_EQ(ImagePlaneCache::reserve("/.crosspoint/epub_1/img_1.pxc", layout), -1);
+  }
+  ASSERT_EQ(HeapTags::usage(HeapTags::Tag::ImageDecode).currentBytes, 0u);
+  ASSERT_TRUE(!ImagePlaneCache::blit(renderer, cachePath, 0, 0));
+  HeapTags::setLargestFreeBlockProbe(nullptr);
+  PASS();
+}
+
+// Planes that would leave the heap without headroom are given back, and the image streams from SD instead
+void testPlaneCacheKeepsHeapHeadroom() {
+  printf("testPlaneCacheKeepsHeapHeadroom...\n");
+  const PixelCacheV1 image = makeIllustration(480, 800);
+  PanelCacheV2 v2;
+  PanelImage::Layout layout;
+  ASSERT_TRUE(buildV2(image, PanelImage::PORTRAIT, 0, 0, v2, layout));
+
+  freeHeapBlock = ImagePlaneCache::HEAP_HEADROOM_BYTES - 1;
+  HeapTags::setLargestFreeBlockProbe([] { return freeHeapBlock; });
+  {
+    ImagePlaneCache::PageScope scope;
+    ASSERT_EQ(ImagePlaneCache::reserve("/.crosspoint/epub_1/img_0.pxc", layout), -1);
+    ASSERT_EQ(HeapTags::usage(HeapTags::Tag::ImageDecode).currentBytes, 0u);
+
+    freeHeapBlock = ImagePlaneCache::HEAP_HEADROOM_BYTES;
+    ASSERT_TRUE(ImagePlaneCache::reserve("/.crosspoint/epub_1/img_0.pxc", layout) >= 0);
+  }
+  HeapTags::setLargestFreeBlockProbe(nullptr);
+  PASS();
+}
+
+void benchmarkFullPageIllustration() {
+  printf("benchmarkFullPageIllustration...\n");
+  constexpr int ITERATIONS = 20;
+  const PixelCacheV1 image = makeIllustration(480, 800);
+  PanelCacheV2 v2;
+  PanelImage::Layout layout;
+  ASSERT_TRUE(buildV2(image, PanelImage::PORTRAIT, 0, 0, v2, layout));
+
+  std::vector<uint8_t> fb(FRAME_SIZE);
+  uint32_t checksum = 0;
+  // One page render = BW, LSB and MSB passes
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < ITERATIONS; i++) {
+    for (uint8_t mode = 0; mode < PanelImage::PLANE_COUNT; mode++) {
+      std::fill(fb.begin(), fb.end(), mode == PanelImage::MODE_BW ? 0xFF : 0x00);
+      renderV1(fb.data(), image, PanelImage::PORTRAIT, mode, 0, 0);
+      checksum += fb[i % FRAME_SIZE];
+    }
+  }
+  const double v1Ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < ITERATIONS; i++) {
+    for (uint8_t mode = 0; mode < PanelImage::PLANE_COUNT; mode++) {
+      std::fill(fb.begin(), fb.end(), mode == PanelImage::MODE_BW ? 0xFF : 0x00);
+      renderV2(fb.data(), v2, layout, mode);
+      checksum += fb[i % FRAME_SIZE];
+    }
+  }
+  const double v2Ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  const size_t v1Bytes = 4 + image.pixels.size();
+  printf("  480x800 portrait, 3 passes per page (checksum %u)\n", checksum);
+  printf("  v1: %.2f ms/page, reads %zu bytes per pass\n", v1Ms / ITERATIONS, v1Bytes);
+  printf("  v2: %.2f ms/page, reads %zu bytes per pass (file %zu bytes)\n", v2Ms / ITERATIONS, layout.planeSize(),
+         v2.file.size());
+  printf("  speedup %.1fx on this host\n", v1Ms / v2Ms);
+  ASSERT_TRUE(v2Ms < v1Ms);
+  PASS();
+}
+
+int main() {
+  printf("=== Panel Image Cache Tests ===\n\n");
+
+  testIdenticalOutputAllOrientations();
+  testHeaderRoundTrip();
+  testFullPageImageServedFromPlaneCache();
+  testPlaneCacheKeepsHeapHeadroom();
+  benchmarkFullPageIllustration();
+
+  printf("\n=== Results: %d passed, %d failed ===\n", testsPassed, testsFailed);
+  return testsFailed > 0 ? 1 : 0;
+}
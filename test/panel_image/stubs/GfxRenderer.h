@@ -0,0 +1,21 @@
+#pragma once
+
+// Host stand-in for GfxRenderer: just the state ImagePlaneCache reads, set directly by the test
+
+#include <cstdint>
+
+class GfxRenderer {
+ public:
+  enum RenderMode { BW, GRAYSCALE_LSB, GRAYSCALE_MSB };
+  enum Orientation { Portrait, LandscapeClockwise, PortraitInverted, LandscapeCounterClockwise };
+
+  Orientation getOrientation() const { return orientation; }
+  RenderMode getRenderMode() const { return renderMode; }
+  uint8_t* getFrameBuffer() const { return frameBuffer; }
+  uint16_t getDisplayWidthBytes() const { return displayWidthBytes; }
+
+  Orientation orientation = Portrait;
+  RenderMode renderMode = BW;
+  uint8_t* frameBuffer = nullptr;
+  uint16_t displayWidthBytes = 0;
+};
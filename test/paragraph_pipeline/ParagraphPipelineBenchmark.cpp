@@ -0,0 +1,599 @@
+#include <expat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+#include "lib/Epub/Epub/htmlEntities.h"
+#include "lib/Epub/Epub/parsers/ParagraphRing.h"
+#include "lib/Epub/Epub/parsers/TextRunTokenizer.h"
+
+static int testsPassed = 0;
+static int testsFailed = 0;
+
+#define ASSERT_EQ(a, b)                                                         \
+  do {                                                                          \
+    if ((a) != (b)) {                                                           \
+      fprintf(stderr, "  FAIL: %s:%d: %s != %s\n", __FILE__, __LINE__, #a, #b); \
+      testsFailed++;                                                            \
+      return;                                                                   \
+    }                                                                           \
+  } while (0)
+
+#define ASSERT_TRUE(cond)                                                \
+  do {                                                                   \
+    if (!(cond)) {                                                       \
+      fprintf(stderr, "  FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testsFailed++;                                                     \
+      return;                                                            \
+    }                                                                    \
+  } while (0)
+
+#define PASS() testsPassed++
+
+using Clock = std::chrono::steady_clock;
+
+// ============================================================================
+// A chapter pipeline shaped like ChapterHtmlSlimParser and ChapterPageBuilder. GfxRenderer does not build on the
+// host, so the layout stage measures words with a glyph width table and breaks lines with the same minimum-raggedness
+// search as ParsedText::computeLineBreaks; "serializing" a page hashes its text.
+// ============================================================================
+
+// Stand-in for ChapterPageBuilder::Item
+struct Item {
+  enum class Kind : uint8_t { Paragraph, End };
+  Kind kind = Kind::Paragraph;
+  std::vector<std::string> words;
+  bool endsParagraph = true;
+};
+
+struct LayoutResult {
+  size_t lines = 0;
+  size_t pages = 0;
+  uint64_t hash = 0xcbf29ce484222325ULL;
+
+  bool operator==(const LayoutResult& other) const {
+    return lines == other.lines && pages == other.pages && hash == other.hash;
+  }
+};
+
+class LayoutStage {
+ public:
+  static constexpr int PAGE_WIDTH = 460;
+  static constexpr size_t LINES_PER_PAGE = 28;
+
+  LayoutStage() {
+    std::mt19937 random(48);
+    for (auto& width : glyphWidths) width = static_cast<uint8_t>(5 + random() % 9);
+  }
+
+  void process(Item& item) {
+    if (item.kind == Item::Kind::End) {
+      completePage();
+      return;
+    }
+    // Like ParsedText::takeWords: swap into an empty paragraph, append to the carried last line otherwise
+    if (paragraph.empty()) {
+      paragraph.swap(item.words);
+    } else {
+      paragraph.insert(paragraph.end(), std::make_move_iterator(item.words.begin()),
+                       std::make_move_iterator(item.words.end()));
+      item.words.clear();
+    }
+    layOut(item.endsParagraph);
+  }
+
+  const LayoutResult& getResult() const { return result; }
+
+ private:
+  uint8_t glyphWidths[256];
+  std::vector<std::string> paragraph;
+  std::vector<int> widths;
+  std::vector<int64_t> cost;
+  std::vector<size_t> lineEnd;
+  std::string page;
+  size_t pageLines = 0;
+  LayoutResult result;
+
+  int measure(const std::string& word) const {
+    int width = 0;
+    uint8_t previous = 0;
+    for (const char c : word) {
+      const auto glyph = static_cast<uint8_t>(c);
+      // Glyph advance plus a kerning adjustment for the pair
+      width += glyphWidths[glyph] - ((previous ^ glyph) & 1);
+      previous = glyph;
+    }
+    return width;
+  }
+
+  void layOut(const bool includeLastLine) {
+    const size_t count = paragraph.size();
+    if (count == 0) {
+      return;
+    }
+    constexpr int SPACE = 4;
+    widths.resize(count);
+    for (size_t i = 0; i < count; i++) widths[i] = std::min(measure(paragraph[i]), PAGE_WIDTH);
+
+    // cost[i]: least badness of the lines from word i to the end; lineEnd[i]: one past the last word of the first
+    cost.assign(count + 1, 0);
+    lineEnd.assign(count + 1, count);
+    for (size_t i = count; i-- > 0;) {
+      cost[i] = INT64_MAX;
+      int lineWidth = -SPACE;
+      for (size_t j = i; j < count; j++) {
+        lineWidth += widths[j] + SPACE;
+        if (lineWidth > PAGE_WIDTH && j > i) break;
+        const int64_t slack = PAGE_WIDTH - lineWidth;
+        const int64_t badness = j + 1 == count ? 0 : slack * slack;
+        if (badness + cost[j + 1] < cost[i]) {
+          cost[i] = badness + cost[j + 1];
+          lineEnd[i] = j + 1;
+        }
+      }
+    }
+
+    size_t start = 0;
+    while (start < count) {
+      const size_t end = lineEnd[start];
+      if (end == count && !includeLastLine) break;
+      addLine(start, end);
+      start = end;
+    }
+    paragraph.erase(paragraph.begin(), paragraph.begin() + static_cast<std::ptrdiff_t>(start));
+  }
+
+  void addLine(const size_t start, const size_t end) {
+    if (pageLines == LINES_PER_PAGE) {
+      completePage();
+    }
+    for (size_t i = start; i < end; i++) {
+      page += paragraph[i];
+      page.push_back(' ');
+    }
+    page.push_back('\n');
+    pageLines++;
+    result.lines++;
+  }
+
+  void completePage() {
+    for (const char c : page) result.hash = (result.hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ULL;
+    result.hash = (result.hash ^ 0xFF) * 0x100000001b3ULL;
+    result.pages++;
+    page.clear();
+    pageLines = 0;
+  }
+};
+
+// How long reading each buffer of the chapter takes (the SD card on the device)
+struct ReadLatency {
+  std::chrono::microseconds perBuffer{0};
+};
+
+// Stand-in for the parser side of ChapterHtmlSlimParser: expat and TextRunTokenizer, paragraphs at block elements,
+// long paragraphs handed over in parts of 750 words
+class ParseStage final : TextRunTokenizer::Sink {
+ public:
+  static constexpr size_t PARSE_BUFFER_SIZE = 1024;
+  static constexpr size_t MAX_PART_WORDS = 750;
+
+  // Items go to the ring if there is one, else to `record` if given, else straight to the layout stage
+  ParseStage(LayoutStage* layout, ParagraphRing<Item>* ring, std::vector<Item>* record = nullptr)
+      : layout(layout), ring(ring), record(record) {}
+
+  bool parse(const std::string& xhtml, const ReadLatency& latency) {
+    XML_Parser parser = XML_ParserCreate(nullptr);
+    XML_SetDefaultHandlerExpand(parser, defaultHandlerExpand);
+    XML_SetUserData(parser, this);
+    XML_SetElementHandler(parser, startElement, endElement);
+    XML_SetCharacterDataHandler(parser, characterData);
+    bool ok = true;
+    for (size_t offset = 0; ok && offset < xhtml.size(); offset += PARSE_BUFFER_SIZE) {
+      if (latency.perBuffer.count() > 0) std::this_thread::sleep_for(latency.perBuffer);
+      const size_t chunk = std::min(PARSE_BUFFER_SIZE, xhtml.size() - offset);
+      const bool done = offset + chunk == xhtml.size();
+      ok = XML_Parse(parser, xhtml.data() + offset, static_cast<int>(chunk), done) != XML_STATUS_ERROR;
+    }
+    XML_ParserFree(parser);
+    tokenizer.flush();
+    emitParagraph(true);
+    Item* item = acquire();
+    if (item) {
+      item->kind = Item::Kind::End;
+      submit();
+    }
+    return ok;
+  }
+
+ private:
+  LayoutStage* layout;
+  ParagraphRing<Item>* ring;
+  std::vector<Item>* record;
+  Item inlineItem;
+  TextRunTokenizer tokenizer{*this};
+  std::vector<std::string> words;
+  size_t partsShipped = 0;  // Of the current paragraph
+  int skipDepth = 0;  // Inside <head>
+
+  Item* acquire() { return ring ? ring->acquire() : &inlineItem; }
+  void submit() {
+    if (ring) {
+      ring->publish();
+    } else {
+      if (record) {
+        record->push_back(std::move(inlineItem));
+        inlineItem.words.clear();
+      } else {
+        layout->process(inlineItem);
+      }
+    }
+  }
+
+  void emitParagraph(const bool endsParagraph) {
+    if (words.empty() && (!endsParagraph || partsShipped == 0)) {
+      return;
+    }
+    Item* item = acquire();
+    if (!item) return;
+    item->kind = Item::Kind::Paragraph;
+    item->words.swap(words);
+    item->endsParagraph = endsParagraph;
+    submit();
+    partsShipped = endsParagraph ? 0 : partsShipped + 1;
+  }
+
+  void addWord(const char* word, const size_t length) override {
+    words.emplace_back(word, length);
+    if (words.size() > MAX_PART_WORDS) emitParagraph(false);
+  }
+  void wordBreak() override {}
+  void noBreakSpace() override { words.emplace_back(" "); }
+
+  static bool isBlock(const char* name) {
+    static const char* const BLOCKS[] = {"p", "li", "div", "br", "blockquote", "h1", "h2", "h3", "h4", "h5", "h6"};
+    return std::any_of(std::begin(BLOCKS), std::end(BLOCKS), [name](const char* tag) { return !strcmp(tag, name); });
+  }
+
+  static void XMLCALL startElement(void* userData, const XML_Char* name, const XML_Char**) {
+    auto* self = static_cast<ParseStage*>(userData);
+    self->tokenizer.flush();
+    if (self->skipDepth > 0 || strcmp(name, "head") == 0) self->skipDepth++;
+    if (isBlock(name)) self->emitParagraph(true);
+  }
+  static void XMLCALL endElement(void* userData, const XML_Char*) {
+    auto* self = static_cast<ParseStage*>(userData);
+    self->tokenizer.flush();
+    if (self->skipDepth > 0) self->skipDepth--;
+  }
+  static void XMLCALL characterData(void* userData, const XML_Char* s, const int len) {
+    auto* self = static_cast<ParseStage*>(userData);
+    if (self->skipDepth == 0) self->tokenizer.feed(s, static_cast<size_t>(len));
+  }
+  static void XMLCALL defaultHandlerExpand(void* userData, const XML_Char* s, const int len) {
+    if (len >= 3 && s[0] == '&' && s[len - 1] == ';') {
+      const char* utf8Value = lookupCommonHtmlEntity(s, static_cast<size_t>(len));
+      if (utf8Value == nullptr) utf8Value = lookupHtmlEntity(s, static_cast<size_t>(len));
+      characterData(userData, utf8Value != nullptr ? utf8Value : s,
+                    utf8Value != nullptr ? static_cast<int>(strlen(utf8Value)) : len);
+    }
+  }
+};
+
+struct RunResult {
+  LayoutResult layout;
+  double seconds = 0;
+  bool ok = true;
+};
+
+// depth 0: everything on one thread, like laying out inline; otherwise the layout stage runs on a thread of its own
+// behind a ring of `depth` items, like ChapterHtmlSlimParser's layout task
+static RunResult runChapters(const std::vector<std::string>& chapters, const size_t depth,
+                             const ReadLatency& latency) {
+  RunResult run;
+  const auto start = Clock::now();
+  for (const auto& chapter : chapters) {
+    LayoutStage layout;
+    if (depth == 0) {
+      ParseStage parse(&layout, nullptr);
+      run.ok &= parse.parse(chapter, latency);
+    } else {
+      ParagraphRing<Item> ring(depth);
+      if (!ring.allocate()) {
+        run.ok = false;
+        break;
+      }
+      std::thread consumer([&ring, &layout] {
+        while (Item* item = ring.next()) {
+          layout.process(*item);
+          ring.release();
+        }
+      });
+      ParseStage parse(&layout, &ring);
+      run.ok &= parse.parse(chapter, latency);
+      ring.close();
+      consumer.join();
+    }
+    const LayoutResult& result = layout.getResult();
+    run.layout.lines += result.lines;
+    run.layout.pages += result.pages;
+    run.layout.hash = (run.layout.hash ^ result.hash) * 0x100000001b3ULL;
+  }
+  run.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  return run;
+}
+
+// ============================================================================
+// Chapters
+// ============================================================================
+
+static std::vector<std::string> loadChapters(const char* dir) {
+  std::vector<std::filesystem::path> paths;
+  for (const auto& entry : std::filesystem::recursive_directory_iterator(dir)) {
+    const auto extension = entry.path().extension();
+    if (entry.is_regular_file() && (extension == ".xhtml" || extension == ".html")) paths.push_back(entry.path());
+  }
+  std::sort(paths.begin(), paths.end());
+  std::vector<std::string> chapters;
+  for (const auto& path : paths) {
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream content;
+    content << file.rdbuf();
+    chapters.push_back(content.str());
+  }
+  return chapters;
+}
+
+// A novel-sized chapter: paragraphs of 20 to 300 words, every 40th one over 750 words, some entities and inline
+// elements
+static std::string syntheticChapter(const size_t paragraphs) {
+  std::mt19937 random(480);
+  const char* const entities[] = {"&nbsp;", "&rsquo;", "&mdash;", "&hellip;"};
+  // An external DTD, like real EPUBs, so expat hands the HTML entities to the default handler
+  std::string xhtml =
+      "<?xml version=\"1.0\"?>\n<!DOCTYPE html PUBLIC \"-//W3C//DTD XHTML 1.1//EN\" "
+      "\"http://www.w3.org/TR/xhtml11/DTD/xhtml11.dtd\">\n<html><head><title>t</title></head><body>\n";
+  for (size_t p = 0; p < paragraphs; p++) {
+    xhtml += "<p>";
+    const size_t count = p % 40 == 39 ? 1600 : 20 + random() % 280;
+    for (size_t w = 0; w < count; w++) {
+      const size_t length = 1 + random() % 10;
+      const bool emphasis = random() % 50 == 0;
+      if (emphasis) xhtml += "<em>";
+      for (size_t c = 0; c < length; c++) xhtml.push_back(static_cast<char>('a' + random() % 26));
+      if (emphasis) xhtml += "</em>";
+      xhtml += random() % 30 == 0 ? entities[random() % 4] : " ";
+    }
+    xhtml += "</p>\n";
+  }
+  xhtml += "</body></html>\n";
+  return xhtml;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+static void testRingOrder() {
+  printf("testRingOrder...\n");
+  for (const size_t depth : {1, 2, 3, 8}) {
+    constexpr int COUNT = 20000;
+    ParagraphRing<int> ring(depth);
+    ASSERT_TRUE(ring.allocate());
+    std::atomic<bool> inOrder{true};
+    std::atomic<int> received{0};
+    std::thread consumer([&] {
+      std::mt19937 random(1);
+      int expected = 0;
+      while (int* value = ring.next()) {
+        if (*value != expected++) inOrder = false;
+        // Uneven consumer, so the producer both waits for slots and runs ahead
+        if (random() % 64 == 0) std::this_thread::yield();
+        ring.release();
+        received++;
+      }
+    });
+    std::mt19937 random(2);
+    for (int i = 0; i < COUNT; i++) {
+      int* slot = ring.acquire();
+      ASSERT_TRUE(slot != nullptr);
+      *slot = i;
+      ring.publish();
+      if (random() % 64 == 0) std::this_thread::yield();
+    }
+    ring.close();
+    consumer.join();
+    ASSERT_TRUE(inOrder);
+    ASSERT_EQ(received.load(), COUNT);
+  }
+  PASS();
+}
+
+static void testRingCloseDrains() {
+  printf("testRingCloseDrains...\n");
+  ParagraphRing<std::string> ring(4);
+  ASSERT_TRUE(ring.allocate());
+  for (const char* word : {"one", "two", "three"}) {
+    *ring.acquire() = word;
+    ring.publish();
+  }
+  ring.close();
+  std::string seen;
+  while (std::string* word = ring.next()) {
+    seen += *word + " ";
+    ring.release();
+  }
+  ASSERT_EQ(seen, std::string("one two three "));
+  ASSERT_TRUE(ring.next() == nullptr);
+  PASS();
+}
+
+static void testRingSlotsReused() {
+  printf("testRingSlotsReused...\n");
+  ParagraphRing<std::vector<int>> ring(2);
+  ASSERT_TRUE(ring.allocate());
+  std::vector<int>* first = ring.acquire();
+  first->assign(100, 1);
+  ring.publish();
+  ring.next()->clear();
+  ring.release();
+  ring.acquire();
+  ring.publish();
+  ring.next();
+  ring.release();
+  // The third item lands in the first slot again, storage and all
+  std::vector<int>* third = ring.acquire();
+  ASSERT_TRUE(third == first);
+  ASSERT_TRUE(third->capacity() >= 100);
+  PASS();
+}
+
+static void testRingAbort() {
+  printf("testRingAbort...\n");
+  {
+    // Producer waiting for a free slot
+    ParagraphRing<int> ring(1);
+    ASSERT_TRUE(ring.allocate());
+    ring.acquire();
+    ring.publish();
+    std::atomic<bool> unblocked{false};
+    int sentinel = 0;
+    int* slot = &sentinel;
+    std::thread producer([&] {
+      slot = ring.acquire();
+      unblocked = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT_TRUE(!unblocked);
+    ring.abort();
+    producer.join();
+    ASSERT_TRUE(slot == nullptr);
+  }
+  {
+    // Consumer waiting for an item
+    ParagraphRing<int> ring(2);
+    ASSERT_TRUE(ring.allocate());
+    int sentinel = 0;
+    int* item = &sentinel;
+    std::thread consumer([&] { item = ring.next(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ring.abort();
+    consumer.join();
+    ASSERT_TRUE(item == nullptr);
+  }
+  PASS();
+}
+
+// Pages come out the same whether the layout stage runs inline or behind a ring of any depth
+static void testSamePages(const char* label, const std::vector<std::string>& chapters) {
+  printf("testSamePages (%s)...\n", label);
+  const RunResult serial = runChapters(chapters, 0, {});
+  ASSERT_TRUE(serial.ok);
+  ASSERT_TRUE(serial.layout.pages > 0);
+  for (const size_t depth : {1, 2, 4, 8}) {
+    const RunResult pipelined = runChapters(chapters, depth, {});
+    ASSERT_TRUE(pipelined.ok);
+    ASSERT_TRUE(pipelined.layout == serial.layout);
+  }
+  PASS();
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+
+static double bestOf(const int rounds, const std::vector<std::string>& chapters, const size_t depth,
+                     const ReadLatency& latency) {
+  double best = 1e9;
+  for (int round = 0; round < rounds; round++) {
+    best = std::min(best, runChapters(chapters, depth, latency).seconds);
+  }
+  return best;
+}
+
+static void benchmark(const char* label, const std::vector<std::string>& chapters) {
+  printf("benchmark (%s)...\n", label);
+  size_t bytes = 0;
+  for (const auto& chapter : chapters) bytes += chapter.size();
+  const RunResult reference = runChapters(chapters, 0, {});
+  printf("  %zu bytes of markup, %zu lines, %zu pages, %u hardware threads\n", bytes, reference.layout.lines,
+         reference.layout.pages, std::thread::hardware_concurrency());
+
+  constexpr int ROUNDS = 5;
+  // No waiting on reads: the stages only overlap on a second core
+  const ReadLatency none{};
+  // Waiting on each 1KB read for about as long as parsing it takes, so a core is idle half the time without the
+  // pipeline
+  constexpr int READ_MICROS = 20;
+  const ReadLatency card{std::chrono::microseconds(READ_MICROS)};
+  // Each stage on its own: the pipeline can at best bring the total down to the slower one
+  double parseOnly = 1e9;
+  double layoutOnly = 1e9;
+  for (int round = 0; round < ROUNDS; round++) {
+    std::vector<std::vector<Item>> items(chapters.size());
+    auto start = Clock::now();
+    for (size_t i = 0; i < chapters.size(); i++) ParseStage(nullptr, nullptr, &items[i]).parse(chapters[i], none);
+    parseOnly = std::min(parseOnly, std::chrono::duration<double>(Clock::now() - start).count());
+    start = Clock::now();
+    for (auto& chapterItems : items) {
+      LayoutStage layout;
+      for (Item& item : chapterItems) layout.process(item);
+    }
+    layoutOnly = std::min(layoutOnly, std::chrono::duration<double>(Clock::now() - start).count());
+  }
+  printf("  stages alone: parse %.2f ms, layout %.2f ms\n", parseOnly * 1e3, layoutOnly * 1e3);
+
+  const double serialNone = bestOf(ROUNDS, chapters, 0, none);
+  const double serialCard = bestOf(ROUNDS, chapters, 0, card);
+  printf("  %-22s %14s %19s%d us\n", "", "CPU only", "read wait ", READ_MICROS);
+  printf("  %-22s %11.2f ms %19.2f ms\n", "inline layout", serialNone * 1e3, serialCard * 1e3);
+  for (const size_t depth : {1, 2, 4, 8}) {
+    const double pipelinedNone = bestOf(ROUNDS, chapters, depth, none);
+    const double pipelinedCard = bestOf(ROUNDS, chapters, depth, card);
+    char name[32];
+    snprintf(name, sizeof(name), "layout thread, ring %zu", depth);
+    printf("  %-22s %11.2f ms (%.2fx) %12.2f ms (%.2fx)\n", name, pipelinedNone * 1e3, serialNone / pipelinedNone,
+           pipelinedCard * 1e3, serialCard / pipelinedCard);
+  }
+  PASS();
+}
+
+int main(const int argc, char** argv) {
+  printf("=== Paragraph Pipeline Benchmark ===\n\n");
+#ifdef __linux__
+  // Sleep for the simulated reads as long as asked, not up to 50 us longer
+  prctl(PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL);
+#endif
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <directory of extracted chapters>\n", argv[0]);
+    return 1;
+  }
+  const std::vector<std::string> chapters = loadChapters(argv[1]);
+  const std::vector<std::string> novel = {syntheticChapter(400)};
+
+  testRingOrder();
+  testRingCloseDrains();
+  testRingSlotsReused();
+  testRingAbort();
+  testSamePages("test chapters", chapters);
+  testSamePages("long chapter", novel);
+  benchmark("test chapters", chapters);
+  benchmark("long chapter", novel);
+
+  printf("\n=== Results: %d passed, %d failed ===\n", testsPassed, testsFailed);
+  return testsFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "lib/FsHelpers/DirectoryListing.h"
+#include "lib/FsHelpers/DirectoryListingCache.h"
+#include "src/network/PropfindWriter.h"
+
+static int testsPassed = 0;
+static int testsFailed = 0;
+
+#define ASSERT_EQ(a, b)                                                         \
+  do {                                                                          \
+    if ((a) != (b)) {                                                           \
+      fprintf(stderr, "  FAIL: %s:%d: %s != %s\n", __FILE__, __LINE__, #a, #b); \
+      testsFailed++;                                                            \
+      return;                                                                   \
+    }                                                                           \
+  } while (0)
+
+#define ASSERT_TRUE(cond)                                                \
+  do {                                                                   \
+    if (!(cond)) {                                                       \
+      fprintf(stderr, "  FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testsFailed++;                                                     \
+      return;                                                            \
+    }                                                                    \
+  } while (0)
+
+#define PASS() testsPassed++
+
+// ============================================================================
+// Stand-in server harness
+//
+// Mirrors WebDAVHandler::handlePropfind: the directory is a DirectoryListing with metadata (what
+// DirectoryListingCache::forEach serves from), visited through the same EntryVisitor signature, and the response
+// body is collected chunk by chunk as WebServer::sendContent would send it.
+// ============================================================================
+
+struct FakeServer {
+  int status = 0;
+  std::string body;
+  size_t chunks = 0;
+  size_t largestChunk = 0;
+  size_t disconnectAfterBytes = SIZE_MAX;
+
+  bool sendContent(const char* data, const size_t length) {
+    body.append(data, length);
+    chunks++;
+    largestChunk = std::max(largestChunk, length);
+    return body.size() < disconnectAfterBytes;
+  }
+};
+
+bool sendChunk(void* context, const char* data, size_t length) {
+  return static_cast<FakeServer*>(context)->sendContent(data, length);
+}
+
+struct VisitState {
+  PropfindWriter& writer;
+  const char* collectionPath;
+  size_t count;
+};
+
+bool visitEntry(void* context, const char* name, size_t nameLength, bool isDirectory, uint32_t size,
+                uint16_t modifyDate, uint16_t modifyTime) {
+  auto* state = static_cast<VisitState*>(context);
+  state->writer.entry(state->collectionPath, {name, nameLength}, isDirectory, size, modifyDate, modifyTime);
+  state->count++;
+  return state->writer.ok();
+}
+
+constexpr DirectoryListingCache::EntryVisitor VISITOR = &visitEntry;
+
+void servePropfind(FakeServer& server, const DirectoryListing& dir, const char* depthHeader) {
+  const PropfindDepth depth = parsePropfindDepth(depthHeader);
+  if (depth == PropfindDepth::Invalid) {
+    server.status = 400;
+    return;
+  }
+  if (depth == PropfindDepth::Infinity) {
+    server.status = 403;
+    return;
+  }
+
+  server.status = 207;
+  PropfindWriter writer(&sendChunk, &server);
+  writer.begin();
+  writer.entry(dir.getPath(), {}, true, 0, dir.directoryDate, dir.directoryTime);
+  if (depth == PropfindDepth::One) {
+    VisitState state{writer, dir.getPath().c_str(), 0};
+    for (size_t i = 0; i < dir.size(); i++) {
+      const auto& e = dir.entry(i);
+      if (!VISITOR(&state, dir.nameCStr(i), e.nameLength, dir.isDirectory(i), e.size, e.modifyDate, e.modifyTime)) {
+        break;
+      }
+    }
+  }
+  writer.end();
+}
+
+constexpr uint16_t FAT_DATE = ((2024 - 1980) << 9) | (3 << 5) | 15;
+constexpr uint16_t FAT_TIME = (14 << 11) | (30 << 5) | 10;
+
+DirectoryListing makeDirectory(const char* path, const size_t entries) {
+  DirectoryListing dir(path);
+  dir.reserve(entries, entries * 32);
+  dir.directoryDate = FAT_DATE;
+  dir.directoryTime = FAT_TIME;
+  dir.hasMetadata = true;
+  char name[64];
+  for (size_t i = 0; i < entries; i++) {
+    const bool isDirectory = i % 50 == 0;
+    if (isDirectory) {
+      snprintf(name, sizeof(name), "Series %zu", i);
+    } else {
+      // Mix of spaces, reserved characters and UTF-8 to exercise href encoding
+      snprintf(name, sizeof(name), i % 7 == 0 ? "Caf\xC3\xA9 & Co #%zu.epub" : "Book %05zu - Title.epub", i);
+    }
+    dir.add(name, strlen(name), isDirectory, isDirectory ? 0 : 100000 + i, FAT_DATE, FAT_TIME);
+  }
+  return dir;
+}
+
+size_t countOccurrences(const std::string& haystack, const char* needle) {
+  size_t count = 0;
+  for (size_t pos = haystack.find(needle); pos != std::string::npos; pos = haystack.find(needle, pos + 1)) {
+    count++;
+  }
+  return count;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void testDepthParsing() {
+  printf("testDepthParsing...\n");
+  ASSERT_TRUE(parsePropfindDepth("0") == PropfindDepth::Zero);
+  ASSERT_TRUE(parsePropfindDepth("1") == PropfindDepth::One);
+  ASSERT_TRUE(parsePropfindDepth("infinity") == PropfindDepth::Infinity);
+  ASSERT_TRUE(parsePropfindDepth("Infinity") == PropfindDepth::Infinity);
+  ASSERT_TRUE(parsePropfindDepth("") == PropfindDepth::One);
+  ASSERT_TRUE(parsePropfindDepth(nullptr) == PropfindDepth::One);
+  ASSERT_TRUE(parsePropfindDepth("2") == PropfindDepth::Invalid);
+  ASSERT_TRUE(parsePropfindDepth("01") == PropfindDepth::Invalid);
+  PASS();
+}
+
+void testMimeTypes() {
+  printf("testMimeTypes...\n");
+  ASSERT_TRUE(strcmp(webDavMimeType("Book.EPUB"), "application/epub+zip") == 0);
+  ASSERT_TRUE(strcmp(webDavMimeType("notes.txt"), "text/plain") == 0);
+  ASSERT_TRUE(strcmp(webDavMimeType("cover.jpeg"), "image/jpeg") == 0);
+  ASSERT_TRUE(strcmp(webDavMimeType("cover.Jpg"), "image/jpeg") == 0);
+  ASSERT_TRUE(strcmp(webDavMimeType("sleep.bmp"), "image/bmp") == 0);
+  ASSERT_TRUE(strcmp(webDavMimeType("manual.pdf"), "application/pdf") == 0);
+  ASSERT_TRUE(strcmp(webDavMimeType("index.htm"), "text/html") == 0);
+  ASSERT_TRUE(strcmp(webDavMimeType("book.xtch"), "application/octet-stream") == 0);
+  ASSERT_TRUE(strcmp(webDavMimeType("txt"), "application/octet-stream") == 0);
+  PASS();
+}
+
+void testDepthZeroAndInfinity() {
+  printf("testDepthZeroAndInfinity...\n");
+  const DirectoryListing dir = makeDirectory("/Books", 20);
+
+  FakeServer zero;
+  servePropfind(zero, dir, "0");
+  ASSERT_EQ(zero.status, 207);
+  ASSERT_EQ(countOccurrences(zero.body, "<D:response>"), 1u);
+  ASSERT_TRUE(zero.body.find("<D:href>/Books/</D:href>") != std::string::npos);
+
+  FakeServer infinity;
+  servePropfind(infinity, dir, "infinity");
+  ASSERT_EQ(infinity.status, 403);
+  ASSERT_TRUE(infinity.body.empty());
+
+  FakeServer invalid;
+  servePropfind(invalid, dir, "banana");
+  ASSERT_EQ(invalid.status, 400);
+  PASS();
+}
+
+void testEntryFormatting() {
+  printf("testEntryFormatting...\n");
+  DirectoryListing dir("/");
+  const char* bookName = "Caf\xC3\xA9 <1>.epub";
+  dir.add(bookName, strlen(bookName), false, 1234, FAT_DATE, FAT_TIME);
+  dir.add("Comics", 6, true, 0, FAT_DATE, FAT_TIME);
+
+  FakeServer server;
+  servePropfind(server, dir, "1");
+  const std::string& b = server.body;
+  ASSERT_TRUE(b.rfind("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<D:multistatus xmlns:D=\"DAV:\">\n", 0) == 0);
+  ASSERT_TRUE(b.find("<D:href>/</D:href>") != std::string::npos);
+  ASSERT_TRUE(b.find("<D:href>/Caf%C3%A9%20%3C1%3E.epub</D:href>") != std::string::npos);
+  ASSERT_TRUE(b.find("<D:getcontentlength>1234</D:getcontentlength>") != std::string::npos);
+  ASSERT_TRUE(b.find("<D:getcontenttype>application/epub+zip</D:getcontenttype>") != std::string::npos);
+  ASSERT_TRUE(b.find("<D:href>/Comics/</D:href><D:propstat><D:prop><D:resourcetype><D:collection/>") !=
+              std::string::npos);
+  ASSERT_TRUE(b.find("<D:getlastmodified>Fri, 15 Mar 2024 14:30:20 GMT</D:getlastmodified>") != std::string::npos);
+  ASSERT_TRUE(b.size() > 17 && b.compare(b.size() - 17, 17, "</D:multistatus>\n") == 0);
+  PASS();
+}
+
+void testDisconnectStopsStreaming() {
+  printf("testDisconnectStopsStreaming...\n");
+  const DirectoryListing dir = makeDirectory("/Books", 1000);
+  FakeServer server;
+  server.disconnectAfterBytes = 8 * 1024;
+  servePropfind(server, dir, "1");
+  // Output stops at the first failed chunk rather than formatting the remaining entries
+  ASSERT_TRUE(server.body.size() < 8 * 1024 + PropfindWriter::BUFFER_SIZE);
+  PASS();
+}
+
+void testThroughput5000Entries() {
+  printf("testThroughput5000Entries...\n");
+  constexpr size_t ENTRY_COUNT = 5000;
+  constexpr int ITERATIONS = 20;
+  const DirectoryListing dir = makeDirectory("/Library/Comics", ENTRY_COUNT);
+
+  FakeServer server;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < ITERATIONS; i++) {
+    server = FakeServer{};
+    servePropfind(server, dir, "1");
+  }
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  ASSERT_EQ(server.status, 207);
+  ASSERT_EQ(countOccurrences(server.body, "<D:response>"), ENTRY_COUNT + 1);
+  ASSERT_EQ(countOccurrences(server.body, "</D:response>\n"), ENTRY_COUNT + 1);
+  ASSERT_TRUE(server.largestChunk <= PropfindWriter::BUFFER_SIZE);
+  // Chunks are full apart from the last one
+  ASSERT_EQ(server.chunks, (server.body.size() + PropfindWriter::BUFFER_SIZE - 1) / PropfindWriter::BUFFER_SIZE);
+
+  const double entriesPerSecond = ENTRY_COUNT * ITERATIONS / seconds;
+  const double megabytesPerSecond = server.body.size() * ITERATIONS / seconds / (1024.0 * 1024.0);
+  printf("  %zu entries -> %zu bytes in %zu chunks\n", ENTRY_COUNT, server.body.size(), server.chunks);
+  printf("  %.0f entries/s, %.1f MB/s of XML on this host\n", entriesPerSecond, megabytesPerSecond);
+  PASS();
+}
+
+int main() {
+  printf("=== PROPFIND Streaming Tests ===\n\n");
+
+  testDepthParsing();
+  testMimeTypes();
+  testDepthZeroAndInfinity();
+  testEntryFormatting();
+  testDisconnectStopsStreaming();
+  testThroughput5000Entries();
+
+  printf("\n=== Results: %d passed, %d failed ===\n", testsPassed, testsFailed);
+  return testsFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+// Host stand-in for the Arduino String that FsHelpers' overloads accept; the test only uses the string_view ones
+
+#include <string>
+
+class String {
+ public:
+  String() = default;
+  String(const char* value) : value(value) {}
+  const char* c_str() const { return value.c_str(); }
+  unsigned int length() const { return value.length(); }
+
+ private:
+  std::string value;
+};
@@ -0,0 +1,51 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/chapter_item_cache"
+BINARY="$BUILD_DIR/ChapterItemCacheTest"
+
+mkdir -p "$BUILD_DIR"
+
+INCLUDES=(
+  -I"$ROOT_DIR/test/chapter_item_cache/stubs"
+  -I"$ROOT_DIR/test/heap_budget/stubs"
+  -I"$ROOT_DIR"
+  -I"$ROOT_DIR/lib"
+  -I"$ROOT_DIR/lib/Epub"
+  -I"$ROOT_DIR/lib/EpdFont"
+  -I"$ROOT_DIR/lib/HeapTags"
+  -I"$ROOT_DIR/lib/Serialization"
+  -I"$ROOT_DIR/lib/Utf8"
+)
+
+SOURCES=(
+  "$ROOT_DIR/test/chapter_item_cache/ChapterItemCacheTest.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/parsers/ChapterPageBuilder.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/ParsedText.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/Page.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/blocks/TextBlock.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/HyphenationCache.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/HyphenationPack.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/Hyphenator.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/LanguageRegistry.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/LiangHyphenation.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/HyphenationCommon.cpp"
+  "$ROOT_DIR/lib/HeapTags/HeapTags.cpp"
+  "$ROOT_DIR/lib/Utf8/Utf8.cpp"
+)
+
+CXXFLAGS=(
+  -std=c++20
+  -O2
+  -Wall
+  -Wextra
+  -pedantic
+  # Serialization.h defines its helpers static in the header, and the device sources ignore some render arguments
+  -Wno-unused-function
+  -Wno-unused-parameter
+)
+
+c++ "${CXXFLAGS[@]}" "${INCLUDES[@]}" "${SOURCES[@]}" -o "$BINARY"
+
+"$BINARY" "$@"
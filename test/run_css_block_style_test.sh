@@ -0,0 +1,29 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/css_block_style"
+BINARY="$BUILD_DIR/CssBlockStyleTest"
+
+mkdir -p "$BUILD_DIR"
+
+INCLUDES=(
+  -I"$ROOT_DIR"
+  -I"$ROOT_DIR/lib/Epub"
+)
+
+SOURCES=(
+  "$ROOT_DIR/test/css_block_style/CssBlockStyleTest.cpp"
+)
+
+CXXFLAGS=(
+  -std=c++20
+  -O2
+  -Wall
+  -Wextra
+  -pedantic
+)
+
+c++ "${CXXFLAGS[@]}" "${INCLUDES[@]}" "${SOURCES[@]}" -o "$BINARY"
+
+"$BINARY" "$@"
@@ -0,0 +1,33 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/font_pack"
+BINARY="$BUILD_DIR/FontPackTest"
+
+mkdir -p "$BUILD_DIR"
+
+SOURCES=(
+  "$ROOT_DIR/test/font_pack/FontPackTest.cpp"
+  "$ROOT_DIR/lib/EpdFont/EpdFontPack.cpp"
+  "$ROOT_DIR/lib/EpdFont/EpdFont.cpp"
+  "$ROOT_DIR/lib/Utf8/Utf8.cpp"
+)
+
+CXXFLAGS=(
+  -std=c++20
+  -O2
+  -Wall
+  -Wextra
+  -pedantic
+  -I"$ROOT_DIR"
+  -I"$ROOT_DIR/lib/EpdFont"
+  -I"$ROOT_DIR/lib/Utf8"
+)
+
+c++ "${CXXFLAGS[@]}" "${SOURCES[@]}" -o "$BINARY"
+
+PACK_DIR="$BUILD_DIR/packs"
+"$ROOT_DIR/lib/EpdFont/scripts/build-font-packs.sh" "$PACK_DIR" 2>/dev/null
+
+FONT_PACK_DIR="$PACK_DIR" "$BINARY" "$@"
@@ -0,0 +1,62 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/heap_budget"
+BINARY="$BUILD_DIR/HeapBudgetBenchmark"
+
+mkdir -p "$BUILD_DIR"
+
+# Same expat configuration as platformio.ini
+CDEFS=(
+  -DXML_GE=0
+  -DXML_CONTEXT_BYTES=1024
+)
+
+INCLUDES=(
+  -I"$ROOT_DIR/test/heap_budget/stubs"
+  -I"$ROOT_DIR"
+  -I"$ROOT_DIR/lib/HeapTags"
+  -I"$ROOT_DIR/lib/XmlParserUtils"
+  -I"$ROOT_DIR/lib/expat"
+  -I"$ROOT_DIR/lib/uzlib/src"
+  -I"$ROOT_DIR/lib/InflateReader"
+  -I"$ROOT_DIR/lib/EpdFont"
+  -I"$ROOT_DIR/lib/Utf8"
+)
+
+C_SOURCES=(
+  "$ROOT_DIR/lib/expat/xmlparse.c"
+  "$ROOT_DIR/lib/expat/xmlrole.c"
+  "$ROOT_DIR/lib/expat/xmltok.c"
+  "$ROOT_DIR/lib/uzlib/src/tinflate.c"
+)
+
+SOURCES=(
+  "$ROOT_DIR/test/heap_budget/HeapBudgetBenchmark.cpp"
+  "$ROOT_DIR/lib/HeapTags/HeapTags.cpp"
+  "$ROOT_DIR/lib/InflateReader/InflateReader.cpp"
+  "$ROOT_DIR/lib/EpdFont/FontDecompressor.cpp"
+  "$ROOT_DIR/lib/Utf8/Utf8.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/css/CssParser.cpp"
+)
+
+CXXFLAGS=(
+  -std=c++20
+  -O2
+  -Wall
+  -Wextra
+  -pedantic
+)
+
+# uzlib ships only tinflate.c; like the firmware link, drop its unused checksum entry point
+OBJECTS=()
+for src in "${C_SOURCES[@]}"; do
+  obj="$BUILD_DIR/$(basename "${src%.c}").o"
+  cc -O2 -ffunction-sections "${CDEFS[@]}" "${INCLUDES[@]}" -c "$src" -o "$obj"
+  OBJECTS+=("$obj")
+done
+
+c++ "${CXXFLAGS[@]}" "${CDEFS[@]}" "${INCLUDES[@]}" "${SOURCES[@]}" "${OBJECTS[@]}" -Wl,--gc-sections -o "$BINARY"
+
+"$BINARY" "${1:-$ROOT_DIR/test/heap_budget/budgets.txt}"
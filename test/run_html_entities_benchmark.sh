@@ -0,0 +1,26 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/html_entities"
+BINARY="$BUILD_DIR/HtmlEntitiesBenchmark"
+
+mkdir -p "$BUILD_DIR"
+
+# The benchmark includes lib/Epub/Epub/htmlEntities.cpp itself
+SOURCES=(
+  "$ROOT_DIR/test/html_entities/HtmlEntitiesBenchmark.cpp"
+)
+
+CXXFLAGS=(
+  -std=c++20
+  -O2
+  -Wall
+  -Wextra
+  -pedantic
+  -I"$ROOT_DIR"
+)
+
+c++ "${CXXFLAGS[@]}" "${SOURCES[@]}" -o "$BINARY"
+
+"$BINARY" "$@"
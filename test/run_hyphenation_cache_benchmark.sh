@@ -0,0 +1,43 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/hyphenation_cache"
+BINARY="$BUILD_DIR/HyphenationCacheBenchmark"
+
+mkdir -p "$BUILD_DIR"
+
+SOURCES=(
+  "$ROOT_DIR/test/hyphenation_cache/HyphenationCacheBenchmark.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/HyphenationCache.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/HyphenationPack.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/Hyphenator.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/LanguageRegistry.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/LiangHyphenation.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/HyphenationCommon.cpp"
+  "$ROOT_DIR/lib/HeapTags/HeapTags.cpp"
+  "$ROOT_DIR/lib/Utf8/Utf8.cpp"
+)
+
+CXXFLAGS=(
+  -std=c++20
+  -O2
+  -Wall
+  -Wextra
+  -pedantic
+  -I"$ROOT_DIR"
+  -I"$ROOT_DIR/lib"
+  -I"$ROOT_DIR/lib/HeapTags"
+  -I"$ROOT_DIR/lib/Utf8"
+)
+
+c++ "${CXXFLAGS[@]}" "${SOURCES[@]}" -o "$BINARY"
+
+# Languages other than English are read from pattern packs, as on the device
+PACK_DIR="$ROOT_DIR/build/hyphenation_packs"
+"$ROOT_DIR/test/hyphenation_pack/build_packs.sh" "$PACK_DIR"
+
+if [ "$#" -eq 0 ]; then
+  set -- "$ROOT_DIR/test/hyphenation_eval/resources/german_hyphenation_tests.txt"
+fi
+HYPHENATION_PACK_DIR="$PACK_DIR" "$BINARY" "$@"
@@ -9,10 +9,13 @@ mkdir -p "$BUILD_DIR"
 
 SOURCES=(
   "$ROOT_DIR/test/hyphenation_eval/HyphenationEvaluationTest.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/HyphenationCache.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/HyphenationPack.cpp"
   "$ROOT_DIR/lib/Epub/Epub/hyphenation/Hyphenator.cpp"
   "$ROOT_DIR/lib/Epub/Epub/hyphenation/LanguageRegistry.cpp"
   "$ROOT_DIR/lib/Epub/Epub/hyphenation/LiangHyphenation.cpp"
   "$ROOT_DIR/lib/Epub/Epub/hyphenation/HyphenationCommon.cpp"
+  "$ROOT_DIR/lib/HeapTags/HeapTags.cpp"
   "$ROOT_DIR/lib/Utf8/Utf8.cpp"
 )
 
@@ -24,9 +27,14 @@ CXXFLAGS=(
   -pedantic
   -I"$ROOT_DIR"
   -I"$ROOT_DIR/lib"
+  -I"$ROOT_DIR/lib/HeapTags"
   -I"$ROOT_DIR/lib/Utf8"
 )
 
 c++ "${CXXFLAGS[@]}" "${SOURCES[@]}" -o "$BINARY"
 
-"$BINARY" "$@"
+# Languages other than English are read from pattern packs, as on the device
+PACK_DIR="$ROOT_DIR/build/hyphenation_packs"
+"$ROOT_DIR/test/hyphenation_pack/build_packs.sh" "$PACK_DIR"
+
+HYPHENATION_PACK_DIR="$PACK_DIR" "$BINARY" "$@"
@@ -0,0 +1,30 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/page_cache"
+BINARY="$BUILD_DIR/PageCacheTest"
+
+mkdir -p "$BUILD_DIR"
+
+INCLUDES=(
+  -I"$ROOT_DIR"
+  -I"$ROOT_DIR/lib/Epub"
+)
+
+SOURCES=(
+  "$ROOT_DIR/test/page_cache/PageCacheTest.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/PageCache.cpp"
+)
+
+CXXFLAGS=(
+  -std=c++20
+  -O2
+  -Wall
+  -Wextra
+  -pedantic
+)
+
+c++ "${CXXFLAGS[@]}" "${INCLUDES[@]}" "${SOURCES[@]}" -o "$BINARY"
+
+"$BINARY" "$@"
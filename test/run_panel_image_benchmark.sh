@@ -0,0 +1,31 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/panel_image"
+BINARY="$BUILD_DIR/PanelImageBenchmark"
+
+mkdir -p "$BUILD_DIR"
+
+SOURCES=(
+  "$ROOT_DIR/test/panel_image/PanelImageBenchmark.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/converters/PanelImage.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/converters/ImagePlaneCache.cpp"
+  "$ROOT_DIR/lib/HeapTags/HeapTags.cpp"
+)
+
+CXXFLAGS=(
+  -std=c++20
+  -O2
+  -Wall
+  -Wextra
+  -pedantic
+  -I"$ROOT_DIR"
+  -I"$ROOT_DIR/test/panel_image/stubs"
+  -I"$ROOT_DIR/test/heap_budget/stubs"
+  -I"$ROOT_DIR/lib/HeapTags"
+)
+
+c++ "${CXXFLAGS[@]}" "${SOURCES[@]}" -o "$BINARY"
+
+"$BINARY" "$@"
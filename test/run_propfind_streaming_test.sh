@@ -0,0 +1,32 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/propfind_streaming"
+BINARY="$BUILD_DIR/PropfindStreamingTest"
+
+mkdir -p "$BUILD_DIR"
+
+SOURCES=(
+  "$ROOT_DIR/test/propfind_streaming/PropfindStreamingTest.cpp"
+  "$ROOT_DIR/src/network/PropfindWriter.cpp"
+  "$ROOT_DIR/src/network/HttpConditional.cpp"
+  "$ROOT_DIR/lib/FsHelpers/DirectoryListing.cpp"
+  "$ROOT_DIR/lib/FsHelpers/FsHelpers.cpp"
+)
+
+CXXFLAGS=(
+  -std=c++20
+  -O2
+  -Wall
+  -Wextra
+  -pedantic
+  -I"$ROOT_DIR"
+  -I"$ROOT_DIR/src/network"
+  -I"$ROOT_DIR/lib/FsHelpers"
+  -I"$ROOT_DIR/test/propfind_streaming/stubs"
+)
+
+c++ "${CXXFLAGS[@]}" "${SOURCES[@]}" -o "$BINARY"
+
+"$BINARY" "$@"
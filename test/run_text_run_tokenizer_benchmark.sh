@@ -0,0 +1,68 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/text_run_tokenizer"
+BINARY="$BUILD_DIR/TextRunTokenizerBenchmark"
+CHAPTER_DIR="$BUILD_DIR/chapters"
+
+mkdir -p "$BUILD_DIR"
+
+# The chapters of the test EPUBs
+rm -rf "$CHAPTER_DIR"
+python3 - "$CHAPTER_DIR" "$ROOT_DIR"/test/epubs/*.epub <<'EOF'
+import os, sys, zipfile
+out = sys.argv[1]
+for epub in sys.argv[2:]:
+    with zipfile.ZipFile(epub) as archive:
+        for name in archive.namelist():
+            if name.endswith((".xhtml", ".html")):
+                target = os.path.join(out, os.path.basename(epub)[:-5], name)
+                os.makedirs(os.path.dirname(target), exist_ok=True)
+                with open(target, "wb") as f:
+                    f.write(archive.read(name))
+EOF
+
+# Same expat configuration as platformio.ini
+CDEFS=(
+  -DXML_GE=0
+  -DXML_CONTEXT_BYTES=1024
+)
+
+INCLUDES=(
+  -I"$ROOT_DIR"
+  -I"$ROOT_DIR/lib/expat"
+  -I"$ROOT_DIR/lib/Utf8"
+)
+
+C_SOURCES=(
+  "$ROOT_DIR/lib/expat/xmlparse.c"
+  "$ROOT_DIR/lib/expat/xmlrole.c"
+  "$ROOT_DIR/lib/expat/xmltok.c"
+)
+
+SOURCES=(
+  "$ROOT_DIR/test/text_run_tokenizer/TextRunTokenizerBenchmark.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/parsers/TextRunTokenizer.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/htmlEntities.cpp"
+  "$ROOT_DIR/lib/Utf8/Utf8.cpp"
+)
+
+CXXFLAGS=(
+  -std=c++20
+  -O2
+  -Wall
+  -Wextra
+  -pedantic
+)
+
+OBJECTS=()
+for src in "${C_SOURCES[@]}"; do
+  obj="$BUILD_DIR/$(basename "${src%.c}").o"
+  cc -O2 "${CDEFS[@]}" "${INCLUDES[@]}" -c "$src" -o "$obj"
+  OBJECTS+=("$obj")
+done
+
+c++ "${CXXFLAGS[@]}" "${CDEFS[@]}" "${INCLUDES[@]}" "${SOURCES[@]}" "${OBJECTS[@]}" -o "$BINARY"
+
+"$BINARY" "$CHAPTER_DIR"
@@ -0,0 +1,31 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/txt_block_parser"
+BINARY="$BUILD_DIR/TxtBlockParserTest"
+
+mkdir -p "$BUILD_DIR"
+
+INCLUDES=(
+  -I"$ROOT_DIR"
+  -I"$ROOT_DIR/lib/EpdFont"
+  -I"$ROOT_DIR/lib/Txt"
+)
+
+SOURCES=(
+  "$ROOT_DIR/test/txt_block_parser/TxtBlockParserTest.cpp"
+  "$ROOT_DIR/lib/Txt/TxtBlockParser.cpp"
+)
+
+CXXFLAGS=(
+  -std=c++20
+  -O2
+  -Wall
+  -Wextra
+  -pedantic
+)
+
+c++ "${CXXFLAGS[@]}" "${INCLUDES[@]}" "${SOURCES[@]}" -o "$BINARY"
+
+"$BINARY" "$@"
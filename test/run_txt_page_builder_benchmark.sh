@@ -0,0 +1,54 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/txt_page_builder"
+BINARY="$BUILD_DIR/TxtPageBuilderBenchmark"
+
+mkdir -p "$BUILD_DIR"
+
+# The layout stubs of the chapter item cache test: a measuring GfxRenderer and an in-memory FsFile
+INCLUDES=(
+  -I"$ROOT_DIR/test/chapter_item_cache/stubs"
+  -I"$ROOT_DIR/test/heap_budget/stubs"
+  -I"$ROOT_DIR"
+  -I"$ROOT_DIR/lib"
+  -I"$ROOT_DIR/lib/Epub"
+  -I"$ROOT_DIR/lib/EpdFont"
+  -I"$ROOT_DIR/lib/HeapTags"
+  -I"$ROOT_DIR/lib/Serialization"
+  -I"$ROOT_DIR/lib/Txt"
+  -I"$ROOT_DIR/lib/Utf8"
+)
+
+SOURCES=(
+  "$ROOT_DIR/test/txt_page_builder/TxtPageBuilderBenchmark.cpp"
+  "$ROOT_DIR/lib/Txt/TxtBlockParser.cpp"
+  "$ROOT_DIR/lib/Txt/TxtPageBuilder.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/ParsedText.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/Page.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/blocks/TextBlock.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/HyphenationCache.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/HyphenationPack.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/Hyphenator.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/LanguageRegistry.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/LiangHyphenation.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/HyphenationCommon.cpp"
+  "$ROOT_DIR/lib/HeapTags/HeapTags.cpp"
+  "$ROOT_DIR/lib/Utf8/Utf8.cpp"
+)
+
+CXXFLAGS=(
+  -std=c++20
+  -O2
+  -Wall
+  -Wextra
+  -pedantic
+  # Serialization.h defines its helpers static in the header, and the device sources ignore some render arguments
+  -Wno-unused-function
+  -Wno-unused-parameter
+)
+
+c++ "${CXXFLAGS[@]}" "${INCLUDES[@]}" "${SOURCES[@]}" -o "$BINARY"
+
+"$BINARY" "$@"
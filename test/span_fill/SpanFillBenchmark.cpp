@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "lib/GfxRenderer/SpanFill.h"
+
+static int testsPassed = 0;
+static int testsFailed = 0;
+
+#define ASSERT_EQ(a, b)                                                         \
+  do {                                                                          \
+    if ((a) != (b)) {                                                           \
+      fprintf(stderr, "  FAIL: %s:%d: %s != %s\n", __FILE__, __LINE__, #a, #b); \
+      testsFailed++;                                                            \
+      return;                                                                   \
+    }                                                                           \
+  } while (0)
+
+#define ASSERT_TRUE(cond)                                                \
+  do {                                                                   \
+    if (!(cond)) {                                                       \
+      fprintf(stderr, "  FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testsFailed++;                                                     \
+      return;                                                            \
+    }                                                                    \
+  } while (0)
+
+#define PASS() testsPassed++
+
+using SpanFill::Fill;
+using SpanFill::Orientation;
+
+// X4 panel geometry (HalDisplay::DISPLAY_WIDTH x DISPLAY_HEIGHT, native landscape)
+constexpr int PANEL_WIDTH = 800;
+constexpr int PANEL_HEIGHT = 480;
+constexpr int STRIDE = PANEL_WIDTH / 8;
+constexpr size_t FRAME_SIZE = STRIDE * PANEL_HEIGHT;
+
+constexpr Orientation ORIENTATIONS[] = {SpanFill::Portrait, SpanFill::LandscapeClockwise, SpanFill::PortraitInverted,
+                                        SpanFill::LandscapeCounterClockwise};
+constexpr const char* ORIENTATION_NAMES[] = {"portrait", "landscape-cw", "portrait-inverted", "landscape-ccw"};
+constexpr Fill FILLS[] = {Fill::Black, Fill::White, Fill::LightGray, Fill::DarkGray};
+
+static bool isPortrait(const Orientation o) { return o == SpanFill::Portrait || o == SpanFill::PortraitInverted; }
+static int logicalWidth(const Orientation o) { return isPortrait(o) ? PANEL_HEIGHT : PANEL_WIDTH; }
+static int logicalHeight(const Orientation o) { return isPortrait(o) ? PANEL_WIDTH : PANEL_HEIGHT; }
+
+// ============================================================================
+// Reference: the per-pixel path GfxRenderer used before, i.e. drawPixel() / drawPixelDither() for every pixel
+// ============================================================================
+
+struct Reference {
+  uint8_t* frame;
+  Orientation orientation;
+  FrameDiff::Rect dirty;
+
+  void drawPixel(const int x, const int y, const bool state) {
+    int phyX = 0;
+    int phyY = 0;
+    SpanFill::toPhysical(orientation, x, y, &phyX, &phyY, PANEL_WIDTH, PANEL_HEIGHT);
+    if (phyX < 0 || phyX >= PANEL_WIDTH || phyY < 0 || phyY >= PANEL_HEIGHT) {
+      return;
+    }
+    const uint32_t byteIndex = static_cast<uint32_t>(phyY) * STRIDE + (phyX / 8);
+    const uint8_t bitPosition = 7 - (phyX % 8);
+    dirty.include(phyX, phyY);
+    if (state) {
+      frame[byteIndex] &= ~(1 << bitPosition);
+    } else {
+      frame[byteIndex] |= 1 << bitPosition;
+    }
+  }
+
+  void fillRect(const int x, const int y, const int width, const int height, const Fill fill) {
+    for (int fillY = y; fillY < y + height; fillY++) {
+      for (int fillX = x; fillX < x + width; fillX++) {
+        drawPixel(fillX, fillY, SpanFill::isBlack(fill, fillX, fillY));
+      }
+    }
+  }
+};
+
+static FrameDiff::Rect spanFill(uint8_t* frame, const Orientation orientation, const int x, const int y,
+                                const int width, const int height, const Fill fill) {
+  const SpanFill::Surface surface{frame, PANEL_WIDTH, PANEL_HEIGHT, STRIDE};
+  return SpanFill::fillRect(surface, orientation, x, y, width, height, fill);
+}
+
+static bool sameRect(const FrameDiff::Rect& a, const FrameDiff::Rect& b) {
+  return (a.empty() && b.empty()) || (a.x0 == b.x0 && a.y0 == b.y0 && a.x1 == b.x1 && a.y1 == b.y1);
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void testOrientationRoundTrip() {
+  printf("testOrientationRoundTrip...\n");
+  for (const Orientation o : ORIENTATIONS) {
+    for (const auto& p : {std::pair{0, 0}, std::pair{1, 2}, std::pair{logicalWidth(o) - 1, logicalHeight(o) - 1}}) {
+      int phyX = 0, phyY = 0, x = 0, y = 0;
+      SpanFill::toPhysical(o, p.first, p.second, &phyX, &phyY, PANEL_WIDTH, PANEL_HEIGHT);
+      ASSERT_TRUE(phyX >= 0 && phyX < PANEL_WIDTH && phyY >= 0 && phyY < PANEL_HEIGHT);
+      SpanFill::toLogical(o, phyX, phyY, &x, &y, PANEL_WIDTH, PANEL_HEIGHT);
+      ASSERT_EQ(x, p.first);
+      ASSERT_EQ(y, p.second);
+    }
+  }
+  PASS();
+}
+
+void testMatchesPerPixelFill() {
+  printf("testMatchesPerPixelFill...\n");
+  std::mt19937 rng(41);
+  std::vector<uint8_t> expected(FRAME_SIZE);
+  std::vector<uint8_t> actual(FRAME_SIZE);
+  int cases = 0;
+  for (size_t oi = 0; oi < 4; oi++) {
+    const Orientation o = ORIENTATIONS[oi];
+    for (const Fill fill : FILLS) {
+      for (int i = 0; i < 300; i++) {
+        // Mostly small rects at every bit offset, some crossing the panel edges
+        const int w = 1 + static_cast<int>(rng() % (i % 10 == 0 ? logicalWidth(o) : 40));
+        const int h = 1 + static_cast<int>(rng() % (i % 10 == 0 ? logicalHeight(o) : 40));
+        const int x = static_cast<int>(rng() % (logicalWidth(o) + 40)) - 20;
+        const int y = static_cast<int>(rng() % (logicalHeight(o) + 40)) - 20;
+
+        for (size_t b = 0; b < FRAME_SIZE; b++) expected[b] = static_cast<uint8_t>(rng());
+        actual = expected;
+        Reference ref{expected.data(), o, {}};
+        ref.fillRect(x, y, w, h, fill);
+        const FrameDiff::Rect written = spanFill(actual.data(), o, x, y, w, h, fill);
+        if (actual != expected || !sameRect(written, ref.dirty)) {
+          fprintf(stderr, "  %s: %dx%d at (%d, %d), fill %d differs\n", ORIENTATION_NAMES[oi], w, h, x, y,
+                  static_cast<int>(fill));
+          testsFailed++;
+          return;
+        }
+        cases++;
+      }
+    }
+  }
+  printf("  %d rects identical to the per-pixel path\n", cases);
+  PASS();
+}
+
+void testEdgeBytes() {
+  printf("testEdgeBytes...\n");
+  uint8_t row[4] = {0xFF, 0xFF, 0xFF, 0xFF};
+  SpanFill::fillRow(row, 3, 5, 0x00);
+  ASSERT_EQ(row[0], 0xE3);
+  SpanFill::fillRow(row, 6, 25, 0x00);
+  ASSERT_EQ(row[0], 0xE0);
+  ASSERT_EQ(row[1], 0x00);
+  ASSERT_EQ(row[2], 0x00);
+  ASSERT_EQ(row[3], 0x3F);
+  SpanFill::fillRow(row, 0, 31, 0xAA);
+  ASSERT_EQ(row[0], 0xAA);
+  ASSERT_EQ(row[3], 0xAA);
+  PASS();
+}
+
+void testEmptyAndOffscreen() {
+  printf("testEmptyAndOffscreen...\n");
+  std::vector<uint8_t> frame(FRAME_SIZE, 0xFF);
+  ASSERT_TRUE(spanFill(frame.data(), SpanFill::Portrait, 10, 10, 0, 5, Fill::Black).empty());
+  ASSERT_TRUE(spanFill(frame.data(), SpanFill::Portrait, 10, 10, 5, -1, Fill::Black).empty());
+  ASSERT_TRUE(spanFill(frame.data(), SpanFill::Portrait, -50, 10, 20, 5, Fill::Black).empty());
+  ASSERT_TRUE(spanFill(frame.data(), SpanFill::LandscapeCounterClockwise, 800, 0, 5, 5, Fill::Black).empty());
+  ASSERT_TRUE(std::vector<uint8_t>(FRAME_SIZE, 0xFF) == frame);
+  PASS();
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+
+struct Shape {
+  const char* name;
+  int x, y, w, h;  // Portrait layout, clamped to the landscape screen; a zero size spans the screen
+  Fill fill;
+};
+
+void benchmarkFills() {
+  printf("benchmarkFills...\n");
+  // Typical UI work: clearing the screen, a menu's selection highlight, a gray button and a thin separator
+  const Shape shapes[] = {
+      {"full screen white", 0, 0, 0, 0, Fill::White},
+      {"menu highlight 440x40", 20, 200, 440, 40, Fill::Black},
+      {"gray button 200x60", 140, 600, 200, 60, Fill::LightGray},
+      {"dark gray panel Wx120", 0, 680, 0, 120, Fill::DarkGray},
+      {"separator 440x1", 20, 300, 440, 1, Fill::Black},
+  };
+  constexpr int ITERATIONS = 50;
+  std::vector<uint8_t> frame(FRAME_SIZE, 0xFF);
+  uint32_t checksum = 0;
+
+  for (size_t oi = 0; oi < 4; oi++) {
+    const Orientation o = ORIENTATIONS[oi];
+    printf("  %s\n", ORIENTATION_NAMES[oi]);
+    for (const Shape& s : shapes) {
+      const int w = s.w == 0 ? logicalWidth(o) : std::min(s.w, logicalWidth(o));
+      const int h = s.h == 0 ? logicalHeight(o) : std::min(s.h, logicalHeight(o));
+      const int x = std::min(s.x, logicalWidth(o) - w);
+      const int y = std::min(s.y, logicalHeight(o) - h);
+
+      Reference ref{frame.data(), o, {}};
+      auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < ITERATIONS; i++) {
+        ref.fillRect(x, y, w, h, s.fill);
+        checksum += frame[(i * 97) % FRAME_SIZE];
+      }
+      const double pixelMs =
+          std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / ITERATIONS;
+
+      start = std::chrono::steady_clock::now();
+      for (int i = 0; i < ITERATIONS; i++) {
+        spanFill(frame.data(), o, x, y, w, h, s.fill);
+        checksum += frame[(i * 97) % FRAME_SIZE];
+      }
+      const double spanMs =
+          std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / ITERATIONS;
+
+      printf("    %-26s per-pixel %8.4f ms  span %8.4f ms  (%.0fx)\n", s.name, pixelMs, spanMs,
+             spanMs > 0 ? pixelMs / spanMs : 0.0);
+    }
+  }
+  printf("  checksum %u\n", checksum);
+  PASS();
+}
+
+int main() {
+  printf("=== Span Fill Tests ===\n\n");
+
+  testOrientationRoundTrip();
+  testMatchesPerPixelFill();
+  testEdgeBytes();
+  testEmptyAndOffscreen();
+  benchmarkFills();
+
+  printf("\n=== Results: %d passed, %d failed ===\n", testsPassed, testsFailed);
+  return testsFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,433 @@
+#include <expat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "lib/Epub/Epub/htmlEntities.h"
+#include "lib/Epub/Epub/parsers/TextRunTokenizer.h"
+#include "lib/Utf8/Utf8.h"
+
+static int testsPassed = 0;
+static int testsFailed = 0;
+
+#define ASSERT_EQ(a, b)                                                         \
+  do {                                                                          \
+    if ((a) != (b)) {                                                           \
+      fprintf(stderr, "  FAIL: %s:%d: %s != %s\n", __FILE__, __LINE__, #a, #b); \
+      testsFailed++;                                                            \
+      return;                                                                   \
+    }                                                                           \
+  } while (0)
+
+#define ASSERT_TRUE(cond)                                                \
+  do {                                                                   \
+    if (!(cond)) {                                                       \
+      fprintf(stderr, "  FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testsFailed++;                                                     \
+      return;                                                            \
+    }                                                                    \
+  } while (0)
+
+#define PASS() testsPassed++
+
+using Sink = TextRunTokenizer::Sink;
+
+// The byte-at-a-time loop ChapterHtmlSlimParser::characterData used before TextRunTokenizer, as the reference
+class LegacyTokenizer {
+ public:
+  static constexpr int MAX_WORD_SIZE = 200;
+
+  explicit LegacyTokenizer(Sink& sink) : sink(sink) {}
+
+  void feed(const char* s, const size_t size) {
+    const int len = static_cast<int>(size);
+    for (int i = 0; i < len; i++) {
+      if (s[i] == ' ' || s[i] == '\r' || s[i] == '\n' || s[i] == '\t') {
+        flush();
+        sink.wordBreak();
+        continue;
+      }
+      if ((static_cast<uint8_t>(s[i]) == 0xC2 && i + 1 < len && static_cast<uint8_t>(s[i + 1]) == 0xA0) ||
+          (static_cast<uint8_t>(s[i]) == 0xE2 && i + 2 < len && static_cast<uint8_t>(s[i + 1]) == 0x80 &&
+           static_cast<uint8_t>(s[i + 2]) == 0xAF)) {
+        flush();
+        sink.noBreakSpace();
+        i += static_cast<uint8_t>(s[i]) == 0xC2 ? 1 : 2;
+        continue;
+      }
+      if (static_cast<uint8_t>(s[i]) == 0xEF && i + 2 < len && static_cast<uint8_t>(s[i + 1]) == 0xBB &&
+          static_cast<uint8_t>(s[i + 2]) == 0xBF) {
+        i += 2;
+        continue;
+      }
+      if (index >= MAX_WORD_SIZE) {
+        const int safeLen = utf8SafeTruncateBuffer(buffer, index);
+        if (safeLen < index && safeLen > 0) {
+          const int overflow = index - safeLen;
+          char saved[4];
+          memcpy(saved, buffer + safeLen, overflow);
+          index = safeLen;
+          flush();
+          memcpy(buffer, saved, overflow);
+          index = overflow;
+        } else {
+          flush();
+        }
+      }
+      buffer[index++] = s[i];
+    }
+  }
+
+  void flush() {
+    if (index > 0) {
+      buffer[index] = '\0';
+      sink.addWord(buffer, strlen(buffer));
+      index = 0;
+    }
+  }
+
+ private:
+  Sink& sink;
+  char buffer[MAX_WORD_SIZE + 1] = {};
+  int index = 0;
+};
+
+// Everything the tokenizer reported, in order: words end in '\0', breaks are "|", no-break spaces "~"
+class RecordingSink final : public Sink {
+ public:
+  std::string events;
+  size_t words = 0;
+  size_t longestWord = 0;
+
+  void addWord(const char* word, const size_t length) override {
+    events.append(word, length).push_back('\0');
+    words++;
+    longestWord = std::max(longestWord, length);
+  }
+  // A break after a break changes nothing
+  void wordBreak() override {
+    if (events.empty() || events.back() != '|') events.push_back('|');
+  }
+  void noBreakSpace() override { events.push_back('~'); }
+};
+
+// Only counts, so the timing is the tokenizer's
+class CountingSink final : public Sink {
+ public:
+  size_t words = 0;
+  size_t bytes = 0;
+
+  void addWord(const char*, const size_t length) override {
+    words++;
+    bytes += length;
+  }
+  void wordBreak() override {}
+  void noBreakSpace() override {}
+};
+
+// ============================================================================
+// Feeding chapters through expat like ChapterHtmlSlimParser::parseAndBuildPages
+// ============================================================================
+
+template <typename Tokenizer>
+struct ParseContext {
+  Tokenizer& tokenizer;
+  int skipDepth = 0;  // Inside <head>
+
+  static void XMLCALL startElement(void* userData, const XML_Char* name, const XML_Char**) {
+    auto* self = static_cast<ParseContext*>(userData);
+    // The parser hands the word over at element boundaries (style changes, blocks)
+    self->tokenizer.flush();
+    if (self->skipDepth > 0 || strcmp(name, "head") == 0) self->skipDepth++;
+  }
+  static void XMLCALL endElement(void* userData, const XML_Char*) {
+    auto* self = static_cast<ParseContext*>(userData);
+    self->tokenizer.flush();
+    if (self->skipDepth > 0) self->skipDepth--;
+  }
+  static void XMLCALL characterData(void* userData, const XML_Char* s, const int len) {
+    auto* self = static_cast<ParseContext*>(userData);
+    if (self->skipDepth == 0) self->tokenizer.feed(s, static_cast<size_t>(len));
+  }
+  static void XMLCALL defaultHandlerExpand(void* userData, const XML_Char* s, const int len) {
+    if (len >= 3 && s[0] == '&' && s[len - 1] == ';') {
+      const char* utf8Value = lookupCommonHtmlEntity(s, static_cast<size_t>(len));
+      if (utf8Value == nullptr) utf8Value = lookupHtmlEntity(s, static_cast<size_t>(len));
+      if (utf8Value != nullptr) {
+        characterData(userData, utf8Value, static_cast<int>(strlen(utf8Value)));
+      } else {
+        characterData(userData, s, len);
+      }
+    }
+  }
+};
+
+template <typename Tokenizer>
+static bool parseChapter(const std::string& xhtml, Tokenizer& tokenizer, const size_t chunkSize) {
+  ParseContext<Tokenizer> context{tokenizer};
+  XML_Parser parser = XML_ParserCreate(nullptr);
+  XML_SetDefaultHandlerExpand(parser, ParseContext<Tokenizer>::defaultHandlerExpand);
+  XML_SetUserData(parser, &context);
+  XML_SetElementHandler(parser, ParseContext<Tokenizer>::startElement, ParseContext<Tokenizer>::endElement);
+  XML_SetCharacterDataHandler(parser, ParseContext<Tokenizer>::characterData);
+  bool ok = true;
+  for (size_t offset = 0; ok && offset < xhtml.size(); offset += chunkSize) {
+    const size_t chunk = std::min(chunkSize, xhtml.size() - offset);
+    const bool done = offset + chunk == xhtml.size();
+    ok = XML_Parse(parser, xhtml.data() + offset, static_cast<int>(chunk), done) != XML_STATUS_ERROR;
+  }
+  if (!ok) {
+    fprintf(stderr, "  parse error: %s\n", XML_ErrorString(XML_GetErrorCode(parser)));
+  }
+  XML_ParserFree(parser);
+  tokenizer.flush();
+  return ok;
+}
+
+static std::vector<std::string> loadChapters(const char* dir) {
+  std::vector<std::filesystem::path> paths;
+  for (const auto& entry : std::filesystem::recursive_directory_iterator(dir)) {
+    const auto extension = entry.path().extension();
+    if (entry.is_regular_file() && (extension == ".xhtml" || extension == ".html")) paths.push_back(entry.path());
+  }
+  std::sort(paths.begin(), paths.end());
+  std::vector<std::string> chapters;
+  for (const auto& path : paths) {
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream content;
+    content << file.rdbuf();
+    chapters.push_back(content.str());
+  }
+  return chapters;
+}
+
+// Both tokenizers, fed the same chunks, report the same events
+static bool sameEvents(const std::vector<std::string>& chunks, std::string* events = nullptr) {
+  RecordingSink legacySink;
+  RecordingSink runSink;
+  LegacyTokenizer legacy(legacySink);
+  TextRunTokenizer tokenizer(runSink);
+  for (const auto& chunk : chunks) {
+    legacy.feed(chunk.data(), chunk.size());
+    tokenizer.feed(chunk.data(), chunk.size());
+  }
+  legacy.flush();
+  tokenizer.flush();
+  if (events) *events = runSink.events;
+  if (legacySink.events != runSink.events) {
+    fprintf(stderr, "  token streams differ (%zu vs %zu bytes)\n", legacySink.events.size(), runSink.events.size());
+    return false;
+  }
+  return true;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+static std::string repeat(const char* piece, const size_t count) {
+  std::string result;
+  for (size_t i = 0; i < count; i++) result += piece;
+  return result;
+}
+
+static const std::vector<std::string>& syntheticTexts() {
+  static const std::vector<std::string> texts = {
+      "The quick brown fox\tjumps over\r\nthe lazy dog.  ",
+      "200\xC2\xA0Quadratkilometer and 5\xE2\x80\xAF%, \xC2\xA9 2024 \xE2\x80\x94 em dash",
+      "\xEF\xBB\xBFstart zero\xEF\xBB\xBFwidth and \xEF\xBC\x81 fullwidth",
+      repeat("a", 450) + " tail",
+      repeat("\xE6\xBC\xA2", 150) + "\xE5\xAD\x97 end",  // CJK without spaces
+      repeat("x", 199) + "\xC3\xA9" + repeat("y", 250),  // 2-byte character across the cut
+      "\x01\x02 control\x1F" + repeat("z", 200) + "\xC2\xA0" + repeat("w", 201),
+  };
+  return texts;
+}
+
+static void testSyntheticWhole() {
+  printf("testSyntheticWhole...\n");
+  for (const auto& text : syntheticTexts()) {
+    ASSERT_TRUE(sameEvents({text}));
+  }
+  std::string events;
+  ASSERT_TRUE(sameEvents({"200\xC2\xA0km, a\xEF\xBB\xBF" "b"}, &events));
+  ASSERT_EQ(events, std::string("200\0~km,\0|ab\0", 13));
+  PASS();
+}
+
+static void testSyntheticSplits() {
+  printf("testSyntheticSplits...\n");
+  // Every split point, so words, no-break spaces and cuts land across callbacks
+  for (const auto& text : syntheticTexts()) {
+    for (size_t split = 1; split < text.size(); split++) {
+      ASSERT_TRUE(sameEvents({text.substr(0, split), text.substr(split)}));
+    }
+    std::vector<std::string> bytes;
+    for (const char c : text) bytes.emplace_back(1, c);
+    ASSERT_TRUE(sameEvents(bytes));
+  }
+  PASS();
+}
+
+static void testLongWordCuts() {
+  printf("testLongWordCuts...\n");
+  RecordingSink sink;
+  TextRunTokenizer tokenizer(sink);
+  const std::string cjk = repeat("\xE6\xBC\xA2", 300);
+  tokenizer.feed(cjk.data(), cjk.size());
+  tokenizer.flush();
+  ASSERT_TRUE(sink.longestWord <= TextRunTokenizer::MAX_WORD_SIZE);
+  // Every piece is whole characters
+  size_t start = 0;
+  for (size_t i = 0; i < sink.events.size(); i++) {
+    if (sink.events[i] != '\0') continue;
+    ASSERT_EQ((i - start) % 3, static_cast<size_t>(0));
+    start = i + 1;
+  }
+  ASSERT_EQ(sink.words, static_cast<size_t>(5));  // 66 + 66 + 66 + 66 + 36 characters
+  PASS();
+}
+
+static void testChapters(const std::vector<std::string>& chapters) {
+  printf("testChapters (%zu chapters)...\n", chapters.size());
+  ASSERT_TRUE(!chapters.empty());
+  // 1KB is what the device feeds expat; the small sizes split text runs inside words
+  for (const size_t chunkSize : {size_t{1024}, size_t{97}, size_t{7}}) {
+    for (const auto& chapter : chapters) {
+      RecordingSink legacySink;
+      RecordingSink runSink;
+      LegacyTokenizer legacy(legacySink);
+      TextRunTokenizer tokenizer(runSink);
+      ASSERT_TRUE(parseChapter(chapter, legacy, chunkSize));
+      ASSERT_TRUE(parseChapter(chapter, tokenizer, chunkSize));
+      ASSERT_TRUE(runSink.words > 0 || chapter.find("<p") == std::string::npos);
+      ASSERT_TRUE(legacySink.events == runSink.events);
+    }
+  }
+  PASS();
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+
+// The text expat hands to characterData for every chapter, recorded once so the tokenizers can be timed alone
+class ChunkRecorder {
+ public:
+  std::vector<std::string> chunks;
+  void feed(const char* text, const size_t length) { chunks.emplace_back(text, length); }
+  void flush() { chunks.emplace_back(); }
+};
+
+template <typename Tokenizer>
+static double timeReplay(const std::vector<std::string>& chunks, const int rounds, CountingSink& sink) {
+  const auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    Tokenizer tokenizer(sink);
+    for (const auto& chunk : chunks) {
+      if (chunk.empty()) {
+        tokenizer.flush();
+      } else {
+        tokenizer.feed(chunk.data(), chunk.size());
+      }
+    }
+    tokenizer.flush();
+  }
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename Tokenizer>
+static double timeParse(const std::vector<std::string>& chapters, const int rounds, CountingSink& sink) {
+  const auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    for (const auto& chapter : chapters) {
+      Tokenizer tokenizer(sink);
+      parseChapter(chapter, tokenizer, 1024);
+    }
+  }
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void benchmark(const char* label, const std::vector<std::string>& chapters) {
+  printf("benchmark (%s)...\n", label);
+  ChunkRecorder recorder;
+  size_t markupBytes = 0;
+  for (const auto& chapter : chapters) {
+    ASSERT_TRUE(parseChapter(chapter, recorder, 1024));
+    markupBytes += chapter.size();
+  }
+  size_t textBytes = 0;
+  size_t callbacks = 0;
+  for (const auto& chunk : recorder.chunks) {
+    textBytes += chunk.size();
+    callbacks += chunk.empty() ? 0 : 1;
+  }
+
+  constexpr int REPLAY_ROUNDS = 400;
+  constexpr int PARSE_ROUNDS = 40;
+  CountingSink legacySink;
+  CountingSink runSink;
+  // Warm up, then time
+  timeReplay<LegacyTokenizer>(recorder.chunks, 5, legacySink);
+  timeReplay<TextRunTokenizer>(recorder.chunks, 5, runSink);
+  const double legacyReplay = timeReplay<LegacyTokenizer>(recorder.chunks, REPLAY_ROUNDS, legacySink);
+  const double runReplay = timeReplay<TextRunTokenizer>(recorder.chunks, REPLAY_ROUNDS, runSink);
+  // All of it in one piece: the scan rate without the per-callback overhead
+  std::vector<std::string> joined(1);
+  for (const auto& chunk : recorder.chunks) joined[0].append(chunk).push_back(' ');
+  const double legacyJoined = timeReplay<LegacyTokenizer>(joined, REPLAY_ROUNDS, legacySink);
+  const double runJoined = timeReplay<TextRunTokenizer>(joined, REPLAY_ROUNDS, runSink);
+  const double legacyParse = timeParse<LegacyTokenizer>(chapters, PARSE_ROUNDS, legacySink);
+  const double runParse = timeParse<TextRunTokenizer>(chapters, PARSE_ROUNDS, runSink);
+  ASSERT_EQ(legacySink.words, runSink.words);
+  ASSERT_EQ(legacySink.bytes, runSink.bytes);
+
+  const double replayBytes = static_cast<double>(textBytes) * REPLAY_ROUNDS;
+  const double parseBytes = static_cast<double>(markupBytes) * PARSE_ROUNDS;
+  printf("  %zu bytes of markup, %zu bytes of character data in %zu callbacks\n", markupBytes, textBytes, callbacks);
+  printf("  %-26s %12s %12s\n", "", "byte loop", "run scan");
+  printf("  %-26s %9.2f ns %9.2f ns  (%.2fx)\n", "tokenize, per text byte", legacyReplay / replayBytes,
+         runReplay / replayBytes, legacyReplay / runReplay);
+  const double joinedBytes = static_cast<double>(joined[0].size()) * REPLAY_ROUNDS;
+  printf("  %-26s %9.2f ns %9.2f ns  (%.2fx)\n", "tokenize in one piece", legacyJoined / joinedBytes,
+         runJoined / joinedBytes, legacyJoined / runJoined);
+  printf("  %-26s %9.2f ns %9.2f ns  (%.2fx)\n", "expat + tokenize, per byte", legacyParse / parseBytes,
+         runParse / parseBytes, legacyParse / runParse);
+  PASS();
+}
+
+// The test chapters wrap their paragraphs at ~75 columns, so expat reports every line and every line break on its
+// own. Most EPUBs keep a paragraph on one line; joining the lines gives the tokenizer runs of that length.
+static std::vector<std::string> unwrapLines(std::vector<std::string> chapters) {
+  for (auto& chapter : chapters) {
+    std::replace(chapter.begin(), chapter.end(), '\n', ' ');
+  }
+  return chapters;
+}
+
+int main(const int argc, char** argv) {
+  printf("=== Text Run Tokenizer Benchmark ===\n\n");
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <directory of extracted chapters>\n", argv[0]);
+    return 1;
+  }
+  const std::vector<std::string> chapters = loadChapters(argv[1]);
+
+  testSyntheticWhole();
+  testSyntheticSplits();
+  testLongWordCuts();
+  testChapters(chapters);
+  benchmark("test chapters", chapters);
+  benchmark("one line per paragraph", unwrapLines(chapters));
+
+  printf("\n=== Results: %d passed, %d failed ===\n", testsPassed, testsFailed);
+  return testsFailed > 0 ? 1 : 0;
+}
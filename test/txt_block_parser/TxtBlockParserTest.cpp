@@ -0,0 +1,253 @@
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "lib/Txt/TxtBlockParser.h"
+
+static int testsPassed = 0;
+static int testsFailed = 0;
+
+#define ASSERT_EQ(a, b)                                                                          \
+  do {                                                                                           \
+    if ((a) != (b)) {                                                                            \
+      fprintf(stderr, "  FAIL: %s:%d: %s != %s\n", __FILE__, __LINE__, #a, #b);                  \
+      testsFailed++;                                                                             \
+      return;                                                                                    \
+    }                                                                                            \
+  } while (0)
+
+#define ASSERT_TRUE(cond)                                                \
+  do {                                                                   \
+    if (!(cond)) {                                                       \
+      fprintf(stderr, "  FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testsFailed++;                                                     \
+      return;                                                            \
+    }                                                                    \
+  } while (0)
+
+#define PASS() testsPassed++
+
+using Format = TxtBlockParser::Format;
+using Block = TxtBlockParser::Block;
+
+// ============================================================================
+// Sink that records blocks and words as text
+// ============================================================================
+
+struct RecordedBlock {
+  Block block;
+  std::string text;  // Words separated by spaces; bold as *w*, italic as /w/, attached words joined with '+'
+};
+
+class RecordingSink final : public TxtBlockParser::Sink {
+ public:
+  std::vector<RecordedBlock> blocks;
+  bool inBlock = false;
+  bool balanced = true;
+
+  void beginBlock(const Block& block) override {
+    balanced = balanced && !inBlock;
+    inBlock = true;
+    blocks.push_back({block, ""});
+  }
+  void addWord(std::string word, const EpdFontFamily::Style style, const bool attachToPrevious) override {
+    balanced = balanced && inBlock;
+    std::string& text = blocks.back().text;
+    if (!text.empty()) {
+      text += attachToPrevious ? "+" : " ";
+    }
+    if (style & EpdFontFamily::BOLD) word = "*" + word + "*";
+    if (style & EpdFontFamily::ITALIC) word = "/" + word + "/";
+    text += word;
+  }
+  void endBlock() override {
+    balanced = balanced && inBlock;
+    inBlock = false;
+  }
+};
+
+static std::vector<RecordedBlock> parse(const Format format, const std::string& source, const size_t chunk = 4096,
+                                        const uint32_t startOffset = 0, const uint8_t state = 0) {
+  RecordingSink sink;
+  TxtBlockParser parser(format, sink, startOffset, state);
+  const auto* data = reinterpret_cast<const uint8_t*>(source.data());
+  for (size_t pos = startOffset; pos < source.size(); pos += chunk) {
+    parser.feed(data + pos, std::min(chunk, source.size() - pos));
+  }
+  parser.finish();
+  if (!sink.balanced || sink.inBlock) {
+    fprintf(stderr, "  unbalanced block events\n");
+    return {};
+  }
+  return sink.blocks;
+}
+
+static std::string texts(const std::vector<RecordedBlock>& blocks) {
+  std::string out;
+  for (const auto& b : blocks) {
+    out += "[" + b.text + "]";
+  }
+  return out;
+}
+
+static bool sameBlocks(const std::vector<RecordedBlock>& a, const std::vector<RecordedBlock>& b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); i++) {
+    if (a[i].text != b[i].text || a[i].block.offset != b[i].block.offset || a[i].block.kind != b[i].block.kind ||
+        a[i].block.level != b[i].block.level || a[i].block.state != b[i].block.state) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static const std::string MARKDOWN_SAMPLE =
+    "# Title #\n"
+    "\n"
+    "Some *italic* and **bold** text,\n"
+    "joined across lines with a [link](http://example.com/a_(b)) and ![an image](img.png).\n"
+    "\n"
+    "- first item\n"
+    "  continued\n"
+    "  - nested `code_span` item\n"
+    "3. numbered\n"
+    "\n"
+    "> quoted **bold\n"
+    "> still bold** end\n"
+    ">\n"
+    "> second\n"
+    "\n"
+    "```cpp\n"
+    "int *p = a_b;\n"
+    "    indented\n"
+    "\n"
+    "```\n"
+    "* * *\n"
+    "snake_case_word, 2 * 3, a*b*c, \\*literal\\* [1] and [brackets] too\n";
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void testPlainLines() {
+  printf("testPlainLines...\n");
+  const std::string source = "\xEF\xBB\xBFHello  world\r\n\nsecond\tline *not bold*\n   \nlast";
+  const auto blocks = parse(Format::Plain, source);
+  ASSERT_EQ(texts(blocks), std::string("[Hello world][second line *not bold*][last]"));
+  ASSERT_EQ(blocks[0].block.offset, 0u);
+  ASSERT_EQ(blocks[1].block.offset, source.find("second"));
+  ASSERT_EQ(blocks[2].block.offset, source.find("last"));
+  ASSERT_TRUE(blocks[1].block.kind == TxtBlockParser::BlockKind::Paragraph);
+  PASS();
+}
+
+void testMarkdownBlocks() {
+  printf("testMarkdownBlocks...\n");
+  const auto blocks = parse(Format::Markdown, MARKDOWN_SAMPLE);
+  using Kind = TxtBlockParser::BlockKind;
+  ASSERT_EQ(blocks.size(), 11u);
+
+  ASSERT_TRUE(blocks[0].block.kind == Kind::Heading);
+  ASSERT_EQ(blocks[0].block.level, 1);
+  ASSERT_EQ(blocks[0].text, std::string("Title"));
+
+  ASSERT_TRUE(blocks[1].block.kind == Kind::Paragraph);
+  ASSERT_EQ(blocks[1].text, std::string("Some /italic/ and *bold* text, joined across lines with a link and an "
+                                        "image+."));
+
+  ASSERT_TRUE(blocks[2].block.kind == Kind::ListItem);
+  ASSERT_EQ(blocks[2].block.level, 0);
+  ASSERT_EQ(blocks[2].text, std::string("\xe2\x80\xa2 first item continued"));
+  ASSERT_EQ(blocks[3].block.level, 1);
+  ASSERT_EQ(blocks[3].text, std::string("\xe2\x80\xa2 nested code_span item"));
+  ASSERT_EQ(blocks[4].text, std::string("3. numbered"));
+
+  ASSERT_TRUE(blocks[5].block.kind == Kind::Quote);
+  ASSERT_EQ(blocks[5].text, std::string("quoted *bold* *still* *bold* end"));
+  ASSERT_EQ(blocks[6].text, std::string("second"));
+
+  ASSERT_TRUE(blocks[7].block.kind == Kind::Code);
+  ASSERT_EQ(blocks[7].text, std::string("int *p = a_b;"));
+  ASSERT_EQ(blocks[8].block.level, 4);
+  ASSERT_EQ(blocks[8].text, std::string("indented"));
+  ASSERT_TRUE(blocks[8].block.state != 0);
+
+  ASSERT_TRUE(blocks[9].block.kind == Kind::Rule);
+  ASSERT_TRUE(blocks[10].block.kind == Kind::Paragraph);
+  ASSERT_EQ(blocks[10].block.state, 0);
+  ASSERT_EQ(blocks[10].text, std::string("snake_case_word, 2 * 3, a+/b/+c, *literal* [+1] and [+brackets] too"));
+  PASS();
+}
+
+void testEmphasisEdgeCases() {
+  printf("testEmphasisEdgeCases...\n");
+  ASSERT_EQ(texts(parse(Format::Markdown, "***both*** _it_ __strong__ *unclosed")),
+            std::string("[/*both*/ /it/ *strong* /unclosed/]"));
+  ASSERT_EQ(texts(parse(Format::Markdown, "**a** *\n\n** b **")), std::string("[*a* *][** b **]"));
+  ASSERT_EQ(texts(parse(Format::Markdown, "un**believ**able")), std::string("[un+*believ*+able]"));
+  PASS();
+}
+
+void testChunkIndependence() {
+  printf("testChunkIndependence...\n");
+  const auto whole = parse(Format::Markdown, MARKDOWN_SAMPLE);
+  for (const size_t chunk : {1u, 2u, 3u, 7u, 64u}) {
+    ASSERT_TRUE(sameBlocks(parse(Format::Markdown, MARKDOWN_SAMPLE, chunk), whole));
+  }
+  const std::string plain = "\xEF\xBB\xBFone two\nthree\n";
+  ASSERT_TRUE(sameBlocks(parse(Format::Plain, plain, 1), parse(Format::Plain, plain)));
+  PASS();
+}
+
+void testResumeAtEveryBlock() {
+  printf("testResumeAtEveryBlock...\n");
+  for (const Format format : {Format::Markdown, Format::Plain}) {
+    const auto whole = parse(format, MARKDOWN_SAMPLE);
+    ASSERT_TRUE(!whole.empty());
+    for (size_t i = 0; i < whole.size(); i++) {
+      const auto resumed = parse(format, MARKDOWN_SAMPLE, 5, whole[i].block.offset, whole[i].block.state);
+      const std::vector<RecordedBlock> tail(whole.begin() + static_cast<long>(i), whole.end());
+      ASSERT_TRUE(sameBlocks(resumed, tail));
+    }
+  }
+  PASS();
+}
+
+void testLongWordsAndLines() {
+  printf("testLongWordsAndLines...\n");
+  // 150 three-byte characters: split after a whole character, never inside one
+  std::string word;
+  for (int i = 0; i < 150; i++) word += "\xe4\xb8\x80";
+  const auto blocks = parse(Format::Plain, word);
+  ASSERT_EQ(blocks.size(), 1u);
+  const size_t split = blocks[0].text.find('+');
+  ASSERT_TRUE(split != std::string::npos);
+  ASSERT_EQ(split % 3, 0u);
+  ASSERT_TRUE(split <= TxtBlockParser::MAX_WORD_SIZE);
+
+  // A Markdown line longer than the classification prefix keeps its inline formatting
+  std::string line = "- ";
+  for (int i = 0; i < 200; i++) line += "word ";
+  line += "**end**";
+  const auto list = parse(Format::Markdown, line, 3);
+  ASSERT_EQ(list.size(), 1u);
+  ASSERT_TRUE(list[0].block.kind == TxtBlockParser::BlockKind::ListItem);
+  ASSERT_TRUE(list[0].text.size() > TxtBlockParser::MAX_LINE_PREFIX);
+  ASSERT_EQ(list[0].text.substr(list[0].text.size() - 5), std::string("*end*"));
+  PASS();
+}
+
+int main() {
+  printf("=== TXT/Markdown Block Parser Tests ===\n\n");
+
+  testPlainLines();
+  testMarkdownBlocks();
+  testEmphasisEdgeCases();
+  testChunkIndependence();
+  testResumeAtEveryBlock();
+  testLongWordsAndLines();
+
+  printf("\n=== Results: %d passed, %d failed ===\n", testsPassed, testsFailed);
+  return testsFailed > 0 ? 1 : 0;
+}
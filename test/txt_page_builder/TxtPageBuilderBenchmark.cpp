@@ -0,0 +1,420 @@
+#include <GfxRenderer.h>
+#include <Serialization.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "lib/Epub/Epub/Page.h"
+#include "lib/Epub/Epub/hyphenation/Hyphenator.h"
+#include "lib/Txt/TxtBlockParser.h"
+#include "lib/Txt/TxtPageBuilder.h"
+
+// ImageBlock.cpp decodes and draws images; text pages never hold one
+ImageBlock::ImageBlock(const std::string& imagePath, int16_t width, int16_t height)
+    : imagePath(imagePath), width(width), height(height) {}
+void ImageBlock::render(GfxRenderer&, const int, const int) {}
+bool ImageBlock::serialize(FsFile&) { return false; }
+std::unique_ptr<ImageBlock> ImageBlock::deserialize(FsFile&) { return nullptr; }
+
+static int testsPassed = 0;
+static int testsFailed = 0;
+
+#define ASSERT_EQ(a, b)                                                         \
+  do {                                                                          \
+    if ((a) != (b)) {                                                           \
+      fprintf(stderr, "  FAIL: %s:%d: %s != %s\n", __FILE__, __LINE__, #a, #b); \
+      testsFailed++;                                                            \
+      return;                                                                   \
+    }                                                                           \
+  } while (0)
+
+#define ASSERT_TRUE(cond)                                                \
+  do {                                                                   \
+    if (!(cond)) {                                                       \
+      fprintf(stderr, "  FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testsFailed++;                                                     \
+      return;                                                            \
+    }                                                                    \
+  } while (0)
+
+#define PASS() testsPassed++
+
+using Format = TxtBlockParser::Format;
+using PageStart = TxtPageBuilder::PageStart;
+
+// Portrait X4 reader viewport with the default margins; the stub renderer's font id is its em size
+static constexpr int FONT_ID = 18;
+static constexpr uint16_t VIEWPORT_WIDTH = 464;
+static constexpr uint16_t VIEWPORT_HEIGHT = 740;
+static constexpr size_t READ_CHUNK = 4 * 1024;  // TxtReaderActivity's indexing buffer
+static constexpr size_t BOOK_BYTES = 4 * 1024 * 1024;
+static constexpr size_t MARKDOWN_BYTES = 512 * 1024;
+
+// ============================================================================
+// Test books
+//
+// Gutenberg-style plain text: hard-wrapped chapters, long unwrapped paragraphs (laid out in parts), CRLF sections,
+// accented and combining text, and words longer than a line. The Markdown book adds the blocks that carry parser
+// state across lines: fenced code, lists, quotes and headings.
+// ============================================================================
+
+static const char* const WORDS[] = {
+    "the",       "of",       "and",      "to",         "a",        "in",          "that",    "was",
+    "he",        "it",       "his",      "with",       "as",       "had",         "for",     "which",
+    "office",    "flourish", "affluent", "difficulty", "waffle",   "fjord",       "naïve",   "café",
+    "résumé",    "Straße",   "Øresund",  "Ångström",   "cœur",     "déjà",        "“quoted”", "—",
+    "e\xCC\x81", "Zürich",   "Kraków",   "année",      "señor",    "extraordinarily", "circumstances",
+    "notwithstanding",      "AVAVAVA",  "Tokyo",      "Wolf",     "yesterday,", "morning.", "(aside)",
+};
+static constexpr size_t WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+
+struct Lcg {
+  uint32_t state;
+  uint32_t next() {
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+  }
+};
+
+static void appendParagraph(std::string& book, Lcg& rng, const size_t words, const size_t wrapAt, const char* eol) {
+  size_t column = 0;
+  for (size_t i = 0; i < words; i++) {
+    const char* word = WORDS[rng.next() % WORD_COUNT];
+    const size_t len = strlen(word);
+    if (wrapAt && column > 0 && column + 1 + len > wrapAt) {
+      book += eol;
+      column = 0;
+    } else if (column > 0) {
+      book += (rng.next() % 23 == 0) ? "  " : " ";
+      column++;
+    }
+    book += word;
+    column += len;
+  }
+  book += eol;
+}
+
+static std::string buildBook(const size_t targetBytes) {
+  std::string book;
+  book.reserve(targetBytes + 4096);
+  Lcg rng{12345};
+
+  int chapter = 0;
+  while (book.size() < targetBytes) {
+    const char* eol = (chapter % 3 == 2) ? "\r\n" : "\n";
+    book += "CHAPTER " + std::to_string(++chapter) + eol + eol;
+    for (int p = 0; p < 40 && book.size() < targetBytes; p++) {
+      switch (rng.next() % 6) {
+        case 0:
+          // Long paragraph on a single source line
+          appendParagraph(book, rng, 600 + rng.next() % 1400, 0, eol);
+          break;
+        case 1:
+          // Word longer than a line
+          book += "See https://www.gutenberg.org/";
+          for (int i = 0; i < 12; i++) book += "ebooks/" + std::to_string(rng.next() % 99999) + "/";
+          book += " for details.";
+          book += eol;
+          break;
+        case 2:
+          book += "    Indented verse, kept as its own line";
+          book += eol;
+          break;
+        default:
+          // Classic 70-column hard-wrapped paragraph
+          appendParagraph(book, rng, 80 + rng.next() % 200, 70, eol);
+          break;
+      }
+      book += eol;
+    }
+  }
+  return book;
+}
+
+static std::string buildMarkdownBook(const size_t targetBytes) {
+  std::string book;
+  book.reserve(targetBytes + 4096);
+  Lcg rng{4242};
+
+  int chapter = 0;
+  while (book.size() < targetBytes) {
+    book += "# Chapter " + std::to_string(++chapter) + "\n\n";
+    for (int p = 0; p < 30 && book.size() < targetBytes; p++) {
+      switch (rng.next() % 7) {
+        case 0:
+          book += "## Section *" + std::to_string(p) + "*\n";
+          break;
+        case 1: {
+          // Fenced code long enough to cross pages; every line is a block inside the fence
+          const char* fence = rng.next() % 2 ? "```\n" : "~~~\n";
+          book += fence;
+          for (int line = 0; line < 40; line++) {
+            book += std::string(rng.next() % 8, ' ') + "code_line(" + std::to_string(line) + "); // *not* emphasis\n";
+          }
+          book += fence;
+          break;
+        }
+        case 2:
+          for (int item = 0; item < 6; item++) {
+            book += std::string((item % 3) * 2, ' ') + "- ";
+            appendParagraph(book, rng, 10 + rng.next() % 40, 0, "\n");
+          }
+          break;
+        case 3:
+          book += "> ";
+          appendParagraph(book, rng, 40 + rng.next() % 80, 70, "\n> ");
+          book += "\n";
+          break;
+        case 4:
+          book += "* * *\n";
+          break;
+        default:
+          book += "Some **bold** and _italic_ text, a [link](http://example.com/x) and ";
+          appendParagraph(book, rng, 60 + rng.next() % 300, 72, "\n");
+          break;
+      }
+      book += "\n";
+    }
+  }
+  return book;
+}
+
+// ============================================================================
+// Building pages
+// ============================================================================
+
+struct BuiltPage {
+  std::string bytes;  // As stored in pages.bin
+  PageStart start;
+
+  bool operator==(const BuiltPage& other) const {
+    return bytes == other.bytes && start.blockOffset == other.start.blockOffset &&
+           start.lineSkip == other.start.lineSkip && start.state == other.start.state;
+  }
+};
+
+// The in-memory FsFile appends on write and reads from the start, so a copy reads back what was written
+static std::string contents(FsFile file) {
+  std::string data(static_cast<size_t>(file.available()), '\0');
+  file.read(data.data(), data.size());
+  return data;
+}
+
+struct BuildOptions {
+  size_t chunk = READ_CHUNK;
+  const PageStart* resumeAt = nullptr;  // Start a resumed build at this stored page
+  size_t stopAtByte = SIZE_MAX;         // Stop feeding here, without finishing, as an interrupted build does
+  size_t maxPages = SIZE_MAX;           // Stop once this many pages are complete
+};
+
+// Drive a parser and builder the way TxtReaderActivity's background indexer does
+static std::vector<BuiltPage> build(const std::string& text, const Format format, const BuildOptions& options = {}) {
+  GfxRenderer renderer;
+  std::vector<BuiltPage> pages;
+  TxtPageBuilder builder(renderer, FONT_ID, 1.0f, true, static_cast<uint8_t>(CssTextAlign::Justify), VIEWPORT_WIDTH,
+                         VIEWPORT_HEIGHT, true, [&pages](std::unique_ptr<Page> page, const PageStart& start) {
+                           FsFile file;
+                           page->serialize(file);
+                           pages.push_back({contents(file), start});
+                         });
+  uint32_t offset = 0;
+  uint8_t state = 0;
+  if (options.resumeAt) {
+    builder.resume(options.resumeAt->lineSkip);
+    offset = options.resumeAt->blockOffset;
+    state = options.resumeAt->state;
+  }
+  TxtBlockParser parser(format, builder, offset, state);
+
+  const size_t end = std::min(options.stopAtByte, text.size());
+  const auto* bytes = reinterpret_cast<const uint8_t*>(text.data());
+  for (size_t pos = offset; pos < end; pos += options.chunk) {
+    parser.feed(bytes + pos, std::min(options.chunk, end - pos));
+    if (pages.size() >= options.maxPages) {
+      pages.resize(options.maxPages);
+      return pages;
+    }
+  }
+  if (end == text.size()) {
+    parser.finish();
+    builder.finish();
+  }
+  return pages;
+}
+
+// ============================================================================
+// Correctness
+// ============================================================================
+
+static void testPagesFitViewport(const std::vector<BuiltPage>& full) {
+  printf("testPagesFitViewport...\n");
+  ASSERT_TRUE(full.size() > 1000);
+
+  size_t lines = 0;
+  for (size_t p = 0; p < full.size(); p++) {
+    FsFile file(full[p].bytes);
+    const auto page = Page::deserialize(file);
+    ASSERT_TRUE(page != nullptr);
+    ASSERT_TRUE(!page->elements.empty());
+    for (const auto& element : page->elements) {
+      ASSERT_TRUE(element->yPos >= 0);
+      ASSERT_TRUE(element->yPos + GfxRenderer().getLineHeight(FONT_ID) <= VIEWPORT_HEIGHT);
+    }
+    lines += page->elements.size();
+    // Page starts only move forward through the book
+    if (p > 0) {
+      const PageStart& previous = full[p - 1].start;
+      const PageStart& start = full[p].start;
+      ASSERT_TRUE(start.blockOffset > previous.blockOffset ||
+                  (start.blockOffset == previous.blockOffset && start.lineSkip > previous.lineSkip));
+    }
+  }
+  ASSERT_EQ(full[0].start.blockOffset, 0u);
+  ASSERT_EQ(full[0].start.lineSkip, 0u);
+  printf("  %zu pages, %zu lines\n", full.size(), lines);
+  PASS();
+}
+
+static void testChunkSizeIndependent(const std::string& book) {
+  printf("testChunkSizeIndependent...\n");
+  // UTF-8 sequences and CRLF pairs straddle chunk boundaries at these sizes
+  const std::string head = book.substr(0, 256 * 1024);
+  const auto reference = build(head, Format::Plain, {head.size()});
+  ASSERT_TRUE(reference.size() > 10);
+  for (const size_t chunk : {size_t{1}, size_t{3}, size_t{7}, size_t{512}, READ_CHUNK}) {
+    BuildOptions options;
+    options.chunk = chunk;
+    ASSERT_TRUE(build(head, Format::Plain, options) == reference);
+  }
+  PASS();
+}
+
+// Every stored page start rebuilds its page, and the one after it, exactly as the uninterrupted pass built them
+static void testResumeFromEveryPage(const std::string& text, const Format format, const std::vector<BuiltPage>& full) {
+  printf("testResumeFromEveryPage (%s, %zu pages)...\n", format == Format::Plain ? "plain" : "markdown", full.size());
+  // The first page starts below the top margin of its first block; the reader rebuilds it from scratch
+  for (size_t p = 1; p < full.size(); p++) {
+    BuildOptions options;
+    options.resumeAt = &full[p].start;
+    options.maxPages = 2;
+    const auto resumed = build(text, format, options);
+    const size_t expected = std::min<size_t>(2, full.size() - p);
+    if (resumed.size() != expected || !std::equal(resumed.begin(), resumed.end(), full.begin() + p)) {
+      fprintf(stderr, "  page %zu (block at %u, %u lines skipped) differs when resumed\n", p,
+              full[p].start.blockOffset, full[p].start.lineSkip);
+      ASSERT_TRUE(false);
+    }
+  }
+  PASS();
+}
+
+// The background indexer stops after any slice and later rebuilds the last stored page, then carries on to the end
+static void testResumeAfterStop(const std::string& text, const Format format, const std::vector<BuiltPage>& full) {
+  printf("testResumeAfterStop (%s)...\n", format == Format::Plain ? "plain" : "markdown");
+  for (const size_t stopAt : {size_t{16 * 1024}, text.size() / 3, text.size() - 5000}) {
+    BuildOptions stopped;
+    stopped.stopAtByte = stopAt;
+    std::vector<BuiltPage> pages = build(text, format, stopped);
+    ASSERT_TRUE(pages.size() >= 2);
+    const BuiltPage last = pages.back();
+    pages.pop_back();
+
+    BuildOptions resumedOptions;
+    resumedOptions.resumeAt = &last.start;
+    const auto resumed = build(text, format, resumedOptions);
+    ASSERT_TRUE(resumed.front() == last);
+    pages.insert(pages.end(), resumed.begin(), resumed.end());
+    ASSERT_TRUE(pages == full);
+  }
+  PASS();
+}
+
+static void testEdgeCases() {
+  printf("testEdgeCases...\n");
+  // Empty input and blank lines produce no pages
+  ASSERT_EQ(build("", Format::Plain).size(), 0u);
+  ASSERT_EQ(build("\n\r\n\n   \n", Format::Plain).size(), 0u);
+  ASSERT_EQ(build("\n\n", Format::Markdown).size(), 0u);
+
+  // No final newline is needed
+  const auto single = build("word   \r\nlast", Format::Plain);
+  ASSERT_EQ(single.size(), 1u);
+  FsFile file(single[0].bytes);
+  ASSERT_EQ(Page::deserialize(file)->elements.size(), 2u);
+
+  // Invalid and truncated UTF-8 never stalls, and is laid out the same at any chunk size
+  std::string broken;
+  for (int i = 0; i < 400; i++) broken += "ab\xFF\xC3 \xE2\x82 x\xC3\xA9\xF0\x9F";
+  const auto garbage = build(broken, Format::Plain);
+  ASSERT_TRUE(!garbage.empty());
+  BuildOptions byteAtATime;
+  byteAtATime.chunk = 1;
+  ASSERT_TRUE(build(broken, Format::Plain, byteAtATime) == garbage);
+  PASS();
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+
+static double elapsedMs(const std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void benchmarkBuild(const std::string& book) {
+  printf("benchmarkBuild (%.1f MB)...\n", book.size() / (1024.0 * 1024.0));
+
+  auto start = std::chrono::steady_clock::now();
+  const auto full = build(book, Format::Plain);
+  const double fullMs = elapsedMs(start);
+
+  // Rebuilding one page from its start: what reopening a book mid-build costs
+  constexpr size_t SAMPLES = 200;
+  start = std::chrono::steady_clock::now();
+  size_t rebuilt = 0;
+  for (size_t p = 1; p < full.size(); p += full.size() / SAMPLES) {
+    BuildOptions options;
+    options.resumeAt = &full[p].start;
+    options.maxPages = 1;
+    rebuilt += build(book, Format::Plain, options).size();
+  }
+  const double resumeMs = elapsedMs(start);
+
+  printf("  full build: %8.1f ms for %zu pages (%.2f MB/s, %.3f ms/page)\n", fullMs, full.size(),
+         book.size() / (1024.0 * 1024.0) / (fullMs / 1000.0), fullMs / full.size());
+  printf("  resume:     %8.3f ms per page rebuilt from its start (%zu pages)\n", resumeMs / rebuilt, rebuilt);
+
+  ASSERT_TRUE(rebuilt >= SAMPLES);
+  PASS();
+}
+
+int main() {
+  printf("=== TXT Page Builder Benchmark ===\n\n");
+
+  // As TxtReaderActivity: plain text has no language to pick hyphenation patterns by
+  Hyphenator::setPreferredLanguage("");
+
+  const std::string book = buildBook(BOOK_BYTES);
+  const auto full = build(book, Format::Plain);
+  printf("  book: %zu bytes, %zu pages\n\n", book.size(), full.size());
+
+  const std::string markdown = buildMarkdownBook(MARKDOWN_BYTES);
+  const auto fullMarkdown = build(markdown, Format::Markdown);
+
+  testPagesFitViewport(full);
+  testChunkSizeIndependent(book);
+  testResumeFromEveryPage(book, Format::Plain, full);
+  testResumeFromEveryPage(markdown, Format::Markdown, fullMarkdown);
+  testResumeAfterStop(book, Format::Plain, full);
+  testResumeAfterStop(markdown, Format::Markdown, fullMarkdown);
+  testEdgeCases();
+  benchmarkBuild(book);
+
+  printf("\n=== Results: %d passed, %d failed ===\n", testsPassed, testsFailed);
+  return testsFailed > 0 ? 1 : 0;
+}